@@ -24,14 +24,17 @@ REMARKS
 DESIGN
     The groups are stored in an array of pointers to store each group in an
     element. Each "atomic group" node contains a link to a hash table to
-    manage the atoms in each group.  The allowed "atomic groups" are stored
-    in an enum (called group_t) in atom.h.
+    manage the atoms in each group.  The hash table of a group doubles in
+    size whenever its chains get ATOM_MAX_LOAD atoms long on average.  The
+    allowed "atomic groups" are stored in an enum (called group_t) in
+    atom.h.
 
 BUGS/LIMITATIONS
     Can't interate over the atoms in a group.
 
 LOCAL ROUTINES
   HAIfind_atom      - Returns a pointer to an atom_info_t from a atom ID
+  HAIgrow_group     - Doubles the hash table of a group
   HAIget_atom_node  - Gets an atom node (uses the atom free list)
   HAIrelease_atom_node - Releases an atom node (uses the atom free list)
 EXPORTED ROUTINES
@@ -60,9 +63,26 @@ MODIFICATION HISTORY
 #include "atom.h"
 #include <assert.h>
 
+#ifdef H4_HAVE_THREADSAFE
+/* Guards the atomic groups, the atom cache and the atom node free list.
+   Recursive, as the HAsearch_atom comparison functions look atoms up */
+PRIVATE pthread_mutex_t atom_lock;
+PRIVATE pthread_once_t atom_lock_once = PTHREAD_ONCE_INIT;
+
+static void HAIinit_atom_lock(void);
+
+static pthread_mutex_t *HAIatom_lock(void);
+
+#define HA_ATOM_GUARD HTS_MUTEX_GUARD(*HAIatom_lock())
+#else  /* H4_HAVE_THREADSAFE */
+#define HA_ATOM_GUARD HTS_NO_GUARD
+#endif /* H4_HAVE_THREADSAFE */
+
 /* Private function prototypes */
 static atom_info_t *HAIfind_atom(atom_t atm);
 
+static void HAIgrow_group(atom_group_t *grp_ptr);
+
 static atom_info_t *HAIget_atom_node(void);
 
 static void HAIrelease_atom_node(atom_info_t *atm);
@@ -75,7 +95,8 @@ static void HAIrelease_atom_node(atom_info_t *atm);
     Creates a global atomic group to store atoms in.  If the group has already
     been initialized, this routine just increments the count of # of
     initializations and returns without trying to change the size of the hash
-    table.
+    table.  The hash table grows as atoms are registered (see HAIgrow_group),
+    the size is where it starts.
 
  RETURNS
     Returns SUCCEED if successful and FAIL otherwise
@@ -85,6 +106,7 @@ intn HAinit_group(group_t grp,      /* IN: Group to initialize */
     intn hash_size                  /* IN: Minimum hash table size to use for group */
 )
 {
+    HA_ATOM_GUARD;
     CONSTR(FUNC, "HAinit_group");	/* for HERROR */
     atom_group_t *grp_ptr=NULL;     /* ptr to the atomic group */
     intn ret_value=SUCCEED;
@@ -158,6 +180,7 @@ done:
 intn HAdestroy_group(group_t grp       /* IN: Group to destroy */
 )
 {
+    HA_ATOM_GUARD;
     CONSTR(FUNC, "HAdestroy_group");	/* for HERROR */
     atom_group_t *grp_ptr=NULL;     /* ptr to the atomic group */
     intn ret_value=SUCCEED;
@@ -220,6 +243,7 @@ atom_t HAregister_atom(group_t grp,     /* IN: Group to register the object in *
     VOIDP object                        /* IN: Object to attach to atom */
 )
 {
+    HA_ATOM_GUARD;
     CONSTR(FUNC, "HAregister_atom");	/* for HERROR */
     atom_group_t *grp_ptr=NULL;     /* ptr to the atomic group */
     atom_info_t *atm_ptr=NULL;      /* ptr to the new atom */
@@ -238,6 +262,10 @@ atom_t HAregister_atom(group_t grp,     /* IN: Group to register the object in *
     if((atm_ptr=HAIget_atom_node())==NULL)
         HGOTO_ERROR(DFE_NOSPACE, FAIL);
 
+    /* Keep the hash chains short */
+    if(grp_ptr->atoms>=(uintn)grp_ptr->hash_size*ATOM_MAX_LOAD)
+        HAIgrow_group(grp_ptr);
+
     /* Create the atom & it's ID */
     atm_id=MAKE_ATOM(grp,grp_ptr->nextid);
     atm_ptr->id=atm_id;
@@ -286,6 +314,7 @@ VOIDP HAatom_object(atom_t atm   /* IN: Atom to retrieve object for */
 )
 #endif /* ATOMS_CACHE_INLINE */
 {
+    HA_ATOM_GUARD;
     CONSTR(FUNC, "HAatom_object");	/* for HERROR */
 #ifndef ATOMS_CACHE_INLINE
 #ifdef ATOMS_ARE_CACHED
@@ -385,6 +414,7 @@ done:
 VOIDP HAremove_atom(atom_t atm   /* IN: Atom to remove */
 )
 {
+    HA_ATOM_GUARD;
     CONSTR(FUNC, "HAremove_atom");	/* for HERROR */
     atom_group_t *grp_ptr=NULL;     /* ptr to the atomic group */
     atom_info_t *curr_atm,          /* ptr to the current atom */
@@ -476,6 +506,7 @@ void * HAsearch_atom(group_t grp,        /* IN: Group to search for the object i
     const void * key                     /* IN: pointer to key to compare against */
 )
 {
+    HA_ATOM_GUARD;
     CONSTR(FUNC, "HAsearch_atom");	/* for HERROR */
     atom_group_t *grp_ptr=NULL;     /* ptr to the atomic group */
     atom_info_t *atm_ptr=NULL;      /* ptr to the new atom */
@@ -577,6 +608,52 @@ done:
   return ret_value;
 }   /* end HAIfind_atom() */
 
+/******************************************************************************
+ NAME
+     HAIgrow_group - Doubles the hash table of a group
+
+ DESCRIPTION
+    Allocates a hash table twice the size of the group's current one and
+    moves the atoms over into it.  The atoms of a chain spread over two
+    chains of the new table, at the same location and at the same location
+    plus the old size.  If the new table cannot be allocated, the group
+    keeps the old one, which still works, only more slowly.
+
+ RETURNS
+    No return value
+
+*******************************************************************************/
+static void HAIgrow_group(atom_group_t *grp_ptr)
+{
+    atom_info_t **new_list;         /* the new hash table */
+    atom_info_t *atm_ptr,           /* ptr to the atom being moved */
+        *next_atm;                  /* ptr to the atom after it */
+    intn new_size;                  /* size of the new hash table */
+    uintn hash_loc;                 /* atom's location in the new table */
+    intn i;                         /* local counting variable */
+
+    /* Keep the hash locations within the atom index bits */
+    if(grp_ptr->hash_size>(ATOM_MASK>>1))
+        return;
+
+    new_size=grp_ptr->hash_size*2;
+    if((new_list=(atom_info_t **)HDcalloc(new_size,sizeof(atom_info_t *)))==NULL)
+        return;
+
+    for(i=0; i<grp_ptr->hash_size; i++)
+        for(atm_ptr=grp_ptr->atom_list[i]; atm_ptr!=NULL; atm_ptr=next_atm)
+          {
+            next_atm=atm_ptr->next;
+            hash_loc=(uintn)ATOM_TO_LOC(atm_ptr->id,new_size);
+            atm_ptr->next=new_list[hash_loc];
+            new_list[hash_loc]=atm_ptr;
+          } /* end for */
+
+    HDfree(grp_ptr->atom_list);
+    grp_ptr->atom_list=new_list;
+    grp_ptr->hash_size=new_size;
+}   /* end HAIgrow_group() */
+
 /******************************************************************************
  NAME
      HAIget_atom_node - Gets an atom node
@@ -639,6 +716,42 @@ static void HAIrelease_atom_node(atom_info_t *atm)
     atom_free_list=atm;
 }   /* end HAIrelease_atom_node() */
 
+#ifdef H4_HAVE_THREADSAFE
+/******************************************************************************
+ NAME
+     HAIinit_atom_lock - Creates the lock of the atomic groups
+
+ DESCRIPTION
+    Run once, by the first thread to use the atomic groups.  There is no
+    portable static initializer for a recursive lock.
+
+ RETURNS
+    No return value
+
+*******************************************************************************/
+static void HAIinit_atom_lock(void)
+{
+    HTSIinit_lock(&atom_lock);
+}   /* end HAIinit_atom_lock() */
+
+/******************************************************************************
+ NAME
+     HAIatom_lock - Gets the lock of the atomic groups
+
+ DESCRIPTION
+    Creates the lock the first time through.
+
+ RETURNS
+    Returns a pointer to the lock, for HTS_MUTEX_GUARD to take
+
+*******************************************************************************/
+static pthread_mutex_t *HAIatom_lock(void)
+{
+    pthread_once(&atom_lock_once, HAIinit_atom_lock);
+    return &atom_lock;
+}   /* end HAIatom_lock() */
+#endif /* H4_HAVE_THREADSAFE */
+
 /*--------------------------------------------------------------------------
  NAME
     HAshutdown
@@ -659,6 +772,7 @@ static void HAIrelease_atom_node(atom_info_t *atm)
 intn 
 HAshutdown(void)
 {
+    HA_ATOM_GUARD;
     atom_info_t *curr;
     intn i;
 
@@ -37,9 +37,11 @@
 #define ATOMS_ARE_CACHED
 
 /* Define the following macro for "inline" atom lookups from the cache */
-#ifdef ATOMS_ARE_CACHED     /* required for this to work */
+/* (not in a thread-safe build, the inline lookup reorders the cache
+    without holding the lock on the atom groups) */
+#if defined ATOMS_ARE_CACHED && !defined H4_HAVE_THREADSAFE /* required for this to work */
 #define ATOMS_CACHE_INLINE
-#endif /* ATOMS_ARE_CACHED */
+#endif /* ATOMS_ARE_CACHED && !H4_HAVE_THREADSAFE */
 
 #ifdef ATOMS_CACHE_INLINE
 /* Do swap using XOR operator. Ugly but fast... -QAK */
@@ -108,6 +110,10 @@ typedef intn (*HAsearch_func_t)(const void * obj, const void * key);
 #define ATOM_TO_LOC(a,s)    (((atom_t)(a)&ATOM_MASK)%(s))
 #endif /* HASH_SIZE_POWER_2 */
 
+/* Average length of the hash chains at which the hash table of a group is
+   doubled, so looking atoms up stays quick however many are registered */
+#define ATOM_MAX_LOAD       2
+
 /* Combine a Group number and an atom index into an atom */
 #define MAKE_ATOM(g,i)      ((((atom_t)(g)&GROUP_MASK)<<((sizeof(atom_t)*8)-GROUP_BITS))|((atom_t)(i)&ATOM_MASK))
 
@@ -169,7 +175,8 @@ extern      "C"
  DESCRIPTION
     Creates an atomic group to store atoms in.  If the group has already been
     initialized, this routine just increments the count of # of initializations
-    and returns without trying to change the size of the hash table.
+    and returns without trying to change the size of the hash table.  The
+    hash table grows as atoms are registered, the size is where it starts.
 
  RETURNS
     Returns SUCCEED if successful and FAIL otherwise
@@ -161,6 +161,112 @@ HCIcdeflate_decode(compinfo_t * info, int32 length, uint8 *buf)
     return(bytes_read);
 }   /* end HCIcdeflate_decode() */
 
+/*--------------------------------------------------------------------------
+ NAME
+    HCPcdeflate_inflate -- Decode gzip 'deflated' data held in memory.
+
+ USAGE
+    int32 HCPcdeflate_inflate(coded,coded_len,buf,length)
+    const uint8 *coded; IN: the compressed bytes of an element
+    int32 coded_len;    IN: number of compressed bytes
+    uint8 *buf;         OUT: buffer to store the decompressed bytes
+    int32 length;       IN: size of the buffer
+
+ RETURNS
+    Returns # of bytes decompressed or FAIL
+
+ DESCRIPTION
+    Decompresses the whole of a gzip 'deflated' element, read from the
+    file beforehand, into a buffer.
+
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+    Does not report errors, it is run by the worker threads (see hwork.c)
+    which must not call the library.
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+int32
+HCPcdeflate_inflate(const uint8 *coded, int32 coded_len, uint8 *buf, int32 length)
+{
+    z_stream    context;        /* inflation state */
+    int         zstat;          /* inflate status */
+
+    context.zalloc=(alloc_func)Z_NULL;
+    context.zfree=(free_func)Z_NULL;
+    context.opaque=NULL;
+    context.next_in=(Bytef *)coded;
+    context.avail_in=(uInt)coded_len;
+    if(inflateInit(&context)!=Z_OK)
+        return(FAIL);
+
+    context.next_out=buf;
+    context.avail_out=(uInt)length;
+    zstat=inflate(&context,Z_FINISH);
+    inflateEnd(&context);
+
+    /* the buffer may hold less than the element, as HCIcdeflate_decode
+       stops once it has read as much as it was asked for */
+    if(zstat!=Z_STREAM_END && !(zstat==Z_BUF_ERROR && context.avail_out==0))
+        return(FAIL);
+
+    return((int32)length-(int32)context.avail_out);
+}   /* end HCPcdeflate_inflate() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCPcdeflate_deflate -- Encode a buffer into gzip 'deflated' data held
+                            in memory.
+
+ USAGE
+    int32 HCPcdeflate_deflate(buf,length,level,coded,coded_len)
+    const uint8 *buf;   IN: the bytes of a whole element
+    int32 length;       IN: number of bytes in the element
+    intn level;         IN: how hard to try to compress
+    uint8 *coded;       OUT: buffer to store the compressed bytes
+    int32 coded_len;    IN: size of that buffer
+
+ RETURNS
+    Returns # of compressed bytes or FAIL
+
+ DESCRIPTION
+    Compresses the whole of an element into a buffer, the same way 
+    HCIcdeflate_encode does, for HCPcdeflate_writecoded to write out
+    later.  A buffer of length + length/1000 + 12 bytes is always large
+    enough.
+
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+    Does not report errors, it is run by the worker threads (see hwork.c)
+    which must not call the library.
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+int32
+HCPcdeflate_deflate(const uint8 *buf, int32 length, intn level, uint8 *coded, int32 coded_len)
+{
+    z_stream    context;        /* deflation state */
+    int         zstat;          /* deflate status */
+
+    context.zalloc=(alloc_func)Z_NULL;
+    context.zfree=(free_func)Z_NULL;
+    context.opaque=NULL;
+    if(deflateInit(&context,level)!=Z_OK)
+        return(FAIL);
+
+    context.next_in=(Bytef *)buf;
+    context.avail_in=(uInt)length;
+    context.next_out=coded;
+    context.avail_out=(uInt)coded_len;
+    zstat=deflate(&context,Z_FINISH);
+    deflateEnd(&context);
+
+    if(zstat!=Z_STREAM_END)
+        return(FAIL);
+
+    return((int32)coded_len-(int32)context.avail_out);
+}   /* end HCPcdeflate_deflate() */
+
 /*--------------------------------------------------------------------------
  NAME
     HCIcdeflate_encode -- Encode data from a buffer into gzip 'deflated'
@@ -695,6 +801,61 @@ HCPcdeflate_write(accrec_t * access_rec, int32 length, const void * data)
     return (length);
 }   /* HCPcdeflate_write() */
 
+/*--------------------------------------------------------------------------
+ NAME
+    HCPcdeflate_writecoded -- Write out a whole element compressed beforehand.
+
+ USAGE
+    int32 HCPcdeflate_writecoded(access_rec,coded,coded_len,length)
+    accrec_t *access_rec;   IN: the access record of the data element
+    const uint8 *coded;     IN: the element compressed by HCPcdeflate_deflate
+    int32 coded_len;        IN: number of compressed bytes
+    int32 length;           IN: number of bytes in the element
+
+ RETURNS
+    Returns the number of bytes written, i.e. 'length', or FAIL
+
+ DESCRIPTION
+    Writes the compressed bytes of the whole element to the file, in
+    place of deflating the element as it is written.  As with 
+    HCPcdeflate_write the element is rewritten from its beginning, as a
+    whole.
+
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+int32
+HCPcdeflate_writecoded(accrec_t * access_rec, const uint8 *coded, int32 coded_len,
+                       int32 length)
+{
+    CONSTR(FUNC, "HCPcdeflate_writecoded");
+    compinfo_t *info;           /* special element information */
+    comp_coder_deflate_info_t *deflate_info;    /* ptr to gzip 'deflate' info */
+
+    info = (compinfo_t *) access_rec->special_info;
+    deflate_info = &(info->cinfo.coder_info.deflate_info);
+
+    /* only the whole element, as in HCPcdeflate_write */
+    if (deflate_info->offset != 0 || length < info->length)
+        HRETURN_ERROR(DFE_UNSUPPORTED, FAIL);
+
+    /* Terminate the previous method of access */
+    if (deflate_info->acc_init != 0
+        && HCIcdeflate_term(info, deflate_info->acc_init) == FAIL)
+        HRETURN_ERROR(DFE_CTERM, FAIL);
+
+    /* Go back to the beginning of the data-stream */
+    if (Hseek(info->aid, 0, 0) == FAIL)
+        HRETURN_ERROR(DFE_SEEKERROR, FAIL);
+    if (Hwrite(info->aid, coded_len, coded) == FAIL)
+        HRETURN_ERROR(DFE_WRITEERROR, FAIL);
+    deflate_info->offset = length;
+
+    return (length);
+}   /* HCPcdeflate_writecoded() */
+
 /*--------------------------------------------------------------------------
  NAME
     HCPcdeflate_inquire -- Inquire information about the access record and data element.
@@ -66,6 +66,15 @@ HDFLIBAPI int32 HCPcdeflate_write
 HDFLIBAPI intn HCPcdeflate_endaccess
                 (accrec_t * access_rec);
 
+HDFLIBAPI int32 HCPcdeflate_inflate
+                (const uint8 *coded, int32 coded_len, uint8 *buf, int32 length);
+
+HDFLIBAPI int32 HCPcdeflate_deflate
+                (const uint8 *buf, int32 length, intn level, uint8 *coded, int32 coded_len);
+
+HDFLIBAPI int32 HCPcdeflate_writecoded
+                (accrec_t * access_rec, const uint8 *coded, int32 coded_len, int32 length);
+
 #if defined c_plusplus || defined __cplusplus
 }
 #endif                          /* c_plusplus || __cplusplus */
@@ -1011,6 +1011,7 @@ HCPcszip_endaccess(accrec_t * access_rec)
 intn
 HCPsetup_szip_parms( comp_info *c_info, int32 nt, int32 ncomp, int32 ndims, int32 *dims, int32 *cdims)
 {
+    HTS_API_LOCK;
 #ifdef H4_HAVE_SZIP_ENCODER
     int32 scanline;
     int32 npoints;
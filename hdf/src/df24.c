@@ -69,6 +69,7 @@ static int32 last_ydim = 0;     /* .....gheesh......... */
 intn
 DF24getdims(const char *filename, int32 *pxdim, int32 *pydim, intn *pil)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DF24getdims");
   intn        ncomps;
   intn       ret_value = SUCCEED;
@@ -113,6 +114,7 @@ done:
 intn
 DF24reqil(intn il)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFGRIreqil(il, IMAGE));
@@ -144,6 +146,7 @@ DF24reqil(intn il)
 intn
 DF24getimage(const char *filename, void * image, int32 xdim, int32 ydim)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DF24getimage");
   intn        il;
   int32       tx, ty;
@@ -202,6 +205,7 @@ done:
 intn
 DF24setdims(int32 xdim, int32 ydim)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   dimsset = 1;
@@ -228,6 +232,7 @@ DF24setdims(int32 xdim, int32 ydim)
 intn
 DF24setil(intn il)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFGRIsetil(il, IMAGE));
@@ -258,6 +263,7 @@ DF24setil(intn il)
 intn
 DF24setcompress(int32 type, comp_info * cinfo)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFGRsetcompress(type, cinfo));
@@ -283,6 +289,7 @@ DF24setcompress(int32 type, comp_info * cinfo)
 intn
 DF24restart(void)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFGRIrestart());
@@ -313,6 +320,7 @@ DF24restart(void)
 intn
 DF24addimage(const char *filename, const void * image, int32 xdim, int32 ydim)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DF24addimage");
   intn ret_value = SUCCEED;
 
@@ -356,6 +364,7 @@ done:
 intn
 DF24putimage(const char *filename, const void * image, int32 xdim, int32 ydim)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DF24putimage");
   intn ret_value = SUCCEED;
 
@@ -394,6 +403,7 @@ done:
 intn
 DF24nimages(const char *filename)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DF24nimages");
   int32       file_id;
   int32       group_id;       /* group ID for looking at RIG's */
@@ -481,6 +491,7 @@ done:
 intn
 DF24readref(const char *filename, uint16 ref)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFGRreadref(filename, ref));
@@ -505,6 +516,7 @@ DF24readref(const char *filename, uint16 ref)
 uint16
 DF24lastref(void)
 {
+    HTS_API_LOCK;
   uint16 ret_value;
 
   ret_value = (DFGRIlastref());
@@ -107,6 +107,7 @@ PRIVATE intn DFANIstart(void);
 int32
 DFANgetlablen(const char *filename, uint16 tag, uint16 ref)
 {
+    HTS_API_LOCK;
   int32 ret_value;
 
   ret_value = (DFANIgetannlen(filename, tag, ref, DFAN_LABEL));
@@ -140,6 +141,7 @@ intn
 DFANgetlabel(const char *filename, uint16 tag, uint16 ref, char *label,
              int32 maxlen)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFANIgetann(filename, tag, ref, (uint8 *) label, maxlen, DFAN_LABEL, 0));
@@ -169,6 +171,7 @@ DFANgetlabel(const char *filename, uint16 tag, uint16 ref, char *label,
 int32
 DFANgetdesclen(const char *filename, uint16 tag, uint16 ref)
 {
+    HTS_API_LOCK;
   int32 ret_value;
 
   ret_value = (DFANIgetannlen(filename, tag, ref, DFAN_DESC));
@@ -204,6 +207,7 @@ intn
 DFANgetdesc(const char *filename, uint16 tag, uint16 ref, char *desc,
             int32 maxlen)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFANIgetann(filename, tag, ref, (uint8 *) desc, maxlen, DFAN_DESC, 0));
@@ -240,6 +244,7 @@ DFANgetdesc(const char *filename, uint16 tag, uint16 ref, char *desc,
 int32
 DFANgetfidlen(int32 file_id, int isfirst)
 {
+    HTS_API_LOCK;
   int32 ret_value;
 
   ret_value = (DFANIgetfannlen(file_id, DFAN_LABEL, isfirst));
@@ -271,6 +276,7 @@ DFANgetfidlen(int32 file_id, int isfirst)
 int32
 DFANgetfid(int32 file_id, char *label, int32 maxlen, intn isfirst)
 {
+    HTS_API_LOCK;
   int32 ret_value;
 
   ret_value = (DFANIgetfann(file_id, label, maxlen, DFAN_LABEL, isfirst));
@@ -303,6 +309,7 @@ DFANgetfid(int32 file_id, char *label, int32 maxlen, intn isfirst)
 int32
 DFANgetfdslen(int32 file_id, intn isfirst)
 {
+    HTS_API_LOCK;
   int32 ret_value;
 
   ret_value = (DFANIgetfannlen(file_id, DFAN_DESC, isfirst));
@@ -334,6 +341,7 @@ DFANgetfdslen(int32 file_id, intn isfirst)
 int32
 DFANgetfds(int32 file_id, char *desc, int32 maxlen, intn isfirst)
 {
+    HTS_API_LOCK;
   int32 ret_value;
 
   ret_value = (DFANIgetfann(file_id, desc, maxlen, DFAN_DESC, isfirst));
@@ -368,6 +376,7 @@ DFANgetfds(int32 file_id, char *desc, int32 maxlen, intn isfirst)
 intn
 DFANputlabel(const char *filename, uint16 tag, uint16 ref, char *label)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFANIputann(filename, tag, ref, (uint8 *) label,
@@ -403,6 +412,7 @@ intn
 DFANputdesc(const char *filename, uint16 tag, uint16 ref, char *desc,
             int32 desclen)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFANIputann(filename, tag, ref, (uint8 *) desc, desclen, DFAN_DESC));
@@ -433,6 +443,7 @@ DFANputdesc(const char *filename, uint16 tag, uint16 ref, char *desc,
 intn
 DFANaddfid(int32 file_id, char *id)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFANIaddfann(file_id, id, (int32) HDstrlen(id), DFAN_LABEL));
@@ -462,6 +473,7 @@ DFANaddfid(int32 file_id, char *id)
 intn
 DFANaddfds(int32 file_id, char *desc, int32 desclen)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFANIaddfann(file_id, desc, desclen, DFAN_DESC));
@@ -491,6 +503,7 @@ DFANaddfds(int32 file_id, char *desc, int32 desclen)
 uint16
 DFANlastref(void)
 {
+    HTS_API_LOCK;
   uint16 ret_value;
 
   ret_value = (Lastref);
@@ -532,6 +545,7 @@ intn
 DFANlablist(const char *filename, uint16 tag, uint16 reflist[], char *labellist,
             intn listsize, intn maxlen, intn startpos)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFANIlablist(filename, tag, reflist, (uint8 *) labellist,
@@ -558,6 +572,7 @@ DFANlablist(const char *filename, uint16 tag, uint16 reflist[], char *labellist,
  *------------------------------------------------------------------*/
 intn DFANclear(void)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = DFANIclear();
@@ -590,6 +605,7 @@ intn DFANclear(void)
 intn
 DFANIclear(void)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFANIclear");
   DFANdirhead *p, *q;
   intn ret_value = SUCCEED;
@@ -757,6 +773,7 @@ done:
 uint16
 DFANIlocate(int32 file_id, int type, uint16 tag, uint16 ref)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFANIlocate");
   uint8       datadi[4];
   int32       more_anns;
@@ -867,6 +884,7 @@ done:
 int
 DFANIaddentry(int type, uint16 annref, uint16 datatag, uint16 dataref)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFANIaddentry");
   int32       i;
   DFANdirhead *p, *q;
@@ -950,6 +968,7 @@ done:
 int32
 DFANIgetannlen(const char *filename, uint16 tag, uint16 ref, int type)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFANIgetannlen");
   int32       file_id, annlength;
   uint16      anntag, annref;
@@ -1025,6 +1044,7 @@ intn
 DFANIgetann(const char *filename, uint16 tag, uint16 ref, uint8 *ann,
             int32 maxlen, int type, int isfortran)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFANIgetann");
   int32       file_id, aid;
   int32       annlen;
@@ -1148,6 +1168,7 @@ intn
 DFANIputann(const char *filename, uint16 tag, uint16 ref, uint8 *ann,
             int32 annlen, int type)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFANIputann");
   int32       file_id, aid;
   int         newflag = 0;
@@ -1280,6 +1301,7 @@ DFANIlablist(const char *filename, uint16 tag, uint16 reflist[],
              uint8 *labellist, int listsize, int maxlen, int startpos,
              int isfortran)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFANIlablist");
   int32       i;
   int         j, k;
@@ -1435,6 +1457,7 @@ done:
 int
 DFANIaddfann(int32 file_id, char *ann, int32 annlen, int type)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFANIaddfann");
   uint16      anntag, annref;
   int         ret_value = SUCCEED;
@@ -1495,6 +1518,7 @@ done:
 int32
 DFANIgetfannlen(int32 file_id, int type, int isfirst)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFANIgetfannlen");
   uint16      anntag, annref;
   int32       aid;
@@ -1580,6 +1604,7 @@ int32
 DFANIgetfann(int32 file_id, char *ann, int32 maxlen, int type,
              int isfirst)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFANIgetfann");
   uint16      anntag, annref;
   int32       length, aid;
@@ -1726,6 +1751,7 @@ done:
 --------------------------------------------------------------------------*/
 intn DFANPshutdown(void)
 {
+    HTS_API_LOCK;
     DFANIclear();   /* frees the directory lists */
 
     if(Lastfile!=NULL)
@@ -65,6 +65,7 @@ DFputcomp(int32 file_id, uint16 tag, uint16 ref, const uint8 *image, int32 xdim,
           int32 ydim, uint8 *palette, uint8 *newpal, int16 scheme,
           comp_info * cinfo)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFputcomp");
     uint8      *buffer;         /* buffer to hold compressed image */
     const uint8      *in;       /* pointer to input for compression */
@@ -192,6 +193,7 @@ int
 DFgetcomp(int32 file_id, uint16 tag, uint16 ref, uint8 *image, int32 xdim,
           int32 ydim, uint16 scheme)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFgetcomp");
     uint8      *buffer;
     uint8      *in;
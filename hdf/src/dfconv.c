@@ -220,6 +220,7 @@ DFKNTsize(int32 number_type)
 intn
 DFKsetNT(int32 ntype)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFKsetNT");
 
     HEclear();
@@ -416,6 +417,7 @@ int
 DFconvert(uint8 *source, uint8 *dest, int ntype, int sourcetype, int desttype,
           int32 size)
 {
+    HTS_API_LOCK;
     uint32 num_elm;
     CONSTR(FUNC, "DFconvert");
 
@@ -520,6 +522,7 @@ int32
 DFKconvert(VOIDP source, VOIDP dest, int32 ntype, int32 num_elm,
            int16 acc_mode, int32 source_stride, int32 dest_stride)
 {
+    HTS_API_LOCK;
     int         ret;
 
     /* Check args (minimally) */
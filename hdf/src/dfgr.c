@@ -172,6 +172,7 @@ int
 DFGRgetlutdims(const char *filename, int32 *pxdim, int32 *pydim, int *pncomps,
                int *pil)
 {
+    HTS_API_LOCK;
     return (DFGRIgetdims(filename, pxdim, pydim, pncomps, pil, LUT));
 }
 
@@ -188,6 +189,7 @@ DFGRgetlutdims(const char *filename, int32 *pxdim, int32 *pydim, int *pncomps,
 int
 DFGRreqlutil(int il)
 {
+    HTS_API_LOCK;
     return (DFGRIreqil(il, LUT));
 }
 
@@ -206,6 +208,7 @@ DFGRreqlutil(int il)
 int
 DFGRgetlut(const char *filename, void * lut, int32 xdim, int32 ydim)
 {
+    HTS_API_LOCK;
     int compressed, has_pal;
     uint16 compr_type;
     /* 0 == C */
@@ -231,6 +234,7 @@ int
 DFGRgetimdims(const char *filename, int32 *pxdim, int32 *pydim, int *pncomps,
               int *pil)
 {
+    HTS_API_LOCK;
     return (DFGRIgetdims(filename, pxdim, pydim, pncomps, pil, IMAGE));
 }
 
@@ -247,6 +251,7 @@ DFGRgetimdims(const char *filename, int32 *pxdim, int32 *pydim, int *pncomps,
 int
 DFGRreqimil(int il)
 {
+    HTS_API_LOCK;
     return (DFGRIreqil(il, IMAGE));
 }
 
@@ -265,6 +270,7 @@ DFGRreqimil(int il)
 int
 DFGRgetimage(const char *filename, void * image, int32 xdim, int32 ydim)
 {
+    HTS_API_LOCK;
     int compressed, has_pal;
     uint16 compr_type;
     /* 0 == C */
@@ -286,6 +292,7 @@ DFGRgetimage(const char *filename, void * image, int32 xdim, int32 ydim)
 int
 DFGRsetcompress(int32 scheme, comp_info * cinfo)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFGRsetcompress");
     intn   ret_value = SUCCEED;
 
@@ -338,6 +345,7 @@ done:
 int
 DFGRsetlutdims(int32 xdim, int32 ydim, int ncomps, int il)
 {
+    HTS_API_LOCK;
     if (DFGRIsetil(il, LUT) < 0)
         return FAIL;
     return (DFGRIsetdims(xdim, ydim, ncomps, LUT));
@@ -357,6 +365,7 @@ DFGRsetlutdims(int32 xdim, int32 ydim, int ncomps, int il)
 int
 DFGRsetlut(void * lut, int32 xdim, int32 ydim)
 {
+    HTS_API_LOCK;
     /* 0 == C, 0 == no newfile */
     return (DFGRIaddimlut((const char *) NULL, lut, xdim, ydim, LUT, 0, 0));
 }
@@ -376,6 +385,7 @@ DFGRsetlut(void * lut, int32 xdim, int32 ydim)
 int
 DFGRaddlut(const char *filename, void * lut, int32 xdim, int32 ydim)
 {
+    HTS_API_LOCK;
     /* 0 == C, 0 == no new file */
     return (DFGRIaddimlut(filename, lut, xdim, ydim, LUT, 0, 0));
 }
@@ -395,6 +405,7 @@ DFGRaddlut(const char *filename, void * lut, int32 xdim, int32 ydim)
 int
 DFGRsetimdims(int32 xdim, int32 ydim, int ncomps, int il)
 {
+    HTS_API_LOCK;
     if (DFGRIsetil(il, IMAGE) < 0)
         return FAIL;
     return (DFGRIsetdims(xdim, ydim, ncomps, IMAGE));
@@ -415,6 +426,7 @@ DFGRsetimdims(int32 xdim, int32 ydim, int ncomps, int il)
 int
 DFGRaddimage(const char *filename, void * image, int32 xdim, int32 ydim)
 {
+    HTS_API_LOCK;
     /* 0 == C, 0 == not new file */
     return (DFGRIaddimlut(filename, image, xdim, ydim, IMAGE, 0, 0));
 }
@@ -422,6 +434,7 @@ DFGRaddimage(const char *filename, void * image, int32 xdim, int32 ydim)
 int
 DFGRputimage(const char *filename, void * image, int32 xdim, int32 ydim)
 {
+    HTS_API_LOCK;
     /* 0 == C, 1 == new file */
     return (DFGRIaddimlut(filename, image, xdim, ydim, IMAGE, 0, 1));
 }
@@ -440,6 +453,7 @@ DFGRputimage(const char *filename, void * image, int32 xdim, int32 ydim)
 int
 DFGRreadref(const char *filename, uint16 ref)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFGRreadref");
     intn    ret_value = SUCCEED;
     int32   file_id=(-1);
@@ -967,6 +981,7 @@ int
 DFGRIgetdims(const char *filename, int32 *pxdim, int32 *pydim,
              int *pncomps, int *pil, int type)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFGRIgetdims");
     intn        ret_value = SUCCEED;
     int32       file_id=(-1);
@@ -1024,6 +1039,7 @@ done:
 int
 DFGRIreqil(intn il, intn type)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFGRIreqil");
     intn    ret_value = SUCCEED;
 
@@ -1073,6 +1089,7 @@ DFGRIgetimlut(const char *filename, void * imlut, int32 xdim, int32 ydim,
               int type, int isfortran, int *compressed, uint16 *compr_type, 
 	      int *has_pal)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFGRIgetimlut");
     int32       file_id=(-1);
     int32       currpos[3], currmax[3], destsize[3], bufsize, i, j;
@@ -1263,6 +1280,7 @@ done:
 int
 DFGRIsetdims(int32 xdim, int32 ydim, intn ncomps, int type)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFGRIsetdims");
     intn    ret_value = SUCCEED;
 
@@ -1305,6 +1323,7 @@ done:
 int
 DFGRIsetil(int il, int type)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFGRIsetil");
     intn    ret_value = SUCCEED;
 
@@ -1340,6 +1359,7 @@ done:
 int
 DFGRIrestart(void)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFGRIrestart");
     intn    ret_value = SUCCEED;
 
@@ -1385,6 +1405,7 @@ int
 DFGRIaddimlut(const char *filename, const void * imlut, int32 xdim, int32 ydim,
               int type, int isfortran, int newfile)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFGRIaddimlut");
     int32       file_id=(-1);
     uint16      wtag, wref;     /* tag of image/lut being written */
@@ -1578,6 +1599,7 @@ done:
 uint16
 DFGRIlastref(void)
 {
+    HTS_API_LOCK;
     return ((uint16) Grlastref);
 }
 
@@ -1639,6 +1661,7 @@ done:
 --------------------------------------------------------------------------*/
 intn DFGRPshutdown(void)
 {
+    HTS_API_LOCK;
     if(Grlastfile!=NULL)
       {
           HDfree(Grlastfile);
@@ -89,6 +89,7 @@ setgroupREC(DIlist_ptr list_rec)
 int32
 DFdiread(int32 file_id, uint16 tag, uint16 ref)
 {
+    HTS_API_LOCK;
     DIlist_ptr  new_list;
     CONSTR(FUNC, "DFdiread");
     int32       length;
@@ -143,6 +144,7 @@ DFdiread(int32 file_id, uint16 tag, uint16 ref)
 intn
 DFdiget(int32 list, uint16 *ptag, uint16 *pref)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFdiget");
     uint8      *p;
     DIlist_ptr  list_rec;
@@ -181,6 +183,7 @@ DFdiget(int32 list, uint16 *ptag, uint16 *pref)
 intn
 DFdinobj(int32 list)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFdinobj");
     DIlist_ptr  list_rec;
 
@@ -207,6 +210,7 @@ DFdinobj(int32 list)
 int32
 DFdisetup(int maxsize)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFdisetup");
     DIlist_ptr  new_list;
 
@@ -241,6 +245,7 @@ DFdisetup(int maxsize)
 intn
 DFdiput(int32 list, uint16 tag, uint16 ref)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFdiput");
     uint8      *p;
     DIlist_ptr  list_rec;
@@ -274,6 +279,7 @@ DFdiput(int32 list, uint16 tag, uint16 ref)
 intn
 DFdiwrite(int32 file_id, int32 list, uint16 tag, uint16 ref)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFdiwrite");
     int32       ret;            /* return value */
     DIlist_ptr  list_rec;
@@ -320,6 +326,7 @@ DFdiwrite(int32 file_id, int32 list, uint16 tag, uint16 ref)
  *---------------------------------------------------------------------------*/
 void DFdifree(int32 groupID)
 {
+    HTS_API_LOCK;
 #ifdef LATER
     CONSTR(FUNC, "DFdifree");
 #endif /* LATER */
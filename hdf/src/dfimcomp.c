@@ -117,6 +117,7 @@ VOID
 DFCIimcomp(int32 xdim, int32 ydim, const uint8 *in, uint8 out[],
            uint8 in_pal[], uint8 out_pal[], int mode)
 {
+    HTS_API_LOCK;
     unsigned char raster[48];
     int         blocks, nmbr;
     int32       i, j, k, l, x, y;
@@ -536,6 +537,7 @@ sqr(int16 x)
 VOID
 DFCIunimcomp(int32 xdim, int32 ydim, uint8 in[], uint8 out[])
 {
+    HTS_API_LOCK;
     int         bitmap, temp;
     int32       i, j, k, x, y;
     uint8       hi_color, lo_color;
@@ -230,6 +230,7 @@ intn
 DFCIjpeg(int32 file_id, uint16 tag, uint16 ref, int32 xdim, int32 ydim,
          const void * image, int16 scheme, comp_info * scheme_info)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFCIjpeg");     /* for HERROR */
     /* These three structs contain JPEG parameters and working data.
      * They must survive for the duration of parameter setup and one
@@ -62,6 +62,7 @@ PRIVATE int32 DFPIopen
 intn
 DFPgetpal(const char *filename, void * palette)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFPgetpal");
   int32       file_id;
   int32       aid;
@@ -169,6 +170,7 @@ done:
 intn
 DFPputpal(const char *filename, const void * palette, intn overwrite, const char *filemode)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFPputpal");
   int32       file_id;
   intn        ret_value = SUCCEED;
@@ -237,6 +239,7 @@ done:
 intn
 DFPaddpal(const char *filename, const void * palette)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFPputpal(filename, palette, 0, "a"));
@@ -262,6 +265,7 @@ DFPaddpal(const char *filename, const void * palette)
 intn
 DFPnpals(const char *filename)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFPnpals");
   int32       file_id;
   intn        curr_pal;       /* current palette count */
@@ -379,6 +383,7 @@ done:
 intn
 DFPreadref(const char *filename, uint16 ref)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFPreadref");
   int32       file_id;
   int32       aid;
@@ -435,6 +440,7 @@ done:
 intn
 DFPwriteref(const char *filename, uint16 ref)
 {
+    HTS_API_LOCK;
   intn ret_value = SUCCEED;
 
   /* shut compiler up */
@@ -462,6 +468,7 @@ DFPwriteref(const char *filename, uint16 ref)
 intn
 DFPrestart(void)
 {
+    HTS_API_LOCK;
   intn ret_value = SUCCEED;
 
   Lastfile[0] = '\0';
@@ -487,6 +494,7 @@ DFPrestart(void)
 uint16
 DFPlastref(void)
 {
+    HTS_API_LOCK;
   uint16 ret_value;
 
   ret_value = Lastref;
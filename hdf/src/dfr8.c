@@ -175,6 +175,7 @@ PRIVATE intn DFR8Istart(void);
 intn
 DFR8setcompress(int32 type, comp_info * cinfo)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFR8setcompress");
   intn   ret_value = SUCCEED;
 
@@ -236,6 +237,7 @@ done:
 intn
 DFR8getdims(const char *filename, int32 *pxdim, int32 *pydim, intn *pispal)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFR8getdims");
   int32       file_id=(-1);
   intn        ret_value = SUCCEED;
@@ -306,6 +308,7 @@ done:
 intn
 DFR8getimage(const char *filename, uint8 *image, int32 xdim, int32 ydim, uint8 *pal)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFR8getimage");
   int32       file_id=(-1);
   intn        ret_value = SUCCEED;
@@ -408,6 +411,7 @@ done:
 intn
 DFR8setpalette(uint8 *pal)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFR8setpalette");
   intn     ret_value = SUCCEED;
 
@@ -656,6 +660,7 @@ intn
 DFR8putimage(const char *filename, const void * image, int32 xdim, int32 ydim,
              uint16 compress)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFR8putimage");    /* for HERROR */
     intn ret_value;
 
@@ -704,6 +709,7 @@ intn
 DFR8addimage(const char *filename, const void * image, int32 xdim, int32 ydim,
              uint16 compress)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFR8addimage");    /* for HERROR */
     intn ret_value;
 
@@ -982,6 +988,7 @@ done:
 intn
 DFR8nimages(const char *filename)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFR8nimages");
   int32       file_id;
   int32       group_id;       /* group ID for looking at RIG's */
@@ -1158,6 +1165,7 @@ done:
 intn
 DFR8readref(const char *filename, uint16 ref)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFR8readref");
   int32       file_id=(-1);
   int32       aid;
@@ -1215,6 +1223,7 @@ done:
 intn
 DFR8writeref(const char *filename, uint16 ref)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFR8writeref");    /* for HERROR */
   intn  ret_value = SUCCEED;
 
@@ -1258,6 +1267,7 @@ done:
 intn
 DFR8restart(void)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFR8restart");    /* for HERROR */
     intn ret_value = SUCCEED;
 
@@ -1297,6 +1307,7 @@ done:
 uint16
 DFR8lastref(void)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFR8lastref");    /* for HERROR */
     uint16 ret_value;
 
@@ -1331,6 +1342,7 @@ done:
 intn
 DFR8getpalref(uint16 *pal_ref)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFR8getpalref");
   intn        ret_value = SUCCEED;
 
@@ -1670,6 +1682,7 @@ done:
 --------------------------------------------------------------------------*/
 intn DFR8Pshutdown(void)
 {
+    HTS_API_LOCK;
     if(paletteBuf!=NULL)
       {
           HDfree(paletteBuf);
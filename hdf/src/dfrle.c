@@ -40,6 +40,7 @@
 int32
 DFCIrle(const void * buf, void * bufto, int32 len)
 {
+    HTS_API_LOCK;
     const uint8 *p;
     const uint8 *q;
     uint8 *cfoll;
@@ -118,6 +119,7 @@ DFCIrle(const void * buf, void * bufto, int32 len)
 int32
 DFCIunrle(uint8 *buf, uint8 *bufto, int32 outlen, int resetsave)
 {
+    HTS_API_LOCK;
     int cnt;
     uint8 *p;
     uint8 *q;
@@ -229,6 +229,7 @@ static intn DFSDIstart(void);
 intn
 DFSDgetdims(const char *filename, intn *prank, int32 sizes[], intn maxrank)
 {
+    HTS_API_LOCK;
   intn        i;
   int32       file_id;
   CONSTR(FUNC, "DFSDgetdims");
@@ -300,6 +301,7 @@ done:
 intn
 DFSDgetdatastrs(char *label, char *unit, char *format, char *coordsys)
 {
+    HTS_API_LOCK;
   int32       luf;
   char       *lufp;
   CONSTR(FUNC, "DFSDgetdatastrs");
@@ -373,6 +375,7 @@ done:
 intn
 DFSDgetdimstrs(int dim, char *label, char *unit, char *format)
 {
+    HTS_API_LOCK;
   intn        luf;
   intn        rdim;
   char       *lufp;
@@ -447,6 +450,7 @@ done:
 intn
 DFSDgetdatalen(intn *llabel, intn *lunit, intn *lformat, intn *lcoordsys)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFSDgetdatalen");
   intn      ret_value = SUCCEED;
 
@@ -495,6 +499,7 @@ done:
 intn
 DFSDgetdimlen(intn dim, intn *llabel, intn *lunit, intn *lformat)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFSDgetdimlen");
   intn ret_value = SUCCEED;
 
@@ -545,6 +550,7 @@ done:
 intn
 DFSDgetdimscale(intn dim, int32 maxsize, VOIDP scale)
 {
+    HTS_API_LOCK;
   uint32      dimsize;
   int32       numtype;
   int32       localNTsize;
@@ -626,6 +632,7 @@ done:
 int
 DFSDgetrange(VOIDP pmax, VOIDP pmin)
 {
+    HTS_API_LOCK;
   int32       numtype;
   uint32      localNTsize;
   uint8      *p1, *p2;
@@ -706,6 +713,7 @@ done:
 intn
 DFSDgetdata(const char *filename, intn rank, int32 maxsizes[], VOIDP data)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFSDIgetdata(filename, rank, maxsizes, data, 0));   /* 0 == C */
@@ -736,6 +744,7 @@ intn
 DFSDsetlengths(intn maxlen_label, intn maxlen_unit, intn maxlen_format,
                intn maxlen_coordsys)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFSDsetlengths");
   intn ret_value = SUCCEED;
 
@@ -784,6 +793,7 @@ done:
 intn
 DFSDsetdims(intn rank, int32 dimsizes[])
 {
+    HTS_API_LOCK;
   intn        i;
   CONSTR(FUNC, "DFSDsetdims");
   intn     ret_value = SUCCEED;
@@ -873,6 +883,7 @@ done:
 intn
 DFSDsetdatastrs(const char *label, const char *unit, const char *format, const char *coordsys)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFSDIsetdatastrs(label, unit, format, coordsys));
@@ -986,6 +997,7 @@ done:
 intn
 DFSDsetdimstrs(intn dim, const char *label, const char *unit, const char *format)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFSDIsetdimstrs(dim, label, unit, format));
@@ -1105,6 +1117,7 @@ done:
 intn
 DFSDsetdimscale(intn dim, int32 dimsize, VOIDP scale)
 {
+    HTS_API_LOCK;
     int32       i;
     intn        rdim;
     int32       numtype;
@@ -1237,6 +1250,7 @@ done:
 intn
 DFSDsetrange(VOIDP maxi, VOIDP mini)
 {
+    HTS_API_LOCK;
     int32       numtype;
     uint32      localNTsize;
     intn        i;
@@ -1302,6 +1316,7 @@ done:
 intn
 DFSDputdata(const char *filename, intn rank, int32 dimsizes[], VOIDP data)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   /* 0, 0 specify create mode, C style array (row major) */
@@ -1337,6 +1352,7 @@ DESCRIPTION
 intn
 DFSDadddata(const char *filename, intn rank, int32 dimsizes[], VOIDP data)
 {
+    HTS_API_LOCK;
   intn  ret_value;
 
   /* 1, 0 specifies append mode, C style array (row major) */
@@ -1359,6 +1375,7 @@ DFSDadddata(const char *filename, intn rank, int32 dimsizes[], VOIDP data)
 intn
 DFSDrestart(void)
 {
+    HTS_API_LOCK;
   intn ret_value = SUCCEED;
   CONSTR(FUNC, "DFSDndatasets");
 
@@ -1399,6 +1416,7 @@ done:
 int32
 DFSDndatasets(char *filename)
 {
+    HTS_API_LOCK;
   int32       file_id;
   int32       nsdgs = 0;
   int32       ret_value = SUCCEED;
@@ -1447,6 +1465,7 @@ done:
 intn
 DFSDclear(void)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFSDclear");
   intn   ret_value = SUCCEED;
 
@@ -1487,6 +1506,7 @@ done:
 uint16
 DFSDlastref(void)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "DFSDlastref");
   uint16  ret_value;
 
@@ -1530,6 +1550,7 @@ done:
 intn
 DFSDreadref(char *filename, uint16 ref)
 {
+    HTS_API_LOCK;
   int32       file_id;
   int32       aid;
   intn        ret_value = SUCCEED;
@@ -1606,6 +1627,7 @@ intn
 DFSDgetslice(const char *filename, int32 winst[], int32 windims[], VOIDP data,
              int32 dims[])
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFSDIgetslice(filename, winst, windims, data, dims, 0));
@@ -1636,6 +1658,7 @@ DFSDgetslice(const char *filename, int32 winst[], int32 windims[], VOIDP data,
 intn
 DFSDstartslice(const char *filename)
 {
+    HTS_API_LOCK;
   intn        i;
   int32       size;
   intn        ret_value = SUCCEED;
@@ -1726,6 +1749,7 @@ done:
 intn
 DFSDputslice(int32 winend[], VOIDP data, int32 dims[])
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFSDIputslice(winend, data, dims, 0));
@@ -1755,6 +1779,7 @@ DFSDputslice(int32 winend[], VOIDP data, int32 dims[])
 intn
 DFSDendslice(void)
 {
+    HTS_API_LOCK;
   intn ret_value;
 
   ret_value = (DFSDIendslice(0));
@@ -1791,6 +1816,7 @@ DFSDendslice(void)
 intn
 DFSDsetNT(int32 numbertype)
 {
+    HTS_API_LOCK;
   uint8       outNT;
   intn        ret_value = SUCCEED;
   CONSTR(FUNC, "DFSDsetNT");
@@ -1911,6 +1937,7 @@ done:
 intn
 DFSDgetNT(int32 *pnumbertype)
 {
+    HTS_API_LOCK;
   intn    ret_value = SUCCEED;
   CONSTR(FUNC, "DFSDgetNT");
 
@@ -1959,6 +1986,7 @@ done:
 intn
 DFSDpre32sdg(char *filename, uint16 ref, intn *ispre32)
 {
+    HTS_API_LOCK;
     uint32      num;
     int32       file_id;
     intn        found = 0;
@@ -4749,6 +4777,7 @@ intn
 DFSDgetcal(float64 *pcal, float64 *pcal_err, float64 *pioff,
            float64 *pioff_err, int32 *cal_nt)
 {
+    HTS_API_LOCK;
   intn      ret_value = SUCCEED;
   CONSTR(FUNC, "DFSDgetcal");
 
@@ -4826,6 +4855,7 @@ intn
 DFSDsetcal(float64 cal, float64 cal_err, float64 ioff, float64 ioff_err,
            int32 cal_nt)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFSDsetcal");
   intn    ret_value = SUCCEED;
 
@@ -4872,6 +4902,7 @@ done:
 intn
 DFSDwriteref(const char *filename, uint16 ref)
 {
+    HTS_API_LOCK;
   int32       file_id;
   int32       aid;
   intn        ret_value = SUCCEED;
@@ -4950,6 +4981,7 @@ done:
 intn
 DFSDsetfillvalue(VOIDP fill_value)
 {
+    HTS_API_LOCK;
   int32       numtype;        /* current number type  */
   uint32      localNTsize;    /* size of this NT on as it is on this machine  */
   intn        ret_value = SUCCEED;
@@ -5011,6 +5043,7 @@ done:
 intn
 DFSDgetfillvalue(VOIDP fill_value)
 {
+    HTS_API_LOCK;
   int32       numtype;        /* current number type  */
   uint32      localNTsize;    /* size of this NT on as it is on this machine  */
   intn        ret_value = SUCCEED;
@@ -5085,6 +5118,7 @@ intn
 DFSDreadslab(const char *filename, int32 start[], int32 slab_size[],
              int32 stride[], VOIDP buffer, int32 buffer_size[])
 {
+    HTS_API_LOCK;
   intn  ret_value = SUCCEED;
   /* shut compiler up */
   stride = stride;
@@ -5113,6 +5147,7 @@ DFSDreadslab(const char *filename, int32 start[], int32 slab_size[],
 intn
 DFSDstartslab(const char *filename)
 {
+    HTS_API_LOCK;
   int32       i;
   int32       sdg_size;
   int32       localNTsize;
@@ -5285,6 +5320,7 @@ intn
 DFSDwriteslab(int32 start[], int32 stride[],
               int32 count[], VOIDP data)
 {
+    HTS_API_LOCK;
   intn        rank;           /* number of dimensions in data[] */
   int32       i;              /* temporary loop index */
 
@@ -5586,6 +5622,7 @@ done:
 intn
 DFSDendslab(void)
 {
+    HTS_API_LOCK;
   intn        ret_value = SUCCEED;
   CONSTR(FUNC, "DFSDendslab");
 
@@ -5710,6 +5747,7 @@ done:
 --------------------------------------------------------------------------*/
 intn DFSDPshutdown(void)
 {
+    HTS_API_LOCK;
     DFSDIclear(&Readsdg);
     DFSDIclear(&Writesdg);
 
@@ -99,6 +99,7 @@ PRIVATE char patterns[] =
 DF         *
 DFopen(char *name, int acc_mode, int ndds)
 {
+    HTS_API_LOCK;
     if (DFIcheck(DFlist) == 0)
       {
           DFerror = DFE_TOOMANY;
@@ -143,6 +144,7 @@ DFopen(char *name, int acc_mode, int ndds)
 int
 DFclose(DF * dfile)
 {
+    HTS_API_LOCK;
     int         ret;
 
     if (DFIcheck(dfile) != 0)
@@ -206,6 +208,7 @@ DFclose(DF * dfile)
 int
 DFdescriptors(DF * dfile, DFdesc ptr[], int begin, int num)
 {
+    HTS_API_LOCK;
     int         i, ret;
     int32       aid;
 
@@ -275,6 +278,7 @@ DFdescriptors(DF * dfile, DFdesc ptr[], int begin, int num)
 int
 DFnumber(DF * dfile, uint16 tag)
 {
+    HTS_API_LOCK;
     int         num;
 
     if (DFIcheck(dfile) != 0)
@@ -309,6 +313,7 @@ DFnumber(DF * dfile, uint16 tag)
 int
 DFsetfind(DF * dfile, uint16 tag, uint16 ref)
 {
+    HTS_API_LOCK;
     if (DFIcheck(dfile) != 0)
       {
           DFerror = DFE_NOTOPEN;
@@ -344,6 +349,7 @@ DFsetfind(DF * dfile, uint16 tag, uint16 ref)
 int
 DFfind(DF * dfile, DFdesc * ptr)
 {
+    HTS_API_LOCK;
     int         ret;
 
     if (DFIcheck(dfile) != 0)
@@ -405,6 +411,7 @@ DFfind(DF * dfile, DFdesc * ptr)
 int
 DFaccess(DF * dfile, uint16 tag, uint16 ref, char *acc_mode)
 {
+    HTS_API_LOCK;
     int         accmode;
     /*
        DFdle *ptr;
@@ -554,6 +561,7 @@ DFIclearacc(void)
 int
 DFstart(DF * dfile, uint16 tag, uint16 ref, char *acc_mode)
 {
+    HTS_API_LOCK;
     return (DFaccess(dfile, tag, ref, acc_mode));
 }
 
@@ -578,6 +586,7 @@ DFstart(DF * dfile, uint16 tag, uint16 ref, char *acc_mode)
 int32
 DFread(DF * dfile, char *ptr, int32 len)
 {
+    HTS_API_LOCK;
     int32       ret;
 
     if (DFIcheck(dfile) != 0)
@@ -631,6 +640,7 @@ DFread(DF * dfile, char *ptr, int32 len)
 int32
 DFseek(DF * dfile, int32 offset)
 {
+    HTS_API_LOCK;
     int         ret;
 
     if (DFIcheck(dfile) != 0)
@@ -688,6 +698,7 @@ DFseek(DF * dfile, int32 offset)
 int32
 DFwrite(DF * dfile, char *ptr, int32 len)
 {
+    HTS_API_LOCK;
     int32       size, ret, newlen;
 
     if (DFIcheck(dfile) != 0)
@@ -769,6 +780,7 @@ DFwrite(DF * dfile, char *ptr, int32 len)
 int
 DFupdate(DF * dfile)
 {
+    HTS_API_LOCK;
     if (DFIcheck(dfile) != 0)
       {
           DFerror = DFE_NOTOPEN;
@@ -809,6 +821,7 @@ DFupdate(DF * dfile)
 int
 DFstat(DF * dfile, DFdata * dfinfo)
 {
+    HTS_API_LOCK;
     if (DFIcheck(dfile) != 0)
       {
           DFerror = DFE_NOTOPEN;
@@ -844,6 +857,7 @@ DFstat(DF * dfile, DFdata * dfinfo)
 int32
 DFgetelement(DF * dfile, uint16 tag, uint16 ref, char *ptr)
 {
+    HTS_API_LOCK;
     if (DFIcheck(dfile) != 0)
       {
           DFerror = DFE_NOTOPEN;
@@ -891,6 +905,7 @@ DFgetelement(DF * dfile, uint16 tag, uint16 ref, char *ptr)
 int32
 DFputelement(DF * dfile, uint16 tag, uint16 ref, char *ptr, int32 len)
 {
+    HTS_API_LOCK;
     if (DFIcheck(dfile) != 0)
       {
           DFerror = DFE_NOTOPEN;
@@ -938,6 +953,7 @@ DFputelement(DF * dfile, uint16 tag, uint16 ref, char *ptr, int32 len)
 int
 DFdup(DF * dfile, uint16 itag, uint16 iref, uint16 otag, uint16 oref)
 {
+    HTS_API_LOCK;
     if (DFIcheck(dfile) != 0)
       {
           DFerror = DFE_NOTOPEN;
@@ -976,6 +992,7 @@ DFdup(DF * dfile, uint16 itag, uint16 iref, uint16 otag, uint16 oref)
 int
 DFdel(DF * dfile, uint16 tag, uint16 ref)
 {
+    HTS_API_LOCK;
     if (DFIcheck(dfile) != 0)
       {
           DFerror = DFE_NOTOPEN;
@@ -1011,6 +1028,7 @@ DFdel(DF * dfile, uint16 tag, uint16 ref)
 uint16
 DFnewref(DF * dfile)
 {
+    HTS_API_LOCK;
     uint16      ret;
 
     if (DFIcheck(dfile) != 0)
@@ -1049,6 +1067,7 @@ DFnewref(DF * dfile)
 int
 DFishdf(char *filename)
 {
+    HTS_API_LOCK;
     int32       dummy;
 
     DFerror = DFE_NONE;
@@ -1083,6 +1102,7 @@ DFishdf(char *filename)
 int
 DFerrno(void)
 {
+    HTS_API_LOCK;
     return (DFerror);
 }
 
@@ -1396,6 +1416,7 @@ int32       offset;
 int
 DFIerr(DF * dfile)
 {
+    HTS_API_LOCK;
     int         saveerror;
 
     saveerror = DFerror;
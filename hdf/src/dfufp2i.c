@@ -114,6 +114,7 @@ DFUfptoimage(int32 hdim, int32 vdim, float32 max, float32 min,
              float32 *hscale, float32 *vscale, float32 *data, uint8 *palette,
          char *outfile, int ct_method, int32 hres, int32 vres, int compress)
 {
+    HTS_API_LOCK;
     Input       in;
     Output      out;
 
@@ -310,6 +310,7 @@ intn
 DFCIunjpeg(int32 file_id, uint16 tag, uint16 ref, VOIDP image, int32 xdim,
            int32 ydim, int16 scheme)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFCIunjpeg");     /* for HERROR */
     /* These three structs contain JPEG parameters and working data.
      * They must survive for the duration of parameter setup and one
@@ -51,6 +51,7 @@
 uint16
 DFfindnextref(int32 file_id, uint16 tag, uint16 lref)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "DFfindnextref");
     uint16      newtag=DFTAG_NULL, newref=DFTAG_NULL;
     int32       aid;
@@ -85,6 +85,7 @@ PRIVATE intn HIbitstart(void);
 int32
 Hstartbitread(int32 file_id, uint16 tag, uint16 ref)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Hstartbitread");  /* for HERROR */
     int32       aid;            /* Access ID for the bit-level routines to use */
     struct bitrec_t *bitfile_rec;   /* Pointer to the bitfile record */
@@ -164,6 +165,7 @@ Hstartbitread(int32 file_id, uint16 tag, uint16 ref)
 int32
 Hstartbitwrite(int32 file_id, uint16 tag, uint16 ref, int32 length)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Hstartbitwrite");     /* for HERROR */
     bitrec_t   *bitfile_rec;    /* access record */
     int32       aid;            /* Access ID for the bit-level routines to use */
@@ -249,6 +251,7 @@ Hstartbitwrite(int32 file_id, uint16 tag, uint16 ref, int32 length)
 intn
 Hbitappendable(int32 bitid)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Hbitappendable");     /* for HERROR */
     bitrec_t   *bitfile_rec;    /* access record */
 
@@ -292,6 +295,7 @@ Hbitappendable(int32 bitid)
 intn
 Hbitwrite(int32 bitid, intn count, uint32 data)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Hbitwrite");  /* for HERROR */
     static int32 last_bit_id=(-1); /* the bit ID of the last bitfile_record accessed */
     static bitrec_t   *bitfile_rec=NULL; /* access record */
@@ -431,6 +435,7 @@ Hbitwrite(int32 bitid, intn count, uint32 data)
 intn
 Hbitread(int32 bitid, intn count, uint32 *data)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Hbitread");   /* for HERROR */
     static int32 last_bit_id=(-1); /* the bit ID of the last bitfile_record accessed */
     static bitrec_t   *bitfile_rec=NULL;    /* access record */
@@ -562,6 +567,7 @@ REVISION LOG
 intn
 Hbitseek(int32 bitid, int32 byte_offset, intn bit_offset)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Hbitseek");   /* for HERROR */
     bitrec_t   *bitfile_rec;    /* access record */
     int32       seek_pos;       /* position of block to seek to */
@@ -655,6 +661,7 @@ Hbitseek(int32 bitid, int32 byte_offset, intn bit_offset)
 intn
 Hgetbit(int32 bitid)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Hgetbit");    /* for HERROR */
     uint32      data;
 
@@ -721,6 +728,7 @@ Hputbit(int32 bitid, intn bit)
 int32
 Hendbitaccess(int32 bitfile_id, intn flushbit)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Hendbitaccess");  /* for HERROR */
     bitrec_t   *bitfile_rec;    /* bitfile record */
 
@@ -953,6 +961,7 @@ HIwrite2read(bitrec_t * bitfile_rec)
 --------------------------------------------------------------------------*/
 intn HPbitshutdown(void)
 {
+    HTS_API_LOCK;
     /* Shutdown the file ID atom group */
     HAdestroy_group(BITIDGROUP);
 
@@ -220,6 +220,8 @@ HLcreate(int32  file_id,
          int32  block_length,
          int32  number_blocks)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HLcreate");   /* for HERROR */
     filerec_t  *file_rec;       /* file record */
     accrec_t   *access_rec=NULL;/* access record */
@@ -230,7 +232,7 @@ HLcreate(int32  file_id,
     atom_t      data_id;        /* dd ID of existing regular element */
     uint16      new_data_tag, new_data_ref=0;  /* Tag/ref of the new data in the file */
     int32       data_len;		/* length of the data we are checking */
-    int32       data_off;		/* offset of the data we are checking */
+    hdf_off_t   data_off;		/* offset of the data we are checking */
     uint16      special_tag;    /* special version of this tag */
     uint8       local_ptbuf[16];
     int32       ret_value = SUCCEED;
@@ -420,6 +422,8 @@ HLconvert(int32 aid,
           int32 block_length,
           int32 number_blocks)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(aid);
     CONSTR(FUNC, "HLconvert");  /* for HERROR */
     filerec_t  *file_rec;       /* file record */
     accrec_t   *access_rec=NULL;/* access record */
@@ -430,7 +434,7 @@ HLconvert(int32 aid,
     uint16      new_data_tag=DFTAG_NULL, new_data_ref=0;  /* Tag/ref of the new data in the file */
     uint16      data_tag, data_ref;  /* Tag/ref of the data in the file */
     int32       data_len;		/* length of the data we are checking */
-    int32       data_off;		/* offset of the data we are checking */
+    hdf_off_t   data_off;		/* offset of the data we are checking */
     uint16      special_tag;    /* special version of this tag */
     int32       file_id;        /* file ID for the access record */
     uint8       local_ptbuf[16];
@@ -601,6 +605,8 @@ HDinqblockinfo(int32 aid,
                int32 *block_length,
                int32 *number_blocks)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(aid);
     accrec_t   *arec;
     int        ret_value = SUCCEED;
     CONSTR(FUNC, "HDinqblockinfo");
@@ -840,6 +846,8 @@ HLgetdatainfo(int32 file_id,
 	   int32 *offsetarray,     /* OUT: array to hold offsets */
 	   int32 *lengtharray)     /* OUT: array to hold lengths */
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HLgetdatainfo");	/* for HERROR */
     link_t *link_info=NULL;  /* link information, to get block ref#s*/
     intn    num_data_blocks; /* number of blocks that actually have data */
@@ -1929,6 +1937,8 @@ HLsetblockinfo(int32 aid,	/* access record id */
               int32 block_size, /* length to be used for each linked-block */
               int32 num_blocks) /* number of blocks the element will have */
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(aid);
     CONSTR(FUNC, "HLsetblockinfo");  	/* for HERROR */
     accrec_t   *access_rec;               /* access record */
     intn	ret_value = SUCCEED;
@@ -2004,6 +2014,8 @@ HLgetblockinfo(int32 aid,	/* access record id */
               int32* block_size, /* length being used for each linked-block */
               int32* num_blocks) /* number of blocks the element will have */
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(aid);
     CONSTR(FUNC, "HLgetblockinfo");  /* for HERROR */
     accrec_t   *access_rec;               /* access record */
     intn	ret_value = SUCCEED;
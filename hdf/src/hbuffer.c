@@ -108,13 +108,15 @@ FORTRAN
 intn
 HBconvert(int32 aid)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(aid);
     CONSTR(FUNC, "HBconvert");   /* for HERROR */
     accrec_t   *access_rec=NULL;/* access element record */
     accrec_t   *new_access_rec; /* newly created access record */
     accrec_t   *tmp_access_rec; /* temp. access record */
     bufinfo_t  *info;           /* information for the buffered element */
     uint16 data_tag,data_ref;   /* tag/ref of the data we are checking */
-    int32       data_off;		/* offset of the data we are checking */
+    hdf_off_t   data_off;		/* offset of the data we are checking */
     int32       data_len;		/* length of the data we are checking */
     intn        ret_value = SUCCEED;
 
@@ -125,8 +127,9 @@ HBconvert(int32 aid)
     /* get the info for the dataset */
     if (HTPis_special(access_rec->ddid) || access_rec->special!=0) {
         if((*access_rec->special_func->inquire) (access_rec, NULL,
-                           &data_tag, &data_ref, &data_len, &data_off, NULL, NULL, NULL)==FAIL)
+                           &data_tag, &data_ref, &data_len, NULL, NULL, NULL, NULL)==FAIL)
             HGOTO_ERROR(DFE_INTERNAL, FAIL);
+        data_off = 0;   /* the special element's header is in the file */
     } /* end if */
     else
         if(HTPinquire(access_rec->ddid,&data_tag,&data_ref,&data_off,&data_len)==FAIL)
@@ -454,12 +457,14 @@ HBPinquire(accrec_t * access_rec, int32 *pfile_id, uint16 *ptag,
     bufinfo_t  *info =          /* special information record */
         (bufinfo_t *) access_rec->special_info;
     uint16 data_tag,data_ref;   /* tag/ref of the data we are checking */
-    int32       data_off;		/* offset of the data we are checking */
+    hdf_off_t   data_off;		/* offset of the data we are checking */
     int32    ret_value = SUCCEED;
 
     /* Get the data's offset & length */
     if(HTPinquire(info->buf_access_rec->ddid,&data_tag,&data_ref,&data_off,NULL)==FAIL)
         HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    if (poffset && data_off > MAX_OFFSET32)
+        HGOTO_ERROR(DFE_EXCEEDMAX, FAIL);
 
     /* fill in the variables if they are present */
     if (pfile_id)
@@ -471,7 +476,7 @@ HBPinquire(accrec_t * access_rec, int32 *pfile_id, uint16 *ptag,
     if (plength)
         *plength = info->length;    /* pass along our value, which might be different from that on disk */
     if (poffset)
-        *poffset = data_off;
+        *poffset = (int32)data_off;
     if (pposn)
         *pposn = access_rec->posn;
     if (paccess)
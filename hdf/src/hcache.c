@@ -0,0 +1,416 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Board of Trustees of the University of Illinois.         *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of HDF.  The full HDF copyright notice, including       *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the root of the source code       *
+ * distribution tree, or in https://support.hdfgroup.org/ftp/HDF/releases/.  *
+ * If you do not have access to either file, you may request a copy from     *
+ * help@hdfgroup.org.                                                        *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* $Id$ */
+
+/*
+FILE
+    hcache.c - The chunk cache shared by all the chunked elements.
+
+REMARKS
+    The cache of a chunked element (see mcache.c) lives as long as the
+    access to the element, once the element is ended the next access
+    has to read and decompress its chunks all over again.  The shared
+    cache keeps the chunks read from the files, decompressed, for all
+    the accesses of the process, within one limit on the memory it
+    uses.  It is off until HMCsetSharedCache() or the environment
+    variable HDF4_SHARED_CHUNK_CACHE_BYTES gives it a size.
+
+    The chunks are found by their file and the tag/ref of the data
+    element the chunk is stored in, which is unique in the file.  The
+    chunked element reads a chunk from the shared cache before going to
+    the file (HMCPchunkread, HMCPchunkreadv), and drops it from the
+    shared cache when it writes the chunk (HMCPchunkwrite).  The chunks
+    of a file are dropped when the file is closed.
+
+DESIGN
+    A hash table of the chunks, by file, tag and ref, and a least
+    recently used list through all of them; the least recently used
+    chunks go when the cache is over its limit.  The memory of a chunk
+    counts its data and its record.  A mutex of its own guards the
+    cache, so that threads reading different files share it, and the
+    chunks are copied in and out while holding it.
+
+EXPORTED ROUTINES
+    HCSsetmax      -- set the most memory of the shared cache
+    HCSget         -- copy a chunk out of the shared cache
+    HCSput         -- copy a chunk into the shared cache
+    HCSinvalidate  -- drop a chunk from the shared cache
+    HCSpurge       -- drop all the chunks of a file
+    HCSshutdown    -- drop all the chunks
+
+MODIFICATION HISTORY
+*/
+
+#include "hdf.h"
+
+#define HCS_HASH_SIZE   1024        /* buckets of the hash table */
+#define HCS_BYTES_ENV   "HDF4_SHARED_CHUNK_CACHE_BYTES" /* initial limit */
+
+/* A chunk in the cache, its data follows the record */
+typedef struct hcs_chunk_t
+{
+    VOIDP       file;               /* file record of the chunk */
+    uint16      tag;                /* tag/ref the chunk is stored in */
+    uint16      ref;
+    int32       length;             /* bytes of data */
+    struct hcs_chunk_t *hnext;      /* next in the hash bucket */
+    struct hcs_chunk_t *prev;       /* more recently used */
+    struct hcs_chunk_t *next;       /* less recently used */
+}
+hcs_chunk_t;
+
+/* The cache */
+#ifdef H4_HAVE_THREADSAFE
+PRIVATE pthread_mutex_t hcs_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif /* H4_HAVE_THREADSAFE */
+PRIVATE hcs_chunk_t *hcs_hash[HCS_HASH_SIZE];
+PRIVATE hcs_chunk_t *hcs_mru = NULL;   /* most recently used chunk */
+PRIVATE hcs_chunk_t *hcs_lru = NULL;   /* least recently used chunk */
+PRIVATE int32 hcs_max = 0;             /* most bytes to use, 0 = off */
+PRIVATE int32 hcs_used = 0;            /* bytes used */
+PRIVATE intn hcs_started = FALSE;      /* TRUE once the environment was read */
+
+/* Private routines */
+PRIVATE intn HCSIstart
+            (void);
+
+PRIVATE hcs_chunk_t **HCSIfind
+            (VOIDP file, uint16 tag, uint16 ref);
+
+PRIVATE void HCSIunlink
+            (hcs_chunk_t *chunk);
+
+PRIVATE void HCSIshrink
+            (int32 max);
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCSIstart -- whether the shared cache is on
+ USAGE
+    intn HCSIstart()
+ RETURNS
+    TRUE if the cache has a size, FALSE otherwise
+ DESCRIPTION
+    Called with the cache lock held.  The first time through, takes the
+    size of the cache from the environment variable
+    HDF4_SHARED_CHUNK_CACHE_BYTES, if it is set and nothing set a size
+    before.
+--------------------------------------------------------------------------*/
+PRIVATE intn
+HCSIstart(void)
+{
+    char       *env;
+    long        bytes;
+
+    if (!hcs_started)
+      {
+          hcs_started = TRUE;
+          /* more than an int32 holds is as good as no limit */
+          if (hcs_max == 0 && (env = HDgetenv(HCS_BYTES_ENV)) != NULL
+              && (bytes = HDstrtol(env, NULL, 10)) > 0)
+              hcs_max = (int32)(bytes > (long)INT_MAX ? INT_MAX : bytes);
+      }
+    return (hcs_max > 0);
+}   /* end HCSIstart() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCSIfind -- find the link to a chunk
+ USAGE
+    hcs_chunk_t **HCSIfind(file, tag, ref)
+        VOIDP file;             IN: file record of the chunk
+        uint16 tag, ref;        IN: tag/ref the chunk is stored in
+ RETURNS
+    The link in its hash bucket pointing at the chunk, which points at
+    NULL if the chunk is not cached
+ DESCRIPTION
+    Called with the cache lock held.
+--------------------------------------------------------------------------*/
+PRIVATE hcs_chunk_t **
+HCSIfind(VOIDP file, uint16 tag, uint16 ref)
+{
+    hcs_chunk_t **link;
+    uint32      key;
+
+    key = ((uint32) ref * 31 + (uint32) tag) ^ (uint32) ((size_t) file >> 4);
+    for (link = &hcs_hash[key % HCS_HASH_SIZE]; *link != NULL; link = &(*link)->hnext)
+        if ((*link)->file == file && (*link)->tag == tag && (*link)->ref == ref)
+            break;
+    return (link);
+}   /* end HCSIfind() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCSIunlink -- take a chunk off the least recently used list
+ USAGE
+    void HCSIunlink(chunk)
+        hcs_chunk_t *chunk;     IN: chunk to take off
+ RETURNS
+    Nothing
+ DESCRIPTION
+    Called with the cache lock held.
+--------------------------------------------------------------------------*/
+PRIVATE void
+HCSIunlink(hcs_chunk_t *chunk)
+{
+    if (chunk->prev != NULL)
+        chunk->prev->next = chunk->next;
+    else
+        hcs_mru = chunk->next;
+    if (chunk->next != NULL)
+        chunk->next->prev = chunk->prev;
+    else
+        hcs_lru = chunk->prev;
+}   /* end HCSIunlink() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCSIshrink -- drop chunks until the cache fits in a size
+ USAGE
+    void HCSIshrink(max)
+        int32 max;              IN: bytes the cache may use
+ RETURNS
+    Nothing
+ DESCRIPTION
+    Called with the cache lock held.  Drops the least recently used
+    chunks first.
+--------------------------------------------------------------------------*/
+PRIVATE void
+HCSIshrink(int32 max)
+{
+    hcs_chunk_t *chunk;
+    hcs_chunk_t **link;
+
+    while (hcs_used > max && (chunk = hcs_lru) != NULL)
+      {
+          link = HCSIfind(chunk->file, chunk->tag, chunk->ref);
+          *link = chunk->hnext;
+          HCSIunlink(chunk);
+          hcs_used -= (int32) sizeof(hcs_chunk_t) + chunk->length;
+          HDfree(chunk);
+      }
+}   /* end HCSIshrink() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCSsetmax -- set the most memory of the shared cache
+ USAGE
+    intn HCSsetmax(max)
+        int32 max;              IN: most bytes to use, 0 turns the cache off
+ RETURNS
+    SUCCEED/FAIL
+ DESCRIPTION
+    Sets the limit on the memory the shared chunk cache uses, dropping
+    the least recently used chunks until it fits.
+--------------------------------------------------------------------------*/
+intn
+HCSsetmax(int32 max)
+{
+    HTS_MUTEX_GUARD(hcs_lock);
+
+    if (max < 0)
+        return (FAIL);
+
+    hcs_started = TRUE;
+    hcs_max = max;
+    HCSIshrink(max);
+    return (SUCCEED);
+}   /* end HCSsetmax() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCSget -- copy a chunk out of the shared cache
+ USAGE
+    intn HCSget(file, tag, ref, datap, length)
+        VOIDP file;             IN: file record of the chunk
+        uint16 tag, ref;        IN: tag/ref the chunk is stored in
+        VOIDP datap;            OUT: buffer for the chunk
+        int32 length;           IN: bytes of the chunk
+ RETURNS
+    TRUE if the chunk was cached, FALSE otherwise
+ DESCRIPTION
+    Copies the chunk into the buffer if the shared cache holds it, with
+    the given length, and makes it the most recently used chunk.
+--------------------------------------------------------------------------*/
+intn
+HCSget(VOIDP file, uint16 tag, uint16 ref, VOIDP datap, int32 length)
+{
+    HTS_MUTEX_GUARD(hcs_lock);
+    hcs_chunk_t *chunk;
+
+    if (!HCSIstart())
+        return (FALSE);
+
+    chunk = *HCSIfind(file, tag, ref);
+    if (chunk == NULL || chunk->length != length)
+        return (FALSE);
+
+    HDmemcpy(datap, chunk + 1, length);
+    if (chunk != hcs_mru)
+      {
+          HCSIunlink(chunk);
+          chunk->prev = NULL;
+          chunk->next = hcs_mru;
+          hcs_mru->prev = chunk;
+          hcs_mru = chunk;
+      }
+    return (TRUE);
+}   /* end HCSget() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCSput -- copy a chunk into the shared cache
+ USAGE
+    void HCSput(file, tag, ref, datap, length)
+        VOIDP file;             IN: file record of the chunk
+        uint16 tag, ref;        IN: tag/ref the chunk is stored in
+        const VOID *datap;      IN: the chunk
+        int32 length;           IN: bytes of the chunk
+ RETURNS
+    Nothing
+ DESCRIPTION
+    Keeps a copy of a chunk as it is in the file, as the most recently
+    used chunk, dropping the least recently used ones to make room.
+    Chunks larger than the whole cache, and chunks there is no memory
+    for, are not kept.
+--------------------------------------------------------------------------*/
+void
+HCSput(VOIDP file, uint16 tag, uint16 ref, const VOID *datap, int32 length)
+{
+    HTS_MUTEX_GUARD(hcs_lock);
+    hcs_chunk_t **link;
+    hcs_chunk_t *chunk;
+    int32       size = (int32) sizeof(hcs_chunk_t) + length;
+
+    if (!HCSIstart() || length <= 0 || size > hcs_max)
+        return;
+
+    /* a chunk read while it was cached is the same chunk */
+    if (*(link = HCSIfind(file, tag, ref)) != NULL)
+        return;
+
+    HCSIshrink(hcs_max - size);
+    if ((chunk = (hcs_chunk_t *) HDmalloc((uint32) size)) == NULL)
+        return;
+    chunk->file = file;
+    chunk->tag = tag;
+    chunk->ref = ref;
+    chunk->length = length;
+    HDmemcpy(chunk + 1, datap, length);
+
+    /* the shrinking may have changed the bucket */
+    link = HCSIfind(file, tag, ref);
+    chunk->hnext = NULL;
+    *link = chunk;
+    chunk->prev = NULL;
+    chunk->next = hcs_mru;
+    if (hcs_mru != NULL)
+        hcs_mru->prev = chunk;
+    else
+        hcs_lru = chunk;
+    hcs_mru = chunk;
+    hcs_used += size;
+}   /* end HCSput() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCSinvalidate -- drop a chunk from the shared cache
+ USAGE
+    void HCSinvalidate(file, tag, ref)
+        VOIDP file;             IN: file record of the chunk
+        uint16 tag, ref;        IN: tag/ref the chunk is stored in
+ RETURNS
+    Nothing
+ DESCRIPTION
+    Called before a chunk is written, the copy of the cache is then out
+    of date, and when the tag/ref of a chunk is deleted or re-used
+    (HTPdelete, HDreuse_tagref), as the tag/ref may then name other data.
+--------------------------------------------------------------------------*/
+void
+HCSinvalidate(VOIDP file, uint16 tag, uint16 ref)
+{
+    HTS_MUTEX_GUARD(hcs_lock);
+    hcs_chunk_t **link;
+    hcs_chunk_t *chunk;
+
+    if (hcs_used == 0)
+        return;
+
+    link = HCSIfind(file, tag, ref);
+    if ((chunk = *link) != NULL)
+      {
+          *link = chunk->hnext;
+          HCSIunlink(chunk);
+          hcs_used -= (int32) sizeof(hcs_chunk_t) + chunk->length;
+          HDfree(chunk);
+      }
+}   /* end HCSinvalidate() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCSpurge -- drop all the chunks of a file
+ USAGE
+    void HCSpurge(file)
+        VOIDP file;             IN: file record of the chunks
+ RETURNS
+    Nothing
+ DESCRIPTION
+    Called when the file record is released, a file opened later may
+    get the same record.
+--------------------------------------------------------------------------*/
+void
+HCSpurge(VOIDP file)
+{
+    HTS_MUTEX_GUARD(hcs_lock);
+    hcs_chunk_t **link;
+    hcs_chunk_t *chunk;
+    intn        i;
+
+    if (hcs_used == 0)
+        return;
+
+    for (i = 0; i < HCS_HASH_SIZE; i++)
+        for (link = &hcs_hash[i]; (chunk = *link) != NULL; )
+          {
+              if (chunk->file != file)
+                {
+                    link = &chunk->hnext;
+                    continue;
+                }
+              *link = chunk->hnext;
+              HCSIunlink(chunk);
+              hcs_used -= (int32) sizeof(hcs_chunk_t) + chunk->length;
+              HDfree(chunk);
+          }
+}   /* end HCSpurge() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCSshutdown -- drop all the chunks
+ USAGE
+    intn HCSshutdown()
+ RETURNS
+    SUCCEED
+ DESCRIPTION
+    Frees the memory of the shared cache when the library shuts down,
+    the size of the cache stays.
+--------------------------------------------------------------------------*/
+intn
+HCSshutdown(void)
+{
+    HTS_MUTEX_GUARD(hcs_lock);
+
+    HCSIshrink(0);
+    return (SUCCEED);
+}   /* end HCSshutdown() */
@@ -201,7 +201,13 @@ EXPORTED ROUTINES
    HMCcreate       -- create a chunked element
    HMCwriteChunk   -- write out the specified chunk to a chunked element
    HMCreadChunk    -- read the specified chunk from a chunked element
+   HMCwriteSlab    -- write out a slab of a chunked element
+   HMCreadSlab     -- read a slab of a chunked element
+   HMCreadSlabMap  -- read a slab, telling which of its chunks were written
    HMCsetMaxcache  -- maximum number of chunks to cache 
+   HMCsetCachePolicy -- byte limit and eviction policy of the chunk cache
+   HMCsetSharedCache -- byte limit of the chunk cache shared by all elements
+   HMCsetAlignment -- where in the file to place the chunks written
    HMCPcloseAID    -- close file but keep AID active (For Hnextread())
 
    Library Private
@@ -210,19 +216,16 @@ EXPORTED ROUTINES
    HMCPstwrite     -- open an access record for writing
    HMCPseek        -- set the seek posn
    HMCPchunkread   -- read a single chunk out of a chunked element
+   HMCPchunkreadv  -- read several chunks out of a chunked element
    HMCPread        -- read some data out of a chunked element
    HMCPchunkwrite  -- write out a single chunk to a chunked element
+   HMCPchunkwritev -- write out several chunks to a chunked element
    HMCPwrite       -- write out some data to a chunked element
    HMCPinquire     -- Hinquire for chunked element
    HMCPendacess    -- close a chunked element AID
    HMCPinfo        -- return info about a chunked element
    HMCPgetnumrecs  -- get the number of records in a chunked element
-
-   TBBT helper rotuines
-   -------------------
-   chkcompare      -- comprares 2 chunk records
-   chkfreekey      -- frees chunk key
-   chkdestroynode  -- destroys chunk record
+   HMCPtableread   -- check whether the chunk table has been read in
 
 LOCAL ROUTINES
 ==============
@@ -240,10 +243,30 @@ LOCAL ROUTINES
    update_seek_pos_chunk     -- update chunk seek array with seek pos in chunk 
    calculate_chunk_num       -- translate chunk coordinates to a number
    calculate_chunk_for_chunk -- calculate number of bytes to operate on chunk
+   calculate_whole_chunk     -- extend the bytes to operate on to the whole chunk
+   calculate_chunk_idx       -- translate a chunk number to chunk coordinates
+
+   Chunk index routines
+   --------------------
+   HMCIslot        -- slot of a chunk in the chunk index
+   HMCIindex_size  -- resize the chunk index, making it flat or hashed
+   HMCIindex_put   -- add a chunk record to the chunk index
+   HMCIindex_load  -- read the chunk table into the chunk index
+   HMCIindex_free  -- free the chunk index and its records
+   HMCIfind_chunk  -- look a chunk record up
+   HMCInew_chunk   -- add a record for a chunk not in the table yet
 
    Common Routine
    -------------
    HMCIstaccess -- set up AID to access a chunked element
+   HMCIdecode_chunk -- decompress a chunk on the worker pool
+   HMCIencode_chunk -- compress a chunk on the worker pool
+   HMCIplace_chunk  -- find the place in the file for a new chunk
+   HMCIunplace      -- give back the places preallocated for chunks not written
+   HMCIchunkwrite   -- write out a chunk, compressed beforehand or not
+   HMCIslab_whole   -- see whether a chunk lies whole in a slab
+   HMCIcopy_slab    -- copy the part of a slab in a chunk
+   HMCIslab         -- read or write a slab of a chunked element
 
    AUTHOR 
    ------- 
@@ -273,11 +296,111 @@ LOCAL ROUTINES
 #include "mcache.h" /* cache */
 #include "hchunks.h"
 
+/* Most chunks HMCPread gets from the cache at once */
+#define HMC_READ_BATCH  64
+
+/* Most chunks HMCPread reads ahead */
+#define HMC_READ_AHEAD  8
+
+/* Chunk index, see HMCIslot() */
+#define HMC_INDEX_MIN     64    /* fewest slots of the chunk index */
+#define HMC_INDEX_SPREAD  4     /* most slots of a flat index per chunk */
+
+/* A chunk HMCPchunkreadv decompresses on the worker pool */
+typedef struct
+{
+    comp_coder_t coder;     /* coder the chunk is compressed with */
+    uint8       *coded;     /* compressed chunk */
+    int32        coded_len; /* length of compressed chunk */
+    VOID        *datap;     /* buffer for the chunk */
+    int32        length;    /* length of the chunk */
+    int32        nread;     /* OUT: bytes decompressed or FAIL */
+    int32        index;     /* index of the chunk in the batch */
+    uint16       tag;       /* tag/ref the chunk is stored in */
+    uint16       ref;
+} chunk_decode_t;
+
+/* A chunk HMCPchunkwritev compresses on the worker pool */
+typedef struct
+{
+    comp_coder_t coder;     /* coder to compress the chunk with */
+    comp_info   *cinfo;     /* settings of the coder */
+    int32        chunk_num; /* chunk number */
+    const VOID  *datap;     /* the chunk */
+    int32        length;    /* length of the chunk */
+    uint8       *coded;     /* buffer for the compressed chunk */
+    int32        coded_size;/* size of that buffer */
+    int32        coded_len; /* OUT: length of compressed chunk or FAIL */
+} chunk_encode_t;
+
 /* private functions */
 PRIVATE int32 
 HMCIstaccess(accrec_t * access_rec,  /* IN: access record to fill in */
              int16 acc_mode          /* IN: access mode */ );
 
+PRIVATE void
+HMCIdecode_chunk(VOID *arg           /* IN/OUT: chunk to decompress */ );
+
+PRIVATE void
+HMCIencode_chunk(VOID *arg           /* IN/OUT: chunk to compress */ );
+
+PRIVATE int
+HMCIencode_cmp(const void *a,        /* IN: chunks to order */
+               const void *b);
+
+PRIVATE hdf_off_t
+HMCIplace_chunk(accrec_t *access_rec, /* IN: access record to mess with */
+                int32 chunk_num,      /* IN: chunk number */
+                int32 length          /* IN: length of the chunk */);
+
+PRIVATE intn
+HMCIunplace(accrec_t *access_rec     /* IN: access record to mess with */);
+
+PRIVATE int32
+HMCIchunkwrite(accrec_t *access_rec, /* IN: access record to mess with */
+               int32 chunk_num,      /* IN: chunk number */
+               const VOID *datap,    /* IN: buffer for data */
+               const uint8 *coded,   /* IN: the chunk compressed, or NULL */
+               int32 coded_len       /* IN: length of compressed chunk */);
+
+PRIVATE VOID
+HMCIindex_free(chunkinfo_t *info     /* IN: chunked element information */);
+
+PRIVATE intn
+HMCIfind_chunk(chunkinfo_t *info,    /* IN: chunked element information */
+               int32 chunk_num,      /* IN: chunk number */
+               CHUNK_REC **chk_rec   /* OUT: chunk record or NULL */);
+
+PRIVATE CHUNK_REC *
+HMCInew_chunk(chunkinfo_t *info,     /* IN: chunked element information */
+              int32 chunk_num,       /* IN: chunk number */
+              const int32 *origin    /* IN: chunk coordinates */);
+
+PRIVATE intn
+HMCIslab_whole(chunkinfo_t *info,      /* IN: chunked element information */
+               const int32 *chunk_idx, /* IN: chunk coordinates */
+               const int32 *start,     /* IN: start of the slab */
+               const int32 *count,     /* IN: size of the slab */
+               int32 *buf_off          /* OUT: offset of the chunk in buffer */);
+
+PRIVATE void
+HMCIcopy_slab(chunkinfo_t *info,      /* IN: chunked element information */
+              const int32 *chunk_idx, /* IN: chunk coordinates */
+              const int32 *start,     /* IN: start of the slab */
+              const int32 *count,     /* IN: size of the slab */
+              uint8 *chk_data,        /* IN/OUT: the chunk */
+              uint8 *buf,             /* IN/OUT: the user's buffer */
+              intn to_chunk           /* IN: TRUE to copy into the chunk */);
+
+PRIVATE int32
+HMCIslab(accrec_t *access_rec, /* IN: access record to mess with */
+         const int32 *start,   /* IN: start of the slab */
+         const int32 *count,   /* IN: size of the slab */
+         uint8 *datap,         /* IN/OUT: buffer for data */
+         intn write_slab,      /* IN: TRUE to write the slab */
+         uint8 *chunk_map,     /* OUT: which chunks were written, or NULL */
+         intn skip_empty       /* IN: TRUE to leave those not written out */);
+
 /* -------------------------------------------------------------------------
 NAME
     create_dim_recs -- create the appropriate arrays in memory
@@ -790,6 +913,31 @@ calculate_chunk_num(int32 *chunk_num, /* OUT: new chunk number within element */
 
 } /* calculate_chunk_num() */
 
+/* -------------------------------------------------------------------------
+NAME
+    calculate_chunk_idx -- translate a chunk number to chunk coordinates
+DESCRIPTION
+    The reverse of calculate_chunk_num().
+RETURNS
+    Nothing
+---------------------------------------------------------------------------*/
+PRIVATE void
+calculate_chunk_idx(int32 *sbi,       /* OUT: chunk coordinates */
+                    int32 ndims,      /* IN: number of dims */
+                    int32 chunk_num,  /* IN: chunk number within element */
+                    DIM_REC *ddims    /* IN: dim record ptrs */ )
+{
+    int32 j;
+
+    for(j = ndims - 1; j > 0 ; j--) 
+      {
+          sbi[j] = chunk_num % ddims[j].num_chunks;
+          chunk_num /= ddims[j].num_chunks;
+      }
+    sbi[0] = chunk_num;
+
+} /* calculate_chunk_idx() */
+
 /* -------------------------------------------------------------------------
 NAME
     calculate_chunk_for_chunk - calculate number of bytes to operate on chunk
@@ -838,79 +986,429 @@ calculate_chunk_for_chunk(int32 *chunk_size,   /* OUT: chunk size for this chunk
 
 /* -------------------------------------------------------------------------
 NAME
-    chkcompare
+    calculate_whole_chunk - extend the bytes to operate on to the whole chunk
 DESCRIPTION
-   Compares two chunk B-tree keys for equality.  Similar to memcmp.
+  calculate_chunk_for_chunk stops at the end of a row of the chunk.
+  When the chunks span every dimension but the first whole, a chunk
+  lies in one piece in the element; if the operation is at the start
+  of such a chunk and covers all of it, the size becomes that of the
+  whole chunk, so that the chunk is operated on in one go.
+RETURNS
+    Nothing
+---------------------------------------------------------------------------*/
+PRIVATE void
+calculate_whole_chunk(int32 *chunk_size,   /* IN/OUT: chunk size for this chunk */
+                      int32 chunk_len,     /* IN: size of a whole chunk */
+                      int32 ndims,         /* IN: number of dims */
+                      int32 len,           /* IN: total length to operate on */
+                      int32 bytes_finished,/* IN: bytes already operted on*/
+                      int32 *sbi,          /* IN: seek chunk array */
+                      int32 *spb,          /* IN: seek pos w/ chunk array */
+                      DIM_REC *ddims       /* IN: dim record ptrs */)
+{
+    int32 j;
+
+    if (*chunk_size == chunk_len || len - bytes_finished < chunk_len)
+        return;
+    for (j = 0; j < ndims; j++)
+        if (spb[j] != 0)
+            return;
+    for (j = 1; j < ndims; j++)
+        if (ddims[j].num_chunks != 1 || ddims[j].chunk_length != ddims[j].dim_length)
+            return;
+    /* a last chunk along the first dimension may stick out of the element */
+    if (sbi[0] == ddims[0].num_chunks - 1 
+        && ddims[0].last_chunk_length != ddims[0].chunk_length)
+        return;
+
+    *chunk_size = chunk_len;
+} /* calculate_whole_chunk() */
 
-   *** Only called by B-tree routines, should _not_ be called externally ***
+/********* Helper fcns for dealing with the chunk index ********************/
+
+/* -------------------------------------------------------------------------
+NAME
+    HMCIslot -- slot of a chunk in the chunk index
+DESCRIPTION
+    The chunk index holds the records of the chunks in the chunk table.
+    While the chunk numbers in use are not too far apart it is a flat 
+    array indexed by chunk number, otherwise a hash table on the chunk 
+    number, with open addressing, at most half full.  Either way finding 
+    a chunk takes about the same time however many chunks there are.
+
+    Returns the slot holding the chunk, or for a hash table the empty 
+    slot where it would go.
 RETURNS
+    The slot, or FAIL if the chunk is past the end of a flat index
+---------------------------------------------------------------------------*/
+PRIVATE int32
+HMCIslot(chunkinfo_t *info,  /* IN: chunked element information */
+         int32 chunk_num     /* IN: chunk number */)
+{
+    uint32  hash;
+    int32   slot;
 
-AUTHOR
-   -GeorgeV - 9/3/96   
+    if (!info->chk_hashed)
+        return ((chunk_num >= 0 && chunk_num < info->chk_nindex) ? chunk_num : FAIL);
+
+    hash = (uint32) chunk_num * 2654435761U;
+    slot = (int32) ((hash ^ (hash >> 16)) & (uint32) (info->chk_nindex - 1));
+    while (info->chk_index[slot] != NULL 
+           && info->chk_index[slot]->chunk_number != chunk_num)
+        slot = (slot + 1) & (info->chk_nindex - 1);
+    return slot;
+} /* HMCIslot() */
+
+/* -------------------------------------------------------------------------
+NAME
+    HMCIindex_size -- resize the chunk index
+DESCRIPTION
+    Makes the chunk index a flat array of 'nslots' slots, or a hash 
+    table of 'nslots' slots, a power of 2, if 'hashed' is TRUE, and 
+    puts the records it holds back in.
+RETURNS
+    SUCCEED/FAIL
 ---------------------------------------------------------------------------*/
-intn
-chkcompare(void * k1,   /* IN: first key */
-           void * k2,   /* IN: second key */
-           intn cmparg /* IN: not sure? */)
+PRIVATE intn
+HMCIindex_size(chunkinfo_t *info,  /* IN: chunked element information */
+               int32 nslots,       /* IN: number of slots */
+               intn hashed         /* IN: make it a hash table? */)
 {
-    intn  ret_value;
-    /* shut compiler up */
-    cmparg = cmparg;
+    CONSTR(FUNC, "HMCIindex_size");   /* for HERROR */
+    CHUNK_REC  **old_index = info->chk_index;
+    int32       old_nindex = info->chk_nindex;
+    int32       i;
+    intn        ret_value = SUCCEED;
+
+    if ((info->chk_index = (CHUNK_REC **) HDcalloc((uint32)nslots, sizeof(CHUNK_REC *))) == NULL)
+      {
+          info->chk_index = old_index;
+          HGOTO_ERROR(DFE_NOSPACE, FAIL);
+      }
+    info->chk_nindex = nslots;
+    info->chk_hashed = hashed;
+
+    for (i = 0; i < old_nindex; i++)
+        if (old_index[i] != NULL)
+            info->chk_index[HMCIslot(info, old_index[i]->chunk_number)] = old_index[i];
 
-    /* valid for integer keys */
-    ret_value = ((intn) ((*(int32 *) k1) - (*(int32 *) k2)));    
+    if (old_index != NULL)
+        HDfree(old_index);
 
+  done:
     return ret_value;
-}   /* chkcompare */
+} /* HMCIindex_size() */
+
+/* -------------------------------------------------------------------------
+NAME
+    HMCIindex_put -- add a chunk record to the chunk index
+DESCRIPTION
+    Puts the record in the chunk index.  A chunk has one record, one
+    for a chunk already in the index is turned down.  A flat index grows to take the chunk number, unless
+    it would then have more than HMC_INDEX_SPREAD slots per record, in 
+    which case it becomes a hash table.  A hash table grows once half of
+    it is used.
+RETURNS
+    SUCCEED/FAIL
+---------------------------------------------------------------------------*/
+PRIVATE intn
+HMCIindex_put(chunkinfo_t *info,  /* IN: chunked element information */
+              CHUNK_REC *chk_rec  /* IN: chunk record */)
+{
+    CONSTR(FUNC, "HMCIindex_put");   /* for HERROR */
+    int32       chunk_num = chk_rec->chunk_number;
+    int32       limit;      /* most slots of a flat index */
+    int32       nslots;
+    int32       slot;
+    intn        ret_value = SUCCEED;
+
+    if (chunk_num < 0)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    if (!info->chk_hashed && chunk_num >= info->chk_nindex)
+      {
+          limit = HMC_INDEX_SPREAD * (info->chk_nused + 1) + HMC_INDEX_MIN;
+          nslots = info->chk_nindex > HMC_INDEX_MIN ? info->chk_nindex : HMC_INDEX_MIN;
+          while (nslots <= chunk_num && nslots <= limit)
+              nslots *= 2;
+          if (nslots <= chunk_num)
+            { /* too sparse, hash it */
+                for (nslots = HMC_INDEX_MIN; nslots < 2 * (info->chk_nused + 1); nslots *= 2)
+                    ;
+                if (HMCIindex_size(info, nslots, TRUE) == FAIL)
+                    HGOTO_ERROR(DFE_INTERNAL, FAIL);
+            }
+          else if (HMCIindex_size(info, nslots, FALSE) == FAIL)
+              HGOTO_ERROR(DFE_INTERNAL, FAIL);
+      }
+    else if (info->chk_hashed && 2 * (info->chk_nused + 1) > info->chk_nindex)
+      {
+          if (HMCIindex_size(info, 2 * info->chk_nindex, TRUE) == FAIL)
+              HGOTO_ERROR(DFE_INTERNAL, FAIL);
+      }
+
+    slot = HMCIslot(info, chunk_num);
+    if (info->chk_index[slot] != NULL)
+        HGOTO_ERROR(DFE_DUPDD, FAIL);
+    info->chk_nused++;
+    info->chk_index[slot] = chk_rec;
 
-/********* Helper fcns for dealing with chunk table TBBT tree ***************/
+  done:
+    return ret_value;
+} /* HMCIindex_put() */
 
 /* -------------------------------------------------------------------------
 NAME
-    chkfreekey
+    HMCIindex_load -- read the chunk table into the chunk index
 DESCRIPTION
-    Free key - used by tbbt routines 
-    *** Only called by B-tree routines, should _not_ be called externally ***
+    Reads all the records of the chunk table (Vdata) with one VSread(),
+    into one block of chunk records, and builds the chunk index of them.
+    The index starts out flat if the chunk numbers allow it and hashed 
+    otherwise.
 
+    Note that chunk tag DTAG_CHUNK is not verified here.  It is checked 
+    in HMCPchunkread() before the chunk is read.
 RETURNS
-   Nothing
-AUTHOR
-   -GeorgeV - 9/3/96
+    SUCCEED/FAIL
+---------------------------------------------------------------------------*/
+PRIVATE intn
+HMCIindex_load(chunkinfo_t *info  /* IN: chunked element information */)
+{
+    CONSTR(FUNC, "HMCIindex_load");   /* for HERROR */
+    int32       num_recs = info->num_recs;  /* records in the table */
+    int32       vdata_size;          /* size of a record */
+    uint8       *v_data = NULL;      /* Vdata records */
+    uint8       *pntr   = NULL;      /* Vdata record being read */
+    CHUNK_REC   *chkptr = NULL;      /* Chunk record */
+    int32       *origins;            /* origins of the chunk records */
+    int32       max_num = 0;         /* largest chunk number */
+    int32       nslots;
+    int32       j;
+    intn        k;
+    intn        ret_value = SUCCEED;
+
+    info->chk_nblock = 0;
+    if (num_recs <= 0)
+        HGOTO_DONE(SUCCEED);
+
+    /* Set the fields to read */
+    if(VSsetfields(info->aid,_HDF_CHK_FIELD_NAMES)==FAIL)
+        HGOTO_ERROR(DFE_BADFIELDS,FAIL);
+    if ((vdata_size = VSsizeof(info->aid, _HDF_CHK_FIELD_NAMES)) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    /* Allocate space for all the Vdata records and read them in */
+    if ((v_data = HDmalloc((size_t)vdata_size * (size_t)num_recs)) == NULL)
+        HGOTO_ERROR(DFE_NOSPACE, FAIL);
+    if(VSread(info->aid,v_data,num_recs,FULL_INTERLACE)==FAIL)
+        HGOTO_ERROR(DFE_VSREAD,FAIL);
+
+    /* the chunk records, followed by their origins */
+    if ((info->chk_block = (CHUNK_REC *) HDmalloc((size_t)num_recs * 
+                 (sizeof(CHUNK_REC) + (size_t)info->ndims * sizeof(int32)))) == NULL)
+        HGOTO_ERROR(DFE_NOSPACE, FAIL);
+    origins = (int32 *) (info->chk_block + num_recs);
+
+    for (j = 0, pntr = v_data; j < num_recs; j++)
+      {
+          chkptr = &info->chk_block[j];
+          chkptr->origin = origins + (size_t)j * (size_t)info->ndims;
+
+          /* Copy origin first */
+          for (k = 0; k < info->ndims; k++)
+            {
+                HDmemcpy(&chkptr->origin[k],pntr,sizeof(int32));
+                pntr += sizeof(int32);
+            }
+
+          /* Copy tag next. 
+             Note: Verification of tag as DTAG_CHUNK is done in
+             HMCPchunkread() before the chunk object is read.
+             In the future the tag/ref pair could point to
+             another chunk table...etc.
+             */
+          HDmemcpy(&chkptr->chk_tag,pntr,sizeof(uint16));
+          pntr += sizeof(uint16);
+
+          /* Copy ref last */
+          HDmemcpy(&chkptr->chk_ref,pntr,sizeof(uint16));
+          pntr += sizeof(uint16);
+#ifdef CHK_DEBUG_2
+          printf(" chkptr->origin = (");
+          for (k = 0; k < info->ndims; k++)
+              printf("%d%s", chkptr->origin[k], k!= info->ndims-1 ? ",":NULL);
+          printf("), chk_tag=%d, chk_ref=%d\n",chkptr->chk_tag,chkptr->chk_ref);
+#endif
+
+          /* now compute chunk number from origin */
+          calculate_chunk_num(&chkptr->chunk_number, info->ndims, chkptr->origin, 
+                              info->ddims);
+          if (chkptr->chunk_number > max_num)
+              max_num = chkptr->chunk_number;
+
+          /* set chunk number to record number */
+          chkptr->chk_vnum = j;
+      } /* end for num_recs */
+    info->chk_nblock = num_recs;
+
+    /* size the index for them at once */
+    if (max_num < HMC_INDEX_SPREAD * num_recs + HMC_INDEX_MIN)
+        ret_value = HMCIindex_size(info, max_num + 1, FALSE);
+    else
+      {
+          for (nslots = HMC_INDEX_MIN; nslots < 2 * (num_recs + 1); nslots *= 2)
+              ;
+          ret_value = HMCIindex_size(info, nslots, TRUE);
+      }
+    if (ret_value == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    /* a chunk in the table twice keeps its first record */
+    for (j = 0; j < num_recs; j++)
+      {
+          if (HMCIfind_chunk(info, info->chk_block[j].chunk_number, &chkptr) == FAIL)
+              HGOTO_ERROR(DFE_INTERNAL, FAIL);
+          if (chkptr == NULL && HMCIindex_put(info, &info->chk_block[j]) == FAIL)
+              HGOTO_ERROR(DFE_INTERNAL, FAIL);
+      } /* end for num_recs */
+
+  done:
+    if (ret_value == FAIL)
+      { /* Error condition cleanup */
+          HMCIindex_free(info);
+      } /* end if */
+
+    /* Normal function cleanup */
+    if (v_data != NULL)
+        HDfree(v_data);
+    return ret_value;
+} /* HMCIindex_load() */
+
+/* -------------------------------------------------------------------------
+NAME
+    HMCIindex_free -- free the chunk index
+DESCRIPTION
+    Frees the chunk index, the block of records read from the chunk 
+    table and the records added since.  The table has to be read again
+    before the index is used.
+RETURNS
+    Nothing
 ---------------------------------------------------------------------------*/
-void
-chkfreekey(void * key /*IN: chunk key */ )
+PRIVATE VOID
+HMCIindex_free(chunkinfo_t *info  /* IN: chunked element information */)
 {
-    if (key != NULL)
-        HDfree(key);
-} /* chkfreekey() */
+    int32       i;
+
+    /* the records added since the table was read are on their own */
+    for (i = 0; i < info->chk_nindex; i++)
+        if (info->chk_index[i] != NULL 
+            && info->chk_index[i]->chk_vnum >= info->chk_nblock)
+            HDfree(info->chk_index[i]);
+
+    if (info->chk_index != NULL)
+        HDfree(info->chk_index);
+    if (info->chk_block != NULL)
+        HDfree(info->chk_block);
+    info->chk_index  = NULL;
+    info->chk_nindex = 0;
+    info->chk_nused  = 0;
+    info->chk_hashed = FALSE;
+    info->chk_block  = NULL;
+    info->chk_nblock = -1;
+} /* HMCIindex_free() */
 
 /* -------------------------------------------------------------------------
 NAME
-    chkdestroynode
+    HMCIfind_chunk -- look a chunk record up
 DESCRIPTION
-   Frees chunk B-Tree nodes
-   *** Only called by B-tree routines, should _not_ be called externally ***
+    Finds the record of a chunk in the chunk index, reading the chunk 
+    table in the first time.
+RETURNS
+    SUCCEED/FAIL, the record or NULL if the chunk is not in the table
+    is left in 'chk_rec'.
+---------------------------------------------------------------------------*/
+PRIVATE intn
+HMCIfind_chunk(chunkinfo_t *info,   /* IN: chunked element information */
+               int32 chunk_num,     /* IN: chunk number */
+               CHUNK_REC **chk_rec  /* OUT: chunk record or NULL */)
+{
+    CONSTR(FUNC, "HMCIfind_chunk");   /* for HERROR */
+    int32       slot;
+    intn        ret_value = SUCCEED;
+
+    *chk_rec = NULL;
+    if (info->chk_nblock < 0 && HMCIindex_load(info) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    if (info->chk_nindex > 0 && (slot = HMCIslot(info, chunk_num)) != FAIL)
+        *chk_rec = info->chk_index[slot];
+
+  done:
+    return ret_value;
+} /* HMCIfind_chunk() */
 
+/* -------------------------------------------------------------------------
+NAME
+    HMCInew_chunk -- add a record for a chunk not in the table yet
+DESCRIPTION
+    Creates the record of a chunk about to be written for the first time
+    and adds it to the chunk index.  It gets the next record number of
+    the chunk table but is only put in the table when the chunk is 
+    written out, see HMCIchunkwrite().
 RETURNS
-   Nothing
-AUTHOR
-   -GeorgeV - 9/3/96
+    The chunk record or NULL
 ---------------------------------------------------------------------------*/
-void
-chkdestroynode(void * n /* IN: chunk record */ )
+PRIVATE CHUNK_REC *
+HMCInew_chunk(chunkinfo_t *info,   /* IN: chunked element information */
+              int32 chunk_num,     /* IN: chunk number */
+              const int32 *origin  /* IN: chunk coordinates */)
 {
-    CHUNK_REC *t=(CHUNK_REC *)n;
+    CONSTR(FUNC, "HMCInew_chunk");   /* for HERROR */
+    CHUNK_REC   *chkptr = NULL;      /* Chunk record */
+    intn        k;
+    CHUNK_REC   *ret_value = NULL;
+
+    /* the table must be read in first */
+    if (info->chk_nblock < 0 && HMCIindex_load(info) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, NULL);
+
+    /* Allocate space for a chunk record and its origin */
+    if ((chkptr = (CHUNK_REC *) HDmalloc(sizeof(CHUNK_REC) 
+                          + (size_t)info->ndims * sizeof(int32))) == NULL)
+        HGOTO_ERROR(DFE_NOSPACE, NULL);
+    chkptr->origin = (int32 *) (chkptr + 1);
+
+    /* Initialize chunk record */
+    chkptr->chk_tag = DFTAG_NULL;
+    chkptr->chk_ref = 0;
+    for (k = 0; k < info->ndims; k++)
+        chkptr->origin[k] = origin[k];
+#ifdef CHK_DEBUG_4
+    printf(" chkptr->origin = (");
+    for (k = 0; k < info->ndims; k++)
+        printf("%d%s", chkptr->origin[k], k!= info->ndims-1 ? ",":NULL);
+    printf(")\n");
+#endif
+    chkptr->chunk_number = chunk_num;
 
-    if (t != NULL)
-      {   
-          /* free orgin first */
-          if (t->origin != NULL)
-              HDfree(t->origin);
+    /* set chunk record number to next Vdata record number */
+    chkptr->chk_vnum = info->num_recs;
 
-          /* free chunk record structure */
-          HDfree((void *) t);
-      }
-}   /* chkdestroynode */
+    if (HMCIindex_put(info, chkptr) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, NULL);
+    info->num_recs++;
+
+    ret_value = chkptr;
+
+  done:
+    if (ret_value == NULL)
+      { /* Error condition cleanup */
+          if (chkptr != NULL)
+              HDfree(chkptr);
+      } /* end if */
+
+    return ret_value;
+} /* HMCInew_chunk() */
 
 /* ----------------------------- HMCIstaccess ------------------------------
 NAME
@@ -961,9 +1459,6 @@ HMCIstaccess(accrec_t *access_rec, /* IN: access record to fill in */
     int32       interlace;           /* type of interlace */
     int32       vdata_size;          /* size of Vdata */
     int32       num_recs;            /* number of Vdatas */
-    uint8       *v_data = NULL;      /* Vdata record */
-    CHUNK_REC   *chkptr = NULL;      /* Chunk record */
-    int32       *chk_key   = NULL;   /* chunk key */
     int32       npages     = 1;      /* number of chunks */
     int32       chunks_needed;       /* default chunk cache size  */
     int32       access_aid = FAIL;   /* access id */
@@ -971,7 +1466,7 @@ HMCIstaccess(accrec_t *access_rec, /* IN: access record to fill in */
     char        name[VSNAMELENMAX + 1];  /* Vdata name */
     char        class[VSNAMELENMAX + 1]; /* Vdata class */
     char        v_class[VSNAMELENMAX + 1] = ""; /* Vdata class for comparison */
-    intn        i,j,k;                     /* loop indicies */
+    intn        i,j;                       /* loop indicies */
 
     /* Check args */
     if (access_rec == NULL)
@@ -1011,8 +1506,8 @@ HMCIstaccess(accrec_t *access_rec, /* IN: access record to fill in */
                 /* Use Vxxx interface to free Vdata info */
                 VSdetach(info->aid);
 
-                /* free chunk tree */
-                tbbtdfree(info->chk_tree, chkdestroynode, chkfreekey);
+                /* free chunk index */
+                HMCIindex_free(tmpinfo);
 
                 /* free up stuff in special info */
                 if (tmpinfo->ddims != NULL)
@@ -1033,6 +1528,8 @@ HMCIstaccess(accrec_t *access_rec, /* IN: access record to fill in */
                     HDfree(tmpinfo->cinfo);
                 if (tmpinfo->minfo != NULL)
                     HDfree(tmpinfo->minfo);
+                if (tmpinfo->pre_used != NULL)
+                    HDfree(tmpinfo->pre_used);
                 /* free info struct last */
                 HDfree(tmpinfo);
 
@@ -1066,7 +1563,12 @@ HMCIstaccess(accrec_t *access_rec, /* IN: access record to fill in */
           info->seek_pos_chunk     = NULL;
           info->seek_user_indices = NULL;
           info->ddims     = NULL;
-          info->chk_tree  = NULL;
+          info->chk_index  = NULL;
+          info->chk_nindex = 0;
+          info->chk_nused  = 0;
+          info->chk_hashed = FALSE;
+          info->chk_block  = NULL;
+          info->chk_nblock = 0;
           info->chk_cache = NULL;
           info->fill_val  = NULL;
           info->minfo     = NULL;
@@ -1074,6 +1576,14 @@ HMCIstaccess(accrec_t *access_rec, /* IN: access record to fill in */
           info->comp_sp_tag_header   = NULL;
           info->comp_sp_tag_head_len = 0;
           info->num_recs  = 0; /* zero records to start with */
+          info->ra_last   = -1; /* nothing read yet */
+          info->ra_stride = 0;
+          info->ra_count  = 0;
+          info->align      = 0;  /* chunks go anywhere */
+          info->pre_off    = 0;
+          info->pre_len    = 0;
+          info->pre_nslots = 0;
+          info->pre_used   = NULL;
 
           /* read the special info structure from the file */
           if((dd_aid=Hstartaccess(access_rec->file_id,data_tag,data_ref,DFACC_READ))==FAIL)
@@ -1234,11 +1744,8 @@ HMCIstaccess(accrec_t *access_rec, /* IN: access record to fill in */
               HGOTO_ERROR(DFE_CANTENDACCESS, FAIL);
 
           /* set up the chunk tables of the information */
-          /* intialize TBBT tree of CHUNK records*/
-          info->chk_tree = tbbtdmake(chkcompare, sizeof(int32), TBBT_FAST_INT32_COMPARE);
-
           /* Use Vdata interface to read in chunk table and
-             store per chunk-info in memory using TBBT trees  */ 
+             store per chunk-info in memory in the chunk index */ 
 
           /* Start access on Vdata */
           if(Vstart(access_rec->file_id) == FAIL)
@@ -1276,93 +1783,10 @@ HMCIstaccess(accrec_t *access_rec, /* IN: access record to fill in */
               HGOTO_ERROR(DFE_INTERNAL, FAIL);
             }
 
-          /* Check to see if any chunks have been written out yet */
-          if (num_recs > 0)
-            { /* Yes */
-                /* Set the fields to read */
-                if(VSsetfields(info->aid,_HDF_CHK_FIELD_NAMES)==FAIL)
-                    HGOTO_ERROR(DFE_BADFIELDS,FAIL);
-
-                /* Allocate space for a single Vdata record */
-                if ((v_data = HDmalloc((size_t)vdata_size)) == NULL)
-                    HGOTO_ERROR(DFE_NOSPACE, FAIL);
-
-                /* for each record read it in and put into TBBT tree 
-                   NOTE: Should change this to a single VSread() but then
-                   would have to store all the v_data rec's somewhere
-                   before inserting them into the TBBT tree...
-                   ....for somone to do later if performance of VSread() is bad.
-                   Technically a B+-Tree should have been used instead or
-                   better yet the Vdata implementation should be re-written to use one.
-                   Note that chunk tag DTAG_CHUNK is not verified here.
-                   It is checked in HMCPchunkread() before the chunk is read. */
-                for (j = 0; j < num_recs; j++)
-                  {
-                      uint8 *pntr = NULL;
-
-                      /* read single record */
-                      if(VSread(info->aid,v_data,1,FULL_INTERLACE)==FAIL)
-                          HGOTO_ERROR(DFE_VSREAD,FAIL);
-        
-                      pntr = v_data; /* set pointer to vdata record */
-
-                      /* Allocate space for a chunk record */
-                      if ((chkptr = (CHUNK_REC *) HDmalloc(sizeof(CHUNK_REC))) == NULL)
-                          HGOTO_ERROR(DFE_NOSPACE, FAIL);
-
-                      /* Allocate space for a origin in chunk record */
-                      if ((chkptr->origin = (int32 *) HDmalloc((size_t)info->ndims*sizeof(int32))) == NULL)
-                          HGOTO_ERROR(DFE_NOSPACE, FAIL);
-
-                      /* allocate space for key */
-                      if ((chk_key = (int32 *)HDmalloc(sizeof(int32))) == NULL)
-                          HGOTO_ERROR(DFE_NOSPACE, FAIL);
-
-                      /* Copy origin first */
-                      for (k = 0; k < info->ndims; k++)
-                        {
-                            HDmemcpy(&chkptr->origin[k],pntr,sizeof(int32));
-                            pntr += sizeof(int32);
-
-                        }
-
-#ifdef CHK_DEBUG_2
-                      printf(" chkptr->origin = (");
-                      for (k = 0; k < info->ndims; k++)
-                          printf("%d%s", chkptr->origin[k], k!= info->ndims-1 ? ",":NULL);
-                      printf("), ");
-#endif
-
-                      /* Copy tag next. 
-                         Note: Verification of tag as DTAG_CHUNK is done in
-                         HMCPchunkread() before the chunk object is read.
-                         In the future the tag/ref pair could point to
-                         another chunk table...etc.
-                         */
-                      HDmemcpy(&chkptr->chk_tag,pntr,sizeof(uint16));
-                      pntr += sizeof(uint16);
-#ifdef CHK_DEBUG_2
-                      printf(" chktpr->chk_tag=%d, ",chkptr->chk_tag);
-#endif
-                      /* Copy ref last */
-                      HDmemcpy(&chkptr->chk_ref,pntr,sizeof(uint16));
-#ifdef CHK_DEBUG_2
-                      printf(" chktpr->chk_ref=%d, ",chkptr->chk_ref);
-                      printf("\n");
-#endif
-                      /* now compute chunk number from origin */
-                      calculate_chunk_num(chk_key, info->ndims, chkptr->origin, 
-                                          info->ddims);
-
-                      chkptr->chunk_number = *chk_key; 
-
-                      /* set chunk number to record number */
-                      chkptr->chk_vnum = info->num_recs++;
-
-                      /* add to TBBT tree based on chunk number as the key */
-                      tbbtdins(info->chk_tree, chkptr , chk_key);   
-                  } /* end for num_recs */
-            } /* end if num_recs */
+          /* The chunk table is read in when a chunk is first looked up,
+             see HMCIfind_chunk(), if any chunks have been written out yet */
+          info->num_recs   = num_recs;
+          info->chk_nblock = (num_recs > 0) ? -1 : 0;
 
           /* set return value */
           access_aid = HAregister_atom(AIDGROUP,access_rec);
@@ -1390,6 +1814,9 @@ HMCIstaccess(accrec_t *access_rec, /* IN: access record to fill in */
                         HMCPchunkread,   /* page-in routine */
                         HMCPchunkwrite,  /* page-out routine */
                         access_rec       /* object handle */);
+          mcache_filterv(info->chk_cache, /* cache handle */
+                         HMCPchunkreadv,  /* page-in-chunks routine */
+                         HMCPchunkwritev  /* page-out-chunks routine */);
 
           /* update chunk info data and file record info */
           info->attached = 1;
@@ -1422,9 +1849,8 @@ HMCIstaccess(accrec_t *access_rec, /* IN: access record to fill in */
                 if (info->aid != FAIL)
                     VSdetach(info->aid);
 
-                /* free chunk tree */
-                if (info->chk_tree != NULL)
-                    tbbtdfree(info->chk_tree, chkdestroynode, chkfreekey);
+                /* free chunk index */
+                HMCIindex_free(info);
 
                 /* free up stuff in special info */
                 if (info->ddims != NULL)
@@ -1457,9 +1883,6 @@ HMCIstaccess(accrec_t *access_rec, /* IN: access record to fill in */
     if (c_sp_header != NULL)
         HDfree(c_sp_header);
 #endif
-    /* free allocated space for vdata record */
-    if (v_data != NULL)
-        HDfree(v_data);
 
     return ret_value;
 }   /* HMCIstaccess */
@@ -1514,6 +1937,8 @@ HMCcreate(int32 file_id,       /* IN: file to put chunked element in */
           HCHUNK_DEF *chk_array /* IN: structure describing chunk distribution
                                   can be an array? but we only handle 1 level */ )
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HMCcreate");     /* for HERROR */
     filerec_t  *file_rec   = NULL; /* file record */
     accrec_t   *access_rec = NULL; /* access record */
@@ -1608,9 +2033,22 @@ HMCcreate(int32 file_id,       /* IN: file to put chunked element in */
     info->seek_pos_chunk = NULL;
     info->seek_user_indices = NULL;
     info->ddims          = NULL;
-    info->chk_tree       = NULL;
+    info->chk_index      = NULL;
+    info->chk_nindex     = 0;
+    info->chk_nused      = 0;
+    info->chk_hashed     = FALSE;
+    info->chk_block      = NULL;
+    info->chk_nblock     = 0;                   /* no chunk table to read */
     info->chk_cache      = NULL;
     info->num_recs       = 0;                   /* zero Vdata records to start */
+    info->ra_last        = -1;                  /* nothing read yet */
+    info->ra_stride      = 0;
+    info->ra_count       = 0;
+    info->align          = 0;                   /* chunks go anywhere */
+    info->pre_off        = 0;
+    info->pre_len        = 0;
+    info->pre_nslots     = 0;
+    info->pre_used       = NULL;
     info->fill_val_len   = fill_val_len;        /* length of fill value */
     /* allocate space for fill value */
     if (( info->fill_val = HDmalloc((uint32)fill_val_len))==NULL)
@@ -1892,9 +2330,6 @@ HMCcreate(int32 file_id,       /* IN: file to put chunked element in */
     if(Hendaccess(dd_aid)==FAIL)
         HGOTO_ERROR(DFE_CANTENDACCESS, FAIL);
 
-    /* intialize TBBT tree of CHUNK records*/
-    info->chk_tree = tbbtdmake(chkcompare, sizeof(int32), TBBT_FAST_INT32_COMPARE);
-
     /* Detach from the data DD ID */
     if(data_id != FAIL)
       {
@@ -1952,6 +2387,9 @@ HMCcreate(int32 file_id,       /* IN: file to put chunked element in */
                   HMCPchunkread,   /* page-in routine */
                   HMCPchunkwrite,  /* page-out routine */
                   access_rec       /* object handle */);
+    mcache_filterv(info->chk_cache, /* cache handle */
+                   HMCPchunkreadv,  /* page-in-chunks routine */
+                   HMCPchunkwritev  /* page-out-chunks routine */);
 
     ret_value = access_aid;
 
@@ -1972,9 +2410,8 @@ HMCcreate(int32 file_id,       /* IN: file to put chunked element in */
                 if (info->aid != FAIL)
                     VSdetach(info->aid); /* detach from chunk table */
 
-                /* free chunk tree */
-                if (info->chk_tree != NULL)
-                    tbbtdfree(info->chk_tree, chkdestroynode, chkfreekey);
+                /* free chunk index */
+                HMCIindex_free(info);
 
                 /* free up stuff in special info */
                 if (info->ddims != NULL)
@@ -2028,6 +2465,7 @@ HMCgetcompress( accrec_t*    access_rec, /* IN: access record */
 		comp_coder_t* comp_type, /* OUT: compression type */
 		comp_info* c_info)       /* OUT: retrieved compression info */
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "HMCgetcompress");   /* for HERROR */
     chunkinfo_t *info = NULL;   /* chunked element information record */
     model_info  m_info;         /* modeling information - dummy */
@@ -2081,6 +2519,7 @@ intn
 HMCgetcomptype(int32 dd_aid, /* IN: access id of header info */
 	       comp_coder_t* comp_type) /* OUT: compression type */
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "HMCgetcomptype");   /* for HERROR */
     uint8 *bufp;		/* pointer to buffer */
     uint8  version;      /* Version of this Chunked element */
@@ -2221,6 +2660,8 @@ HMCgetdatainfo(int32 file_id,
                 int32 *offsetarray,	/* OUT: array to hold offsets */
                 int32 *lengtharray)	/* OUT: array to hold lengths */
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HMCgetdatainfo");	/* for HERROR */
     uint16	 comp_ref = 0;		/* ref# of compressed data */
     chunkinfo_t *chkinfo=NULL;		/* chunked element information */
@@ -2228,10 +2669,10 @@ HMCgetdatainfo(int32 file_id,
     atom_t       cmpddid=FAIL;          /* description record access id */
     uint16	 new_tag=0, new_ref=0;
     int32	 new_off=0, new_len=0;
+    hdf_off_t	 dd_off=0;		/* offset of a description record */
     intn	 count=0;		/* number of blocks */
     int32	 chk_num=0;
     CHUNK_REC   *chk_rec = NULL;	/* chunk record */
-    TBBT_NODE   *entry   = NULL;	/* chunk node from TBBT */
     accrec_t *access_rec;
     filerec_t *file_rec;
     int32 new_aid=FAIL;
@@ -2270,8 +2711,10 @@ HMCgetdatainfo(int32 file_id,
     /* Calculate chunk number from origin */
     calculate_chunk_num(&chk_num, chkinfo->ndims, chk_coord, chkinfo->ddims);
 
-    /* Find chunk record in TBBT */
-    if ((entry = (tbbtdfind(chkinfo->chk_tree, &chk_num, NULL))) == NULL)
+    /* Find chunk record in the chunk index */
+    if (HMCIfind_chunk(chkinfo, chk_num, &chk_rec) == FAIL)
+	HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    if (chk_rec == NULL)
     { /* chunk had not been written, no chunk record */
 	if (offsetarray != NULL && lengtharray != NULL)
 	{
@@ -2282,9 +2725,6 @@ HMCgetdatainfo(int32 file_id,
     }
     else
     { /* chunk record exists */
-        /* Get chunk record from node */
-        chk_rec = (CHUNK_REC *) entry->data;
-
         /* Check to see if it has been written to */
         if (chk_rec->chk_tag != DFTAG_NULL && BASETAG(chk_rec->chk_tag) == DFTAG_CHUNK)
         { /* valid chunk in file */
@@ -2295,6 +2735,9 @@ HMCgetdatainfo(int32 file_id,
 
 	    if ((ddid = HTPselect(file_rec, new_tag, new_ref)) == FAIL)
 	        HE_REPORT_GOTO("HTPselect failed ", FAIL);
+	    /* Hfind can't return offsets past 2 GB, the DD has the full one */
+	    if (HTPinquire(ddid, NULL, NULL, &dd_off, NULL) == FAIL)
+	        HE_REPORT_GOTO("HTPinquire failed ", FAIL);
 
 	    if (HTPis_special(ddid)!=TRUE)
 	    { /* this chunk is not special */
@@ -2307,7 +2750,7 @@ HMCgetdatainfo(int32 file_id,
 	    }   /* end if */
 	    else
 	    { /* this chunk is special */
-	        if (HPseek(file_rec, new_off) == FAIL)
+	        if (HPseek(file_rec, dd_off) == FAIL)
 		    HGOTO_ERROR(DFE_SEEKERROR, FAIL);
 	        if (HP_read(file_rec, lbuf, (int)2) == FAIL)
 		    HGOTO_ERROR(DFE_READERROR, FAIL);
@@ -2332,20 +2775,24 @@ HMCgetdatainfo(int32 file_id,
 		        HE_REPORT_GOTO("Hfind failed ", FAIL);
 		    if ((cmpddid = HTPselect(file_rec, new_tag, new_ref)) == FAIL)
 		        HE_REPORT_GOTO("HTPselect failed ", FAIL);
+		    if (HTPinquire(cmpddid, NULL, NULL, &dd_off, NULL) == FAIL)
+		        HE_REPORT_GOTO("HTPinquire failed ", FAIL);
 
 		    /* Check for further specialness */
 		    if (HTPis_special(cmpddid)!=TRUE)
 		    { /* this chunk is not further special, only compressed */
 		        if (offsetarray != NULL && lengtharray != NULL)
 		        {
-			    offsetarray[0] = new_off;
+			    if (dd_off > MAX_OFFSET32)
+			        HGOTO_ERROR(DFE_EXCEEDMAX, FAIL);
+			    offsetarray[0] = (int32)dd_off;
 			    lengtharray[0] = new_len;
 		        }
 		        count = 1;
 		    }   /* end if */
 		    else
 		    { /* this chunk is further special */
-		        if (HPseek(file_rec, new_off) == FAIL)
+		        if (HPseek(file_rec, dd_off) == FAIL)
 			    HGOTO_ERROR(DFE_SEEKERROR, FAIL);
 		        if (HP_read(file_rec, lbuf, (int)2) == FAIL)
 			    HGOTO_ERROR(DFE_READERROR, FAIL);
@@ -2448,6 +2895,8 @@ HMCgetdatasize(int32 file_id,
 		int32 *comp_size, /* OUT: size of compressed data */
 		int32 *orig_size) /* OUT: size of uncompression type */
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HMCgetdatasize");	/* for HERROR */
     uint16	 comp_ref = 0;		/* ref# of compressed data */
     char         vsname[VSNAMELENMAX + 1];  /* Vdata name */
@@ -2702,6 +3151,8 @@ HMCsetMaxcache(int32 access_id, /* IN: access aid to mess with */
                int32 maxcache,  /* IN: max number of pages to cache */
                int32 flags      /* IN: flags = 0, HMC_PAGEALL */)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
     CONSTR(FUNC, "HMCsetMaxcache");   /* for HERROR */
     accrec_t    *access_rec = NULL;   /* access record */
     chunkinfo_t *info       = NULL;   /* chunked element information record */
@@ -2747,40 +3198,302 @@ HMCsetMaxcache(int32 access_id, /* IN: access aid to mess with */
     return ret_value;
 } /* HMCsetMaxcache() */
 
-/* ------------------------------ HMCPstread -------------------------------
+/*--------------------------------------------------------------------------
 NAME
-   HMCPstread -- open an access record of chunked element for reading
+     HMCsetCachePolicy - byte limit and eviction policy of the chunk cache
 
 DESCRIPTION
-   Calls to HMCIstaccess to fill in the access rec for
-   reading
+     Budgets the chunk cache of the current object in bytes and sets which
+     chunks it gives up first when it is full.
+
+     The cache is set to hold as many chunks as fit in 'maxbytes', at
+     least one, and HMCsetMaxcache() does not let it hold more. Unlike
+     the number of chunks, the budget can be lowered: the chunks which 
+     do not fit any longer are written out and dropped. A 'maxbytes' of
+     zero leaves the number of chunks alone and takes the limit away.
+
+     'policy' is one of
+        HDF_CACHE_LRU   - the least recently used chunk goes first, 
+                          the default
+        HDF_CACHE_2Q    - chunks used once go before chunks used again,
+                          so a long scan does not push out the chunks
+                          read over and over
+        HDF_CACHE_CLOCK - chunks not used since the last sweep of the 
+                          cache go first
+
+     The environment variables HDF4_CHUNK_CACHE_BYTES and
+     HDF4_CHUNK_CACHE_POLICY ("lru", "2q" or "clock") set both for
+     every chunk cache when it is created.
 
 RETURNS
-   The AID of the access record on success FAIL on error.
-AUTHOR
-   -GeorgeV - 9/3/96
----------------------------------------------------------------------------*/
+     Returns the number of chunks to cache if successful and FAIL otherwise
+
+NOTE
+     This calls the real routines mcache_set_policy() and
+     mcache_set_maxbytes().
+
+-------------------------------------------------------------------------- */
 int32
-HMCPstread(accrec_t * access_rec /* IN: access record to fill in */)
+HMCsetCachePolicy(int32 access_id, /* IN: access aid to mess with */
+                  int32 maxbytes,  /* IN: max bytes to cache, 0 for no limit */
+                  intn policy      /* IN: HDF_CACHE_LRU, HDF_CACHE_2Q, HDF_CACHE_CLOCK */)
 {
-    int32 ret_value;
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
+    CONSTR(FUNC, "HMCsetCachePolicy");   /* for HERROR */
+    accrec_t    *access_rec = NULL;   /* access record */
+    chunkinfo_t *info       = NULL;   /* chunked element information record */
+    int32       ret_value = SUCCEED;
 
-    ret_value = HMCIstaccess(access_rec, DFACC_READ);
+    /* Check args */
+    access_rec = HAatom_object(access_id);
+    if (access_rec == NULL || maxbytes < 0)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* since this routine can be called by the user,
+       need to check if this access id is special CHUNKED */
+    if (access_rec->special != SPECIAL_CHUNKED
+        || (info = (chunkinfo_t *) (access_rec->special_info)) == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    if (mcache_set_policy(info->chk_cache, policy) == RET_ERROR)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    if ((ret_value = mcache_set_maxbytes(info->chk_cache, maxbytes)) == FAIL)
+        HE_REPORT_GOTO("failed to shrink the chunk cache", FAIL);
+
+  done:
+    if(ret_value == FAIL)   
+      { /* Error condition cleanup */
+
+      } /* end if */
 
+    /* Normal function cleanup */
     return ret_value;
-}   /* HMCPstread */
+} /* HMCsetCachePolicy() */
 
-/* ------------------------------ HMCPstwrite ------------------------------
+/*--------------------------------------------------------------------------
 NAME
-   HMCPstwrite -- open an access record of a chunked elmenent for writing
+     HMCsetSharedCache - byte limit of the chunk cache shared by all elements
 
 DESCRIPTION
-   Calls to HMCIstaccess to fill in the access rec for
-   writing
+     Sets the memory of the chunk cache shared by all the chunked
+     elements of all the files of the process.
+
+     The cache of a chunked element goes away when the access to the
+     element ends. The shared cache keeps the chunks read, decompressed,
+     across the accesses and the elements, so that reading them again
+     goes neither to the file nor through the decompression. The least
+     recently used chunks are given up when the chunks take more than
+     'maxbytes', chunks larger than that are not kept. A chunk written
+     is dropped from the cache, the chunks of a file when it is closed.
+
+     The cache is off until it is given a size, a 'maxbytes' of zero
+     turns it off again. The environment variable 
+     HDF4_SHARED_CHUNK_CACHE_BYTES gives it a size at the first read.
 
 RETURNS
-   The AID of the access record on success FAIL on error.
-AUTHOR
+     SUCCEED/FAIL
+
+NOTE
+     This calls the real routine HCSsetmax().
+
+-------------------------------------------------------------------------- */
+intn
+HMCsetSharedCache(int32 maxbytes /* IN: max bytes to cache, 0 to turn off */)
+{
+    HTS_API_LOCK;
+    CONSTR(FUNC, "HMCsetSharedCache");   /* for HERROR */
+    intn        ret_value = SUCCEED;
+
+    /* Check args */
+    if (maxbytes < 0)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    if (HCSsetmax(maxbytes) == FAIL)
+        HE_REPORT_GOTO("failed to size the shared chunk cache", FAIL);
+
+  done:
+    if(ret_value == FAIL)   
+      { /* Error condition cleanup */
+
+      } /* end if */
+
+    /* Normal function cleanup */
+    return ret_value;
+} /* HMCsetSharedCache() */
+
+/*--------------------------------------------------------------------------
+NAME
+     HMCsetAlignment - where in the file to place the chunks written
+
+DESCRIPTION
+     Sets where the chunks of the current object written for the first
+     time go in the file. Left alone, they go wherever there is room,
+     mixed with the chunk table and the other objects of the file.
+
+     With an 'alignment' above one each chunk starts on a multiple of 
+     'alignment' bytes from the beginning of the file, e.g. the page size
+     or the stripe size of the file system, as direct I/O needs. The 
+     alignment need not be a power of two, zero places the chunks 
+     anywhere again.
+
+     With HDF_CHUNK_PREALLOC in 'flags' one extent of the file, starting
+     on a boundary, is kept right away for all the chunks of the object,
+     which are placed in it next to each other in the order of their 
+     chunk numbers, each on a boundary. The places of the chunks never
+     written are given back when the access to the object ends, or when
+     HMCsetAlignment() is called again. Chunks written before are left
+     where they are.
+
+     This only applies to chunks stored without compression, the 
+     compressed ones grow as they are written. It is not recorded in the
+     file and lasts until the access to the object ends.
+
+RETURNS
+     SUCCEED/FAIL
+
+-------------------------------------------------------------------------- */
+intn
+HMCsetAlignment(int32 access_id, /* IN: access aid to mess with */
+                int32 alignment, /* IN: chunks start on multiples of this, 0 for anywhere */
+                intn flags       /* IN: 0 or HDF_CHUNK_PREALLOC */)
+{
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
+    CONSTR(FUNC, "HMCsetAlignment");   /* for HERROR */
+    accrec_t    *access_rec = NULL;   /* access record */
+    chunkinfo_t *info       = NULL;   /* chunked element information record */
+    filerec_t   *file_rec   = NULL;   /* file record */
+    CHUNK_REC   *chk_rec    = NULL;   /* chunk record */
+    int32       chunk_len;            /* bytes of a chunk */
+    int32       nslots;               /* number of chunks of the element */
+    int32       i;                    /* loop index */
+    intn        ret_value = SUCCEED;
+
+    /* Check args */
+    access_rec = HAatom_object(access_id);
+    if (access_rec == NULL || alignment < 0 || (flags & ~HDF_CHUNK_PREALLOC))
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* since this routine can be called by the user,
+       need to check if this access id is special CHUNKED */
+    if (access_rec->special != SPECIAL_CHUNKED
+        || (info = (chunkinfo_t *) (access_rec->special_info)) == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    file_rec = HAatom_object(access_rec->file_id);
+    if (BADFREC(file_rec))
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* check file access for write */
+    if (!(file_rec->access & DFACC_WRITE))
+        HGOTO_ERROR(DFE_DENIED, FAIL);
+
+    /* compressed chunks can't be placed */
+    if ((info->flag & 0xff) == SPECIAL_COMP)
+        HGOTO_ERROR(DFE_UNSUPPORTED, FAIL);
+
+    /* chunks waiting in the cache must go by the old policy, which
+       also drops an extent kept before */
+    if (mcache_sync(info->chk_cache) == RET_ERROR)
+        HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+    if (HMCIunplace(access_rec) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    info->align = (alignment > 1) ? alignment : 0;
+
+    if (flags & HDF_CHUNK_PREALLOC)
+      {
+          /* each chunk takes its length, up to the next boundary */
+          chunk_len = info->chunk_size * info->nt_size;
+          if (info->align > 1 && chunk_len % info->align != 0)
+            {
+                if ((hdf_off_t)chunk_len + info->align > MAX_OFFSET32)
+                    HGOTO_ERROR(DFE_BADLEN, FAIL);
+                chunk_len += info->align - chunk_len % info->align;
+            }
+
+          for (i = 0, nslots = 1; i < info->ndims; i++)
+              nslots *= info->ddims[i].num_chunks;
+          if (chunk_len <= 0 || nslots <= 0
+              || (hdf_off_t)chunk_len * nslots > MAX_OFFSET32)
+              HGOTO_ERROR(DFE_BADLEN, FAIL);
+
+          if ((info->pre_used = (uint8 *) HDcalloc((uint32)nslots, sizeof(uint8))) == NULL)
+              HGOTO_ERROR(DFE_NOSPACE, FAIL);
+
+          if ((info->pre_off = HPgetalignedblock(file_rec, chunk_len * nslots,
+                                                 info->align)) == FAIL)
+            {
+                info->pre_off = 0;
+                HDfree(info->pre_used);
+                info->pre_used = NULL;
+                HGOTO_ERROR(DFE_SEEKERROR, FAIL);
+            }
+          info->pre_len    = chunk_len;
+          info->pre_nslots = nslots;
+
+          /* the chunks written already stay where they are */
+          for (i = 0; i < nslots; i++)
+            {
+                if (HMCIfind_chunk(info, i, &chk_rec) == FAIL)
+                    HGOTO_ERROR(DFE_INTERNAL, FAIL);
+                if (chk_rec != NULL && chk_rec->chk_tag != DFTAG_NULL)
+                  {
+                      info->pre_used[i] = TRUE;
+                      if (HPfreediskblock(file_rec, 
+                                info->pre_off + (hdf_off_t)i * chunk_len,
+                                chunk_len) == FAIL)
+                          HGOTO_ERROR(DFE_INTERNAL, FAIL);
+                  }
+            }
+      }
+
+  done:
+    if(ret_value == FAIL)   
+      { /* Error condition cleanup */
+
+      } /* end if */
+
+    /* Normal function cleanup */
+    return ret_value;
+} /* HMCsetAlignment() */
+
+/* ------------------------------ HMCPstread -------------------------------
+NAME
+   HMCPstread -- open an access record of chunked element for reading
+
+DESCRIPTION
+   Calls to HMCIstaccess to fill in the access rec for
+   reading
+
+RETURNS
+   The AID of the access record on success FAIL on error.
+AUTHOR
+   -GeorgeV - 9/3/96
+---------------------------------------------------------------------------*/
+int32
+HMCPstread(accrec_t * access_rec /* IN: access record to fill in */)
+{
+    int32 ret_value;
+
+    ret_value = HMCIstaccess(access_rec, DFACC_READ);
+
+    return ret_value;
+}   /* HMCPstread */
+
+/* ------------------------------ HMCPstwrite ------------------------------
+NAME
+   HMCPstwrite -- open an access record of a chunked elmenent for writing
+
+DESCRIPTION
+   Calls to HMCIstaccess to fill in the access rec for
+   writing
+
+RETURNS
+   The AID of the access record on success FAIL on error.
+AUTHOR
    -GeorgeV - 9/3/96
 ---------------------------------------------------------------------------*/
 int32
@@ -2886,7 +3599,7 @@ HMCPchunkread(void  *cookie,    /* IN: access record to mess with */
     accrec_t * access_rec = (accrec_t *)cookie; /* access record */
     chunkinfo_t *info    = NULL; /* information record for this special data elt */
     CHUNK_REC   *chk_rec = NULL; /* chunk record */
-    TBBT_NODE   *entry   = NULL; /* chunk node from TBBT */
+    filerec_t   *file_rec = NULL; /* file record */
     uint8       *bptr    = NULL; /* pointer to data buffer */
     int32       chk_id   = FAIL; /* chunk id */
     int32       bytes_read = 0;    /* total # bytes read for this call of HMCIread */
@@ -2907,8 +3620,10 @@ HMCPchunkread(void  *cookie,    /* IN: access record to mess with */
 #ifdef CHK_DEBUG_3
     printf("HMCPchunkread called with chunk %d \n",chunk_num);
 #endif
-    /* find chunk record in TBBT */
-    if ((entry = (tbbtdfind(info->chk_tree, &chunk_num, NULL))) == NULL)
+    /* find chunk record in the chunk index */
+    if (HMCIfind_chunk(info, chunk_num, &chk_rec) == FAIL)
+        HE_REPORT_GOTO("failed to look chunk record up", FAIL);
+    if (chk_rec == NULL)
       { /* does not exist */
           /* calculate number of fill value items to fill buffer with */
           nitems = (info->chunk_size * info->nt_size) / info->fill_val_len;
@@ -2917,14 +3632,16 @@ HMCPchunkread(void  *cookie,    /* IN: access record to mess with */
           if (HDmemfill(datap,info->fill_val, (uint32)info->fill_val_len,(uint32)nitems) == NULL)
               HE_REPORT_GOTO("HDmemfill failed to fill read chunk", FAIL);
       }
-    else /* exists in TBBT */
+    else /* exists in the chunk index */
       {
-          /* get chunk record from node */
-          chk_rec = (CHUNK_REC *) entry->data; 
-
           /* check to see if has been written to */
           if (chk_rec->chk_tag != DFTAG_NULL && BASETAG(chk_rec->chk_tag) == DFTAG_CHUNK)
             { /* valid chunk in file */
+                /* the shared cache may have it already (see hcache.c) */
+                file_rec = HAatom_object(access_rec->file_id);
+                if (HCSget(file_rec, chk_rec->chk_tag, chk_rec->chk_ref, bptr, read_len))
+                    HGOTO_DONE(read_len);
+
                 /* Start read on chunk */
                 if ((chk_id = Hstartread(access_rec->file_id, chk_rec->chk_tag,
                                          chk_rec->chk_ref)) == FAIL)
@@ -2942,7 +3659,8 @@ HMCPchunkread(void  *cookie,    /* IN: access record to mess with */
                 /* end access to chunk */
                 if (Hendaccess(chk_id) == FAIL)
                     HE_REPORT_GOTO("Hendaccess failed to end access to chunk", FAIL);
-              
+
+                HCSput(file_rec, chk_rec->chk_tag, chk_rec->chk_ref, bptr, read_len);
             }
           else if (chk_rec->chk_tag == DFTAG_NULL) 
             {/* chunk has not been written, so return fill value buffer */
@@ -2960,7 +3678,7 @@ HMCPchunkread(void  *cookie,    /* IN: access record to mess with */
                 HE_REPORT_GOTO("Not a valid Chunk object, wrong tag for chunk", FAIL);
             }
 
-      } /* end else exists in TBBT tree */
+      } /* end else exists in the chunk index */
 
     ret_value = bytes_read; /* number of bytes read */
 
@@ -2978,6 +3696,162 @@ HMCPchunkread(void  *cookie,    /* IN: access record to mess with */
     return ret_value;
 } /* HMCPchunkread() */
 
+/* ------------------------------- HMCIdecode_chunk -----------------------
+NAME
+   HMCIdecode_chunk - decompress a chunk
+
+DESCRIPTION
+   Decompresses a chunk read by HMCPchunkreadv into its buffer.
+   Runs on the worker pool, see HWrun().
+
+RETURNS
+   Nothing, the number of bytes decompressed or FAIL is left in
+   the argument.
+--------------------------------------------------------------------------- */
+PRIVATE void
+HMCIdecode_chunk(VOID *arg           /* IN/OUT: chunk to decompress */ )
+{
+    chunk_decode_t *dec = (chunk_decode_t *) arg;
+
+    /* chunks found in the shared cache are done already */
+    if (dec->coded != NULL)
+        dec->nread = HCPdecode_coded(dec->coder, dec->coded, dec->coded_len,
+                                     (uint8 *) dec->datap, dec->length);
+} /* HMCIdecode_chunk() */
+
+/* ------------------------------- HMCPchunkreadv -------------------------------
+NAME
+   HMCPchunkreadv - read several chunks
+
+DESCRIPTION
+   Read in several whole chunks from a chunked element given the
+   chunk numbers.  
+
+   The chunks of a compressed element are read from the file one
+   after the other and then decompressed at the same time on the
+   worker pool (see HWrun()). Chunks the pool cannot decompress,
+   those of other coders than gzip 'deflate', are read through
+   HMCPchunkread(), as are the chunks of elements not compressed.
+
+   This is used as the 'page-in-chunks' routine for the cache
+   (see mcache_getv()). Only the cache should call this routine.
+
+RETURNS
+   SUCCEED or FAIL on error
+--------------------------------------------------------------------------- */
+int32
+HMCPchunkreadv(void  *cookie,    /* IN: access record to mess with */
+               int32 nchunks,    /* IN: number of chunks to read */
+               const int32 *chunk_nums, /* IN: chunks to read */
+               void  **datap     /* OUT: buffers for data */)
+{
+    CONSTR(FUNC, "HMCPchunkreadv");    /* for HERROR */
+    accrec_t * access_rec = (accrec_t *)cookie; /* access record */
+    chunkinfo_t *info    = NULL; /* information record for this special data elt */
+    CHUNK_REC   *chk_rec = NULL; /* chunk record */
+    filerec_t   *file_rec = NULL; /* file record */
+    chunk_decode_t *decs = NULL; /* chunks to decompress */
+    int32       ndecs    = 0;    /* number of chunks to decompress */
+    int32       chunk_num;       /* chunk to read */
+    int32       read_len = 0;    /* length of a chunk */
+    int32       orig_len;        /* length of a chunk decompressed */
+    intn        status;
+    int32       i, j;
+    int32       ret_value = SUCCEED;
+
+    /* Check args */
+    if (access_rec == NULL || nchunks < 0)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* set inputs */
+    info = (chunkinfo_t *) (access_rec->special_info);
+    read_len = (info->chunk_size * info->nt_size); 
+    file_rec = HAatom_object(access_rec->file_id);
+
+    /* read in the compressed chunks */
+    if (nchunks > 1 && (info->flag & 0xff) == SPECIAL_COMP 
+        && info->comp_type == COMP_CODE_DEFLATE)
+      {
+          if ((decs = (chunk_decode_t *) HDcalloc((uint32)nchunks, sizeof(chunk_decode_t))) == NULL)
+              HGOTO_ERROR(DFE_NOSPACE, FAIL);
+
+          for (i = 0; i < nchunks; i++)
+            {
+                /* chunks not written are filled by HMCPchunkread */
+                chunk_num = chunk_nums[i];
+                if (HMCIfind_chunk(info, chunk_num, &chk_rec) == FAIL)
+                    HE_REPORT_GOTO("failed to look chunk record up", FAIL);
+                if (chk_rec == NULL)
+                    continue;
+                if (chk_rec->chk_tag == DFTAG_NULL || BASETAG(chk_rec->chk_tag) != DFTAG_CHUNK)
+                    continue;
+
+                decs[ndecs].datap  = datap[i];
+                decs[ndecs].length = read_len;
+                decs[ndecs].index  = i;
+                decs[ndecs].tag    = chk_rec->chk_tag;
+                decs[ndecs].ref    = chk_rec->chk_ref;
+
+                /* the shared cache may have it already (see hcache.c) */
+                if (HCSget(file_rec, chk_rec->chk_tag, chk_rec->chk_ref, datap[i], read_len))
+                  {
+                      decs[ndecs].coded   = NULL;
+                      decs[ndecs++].nread = read_len;
+                      continue;
+                  }
+
+                status = HCPreadcoded(access_rec->file_id, chk_rec->chk_tag, chk_rec->chk_ref,
+                                      &decs[ndecs].coder, &orig_len,
+                                      &decs[ndecs].coded_len, &decs[ndecs].coded);
+                if (status == FAIL)
+                    HE_REPORT_GOTO("HCPreadcoded failed to read chunk", FAIL);
+                if (status == FALSE)
+                    continue;
+                if (orig_len != read_len)
+                  { /* leave it to HMCPchunkread */
+                      HDfree(decs[ndecs].coded);
+                      decs[ndecs].coded = NULL;
+                      continue;
+                  }
+                ndecs++;
+            } /* end for i */
+
+          /* decompress them all at once */
+          HWrun(HMCIdecode_chunk, decs, sizeof(chunk_decode_t), (intn)ndecs);
+
+          for (j = 0; j < ndecs; j++)
+              if (decs[j].coded != NULL && decs[j].nread == read_len)
+                  HCSput(file_rec, decs[j].tag, decs[j].ref, decs[j].datap, read_len);
+      }
+
+    /* read the other chunks, and the ones which failed to decompress,
+       one at a time */
+    for (i = 0, j = 0; i < nchunks; i++)
+      {
+          if (j < ndecs && decs[j].index == i)
+              if (decs[j++].nread == read_len)
+                  continue;
+
+          if (HMCPchunkread(cookie, chunk_nums[i], datap[i]) == FAIL)
+              HE_REPORT_GOTO("failed to read chunk", FAIL);
+      } /* end for i */
+
+  done:
+    if(ret_value == FAIL)   
+      { /* Error condition cleanup */
+      } /* end if */
+
+    /* Normal function cleanup */
+    if (decs != NULL)
+      {
+          for (i = 0; i < nchunks; i++)
+              if (decs[i].coded != NULL)
+                  HDfree(decs[i].coded);
+          HDfree(decs);
+      }
+    return ret_value;
+} /* HMCPchunkreadv() */
+
 /* ------------------------------- HMCreadChunk ---------------------------
 NAME
    HMCreadChunk -- read a whole chunk
@@ -2999,6 +3873,7 @@ HMCreadChunk(int32 access_id,  /* IN: access aid to mess with */
              int32 *origin,    /* IN: origin of chunk to read */
              void *datap /* IN: buffer for data */)
 {
+    HTS_READ_LOCK(access_id);
     CONSTR(FUNC, "HMCreadChunk");  /* for HERROR */
     accrec_t    *access_rec = NULL; /* access record */
 #ifdef UNUSED
@@ -3153,7 +4028,22 @@ DESCRIPTION
    Read in some data from a chunked element. 
 
    Data is obtained from the cache which takes care of reading
-   in the proper chunks to satisfy the request.
+   in the proper chunks to satisfy the request. Chunks which are
+   read whole, and fall in one piece in the user's buffer, are read
+   straight into it instead if they are not cached, they do not go
+   through the cache nor push other chunks out of it.
+
+   Reads which go through the chunks at a steady stride, forwards or
+   backwards, along the fastest dimension or down the slowest one as
+   in pulling a time series out of the element, are read ahead: once
+   three reads in a row have moved on by the same number of chunks, a
+   read whose next chunk at that stride is not cached gets the
+   following chunks too, up to HMC_READ_AHEAD and as many as the cache
+   has room for besides the chunks of the read.  They are read in 
+   along with those and then decompressed together on the worker pool
+   (see HMCPchunkreadv()), so that the next reads find them in the 
+   cache.  The read-ahead is done within the read, which waits for it;
+   nothing is fetched in the background.
 
 RETURNS
    The number of bytes read or FAIL on error
@@ -3177,8 +4067,22 @@ HMCPread(accrec_t * access_rec, /* IN: access record to mess with */
     int32       read_seek = 0;   /* next read seek position */
     int32       chunk_size = 0;  /* size of data to read from chunk */
     int32       chunk_num = 0;   /* next chunk number */
-    void        *chk_data = NULL; /* chunk data */
     uint8       *chk_dptr = NULL; /* pointer to chunk data */
+    int32       chunk_pgnos[HMC_READ_BATCH]; /* chunks to get from the cache */
+    void        *chk_pages[HMC_READ_BATCH];  /* their data */
+    int32       nchunks = 0;     /* number of chunks to get */
+    int32       direct_nums[HMC_READ_BATCH]; /* chunks to read straight into datap */
+    void        *direct_bufs[HMC_READ_BATCH]; /* where they go */
+    int32       ndirect = 0;     /* number of chunks to read straight in */
+    int32       chunk_len;       /* size of a whole chunk */
+    int32       max_chunks;      /* most chunks to get at once */
+    int32       batch_posn;      /* relative_posn of the chunks got */
+    int32       batch_read;      /* bytes_read before them */
+    int32       batch_end;       /* bytes_read after them */
+    int32       last_chunk;      /* chunk the read ends in */
+    int32       ahead;           /* chunk to read ahead */
+    int32       total_chunks;    /* number of chunks in the element */
+    int32       j, k;
 #ifdef CHK_DEBUG_3
     int         i;
 #endif
@@ -3218,103 +4122,245 @@ HMCPread(accrec_t * access_rec, /* IN: access record to mess with */
                                info->seek_chunk_indices,
                                info->seek_pos_chunk,info->ddims);
 
+    /* the chunks got at once must all fit in the cache */
+    max_chunks = mcache_get_maxcache(info->chk_cache);
+    if (max_chunks > HMC_READ_BATCH)
+        max_chunks = HMC_READ_BATCH;
+    else if (max_chunks < 1)
+        max_chunks = 1;
+
+    chunk_len = info->chunk_size * info->nt_size;
+
+    /* see whether the reads go through the chunks at a steady stride, 
+       reads staying in the chunk the last one ended in do not count */
+    calculate_chunk_num(&chunk_num,info->ndims,info->seek_chunk_indices,
+                        info->ddims);
+    if (chunk_num != info->ra_last)
+      {
+          if (info->ra_last >= 0 && chunk_num - info->ra_last == info->ra_stride)
+              info->ra_count++;
+          else
+            {
+                info->ra_stride = (info->ra_last >= 0) ? chunk_num - info->ra_last : 0;
+                info->ra_count = 0;
+            }
+      }
+    last_chunk = chunk_num;
+
     /* enter translating length to proper filling of buffer from chunks */
     bptr = datap;
     bytes_read = 0;
     read_len = length; 
     while (bytes_read < read_len) 
       {
-          /* for debuging */
+          /* work out the chunks the read needs next, as many as the
+             cache holds at most, so that the ones which have to be read 
+             in can be read in together.  The chunks read whole which 
+             are not cached are read straight into the user's buffer
+             instead, bypassing the cache */
+          batch_posn = relative_posn;
+          batch_read = bytes_read;
+          nchunks = 0;
+          ndirect = 0;
+          k = 0;
+          while (bytes_read < read_len) 
+            {
+                /* for debuging */
 #ifdef CHK_DEBUG_3
-	  int i;
-          printf(" Seek start(in chunk array):(");
-          for (i = 0; i < info->ndims; i++)
-              printf("%d%s", info->seek_chunk_indices[i], i!= info->ndims-1 ? ",":NULL);
-          printf(")\n");
-          printf(" Seek start(within the chunk):(");
-          for (i = 0; i < info->ndims; i++)
-              printf("%d%s", info->seek_pos_chunk[i], i!= info->ndims-1 ? ",":NULL);
-          printf(")\n");
+                int i;
+                printf(" Seek start(in chunk array):(");
+                for (i = 0; i < info->ndims; i++)
+                    printf("%d%s", info->seek_chunk_indices[i], i!= info->ndims-1 ? ",":NULL);
+                printf(")\n");
+                printf(" Seek start(within the chunk):(");
+                for (i = 0; i < info->ndims; i++)
+                    printf("%d%s", info->seek_pos_chunk[i], i!= info->ndims-1 ? ",":NULL);
+                printf(")\n");
 #endif
 
-          /* calculate chunk to retrieve on this pass */
-          calculate_chunk_num(&chunk_num,info->ndims,info->seek_chunk_indices,
-                              info->ddims);
+                /* calculate chunk to retrieve on this pass 
+                   Note the cache deals with objects starting from 1 not 0 */
+                calculate_chunk_num(&chunk_num,info->ndims,info->seek_chunk_indices,
+                                    info->ddims);
+
+                /* calculate contiguous chunk size that we can read from this chunk 
+                   during this pass, and where it starts in the chunk */
+                calculate_chunk_for_chunk(&chunk_size,info->ndims,info->nt_size,
+                                          read_len,bytes_read,
+                                          info->seek_chunk_indices,
+                                          info->seek_pos_chunk,info->ddims);
+                calculate_whole_chunk(&chunk_size,chunk_len,info->ndims,
+                                      read_len,bytes_read,
+                                      info->seek_chunk_indices,
+                                      info->seek_pos_chunk,info->ddims);
+                calculate_seek_in_chunk(&read_seek,info->ndims,info->nt_size,
+                                        info->seek_pos_chunk,
+                                        info->ddims);
+                last_chunk = chunk_num;
+
+                if (read_seek == 0 && chunk_size == chunk_len
+                    && !mcache_cached(info->chk_cache, chunk_num+1))
+                  { /* the whole chunk, laid out as in the user's buffer */
+                      if (ndirect == HMC_READ_BATCH)
+                          break;
+                      direct_nums[ndirect] = chunk_num;
+                      direct_bufs[ndirect++] = bptr + (bytes_read - batch_read);
+                  }
+                else if (nchunks == 0 || chunk_pgnos[k] != chunk_num+1)
+                  {
+                      for (k = 0; k < nchunks && chunk_pgnos[k] != chunk_num+1; k++)
+                          ;
+                      if (k == nchunks)
+                        {
+                            if (nchunks == max_chunks)
+                                break;
+                            chunk_pgnos[nchunks++] = chunk_num+1;
+                        }
+                  }
 
-          /* calculate contiguous chunk size that we can read from this chunk 
-             during this pass */
-          calculate_chunk_for_chunk(&chunk_size,info->ndims,info->nt_size,
-                                    read_len,bytes_read,
-                                    info->seek_chunk_indices,
-                                    info->seek_pos_chunk,info->ddims);
+                bytes_read += chunk_size; 
+                relative_posn += chunk_size;
+                update_chunk_indicies_seek(relative_posn,info->ndims, info->nt_size,
+                                           info->seek_chunk_indices,
+                                           info->seek_pos_chunk,info->ddims);
+            } /* end while "bytes_read" */
+          batch_end = bytes_read;
+
+          /* along with the last chunks of a read at a steady stride,
+             get the next ones at that stride unless they are cached */
+          for (total_chunks = 1, j = 0; j < info->ndims; j++)
+              total_chunks *= info->ddims[j].num_chunks;
+          ahead = last_chunk + info->ra_stride;
+          if (bytes_read == read_len && info->ra_count > 0 && info->ra_stride != 0
+              && ahead >= 0 && ahead < total_chunks
+              && !mcache_cached(info->chk_cache, ahead+1))
+            {
+                for (j = 0; j < HMC_READ_AHEAD && nchunks < max_chunks
+                         && ahead >= 0 && ahead < total_chunks; 
+                     j++, ahead += info->ra_stride)
+                  {
+                      if (mcache_cached(info->chk_cache, ahead+1))
+                          continue;
+                      for (k = 0; k < nchunks && chunk_pgnos[k] != ahead+1; k++)
+                          ;
+                      if (k == nchunks)
+                          chunk_pgnos[nchunks++] = ahead+1;
+                  }
+            }
 
-          /* would be nice to get Chunk record from TBBT based on chunk number 
+          /* would be nice to get Chunk record from the index based on chunk number 
              and then get chunk data base on chunk vdata number but
              currently the chunk calculations return chunk 
              numbers and not Vdata record numbers. 
              This would reduce some overhead in the number of chunks
              dealt with in the cache */
 
-          /* currently get chunk data from cache based on chunk number 
-             Note the cache deals with objects starting from 1 not 0 */
-          if ((chk_data = mcache_get(info->chk_cache, /* cache handle */
-                                              chunk_num+1,     /* chunk number */
-                                              0                /* flag: unused */)) 
-              == NULL)
-              HE_REPORT_GOTO("failed to find chunk record", FAIL);
+          /* read the whole chunks straight into the user's buffer */
+          if (ndirect > 0 && HMCPchunkreadv(access_rec, ndirect, 
+                                            direct_nums, direct_bufs) == FAIL)
+              HE_REPORT_GOTO("failed to read chunks", FAIL);
 
-          chk_dptr = chk_data; /* set chunk data ptr */
+          /* currently get chunk data from cache based on chunk number */
+          if (nchunks == 1)
+            {
+                if ((chk_pages[0] = mcache_get(info->chk_cache, /* cache handle */
+                                               chunk_pgnos[0],   /* chunk number */
+                                               0                 /* flag: unused */)) 
+                    == NULL)
+                    HE_REPORT_GOTO("failed to find chunk record", FAIL);
+            }
+          else if (nchunks > 1 && mcache_getv(info->chk_cache, /* cache handle */
+                               nchunks,          /* number of chunks */
+                               chunk_pgnos,      /* chunk numbers */
+                               chk_pages         /* OUT: chunk data */) 
+                   == FAIL)
+              HE_REPORT_GOTO("failed to find chunk records", FAIL);
+
+          /* go over the read again, copying the data this time */
+          relative_posn = batch_posn;
+          bytes_read = batch_read;
+          update_chunk_indicies_seek(relative_posn,info->ndims, info->nt_size,
+                                     info->seek_chunk_indices,
+                                     info->seek_pos_chunk,info->ddims);
+          k = 0;
+          while (bytes_read < batch_end) 
+            {
+                calculate_chunk_num(&chunk_num,info->ndims,info->seek_chunk_indices,
+                                    info->ddims);
+                if (k >= nchunks || chunk_pgnos[k] != chunk_num+1)
+                    for (k = 0; k < nchunks && chunk_pgnos[k] != chunk_num+1; k++)
+                        ;
+
+                calculate_chunk_for_chunk(&chunk_size,info->ndims,info->nt_size,
+                                          read_len,bytes_read,
+                                          info->seek_chunk_indices,
+                                          info->seek_pos_chunk,info->ddims);
+                calculate_whole_chunk(&chunk_size,chunk_len,info->ndims,
+                                      read_len,bytes_read,
+                                      info->seek_chunk_indices,
+                                      info->seek_pos_chunk,info->ddims);
+
+                /* chunks not got from the cache were read in whole above */
+                if (k < nchunks)
+                  {
+                      chk_dptr = chk_pages[k]; /* set chunk data ptr */
 
-          /* calculate position in chunk */
-          calculate_seek_in_chunk(&read_seek,info->ndims,info->nt_size,
-                                  info->seek_pos_chunk,
-                                  info->ddims);
+                      /* calculate position in chunk */
+                      calculate_seek_in_chunk(&read_seek,info->ndims,info->nt_size,
+                                              info->seek_pos_chunk,
+                                              info->ddims);
 
-          chk_dptr += read_seek; /* move to correct position in chunk */
+                      chk_dptr += read_seek; /* move to correct position in chunk */
 
 #ifdef CHK_DEBUG_3
-          printf("  read pos in chunk(%d) is %d bytes\n", chunk_num, read_seek);
+                      printf("  read pos in chunk(%d) is %d bytes\n", chunk_num, read_seek);
 #endif
-          /* copy data from chunk to users buffer */
-          HDmemcpy(bptr, chk_dptr, chunk_size);        
+                      /* copy data from chunk to users buffer */
+                      HDmemcpy(bptr, chk_dptr, chunk_size);        
+                  }
 
 #ifdef CHK_DEBUG_10
-          printf(" chk_dptr={");
-          for (i = 0; i < chunk_size; i++)
-              printf("%d,",(uint8)*((uint8 *)(chk_dptr)+i));
-          printf("}\n");
+                printf(" chk_dptr={");
+                for (i = 0; i < chunk_size; i++)
+                    printf("%d,",(uint8)*((uint8 *)(chk_dptr)+i));
+                printf("}\n");
 #endif
-          /* put chunk back to cache */
-          if (mcache_put(info->chk_cache, /* cache handle */
-                         chk_data,        /* whole data chunk */
-                         0                /* flag: 0->not DIRTY */) 
-              == FAIL)
-              HE_REPORT_GOTO("failed to put chunk back in cache", FAIL);
-
-          /* increment buffer pointer */
-          bptr += chunk_size;
+                /* increment buffer pointer */
+                bptr += chunk_size;
 
-          /* adjust number of bytes already read */
-          bytes_read += chunk_size; 
+                /* adjust number of bytes already read */
+                bytes_read += chunk_size; 
 
 #ifdef CHK_DEBUG_3
-          printf("  read %d bytes already\n", bytes_read);
+                printf("  read %d bytes already\n", bytes_read);
 #endif
-          /* update relative position i.e. user element seek postion 
-             with chunk size written */
-          relative_posn += chunk_size;
+                /* update relative position i.e. user element seek postion 
+                   with chunk size written */
+                relative_posn += chunk_size;
 #ifdef CHK_DEBUG_3
-          printf("  relative_posn = %d bytes \n", relative_posn);
+                printf("  relative_posn = %d bytes \n", relative_posn);
 #endif
-          /* i.e calculate chunk indices given seek location 
-             this will update the proper arrays in the special info struct */
-          update_chunk_indicies_seek(relative_posn,info->ndims, info->nt_size,
-                                     info->seek_chunk_indices,
-                                     info->seek_pos_chunk,info->ddims);
+                /* i.e calculate chunk indices given seek location 
+                   this will update the proper arrays in the special info struct */
+                update_chunk_indicies_seek(relative_posn,info->ndims, info->nt_size,
+                                           info->seek_chunk_indices,
+                                           info->seek_pos_chunk,info->ddims);
+            } /* end while "bytes_read" */
+
+          /* put chunks back to cache */
+          for (k = 0; k < nchunks; k++)
+              if (mcache_put(info->chk_cache, /* cache handle */
+                             chk_pages[k],    /* whole data chunk */
+                             0                /* flag: 0->not DIRTY */) 
+                  == FAIL)
+                  ret_value = FAIL;
+          if (ret_value == FAIL)
+              HE_REPORT_GOTO("failed to put chunk back in cache", FAIL);
       } /* end while "bytes_read" */
 
     /* update access record postion with bytes read */
     access_rec->posn += bytes_read;
+    info->ra_last = last_chunk;
 
     ret_value = bytes_read;
 
@@ -3334,33 +4380,141 @@ HMCPread(accrec_t * access_rec, /* IN: access record to mess with */
     return ret_value;
 }   /* HMCPread  */
 
-/* ------------------------------- HMCPchunkwrite -------------------------------
+/* ------------------------------- HMCIplace_chunk ----------------------------
 NAME
-   HMCPchunkwrite -- write out chunk
+   HMCIplace_chunk -- find the place in the file for a new chunk
 
 DESCRIPTION
-   Write a whole chunk to a chunked element given the chunk number.  
+   Gets the block of the file a chunk written for the first time goes
+   in, as HMCsetAlignment() asked: its place in the extent preallocated
+   for the chunks if there is one, otherwise a block starting on a
+   multiple of the alignment.
 
-   This is used as the 'page-out-chunk' routine for the cache.
-   Only the cache should call this routine.
+RETURNS
+   The offset of the block or FAIL on error
+---------------------------------------------------------------------------*/
+PRIVATE hdf_off_t
+HMCIplace_chunk(accrec_t *access_rec, /* IN: access record to mess with */
+                int32 chunk_num,      /* IN: chunk number */
+                int32 length          /* IN: length of the chunk */)
+{
+    CONSTR(FUNC, "HMCIplace_chunk");   /* for HERROR */
+    chunkinfo_t *info     = (chunkinfo_t *) (access_rec->special_info);
+    filerec_t   *file_rec = NULL;     /* file record */
+    hdf_off_t   ret_value = SUCCEED;
+
+    file_rec = HAatom_object(access_rec->file_id);
+    if (BADFREC(file_rec))
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* chunks past the end of the extent, after an unlimited dimension
+       grew, go elsewhere */
+    if (info->pre_off != 0 && chunk_num < info->pre_nslots
+        && length <= info->pre_len && !info->pre_used[chunk_num])
+      {
+          info->pre_used[chunk_num] = TRUE;
+          ret_value = info->pre_off + (hdf_off_t)chunk_num * info->pre_len;
+      }
+    else if ((ret_value = HPgetalignedblock(file_rec, length, info->align)) == FAIL)
+        HGOTO_ERROR(DFE_SEEKERROR, FAIL);
+
+  done:
+    if(ret_value == FAIL)   
+      { /* Error condition cleanup */
+
+      } /* end if */
+
+    /* Normal function cleanup */
+    return ret_value;
+} /* HMCIplace_chunk() */
+
+/* ------------------------------- HMCIunplace --------------------------------
+NAME
+   HMCIunplace -- give back the places preallocated for chunks not written
+
+DESCRIPTION
+   Puts the places of the extent preallocated for the chunks which no
+   chunk was written to back in the free list of the file, and drops
+   the extent.  The chunks must all have been written out of the cache.
+
+RETURNS
+   SUCCEED/FAIL
+---------------------------------------------------------------------------*/
+PRIVATE intn
+HMCIunplace(accrec_t *access_rec     /* IN: access record to mess with */)
+{
+    CONSTR(FUNC, "HMCIunplace");   /* for HERROR */
+    chunkinfo_t *info     = (chunkinfo_t *) (access_rec->special_info);
+    filerec_t   *file_rec = NULL;  /* file record */
+    int32       i, j;              /* loop indices */
+    intn        ret_value = SUCCEED;
+
+    if (info->pre_off == 0)
+        HGOTO_DONE(SUCCEED);
+
+    file_rec = HAatom_object(access_rec->file_id);
+    if (BADFREC(file_rec))
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* give back the runs of places not used, from the last one so that
+       those at the end of the file just shorten it */
+    for (i = info->pre_nslots; i > 0; i = j)
+      {
+          for (; i > 0 && info->pre_used[i - 1]; i--)
+              ;
+          for (j = i; j > 0 && !info->pre_used[j - 1]; j--)
+              ;
+          if (j < i && HPfreediskblock(file_rec,
+                          info->pre_off + (hdf_off_t)j * info->pre_len,
+                          (i - j) * info->pre_len) == FAIL)
+              ret_value = FAIL;
+      }
+
+    HDfree(info->pre_used);
+    info->pre_used   = NULL;
+    info->pre_off    = 0;
+    info->pre_len    = 0;
+    info->pre_nslots = 0;
+
+    if (ret_value == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+  done:
+    if(ret_value == FAIL)   
+      { /* Error condition cleanup */
+
+      } /* end if */
+
+    /* Normal function cleanup */
+    return ret_value;
+} /* HMCIunplace() */
+
+/* ------------------------------- HMCIchunkwrite -------------------------------
+NAME
+   HMCIchunkwrite -- write out chunk
+
+DESCRIPTION
+   Write a whole chunk to a chunked element given the chunk number.  
+   If 'coded' is given it holds the chunk compressed beforehand (see
+   HMCPchunkwritev()), which is written instead of compressing 'datap'.
 
 RETURNS
    The number of bytes written or FAIL on error
 AUTHOR
    -GeorgeV - 9/3/96
 ---------------------------------------------------------------------------*/
-int32
-HMCPchunkwrite(void  *cookie,    /* IN: access record to mess with */
-               int32 chunk_num,  /* IN: chunk number */
-               const void *datap /* IN: buffer for data */)
+PRIVATE int32
+HMCIchunkwrite(accrec_t *access_rec, /* IN: access record to mess with */
+               int32 chunk_num,      /* IN: chunk number */
+               const VOID *datap,    /* IN: buffer for data */
+               const uint8 *coded,   /* IN: the chunk compressed, or NULL */
+               int32 coded_len       /* IN: length of compressed chunk */)
 {
-    CONSTR(FUNC, "HMCPchunkwrite");   /* for HERROR */
-    accrec_t * access_rec = (accrec_t *)cookie; /* access record */
+    CONSTR(FUNC, "HMCIchunkwrite");   /* for HERROR */
     chunkinfo_t *info    = NULL;  /* chunked element information record */
     CHUNK_REC   *chk_rec = NULL;  /* current chunk */
-    TBBT_NODE   *entry   = NULL;  /* node off of  chunk tree */
     uint8       *v_data  = NULL;  /* chunk table record i.e Vdata record */
-    CHUNK_REC   *chkptr  = NULL;  /* Chunk record to inserted in TBBT  */
+    CHUNK_REC   *chkptr  = NULL;  /* Chunk record to put in the table  */
     const void  *bptr    = NULL;  /* data buffer pointer */
     int32       chk_id   = FAIL ; /* chunkd accces id */
 #ifdef UNUSED
@@ -3387,17 +4541,15 @@ HMCPchunkwrite(void  *cookie,    /* IN: access record to mess with */
     bptr          = datap;
 
 #ifdef CHK_DEBUG_4
-    printf("HMCPchunkwrite called with chunk %d \n",chunk_num);
+    printf("HMCIchunkwrite called with chunk %d \n",chunk_num);
 #endif
-    /* find chunk record in TBBT */
-    if ((entry = (tbbtdfind(info->chk_tree, &chunk_num, NULL))) == NULL)
+    /* find chunk record in the chunk index */
+    if (HMCIfind_chunk(info, chunk_num, &chk_rec) == FAIL || chk_rec == NULL)
         HE_REPORT_GOTO("failed to find chunk record", FAIL);
 
-    chk_rec = (CHUNK_REC *) entry->data; /* get file entry from node */
-
     /* Check to see if already created in chunk table */
     if (chk_rec->chk_tag == DFTAG_NULL)
-      { /* does not exists in Vdata table and in file but does in TBBT */
+      { /* does not exists in Vdata table and in file but does in the index */
           uint8 *pntr = NULL;
 
           chkptr = chk_rec;
@@ -3458,8 +4610,19 @@ HMCPchunkwrite(void  *cookie,    /* IN: access record to mess with */
                 break;
             default:
                 /* Start write on chunk */
-                if ((chk_id = Hstartwrite(access_rec->file_id, chk_rec->chk_tag,
-                                          chk_rec->chk_ref,write_len)) == FAIL)
+                if (info->align > 1 || info->pre_off != 0)
+                  { /* put it where HMCsetAlignment() asked */
+                      hdf_off_t chk_off;   /* offset of the chunk in the file */
+
+                      if ((chk_id = Hstartaccess(access_rec->file_id, chk_rec->chk_tag,
+                                                 chk_rec->chk_ref, DFACC_RDWR)) == FAIL)
+                          HE_REPORT_GOTO("Hstartaccess failed to write chunk", FAIL);
+                      if ((chk_off = HMCIplace_chunk(access_rec, chunk_num, write_len)) == FAIL
+                          || HPsetdiskblock(chk_id, chk_off, write_len) == FAIL)
+                          HE_REPORT_GOTO("failed to place chunk", FAIL);
+                  }
+                else if ((chk_id = Hstartwrite(access_rec->file_id, chk_rec->chk_tag,
+                                               chk_rec->chk_ref,write_len)) == FAIL)
                     HE_REPORT_GOTO("Hstartwrite failed to read chunk", FAIL);
                 break;
             }
@@ -3472,8 +4635,16 @@ HMCPchunkwrite(void  *cookie,    /* IN: access record to mess with */
             HE_REPORT_GOTO("Hstartwrite failed to read chunk", FAIL);
       }
 
+    /* the shared cache (see hcache.c) may hold the chunk as it was */
+    HCSinvalidate(HAatom_object(access_rec->file_id), chk_rec->chk_tag, chk_rec->chk_ref);
+
     /* write data to chunk */
-    if (Hwrite(chk_id, write_len, bptr) == FAIL)
+    if (coded != NULL)
+      {
+          if (HCPwritecoded(chk_id, info->comp_type, coded, coded_len, write_len) == FAIL)
+              HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+      }
+    else if (Hwrite(chk_id, write_len, bptr) == FAIL)
         HGOTO_ERROR(DFE_WRITEERROR, FAIL);
 
     bytes_written = write_len;
@@ -3496,11 +4667,179 @@ HMCPchunkwrite(void  *cookie,    /* IN: access record to mess with */
         HDfree(v_data);
 
 #ifdef CHK_DEBUG_4
-    printf("HMCPchunkwrite exited with ret_value %d \n",ret_value);
+    printf("HMCIchunkwrite exited with ret_value %d \n",ret_value);
 #endif
     return ret_value;
+} /* HMCIchunkwrite() */
+
+/* ------------------------------- HMCPchunkwrite -------------------------------
+NAME
+   HMCPchunkwrite -- write out chunk
+
+DESCRIPTION
+   Write a whole chunk to a chunked element given the chunk number.  
+
+   This is used as the 'page-out-chunk' routine for the cache.
+   Only the cache should call this routine.
+
+RETURNS
+   The number of bytes written or FAIL on error
+AUTHOR
+   -GeorgeV - 9/3/96
+---------------------------------------------------------------------------*/
+int32
+HMCPchunkwrite(void  *cookie,    /* IN: access record to mess with */
+               int32 chunk_num,  /* IN: chunk number */
+               const void *datap /* IN: buffer for data */)
+{
+    return HMCIchunkwrite((accrec_t *)cookie, chunk_num, datap, NULL, 0);
 } /* HMCPchunkwrite() */
 
+/* ------------------------------- HMCIencode_chunk -----------------------
+NAME
+   HMCIencode_chunk - compress a chunk
+
+DESCRIPTION
+   Compresses a chunk HMCPchunkwritev is about to write into its
+   buffer.  Runs on the worker pool, see HWrun().
+
+RETURNS
+   Nothing, the length of the compressed chunk or FAIL is left in
+   the argument.
+--------------------------------------------------------------------------- */
+PRIVATE void
+HMCIencode_chunk(VOID *arg           /* IN/OUT: chunk to compress */ )
+{
+    chunk_encode_t *enc = (chunk_encode_t *) arg;
+
+    if (enc->coded != NULL)
+        enc->coded_len = HCPencode_coded(enc->coder, enc->cinfo, 
+                                         (const uint8 *) enc->datap, enc->length,
+                                         enc->coded, enc->coded_size);
+    else
+        enc->coded_len = FAIL;
+} /* HMCIencode_chunk() */
+
+/* ------------------------------- HMCIencode_cmp -------------------------
+NAME
+   HMCIencode_cmp - order chunks by number
+
+DESCRIPTION
+   qsort() comparison putting the chunks HMCPchunkwritev writes in
+   the order of their numbers.
+
+RETURNS
+   <0, 0 or >0 as the first chunk comes before, with or after the second
+--------------------------------------------------------------------------- */
+PRIVATE int
+HMCIencode_cmp(const void *a,        /* IN: chunks to order */
+               const void *b)
+{
+    int32 na = ((const chunk_encode_t *) a)->chunk_num;
+    int32 nb = ((const chunk_encode_t *) b)->chunk_num;
+
+    return (na < nb ? -1 : (na > nb ? 1 : 0));
+} /* HMCIencode_cmp() */
+
+/* ------------------------------- HMCPchunkwritev -------------------------------
+NAME
+   HMCPchunkwritev -- write out several chunks
+
+DESCRIPTION
+   Write several whole chunks to a chunked element given the chunk
+   numbers.  
+
+   The chunks of an element compressed with gzip 'deflate' are first
+   compressed at the same time on the worker pool (see HWrun()), then
+   written out one after the other, as are the chunks of other elements.
+   The chunks are written in the order of their numbers, so that new
+   chunks are laid out in the file in the order of the element.  A chunk
+   the pool failed to compress is compressed again as it is written.
+
+   This is used as the 'page-out-chunks' routine for the cache (see
+   mcache_filterv()), which hands it the dirty chunks it syncs or gives
+   up together, and by HMCPwrite() for the whole chunks it writes
+   straight from the user's buffer.
+
+RETURNS
+   SUCCEED or FAIL on error
+--------------------------------------------------------------------------- */
+int32
+HMCPchunkwritev(void  *cookie,    /* IN: access record to mess with */
+                int32 nchunks,    /* IN: number of chunks to write */
+                const int32 *chunk_nums, /* IN: chunks to write */
+                void  **datap     /* IN: buffers for data */)
+{
+    CONSTR(FUNC, "HMCPchunkwritev");    /* for HERROR */
+    accrec_t * access_rec = (accrec_t *)cookie; /* access record */
+    chunkinfo_t *info    = NULL; /* information record for this special data elt */
+    chunk_encode_t *encs = NULL; /* chunks to write */
+    int32       write_len = 0;   /* length of a chunk */
+    intn        encode;          /* compress on the worker pool? */
+    int32       i;
+    int32       ret_value = SUCCEED;
+
+    /* Check args */
+    if (access_rec == NULL || nchunks < 0)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+    if (nchunks == 0)
+        HGOTO_DONE(SUCCEED);
+
+    /* set inputs */
+    info = (chunkinfo_t *) (access_rec->special_info);
+    write_len = (info->chunk_size * info->nt_size); 
+    encode = (nchunks > 1 && (info->flag & 0xff) == SPECIAL_COMP 
+              && info->comp_type == COMP_CODE_DEFLATE
+              && info->model_type == COMP_MODEL_STDIO);
+
+    if ((encs = (chunk_encode_t *) HDcalloc((uint32)nchunks, sizeof(chunk_encode_t))) == NULL)
+        HGOTO_ERROR(DFE_NOSPACE, FAIL);
+
+    for (i = 0; i < nchunks; i++)
+      {
+          encs[i].coder      = info->comp_type;
+          encs[i].cinfo      = info->cinfo;
+          encs[i].chunk_num  = chunk_nums[i];
+          encs[i].datap      = datap[i];
+          encs[i].length     = write_len;
+          encs[i].coded_len  = FAIL;
+          if (encode)
+            { /* without the memory the chunk is compressed as it is written */
+                encs[i].coded_size = HCP_CODED_BOUND(write_len);
+                encs[i].coded = (uint8 *) HDmalloc((uint32)encs[i].coded_size);
+            }
+      } /* end for i */
+
+    /* compress them all at once */
+    if (encode)
+        HWrun(HMCIencode_chunk, encs, sizeof(chunk_encode_t), (intn)nchunks);
+
+    /* and write them in order */
+    HDqsort(encs, (size_t)nchunks, sizeof(chunk_encode_t), HMCIencode_cmp);
+    for (i = 0; i < nchunks; i++)
+      {
+          if (HMCIchunkwrite(access_rec, encs[i].chunk_num, encs[i].datap,
+                             encs[i].coded_len >= 0 ? encs[i].coded : NULL,
+                             encs[i].coded_len) == FAIL)
+              HE_REPORT_GOTO("failed to write chunk", FAIL);
+      } /* end for i */
+
+  done:
+    if(ret_value == FAIL)   
+      { /* Error condition cleanup */
+      } /* end if */
+
+    /* Normal function cleanup */
+    if (encs != NULL)
+      {
+          for (i = 0; i < nchunks; i++)
+              if (encs[i].coded != NULL)
+                  HDfree(encs[i].coded);
+          HDfree(encs);
+      }
+    return ret_value;
+} /* HMCPchunkwritev() */
+
 /* ------------------------------- HMCwriteChunk ---------------------------
 NAME
    HMCwriteChunk -- write out a whole chunk
@@ -3522,17 +4861,16 @@ HMCwriteChunk(int32 access_id,  /* IN: access aid to mess with */
               int32 *origin,    /* IN: origin of chunk to write */
               const void *datap /* IN: buffer for data */)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
     CONSTR(FUNC, "HMCwriteChunk");  /* for HERROR */
     accrec_t    *access_rec = NULL; /* access record */
 #ifdef UNUSED
     uint8       *data       = NULL; /* data buffer */
-    CHUNK_REC   *chk_rec    = NULL; /* current chunk */
-    TBBT_NODE   *entry      = NULL; /* node off of  chunk tree */
 #endif /* UNUSED */
     filerec_t   *file_rec   = NULL; /* file record */
     chunkinfo_t *info       = NULL; /* chunked element information record */
-    CHUNK_REC   *chkptr     = NULL; /* Chunk record to inserted in TBBT  */
-    int32       *chk_key    = NULL; /* Chunk recored key for insertion in TBBT */
+    CHUNK_REC   *chk_rec    = NULL; /* current chunk */
     const void  *bptr       = NULL; /* data buffer pointer */
     void        *chk_data   = NULL; /* chunk data */
     uint8       *chk_dptr   = NULL; /* chunk data pointer */
@@ -3541,7 +4879,6 @@ HMCwriteChunk(int32 access_id,  /* IN: access aid to mess with */
     int32       write_len = 0;      /* bytes to write next */
     int32       chunk_num = -1;     /* chunk number */
     int32       ret_value = SUCCEED;
-    intn        k;                  /* loop index */
     intn        i;
 
 
@@ -3600,65 +4937,14 @@ HMCwriteChunk(int32 access_id,  /* IN: access aid to mess with */
 #ifdef CHK_DEBUG_4
     printf("HMCwriteChunk called with chunk %d \n",chunk_num);
 #endif
-          /* find chunk record in TBBT */
-          if (tbbtdfind(info->chk_tree, &chunk_num, NULL) == NULL)
-            { /* not in tree */
-                
-                /* so create a new chunk record */
-                /* Allocate space for a chunk record */
-                if ((chkptr = (CHUNK_REC *) HDmalloc(sizeof(CHUNK_REC))) == NULL)
-                    HGOTO_ERROR(DFE_NOSPACE, FAIL);
-
-                /* Allocate space for a origin in chunk record */
-                if ((chkptr->origin = (int32 *) HDmalloc((size_t)info->ndims*sizeof(int32))) == NULL)
-                    HGOTO_ERROR(DFE_NOSPACE, FAIL);
-
-                /* allocate space for key */
-                if ((chk_key = (int32 *)HDmalloc(sizeof(int32))) == NULL)
-                    HGOTO_ERROR(DFE_NOSPACE, FAIL);
-
-                /* Initialize chunk record */
-                chkptr->chk_tag = DFTAG_NULL;
-                chkptr->chk_ref = 0;
-#ifdef CHK_DEBUG_4
-                printf("HMCwriteChunk: chktpr->chk_tag=%d, ",chkptr->chk_tag);
-                printf(" chktpr->chk_ref=%d \n",chkptr->chk_ref);
-#endif
-                /* Intialize chunk origins */
-                for (k = 0; k < info->ndims; k++)
-                  {
-                      chkptr->origin[k] = origin[k];
-#ifdef CHK_DEBUG_4
-                      printf("   chktpr->origin[%d]=%d, ",k,chkptr->origin[k]);
-#endif
-                  }
-#ifdef CHK_DEBUG_4
-                printf("\n");
-#endif
-                /* set chunk record number to next Vdata record number */
-                chkptr->chk_vnum = info->num_recs++;
-
-                /* set key to chunk number */
-                chkptr->chunk_number = *chk_key = chunk_num;
-
-                /* add to TBBT tree based on chunk number as the key */
-                tbbtdins(info->chk_tree, chkptr , chk_key);   
-
-#ifdef UNUSED
-                /* assign over new chk */
-                chk_rec = chkptr;
-#endif /* UNUSED */
-
-                /* re-intialize ptrs to allow for error-failure check */
-                chkptr = NULL;
-                chk_key = NULL;
-            }
-#ifdef UNUSED
-          else /* already in TBBT tree */
-              chk_rec = (CHUNK_REC *) entry->data; /* get file entry from node */
-#endif /* UNUSED */
-
-          /* would be nice to get Chunk record from TBBT based on chunk number 
+          /* find chunk record in the chunk index, or make a new one */
+          if (HMCIfind_chunk(info, chunk_num, &chk_rec) == FAIL)
+              HE_REPORT_GOTO("failed to look chunk record up", FAIL);
+          if (chk_rec == NULL 
+              && HMCInew_chunk(info, chunk_num, origin) == NULL)
+              HE_REPORT_GOTO("failed to make chunk record", FAIL);
+
+          /* would be nice to get Chunk record from the index based on chunk number 
              and then get chunk data base on chunk vdata number but
              currently the chunk calculations return chunk 
              numbers and not Vdata record numbers. 
@@ -3725,15 +5011,7 @@ HMCwriteChunk(int32 access_id,  /* IN: access aid to mess with */
   done:
     if(ret_value == FAIL)   
       { /* Error condition cleanup */
-          /* check chunk ptrs */
-          if (chkptr != NULL)
-            {
-                if (chkptr->origin != NULL)
-                    HDfree(chkptr->origin);
-                HDfree(chkptr);
-            }
-          if (chk_key != NULL)
-              HDfree(chk_key);
+
       } /* end if */
 
     /* Normal function cleanup */
@@ -3756,6 +5034,9 @@ DESCRIPTION
 
    The chunks are marked as dirty before being returned to the cache.
 
+   Chunks which are written whole, and lie in one piece in the user's
+   buffer, are written straight from it instead if they are not cached.
+
 RETURNS
    The number of bytes written or FAIL on error
 AUTHOR
@@ -3770,12 +5051,9 @@ HMCPwrite(accrec_t * access_rec, /* IN: access record to mess with */
     filerec_t   *file_rec = NULL; /* file record */
     chunkinfo_t *info     = NULL; /* chunked element information record */
 #ifdef UNUSED
-    CHUNK_REC   *chk_rec  = NULL; /* current chunk */
     uint8       *data     = NULL; /* data buffer */
-    TBBT_NODE   *entry    = NULL; /* node off of  chunk tree */
 #endif /* UNUSED */
-    CHUNK_REC   *chkptr   = NULL; /* Chunk record to inserted in TBBT  */
-    int32       *chk_key  = NULL; /* Chunk recored key for insertion in TBBT */
+    CHUNK_REC   *chk_rec  = NULL; /* current chunk */
     const uint8 *bptr     = NULL; /* data buffer pointer */
     void        *chk_data = NULL; /* chunk data */
     uint8       *chk_dptr = NULL; /* chunk data pointer */
@@ -3785,6 +5063,9 @@ HMCPwrite(accrec_t * access_rec, /* IN: access record to mess with */
     int32       write_seek = 0;   /* next write seek */
     int32       chunk_size = 0;   /* chunk size */
     int32       chunk_num = 0;    /* chunk number */
+    int32       direct_nums[HMC_READ_BATCH]; /* chunks to write straight from datap */
+    void        *direct_bufs[HMC_READ_BATCH]; /* where they are */
+    int32       ndirect = 0;      /* number of chunks to write straight out */
     int32       ret_value = SUCCEED;
     intn        k;                  /* loop index */
 #ifdef CHK_DEBUG_4
@@ -3844,111 +5125,97 @@ HMCPwrite(accrec_t * access_rec, /* IN: access record to mess with */
                                     write_len,bytes_written,
                                     info->seek_chunk_indices,
                                     info->seek_pos_chunk,info->ddims);
+          calculate_whole_chunk(&chunk_size,info->chunk_size * info->nt_size,info->ndims,
+                                write_len,bytes_written,
+                                info->seek_chunk_indices,
+                                info->seek_pos_chunk,info->ddims);
 
 #ifdef CHK_DEBUG_4
           printf("    writing chunk(%d) of %d bytes ->\n", chunk_num, chunk_size);
 #endif
 
-          /* find chunk record in TBBT */
-          if (tbbtdfind(info->chk_tree, &chunk_num, NULL) == NULL)
-            { /* not in tree */
-                
-                /* so create a new chunk record */
-                /* Allocate space for a chunk record */
-                if ((chkptr = (CHUNK_REC *) HDmalloc(sizeof(CHUNK_REC))) == NULL)
-                    HGOTO_ERROR(DFE_NOSPACE, FAIL);
+          /* find chunk record in the chunk index, or make a new one */
+          if (HMCIfind_chunk(info, chunk_num, &chk_rec) == FAIL)
+              HE_REPORT_GOTO("failed to look chunk record up", FAIL);
+          if (chk_rec == NULL 
+              && HMCInew_chunk(info, chunk_num, info->seek_chunk_indices) == NULL)
+              HE_REPORT_GOTO("failed to make chunk record", FAIL);
 
-                /* Allocate space for a origin in chunk record */
-                if ((chkptr->origin = (int32 *) HDmalloc((size_t)info->ndims*sizeof(int32))) == NULL)
-                    HGOTO_ERROR(DFE_NOSPACE, FAIL);
-
-                /* allocate space for key */
-                if ((chk_key = (int32 *)HDmalloc(sizeof(int32))) == NULL)
-                    HGOTO_ERROR(DFE_NOSPACE, FAIL);
-
-                /* Initialize chunk record */
-                chkptr->chk_tag = DFTAG_NULL;
-                chkptr->chk_ref = 0;
-#ifdef CHK_DEBUG_4
-                printf(" chktpr->chk_tag=%d, ",chkptr->chk_tag);
-                printf(" chktpr->chk_ref=%d, ",chkptr->chk_ref);
-#endif
-                /* Intialize chunk origins */
-                for (k = 0; k < info->ndims; k++)
-                      chkptr->origin[k] = info->seek_chunk_indices[k];
-#ifdef CHK_DEBUG_4
-                printf(" chkptr->origin = (");
-                for (k = 0; k < info->ndims; k++)
-                    printf("%d%s", chkptr->origin[k], k!= info->ndims-1 ? ",":NULL);
-                printf(")\n");
-#endif
-                /* set chunk record number to next Vdata record number */
-                chkptr->chk_vnum = info->num_recs++;
-
-                /* set key to chunk number */
-                chkptr->chunk_number = *chk_key = chunk_num;
-
-                /* add to TBBT tree based on chunk number as the key */
-                tbbtdins(info->chk_tree, chkptr , chk_key);   
-
-#ifdef UNUSED
-                /* assign over new chk */
-                chk_rec = chkptr;
-#endif /* UNUSED */
-
-                /* re-intialize ptrs to allow for error-failure check */
-                chkptr = NULL;
-                chk_key = NULL;
-            }
-#ifdef UNUSED
-          else /* already in TBBT tree */
-              chk_rec = (CHUNK_REC *) entry->data; /* get file entry from node */
-#endif /* UNUSED */
-
-          /* would be nice to get Chunk record from TBBT based on chunk number 
+          /* would be nice to get Chunk record from the index based on chunk number 
              and then get chunk data base on chunk vdata number but
              currently the chunk calculations return chunk 
              numbers and not Vdata record numbers. 
              This would reduce some overhead in the number of chunks
              dealt with in the cache */
-#ifdef CHK_DEBUG_4
-          printf("  getting chunk %d from cache\n",chunk_num);
-#endif
-          /* get chunk data from cache based on chunk number 
-             chunks in the cache start from 1 not 0 */
-          if ((chk_data = mcache_get(info->chk_cache, /* cache handle */
-                                              chunk_num+1,     /* chunk number */
-                                              0                /* flag: unused */)) 
-              == NULL)
-              HE_REPORT_GOTO("failed to find chunk record", FAIL);
-
-          chk_dptr = chk_data; /* set chunk data ptr */
-
           /* calculate position in chunk */
           calculate_seek_in_chunk(&write_seek,info->ndims,info->nt_size,
                                   info->seek_pos_chunk,
                                   info->ddims);
 
-          chk_dptr += write_seek; /* move to correct position in chunk */
+          /* a whole chunk, laid out as in the user's buffer, which is not
+             cached is written straight from the buffer, bypassing the cache;
+             such chunks are written out together (see HMCPchunkwritev()) */
+          if (write_seek == 0 && chunk_size == info->chunk_size * info->nt_size
+              && !mcache_cached(info->chk_cache, chunk_num+1))
+            {
+#ifdef CHK_DEBUG_4
+                printf("  writing chunk %d past the cache\n",chunk_num);
+#endif
+                if (ndirect == HMC_READ_BATCH)
+                  {
+                      if (HMCPchunkwritev(access_rec, ndirect, direct_nums, direct_bufs) == FAIL)
+                          HE_REPORT_GOTO("failed to write chunks", FAIL);
+                      ndirect = 0;
+                  }
+                direct_nums[ndirect] = chunk_num;
+                direct_bufs[ndirect++] = (void *) bptr;
+            }
+          else
+            {
+#ifdef CHK_DEBUG_4
+                printf("  getting chunk %d from cache\n",chunk_num);
+#endif
+                /* a chunk waiting to be written must be in the file first */
+                for (k = 0; k < ndirect && direct_nums[k] != chunk_num; k++)
+                    ;
+                if (k < ndirect)
+                  {
+                      if (HMCPchunkwritev(access_rec, ndirect, direct_nums, direct_bufs) == FAIL)
+                          HE_REPORT_GOTO("failed to write chunks", FAIL);
+                      ndirect = 0;
+                  }
+
+                /* get chunk data from cache based on chunk number 
+                   chunks in the cache start from 1 not 0 */
+                if ((chk_data = mcache_get(info->chk_cache, /* cache handle */
+                                           chunk_num+1,     /* chunk number */
+                                           0                /* flag: unused */)) 
+                    == NULL)
+                    HE_REPORT_GOTO("failed to find chunk record", FAIL);
+
+                chk_dptr = chk_data; /* set chunk data ptr */
+
+                chk_dptr += write_seek; /* move to correct position in chunk */
 
 #ifdef CHK_DEBUG_4
-          fprintf(stderr,"  write pos in chunk (%d) is %d bytes\n", chunk_num, write_seek);
+                fprintf(stderr,"  write pos in chunk (%d) is %d bytes\n", chunk_num, write_seek);
 #endif
-          /* copy data from users buffer to chunk */
-          HDmemcpy(chk_dptr, bptr, chunk_size);        
+                /* copy data from users buffer to chunk */
+                HDmemcpy(chk_dptr, bptr, chunk_size);        
 
 #ifdef CHK_DEBUG_10
-          printf(" chk_dptr={");
-          for (i = 0; i < chunk_size; i++)
-              printf("%d,",(uint8)*((uint8 *)(chk_dptr)+i));
-          printf("}\n");
+                printf(" chk_dptr={");
+                for (i = 0; i < chunk_size; i++)
+                    printf("%d,",(uint8)*((uint8 *)(chk_dptr)+i));
+                printf("}\n");
 #endif
-          /* put chunk back to cache as DIRTY */
-          if (mcache_put(info->chk_cache, /* cache handle */
-                         chk_data,        /* whole data chunk */
-                         MCACHE_DIRTY     /* flag:  DIRTY */) 
-              == FAIL)
-              HE_REPORT_GOTO("failed to put chunk back in cache", FAIL);
+                /* put chunk back to cache as DIRTY */
+                if (mcache_put(info->chk_cache, /* cache handle */
+                               chk_data,        /* whole data chunk */
+                               MCACHE_DIRTY     /* flag:  DIRTY */) 
+                    == FAIL)
+                    HE_REPORT_GOTO("failed to put chunk back in cache", FAIL);
+            }
 
           /* increment buffer pointer */
           bptr += chunk_size;
@@ -3972,6 +5239,10 @@ HMCPwrite(accrec_t * access_rec, /* IN: access record to mess with */
                                      info->seek_pos_chunk,info->ddims);
       } /* end while "bytes_written" */
 
+    /* write out the chunks left */
+    if (ndirect > 0 && HMCPchunkwritev(access_rec, ndirect, direct_nums, direct_bufs) == FAIL)
+        HE_REPORT_GOTO("failed to write chunks", FAIL);
+
     /* update access record with bytes written */
     access_rec->posn += bytes_written; 
 
@@ -3980,15 +5251,7 @@ HMCPwrite(accrec_t * access_rec, /* IN: access record to mess with */
   done:
     if(ret_value == FAIL)   
       { /* Error condition cleanup */
-          /* check chunk ptrs */
-          if (chkptr != NULL)
-            {
-                if (chkptr->origin != NULL)
-                    HDfree(chkptr->origin);
-                HDfree(chkptr);
-            }
-          if (chk_key != NULL)
-              HDfree(chk_key);
+
       } /* end if */
 
     /* Normal function cleanup */
@@ -3999,6 +5262,598 @@ HMCPwrite(accrec_t * access_rec, /* IN: access record to mess with */
     return ret_value;
 }   /* HMCPwrite */
 
+/* -------------------------------------------------------------------------
+NAME
+    HMCIslab_whole -- see whether a chunk lies whole in a slab
+DESCRIPTION
+    Checks whether the chunk at 'chunk_idx' lies whole in the slab
+    'start', 'count' of the element, and if it does, whether it also
+    lies in one piece in the user's buffer, which holds the slab.
+RETURNS
+    TRUE/FALSE, '*buf_off' is set to the offset of the chunk in the
+    user's buffer, or -1 if it is not in one piece there.
+---------------------------------------------------------------------------*/
+PRIVATE intn
+HMCIslab_whole(chunkinfo_t *info,      /* IN: chunked element information */
+               const int32 *chunk_idx, /* IN: chunk coordinates */
+               const int32 *start,     /* IN: start of the slab */
+               const int32 *count,     /* IN: size of the slab */
+               int32 *buf_off          /* OUT: offset of the chunk in buffer */)
+{
+    int32 c0;        /* first element of the chunk along a dimension */
+    int32 stride;    /* elements between slab rows along a dimension */
+    int32 j;
+
+    *buf_off = -1;
+    for (j = 0; j < info->ndims; j++)
+      {
+          c0 = chunk_idx[j] * info->ddims[j].chunk_length;
+          if (c0 < start[j] 
+              || c0 + info->ddims[j].chunk_length > start[j] + count[j])
+              return FALSE;
+      }
+
+    /* in one piece if the slab is as wide as the chunk but for the
+       slowest dimension */
+    for (j = 1; j < info->ndims; j++)
+        if (count[j] != info->ddims[j].chunk_length)
+            return TRUE;
+
+    *buf_off = 0;
+    for (j = info->ndims - 1, stride = 1; j >= 0; j--)
+      {
+          *buf_off += (chunk_idx[j] * info->ddims[j].chunk_length - start[j]) * stride;
+          stride *= count[j];
+      }
+    *buf_off *= info->nt_size;
+    return TRUE;
+} /* HMCIslab_whole() */
+
+/* -------------------------------------------------------------------------
+NAME
+    HMCIcopy_slab -- copy the part of a slab in a chunk
+DESCRIPTION
+    Copies the part of the slab 'start', 'count' which falls in the
+    chunk at 'chunk_idx' between the chunk and the user's buffer, which
+    holds the slab.  The part is copied in blocks as large as the chunk
+    and the buffer both hold in one piece: a row along the fastest
+    dimension, or several dimensions at once where the slab is as wide
+    as the chunk in them, stepping through the chunk and the buffer
+    at their own strides between blocks.
+RETURNS
+    Nothing
+---------------------------------------------------------------------------*/
+PRIVATE void
+HMCIcopy_slab(chunkinfo_t *info,      /* IN: chunked element information */
+              const int32 *chunk_idx, /* IN: chunk coordinates */
+              const int32 *start,     /* IN: start of the slab */
+              const int32 *count,     /* IN: size of the slab */
+              uint8 *chk_data,        /* IN/OUT: the chunk */
+              uint8 *buf,             /* IN/OUT: the user's buffer */
+              intn to_chunk           /* IN: TRUE to copy into the chunk */)
+{
+    int32 ext[H4_MAX_VAR_DIMS];        /* elements of the part along each dim */
+    int32 pos[H4_MAX_VAR_DIMS];        /* block being copied */
+    int32 chk_stride[H4_MAX_VAR_DIMS]; /* elements between rows of the chunk */
+    int32 buf_stride[H4_MAX_VAR_DIMS]; /* elements between rows of the slab */
+    int32 ndims = info->ndims;
+    int32 c0;        /* first element of the chunk along a dimension */
+    int32 lo;        /* first element of the part along a dimension */
+    int32 chk_off;   /* offset of the block in the chunk */
+    int32 buf_off;   /* offset of the block in the buffer */
+    int32 block;     /* size of a block */
+    int32 inner;     /* slowest dimension a block spans */
+    int32 j;
+
+    chk_stride[ndims - 1] = 1;
+    buf_stride[ndims - 1] = 1;
+    for (j = ndims - 2; j >= 0; j--)
+      {
+          chk_stride[j] = chk_stride[j + 1] * info->ddims[j + 1].chunk_length;
+          buf_stride[j] = buf_stride[j + 1] * count[j + 1];
+      }
+
+    chk_off = 0;
+    buf_off = 0;
+    for (j = 0; j < ndims; j++)
+      {
+          c0 = chunk_idx[j] * info->ddims[j].chunk_length;
+          lo = MAX(start[j], c0);
+          ext[j] = MIN(start[j] + count[j], c0 + info->ddims[j].chunk_length) - lo;
+          chk_off += (lo - c0) * chk_stride[j];
+          buf_off += (lo - start[j]) * buf_stride[j];
+          pos[j] = 0;
+      }
+
+    /* merge the fastest dimensions in which the part spans the chunk
+       and the slab both */
+    inner = ndims - 1;
+    block = ext[inner];
+    while (inner > 0 && ext[inner] == info->ddims[inner].chunk_length
+           && ext[inner] == count[inner])
+      {
+          inner--;
+          block *= ext[inner];
+      }
+    block *= info->nt_size;
+
+    for (;;)
+      {
+          if (to_chunk)
+              HDmemcpy(chk_data + chk_off * info->nt_size, 
+                       buf + buf_off * info->nt_size, block);
+          else
+              HDmemcpy(buf + buf_off * info->nt_size, 
+                       chk_data + chk_off * info->nt_size, block);
+
+          /* on to the next block */
+          for (j = inner - 1; j >= 0; j--)
+            {
+                chk_off += chk_stride[j];
+                buf_off += buf_stride[j];
+                if (++pos[j] < ext[j])
+                    break;
+                chk_off -= ext[j] * chk_stride[j];
+                buf_off -= ext[j] * buf_stride[j];
+                pos[j] = 0;
+            }
+          if (j < 0)
+              break;
+      }
+} /* HMCIcopy_slab() */
+
+/* -------------------------------------------------------------------------
+NAME
+    HMCIslab -- read or write a slab of a chunked element
+DESCRIPTION
+    Works out the chunks the slab 'start', 'count' of the element
+    covers once, from the chunk grid, and goes through them in chunk
+    number order, copying the part of the slab each one holds with
+    HMCIcopy_slab().  Each chunk is got from the cache once, however
+    many rows of the slab it holds, and the chunks are got as many at
+    a time as HMCPread() gets them, so that the ones not cached are
+    read in together.  Chunks lying whole in the slab which are not
+    cached do not go through the cache, they are read in or written
+    out together, straight from or into the user's buffer when they
+    lie in one piece there, through a buffer of their own otherwise.
+
+    The slab is laid out in the user's buffer as an array of 'count',
+    fastest dimension last.  The seek position of the access record is
+    not changed.
+
+    If 'chunk_map' is given, it is set to TRUE for each chunk of the
+    slab which has been written, which has a record in the chunk
+    table, and to FALSE for the others, in chunk number order.  Reads
+    with 'skip_empty' leave the chunks never written out, without
+    filling their part of the slab with the fill value.
+RETURNS
+    The number of bytes read or written or FAIL on error
+---------------------------------------------------------------------------*/
+PRIVATE int32
+HMCIslab(accrec_t *access_rec, /* IN: access record to mess with */
+         const int32 *start,   /* IN: start of the slab */
+         const int32 *count,   /* IN: size of the slab */
+         uint8 *datap,         /* IN/OUT: buffer for data */
+         intn write_slab,      /* IN: TRUE to write the slab */
+         uint8 *chunk_map,     /* OUT: which chunks were written, or NULL */
+         intn skip_empty       /* IN: TRUE to leave those not written out */)
+{
+    CONSTR(FUNC, "HMCIslab");    /* for HERROR */
+    chunkinfo_t *info = NULL;    /* chunked element information record */
+    CHUNK_REC   *chk_rec = NULL; /* current chunk */
+    int32       chunk_idx[H4_MAX_VAR_DIMS]; /* coordinates of the next chunk */
+    int32       idx[H4_MAX_VAR_DIMS];       /* coordinates of a chunk got */
+    int32       first[H4_MAX_VAR_DIMS];     /* first chunk of the slab */
+    int32       last[H4_MAX_VAR_DIMS];      /* last chunk of the slab */
+    int32       chunk_pgnos[HMC_READ_BATCH]; /* chunks to get from the cache */
+    void        *chk_pages[HMC_READ_BATCH];  /* their data */
+    int32       nchunks;         /* number of chunks to get */
+    int32       direct_nums[HMC_READ_BATCH]; /* chunks read or written whole */
+    void        *direct_bufs[HMC_READ_BATCH]; /* where they are */
+    intn        direct_copy[HMC_READ_BATCH]; /* TRUE if in their own buffer */
+    int32       ndirect;         /* number of chunks read or written whole */
+    int32       ncopy;           /* number of them in their own buffer */
+    uint8       *copy_buf = NULL; /* buffer of those chunks */
+    int32       chunk_len;       /* size of a whole chunk */
+    int32       max_chunks;      /* most chunks to get at once */
+    int32       chunk_num;       /* chunk number */
+    int32       buf_off;         /* offset of a whole chunk in datap */
+    int32       length;          /* size of the slab in bytes */
+    int32       nmap = 0;        /* chunks in chunk_map */
+    intn        more;            /* TRUE while chunks are left */
+    intn        j, k;
+    int32       ret_value = SUCCEED;
+
+    info = (chunkinfo_t *) (access_rec->special_info);
+    if (info->ndims > H4_MAX_VAR_DIMS)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* check the slab against the element */
+    length = info->nt_size;
+    for (j = 0; j < info->ndims; j++)
+      {
+          if (start[j] < 0 || count[j] < 0 
+              || start[j] + count[j] > info->ddims[j].dim_length)
+              HGOTO_ERROR(DFE_RANGE, FAIL);
+          length *= count[j];
+      }
+    if (length == 0)
+        HGOTO_DONE(0);
+
+    /* chunks of the slab along each dimension */
+    for (j = 0; j < info->ndims; j++)
+      {
+          first[j] = start[j] / info->ddims[j].chunk_length;
+          last[j] = (start[j] + count[j] - 1) / info->ddims[j].chunk_length;
+          chunk_idx[j] = first[j];
+      }
+
+    /* the chunks got at once must all fit in the cache */
+    max_chunks = mcache_get_maxcache(info->chk_cache);
+    if (max_chunks > HMC_READ_BATCH)
+        max_chunks = HMC_READ_BATCH;
+    else if (max_chunks < 1)
+        max_chunks = 1;
+
+    chunk_len = info->chunk_size * info->nt_size;
+
+    more = TRUE;
+    while (more)
+      {
+          /* work out the next chunks, whole ones not cached apart */
+          nchunks = 0;
+          ndirect = 0;
+          ncopy = 0;
+          while (more && nchunks + ndirect < max_chunks)
+            {
+                calculate_chunk_num(&chunk_num, info->ndims, chunk_idx, info->ddims);
+
+                /* chunks with no record have never been written */
+                if (write_slab || chunk_map != NULL)
+                  {
+                      if (HMCIfind_chunk(info, chunk_num, &chk_rec) == FAIL)
+                          HE_REPORT_GOTO("failed to look chunk record up", FAIL);
+                  }
+                if (chunk_map != NULL)
+                    chunk_map[nmap++] = (uint8) (chk_rec != NULL);
+
+                /* chunks written to need a record */
+                if (write_slab && chk_rec == NULL 
+                    && HMCInew_chunk(info, chunk_num, chunk_idx) == NULL)
+                    HE_REPORT_GOTO("failed to make chunk record", FAIL);
+
+                if (skip_empty && chk_rec == NULL)
+                    ; /* left out of the read */
+                else if (HMCIslab_whole(info, chunk_idx, start, count, &buf_off)
+                    && !mcache_cached(info->chk_cache, chunk_num+1))
+                  {
+                      direct_nums[ndirect] = chunk_num;
+                      direct_copy[ndirect] = (buf_off < 0);
+                      direct_bufs[ndirect++] = (buf_off < 0) ? NULL : datap + buf_off;
+                      if (buf_off < 0)
+                          ncopy++;
+                  }
+                else
+                    chunk_pgnos[nchunks++] = chunk_num+1;
+
+                /* on to the next chunk of the slab */
+                for (j = info->ndims - 1; j >= 0; j--)
+                  {
+                      if (++chunk_idx[j] <= last[j])
+                          break;
+                      chunk_idx[j] = first[j];
+                  }
+                more = (j >= 0);
+            } /* end while "more" */
+
+          /* whole chunks not in one piece in the user's buffer go
+             through a buffer of their own */
+          if (ncopy > 0)
+            {
+                if ((copy_buf = (uint8 *) HDmalloc(ncopy * chunk_len)) == NULL)
+                    HGOTO_ERROR(DFE_NOSPACE, FAIL);
+                for (k = 0, j = 0; k < ndirect; k++)
+                    if (direct_copy[k])
+                      {
+                          direct_bufs[k] = copy_buf + (j++) * chunk_len;
+                          if (write_slab)
+                            {
+                                calculate_chunk_idx(idx, info->ndims, direct_nums[k], 
+                                                    info->ddims);
+                                HMCIcopy_slab(info, idx, start, count,
+                                              direct_bufs[k], datap, TRUE);
+                            }
+                      }
+            }
+
+          /* read in or write out the whole chunks together */
+          if (ndirect > 0)
+            {
+                if (write_slab)
+                  {
+                      if (HMCPchunkwritev(access_rec, ndirect, direct_nums, direct_bufs) == FAIL)
+                          HE_REPORT_GOTO("failed to write chunks", FAIL);
+                  }
+                else
+                  {
+                      if (HMCPchunkreadv(access_rec, ndirect, direct_nums, direct_bufs) == FAIL)
+                          HE_REPORT_GOTO("failed to read chunks", FAIL);
+                      for (k = 0; k < ndirect; k++)
+                          if (direct_copy[k])
+                            {
+                                calculate_chunk_idx(idx, info->ndims, direct_nums[k], 
+                                                    info->ddims);
+                                HMCIcopy_slab(info, idx, start, count,
+                                              direct_bufs[k], datap, FALSE);
+                            }
+                  }
+            }
+          if (copy_buf != NULL)
+            {
+                HDfree(copy_buf);
+                copy_buf = NULL;
+            }
+
+          /* get the other chunks from the cache */
+          if (nchunks == 1)
+            {
+                if ((chk_pages[0] = mcache_get(info->chk_cache, /* cache handle */
+                                               chunk_pgnos[0],   /* chunk number */
+                                               0                 /* flag: unused */)) 
+                    == NULL)
+                    HE_REPORT_GOTO("failed to find chunk record", FAIL);
+            }
+          else if (nchunks > 1 && mcache_getv(info->chk_cache, /* cache handle */
+                               nchunks,          /* number of chunks */
+                               chunk_pgnos,      /* chunk numbers */
+                               chk_pages         /* OUT: chunk data */) 
+                   == FAIL)
+              HE_REPORT_GOTO("failed to find chunk records", FAIL);
+
+          for (k = 0; k < nchunks; k++)
+            {
+                calculate_chunk_idx(idx, info->ndims, chunk_pgnos[k]-1, info->ddims);
+                HMCIcopy_slab(info, idx, start, count, chk_pages[k], datap, write_slab);
+            }
+
+          /* put chunks back to cache, dirty if written to */
+          for (k = 0; k < nchunks; k++)
+              if (mcache_put(info->chk_cache, /* cache handle */
+                             chk_pages[k],    /* whole data chunk */
+                             write_slab ? MCACHE_DIRTY : 0 /* flag */) 
+                  == FAIL)
+                  ret_value = FAIL;
+          if (ret_value == FAIL)
+              HE_REPORT_GOTO("failed to put chunk back in cache", FAIL);
+      } /* end while "more" */
+
+    ret_value = length;
+
+  done:
+    if(ret_value == FAIL)   
+      { /* Error condition cleanup */
+          if (copy_buf != NULL)
+              HDfree(copy_buf);
+      } /* end if */
+
+    /* Normal function cleanup */
+    return ret_value;
+} /* HMCIslab() */
+
+/* ------------------------------- HMCreadSlab -----------------------------
+NAME
+   HMCreadSlab -- read a slab of a chunked element
+
+DESCRIPTION
+   Read the slab of 'count' elements from 'start' of a chunked
+   element, laid out in 'datap' as an array of 'count', fastest
+   dimension last.  
+
+   Unlike reading the slab one contiguous run at a time through Hread,
+   each chunk the slab covers is got once and the part of the slab in
+   it copied over in as few blocks as can be (see HMCIslab()), which
+   counts for reads whose fastest dimension is narrow.  The seek
+   position of the access id is not changed.
+
+RETURNS
+   The number of bytes read or FAIL on error
+---------------------------------------------------------------------------*/
+int32
+HMCreadSlab(int32 access_id,    /* IN: access aid to mess with */
+            const int32 *start, /* IN: start of the slab */
+            const int32 *count, /* IN: size of the slab */
+            VOID *datap         /* OUT: buffer for data */)
+{
+    HTS_READ_LOCK(access_id);
+    CONSTR(FUNC, "HMCreadSlab");  /* for HERROR */
+    accrec_t    *access_rec = NULL; /* access record */
+    filerec_t   *file_rec   = NULL; /* file record */
+    int32       ret_value = SUCCEED;
+
+    /* Check args */
+    access_rec = HAatom_object(access_id);
+    if (access_rec == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    if (start == NULL || count == NULL || datap == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* validate file records */
+    file_rec =  HAatom_object(access_rec->file_id);
+    if (BADFREC(file_rec))
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    /* can read from this file? */
+    if (!(file_rec->access & DFACC_READ))
+        HGOTO_ERROR(DFE_DENIED, FAIL);
+
+    /* since this routine can be called by the user,
+       need to check if this access id is special CHUNKED */
+    if (access_rec->special != SPECIAL_CHUNKED)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    ret_value = HMCIslab(access_rec, start, count, (uint8 *) datap, FALSE,
+                         NULL, FALSE);
+
+  done:
+    if(ret_value == FAIL)   
+      { /* Error condition cleanup */
+      } /* end if */
+
+    /* Normal function cleanup */
+    return ret_value;
+} /* HMCreadSlab() */
+
+/* ------------------------------- HMCreadSlabMap --------------------------
+NAME
+   HMCreadSlabMap -- read a slab of a chunked element, telling which
+                     chunks of it have been written
+
+DESCRIPTION
+   Read the slab of 'count' elements from 'start' of a chunked element
+   as HMCreadSlab() does, and set 'chunk_map' to TRUE for each chunk of
+   the slab which has been written and to FALSE for those which never
+   were.  The map has one entry for each chunk the slab covers, in
+   chunk number order: along each dimension the slab covers the chunks
+   start/chunk_length to (start+count-1)/chunk_length.
+
+   Unless 'fill_empty' is TRUE, the chunks never written are not read
+   at all, their part of the slab in 'datap' is left as it is instead
+   of being filled with the fill value.  Reading sparse elements that
+   way costs little for the chunks left out.
+
+RETURNS
+   The number of chunks of the slab which have been written or FAIL
+   on error
+---------------------------------------------------------------------------*/
+int32
+HMCreadSlabMap(int32 access_id,    /* IN: access aid to mess with */
+               const int32 *start, /* IN: start of the slab */
+               const int32 *count, /* IN: size of the slab */
+               VOID *datap,        /* OUT: buffer for data */
+               uint8 *chunk_map,   /* OUT: TRUE for chunks written */
+               intn fill_empty     /* IN: TRUE to fill chunks not written */)
+{
+    HTS_READ_LOCK(access_id);
+    CONSTR(FUNC, "HMCreadSlabMap");  /* for HERROR */
+    accrec_t    *access_rec = NULL; /* access record */
+    filerec_t   *file_rec   = NULL; /* file record */
+    chunkinfo_t *info       = NULL; /* chunked element information record */
+    int32       nmap;               /* number of chunks of the slab */
+    int32       i;
+    int32       ret_value = SUCCEED;
+
+    /* Check args */
+    access_rec = HAatom_object(access_id);
+    if (access_rec == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    if (start == NULL || count == NULL || datap == NULL || chunk_map == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* validate file records */
+    file_rec =  HAatom_object(access_rec->file_id);
+    if (BADFREC(file_rec))
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    /* can read from this file? */
+    if (!(file_rec->access & DFACC_READ))
+        HGOTO_ERROR(DFE_DENIED, FAIL);
+
+    /* since this routine can be called by the user,
+       need to check if this access id is special CHUNKED */
+    if (access_rec->special != SPECIAL_CHUNKED)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    if (HMCIslab(access_rec, start, count, (uint8 *) datap, FALSE,
+                 chunk_map, !fill_empty) == FAIL)
+        HGOTO_ERROR(DFE_READERROR, FAIL);
+
+    /* count the chunks written */
+    info = (chunkinfo_t *) (access_rec->special_info);
+    for (i = 0, nmap = 1; i < info->ndims; i++)
+        nmap *= (count[i] == 0) ? 0 : (start[i] + count[i] - 1) / info->ddims[i].chunk_length
+                                       - start[i] / info->ddims[i].chunk_length + 1;
+    ret_value = 0;
+    for (i = 0; i < nmap; i++)
+        if (chunk_map[i])
+            ret_value++;
+
+  done:
+    if(ret_value == FAIL)   
+      { /* Error condition cleanup */
+      } /* end if */
+
+    /* Normal function cleanup */
+    return ret_value;
+} /* HMCreadSlabMap() */
+
+/* ------------------------------- HMCwriteSlab ----------------------------
+NAME
+   HMCwriteSlab -- write out a slab of a chunked element
+
+DESCRIPTION
+   Write out the slab of 'count' elements from 'start' of a chunked
+   element, laid out in 'datap' as an array of 'count', fastest
+   dimension last.  
+
+   As HMCreadSlab() does, each chunk the slab covers is got once, and
+   marked dirty after the part of the slab in it is copied in; chunks
+   lying whole in the slab which are not cached are written out
+   together without being read in.  The seek position of the access id
+   is not changed.
+
+RETURNS
+   The number of bytes written or FAIL on error
+---------------------------------------------------------------------------*/
+int32
+HMCwriteSlab(int32 access_id,    /* IN: access aid to mess with */
+             const int32 *start, /* IN: start of the slab */
+             const int32 *count, /* IN: size of the slab */
+             const VOID *datap   /* IN: buffer for data */)
+{
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
+    CONSTR(FUNC, "HMCwriteSlab");  /* for HERROR */
+    accrec_t    *access_rec = NULL; /* access record */
+    filerec_t   *file_rec   = NULL; /* file record */
+    int32       ret_value = SUCCEED;
+
+    /* Check args */
+    access_rec = HAatom_object(access_id);
+    if (access_rec == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    if (start == NULL || count == NULL || datap == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* validate file records */
+    file_rec =  HAatom_object(access_rec->file_id);
+    if (BADFREC(file_rec))
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    /* can write in this file? */
+    if (!(file_rec->access & DFACC_WRITE))
+        HGOTO_ERROR(DFE_DENIED, FAIL);
+
+    /* since this routine can be called by the user,
+       need to check if this access id is special CHUNKED */
+    if (access_rec->special != SPECIAL_CHUNKED)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* the slab is only copied from */
+    ret_value = HMCIslab(access_rec, start, count, (uint8 *) datap, TRUE,
+                         NULL, FALSE);
+
+  done:
+    if(ret_value == FAIL)   
+      { /* Error condition cleanup */
+      } /* end if */
+
+    /* Normal function cleanup */
+    return ret_value;
+} /* HMCwriteSlab() */
+
 
 /* ---------------------------------------------------------------------
 NAME
@@ -4055,6 +5910,11 @@ HMCPcloseAID(accrec_t *access_rec /* IN:  access record of file to close */)
                 mcache_close(info->chk_cache);
             } /* cache not empty */
 
+          /* the chunks are all out, give back the space kept for the
+             chunks never written */
+          if (HMCIunplace(access_rec) == FAIL)
+              HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
           /* clean up chunk table lists and info record here */
           /* Use Vxxx interface to end access to Vdata info */
           if (info->aid != FAIL)
@@ -4068,8 +5928,8 @@ HMCPcloseAID(accrec_t *access_rec /* IN:  access record of file to close */)
           if (Vend(access_rec->file_id) == FAIL)
               HGOTO_ERROR(DFE_CANTFLUSH, FAIL);
 
-          /* clean up chunk tree */
-          tbbtdfree(info->chk_tree, chkdestroynode, chkfreekey);
+          /* clean up chunk index */
+          HMCIindex_free(info);
 
           /* free up stuff in special info */
           if (info->ddims != NULL)
@@ -4347,3 +6207,25 @@ HMCPgetnumrecs(accrec_t* access_rec,	/* access record */
     return ret_value;
 }   /* HMCPgetnumrecs */
 
+/* -------------------------------------------------------------------------
+NAME
+   HMCPtableread -- check whether the chunk table has been read in
+DESCRIPTION
+   The chunk table of an element is read in through the Vdata interface
+   the first time a chunk is looked up, see HMCIfind_chunk().  The thread
+   safe library only reads elements without the API lock once it has
+   been.
+RETURNS
+   TRUE if the chunk table is in memory, FALSE if not or on error
+---------------------------------------------------------------------------*/
+intn
+HMCPtableread(accrec_t* access_rec	/* access record */)
+{
+    chunkinfo_t *chunk_info = NULL;	/* chunked element information record */
+
+    if (access_rec == NULL
+        || (chunk_info = (chunkinfo_t *) access_rec->special_info) == NULL)
+        return FALSE;
+    return (chunk_info->chk_nblock >= 0);
+}   /* HMCPtableread */
+
@@ -16,7 +16,7 @@
 /*-----------------------------------------------------------------------------
  * File:         hchunks.h
  * Purpose:      Header file for Chunked elements
- * Dependencies: tbbt.c mcache.c
+ * Dependencies: mcache.c
  * Invokes:      none
  * Contents:     Structures & definitions for chunked elements
  * Structure definitions: DIM_DEF, HCHUNK_DEF
@@ -36,7 +36,6 @@
 #ifdef   _HCHUNKS_MAIN_
 /* Private to 'hchunks.c' */
 
-#include "tbbt.h"   /* TBBT stuff */
 #include "mcache.h" /* caching routines */
 #include "hcomp.h"  /* For Compression */
 
@@ -152,10 +151,28 @@ typedef struct chunkinfo_t
                                         to the other chunks */
     int32       *seek_pos_chunk;     /* postion within the current chunk */
     int32       *seek_user_indices;  /* user postion within the element  */
-    TBBT_TREE   *chk_tree;    /* TBBT tree of all accessed table entries 
-                                 i.e. CHUNK_REC's read/written/modified */
+    CHUNK_REC   **chk_index;  /* records of the chunks in the table, by 
+                                 chunk number or hashed on it, see 
+                                 HMCIfind_chunk() */
+    int32       chk_nindex;   /* slots in chk_index */
+    int32       chk_nused;    /* records in chk_index */
+    intn        chk_hashed;   /* TRUE if chk_index is a hash table */
+    CHUNK_REC   *chk_block;   /* records read in from the table, in one block */
+    int32       chk_nblock;   /* number of them, -1 until the table is read */
     MCACHE      *chk_cache;   /* chunk cache */
     int32       num_recs;     /* number of Table(Vdata) records */
+
+    /* For reading ahead, see HMCPread() */
+    int32       ra_last;      /* chunk the last read ended in, -1 for none */
+    int32       ra_stride;    /* chunks between the last two reads */
+    intn        ra_count;     /* reads in a row with that stride */
+
+    /* For placing the chunks in the file, see HMCsetAlignment() */
+    int32       align;        /* chunks start on multiples of this, 0 for anywhere */
+    hdf_off_t   pre_off;      /* extent preallocated for the chunks, 0 for none */
+    int32       pre_len;      /* bytes from one chunk to the next in it */
+    int32       pre_nslots;   /* number of chunks it has room for */
+    uint8       *pre_used;    /* TRUE for the places in it given to a chunk */
 }
 chunkinfo_t;
 #endif /* _HCHUNKS_MAIN_ */
@@ -210,6 +227,19 @@ extern      "C"
          int32 maxcache,   /* IN: max number of pages to cache */
          int32 flags       /* IN: flags = 0, HMC_PAGEALL */);
 
+    HDFLIBAPI int32 HMCsetCachePolicy
+        (int32 access_id,  /* IN: access aid to mess with */
+         int32 maxbytes,   /* IN: max bytes to cache, 0 for no limit */
+         intn policy       /* IN: HDF_CACHE_LRU, HDF_CACHE_2Q, HDF_CACHE_CLOCK */);
+
+    HDFLIBAPI intn HMCsetSharedCache
+        (int32 maxbytes    /* IN: max bytes to cache, 0 to turn off */);
+
+    HDFLIBAPI intn HMCsetAlignment
+        (int32 access_id,  /* IN: access aid to mess with */
+         int32 alignment,  /* IN: chunks start on multiples of this, 0 for anywhere */
+         intn flags        /* IN: 0 or HDF_CHUNK_PREALLOC */);
+
     HDFLIBAPI int32 HMCwriteChunk
         (int32 access_id,  /* IN: access aid to mess with */
          int32 *origin,    /* IN: origin of chunk to write */
@@ -220,6 +250,26 @@ extern      "C"
          int32 *origin,    /* IN: origin of chunk to read */
          VOID *datap       /* IN: buffer for data */);
 
+    HDFLIBAPI int32 HMCwriteSlab
+        (int32 access_id,    /* IN: access aid to mess with */
+         const int32 *start, /* IN: start of the slab */
+         const int32 *count, /* IN: size of the slab */
+         const VOID *datap   /* IN: buffer for data */);
+
+    HDFLIBAPI int32 HMCreadSlab
+        (int32 access_id,    /* IN: access aid to mess with */
+         const int32 *start, /* IN: start of the slab */
+         const int32 *count, /* IN: size of the slab */
+         VOID *datap         /* OUT: buffer for data */);
+
+    HDFLIBAPI int32 HMCreadSlabMap
+        (int32 access_id,    /* IN: access aid to mess with */
+         const int32 *start, /* IN: start of the slab */
+         const int32 *count, /* IN: size of the slab */
+         VOID *datap,        /* OUT: buffer for data */
+         uint8 *chunk_map,   /* OUT: TRUE for chunks written */
+         intn fill_empty     /* IN: TRUE to fill chunks not written */);
+
     HDFLIBAPI int32 HMCPcloseAID
         (accrec_t *access_rec /* IN:  access record of file to close */);
 
@@ -227,15 +277,11 @@ extern      "C"
         (accrec_t * access_rec, /* IN:  access record to return info about */
          int32 *num_recs        /* OUT: length of the chunked elt */);
 
+    HDFLIBAPI intn HMCPtableread /* has to be here because used in hts.c */
+        (accrec_t * access_rec  /* IN:  access record of the chunked elt */);
+
 /* Library Private */
 #ifdef _HCHUNKS_MAIN_
-    /* tbbt.h helper routines */
-    intn chkcompare(void * k1,   /* IN: first key */
-           void * k2,   /* IN: second key */
-           intn cmparg /* IN: not sure? */);
-    void chkfreekey(void * key /*IN: chunk key */ );
-    void chkdestroynode(void * n /* IN: chunk record */ );
-
 /* Private to 'hchunks.c' */
     extern int32 HMCPstread
         (accrec_t *access_rec  /* IN: access record to fill in */);
@@ -253,6 +299,12 @@ extern      "C"
          int32 chunk_num,  /* IN: chunk to read */
          VOID  *datap      /* OUT: buffer for data */);
 
+    extern int32 HMCPchunkreadv
+        (VOID  *cookie,    /* IN: access record to mess with */
+         int32 nchunks,    /* IN: number of chunks to read */
+         const int32 *chunk_nums, /* IN: chunks to read */
+         VOID  **datap     /* OUT: buffers for data */);
+
     extern int32 HMCPread
         (accrec_t * access_rec, /* IN: access record to mess with */
          int32 length,          /* IN: number of bytes to read */
@@ -263,6 +315,12 @@ extern      "C"
          int32 chunk_num,  /* IN: chunk number */
          const VOID *datap /* IN: buffer for data */);
 
+    extern int32 HMCPchunkwritev
+        (VOID  *cookie,    /* IN: access record to mess with */
+         int32 nchunks,    /* IN: number of chunks to write */
+         const int32 *chunk_nums, /* IN: chunks to write */
+         VOID  **datap     /* IN: buffers for data */);
+
     extern int32 HMCPwrite
         (accrec_t *access_rec, /* IN: access record to mess with */
          int32 length,         /* IN: number of bytes to write */
@@ -112,6 +112,9 @@ PRIVATE int32 HCIinit_model
             (int16 acc_mode, comp_model_info_t * minfo, comp_model_t model_type,
              model_info * m_info);
 
+PRIVATE int32 HCIwritten
+            (accrec_t * access_rec, int32 length);
+
 /* comp_funcs -- struct of accessing functions for the compressed
    data element function modules.  The position of each function in
    the table is standard */
@@ -330,6 +333,7 @@ int32
 HCPquery_encode_header(comp_model_t model_type, model_info * m_info,
          comp_coder_t coder_type, comp_info * c_info)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "HCPquery_encode_header");    /* for HERROR */
     int32 coder_len=2;  /* # of bytes to encode coder information (2 minimum) */
     int32 model_len=2;  /* # of bytes to encode model information (2 minimum) */
@@ -411,6 +415,7 @@ intn
 HCPencode_header(uint8 *p, comp_model_t model_type, model_info * m_info,
          comp_coder_t coder_type, comp_info * c_info)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "HCPencode_header");    /* for HERROR */
     int32 ret_value=SUCCEED;
 
@@ -517,6 +522,7 @@ intn
 HCPdecode_header(uint8 *p, comp_model_t *model_type, model_info * m_info,
          comp_coder_t *coder_type, comp_info * c_info)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "HCPdecode_header");    /* for HERROR */
     uint16 m_type, c_type;
     int32 ret_value=SUCCEED;
@@ -810,6 +816,8 @@ HCcreate(int32 file_id, uint16 tag, uint16 ref, comp_model_t model_type,
          model_info * m_info, comp_coder_t coder_type,
          comp_info * c_info)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HCcreate");   /* for HERROR */
     filerec_t  *file_rec;       /* file record */
     accrec_t   *access_rec=NULL;/* access element record */
@@ -958,6 +966,8 @@ HCPgetcompress(int32 file_id,
               comp_coder_t* comp_type,  /* OUT: compression type */
               comp_info* c_info)        /* OUT: retrieved compression info */
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HCPgetcompress");   /* for HGOTO_ERROR */
     int32   aid=0, status;
     accrec_t*    access_rec=NULL;/* access element record */
@@ -1061,6 +1071,8 @@ HCPgetcompinfo(int32 file_id,
               comp_coder_t* comp_type,  /* OUT: compression type */
               comp_info* c_info)        /* OUT: retrieved compression info */
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HCPgetcompinfo");    /* for HGOTO_ERROR */
     int32   aid=0, status;
     accrec_t*    access_rec=NULL;    /* access element record */
@@ -1415,14 +1427,8 @@ HCPwrite(accrec_t * access_rec, int32 length, const void * data)
 {
     CONSTR(FUNC, "HCPwrite");   /* for HERROR */
     compinfo_t *info;           /* information on the special element */
-    uint8       local_ptbuf[4];
-    uint8       *p = local_ptbuf;  /* temp buffer ptr */
-    filerec_t  *file_rec;           /* file record */
     int32       ret_value;
 
-    /* convert file id to file record */
-    file_rec = HAatom_object(access_rec->file_id);
-
     /* validate length */
     if (length < 0)
         HRETURN_ERROR(DFE_RANGE, FAIL);
@@ -1432,10 +1438,57 @@ HCPwrite(accrec_t * access_rec, int32 length, const void * data)
         HGOTO_ERROR(DFE_MODEL, FAIL);
 
     /* update access record, and information about special element */
+    if (HCIwritten(access_rec, length) == FAIL)
+        HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+
+    ret_value=length;  /* return length of bytes written */
+
+done:
+    if(ret_value == FAIL)
+      { /* Error condition cleanup */
+
+      } /* end if */
+
+    /* Normal function cleanup */
+    return ret_value;
+}   /* end HCPwrite() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCIwritten -- Account for data written to a compressed data element.
+ USAGE
+    int32 HCIwritten(access_rec,length)
+    accrec_t *access_rec;   IN: the access record of the data element
+    int32 length;           IN: the number of bytes written
+ RETURNS
+    Returns SUCCEED or FAIL
+ DESCRIPTION
+    Moves the position of the access past the bytes written and, if the
+    element grew, rewrites its un-compressed length in the file.
+
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+PRIVATE int32
+HCIwritten(accrec_t * access_rec, int32 length)
+{
+    CONSTR(FUNC, "HCIwritten"); /* for HERROR */
+    compinfo_t *info;           /* information on the special element */
+    uint8       local_ptbuf[4];
+    uint8       *p = local_ptbuf;  /* temp buffer ptr */
+    filerec_t  *file_rec;           /* file record */
+    int32       ret_value = SUCCEED;
+
+    /* convert file id to file record */
+    file_rec = HAatom_object(access_rec->file_id);
+    info = (compinfo_t *) access_rec->special_info;
+
     access_rec->posn += length;
     if (access_rec->posn > info->length)
       {
-          int32       data_off;        /* offset of the data we are checking */
+          hdf_off_t   data_off;        /* offset of the data we are checking */
 
           /* get the info for the dataset */
           if(HTPinquire(access_rec->ddid,NULL,NULL,&data_off,NULL)==FAIL)
@@ -1451,8 +1504,6 @@ HCPwrite(accrec_t * access_rec, int32 length, const void * data)
               HGOTO_ERROR(DFE_WRITEERROR, FAIL);
       }     /* end if */
 
-    ret_value=length;  /* return length of bytes written */
-
 done:
     if(ret_value == FAIL)
       { /* Error condition cleanup */
@@ -1461,7 +1512,7 @@ done:
 
     /* Normal function cleanup */
     return ret_value;
-}   /* end HCPwrite() */
+}   /* end HCIwritten() */
 
 /*--------------------------------------------------------------------------
  NAME
@@ -1497,11 +1548,13 @@ HCPinquire(accrec_t * access_rec, int32 *pfile_id, uint16 *ptag,
     compinfo_t *info =          /* special information record */
         (compinfo_t *) access_rec->special_info;
     uint16 data_tag,data_ref;   /* tag/ref of the data we are checking */
-    int32       data_off;        /* offset of the data we are checking */
+    hdf_off_t   data_off;        /* offset of the data we are checking */
 
     /* get the info for the dataset */
     if(HTPinquire(access_rec->ddid,&data_tag,&data_ref,&data_off,NULL)==FAIL)
         HRETURN_ERROR(DFE_INTERNAL, FAIL);
+    if (poffset != NULL && data_off > MAX_OFFSET32)
+        HRETURN_ERROR(DFE_EXCEEDMAX, FAIL);
 
     /* fill in the variables if they are present */
     if (pfile_id != NULL)
@@ -1513,7 +1566,7 @@ HCPinquire(accrec_t * access_rec, int32 *pfile_id, uint16 *ptag,
     if (plength != NULL)
         *plength = info->length;
     if (poffset != NULL)
-        *poffset = data_off;
+        *poffset = (int32)data_off;
     if (pposn != NULL)
         *pposn = access_rec->posn;
     if (paccess != NULL)
@@ -1759,6 +1812,8 @@ HCPgetcomptype(int32 file_id,
               uint16 data_tag, uint16 data_ref, /* IN: tag/ref of element */
               comp_coder_t* comp_type)  /* OUT: compression type */
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HCPgetcomptype");    /* for HGOTO_ERROR */
     uint16      ctag, cref;    /* tag/ref for the special info header object */
     int32       data_id=FAIL;    /* temporary AID for header info */
@@ -1906,6 +1961,8 @@ HCPgetdatasize(int32 file_id,
               int32* comp_size,    /* OUT  - size of compressed data */
               int32* orig_size)    /* OUT  - size of non-compressed data */
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HCPgetdatasize");    /* for HGOTO_ERROR */
     uint8      *local_ptbuf=NULL, *p;
     uint16    sp_tag;        /* special tag */
@@ -2011,3 +2068,258 @@ done:
 
     return ret_value;
 } /* HCPgetdatasize */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCPreadcoded -- Read the compressed bytes of an element.
+ USAGE
+    intn HCPreadcoded(file_id, data_tag, data_ref, coder_type, orig_size,
+                      coded_size, coded)
+        int32 file_id;            IN: file id
+        uint16 data_tag;          IN: tag of the element
+        uint16 data_ref;          IN: ref of element
+        comp_coder_t *coder_type; OUT: coder the element is compressed with
+        int32 *orig_size;         OUT: size of non-compressed data
+        int32 *coded_size;        OUT: size of compressed data
+        uint8 **coded;            OUT: the compressed data
+ RETURNS
+    TRUE if the compressed data was read, FALSE if the element is not
+    compressed with a coder HCPdecode_coded knows or holds no data yet,
+    FAIL on error.
+ DESCRIPTION
+    Reads the special header of a compressed element and the compressed
+    data it points at into a buffer allocated with HDmalloc, which the
+    caller frees.  The data is left for HCPdecode_coded to decompress,
+    which need not run in the calling thread.
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+    Only called from inside the library, with the lock of the file held.
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+intn
+HCPreadcoded(int32 file_id, uint16 data_tag, uint16 data_ref,
+             comp_coder_t *coder_type, int32 *orig_size, int32 *coded_size,
+             uint8 **coded)
+{
+    CONSTR(FUNC, "HCPreadcoded");    /* for HGOTO_ERROR */
+    uint8      *local_ptbuf = NULL, *p;
+    uint8      *buf = NULL;     /* the compressed data */
+    uint16      sp_tag;         /* special tag */
+    uint16      comp_ref = 0;   /* ref of the compressed data */
+    atom_t      data_id = FAIL; /* dd ID of the element */
+    int32       aid = FAIL;     /* access id of the compressed data */
+    int32       len = 0;
+    comp_model_t model_type;    /* modeling type - dummy */
+    model_info  m_info;         /* modeling information - dummy */
+    comp_info   c_info;         /* coder information - dummy */
+    filerec_t  *file_rec;       /* file record */
+    intn        ret_value = FALSE;
+
+    /* convert file id to file rec and check for validity */
+    file_rec = HAatom_object(file_id);
+    if (BADFREC(file_rec) || coder_type == NULL || orig_size == NULL
+        || coded_size == NULL || coded == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    if ((data_id = HTPselect(file_rec, data_tag, data_ref)) == FAIL)
+        HGOTO_ERROR(DFE_CANTACCESS, FAIL);
+    if (HTPis_special(data_id) == FALSE)
+        HGOTO_DONE(FALSE);
+
+    /* Get the compression header (description record) */
+    if (HPread_drec(file_id, data_id, &local_ptbuf) <= 0)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    p = local_ptbuf;
+    INT16DECODE(p, sp_tag);
+    if (sp_tag != SPECIAL_COMP)
+        HGOTO_DONE(FALSE);
+    p = p + 2;          /* skip 2byte header_version */
+    INT32DECODE(p, *orig_size);    /* get _uncompressed_ data length */
+    UINT16DECODE(p, comp_ref);     /* get ref # of comp. data */
+    if (HCPdecode_header(p, &model_type, &m_info, coder_type, &c_info) == FAIL)
+        HGOTO_ERROR(DFE_COMPINFO, FAIL);
+    if (*orig_size == 0 || *coder_type != COMP_CODE_DEFLATE)
+        HGOTO_DONE(FALSE);
+
+    /* read the compressed data */
+    if ((aid = Hstartread(file_id, DFTAG_COMPRESSED, comp_ref)) == FAIL)
+        HGOTO_ERROR(DFE_DENIED, FAIL);
+    if (Hinquire(aid, NULL, NULL, NULL, &len, NULL, NULL, NULL, NULL) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    if ((buf = (uint8 *) HDmalloc(len > 0 ? (uint32) len : 1)) == NULL)
+        HGOTO_ERROR(DFE_NOSPACE, FAIL);
+    if (len > 0 && Hread(aid, len, buf) != len)
+        HGOTO_ERROR(DFE_READERROR, FAIL);
+
+    *coded_size = len;
+    *coded = buf;
+    buf = NULL;
+    ret_value = TRUE;
+
+done:
+    if(ret_value == FAIL)
+    { /* Error condition cleanup */
+    } /* end if */
+
+    /* Normal function cleanup */
+    if (aid != FAIL)
+        Hendaccess(aid);
+    if (data_id != FAIL)
+        HTPendaccess(data_id);
+    if (buf != NULL)
+        HDfree(buf);
+    if (local_ptbuf != NULL)
+        HDfree(local_ptbuf);
+
+    return ret_value;
+} /* HCPreadcoded */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCPdecode_coded -- Decompress data read by HCPreadcoded.
+ USAGE
+    int32 HCPdecode_coded(coder_type, coded, coded_size, buf, length)
+        comp_coder_t coder_type;  IN: coder the data is compressed with
+        const uint8 *coded;       IN: the compressed data
+        int32 coded_size;         IN: size of compressed data
+        uint8 *buf;               OUT: buffer for the decompressed data
+        int32 length;             IN: size of the buffer
+ RETURNS
+    The number of bytes decompressed or FAIL
+ DESCRIPTION
+    Decompresses a whole element held in memory.  Only the gzip
+    'deflate' coder can do that for now.
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+    Does not report errors, it is run by the worker threads (see hwork.c)
+    which must not call the library.
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+int32
+HCPdecode_coded(comp_coder_t coder_type, const uint8 *coded, int32 coded_size,
+                uint8 *buf, int32 length)
+{
+    switch (coder_type)
+      {
+          case COMP_CODE_DEFLATE:
+              return (HCPcdeflate_inflate(coded, coded_size, buf, length));
+
+          default:
+              return (FAIL);
+      }     /* end switch */
+} /* HCPdecode_coded */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCPencode_coded -- Compress an element in memory for HCPwritecoded.
+ USAGE
+    int32 HCPencode_coded(coder_type, c_info, buf, length, coded, coded_size)
+        comp_coder_t coder_type;  IN: coder to compress with
+        comp_info *c_info;        IN: settings of the coder
+        const uint8 *buf;         IN: the data of the whole element
+        int32 length;             IN: size of the data
+        uint8 *coded;             OUT: buffer for the compressed data
+        int32 coded_size;         IN: size of that buffer
+ RETURNS
+    The number of compressed bytes or FAIL
+ DESCRIPTION
+    Compresses a whole element held in memory, as writing it through
+    the coder would.  Only the gzip 'deflate' coder can do that for now,
+    a buffer of HCP_CODED_BOUND(length) bytes is large enough for it.
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+    Does not report errors, it is run by the worker threads (see hwork.c)
+    which must not call the library.
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+int32
+HCPencode_coded(comp_coder_t coder_type, const comp_info *c_info,
+                const uint8 *buf, int32 length, uint8 *coded, int32 coded_size)
+{
+    switch (coder_type)
+      {
+          case COMP_CODE_DEFLATE:
+              return (HCPcdeflate_deflate(buf, length, c_info->deflate.level,
+                                          coded, coded_size));
+
+          default:
+              return (FAIL);
+      }     /* end switch */
+} /* HCPencode_coded */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HCPwritecoded -- Write out an element compressed by HCPencode_coded.
+ USAGE
+    int32 HCPwritecoded(access_id, coder_type, coded, coded_size, length)
+        int32 access_id;          IN: access id of the compressed element
+        comp_coder_t coder_type;  IN: coder the data was compressed with
+        const uint8 *coded;       IN: the compressed data
+        int32 coded_size;         IN: size of compressed data
+        int32 length;             IN: size of the data before compression
+ RETURNS
+    The number of bytes written, i.e. 'length', or FAIL
+ DESCRIPTION
+    Writes a whole element, compressed beforehand, to a compressed data
+    element opened for writing at its beginning, as Hwrite would after
+    compressing it.  The element must be compressed with the same coder
+    through the stdio model.
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+    Only called from inside the library, with the lock of the file held.
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+int32
+HCPwritecoded(int32 access_id, comp_coder_t coder_type, const uint8 *coded,
+              int32 coded_size, int32 length)
+{
+    CONSTR(FUNC, "HCPwritecoded");   /* for HGOTO_ERROR */
+    accrec_t   *access_rec;     /* access record */
+    compinfo_t *info;           /* information on the special element */
+    int32       ret_value = SUCCEED;
+
+    access_rec = HAatom_object(access_id);
+    if (access_rec == NULL || access_rec->special != SPECIAL_COMP
+        || coded == NULL || coded_size < 0 || length < 0)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    info = (compinfo_t *) access_rec->special_info;
+    if (info->cinfo.coder_type != coder_type
+        || info->minfo.model_type != COMP_MODEL_STDIO)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* only the whole element */
+    if (access_rec->posn != 0)
+        HGOTO_ERROR(DFE_UNSUPPORTED, FAIL);
+
+    switch (coder_type)
+      {
+          case COMP_CODE_DEFLATE:
+              if (HCPcdeflate_writecoded(access_rec, coded, coded_size, length) == FAIL)
+                  HGOTO_ERROR(DFE_CENCODE, FAIL);
+              break;
+
+          default:
+              HGOTO_ERROR(DFE_BADCODER, FAIL);
+      }     /* end switch */
+
+    /* the stdio model keeps the position too */
+    info->minfo.model_info.stdio_info.pos = length;
+
+    if (HCIwritten(access_rec, length) == FAIL)
+        HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+
+    ret_value = length;
+
+done:
+    if(ret_value == FAIL)
+    { /* Error condition cleanup */
+    } /* end if */
+
+    /* Normal function cleanup */
+    return ret_value;
+} /* HCPwritecoded */
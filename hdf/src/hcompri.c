@@ -107,6 +107,8 @@ FORTRAN
 int32
 HRPconvert(int32 fid, uint16 tag, uint16 ref, int32 xdim, int32 ydim,int16 scheme, comp_info *cinfo, uintn pixel_size)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(fid);
     CONSTR(FUNC, "HRPconvert");     /* for HERROR */
     filerec_t  *file_rec;           /* file record */
     accrec_t   *access_rec=NULL;    /* access element record */
@@ -384,12 +386,14 @@ HRPinquire(accrec_t * access_rec, int32 *pfile_id, uint16 *ptag,
     crinfo_t  *info =          /* special information record */
         (crinfo_t *) access_rec->special_info;
     uint16 data_tag,data_ref;   /* tag/ref of the data we are checking */
-    int32       data_off;		/* offset of the data we are checking */
+    hdf_off_t   data_off;		/* offset of the data we are checking */
     int32    ret_value = SUCCEED;
 
     /* Get the data's offset & length */
     if(HTPinquire(access_rec->ddid,&data_tag,&data_ref,&data_off,NULL)==FAIL)
         HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    if (poffset && data_off > MAX_OFFSET32)
+        HGOTO_ERROR(DFE_EXCEEDMAX, FAIL);
 
     /* fill in the variables if they are present */
     if (pfile_id)
@@ -401,7 +405,7 @@ HRPinquire(accrec_t * access_rec, int32 *pfile_id, uint16 *ptag,
     if (plength)
         *plength = (access_rec->new_elem ? -1 : info->image_size);
     if (poffset)
-        *poffset = data_off;
+        *poffset = (int32)data_off;
     if (pposn)
         *pposn = access_rec->posn;
     if (paccess)
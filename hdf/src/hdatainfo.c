@@ -112,12 +112,15 @@ HDgetdatainfo(int32 file_id, uint16 tag, uint16 ref, int32 *chk_coord,
 	uintn start_block, uintn info_count, int32 *offsetarray,
 	int32 *lengtharray)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HDgetdatainfo");	/* for HGOTO_ERROR */
     filerec_t  *file_rec;	/* file record */
     uint16	sp_tag;		/* special tag */
     uint16	comp_ref = 0;	/* ref for compressed data or comp header */
     uint16	dtag, dref;	/* description record tag/ref */
-    int32	dlen=0, doff=0;	/* offset/length of the description record */
+    int32	dlen=0;		/* length of the description record */
+    hdf_off_t	doff=0;		/* offset of the description record */
     uint8	lbuf[COMP_HEADER_LENGTH],
 		*p=NULL;	/* desc record buffer and a pointer to it */
     atom_t	data_id = FAIL;	/* dd ID of existing element */
@@ -174,7 +177,10 @@ HDgetdatainfo(int32 file_id, uint16 tag, uint16 ref, int32 *chk_coord,
 	    /* Offset and length are requested by caller */
 	    if (offsetarray != NULL && lengtharray != NULL)
 	    {
-		offsetarray[0] = doff;
+		/* the offset must fit in the 32-bit array */
+		if (doff > MAX_OFFSET32)
+		    HGOTO_ERROR(DFE_EXCEEDMAX, FAIL);
+		offsetarray[0] = (int32)doff;
 		lengtharray[0] = dlen;
 	    }
 	    count = 1;
@@ -372,6 +378,7 @@ intn
 VSgetdatainfo(int32 vsid, uintn start_block, uintn info_count,
 	int32 *offsetarray, int32 *lengtharray)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "VSgetdatainfo");
     vsinstance_t *vs_inst = NULL;
     VDATA        *vs = NULL;
@@ -505,6 +512,7 @@ done:
 intn
 Vgetattdatainfo(int32 vgid, intn attrindex, int32 *offset, int32 *length)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vgetattdatainfo");
     VGROUP *vg;
     vg_attr_t *vg_alist;
@@ -613,6 +621,7 @@ done:
 intn
 VSgetattdatainfo(int32 vsid, int32 findex, intn attrindex, int32 *offset, int32 *length)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "VSgetattdatainfo");
     VDATA *vs;
     vs_attr_t *vs_alist;
@@ -725,6 +734,7 @@ done:
 intn
 GRgetattdatainfo(int32 id, int32 attrindex, int32 *offset, int32 *length)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRgetattdatainfo");
     int32      hdf_file_id;	/* file id */
     int32      attr_vsid;	/* id of vdata that stores the attribute */
@@ -861,6 +871,7 @@ intn
 GRgetdatainfo(int32 riid, uintn start_block, uintn info_count,
 	int32 *offsetarray, int32 *lengtharray)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRgetdatainfo");
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     int32 hdf_file_id;		/* short cut for file id */
@@ -970,6 +981,7 @@ DESCRIPTION
 intn
 GRgetpalinfo(int32 gr_id, uintn pal_count, hdf_ddinfo_t *palinfo_array)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRgetpalinfo");
     gr_info_t *gr_ptr;
     int32 file_id;
@@ -1083,6 +1095,7 @@ ANgetdatainfo(int32 ann_id,    /* IN: annotation id */
 	int32 *offset,	/* OUT: buffer for offset */
 	int32 *length)	/* OUT: buffer for length */
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "ANgetdatainfo");
     filerec_t  *file_rec = NULL;		/* file record pointer */
     ANnode     *ann_node   = NULL;
@@ -49,6 +49,8 @@ typedef enum
 #define DFACC_RDONLY 1
 #define DFACC_RDWR 3
 #define DFACC_CLOBBER 4
+#define DFACC_LARGE 0x40    /* create the file in the large file format */
+#define DFACC_LAZYDD 0x80   /* read the DD list in lazily (see Hsetlazydd) */
 
 /* New file access codes (for Hstartaccess only, currently) */
 #define DFACC_BUFFER 8  /* buffer the access to this AID */
@@ -64,6 +66,27 @@ typedef enum
 /* The magic cookie for Hcache to cache all files */
 #define CACHE_ALL_FILES (-2)
 
+/* The magic cookie for Hmmap to map all files opened read-only */
+#define MMAP_ALL_FILES (-2)
+
+/* The magic cookie for Hmergedd to merge the DD blocks of all files */
+#define MERGEDD_ALL_FILES (-2)
+
+/* The magic cookie for Hwritebuf to set the write buffer of all files */
+#define WRITEBUF_ALL_FILES (-2)
+
+/* The magic cookie for Hreadahead to set the read-ahead of all files */
+#define READAHEAD_ALL_FILES (-2)
+
+/* The magic cookie for Hgetiostats to get the statistics of all files */
+#define IOSTATS_ALL_FILES (-2)
+
+/* File drivers for Hsetdriver and Hopendriver */
+#define HDF_DRIVER_DEFAULT  0   /* POSIX if pread/pwrite are there, else stdio */
+#define HDF_DRIVER_POSIX    1   /* POSIX file descriptors */
+#define HDF_DRIVER_STDIO    2   /* C buffered streams */
+#define HDF_DRIVER_CORE     3   /* whole file in memory, written at close */
+
 /* File access modes */
 /* 001--007 for different serial modes */
 /* 011--017 for different parallel modes */
@@ -138,11 +161,40 @@ typedef struct hdf_ntinfo_t
   }
 hdf_ntinfo_t;
 
+/* I/O statistics of a file or of all files, see Hgetiostats */
+typedef struct hdf_iostats_t
+  {
+      uint32  nreads;           /* # of reads passed to the file driver */
+      uint32  nwrites;          /* # of writes passed to the file driver */
+      float64 bytes_read;       /* # of bytes read by the file driver */
+      float64 bytes_written;    /* # of bytes written by the file driver */
+      uint32  nseeks;           /* # of reads/writes not continuing the last one */
+      uint32  nseeks_avoided;   /* # of reads/writes continuing the last one */
+      uint32  ndd_loads;        /* # of DD blocks read in */
+      uint32  nprefetches;      /* # of read-aheads asked of the file driver */
+      float64 io_time;          /* seconds spent in the file driver */
+  }
+hdf_iostats_t;
+
+/* One element to read with Hreadv */
+typedef struct hdf_readreq_t
+  {
+      uint16  tag;              /* tag of the element */
+      uint16  ref;              /* ref of the element */
+      int32   offset;           /* where in the element to start reading */
+      int32   length;           /* # of bytes to read, 0 for the rest */
+      void   *buf;              /* buffer to read the data into */
+      int32   nread;            /* OUT: # of bytes read */
+  }
+hdf_readreq_t;
+
 /* type for File ID to send to Hlevel from Vxx interface */
 typedef int32 HFILEID;
 
 typedef intn (*hdf_termfunc_t)(void);   /* termination function typedef */
 
+typedef void (*hdf_worktask_t)(void *arg);  /* worker pool task typedef */
+
 /* .................................................................. */
 
 /* Publically useful macros for tests/examples.  */
@@ -161,6 +213,7 @@ do {if(ret == val) {printf("*** ERROR from %s is %ld at line %4d in %s\n", where
 #include "hbitio.h"
 #include "hcomp.h"
 #include "herr.h"
+#include "hts.h"
 #include "hproto.h"
 #include "hdatainfo.h"  /* Add the data info header */
 #include "vg.h"         /* Add the Vgroup/Vdata header so the users don't have to */
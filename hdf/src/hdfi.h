@@ -1175,6 +1175,24 @@ No machine type has been defined.  Your Makefile needs to have someing like
 correctly.
 #endif
 
+/* offsets in HDF files, wide enough for files in the large file format
+   (created with DFACC_LARGE, magic number HDFMAGIC_LARGE) to grow past
+   2 GB: the 64-bit integer type found by configure */
+#if defined H4_SIZEOF_LONG_LONG && H4_SIZEOF_LONG_LONG >= 8
+typedef long long         hdf_off_t;
+#elif defined H4_SIZEOF___INT64 && H4_SIZEOF___INT64 >= 8
+typedef __int64           hdf_off_t;
+#elif defined H4_HAVE_STDINT_H
+#include <stdint.h>
+typedef int64_t           hdf_off_t;
+#else
+No 64-bit integer type has been found for hdf_off_t.
+#endif
+
+/* 2^32, the unit of the high 32 bits of an encoded hdf_off_t, without a
+   long long literal suffix */
+#define HDF_OFF_2_32      ((hdf_off_t)65536 * 65536)
+
 /*-----------------------------------------------------*/
 /*              encode and decode macros               */
 /*-----------------------------------------------------*/
@@ -1198,6 +1216,10 @@ correctly.
         *(p) = (uint8)(((i) >> 8) & 0xff); (p)++; \
         *(p) = (uint8)((i) & 0xff); (p)++; }
 
+#   define INT64ENCODE(p, i) \
+{ INT32ENCODE(p, (hdf_off_t)(i) / HDF_OFF_2_32 - ((hdf_off_t)(i) % HDF_OFF_2_32 < 0)); \
+        UINT32ENCODE(p, (uint32)((hdf_off_t)(i) & 0xffffffff)); }
+
 #   define NBYTEENCODE(d, s, n) \
 {   HDmemcpy(d,s,n); p+=n }
 
@@ -1229,6 +1251,11 @@ correctly.
         (i) |= ((uint32)(*(p) & 0xff) << 8); (p)++; \
         (i) |= (uint32)(*(p) & 0xff); (p)++; }
 
+#   define INT64DECODE(p, i) \
+{ int32 hi_; uint32 lo_; \
+        INT32DECODE(p, hi_); UINT32DECODE(p, lo_); \
+        (i) = (hdf_off_t)hi_ * HDF_OFF_2_32 + (hdf_off_t)lo_; }
+
 /* Note! the NBYTEDECODE macro is backwards from the memcpy() routine, */
 /*      in the spirit of the other DECODE macros */
 #   define NBYTEDECODE(s, d, n) \
@@ -1338,6 +1365,7 @@ correctly.
 **************************************************************************/
 
 # define HDmemcpy(dst,src,n)   (memcpy((void *)(dst),(const void *)(src),(size_t)(n)))
+# define HDmemmove(dst,src,n)  (memmove((void *)(dst),(const void *)(src),(size_t)(n)))
 # define HDmemset(dst,c,n)     (memset((void *)(dst),(intn)(c),(size_t)(n)))
 # define HDmemcmp(dst,src,n)   (memcmp((const void *)(dst),(const void *)(src),(size_t)(n)))
 
@@ -1347,6 +1375,7 @@ correctly.
 **************************************************************************/
 #define HDstat(path, result)    (stat(path, result))
 #define HDgetenv(s1)            (getenv(s1))
+#define HDqsort(b,n,s,f)        (qsort((void *)(b),(size_t)(n),(size_t)(s),(f)))
 #define HDputenv(s1)            (putenv(s1))
 #define HDltoa(v)               (ltoa(v))
 #if defined (SUN) && defined(__GNUC__)
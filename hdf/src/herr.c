@@ -54,8 +54,19 @@ typedef struct error_t
 error_t;
 
 
-/* pointer to the structure to hold error messages */
-PRIVATE error_t *error_stack = NULL;
+/* pointer to the structure to hold error messages, one per thread in the
+   thread-safe build, like error_top */
+PRIVATE HE_THREAD_LOCAL error_t *error_stack = NULL;
+
+#ifdef H4_HAVE_THREADSAFE
+/* Frees the error stack of a thread when it exits */
+PRIVATE pthread_key_t error_key;
+PRIVATE pthread_once_t error_key_once = PTHREAD_ONCE_INIT;
+
+PRIVATE void HEIcreate_key(void);
+
+PRIVATE void HEIfree_stack(void *stack);
+#endif /* H4_HAVE_THREADSAFE */
 
 #ifndef DEFAULT_MESG
 #   define DEFAULT_MESG "Unknown error"
@@ -163,6 +174,10 @@ HEpush(hdf_err_code_t error_code, const char *function_name, const char *file_na
             }
           for (i = 0; i < ERR_STACK_SZ; i++)
               error_stack[i].desc = NULL;
+#ifdef H4_HAVE_THREADSAFE
+          pthread_once(&error_key_once, HEIcreate_key);
+          pthread_setspecific(error_key, error_stack);
+#endif /* H4_HAVE_THREADSAFE */
       }
 
     /* if stack is full, discard error */
@@ -309,6 +324,9 @@ intn HEshutdown(void)
 {
     if(error_stack!=NULL)
       {
+#ifdef H4_HAVE_THREADSAFE
+          pthread_setspecific(error_key, NULL);
+#endif /* H4_HAVE_THREADSAFE */
           HDfree(error_stack);
           error_stack=NULL;
           error_top=0;
@@ -316,3 +334,48 @@ intn HEshutdown(void)
     return(SUCCEED);
 } /* end HEshutdown() */
 
+#ifdef H4_HAVE_THREADSAFE
+/*--------------------------------------------------------------------------
+ NAME
+    HEIcreate_key
+ PURPOSE
+    Create the key which frees the error stacks of exiting threads.
+ USAGE
+    void HEIcreate_key()
+ RETURNS
+    none
+ DESCRIPTION
+    Run once, by the first thread to push an error.
+--------------------------------------------------------------------------*/
+PRIVATE void
+HEIcreate_key(void)
+{
+    pthread_key_create(&error_key, HEIfree_stack);
+} /* end HEIcreate_key() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HEIfree_stack
+ PURPOSE
+    Free the error stack of a thread which exits.
+ USAGE
+    void HEIfree_stack(stack)
+        void *stack;        IN: the error stack of the thread
+ RETURNS
+    none
+ DESCRIPTION
+    Called by the threads library, with the stack HEpush registered.
+--------------------------------------------------------------------------*/
+PRIVATE void
+HEIfree_stack(void *stack)
+{
+    error_t    *err = (error_t *) stack;
+    intn        i;
+
+    for (i = 0; i < ERR_STACK_SZ; i++)
+        if (err[i].desc != NULL)
+            HDfree(err[i].desc);
+    HDfree(err);
+} /* end HEIfree_stack() */
+#endif /* H4_HAVE_THREADSAFE */
+
@@ -98,6 +98,13 @@
                                                   goto done;}
 
 
+/* In the thread-safe build each thread has an error stack of its own */
+#ifdef H4_HAVE_THREADSAFE
+#define HE_THREAD_LOCAL __thread
+#else  /* H4_HAVE_THREADSAFE */
+#define HE_THREAD_LOCAL
+#endif /* H4_HAVE_THREADSAFE */
+
 /* always points to the next available slot; the last error record is in slot (top-1) */
 #if defined(H4_BUILT_AS_DYNAMIC_LIB)
 # ifdef _H_ERR_MASTER_
@@ -107,7 +114,7 @@ __declspec(dllexport)
 # else
 HDFERRPUBLIC
 # endif /* _H_ERR_MASTER_ */
-int32       error_top
+HE_THREAD_LOCAL int32 error_top
 # ifdef _H_ERR_MASTER_
 = 0
 # endif /* _H_ERR_MASTER_ */
@@ -116,14 +123,15 @@ int32       error_top
 # ifndef _H_ERR_MASTER_
 HDFERRPUBLIC
 # endif /* _H_ERR_MASTER_ */
-int32       error_top
+HE_THREAD_LOCAL int32 error_top
 # ifdef _H_ERR_MASTER_
 = 0
 # endif /* _H_ERR_MASTER_ */
 ;
 #endif /* defined(H4_BUILT_AS_DYNAMIC_LIB) */
 
-/* Macro to wrap around calls to HEPclear, so it doesn't get called zillions of times */
+/* Macro to wrap around calls to HEPclear, so it doesn't get called zillions of times;
+   with nothing on the stack it costs a load of error_top */
 #define HEclear() {if(error_top!=0) HEPclear(); }
 
 /*
@@ -187,6 +187,8 @@ MODIFICATION
 int32
 HXcreate(int32 file_id, uint16 tag, uint16 ref, const char *extern_file_name, int32 offset, int32 start_len)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HXcreate");   /* for HERROR */
     filerec_t  *file_rec;       /* file record */
     accrec_t   *access_rec=NULL;/* access element record */
@@ -478,7 +480,7 @@ HXIstaccess(accrec_t * access_rec, int16 acc_mode)
     CONSTR(FUNC, "HXIstaccess");    /* for HERROR */
     extinfo_t  *info = NULL;        /* special element information */
     filerec_t  *file_rec = NULL;    /* file record */
-    int32       data_off;		    /* offset of the data we are checking */
+    hdf_off_t   data_off;		    /* offset of the data we are checking */
     uint8       local_ptbuf[12];    /* working buffer */
     int32       ret_value = SUCCEED;
 
@@ -813,7 +815,7 @@ HXPwrite(accrec_t * access_rec, int32 length, const void * data)
     access_rec->posn += length;
     if (access_rec->posn > info->length)
       {
-          int32       data_off;		/* offset of the data we are checking */
+          hdf_off_t   data_off;		/* offset of the data we are checking */
           info->length = access_rec->posn;
           INT32ENCODE(p, info->length);
 
@@ -1091,7 +1093,8 @@ HXPreset(accrec_t * access_rec, sp_info_block_t * info_block)
     uint8       local_ptbuf[14 + MAX_PATH_LEN];     /* temp buffer */
     extinfo_t  *info =          /* special information record */
     (extinfo_t *) access_rec->special_info;
-    int32 new_len, new_off;     /* new length & offset of the special info */
+    int32 new_len;              /* new length of the special info */
+    hdf_off_t new_off;          /* new offset of the special info */
     int32      ret_value = SUCCEED;
 
     /* validate access record -- make sure is already external element */
@@ -1166,6 +1169,10 @@ static	char*	extcreatedir = NULL;
 static	char*	HDFEXTCREATEDIR = NULL;
 static	char*	extdir = NULL;
 static	char*	HDFEXTDIR = NULL;
+#ifdef H4_HAVE_THREADSAFE
+/* Guards the directories above, external files are opened on first read */
+PRIVATE pthread_mutex_t extdir_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif /* H4_HAVE_THREADSAFE */
 
 /*------------------------------------------------------------------------ 
 NAME
@@ -1189,6 +1196,8 @@ FORTRAN
 intn
 HXsetcreatedir(const char *dir)
 {
+    HTS_API_LOCK;
+    HTS_MUTEX_GUARD(extdir_lock);
     CONSTR(FUNC, "HXsetcreatedir");
   char	*pt;
   intn       ret_value = SUCCEED;
@@ -1240,6 +1249,8 @@ FORTRAN
 intn
 HXsetdir(const char *dir)
 {
+    HTS_API_LOCK;
+    HTS_MUTEX_GUARD(extdir_lock);
     CONSTR(FUNC, "HXsetdir");
   char	*pt;
   intn   ret_value = SUCCEED;
@@ -1292,6 +1303,7 @@ PRIVATE
 char *
 HXIbuildfilename(const char *ext_fname, const intn acc_mode)
 {
+    HTS_MUTEX_GUARD(extdir_lock);
     CONSTR(FUNC, "HXIbuildfilename");
     int	        fname_len;		/* string length of the ext_fname */
     int	        path_len;		/* string length of prepend pathname */
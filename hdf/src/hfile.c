@@ -46,6 +46,7 @@
 
    EXPORTED ROUTINES
    Hopen       -- open or create a HDF file
+   Hopendriver -- open or create a HDF file with a given file driver
    Hclose      -- close HDF file
    Hstartread  -- locate and position a read access elt on a tag/ref
    Hnextread   -- locate and position a read access elt on next tag/ref.
@@ -60,6 +61,7 @@
    HDputc      -- write a byte to data element
    Hendaccess  -- to dispose of an access element
    Hgetelement -- read in a data element
+   Hreadv      -- read in parts of several data elements
    Hputelement -- writes a data element
    Hlength     -- returns length of a data element
    Hoffset     -- get offset of data element in the file
@@ -67,6 +69,9 @@
    Htrunc      -- truncate a dataset to a length
    Hsync       -- sync file with memory
    Hcache      -- set low-level caching for a file
+   Hwritebuf   -- set the size of the buffer for small writes to a file
+   Hreadahead  -- set the # of bytes read ahead of sequential reads
+   Hgetiostats -- get the I/O statistics of a file or of all files
    HDvalidfid  -- check if a file ID is valid
    HDerr       --  Closes a file and return FAIL.  
    Hsetacceesstype -- set the I/O access type (serial, parallel, ...)
@@ -74,7 +79,9 @@
    Hgetlibversion  -- return version info on current HDF library
    Hgetfileversion -- return version info on HDF file
    HPgetdiskblock  -- Get the offset of a free block in the file.
+   HPgetalignedblock -- Get the offset of a free block starting on a boundary.
    HPfreediskblock -- Release a block in a file to be re-used.
+   HPsetdiskblock  -- Place a new data element on a block already allocated.
    HDread_drec -- reads a description record
    HDcheck_empty   -- determines if an element has been written with data
    HDget_special_info -- get information about a special element
@@ -102,6 +109,14 @@
 
    LOCAL ROUTINES
    HIextend_file   -- extend file to current length
+   HIappend_diskblock -- allocate a block at the end of the file
+   HIbuffer_write  -- add a small write to the write buffer of a file
+   HIdriver_read   -- read through the file driver, keeping I/O statistics
+   HIdriver_write  -- write through the file driver, keeping I/O statistics
+   HIcount_io      -- add a read or write to the I/O statistics
+   HIio_time       -- current time for the I/O statistics
+   HIread_ahead    -- read ahead of a sequential read of an element
+   HIcompare_readv_piece -- order the pieces of Hreadv by file offset
    HIget_function_table -- create special function table
    HIgetspinfo          -- return special info
    HIunlock             -- unlock a previously locked file record
@@ -119,13 +134,45 @@
 #define HFILE_MASTER
 #include "hfile.h"
 #include <errno.h>
+#ifdef H4_HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif /* H4_HAVE_SYS_TIME_H */
 #include "glist.h" /* for double-linked lists, stacks and queues */
 
+/*--------------------- Local definitions ---------------------------------*/
+
+/* The part of the file a request of Hreadv reads */
+typedef struct readv_piece_t
+  {
+      hdf_off_t   file_off;     /* offset in the file to read from */
+      int32       len;          /* # of bytes to read */
+      intn        req;          /* index of the request */
+  }
+readv_piece_t;
+
 /*--------------------- Locally defined Globals -----------------------------*/
 
 /* The default state of the file DD caching */
 PRIVATE intn default_cache = TRUE;
 
+/* The default state of memory-mapping for files opened read-only */
+PRIVATE intn default_mmap = FALSE;
+
+/* The file driver for files Hopen'ed from now on */
+PRIVATE intn default_driver = HDF_DRIVER_DEFAULT;
+
+/* Whether the DD list of files opened from now on is read in lazily */
+PRIVATE intn default_lazydd = FALSE;
+
+/* The default state of merging the DD blocks when files are closed */
+PRIVATE intn default_mergedd = FALSE;
+
+/* The size of the write buffer of files Hopen'ed from now on */
+PRIVATE int32 default_writebuf = DEF_WRITEBUF_SIZE;
+
+/* The # of bytes read ahead in files Hopen'ed from now on */
+PRIVATE int32 default_readahead = DEF_READAHEAD_SIZE;
+
 /* Whether we've installed the library termination function yet for this interface */
 PRIVATE intn library_terminate = FALSE;
 #ifdef OLD_WAY
@@ -196,7 +243,7 @@ PRIVATE intn HIrelease_filerec_node
             (filerec_t *file_rec);
 
 PRIVATE intn HIvalid_magic
-            (hdf_file_t file);
+            (const hdf_fdriver_t *driver, void *file, intn *largefile);
 
 PRIVATE intn HIextend_file
             (filerec_t * file_rec);
@@ -216,6 +263,37 @@ PRIVATE intn HIcheckfileversion
 PRIVATE intn HIsync
             (filerec_t *file_rec);
 
+PRIVATE intn HImap_file
+            (filerec_t *file_rec);
+
+PRIVATE intn HIunmap_file
+            (filerec_t *file_rec);
+
+PRIVATE hdf_off_t HIappend_diskblock
+            (filerec_t * file_rec, int32 block_size, intn moveto);
+
+PRIVATE intn HIbuffer_write
+            (filerec_t *file_rec, const void * buf, int32 bytes, hdf_off_t offset);
+
+PRIVATE intn HIdriver_read
+            (filerec_t *file_rec, void * buf, int32 bytes, hdf_off_t offset);
+
+PRIVATE intn HIdriver_write
+            (filerec_t *file_rec, const void * buf, int32 bytes, hdf_off_t offset);
+
+PRIVATE void HIcount_io
+            (filerec_t *file_rec, fileop_t op, int32 bytes, hdf_off_t offset,
+             float64 io_time);
+
+PRIVATE float64 HIio_time(void);
+
+PRIVATE void HIread_ahead
+            (filerec_t *file_rec, accrec_t *access_rec, hdf_off_t data_off,
+             int32 data_len);
+
+PRIVATE int HIcompare_readv_piece
+            (const void *p1, const void *p2);
+
 PRIVATE intn HIstart(void);
 
 /* #define TESTING */
@@ -244,6 +322,19 @@ DESCRIPTION
    implied even if it is not set.  DFACC_CREATE implies
    DFACC_WRITE.
 
+   A new file is created in the large file format, with 64-bit
+   offsets in its DD list, if DFACC_LARGE is or'ed into access.
+   Such files can grow past 2 GB, but can't be read by libraries
+   older than this one.  DFACC_LARGE is ignored for existing files.
+
+   The DD list of a file opened read-only is read in lazily if
+   DFACC_LAZYDD is or'ed into access, or if Hsetlazydd() turned it on
+   for all files.  Like the other per-file settings, it only applies
+   to the open which first opens the file.
+
+   The file is accessed with the driver set with Hsetdriver(), see
+   Hopendriver() to pick the driver for one open.
+
    If the file is already opened and access is DFACC_CREATE:
    error DFE_ALROPEN.
    If the file is already opened, the requested access contains
@@ -261,17 +352,60 @@ DESCRIPTION
 int32 
 Hopen(const char *path, intn acc_mode, int16 ndds)
 {
-  CONSTR(FUNC, "Hopen");	/* For HERROR */
+    HTS_API_LOCK;
+
+  /* the default driver is read under the API lock */
+  return Hopendriver(path, acc_mode, ndds, default_driver);
+}	/* Hopen */
+
+/*--------------------------------------------------------------------------
+NAME
+   Hopendriver -- Opens a HDF file with a given file driver.
+USAGE
+   int32 Hopendriver(path, access, ndds, driver_id)
+   char *path;             IN: Name of file to be opened.
+   int access;             IN: as for Hopen()
+   int16 ndds;             IN: Number of dds in a block if this
+				file needs to be created.
+   intn driver_id;         IN: HDF_DRIVER_* number of the driver
+RETURNS
+   On success returns file id, on failure returns -1.
+DESCRIPTION
+   Like Hopen(), but the file is accessed with the driver given instead
+   of the one set with Hsetdriver(), so that threads can open files with
+   different drivers without changing the default for each other.
+   HDF_DRIVER_DEFAULT is the built-in default driver here (see
+   Hsetdriver()).  If the file is already open it keeps the driver it
+   was first opened with.
+
+   DFACC_LARGE with HDF_DRIVER_CORE fails with DFE_UNSUPPORTED, the core
+   driver keeps the file in memory with 32-bit offsets.
+--------------------------------------------------------------------------*/
+int32 
+Hopendriver(const char *path, intn acc_mode, int16 ndds, intn driver_id)
+{
+    HTS_API_LOCK;
+  CONSTR(FUNC, "Hopendriver");	/* For HERROR */
   filerec_t  *file_rec=NULL;/* File record */
   int         vtag = 0;		/* write version tag? */
   int32       fid=FAIL;     /* File ID */
+  intn        large;        /* create the file in the large file format? */
+  intn        lazydd;       /* read the DD list in lazily? */
   int32       ret_value = SUCCEED;
 
   /* Clear errors and check args and all the boring stuff. */
   HEclear();
-  if (!path || ((acc_mode & DFACC_ALL) != acc_mode))
+  large = (acc_mode & DFACC_LARGE) ? TRUE : FALSE;
+  lazydd = (acc_mode & DFACC_LAZYDD) ? TRUE : default_lazydd;
+  acc_mode &= ~(DFACC_LARGE | DFACC_LAZYDD);
+  if (!path || ((acc_mode & DFACC_ALL) != acc_mode)
+      || HPget_driver(driver_id) == NULL)
     HGOTO_ERROR(DFE_ARGS, FAIL);
 
+  /* the core driver can't hold a file grown past 2 GB */
+  if (large && driver_id == HDF_DRIVER_CORE)
+    HGOTO_ERROR(DFE_UNSUPPORTED, FAIL);
+
   /* Perform global, one-time initialization */
   if (library_terminate == FALSE)
       if(HIstart()==FAIL)
@@ -296,26 +430,38 @@ Hopen(const char *path, intn acc_mode, int16 ndds)
 	   This cannot be done on OS (such as the SXOS) where only one
 	   open is allowed per file at any time. */
 #ifndef NO_MULTI_OPEN
-          hdf_file_t  f;
+          void       *f;
 
           /* Sync. the file before throwing away the old file handle */
           if(HIsync(file_rec)==FAIL)
             HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
-          f =  (hdf_file_t)HI_OPEN(file_rec->path, acc_mode);
-          if (OPENERR(f))
+          /* The mapping would not see any of the new writes */
+          if(HIunmap_file(file_rec)==FAIL)
+            HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+          /* Writing needs the end of the file, known from the whole DD list */
+          if(HTPload(file_rec)==FAIL)
+            HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+          /* Pick up the free space recorded in the file */
+          if(HTPgetfree(file_rec)==FAIL)
+            HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+          f = (*file_rec->driver->open)(file_rec->path, acc_mode);
+          if (f == NULL)
             HGOTO_ERROR(DFE_DENIED, FAIL);
 
-				/* Replace file_rec->file with new file pointer and
+				/* Replace file_rec->file with new file handle and
 				   close old one. */
-          if (HI_CLOSE(file_rec->file) == FAIL)
+          if ((*file_rec->driver->close)(file_rec->file) == FAIL)
             {
-              HI_CLOSE(f);
+              (*file_rec->driver->close)(f);
               HGOTO_ERROR(DFE_CANTCLOSE, FAIL);
             }
           file_rec->file = f;
+          file_rec->access |= acc_mode;
           file_rec->f_cur_off=0;
-          file_rec->last_op=H4_OP_UNKNOWN;
 #else  /* NO_MULTI_OPEN */
           HGOTO_ERROR(DFE_DENIED, FAIL);
 #endif /* NO_MULTI_OPEN */
@@ -329,11 +475,15 @@ Hopen(const char *path, intn acc_mode, int16 ndds)
       /* Flag to see if file is new and needs to be set up. */
       intn        new_file = FALSE;
 
+      /* Pick the file driver to do the I/O with */
+      if ((file_rec->driver = HPget_driver(driver_id)) == NULL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
       /* Open the file, fill in the blanks and all the good stuff. */
       if (acc_mode != DFACC_CREATE)
         {	/* try to open existing file */
-          file_rec->file =  (hdf_file_t)HI_OPEN(file_rec->path, acc_mode);
-          if (OPENERR(file_rec->file))
+          file_rec->file = (*file_rec->driver->open)(file_rec->path, acc_mode);
+          if (file_rec->file == NULL)
             {
               if (acc_mode & DFACC_WRITE)
                 {
@@ -345,27 +495,34 @@ Hopen(const char *path, intn acc_mode, int16 ndds)
             }
           else
             {
-#ifdef STDIO_BUF
-               /* Testing stdio buffered i/o */
-              if (HDsetvbuf(file_rec->file, my_stdio_buf, _IOFBF, MY_STDIO_BUF_SIZE) != 0)
-                HGOTO_ERROR(DFE_BADOPEN, FAIL);
-#endif /* STDIO_BUF */
                /* Open existing file successfully. */
               file_rec->access = acc_mode | DFACC_READ;
 
               /* Check to see if file is a HDF file. */
-              if (!HIvalid_magic(file_rec->file))
+              file_rec->largefile = FALSE;
+              if (!HIvalid_magic(file_rec->driver, file_rec->file,
+                    &file_rec->largefile))
                 {
-                  HI_CLOSE(file_rec->file);
+                  (*file_rec->driver->close)(file_rec->file);
+                  file_rec->file = NULL;
                   HGOTO_ERROR(DFE_NOTDFFILE, FAIL);
                 }
 
               file_rec->f_cur_off=0;
-              file_rec->last_op=H4_OP_UNKNOWN;
+
+              /* Map read-only files when asked to, reading the DD list
+                 below already goes through the mapping.  Failure to map
+                 is not an error, the file is just read normally. */
+              if (default_mmap && !(acc_mode & DFACC_WRITE))
+                  HImap_file(file_rec);
+
               /* Read in all the relevant data descriptor records. */
-              if (HTPstart(file_rec) == FAIL)
+              if (HTPstart(file_rec,
+                    lazydd && !(acc_mode & DFACC_WRITE)) == FAIL)
                 {
-                  HI_CLOSE(file_rec->file);
+                  HIunmap_file(file_rec);
+                  (*file_rec->driver->close)(file_rec->file);
+                  file_rec->file = NULL;
                   HGOTO_ERROR(DFE_BADOPEN, FAIL);
                 }
             }
@@ -376,8 +533,8 @@ Hopen(const char *path, intn acc_mode, int16 ndds)
 	/* make user we get a version tag */
           vtag = 1;
 
-          file_rec->file =  (hdf_file_t)HI_CREATE(file_rec->path);
-          if (OPENERR(file_rec->file))
+          file_rec->file = (*file_rec->driver->create)(file_rec->path);
+          if (file_rec->file == NULL)
           {
 	      /* check if the failure was due to "too many open files" */
               if(errno == EMFILE)
@@ -389,18 +546,13 @@ Hopen(const char *path, intn acc_mode, int16 ndds)
           }
 
           file_rec->f_cur_off=0;
-          file_rec->last_op=H4_OP_UNKNOWN;
-#ifdef STDIO_BUF
-	/* Testing stdio buffered i/o */
-          if (HDsetvbuf(file_rec->file, my_stdio_buf, _IOFBF, MY_STDIO_BUF_SIZE) != 0)
-            HGOTO_ERROR(DFE_BADOPEN, FAIL);
-#endif /* STDIO_BUF */
 	/* set up the newly created (and empty) file with
 	   the magic cookie and initial data descriptor records */
-          if (HP_write(file_rec, HDFMAGIC, MAGICLEN) == FAIL)
+          file_rec->largefile = large;
+          if (HP_write(file_rec, large ? HDFMAGIC_LARGE : HDFMAGIC, MAGICLEN) == FAIL)
             HGOTO_ERROR(DFE_WRITEERROR, FAIL);
 
-          if (HI_FLUSH(file_rec->file) == FAIL)	/* flush the cookie */
+          if ((*file_rec->driver->flush)(file_rec->file) == FAIL)	/* flush the cookie */
             HGOTO_ERROR(DFE_WRITEERROR, FAIL);
 
           if (HTPinit(file_rec, ndds) == FAIL)
@@ -414,7 +566,17 @@ Hopen(const char *path, intn acc_mode, int16 ndds)
 
       /* currently, default is caching OFF */
       file_rec->cache = default_cache;
+      file_rec->mergedd = default_mergedd;
+
+      /* the core driver keeps the file in memory already */
+      if (file_rec->driver->id != HDF_DRIVER_CORE)
+          file_rec->wbuf_size = default_writebuf;
+      file_rec->ra_size = default_readahead;
       file_rec->dirty = 0;	/* mark all dirty flags off to start */
+
+      /* Pick up the free space recorded in the file */
+      if ((file_rec->access & DFACC_WRITE) && HTPgetfree(file_rec) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
     }	/* end else */
 
   file_rec->version_set = FALSE;
@@ -448,7 +610,7 @@ done:
 
   /* Normal function cleanup */
   return ret_value;
-}	/* Hopen */
+}	/* Hopendriver */
 
 /*--------------------------------------------------------------------------
 NAME
@@ -467,8 +629,10 @@ DESCRIPTION
 intn
 Hclose(int32 file_id)
 {
+    HTS_API_LOCK;
   CONSTR(FUNC, "Hclose");	/* for HERROR */
   filerec_t  *file_rec;		/* file record pointer */
+  intn        close_ret = SUCCEED; /* whether the driver closed the file */
   intn  ret_value = SUCCEED;
 
   /* Clear errors and check args and all the boring stuff. */
@@ -479,40 +643,63 @@ Hclose(int32 file_id)
   if (BADFREC(file_rec))
     HGOTO_ERROR(DFE_ARGS, FAIL);
 
-  /* version tags */
-  if ((file_rec->refcount > 0) && (file_rec->version.modified == 1))
-      HIupdate_version(file_id);
+  /* the file lock lives in the file record, it has to be released
+     before the record is */
+  {
+    HTS_FILE_LOCK(file_id);
 
-  /* decrease the reference count */
-  if (--file_rec->refcount == 0)
-    {
-      /* if file reference count is zero but there are still attached
-         access elts, reject this close. */
-      if (file_rec->attach > 0)
-        {
-          file_rec->refcount++;
-          HEreport("There are still %d active aids attached", file_rec->attach);
-          HGOTO_ERROR(DFE_OPENAID, FAIL);
-        } /* end if */
+    /* version tags */
+    if ((file_rec->refcount > 0) && (file_rec->version.modified == 1))
+        HIupdate_version(file_id);
 
-      /* before closing file, check whether to flush file info */
-      if(HIsync(file_rec)==FAIL)
-          HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    /* decrease the reference count */
+    if (--file_rec->refcount == 0)
+      {
+        /* if file reference count is zero but there are still attached
+           access elts, reject this close. */
+        if (file_rec->attach > 0)
+          {
+            file_rec->refcount++;
+            HEreport("There are still %d active aids attached", file_rec->attach);
+            HGOTO_ERROR(DFE_OPENAID, FAIL);
+          } /* end if */
 
-      /* otherwise, nothing should still be using this file, close it */
-      /* ignore any close error */
-      HI_CLOSE(file_rec->file);
+        /* rewrite the DD list as one block if asked to */
+        if (file_rec->mergedd && (file_rec->access & DFACC_WRITE))
+            if(HTPmerge(file_rec)==FAIL)
+                HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
-      if(HTPend(file_rec)==FAIL)
-          HGOTO_ERROR(DFE_INTERNAL, FAIL);
+        /* keep the free space for the next time the file is written to */
+        if (file_rec->access & DFACC_WRITE)
+            if(HTPputfree(file_rec)==FAIL)
+                HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+        /* before closing file, check whether to flush file info */
+        if(HIsync(file_rec)==FAIL)
+            HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+        /* otherwise, nothing should still be using this file, close it.
+           A close error is reported once the file record is released,
+           since drivers such as the core driver write the file out here. */
+        HIunmap_file(file_rec);
+        close_ret = (*file_rec->driver->close)(file_rec->file);
+        file_rec->file = NULL;
+
+        if(HTPend(file_rec)==FAIL)
+            HGOTO_ERROR(DFE_INTERNAL, FAIL);
+      } /* end if */
+  }
 
+  if (file_rec->refcount == 0)
       if(HIrelease_filerec_node(file_rec))
           HGOTO_ERROR(DFE_INTERNAL, FAIL);
-    } /* end if */
 
     if(HAremove_atom(file_id)==NULL)
         HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
+    if(close_ret==FAIL)
+        HGOTO_ERROR(DFE_CANTCLOSE, FAIL);
+
 done:
   if(ret_value == FAIL)   
     { /* Error condition cleanup */
@@ -548,6 +735,8 @@ REVISION LOG
 intn
 Hexist(int32 file_id, uint16 search_tag, uint16 search_ref)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
 #ifdef LATER
   CONSTR(FUNC, "Hexist");		/* for HERROR */
 #endif
@@ -583,7 +772,9 @@ DESCRIPTION
    the access elt.  The access type is set if the access_id is valid even
    if FAIL is returned.  If access_id is not valid then access is set to
    zero (0). If statistic is not needed, pass NULL for the appropriate
-   value.
+   value.  Asking for the offset of an element past the 2 GB offsets
+   the 32-bit argument can hold, in a file in the large file format,
+   fails with DFE_EXCEEDMAX.
 
 --------------------------------------------------------------------------*/
 intn
@@ -591,8 +782,11 @@ Hinquire(int32 access_id, int32 *pfile_id, uint16 *ptag, uint16 *pref,
 		 int32 *plength, int32 *poffset, int32 *pposn, int16 *paccess,
 		 int16 *pspecial)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
   CONSTR(FUNC, "Hinquire");	/* for HERROR */
   accrec_t   *access_rec;	/* access record */
+  hdf_off_t   data_off;		/* offset of the element */
   intn   ret_value = SUCCEED;
 
   /* clear error stack and check validity of access id */
@@ -611,8 +805,14 @@ Hinquire(int32 access_id, int32 *pfile_id, uint16 *ptag, uint16 *pref,
   if (pfile_id != NULL)
     *pfile_id = access_rec->file_id;
   /* Get the relevant DD information */
-  if (HTPinquire(access_rec->ddid,ptag,pref,poffset,plength)==FAIL)
+  if (HTPinquire(access_rec->ddid,ptag,pref,&data_off,plength)==FAIL)
     HGOTO_ERROR(DFE_INTERNAL, FAIL);
+  if (poffset != NULL)
+    {
+      if (data_off > MAX_OFFSET32)
+        HGOTO_ERROR(DFE_EXCEEDMAX, FAIL);
+      *poffset = (int32)data_off;
+    }
   if (pposn != NULL)
     *pposn = access_rec->posn;
   if (paccess != NULL)
@@ -649,6 +849,8 @@ done:
 intn 
 Hfidinquire(int32 file_id, char **fname, intn *faccess, intn *attach)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "Hfidinquire");               /* for HERROR */
     filerec_t *file_rec;
     intn      ret_value = SUCCEED;
@@ -696,6 +898,8 @@ DESCRIPTION
 int32
 Hstartread(int32 file_id, uint16 tag, uint16 ref)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
   CONSTR(FUNC, "Hstartread");		/* for HERROR */
   int32       ret;			/* AID to return */
   int32  ret_value = SUCCEED;
@@ -745,6 +949,8 @@ DF_END _not_ supported yet!
 intn
 Hnextread(int32 access_id, uint16 tag, uint16 ref, intn origin)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
   CONSTR(FUNC, "Hnextread");	/* for HERROR */
   filerec_t  *file_rec;		/* file record */
   accrec_t   *access_rec;		/* access record */
@@ -887,6 +1093,8 @@ DESCRIPTION
 int32
 Hstartwrite(int32 file_id, uint16 tag, uint16 ref, int32 length)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
   CONSTR(FUNC, "Hstartwrite");	/* for HERROR */
   accrec_t   *access_rec;		/* access record */
   int32       ret;			/* AID to return */
@@ -942,12 +1150,16 @@ DESCRIPTION
 int32
 Hstartaccess(int32 file_id, uint16 tag, uint16 ref, uint32 flags)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
   CONSTR(FUNC, "Hstartaccess");	/* for HERROR */
   intn        ddnew = FALSE;	/* is the dd a new one? */
   filerec_t  *file_rec=NULL;		/* file record */
   accrec_t   *access_rec=NULL;		/* access record */
   uint16 new_tag=0, new_ref=0;      /* new tag & ref to access */
-  int32  new_off, new_len;      /* offset & length of new tag & ref */
+  int32  find_off;              /* 32-bit offset from Hfind, not used */
+  hdf_off_t new_off;            /* offset of new tag & ref */
+  int32  new_len;               /* length of new tag & ref */
   int32      ret_value = SUCCEED;
 
   /* clear error stack and check validity of file id */
@@ -985,7 +1197,7 @@ Hstartaccess(int32 file_id, uint16 tag, uint16 ref, uint32 flags)
   /* the current location in the DD list */
   if (flags & DFACC_CURRENT 
       || Hfind(access_rec->file_id,tag,ref,&new_tag,&new_ref,
-               &new_off,&new_len,DF_FORWARD)==FAIL)
+               &find_off,&new_len,DF_FORWARD)==FAIL)
     { /* not in DD list */
         new_tag=tag;
         new_ref=ref;
@@ -1036,8 +1248,13 @@ Hstartaccess(int32 file_id, uint16 tag, uint16 ref, uint32 flags)
   /* it's length being set.  If that was the case, the offset and length */
   /* will be marked as invalid, and therefore we should mark it as "new" */
   /* again when the element is re-opened -QAK */
-  if (!ddnew && new_off == INVALID_OFFSET && new_len == INVALID_LENGTH)
-    ddnew = TRUE; /* mark as new element */
+  if (!ddnew)
+    {
+      if (HTPinquire(access_rec->ddid,NULL,NULL,&new_off,&new_len)==FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+      if (new_off == INVALID_OFFSET && new_len == INVALID_LENGTH)
+        ddnew = TRUE; /* mark as new element */
+    }
 
   /* update the access record, and the file record */
   access_rec->posn     = 0;
@@ -1090,10 +1307,12 @@ DESCRIPTION
 intn
 Hsetlength(int32 aid, int32 length)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(aid);
   CONSTR(FUNC, "Hsetlength");		/* for HERROR */
   accrec_t   *access_rec;		/* access record */
   filerec_t  *file_rec;		/* file record */
-  int32       offset;			/* offset of this data element in file */
+  hdf_off_t   offset;			/* offset of this data element in file */
   intn       ret_value = SUCCEED;
 
   /* clear error stack and check validity of file id */
@@ -1110,8 +1329,14 @@ Hsetlength(int32 aid, int32 length)
   if (BADFREC(file_rec))
     HGOTO_ERROR(DFE_ARGS, FAIL);
 
-  /* place the data element at the end of the file and record its offset */
-  if ((offset = HPgetdiskblock(file_rec, length, FALSE)) == FAIL)
+  /* place the data element in the file and record its offset.  Elements
+     which may grow are kept at the end of the file, so they can be extended
+     without being converted to linked blocks */
+  if (access_rec->appendable)
+      offset = HIappend_diskblock(file_rec, length, FALSE);
+  else
+      offset = HPgetdiskblock(file_rec, length, FALSE);
+  if (offset == FAIL)
       HGOTO_ERROR(DFE_SEEKERROR, FAIL);
 
   /* fill in dd record updating the offset and length of the element */
@@ -1149,6 +1374,8 @@ DESCRIPTION
 intn
 Happendable(int32 aid)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(aid);
   CONSTR(FUNC, "Happendable");	/* for HERROR */
   accrec_t   *access_rec;		/* access record */
   intn   ret_value = SUCCEED;
@@ -1190,11 +1417,13 @@ DESCRIPTION
 intn
 HPisappendable(int32 aid)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(aid);
   CONSTR(FUNC, "HPisappendable");		/* for HERROR */
   accrec_t   *access_rec;		/* access record */
   filerec_t  *file_rec;		/* file record */
   int32       data_len;		/* length of the data we are checking */
-  int32       data_off;		/* offset of the data we are checking */
+  hdf_off_t   data_off;		/* offset of the data we are checking */
   intn        ret_value = SUCCEED;
 
   /* clear error stack and check validity of file id */
@@ -1207,7 +1436,7 @@ HPisappendable(int32 aid)
     HGOTO_ERROR(DFE_ARGS, FAIL);
 
   /* get the offset and length of the dataset */
-  if(HTPinquire(access_rec->ddid,NULL,NULL,&data_len,&data_off)==FAIL)
+  if(HTPinquire(access_rec->ddid,NULL,NULL,&data_off,&data_len)==FAIL)
     HGOTO_ERROR(DFE_ARGS, FAIL);
 
   /* dataset at end? */
@@ -1250,12 +1479,14 @@ DESCRIPTION
 intn
 Hseek(int32 access_id, int32 offset, intn origin)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
   CONSTR(FUNC, "Hseek");	/* for HERROR */
   accrec_t   *access_rec;		/* access record */
   intn        old_offset = offset;	/* save for later potential use */
   filerec_t  *file_rec;		/* file record */
   int32       data_len;		/* length of the data we are checking */
-  int32       data_off;		/* offset of the data we are checking */
+  hdf_off_t   data_off;		/* offset of the data we are checking */
   intn        ret_value = SUCCEED;
 
   /* clear error stack and check validity of this access id */
@@ -1349,6 +1580,8 @@ DESCRIPTION
 int32
 Htell(int32 access_id)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
   CONSTR(FUNC, "Htell");	/* for HERROR */
   accrec_t   *access_rec;		/* access record */
   int32     ret_value = SUCCEED;
@@ -1388,16 +1621,20 @@ DESCRIPTION
    Read in the next segment in the data element pointed to by the
    access elt.  If length is zero or larger than the remaining bytes
    of the object, read until the end of the object.
+   Reads going on from where the last one ended make the file driver
+   read ahead of them, see Hreadahead().
 
 --------------------------------------------------------------------------*/
 int32
 Hread(int32 access_id, int32 length, void * data)
 {
+    HTS_READ_LOCK(access_id);
   CONSTR(FUNC, "Hread");	/* for HERROR */
   filerec_t  *file_rec;		/* file record */
   accrec_t   *access_rec;		/* access record */
   int32       data_len;		/* length of the data we are checking */
-  int32       data_off;		/* offset of the data we are checking */
+  hdf_off_t   data_off;		/* offset of the data we are checking */
+  intn        sequential;       /* whether this read goes on from the last */
   int32      ret_value = SUCCEED;
 
   /* clear error stack and check validity of access id */
@@ -1430,21 +1667,27 @@ Hread(int32 access_id, int32 length, void * data)
   if(HTPinquire(access_rec->ddid,NULL,NULL,&data_off,&data_len)==FAIL)
       HGOTO_ERROR(DFE_INTERNAL, FAIL);
       
-  /* seek to position to start reading and read in data */
-  if (HPseek(file_rec, access_rec->posn + data_off) == FAIL)
-    HGOTO_ERROR(DFE_SEEKERROR, FAIL);
-
   /* length == 0 means to read to end of element, */
   /* if read length exceeds length of elt, read till end of elt */
   if (length == 0 || length + access_rec->posn > data_len)
     length = data_len - access_rec->posn;
 
-  /* read in data */
-  if (HP_read(file_rec, data, length) == FAIL)
+  /* read in data from the position to start reading */
+  if (HP_pread(file_rec, data, length, access_rec->posn + data_off) == FAIL)
     HGOTO_ERROR(DFE_READERROR, FAIL);
 
+  /* a read going on from where the last one ended is taken to be part
+     of a sequential scan of the element */
+  sequential = (access_rec->ra_next > 0 && access_rec->posn == access_rec->ra_next);
+
   /* move the position of the access record */
   access_rec->posn += length;
+  access_rec->ra_next = access_rec->posn;
+
+  if (sequential)
+    HIread_ahead(file_rec, access_rec, data_off, data_len);
+  else
+    access_rec->ra_end = access_rec->posn;
 
   ret_value = length;
 
@@ -1481,11 +1724,13 @@ DESCRIPTION
 int32
 Hwrite(int32 access_id, int32 length, const void * data)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
   CONSTR(FUNC, "Hwrite");		/* for HERROR */
   filerec_t  *file_rec;		/* file record */
   accrec_t   *access_rec;		/* access record */
   int32       data_len;		/* length of the data we are checking */
-  int32       data_off;		/* offset of the data we are checking */
+  hdf_off_t   data_off;		/* offset of the data we are checking */
   int32       ret_value = SUCCEED;
 
   /* clear error stack and check validity of access id */
@@ -1513,8 +1758,8 @@ Hwrite(int32 access_id, int32 length, const void * data)
      Does this mean every element is by default appendable? */
   if (access_rec->new_elem == TRUE)
     {
-      Hsetlength(access_id, length);	/* make the initial chunk of data */
       access_rec->appendable = TRUE;	/* make it appendable */
+      Hsetlength(access_id, length);	/* make the initial chunk of data */
     }		/* end if */
 
 
@@ -1557,16 +1802,13 @@ Hwrite(int32 access_id, int32 length, const void * data)
           HGOTO_ERROR(DFE_INTERNAL, FAIL);
     }		/* end if */
 
-  /* seek and write data */
-  if (HPseek(file_rec, access_rec->posn + data_off) == FAIL)
-    HGOTO_ERROR(DFE_SEEKERROR, FAIL);
-
-  if (HP_write(file_rec, data, length) == FAIL)
+  /* write data at the access position */
+  if (HP_pwrite(file_rec, data, length, access_rec->posn + data_off) == FAIL)
     HGOTO_ERROR(DFE_WRITEERROR, FAIL);
 
   /* update end of file pointer? */
-  if (file_rec->f_cur_off > file_rec->f_end_off)
-    file_rec->f_end_off = file_rec->f_cur_off;
+  if (access_rec->posn + data_off + length > file_rec->f_end_off)
+    file_rec->f_end_off = access_rec->posn + data_off + length;
 
   /* update position of access in elt */
   access_rec->posn += length;
@@ -1601,6 +1843,8 @@ DESCRIPTION
 intn
 HDgetc(int32 access_id)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
   CONSTR(FUNC, "HDgetc");		 /* for HERROR */
   uint8       c=(uint8)FAIL;		     /* character read in */
   intn    ret_value = SUCCEED;
@@ -1640,6 +1884,8 @@ DESCRIPTION
 intn
 HDputc(uint8 c, int32 access_id)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
   CONSTR(FUNC, "HDputc");		/* for HERROR */
   intn ret_value = SUCCEED;
 
@@ -1679,6 +1925,8 @@ DESCRIPTION
 intn
 Hendaccess(int32 access_id)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
     CONSTR(FUNC, "Hendaccess");		/* for HERROR */
     filerec_t  *file_rec;		/* file record */
     accrec_t   *access_rec=NULL;/* access record */
@@ -1744,6 +1992,8 @@ DESCRIPTION
 int32
 Hgetelement(int32 file_id, uint16 tag, uint16 ref, uint8 *data)
 {
+  /* No API lock: each of the H routines called takes what it needs, so
+     that Hread runs without it */
   CONSTR(FUNC, "Hgetelement");	/* for HERROR */
   int32       access_id=FAIL;   /* access record id */
   int32       length;			/* length of this elt */
@@ -1776,6 +2026,170 @@ done:
   return ret_value;
 }	/* Hgetelement() */
 
+/*--------------------------------------------------------------------------
+NAME
+   Hreadv -- read in parts of several data elements
+USAGE
+   intn Hreadv(file_id, nreqs, reqs)
+   int32 file_id;            IN: id of file
+   intn nreqs;               IN: # of requests
+   hdf_readreq_t reqs[];     IN/OUT: the data to read
+RETURNS
+   returns SUCCEED (0) if all the requests were read and FAIL (-1)
+   otherwise
+DESCRIPTION
+   Reads 'length' bytes from 'offset' in each of the elements 'tag'/'ref'
+   into 'buf', and sets 'nread' to the # of bytes read.  As with Hread(),
+   a length of 0 or one going past the end of an element reads to the
+   end of the element.
+   The DDs of all the elements are looked up first, then the data is read
+   in the order it lies in the file.  Requests no more than READV_MAX_GAP
+   bytes apart are read with a single read of up to READV_MAX_SPAN bytes,
+   so many small elements cost few reads instead of an Hstartread(),
+   Hread() and Hendaccess() each.
+COMMENTS, BUGS, ASSUMPTIONS
+   Special elements (compressed, chunked, linked blocks, ...) don't lie
+   in one piece in the file, they are read one by one through Hread().
+   If the call fails, the data of some requests may have been read.
+--------------------------------------------------------------------------*/
+intn
+Hreadv(int32 file_id, intn nreqs, hdf_readreq_t reqs[])
+{
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
+  CONSTR(FUNC, "Hreadv");	/* for HERROR */
+  filerec_t  *file_rec;		/* file record */
+  readv_piece_t *pieces=NULL;   /* the requests read straight from the file */
+  intn        npieces=0;        /* # of pieces */
+  uint8      *tbuf=NULL;        /* buffer for reads serving several pieces */
+  int32       tbuf_size=0;      /* size of the buffer */
+  int32       access_id=FAIL;   /* access record id of a special element */
+  atom_t      ddid;             /* DD id of an element */
+  hdf_off_t   data_off;		/* offset of the element */
+  int32       data_len;		/* length of the element */
+  hdf_off_t   start, end;       /* part of the file read at once */
+  intn        i, j, k;
+  intn        ret_value = SUCCEED;
+
+  /* clear error stack and check validity of the arguments */
+  HEclear();
+  file_rec = HAatom_object(file_id);
+  if (BADFREC(file_rec) || nreqs < 0 || (nreqs > 0 && reqs == NULL))
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+  if (nreqs == 0)
+    HGOTO_DONE(SUCCEED);
+
+  if ((pieces = (readv_piece_t *)HDmalloc((uint32)nreqs * sizeof(readv_piece_t))) == NULL)
+    HGOTO_ERROR(DFE_NOSPACE, FAIL);
+
+  /* find where in the file each request lies */
+  for (i = 0; i < nreqs; i++)
+    {
+      reqs[i].nread = 0;
+      if (reqs[i].offset < 0 || reqs[i].length < 0 || reqs[i].buf == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+      if ((ddid = HTPselect(file_rec, BASETAG(reqs[i].tag), reqs[i].ref)) == FAIL)
+        HGOTO_ERROR(DFE_NOMATCH, FAIL);
+      if (HTPis_special(ddid) == TRUE)
+        {
+          if (HTPendaccess(ddid) == FAIL)
+            HGOTO_ERROR(DFE_CANTENDACCESS, FAIL);
+
+          /* let the special element's own routines read it */
+          if ((access_id = Hstartread(file_id, reqs[i].tag, reqs[i].ref)) == FAIL)
+            HGOTO_ERROR(DFE_NOMATCH, FAIL);
+          if (Hseek(access_id, reqs[i].offset, DF_START) == FAIL)
+            HGOTO_ERROR(DFE_BADSEEK, FAIL);
+          if ((reqs[i].nread = Hread(access_id, reqs[i].length, reqs[i].buf)) == FAIL)
+            HGOTO_ERROR(DFE_READERROR, FAIL);
+          if (Hendaccess(access_id) == FAIL)
+            HGOTO_ERROR(DFE_CANTENDACCESS, FAIL);
+          access_id = FAIL;
+          continue;
+        } /* end if */
+
+      if (HTPinquire(ddid, NULL, NULL, &data_off, &data_len) == FAIL)
+        {
+          HTPendaccess(ddid);
+          HGOTO_ERROR(DFE_INTERNAL, FAIL);
+        } /* end if */
+      if (HTPendaccess(ddid) == FAIL)
+        HGOTO_ERROR(DFE_CANTENDACCESS, FAIL);
+
+      /* Don't allow reading of "new" elements */
+      if (data_off == INVALID_OFFSET && data_len == INVALID_LENGTH)
+        HGOTO_ERROR(DFE_READERROR, FAIL);
+      if (reqs[i].offset > data_len)
+        HGOTO_ERROR(DFE_BADSEEK, FAIL);
+
+      pieces[npieces].file_off = data_off + reqs[i].offset;
+      if (reqs[i].length == 0 || reqs[i].length > data_len - reqs[i].offset)
+        pieces[npieces].len = data_len - reqs[i].offset;
+      else
+        pieces[npieces].len = reqs[i].length;
+      pieces[npieces].req = i;
+      if (pieces[npieces].len > 0)
+        npieces++;
+    } /* end for */
+
+  HDqsort(pieces, npieces, sizeof(readv_piece_t), HIcompare_readv_piece);
+
+  for (i = 0; i < npieces; i = j)
+    {
+      /* take in the following pieces close enough to share the read */
+      start = pieces[i].file_off;
+      end = start + pieces[i].len;
+      for (j = i + 1; j < npieces; j++)
+        {
+          if (pieces[j].file_off > end + READV_MAX_GAP
+              || MAX(end, pieces[j].file_off + pieces[j].len) - start > READV_MAX_SPAN)
+            break;
+          end = MAX(end, pieces[j].file_off + pieces[j].len);
+        } /* end for */
+
+      if (j == i + 1)
+        { /* read straight into the caller's buffer */
+          if (HP_pread(file_rec, reqs[pieces[i].req].buf, pieces[i].len, start) == FAIL)
+            HGOTO_ERROR(DFE_READERROR, FAIL);
+        } /* end if */
+      else
+        {
+          if (end - start > tbuf_size)
+            {
+              if (tbuf != NULL)
+                HDfree(tbuf);
+              if ((tbuf = (uint8 *)HDmalloc((uint32)(end - start))) == NULL)
+                HGOTO_ERROR(DFE_NOSPACE, FAIL);
+              tbuf_size = (int32)(end - start);
+            } /* end if */
+          if (HP_pread(file_rec, tbuf, (int32)(end - start), start) == FAIL)
+            HGOTO_ERROR(DFE_READERROR, FAIL);
+          for (k = i; k < j; k++)
+            HDmemcpy(reqs[pieces[k].req].buf, tbuf + (pieces[k].file_off - start),
+                pieces[k].len);
+        } /* end else */
+
+      for (k = i; k < j; k++)
+        reqs[pieces[k].req].nread = pieces[k].len;
+    } /* end for */
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+        if(access_id!=FAIL)
+          Hendaccess(access_id);
+    } /* end if */
+
+  /* Normal function cleanup */
+  if (pieces != NULL)
+    HDfree(pieces);
+  if (tbuf != NULL)
+    HDfree(tbuf);
+
+  return ret_value;
+}	/* Hreadv() */
+
 /*--------------------------------------------------------------------------
 NAME
    Hputelement -- writes a data element
@@ -1798,6 +2212,8 @@ int32
 Hputelement(int32 file_id, uint16 tag, uint16 ref, const uint8 *data,
 			int32 length)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
   CONSTR(FUNC, "Hputelement");	/* for HERROR */
   int32       access_id=FAIL;   /* access record id */
   int32       ret_value = SUCCEED;
@@ -1848,6 +2264,8 @@ DESCRIPTION
 int32
 Hlength(int32 file_id, uint16 tag, uint16 ref)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
 #ifdef FASTER_BUT_DOESNT_WORK
   CONSTR(FUNC, "Hlength");	/* for HERROR */
   filerec_t  *file_rec;		/* file record */
@@ -1936,6 +2354,8 @@ DESCRIPTION
 int32
 Hoffset(int32 file_id, uint16 tag, uint16 ref)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
   CONSTR(FUNC, "Hoffset");	/* for HERROR */
   int32       access_id;	/* access record id */
   int32       offset=FAIL;	/* offset of elt inquired */
@@ -1985,27 +2405,31 @@ DESCRIPTION
 intn
 Hishdf(const char *filename)
 {
+    HTS_API_LOCK;
 #ifdef LATER
   CONSTR(FUNC, "Hishdf");
 #endif /* LATER */
 
   intn        ret;
-  hdf_file_t  fp;
+  const hdf_fdriver_t *driver;
+  void       *fp;
   intn   ret_value = TRUE;
 
   /* Search for a matching slot in the already open files. */
   if(HAsearch_atom(FIDGROUP,HPcompare_filerec_path,filename)!=NULL)
       HGOTO_DONE(TRUE);
 
-  fp =  (hdf_file_t)HI_OPEN(filename, DFACC_READ);
-  if (OPENERR(fp))
+  /* only the magic cookie is needed, so never read the file in */
+  driver = HPget_driver(HDF_DRIVER_DEFAULT);
+  fp = (*driver->open)(filename, DFACC_READ);
+  if (fp == NULL)
     {
       ret_value = FALSE;
     }
   else
     {
-      ret = HIvalid_magic(fp);
-      HI_CLOSE(fp);
+      ret = HIvalid_magic(driver, fp, NULL);
+      (*driver->close)(fp);
       ret_value = (int) ret;
     }
 
@@ -2036,10 +2460,12 @@ DESCRIPTION
 int32
 Htrunc(int32 aid, int32 trunc_len)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(aid);
   CONSTR(FUNC, "Htrunc");		/* for HERROR */
   accrec_t   *access_rec;		/* access record */
   int32       data_len;		/* length of the data we are checking */
-  int32       data_off;		/* offset of the data we are checking */
+  hdf_off_t   data_off;		/* offset of the data we are checking */
   int32      ret_value = SUCCEED;
 
   /* clear error stack and check validity of access id */
@@ -2121,6 +2547,10 @@ HIsync(filerec_t *file_rec)
       file_rec->dirty = 0;	/* file doesn't need to be flushed now */
     }		/* end if */
 
+  /* write out the small writes gathered so far */
+  if (HPflush_writes(file_rec) == FAIL)
+    HGOTO_ERROR(DFE_CANTFLUSH, FAIL);
+
 done:
   if(ret_value == FAIL)   
     { /* Error condition cleanup */
@@ -2141,10 +2571,9 @@ USAGE
 RETURNS
    returns SUCCEED (0) if sucessful, FAIL (-1) otherwise
 DESCRIPTION
-   Currently, the on-disk and in-memory representations are always
-   the same.  Thus there is no real use for Hsync().  In the future,
-   things may be buffered before being written out at which time
-   Hsync() will be useful to sync up the on-disk representation.
+   Writes out the DD blocks cached in memory and the small writes
+   gathered in the write buffer of the file, so that the file on disk
+   is up to date.
 NOTE
    First tests of caching DD's until close.
 
@@ -2152,6 +2581,8 @@ NOTE
 intn
 Hsync(int32 file_id)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
   CONSTR(FUNC, "Hsync");	/* for HERROR */
   filerec_t  *file_rec;		/* file record */
   intn        ret_value = SUCCEED;
@@ -2192,6 +2623,8 @@ DESCRIPTION
 intn
 Hcache(int32 file_id, intn cache_on)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
   CONSTR(FUNC, "Hcache");		/* for HERROR */
   filerec_t  *file_rec;		/* file record */
   intn        ret_value = SUCCEED;
@@ -2228,85 +2661,150 @@ done:
 
 /*--------------------------------------------------------------------------
 NAME
-   HDvalidfid -- check if a file ID is valid
+   Hmmap -- set memory-mapped reading for a file
 USAGE
-   int HDvalidfid(file_id)
-   int32 file_id;            IN: id of file
+   intn Hmmap(file_id,mmap_on)
+	   int32 file_id;            IN: id of file
+	   intn mmap_on;             IN: whether to map the file or not
 RETURNS
-   returns TRUE if valid ID else FALSE
+   returns SUCCEED (0) if sucessful, FAIL (-1) otherwise
 DESCRIPTION
-   Determine whether a given int32 is a valid HDF file ID or not
-
+   Map/unmap an HDF file opened read-only.  While a file is mapped, all
+   low-level reads from it are copied straight out of the mapping instead
+   of going through a system call for each read.
+   If file_id is set to MMAP_ALL_FILES, then the value of mmap_on is
+   used to modify the default mapping state of files Hopen'ed read-only
+   afterwards.  Files are not mapped by default.
+COMMENTS, BUGS, ASSUMPTIONS
+   Files opened for writing cannot be mapped, and a mapped file is
+   unmapped if it is re-opened for writing.  Not every platform and file
+   driver supports mapping files, DFE_UNSUPPORTED is reported where it
+   is not.
 --------------------------------------------------------------------------*/
 intn
-HDvalidfid(int32 file_id)
+Hmmap(int32 file_id, intn mmap_on)
 {
-  filerec_t  *file_rec;
-  intn        ret_value = TRUE;
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
+  CONSTR(FUNC, "Hmmap");		/* for HERROR */
+  filerec_t  *file_rec;		/* file record */
+  intn        ret_value = SUCCEED;
 
-  /* convert file id to file rec and check for validity */
-  file_rec = HAatom_object(file_id);
-  if (BADFREC(file_rec))
-    ret_value = FALSE;
+  if (file_id == MMAP_ALL_FILES)/* check whether to modify the default */
+    {	/* set the default mapping for all further files Hopen'ed */
+      default_mmap = (mmap_on != 0 ? TRUE : FALSE);
+    }	/* end if */
+  else
+    {
+      /* check validity of file record */
+      file_rec = HAatom_object(file_id);
+      if (BADFREC(file_rec))
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+      if (mmap_on != FALSE)
+        {
+          if (file_rec->access & DFACC_WRITE)
+            HGOTO_ERROR(DFE_BADACC, FAIL);
+          if (file_rec->driver->map == NULL)
+            HGOTO_ERROR(DFE_UNSUPPORTED, FAIL);
+          if (HImap_file(file_rec) == FAIL)
+            HGOTO_ERROR(DFE_READERROR, FAIL);
+        } /* end if */
+      else
+        {
+          if (HIunmap_file(file_rec) == FAIL)
+            HGOTO_ERROR(DFE_INTERNAL, FAIL);
+        } /* end else */
+    }		/* end else */
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
 
+    } /* end if */
+
+  /* Normal function cleanup */
   return ret_value;
-}	/* HDvalidfid */
+}	/* Hmmap */
 
 /*--------------------------------------------------------------------------
-HDerr --  Closes a file and return FAIL.  
-	   Replacement for DFIerr in HDF3.1 and before
+NAME
+   Hsetdriver -- set the file driver for files opened from now on
+USAGE
+   intn Hsetdriver(driver_id)
+	   intn driver_id;           IN: HDF_DRIVER_* number of the driver
+RETURNS
+   returns SUCCEED (0) if sucessful, FAIL (-1) otherwise
+DESCRIPTION
+   Selects the file driver which does the low-level I/O of the files
+   Hopen'ed (and so SDstart'ed, etc.) after this call:
+       HDF_DRIVER_DEFAULT - the POSIX driver if the system has positional
+                            I/O, the stdio driver otherwise
+       HDF_DRIVER_POSIX   - POSIX file descriptors
+       HDF_DRIVER_STDIO   - C buffered streams
+       HDF_DRIVER_CORE    - the whole file is kept in memory and written
+                            out with a single write when it is closed
+   Files already open keep the driver they were opened with, the driver
+   in effect when a file is first opened is used for all its opens.
+
+   This is the default for the whole process, set under the API lock.  A
+   thread which needs a driver for its own files, without changing it for
+   the others, opens them with Hopendriver() instead.
+COMMENTS, BUGS, ASSUMPTIONS
+   Nothing of a file opened with the core driver is on disk before it is
+   closed, and an error writing it out is reported by Hclose().
 --------------------------------------------------------------------------*/
-int
-HDerr(int32 file_id)
+intn
+Hsetdriver(intn driver_id)
 {
-  Hclose(file_id);
-  return FAIL;
-}
+    HTS_API_LOCK;
+  CONSTR(FUNC, "Hsetdriver");		/* for HERROR */
+  intn        ret_value = SUCCEED;
+
+  HEclear();
+  if (HPget_driver(driver_id) == NULL)
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+
+  default_driver = driver_id;
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+  return ret_value;
+}	/* Hsetdriver */
 
 /*--------------------------------------------------------------------------
 NAME
-   Hsetacceesstype -- set the I/O access type (serial, parallel, ...)
-					  of a data element
+   Hgetdriver -- get the file driver of an open file
 USAGE
-   intn Hsetacceesstype(access_id, accesstype)
-   int32 access_id;        IN: id of access element
-   uintn accesstype;       IN: I/O access type
+   intn Hgetdriver(file_id)
+	   int32 file_id;            IN: id of file
 RETURNS
-   returns FAIL (-1) if fail, SUCCEED (0) otherwise.
+   returns the HDF_DRIVER_* number of the driver the file is accessed
+   with, FAIL (-1) otherwise
 DESCRIPTION
-   Set the type of I/O for accessing the data element to
-   accesstype.
-
+   HDF_DRIVER_DEFAULT is never returned, the driver it stood for when the
+   file was opened is.
 --------------------------------------------------------------------------*/
 intn
-Hsetaccesstype(int32 access_id, uintn accesstype)
+Hgetdriver(int32 file_id)
 {
-  CONSTR(FUNC, "Hsetaccesstype");		/* for HERROR */
-  accrec_t   *access_rec;		/* access record */
-  intn       ret_value = SUCCEED;
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
+  CONSTR(FUNC, "Hgetdriver");		/* for HERROR */
+  filerec_t  *file_rec;		/* file record */
+  intn        ret_value = FAIL;
 
-  /* clear error stack and check validity of this access id */
   HEclear();
-
-  access_rec = HAatom_object(access_id);
-  if (access_rec == (accrec_t *) NULL)
-    HGOTO_ERROR(DFE_ARGS, FAIL);
-  if (accesstype != DFACC_DEFAULT && accesstype != DFACC_SERIAL &&
-      accesstype != DFACC_PARALLEL)
+  file_rec = HAatom_object(file_id);
+  if (BADFREC(file_rec))
     HGOTO_ERROR(DFE_ARGS, FAIL);
 
-  if (accesstype == access_rec->access_type)
-    goto done;
-
-  /* kludge mode on */
-  if (accesstype != DFACC_PARALLEL)	/* go to PARALLEL only */
-    {
-      ret_value = FAIL;
-      goto done;
-    }
-  /* if special elt, call special function */
-  if (access_rec->special)
-    ret_value = HXPsetaccesstype(access_rec);
+  ret_value = file_rec->driver->id;
 
 done:
   if(ret_value == FAIL)   
@@ -2316,12 +2814,387 @@ done:
 
   /* Normal function cleanup */
   return ret_value;
-}	/* Hsetacceesstype() */
+}	/* Hgetdriver */
 
 /*--------------------------------------------------------------------------
- NAME
-    HDdont_atexit
- PURPOSE
+NAME
+   Hsetlazydd -- set lazy reading of the DD list for files opened from now on
+USAGE
+   intn Hsetlazydd(lazy_on)
+	   intn lazy_on;             IN: TRUE to read the DD list in lazily
+RETURNS
+   returns SUCCEED (0) if sucessful, FAIL (-1) otherwise
+DESCRIPTION
+   Normally Hopen() reads in all the DD blocks of a file and indexes all
+   the tag/refs in it before returning.  With lazy reading turned on only
+   the first DD block of a file opened read-only is read in at Hopen(),
+   the rest are read in, one block at a time, when a look-up of a tag/ref
+   or a search through the DD list gets to them.  Counting objects
+   (Hnumber) and re-opening the file for writing read in the whole DD
+   list.
+
+   This sets the default for all files; a single file can be opened with
+   lazy reading by or'ing DFACC_LAZYDD into the access of Hopen() instead,
+   which does not affect files other threads open.  The default is read
+   at Hopen() under the API lock in the thread-safe build.
+COMMENTS, BUGS, ASSUMPTIONS
+   This only saves time for programs that touch a few objects by tag/ref
+   in files with many DD blocks.  The SD, GR and V interfaces search the
+   whole DD list when they start on a file, so they read all of it in
+   anyway.
+--------------------------------------------------------------------------*/
+intn
+Hsetlazydd(intn lazy_on)
+{
+    HTS_API_LOCK;
+  default_lazydd = (lazy_on != 0 ? TRUE : FALSE);
+
+  return SUCCEED;
+}	/* Hsetlazydd */
+
+/*--------------------------------------------------------------------------
+NAME
+   Hmergedd -- set merging of the DD blocks when a file is closed
+USAGE
+   intn Hmergedd(file_id,merge_on)
+	   int32 file_id;            IN: id of file
+	   intn merge_on;            IN: whether to merge the DD blocks or not
+RETURNS
+   returns SUCCEED (0) if sucessful, FAIL (-1) otherwise
+DESCRIPTION
+   A file which gets a few objects added at a time ends up with a long
+   chain of small DD blocks, and opening it takes one seek and read per
+   block.  With merging turned on, the last Hclose() of a file opened for
+   writing rewrites the DD list as the first DD block followed by a single
+   block holding all the other DDs, re-using the space of the second block
+   if it is big enough and appending the block to the file otherwise.
+   If file_id is set to MERGEDD_ALL_FILES, then the value of merge_on is
+   used to set the default for all files Hopen'ed afterwards.
+COMMENTS, BUGS, ASSUMPTIONS
+   The space of the old DD blocks is given back with HPfreediskblock().
+--------------------------------------------------------------------------*/
+intn
+Hmergedd(int32 file_id, intn merge_on)
+{
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
+  CONSTR(FUNC, "Hmergedd");		/* for HERROR */
+  filerec_t  *file_rec;		/* file record */
+  intn        ret_value = SUCCEED;
+
+  if (file_id == MERGEDD_ALL_FILES)/* check whether to modify the default */
+    {	/* set the default merging for all further files Hopen'ed */
+      default_mergedd = (merge_on != 0 ? TRUE : FALSE);
+    }	/* end if */
+  else
+    {
+      /* check validity of file record */
+      file_rec = HAatom_object(file_id);
+      if (BADFREC(file_rec))
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+      file_rec->mergedd = (merge_on != 0 ? TRUE : FALSE);
+    }		/* end else */
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+  return ret_value;
+}	/* Hmergedd */
+
+/*--------------------------------------------------------------------------
+NAME
+   Hwritebuf -- set the size of the buffer for small writes to a file
+USAGE
+   intn Hwritebuf(file_id,size)
+	   int32 file_id;            IN: id of file
+	   int32 size;               IN: size of the buffer in bytes, 0 for none
+RETURNS
+   returns SUCCEED (0) if sucessful, FAIL (-1) otherwise
+DESCRIPTION
+   Writes to a file which are smaller than its write buffer are gathered
+   in the buffer while each one starts next to or inside the data already
+   there, and go out as one write when the next write lands elsewhere,
+   the buffer fills up, or the file is Hsync'ed or closed.  Creating the
+   objects of a file makes many small writes of headers and DDs, mostly
+   one after the other, which this turns into a few large ones.
+   If file_id is set to WRITEBUF_ALL_FILES, then size is used for all
+   files Hopen'ed afterwards.  The default is DEF_WRITEBUF_SIZE bytes,
+   no buffer: the buffer is only used by files it is asked for.
+COMMENTS, BUGS, ASSUMPTIONS
+   Errors writing the buffered data are only reported by the call which
+   writes the buffer out, Hsync() or Hclose() at the latest.  Until then
+   the file itself doesn't have the data, which matters to readers of
+   the file going by the offsets from HDgetdatainfo().  Files using the
+   core driver don't take the size set for all files.
+--------------------------------------------------------------------------*/
+intn
+Hwritebuf(int32 file_id, int32 size)
+{
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
+  CONSTR(FUNC, "Hwritebuf");		/* for HERROR */
+  filerec_t  *file_rec;		/* file record */
+  intn        ret_value = SUCCEED;
+
+  if (size < 0)
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+
+  if (file_id == WRITEBUF_ALL_FILES)/* check whether to modify the default */
+    {	/* set the buffer size for all further files Hopen'ed */
+      default_writebuf = size;
+    }	/* end if */
+  else
+    {
+      /* check validity of file record */
+      file_rec = HAatom_object(file_id);
+      if (BADFREC(file_rec))
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+      /* the buffer is re-allocated at the new size when next needed */
+      if (HPflush_writes(file_rec) == FAIL)
+        HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+      if (file_rec->wbuf != NULL)
+        {
+          HDfree(file_rec->wbuf);
+          file_rec->wbuf = NULL;
+        } /* end if */
+      file_rec->wbuf_size = size;
+    }		/* end else */
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+  return ret_value;
+}	/* Hwritebuf */
+
+/*--------------------------------------------------------------------------
+NAME
+   Hgetiostats -- get the I/O statistics of a file or of all files
+USAGE
+   intn Hgetiostats(file_id,stats)
+	   int32 file_id;            IN: id of file
+	   hdf_iostats_t *stats;     OUT: the statistics
+RETURNS
+   returns SUCCEED (0) if sucessful, FAIL (-1) otherwise
+DESCRIPTION
+   Returns the counts of the reads and writes passed to the file driver,
+   the bytes they moved, the time spent in them, and the number of DD
+   blocks read in, since the file was opened.  A read or write which
+   doesn't continue where the last one on the same file ended counts as a
+   seek, one which does counts as a seek avoided.
+   If file_id is set to IOSTATS_ALL_FILES, the statistics of all the
+   files opened by the library so far, closed ones included, are
+   returned.
+COMMENTS, BUGS, ASSUMPTIONS
+   Reads served from a file mapping or from the write buffer, and writes
+   still in the write buffer, are not counted since they make no call to
+   the driver.  The I/O time is 0 where there is no clock to read.
+--------------------------------------------------------------------------*/
+intn
+Hgetiostats(int32 file_id, hdf_iostats_t *stats)
+{
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
+  CONSTR(FUNC, "Hgetiostats");		/* for HERROR */
+  filerec_t  *file_rec;		/* file record */
+  intn        ret_value = SUCCEED;
+
+  if (stats == NULL)
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+
+  if (file_id == IOSTATS_ALL_FILES)
+    {
+      HTS_MUTEX_LOCK(lib_iostats_lock);
+      *stats = lib_iostats;
+      HTS_MUTEX_UNLOCK(lib_iostats_lock);
+    }	/* end if */
+  else
+    {
+      /* check validity of file record */
+      file_rec = HAatom_object(file_id);
+      if (BADFREC(file_rec))
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+      *stats = file_rec->iostats;
+    }		/* end else */
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+  return ret_value;
+}	/* Hgetiostats */
+
+/*--------------------------------------------------------------------------
+NAME
+   Hreadahead -- set the # of bytes read ahead of sequential reads
+USAGE
+   intn Hreadahead(file_id,size)
+	   int32 file_id;            IN: id of file
+	   int32 size;               IN: # of bytes to read ahead, 0 for none
+RETURNS
+   returns SUCCEED (0) if sucessful, FAIL (-1) otherwise
+DESCRIPTION
+   When an element is read by Hread()s each going on from where the last
+   one ended, such as an SDS or a vdata read from start to end, the file
+   driver is asked to start reading up to 'size' bytes of the element
+   after the data read so far.  The system does this while the data
+   already read is being worked on, so the next Hread() finds its data in
+   memory.  If file_id is set to READAHEAD_ALL_FILES, then size is used
+   for all files Hopen'ed afterwards.  The default is DEF_READAHEAD_SIZE
+   bytes, none: only files it is asked for read ahead.
+COMMENTS, BUGS, ASSUMPTIONS
+   Only the POSIX and stdio drivers can read ahead, and only where the
+   system has posix_fadvise().  Elsewhere this setting has no effect.
+--------------------------------------------------------------------------*/
+intn
+Hreadahead(int32 file_id, int32 size)
+{
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
+  CONSTR(FUNC, "Hreadahead");		/* for HERROR */
+  filerec_t  *file_rec;		/* file record */
+  intn        ret_value = SUCCEED;
+
+  if (size < 0)
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+
+  if (file_id == READAHEAD_ALL_FILES)/* check whether to modify the default */
+    {	/* set the read-ahead for all further files Hopen'ed */
+      default_readahead = size;
+    }	/* end if */
+  else
+    {
+      /* check validity of file record */
+      file_rec = HAatom_object(file_id);
+      if (BADFREC(file_rec))
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+      file_rec->ra_size = size;
+    }		/* end else */
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+  return ret_value;
+}	/* Hreadahead */
+
+/*--------------------------------------------------------------------------
+NAME
+   HDvalidfid -- check if a file ID is valid
+USAGE
+   int HDvalidfid(file_id)
+   int32 file_id;            IN: id of file
+RETURNS
+   returns TRUE if valid ID else FALSE
+DESCRIPTION
+   Determine whether a given int32 is a valid HDF file ID or not
+
+--------------------------------------------------------------------------*/
+intn
+HDvalidfid(int32 file_id)
+{
+    HTS_API_LOCK;
+  filerec_t  *file_rec;
+  intn        ret_value = TRUE;
+
+  /* convert file id to file rec and check for validity */
+  file_rec = HAatom_object(file_id);
+  if (BADFREC(file_rec))
+    ret_value = FALSE;
+
+  return ret_value;
+}	/* HDvalidfid */
+
+/*--------------------------------------------------------------------------
+HDerr --  Closes a file and return FAIL.  
+	   Replacement for DFIerr in HDF3.1 and before
+--------------------------------------------------------------------------*/
+int
+HDerr(int32 file_id)
+{
+    HTS_API_LOCK;
+  Hclose(file_id);
+  return FAIL;
+}
+
+/*--------------------------------------------------------------------------
+NAME
+   Hsetacceesstype -- set the I/O access type (serial, parallel, ...)
+					  of a data element
+USAGE
+   intn Hsetacceesstype(access_id, accesstype)
+   int32 access_id;        IN: id of access element
+   uintn accesstype;       IN: I/O access type
+RETURNS
+   returns FAIL (-1) if fail, SUCCEED (0) otherwise.
+DESCRIPTION
+   Set the type of I/O for accessing the data element to
+   accesstype.
+
+--------------------------------------------------------------------------*/
+intn
+Hsetaccesstype(int32 access_id, uintn accesstype)
+{
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(access_id);
+  CONSTR(FUNC, "Hsetaccesstype");		/* for HERROR */
+  accrec_t   *access_rec;		/* access record */
+  intn       ret_value = SUCCEED;
+
+  /* clear error stack and check validity of this access id */
+  HEclear();
+
+  access_rec = HAatom_object(access_id);
+  if (access_rec == (accrec_t *) NULL)
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+  if (accesstype != DFACC_DEFAULT && accesstype != DFACC_SERIAL &&
+      accesstype != DFACC_PARALLEL)
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+
+  if (accesstype == access_rec->access_type)
+    goto done;
+
+  /* kludge mode on */
+  if (accesstype != DFACC_PARALLEL)	/* go to PARALLEL only */
+    {
+      ret_value = FAIL;
+      goto done;
+    }
+  /* if special elt, call special function */
+  if (access_rec->special)
+    ret_value = HXPsetaccesstype(access_rec);
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+  return ret_value;
+}	/* Hsetacceesstype() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HDdont_atexit
+ PURPOSE
     Indicates to the library that an 'atexit()' routine is _not_ to be installed
  USAGE
     intn HDdont_atexit(void)
@@ -2346,6 +3219,7 @@ done:
 --------------------------------------------------------------------------*/
 intn HDdont_atexit(void)
 {
+    HTS_API_LOCK;
 #ifdef LATER
     CONSTR(FUNC, "HDdont_atexit");    /* for HERROR */
 #endif /* LATER */
@@ -2455,6 +3329,7 @@ done:
 --------------------------------------------------------------------------*/
 intn HPregister_term_func(hdf_termfunc_t term_func)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "HPregister_term_func");    /* for HERROR */
     intn        ret_value = SUCCEED;
     if(library_terminate == FALSE)
@@ -2499,6 +3374,7 @@ done:
 --------------------------------------------------------------------------*/
 void HPend(void)
 {
+    HTS_API_LOCK;
 #ifdef LATER
     CONSTR(FUNC, "HPend");    /* for HERROR */
 #endif /* LATER */
@@ -2528,6 +3404,8 @@ void HPend(void)
     HPbitshutdown();
     HXPshutdown();
     Hshutdown();
+    HWshutdown();
+    HCSshutdown();
     HEshutdown();
     HAshutdown();
 #ifdef OLD_WAY
@@ -2593,7 +3471,7 @@ HIget_function_table(accrec_t * access_rec)
   int16       spec_code;
   uint8       lbuf[4];      /* temporary buffer */
   uint8      *p;		/* tmp buf ptr */
-  int32       data_off;		/* offset of the data we are checking */
+  hdf_off_t   data_off;		/* offset of the data we are checking */
   int         i;		/* loop index */
   funclist_t  *ret_value = NULL; /* FAIL */
 
@@ -2604,9 +3482,7 @@ HIget_function_table(accrec_t * access_rec)
   if(HTPinquire(access_rec->ddid,NULL,NULL,&data_off,NULL)==FAIL)
       HGOTO_ERROR(DFE_INTERNAL, NULL);
 
-  if (HPseek(file_rec, data_off) == FAIL)
-    HGOTO_ERROR(DFE_SEEKERROR, NULL);
-  if (HP_read(file_rec, lbuf, (int)2) == FAIL)
+  if (HP_pread(file_rec, lbuf, (int)2, data_off) == FAIL)
     HGOTO_ERROR(DFE_READERROR, NULL);
 
   /* using special code, look up function table in associative table */
@@ -2900,6 +3776,8 @@ intn
 Hgetfileversion(int32 file_id, uint32 *majorv, uint32 *minorv,
 				uint32 *release, char *string)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
   CONSTR(FUNC, "Hgetfileversion");
   filerec_t  *file_rec;
   intn      ret_value = SUCCEED;
@@ -3024,6 +3902,10 @@ HIget_filerec_node(const char *path)
         if((ret_value->path=(char *)HDstrdup(path))==NULL)
             HGOTO_ERROR(DFE_NOSPACE,NULL);
 
+#ifdef H4_HAVE_THREADSAFE
+        HTSIinit_lock(&ret_value->lock);
+#endif /* H4_HAVE_THREADSAFE */
+
         /* Initialize annotation stuff */
         ret_value->an_tree[AN_DATA_LABEL] = NULL;
         ret_value->an_tree[AN_DATA_DESC]  = NULL;
@@ -3065,13 +3947,31 @@ HIrelease_filerec_node(filerec_t *file_rec)
     CONSTR(FUNC, "HIrelease_filerec_node");
 #endif /* LATER */
 
+    /* Drop its chunks from the shared cache, the record may be reused */
+    HCSpurge(file_rec);
+
+    /* Release the file mapping, if any */
+    HIunmap_file(file_rec);
+
     /* Close file if it's opened */
     if(file_rec->file!=NULL)
-	HI_CLOSE(file_rec->file);
+	(*file_rec->driver->close)(file_rec->file);
 
     /* Free all the components of the file record */
+    if(file_rec->wbuf!=NULL)
+        HDfree(file_rec->wbuf);
+    while(file_rec->freelist!=NULL)
+      {
+        freeblock_t *next=file_rec->freelist->next;
+
+        HDfree(file_rec->freelist);
+        file_rec->freelist=next;
+      } /* end while */
     if(file_rec->path!=NULL)
         HDfree(file_rec->path);
+#ifdef H4_HAVE_THREADSAFE
+    pthread_mutex_destroy(&file_rec->lock);
+#endif /* H4_HAVE_THREADSAFE */
     HDfree(file_rec);
 
 #ifdef LATER
@@ -3089,14 +3989,70 @@ done:
 
 /*--------------------------------------------------------------------------
  NAME
-       HPisfile_in_use -- check if a FILE is currently in use
+       HImap_file -- map a file into memory
  USAGE
-       intn HPisfile_in_use(path)
-       const char * path;             IN: name of file
+       intn HImap_file(file_rec)
+       filerec_t *file_rec;         IN: File record of the file to map
  RETURNS
-       TRUE if the file is in use or FALSE, otherwise.
+       SUCCEED/FAIL
  DESCRIPTION
-        Get its record if the file is opened, then check its
+        Map the whole of a file opened read-only into memory, so that
+        HP_read() can copy out of the mapping.  Mapping a file which is
+        already mapped does nothing.  No error is pushed on failure, the
+        caller decides whether not being able to map is an error.
+
+--------------------------------------------------------------------------*/
+PRIVATE intn
+HImap_file(filerec_t *file_rec)
+{
+    if(file_rec->map_base!=NULL)
+        return SUCCEED;
+
+    if(file_rec->driver->map==NULL)
+        return FAIL;
+
+    return (*file_rec->driver->map)(file_rec->file, &file_rec->map_base,
+                                    &file_rec->map_len);
+}	/* HImap_file */
+
+/*--------------------------------------------------------------------------
+ NAME
+       HIunmap_file -- release the memory mapping of a file
+ USAGE
+       intn HIunmap_file(file_rec)
+       filerec_t *file_rec;         IN: File record of the mapped file
+ RETURNS
+       SUCCEED/FAIL
+ DESCRIPTION
+        Unmap a file mapped by HImap_file().  Files which aren't mapped
+        are left alone.
+
+--------------------------------------------------------------------------*/
+PRIVATE intn
+HIunmap_file(filerec_t *file_rec)
+{
+    if(file_rec->map_base!=NULL)
+      {
+        if((*file_rec->driver->unmap)(file_rec->file, file_rec->map_base,
+                                      file_rec->map_len) == FAIL)
+            return FAIL;
+        file_rec->map_base = NULL;
+        file_rec->map_len = 0;
+      } /* end if */
+
+    return SUCCEED;
+}	/* HIunmap_file */
+
+/*--------------------------------------------------------------------------
+ NAME
+       HPisfile_in_use -- check if a FILE is currently in use
+ USAGE
+       intn HPisfile_in_use(path)
+       const char * path;             IN: name of file
+ RETURNS
+       TRUE if the file is in use or FALSE, otherwise.
+ DESCRIPTION
+        Get its record if the file is opened, then check its
         reference count to decide whether the file is currently in use.
 
 --------------------------------------------------------------------------*/
@@ -3230,32 +4186,38 @@ done:
  NAME
        HIvalid_magic -- verify the magic number in a file
  USAGE
-       int32 HIvalid_magic(path)
-       hdf_file_t file;             IN: FILE pointer
+       intn HIvalid_magic(driver, file, largefile)
+       const hdf_fdriver_t *driver; IN: file driver the file is open with
+       void *file;                  IN: the driver's file handle
+       intn *largefile;             OUT: whether the file is in the large
+                                    file format, may be NULL
  RETURNS
        TRUE if valid magic number else FALSE
  DESCRIPTION
-       Given an open file pointer, see if the first four bytes of the
-       file are the HDF "magic number" HDFMAGIC
+       Given an open file, see if the first four bytes of the
+       file are the HDF "magic number" HDFMAGIC, or HDFMAGIC_LARGE for
+       files with 64-bit offsets in their DD list.
 
 --------------------------------------------------------------------------*/
 PRIVATE intn
-HIvalid_magic(hdf_file_t file)
+HIvalid_magic(const hdf_fdriver_t *driver, void *file, intn *largefile)
 {
   CONSTR(FUNC, "HIvalid_magic");
   char        b[MAGICLEN];	/* Temporary buffer */
   intn    ret_value = FALSE; /* FAIL */
 
-  /* Seek to beginning of the file. */
-  if (HI_SEEK(file, 0) == FAIL)
-    HGOTO_ERROR(DFE_SEEKERROR, FALSE);
-
-  /* Read in magic cookie and compare. */
-  if (HI_READ(file, b, MAGICLEN) == FAIL)
+  /* Read in magic cookie from the beginning of the file and compare. */
+  if ((*driver->read)(file, b, MAGICLEN, 0) == FAIL)
     HGOTO_ERROR(DFE_READERROR, FALSE);
 
   if (NSTREQ(b, HDFMAGIC, MAGICLEN))
     ret_value = TRUE;
+  else if (NSTREQ(b, HDFMAGIC_LARGE, MAGICLEN))
+    {
+      if (largefile != NULL)
+          *largefile = TRUE;
+      ret_value = TRUE;
+    }
 
 done:
   if(ret_value == FALSE)   
@@ -3281,6 +4243,7 @@ done:
 --------------------------------------------------------------------------*/
 accrec_t *HIget_access_rec(void)
 {
+    HTS_MUTEX_GUARD(accrec_lock);
     CONSTR(FUNC, "HIget_access_rec");
     accrec_t   *ret_value = NULL;
   
@@ -3325,6 +4288,7 @@ done:
 *******************************************************************************/
 void HIrelease_accrec_node(accrec_t *acc)
 {
+    HTS_MUTEX_GUARD(accrec_lock);
 #ifdef LATER
     CONSTR(FUNC, "HIrelease_atom_node");	/* for HERROR */
 #endif /* LATER */
@@ -3465,9 +4429,9 @@ done:
 
 /*-----------------------------------------------------------------------
 NAME
-   HPgetdiskblock --- Get the offset of a free block in the file.
+   HIappend_diskblock --- Allocate a block at the end of the file.
 USAGE
-   int32 HPgetdiskblock(file_rec, block_size)
+   hdf_off_t HIappend_diskblock(file_rec, block_size, moveto)
    filerec_t *file_rec;     IN: ptr to the file record
    int32 block_size;        IN: size of the block needed
    intn moveto;             IN: whether to move the file position
@@ -3476,23 +4440,29 @@ USAGE
 RETURNS
    returns offset of block in the file if successful, FAIL (-1) if failed.
 DESCRIPTION
-   Used to "allocate" space in the file.  Currently, it just appends
-   blocks to the end of the file willy-nilly.  At some point in the
-   future, this could be changed to use a "real" free-list of empty
-   blocks in the file and dole those out.
+   Appends a block to the end of the file, ignoring the free list.  Used
+   for elements which may be extended later, which can only be done
+   in place at the end of the file.
+
+   Files which are not in the large file format can't grow past the
+   32-bit offsets in their DD list.
 
 -------------------------------------------------------------------------*/
-int32
-HPgetdiskblock(filerec_t * file_rec, int32 block_size, intn moveto)
+PRIVATE hdf_off_t
+HIappend_diskblock(filerec_t * file_rec, int32 block_size, intn moveto)
 {
-  CONSTR(FUNC, "HPgetdiskblock");
+  CONSTR(FUNC, "HIappend_diskblock");
   uint8       temp;
-  int32       ret_value = SUCCEED;
+  hdf_off_t   ret_value = SUCCEED;
 
   /* check for valid arguments */
   if (file_rec == NULL || block_size < 0)
     HGOTO_ERROR(DFE_ARGS, FAIL);
 
+  if (!file_rec->largefile
+      && file_rec->f_end_off + block_size > MAX_OFFSET32)
+    HGOTO_ERROR(DFE_EXCEEDMAX, FAIL);
+
 
 #ifdef DISKBLOCK_DEBUG
   block_size+=(DISKBLOCK_HSIZE+DISKBLOCK_TSIZE);
@@ -3542,6 +4512,98 @@ HPgetdiskblock(filerec_t * file_rec, int32 block_size, intn moveto)
   /* incr. offset of end of file */
   file_rec->f_end_off +=block_size;
 
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+}	/* HIappend_diskblock() */
+
+/*-----------------------------------------------------------------------
+NAME
+   HPgetdiskblock --- Get the offset of a free block in the file.
+USAGE
+   hdf_off_t HPgetdiskblock(file_rec, block_size)
+   filerec_t *file_rec;     IN: ptr to the file record
+   int32 block_size;        IN: size of the block needed
+   intn moveto;             IN: whether to move the file position
+                                to the allocated position or leave
+                                it undefined.
+RETURNS
+   returns offset of block in the file if successful, FAIL (-1) if failed.
+DESCRIPTION
+   Used to "allocate" space in the file.  The block is taken from the
+   smallest extent in the free list of the file which it fits in, what
+   is left of the extent stays in the list.  If no extent is big enough
+   the block is appended to the end of the file.
+
+-------------------------------------------------------------------------*/
+hdf_off_t
+HPgetdiskblock(filerec_t * file_rec, int32 block_size, intn moveto)
+{
+  CONSTR(FUNC, "HPgetdiskblock");
+  freeblock_t *curr, *prev;     /* current extent & the one before it */
+  freeblock_t *best = NULL;     /* best fitting extent found */
+  freeblock_t *best_prev = NULL;    /* extent before the best fitting one */
+  hdf_off_t   ret_value = SUCCEED;
+
+  /* check for valid arguments */
+  if (file_rec == NULL || block_size < 0)
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+
+#ifndef DISKBLOCK_DEBUG
+  /* look for the smallest free extent the block fits in */
+  if (block_size > 0)
+    {
+      for (prev = NULL, curr = file_rec->freelist; curr != NULL;
+           prev = curr, curr = curr->next)
+        if (curr->length >= block_size
+            && (best == NULL || curr->length < best->length))
+          {
+            best = curr;
+            best_prev = prev;
+            if (curr->length == block_size)
+                break;  /* can't do better than this */
+          } /* end if */
+    } /* end if */
+
+  if (best != NULL)
+    {
+      /* the free list in the file is about to go out of date */
+      if (HTPdropfree(file_rec) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+      ret_value = best->offset;
+
+      /* take the block from the front of the extent */
+      if (best->length == block_size)
+        {
+          if (best_prev == NULL)
+              file_rec->freelist = best->next;
+          else
+              best_prev->next = best->next;
+          HDfree(best);
+        } /* end if */
+      else
+        {
+          best->offset += block_size;
+          best->length -= block_size;
+        } /* end else */
+
+      if (moveto == TRUE)   /* move to the beginning of the element */
+        {
+          if (HPseek(file_rec, ret_value) == FAIL)
+            HGOTO_ERROR(DFE_SEEKERROR, FAIL);
+        } /* end if */
+    } /* end if */
+  else
+#endif /* DISKBLOCK_DEBUG */
+    ret_value = HIappend_diskblock(file_rec, block_size, moveto);
+
 done:
   if(ret_value == FAIL)   
     { /* Error condition cleanup */
@@ -3553,38 +4615,268 @@ done:
   return ret_value;
 }	/* HPgetdiskblock() */
 
+/*-----------------------------------------------------------------------
+NAME
+   HPgetalignedblock --- Get the offset of a free block starting on a boundary.
+USAGE
+   hdf_off_t HPgetalignedblock(file_rec, block_size, alignment)
+   filerec_t *file_rec;     IN: ptr to the file record
+   int32 block_size;        IN: size of the block needed
+   int32 alignment;         IN: the block starts on a multiple of this
+RETURNS
+   returns offset of block in the file if successful, FAIL (-1) if failed.
+DESCRIPTION
+   Like HPgetdiskblock, but the offset of the block is a multiple of
+   'alignment' bytes, which need not be a power of two.  The block is
+   taken from the smallest extent in the free list an aligned block fits
+   in, or else appended to the end of the file.  The space before the
+   boundary goes into the free list.  An 'alignment' of 0 or 1 is the
+   same as HPgetdiskblock.
+
+-------------------------------------------------------------------------*/
+hdf_off_t
+HPgetalignedblock(filerec_t * file_rec, int32 block_size, int32 alignment)
+{
+  CONSTR(FUNC, "HPgetalignedblock");
+  freeblock_t *curr, *prev;     /* current extent & the one before it */
+  freeblock_t *best = NULL;     /* best fitting extent found */
+  freeblock_t *best_prev = NULL;    /* extent before the best fitting one */
+  hdf_off_t   best_off = 0;     /* the extent the block is taken from */
+  int32       best_len = 0;
+  int32       pad;              /* bytes up to the boundary */
+  hdf_off_t   ret_value = SUCCEED;
+
+  /* check for valid arguments */
+  if (file_rec == NULL || block_size < 0 || alignment < 0)
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+
+#ifndef DISKBLOCK_DEBUG
+  if (alignment <= 1)
+#endif /* DISKBLOCK_DEBUG */
+    HGOTO_DONE(HPgetdiskblock(file_rec, block_size, FALSE));
+
+  /* look for the smallest free extent an aligned block fits in */
+  if (block_size > 0)
+    {
+      for (prev = NULL, curr = file_rec->freelist; curr != NULL;
+           prev = curr, curr = curr->next)
+        {
+          pad = (int32)((alignment - curr->offset % alignment) % alignment);
+          if (curr->length - pad >= block_size
+              && (best == NULL || curr->length < best->length))
+            {
+              best = curr;
+              best_prev = prev;
+            } /* end if */
+        } /* end for */
+    } /* end if */
+
+  if (best != NULL)
+    {
+      if (HTPdropfree(file_rec) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+      pad = (int32)((alignment - best->offset % alignment) % alignment);
+      ret_value = best->offset + pad;
+
+      /* take the extent out of the list and give back what is left 
+         of it on either side of the block */
+      best_off = best->offset;
+      best_len = best->length;
+      if (best_prev == NULL)
+          file_rec->freelist = best->next;
+      else
+          best_prev->next = best->next;
+      HDfree(best);
+
+      if (HPfreediskblock(file_rec, best_off, pad) == FAIL
+          || HPfreediskblock(file_rec, ret_value + block_size,
+                             best_len - pad - block_size) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    } /* end if */
+  else
+    {
+      pad = (int32)((alignment - file_rec->f_end_off % alignment) % alignment);
+      if ((ret_value = HIappend_diskblock(file_rec, pad + block_size, FALSE)) == FAIL)
+        HGOTO_ERROR(DFE_SEEKERROR, FAIL);
+      if (HPfreediskblock(file_rec, ret_value, pad) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+      ret_value += pad;
+    } /* end else */
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+}	/* HPgetalignedblock() */
+
 /*-----------------------------------------------------------------------
 NAME
    HPfreediskblock --- Release a block in a file to be re-used.
 USAGE
    intn HPfreediskblock(file_rec, block_off, block_size)
    filerec_t *file_rec;     IN: ptr to the file record
-   int32 block_off;         IN: offset of the block to release
+   hdf_off_t block_off;     IN: offset of the block to release
    int32 block_size;        IN: size of the block to release
 RETURNS
    returns SUCCEED (0) if successful, FAIL (-1) if failed.
 DESCRIPTION
-   Used to "release" space in the file.  Currently, it does nothing.
-   At some point in the future, this could be changed to add the block
-   to a "real" free-list of empty blocks in the file and manage those.
+   Used to "release" space in the file.  The block is added to the free
+   list of the file, merged with the free extents next to it, for
+   HPgetdiskblock to hand out again.  Free space at the end of the file
+   is given back by moving the end of the file down instead.
+
+   Blocks with an invalid offset or length (i.e. elements which never had
+   any data written) and blocks which are already free are ignored.  The
+   caller must make sure no other element still uses the block.
 
 -------------------------------------------------------------------------*/
 intn
-HPfreediskblock(filerec_t * file_rec, int32 block_off, int32 block_size)
+HPfreediskblock(filerec_t * file_rec, hdf_off_t block_off, int32 block_size)
 {
-#ifdef LATER
   CONSTR(FUNC, "HPfreediskblock");
-#endif
+  freeblock_t *prev = NULL;     /* free extent before the block */
+  freeblock_t *next;            /* free extent after the block */
+  freeblock_t *new_blk;         /* new free extent */
   intn ret_value = SUCCEED;
 
-  /* shut compiler up */
-  file_rec = file_rec;
-  block_off = block_off;
-  block_size = block_size;
+  /* check for valid arguments */
+  if (file_rec == NULL)
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+
+  /* no space to give back */
+  if (block_off < MAGICLEN || block_size <= 0
+      || block_off > file_rec->f_end_off - block_size)
+    HGOTO_DONE(SUCCEED);
+
+  /* find the free extents on either side of the block */
+  for (next = file_rec->freelist; next != NULL && next->offset < block_off;
+       next = next->next)
+      prev = next;
+
+  /* don't give the same space out twice */
+  if ((prev != NULL && prev->offset + prev->length > block_off)
+      || (next != NULL && block_off + block_size > next->offset))
+    HGOTO_DONE(SUCCEED);
+
+  /* the free list in the file is about to go out of date; deleting its
+     dd's does not change the list, they are in it already */
+  if (HTPdropfree(file_rec) == FAIL)
+    HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+  if (prev != NULL && prev->offset + prev->length == block_off)
+    {   /* merge with the extent before */
+      prev->length += block_size;
+      if (next != NULL && prev->offset + prev->length == next->offset)
+        {   /* and with the extent after */
+          prev->length += next->length;
+          prev->next = next->next;
+          HDfree(next);
+        } /* end if */
+      new_blk = prev;
+    } /* end if */
+  else if (next != NULL && block_off + block_size == next->offset)
+    {   /* merge with the extent after */
+      next->offset = block_off;
+      next->length += block_size;
+      new_blk = next;
+    } /* end if */
+  else
+    {
+      if ((new_blk = (freeblock_t *) HDmalloc(sizeof(freeblock_t))) == NULL)
+        HGOTO_ERROR(DFE_NOSPACE, FAIL);
+      new_blk->offset = block_off;
+      new_blk->length = block_size;
+      new_blk->next = next;
+      if (prev == NULL)
+          file_rec->freelist = new_blk;
+      else
+          prev->next = new_blk;
+    } /* end else */
+
+  /* free space at the end of the file just shortens the file */
+  if (new_blk->next == NULL
+      && new_blk->offset + new_blk->length == file_rec->f_end_off)
+    {
+      file_rec->f_end_off = new_blk->offset;
+      if (file_rec->freelist == new_blk)
+          file_rec->freelist = NULL;
+      else
+        {
+          for (prev = file_rec->freelist; prev->next != new_blk; prev = prev->next)
+              ;
+          prev->next = NULL;
+        } /* end else */
+      HDfree(new_blk);
+    } /* end if */
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
 
   return ret_value;
 }	/* HPfreediskblock() */
 
+/*-----------------------------------------------------------------------
+NAME
+   HPsetdiskblock --- Place a new data element on a block already allocated.
+USAGE
+   intn HPsetdiskblock(aid, offset, length)
+   int32 aid;               IN: id of the new element
+   hdf_off_t offset;        IN: offset of the block
+   int32 length;            IN: the length of the element
+RETURNS
+   returns SUCCEED (0) if successful, FAIL (-1) if failed.
+DESCRIPTION
+   Like Hsetlength, but the data of the element go in a block the caller
+   got from HPgetdiskblock or HPgetalignedblock, or carved out of one,
+   instead of where Hsetlength would put them.  This function is only
+   valid when called after Hstartaccess on a new data element and before
+   any data is written to that element.
+
+-------------------------------------------------------------------------*/
+intn
+HPsetdiskblock(int32 aid, hdf_off_t offset, int32 length)
+{
+  CONSTR(FUNC, "HPsetdiskblock");
+  accrec_t   *access_rec;		/* access record */
+  intn        ret_value = SUCCEED;
+
+  if ((access_rec = HAatom_object(aid)) == NULL || offset < MAGICLEN
+      || length < 0)
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+
+  /* only a new element can be placed */
+  if (access_rec->new_elem != TRUE)
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+
+  /* fill in dd record updating the offset and length of the element */
+  if (HTPupdate(access_rec->ddid, offset, length) == FAIL)
+    HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+  /* turn off the "new" flag now that we have a length and offset */
+  access_rec->new_elem = FALSE;
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+}	/* HPsetdiskblock() */
+
 /*--------------------------------------------------------------------------
  NAME
        HDget_special_info -- get information about a special element
@@ -3698,6 +4990,7 @@ done:
 intn 
 Hshutdown(void)
 {
+    HTS_API_LOCK;
     accrec_t *curr;
 
     /* Release the free-list if it exists */
@@ -3716,28 +5009,11 @@ Hshutdown(void)
     return (SUCCEED);
 }	/* end Hshutdown() */
 
-/* #define HFILE_SEEKINFO */
-#ifdef HFILE_SEEKINFO
-static uint32 seek_taken=0;
-static uint32 seek_avoided=0;
-static uint32 write_force_seek=0;
-static uint32 read_force_seek=0;
-
-void
-Hdumpseek(void)
-{
-    printf("Seeks taken=%lu\n",(unsigned long)seek_taken);
-    printf("Seeks avoided=%lu\n",(unsigned long)seek_avoided);
-    printf("# of times write forced a seek=%lu\n",(unsigned long)write_force_seek);
-    printf("# of times read forced a seek=%lu\n",(unsigned long)read_force_seek);
-} /* Hdumpseek() */
-#endif /* HFILE_SEEKINFO */
-
 /*--------------------------------------------------------------------------
  NAME
     HP_read
  PURPOSE
-    Alias for HI_READ on HDF files.
+    Read from an HDF file at its current position.
  USAGE
     intn HP_read(file_rec,buf,bytes)
         filerec_t * file_rec;   IN: Pointer to the HDF file record
@@ -3746,7 +5022,8 @@ Hdumpseek(void)
  RETURNS
     Returns SUCCEED/FAIL
  DESCRIPTION
-    Function to wrap around HI_READ
+    Reads through the file driver (or out of the file mapping) at the
+    position set by HPseek() and moves the position past the data read.
  GLOBAL VARIABLES
  COMMENTS, BUGS, ASSUMPTIONS
     Should only be called by HDF low-level routines
@@ -3759,21 +5036,10 @@ HP_read(filerec_t *file_rec,void * buf,int32 bytes)
   CONSTR(FUNC, "HP_read");
   intn     ret_value = SUCCEED;
 
-  /* Check for switching file access operations */
-  if(file_rec->last_op==H4_OP_WRITE || file_rec->last_op==H4_OP_UNKNOWN)
-    {
-#ifdef HFILE_SEEKINFO
-      read_force_seek++;
-#endif /* HFILE_SEEKINFO */
-      file_rec->last_op=H4_OP_UNKNOWN;
-      if(HPseek(file_rec,file_rec->f_cur_off)==FAIL)
-        HGOTO_ERROR(DFE_INTERNAL,FAIL);
-    } /* end if */
-
-  if(HI_READ(file_rec->file,buf,bytes)==FAIL)
+  if(HP_pread(file_rec,buf,bytes,file_rec->f_cur_off)==FAIL)
     HGOTO_ERROR(DFE_READERROR, FAIL);
   file_rec->f_cur_off+=bytes;
-  file_rec->last_op=H4_OP_READ;
+
 done:
   if(ret_value == FAIL)   
     { /* Error condition cleanup */
@@ -3789,15 +5055,17 @@ done:
  NAME
     HPseek
  PURPOSE
-    Alias for HI_SEEK on HDF files.
+    Set the current position in an HDF file.
  USAGE
     intn HPseek(file_rec,offset)
         filerec_t * file_rec;   IN: Pointer to the HDF file record
-        int32 offset;           IN: offset in the file to go to
+        hdf_off_t offset;       IN: offset in the file to go to
  RETURNS
     Returns SUCCEED/FAIL
  DESCRIPTION
-    Function to wrap around HI_SEEK
+    Sets the position used by the next HP_read() or HP_write().  The file
+    drivers are always given the offset to transfer at, so no seek is
+    done here.
  GLOBAL VARIABLES
  COMMENTS, BUGS, ASSUMPTIONS
     Should only be called by HDF low-level routines
@@ -3805,32 +5073,14 @@ done:
  REVISION LOG
 --------------------------------------------------------------------------*/
 intn 
-HPseek(filerec_t *file_rec,int32 offset)
+HPseek(filerec_t *file_rec,hdf_off_t offset)
 {
   CONSTR(FUNC, "HPseek");
   intn     ret_value = SUCCEED;
 
-#ifdef HFILE_SEEKINFO
-printf("%s: file_rec=%p, last_offset=%ld, offset=%ld, last_op=%d",FUNC,file_rec,(long)file_rec->f_cur_off,(long)offset,(int)file_rec->last_op);
-#endif /* HFILE_SEEKINFO */
-  if(file_rec->f_cur_off!=offset || file_rec->last_op==H4_OP_UNKNOWN)
-    {
-#ifdef HFILE_SEEKINFO
-      seek_taken++;
-printf(" taken: %d\n",(int)seek_taken);
-#endif /* HFILE_SEEKINFO */
-      if (HI_SEEK(file_rec->file, offset) == FAIL)
-        HGOTO_ERROR(DFE_SEEKERROR, FAIL);
-      file_rec->f_cur_off=offset;
-      file_rec->last_op=H4_OP_SEEK;
-    } /* end if */
-#ifdef HFILE_SEEKINFO
-  else
-{
-    seek_avoided++;
-printf(" avoided: %d\n",(int)seek_avoided);
-}
-#endif /* HFILE_SEEKINFO */
+  if(offset < 0)
+    HGOTO_ERROR(DFE_SEEKERROR, FAIL);
+  file_rec->f_cur_off=offset;
 
 done:
   if(ret_value == FAIL)   
@@ -3847,7 +5097,7 @@ done:
  NAME
     HP_write
  PURPOSE
-    Alias for HI_WRITE on HDF files.
+    Write to an HDF file at its current position.
  USAGE
     intn HP_write(file_rec,buf,bytes)
         filerec_t * file_rec;   IN: Pointer to the HDF file record
@@ -3856,7 +5106,8 @@ done:
  RETURNS
     Returns SUCCEED/FAIL
  DESCRIPTION
-    Function to wrap around HI_WRITE
+    Writes through the file driver at the position set by HPseek() and
+    moves the position past the data written.
  GLOBAL VARIABLES
  COMMENTS, BUGS, ASSUMPTIONS
     Should only be called by HDF low-level routines
@@ -3869,21 +5120,9 @@ HP_write(filerec_t *file_rec,const void * buf,int32 bytes)
   CONSTR(FUNC, "HP_write");
   intn    ret_value = SUCCEED;
 
-  /* Check for switching file access operations */
-  if(file_rec->last_op==H4_OP_READ || file_rec->last_op==H4_OP_UNKNOWN)
-    {
-#ifdef HFILE_SEEKINFO
-      write_force_seek++;
-#endif /* HFILE_SEEKINFO */
-      file_rec->last_op=H4_OP_UNKNOWN;
-      if(HPseek(file_rec,file_rec->f_cur_off)==FAIL)
-        HGOTO_ERROR(DFE_INTERNAL,FAIL);
-    } /* end if */
-
-  if(HI_WRITE(file_rec->file,buf,bytes)==FAIL)
+  if(HP_pwrite(file_rec,buf,bytes,file_rec->f_cur_off)==FAIL)
     HGOTO_ERROR(DFE_WRITEERROR, FAIL);
   file_rec->f_cur_off+=bytes;
-  file_rec->last_op=H4_OP_WRITE;
 
 done:
   if(ret_value == FAIL)   
@@ -3896,6 +5135,490 @@ done:
   return ret_value;
 } /* end HP_write() */
 
+/*--------------------------------------------------------------------------
+ NAME
+    HP_pread
+ PURPOSE
+    Read from an HDF file at an explicit offset.
+ USAGE
+    intn HP_pread(file_rec,buf,bytes,offset)
+        filerec_t * file_rec;   IN: Pointer to the HDF file record
+        void * buf;             IN: Pointer to the buffer to read data into
+        int32 bytes;            IN: # of bytes to read
+        hdf_off_t offset;       IN: offset in the file to read from
+ RETURNS
+    Returns SUCCEED/FAIL
+ DESCRIPTION
+    Reads 'bytes' bytes starting at 'offset', without using or changing
+    the file record's current position.  Reads from a mapped file are
+    copied out of the mapping, and reads of data still in the write
+    buffer are copied out of the buffer.
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+    Should only be called by HDF low-level routines
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+intn 
+HP_pread(filerec_t *file_rec,void * buf,int32 bytes,hdf_off_t offset)
+{
+  CONSTR(FUNC, "HP_pread");
+  intn     ret_value = SUCCEED;
+
+  if(offset < 0)
+    HGOTO_ERROR(DFE_SEEKERROR, FAIL);
+
+  if(file_rec->wbuf_len>0 && offset<file_rec->wbuf_off+file_rec->wbuf_len
+      && offset+bytes>file_rec->wbuf_off)
+    { /* the data is (partly) still in the write buffer */
+      if(offset>=file_rec->wbuf_off
+          && offset+bytes<=file_rec->wbuf_off+file_rec->wbuf_len)
+        {
+          HDmemcpy(buf,file_rec->wbuf+(offset-file_rec->wbuf_off),bytes);
+          HGOTO_DONE(SUCCEED);
+        } /* end if */
+      if(HPflush_writes(file_rec)==FAIL)
+        HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+    } /* end if */
+
+  if(file_rec->map_base!=NULL && offset<=file_rec->map_len-bytes)
+    { /* copy straight out of the file mapping */
+      HDmemcpy(buf,file_rec->map_base+offset,bytes);
+    } /* end if */
+  else
+    {
+      if(HIdriver_read(file_rec,buf,bytes,offset)==FAIL)
+        HGOTO_ERROR(DFE_READERROR, FAIL);
+    } /* end else */
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+} /* end HP_pread() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HP_pwrite
+ PURPOSE
+    Write to an HDF file at an explicit offset.
+ USAGE
+    intn HP_pwrite(file_rec,buf,bytes,offset)
+        filerec_t * file_rec;   IN: Pointer to the HDF file record
+        void * buf;             IN: Pointer to the buffer to write
+        int32 bytes;            IN: # of bytes to write
+        hdf_off_t offset;       IN: offset in the file to write to
+ RETURNS
+    Returns SUCCEED/FAIL
+ DESCRIPTION
+    Writes 'bytes' bytes starting at 'offset', without using or changing
+    the file record's current position.  Writes smaller than the write
+    buffer of the file are gathered there, see HIbuffer_write().
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+    Should only be called by HDF low-level routines
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+intn 
+HP_pwrite(filerec_t *file_rec,const void * buf,int32 bytes,hdf_off_t offset)
+{
+  CONSTR(FUNC, "HP_pwrite");
+  intn    ret_value = SUCCEED;
+
+  if(offset < 0)
+    HGOTO_ERROR(DFE_SEEKERROR, FAIL);
+
+  if(bytes < file_rec->wbuf_size)
+    {
+      if(HIbuffer_write(file_rec,buf,bytes,offset)==FAIL)
+        HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+    } /* end if */
+  else
+    {
+      /* the buffered data must not land on top of this write later */
+      if(file_rec->wbuf_len>0 && offset<file_rec->wbuf_off+file_rec->wbuf_len
+          && offset+bytes>file_rec->wbuf_off)
+          if(HPflush_writes(file_rec)==FAIL)
+            HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+      if(HIdriver_write(file_rec,buf,bytes,offset)==FAIL)
+        HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+    } /* end else */
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+} /* end HP_pwrite() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HIbuffer_write
+ PURPOSE
+    Add a small write to the write buffer of a file.
+ USAGE
+    intn HIbuffer_write(file_rec,buf,bytes,offset)
+        filerec_t * file_rec;   IN: Pointer to the HDF file record
+        void * buf;             IN: Pointer to the buffer to write
+        int32 bytes;            IN: # of bytes to write
+        hdf_off_t offset;       IN: offset in the file to write to
+ RETURNS
+    Returns SUCCEED/FAIL
+ DESCRIPTION
+    The buffer holds one run of bytes of the file.  A write which overlaps
+    or touches the run is copied into the buffer if the run still fits in
+    it afterwards, otherwise the run is written out first and the write
+    starts a new one.
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+    Gaps are never buffered, the bytes in them are not known.
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+PRIVATE intn 
+HIbuffer_write(filerec_t *file_rec,const void * buf,int32 bytes,hdf_off_t offset)
+{
+  CONSTR(FUNC, "HIbuffer_write");
+  hdf_off_t start, end;  /* extent of the buffered run after this write */
+  intn    ret_value = SUCCEED;
+
+  if(file_rec->wbuf==NULL)
+    {
+      if((file_rec->wbuf=(uint8 *)HDmalloc((uint32)file_rec->wbuf_size))==NULL)
+        { /* just write the data out then */
+          if(HIdriver_write(file_rec,buf,bytes,offset)==FAIL)
+            HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+          HGOTO_DONE(SUCCEED);
+        } /* end if */
+      file_rec->wbuf_len=0;
+    } /* end if */
+
+  start=offset;
+  end=offset+bytes;
+  if(file_rec->wbuf_len>0)
+    {
+      start=MIN(start,file_rec->wbuf_off);
+      end=MAX(end,file_rec->wbuf_off+file_rec->wbuf_len);
+      if(offset>file_rec->wbuf_off+file_rec->wbuf_len
+          || offset+bytes<file_rec->wbuf_off
+          || end-start>file_rec->wbuf_size)
+        { /* doesn't join up with the run in the buffer */
+          if(HPflush_writes(file_rec)==FAIL)
+            HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+          start=offset;
+          end=offset+bytes;
+        } /* end if */
+    } /* end if */
+
+  if(file_rec->wbuf_len==0)   /* start a new run */
+      file_rec->wbuf_off=offset;
+
+  /* make room in front of the run if the write starts before it */
+  if(start<file_rec->wbuf_off)
+    {
+      HDmemmove(file_rec->wbuf+(file_rec->wbuf_off-start),file_rec->wbuf,
+          file_rec->wbuf_len);
+      file_rec->wbuf_off=start;
+    } /* end if */
+
+  HDmemcpy(file_rec->wbuf+(offset-file_rec->wbuf_off),buf,bytes);
+  file_rec->wbuf_len=(int32)(end-file_rec->wbuf_off);
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+} /* end HIbuffer_write() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HPflush_writes
+ PURPOSE
+    Write out the data gathered in the write buffer of a file.
+ USAGE
+    intn HPflush_writes(file_rec)
+        filerec_t * file_rec;   IN: Pointer to the HDF file record
+ RETURNS
+    Returns SUCCEED/FAIL
+ DESCRIPTION
+    Writes the run of bytes in the write buffer to the file in one write
+    and empties the buffer.  Does nothing if the buffer is empty.
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+    The buffer is emptied even if the write fails, so the error is only
+    reported once.
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+intn 
+HPflush_writes(filerec_t *file_rec)
+{
+  CONSTR(FUNC, "HPflush_writes");
+  int32   len;          /* # of bytes buffered */
+  intn    ret_value = SUCCEED;
+
+  if((len=file_rec->wbuf_len)>0)
+    {
+      file_rec->wbuf_len=0;
+      if(HIdriver_write(file_rec,file_rec->wbuf,len,file_rec->wbuf_off)==FAIL)
+        HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+    } /* end if */
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+} /* end HPflush_writes() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HIio_time
+ PURPOSE
+    Get the current time for the I/O statistics.
+ USAGE
+    float64 HIio_time()
+ RETURNS
+    Returns the time in seconds, or 0 where there is no clock to read
+ DESCRIPTION
+    Only differences between two times are used.
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+PRIVATE float64
+HIio_time(void)
+{
+#ifdef H4_HAVE_SYS_TIME_H
+  struct timeval tv;
+
+  gettimeofday(&tv,NULL);
+  return (float64)tv.tv_sec+(float64)tv.tv_usec/1.0e6;
+#else /* H4_HAVE_SYS_TIME_H */
+  return 0.0;
+#endif /* H4_HAVE_SYS_TIME_H */
+} /* end HIio_time() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HIread_ahead
+ PURPOSE
+    Read ahead of a sequential read of an element.
+ USAGE
+    void HIread_ahead(file_rec,access_rec,data_off,data_len)
+        filerec_t * file_rec;   IN: Pointer to the HDF file record
+        accrec_t * access_rec;  IN: Pointer to the access record just read
+        hdf_off_t data_off;     IN: offset of the element in the file
+        int32 data_len;         IN: length of the element
+ RETURNS
+    none
+ DESCRIPTION
+    Once the reads of the element get within half the read-ahead size of
+    the end of the data read ahead so far, asks the file driver to read
+    ahead up to the read-ahead size past the current position.  Each
+    part of the element is asked for only once.
+ GLOBAL VARIABLES
+    lib_iostats
+ COMMENTS, BUGS, ASSUMPTIONS
+    Read-ahead is only a hint, errors from the driver are ignored.
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+PRIVATE void
+HIread_ahead(filerec_t *file_rec,accrec_t *access_rec,hdf_off_t data_off,
+    int32 data_len)
+{
+  int32   start, end;   /* part of the element to read ahead */
+
+  if(file_rec->ra_size<=0 || file_rec->driver->prefetch==NULL
+      || file_rec->map_base!=NULL)
+      return;
+
+  /* enough of the element is still on its way in */
+  if(access_rec->ra_end-access_rec->posn>file_rec->ra_size/2)
+      return;
+
+  start=MAX(access_rec->posn,access_rec->ra_end);
+  end=MIN(access_rec->posn+file_rec->ra_size,data_len);
+  if(end<=start)
+      return;
+
+  (*file_rec->driver->prefetch)(file_rec->file,data_off+start,end-start);
+  access_rec->ra_end=end;
+  file_rec->iostats.nprefetches++;
+  HTS_MUTEX_LOCK(lib_iostats_lock);
+  lib_iostats.nprefetches++;
+  HTS_MUTEX_UNLOCK(lib_iostats_lock);
+} /* end HIread_ahead() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HIcompare_readv_piece
+ PURPOSE
+    Order the pieces of Hreadv by their offset in the file.
+ USAGE
+    int HIcompare_readv_piece(p1,p2)
+        const void * p1;        IN: Pointer to the first piece
+        const void * p2;        IN: Pointer to the second piece
+ RETURNS
+    Returns <0, 0 or >0 as for qsort()
+ DESCRIPTION
+ GLOBAL VARIABLES
+ COMMENTS, BUGS, ASSUMPTIONS
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+PRIVATE int
+HIcompare_readv_piece(const void *p1, const void *p2)
+{
+  hdf_off_t off1=((const readv_piece_t *)p1)->file_off;
+  hdf_off_t off2=((const readv_piece_t *)p2)->file_off;
+
+  return (off1<off2 ? -1 : (off1>off2 ? 1 : 0));
+} /* end HIcompare_readv_piece() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HIdriver_read
+ PURPOSE
+    Read from a file through its driver, keeping the I/O statistics.
+ USAGE
+    intn HIdriver_read(file_rec,buf,bytes,offset)
+        filerec_t * file_rec;   IN: Pointer to the HDF file record
+        void * buf;             IN: Pointer to the buffer to read data into
+        int32 bytes;            IN: # of bytes to read
+        hdf_off_t offset;       IN: offset in the file to read from
+ RETURNS
+    Returns SUCCEED/FAIL
+ DESCRIPTION
+    Counts the read in the statistics of the file and of the library, see
+    Hgetiostats().
+ GLOBAL VARIABLES
+    lib_iostats
+ COMMENTS, BUGS, ASSUMPTIONS
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+PRIVATE intn 
+HIdriver_read(filerec_t *file_rec,void * buf,int32 bytes,hdf_off_t offset)
+{
+  float64 start=HIio_time();
+  intn    ret_value;
+
+  ret_value=(*file_rec->driver->read)(file_rec->file,buf,bytes,offset);
+  HIcount_io(file_rec,H4_OP_READ,bytes,offset,HIio_time()-start);
+
+  return ret_value;
+} /* end HIdriver_read() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HIdriver_write
+ PURPOSE
+    Write to a file through its driver, keeping the I/O statistics.
+ USAGE
+    intn HIdriver_write(file_rec,buf,bytes,offset)
+        filerec_t * file_rec;   IN: Pointer to the HDF file record
+        void * buf;             IN: Pointer to the buffer to write
+        int32 bytes;            IN: # of bytes to write
+        hdf_off_t offset;       IN: offset in the file to write to
+ RETURNS
+    Returns SUCCEED/FAIL
+ DESCRIPTION
+    Counts the write in the statistics of the file and of the library, see
+    Hgetiostats().
+ GLOBAL VARIABLES
+    lib_iostats
+ COMMENTS, BUGS, ASSUMPTIONS
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+PRIVATE intn 
+HIdriver_write(filerec_t *file_rec,const void * buf,int32 bytes,hdf_off_t offset)
+{
+  float64 start=HIio_time();
+  intn    ret_value;
+
+  ret_value=(*file_rec->driver->write)(file_rec->file,buf,bytes,offset);
+  HIcount_io(file_rec,H4_OP_WRITE,bytes,offset,HIio_time()-start);
+
+  return ret_value;
+} /* end HIdriver_write() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HIcount_io
+ PURPOSE
+    Add a read or write to the I/O statistics.
+ USAGE
+    void HIcount_io(file_rec,op,bytes,offset,io_time)
+        filerec_t * file_rec;   IN: Pointer to the HDF file record
+        fileop_t op;            IN: H4_OP_READ or H4_OP_WRITE
+        int32 bytes;            IN: # of bytes read or written
+        hdf_off_t offset;       IN: offset in the file of the I/O
+        float64 io_time;        IN: seconds the I/O took
+ RETURNS
+    none
+ DESCRIPTION
+    Updates the statistics of the file and of the library.  An I/O which
+    doesn't start where the last one on the file ended counts as a seek,
+    whether or not the driver actually has to seek for it.
+ GLOBAL VARIABLES
+    lib_iostats
+ COMMENTS, BUGS, ASSUMPTIONS
+ EXAMPLES
+ REVISION LOG
+--------------------------------------------------------------------------*/
+PRIVATE void
+HIcount_io(filerec_t *file_rec,fileop_t op,int32 bytes,hdf_off_t offset,float64 io_time)
+{
+  HTS_MUTEX_GUARD(lib_iostats_lock);
+  hdf_iostats_t *stats[2];
+  intn    i;
+
+  stats[0]=&file_rec->iostats;
+  stats[1]=&lib_iostats;
+  for(i=0; i<2; i++)
+    {
+      if(op==H4_OP_READ)
+        {
+          stats[i]->nreads++;
+          stats[i]->bytes_read+=(float64)bytes;
+        } /* end if */
+      else
+        {
+          stats[i]->nwrites++;
+          stats[i]->bytes_written+=(float64)bytes;
+        } /* end else */
+      if(offset==file_rec->io_end_off)
+          stats[i]->nseeks_avoided++;
+      else
+          stats[i]->nseeks++;
+      stats[i]->io_time+=io_time;
+    } /* end for */
+  file_rec->io_end_off=offset+bytes;
+} /* end HIcount_io() */
+
 
 /*--------------------------------------------------------------------------
  NAME
@@ -4006,7 +5729,8 @@ HDcheck_empty(int32 file_id, uint16 tag, uint16 ref,
     /* get access element from dataset's tag/ref */
     if ((data_id=HTPselect(file_rec,tag,ref))!=FAIL)
     {
-	int32  dlen=0, doff=0; /* offset/length of the description record */
+	int32  dlen=0;          /* length of the description record */
+	hdf_off_t doff=0;      /* offset of the description record */
 
         /* Get the info pointed to by this dd, which could point to data or
            description record, or neither */
@@ -4227,6 +5951,7 @@ DESCRIPTION
 intn
 Hgetntinfo(const int32 numbertype, hdf_ntinfo_t *nt_info)
 {
+    HTS_API_LOCK;
     /* Clear error stack */
     HEclear();
 
@@ -4332,6 +6057,7 @@ Hmpset(int pagesize, /* IN: pagesize to use for next open/create */
        int flags     /* IN: flags = 0, MP_PAGEALL */
 )
 {
+    HTS_API_LOCK;
     int ret_value = SUCCEED;
 
         /* call the real routine */
@@ -4368,6 +6094,7 @@ Hmpget(int *pagesize, /* OUT: pagesize to used in last open/create */
       int flags      /* IN: */
 )
 {
+    HTS_API_LOCK;
     int psize = 0;
     int mcache = 0;
     int ret_value = SUCCEED;
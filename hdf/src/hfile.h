@@ -31,6 +31,9 @@
 /* Magic cookie for HDF data files */
 #define MAGICLEN 4  /* length */
 #define HDFMAGIC "\016\003\023\001"     /* ^N^C^S^A */
+/* Magic cookie for HDF files in the large file format, which older
+   libraries are not to open */
+#define HDFMAGIC_LARGE "\016\003\023\002"     /* ^N^C^S^B */
 
 /* sizes of elements in a file.  This is necessary because
    the size of variables need not be the same as in the file
@@ -39,6 +42,20 @@
 #define NDDS_SZ 2
 #define OFFSET_SZ 4
 
+/* sizes of the elements in the large file format, where the offsets and
+   lengths in the DD list are 64-bit */
+#define DD64_SZ 20  /* 2+2+8+8 */
+#define OFFSET64_SZ 8
+
+/* sizes of the DD list elements in a file, by the format of the file */
+#define FILE_DD_SZ(f)       ((f)->largefile ? DD64_SZ : DD_SZ)
+#define FILE_OFFSET_SZ(f)   ((f)->largefile ? OFFSET64_SZ : OFFSET_SZ)
+#define FILE_DDHEAD_SZ(f)   (NDDS_SZ + FILE_OFFSET_SZ(f))
+
+/* largest offset or length that an int32 of the API or of an element
+   header can hold */
+#define MAX_OFFSET32 ((hdf_off_t)0x7fffffff)
+
 /* invalid offset & length to indicate a partially defined element 
 * written to the HDF file i.e. can handle the case where the the
 * element is defined but not written out */
@@ -61,7 +78,10 @@
 
 /* -------------------------- File I/O Functions -------------------------- */
 /* FILELIB -- file library to use for file access: 1 stdio, 2 fcntl
-   default to stdio library i.e. UNIX buffered I/O */
+   default to stdio library i.e. UNIX buffered I/O.
+   HDF files opened with Hopen() go through a file driver instead (see
+   hdf_fdriver_t below), the HI_* macros are used for the other files the
+   library reads, such as external elements. */
 
 #ifndef FILELIB
 #   define FILELIB UNIXBUFIO    /* UNIX buffered I/O is the default */
@@ -125,6 +145,26 @@ typedef short hdf_file_t;
 #   define OPENERR(f)           (f < 0)
 #endif /* FILELIB == MACIO */
 
+/* Positional I/O -- when the system provides pread()/pwrite(), the POSIX
+   file driver reads and writes at explicit offsets and never seeks. */
+#if defined(H4_HAVE_PREAD) && defined(H4_HAVE_PWRITE)
+#   define H4_HAVE_POSITIONAL_IO
+#endif /* H4_HAVE_PREAD && H4_HAVE_PWRITE */
+
+/* Memory-mapped reads -- a file opened read-only may be mapped into memory
+   (see Hmmap()), HP_read() then copies out of the mapping instead of
+   calling into the file driver. */
+#if defined(H4_HAVE_MMAP) && defined(H4_HAVE_MUNMAP)
+#   define H4_HAVE_MMAP_IO
+#endif /* H4_HAVE_MMAP && H4_HAVE_MUNMAP */
+
+/* Read-ahead -- sequential Hread()s on an element ask the file driver to
+   start reading the data which comes next (see Hreadahead()), which the
+   POSIX and stdio drivers pass on to the system with posix_fadvise(). */
+#if defined(H4_HAVE_POSIX_FADVISE)
+#   define H4_HAVE_READAHEAD
+#endif /* H4_HAVE_POSIX_FADVISE */
+
 
 /* ----------------------- Internal Data Structures ----------------------- */
 /* The internal structure used to keep track of the files opened: an
@@ -217,7 +257,7 @@ typedef struct dd_t
       uint16      tag;          /* Tag number of element i.e. type of data */
       uint16      ref;          /* Reference number of element */
       int32       length;       /* length of data element */
-      int32       offset;       /* byte offset of data element from */
+      hdf_off_t   offset;       /* byte offset of data element from */
       struct ddblock_t *blk;    /* Pointer to the block this dd is in */
   }                             /* beginning of file */
 dd_t;
@@ -237,9 +277,9 @@ version_t;
 typedef struct ddblock_t
   {
       uintn       dirty;        /* boolean: should this DD block be flushed? */
-      int32       myoffset;     /* offset of this DD block in the file */
+      hdf_off_t   myoffset;     /* offset of this DD block in the file */
       int16       ndds;         /* number of dd's in this block */
-      int32       nextoffset;   /* offset to the next ddblock in the file */
+      hdf_off_t   nextoffset;   /* offset to the next ddblock in the file */
       struct filerec_t *frec;   /* Pointer to the filerec this block is in */
       struct ddblock_t *next;   /* pointer to the next ddblock in memory */
       struct ddblock_t *prev;   /* Pointer to previous ddblock. */
@@ -247,6 +287,24 @@ typedef struct ddblock_t
   }
 ddblock_t;
 
+/* record of a released extent of the file, which can be handed out again */
+typedef struct freeblock_t
+  {
+      hdf_off_t   offset;       /* offset of the free extent in the file */
+      int32       length;       /* length of the free extent */
+      struct freeblock_t *next; /* pointer to the next free extent in the list */
+  }
+freeblock_t;
+
+/* Extent tree node structure, the dd's with their data at one offset */
+typedef struct extent_info_str
+  {
+      hdf_off_t   offset;       /* offset of the data in the file */
+      /* Needs to be first in this structure */
+      int32       length;       /* longest length of the dd's there */
+      intn        count;        /* number of dd's there */
+  }extent_info;
+
 /* Tag tree node structure */
 typedef struct tag_info_str
   {
@@ -266,30 +324,78 @@ typedef enum
   }
 fileop_t;
 
+/* File driver structure.  A file driver does the low-level I/O for HDF files
+   opened with Hopen(), see hfiledrv.c.  Reads and writes always give the
+   offset to transfer at, the driver does not keep a current position for
+   its callers. */
+typedef struct hdf_fdriver_t
+  {
+      intn        id;           /* HDF_DRIVER_* number of this driver */
+      const char *name;         /* name of this driver */
+      void     *(*open)   (const char *path, intn acc_mode);
+      void     *(*create) (const char *path);
+      intn      (*read)   (void *file, void *buf, int32 bytes, hdf_off_t offset);
+      intn      (*write)  (void *file, const void *buf, int32 bytes, hdf_off_t offset);
+      intn      (*flush)  (void *file);
+      intn      (*close)  (void *file);
+      hdf_off_t (*size)   (void *file);
+      /* optional, NULL if the driver can't map files into memory */
+      intn      (*map)    (void *file, uint8 **base, int32 *len);
+      intn      (*unmap)  (void *file, uint8 *base, int32 len);
+      /* optional, NULL if the driver can't read ahead */
+      intn      (*prefetch) (void *file, hdf_off_t offset, int32 len);
+  }
+hdf_fdriver_t;
+
 /* File record structure */
 typedef struct filerec_t
   {
       char       *path;         /* name of file */
-      hdf_file_t  file;         /* either file descriptor or pointer */
+      const hdf_fdriver_t *driver; /* file driver doing the I/O */
+      void       *file;         /* the driver's handle of the open file */
       uint16      maxref;       /* highest ref in this file */
       intn        access;       /* access mode */
       intn        refcount;     /* reference count / times opened */
       intn        attach;       /* number of access elts attached */
       intn        version_set;  /* version tag stuff */
       version_t   version;      /* file version info */
+      intn        largefile;    /* boolean: file is in the large file format */
 
-      /* Seek caching info */
-      int32      f_cur_off;    /* Current location in the file */
-      fileop_t    last_op;      /* the last file operation performed */
+      /* Logical position for HPseek/HP_read/HP_write */
+      hdf_off_t  f_cur_off;    /* Current location in the file */
+
+      /* Memory-mapping info, for files opened read-only */
+      uint8      *map_base;     /* start of the file mapping, NULL if none */
+      int32       map_len;      /* # of bytes of the file mapped */
 
       /* DD block caching info */
       intn        cache;        /* boolean: whether caching is on */
+      intn        mergedd;      /* boolean: merge the DD blocks on close */
       intn        dirty;        /* boolean: if dd list needs to be flushed */
-      int32      f_end_off;    /* offset of the end of the file */
+      hdf_off_t  f_end_off;    /* offset of the end of the file */
+
+      /* Buffer gathering small writes into larger ones */
+      uint8      *wbuf;         /* buffered data, NULL until first needed */
+      int32       wbuf_size;    /* size of the buffer, 0 for no buffering */
+      hdf_off_t   wbuf_off;     /* offset in the file of the buffered data */
+      int32       wbuf_len;     /* # of bytes in the buffer */
+
+      /* Read-ahead of sequential reads, see Hreadahead() */
+      int32       ra_size;      /* # of bytes to read ahead, 0 for none */
+
+      /* I/O statistics, see Hgetiostats() */
+      hdf_iostats_t iostats;    /* counts of the I/O done on this file */
+      hdf_off_t   io_end_off;   /* offset where the last read/write ended */
+
+      /* Free space in the file, sorted by offset */
+      struct freeblock_t *freelist; /* list of the released extents */
+      intn        free_ondisk;  /* boolean: the DFTAG_FREE dd's of the file
+                                   still hold the free list, see HTPdropfree */
 
       /* DD list pointers */
       struct ddblock_t *ddhead; /* head of ddblock list */
-      struct ddblock_t *ddlast; /* end of ddblock list */
+      struct ddblock_t *ddlast; /* end of ddblock list (in memory, its nextoffset
+                                   is not 0 while more DD blocks are on disk) */
 
       /* NULL DD pointers (for fast lookup of DFTAG_NULL) */
       struct ddblock_t *ddnull; /* location of last ddblock with a DFTAG_NULL */
@@ -298,12 +404,20 @@ typedef struct filerec_t
       /* tag tree for file */
       TBBT_TREE *tag_tree;      /* TBBT of the tags in the file */
 
+      /* extent tree for file */
+      TBBT_TREE *extent_tree;   /* TBBT of the data offsets of the dd's */
+
       /* annotation stuff for file */
       intn       an_num[4];   /* Holds number of annotations found of each type */
       TBBT_TREE *an_tree[4];  /* tbbt trees for each type of annotation in file 
                                * i.e. file/data labels and descriptions.
                                * This is done for faster searching of annotations
                                * of a particular type. */
+
+#ifdef H4_HAVE_THREADSAFE
+      /* lock of the file, see HTS_FILE_LOCK in hts.h */
+      pthread_mutex_t lock;
+#endif /* H4_HAVE_THREADSAFE */
   }
 filerec_t;
 
@@ -328,6 +442,8 @@ typedef struct accrec_t
       int32       file_id;      /* id of attached file */
       atom_t      ddid;         /* DD id for the DD attached to */
       int32       posn;         /* seek position with respect to start of element */
+      int32       ra_next;      /* where the last read ended, 0 before any */
+      int32       ra_end;       /* end of the data read ahead so far */
       void *       special_info; /* special element info? */
       struct funclist_t *special_func;  /* ptr to special function? */
       struct accrec_t *next;    /* for free-list linking */
@@ -337,7 +453,25 @@ accrec_t;
 #ifdef HFILE_MASTER
 /* Pointer to the access record node free list */
 static accrec_t *accrec_free_list=NULL;
+#ifdef H4_HAVE_THREADSAFE
+static pthread_mutex_t accrec_lock=PTHREAD_MUTEX_INITIALIZER;
+#endif /* H4_HAVE_THREADSAFE */
+#endif /* HFILE_MASTER */
+
+/* I/O statistics of all the files opened, see Hgetiostats() */
+#ifndef HFILE_MASTER
+extern
+#endif /* HFILE_MASTER */
+hdf_iostats_t lib_iostats;
+
+#ifdef H4_HAVE_THREADSAFE
+/* Guards lib_iostats, threads reading different files update it at once */
+#ifdef HFILE_MASTER
+pthread_mutex_t lib_iostats_lock=PTHREAD_MUTEX_INITIALIZER;
+#else /* HFILE_MASTER */
+extern pthread_mutex_t lib_iostats_lock;
 #endif /* HFILE_MASTER */
+#endif /* H4_HAVE_THREADSAFE */
 
 /* this type is returned to applications programs or other special
    interfaces when they need to know information about a given
@@ -476,11 +610,17 @@ extern      "C"
     HDFLIBAPI intn HPcompare_accrec_tagref
                 (const void * rec1, const void * rec2);
 
-    HDFLIBAPI int32 HPgetdiskblock
+    HDFLIBAPI hdf_off_t HPgetdiskblock
                 (filerec_t * file_rec, int32 block_size, intn moveto);
 
+    HDFLIBAPI hdf_off_t HPgetalignedblock
+                (filerec_t * file_rec, int32 block_size, int32 alignment);
+
     HDFLIBAPI intn HPfreediskblock
-                (filerec_t * file_rec, int32 block_offset, int32 block_size);
+                (filerec_t * file_rec, hdf_off_t block_offset, int32 block_size);
+
+    HDFLIBAPI intn HPsetdiskblock
+                (int32 aid, hdf_off_t offset, int32 length);
 
     HDFLIBAPI intn HPisfile_in_use
                 (const char *path);
@@ -498,11 +638,26 @@ extern      "C"
                 (filerec_t *file_rec,void * buf,int32 bytes);
 
     HDFLIBAPI intn HPseek
-                (filerec_t *file_rec,int32 offset);
+                (filerec_t *file_rec,hdf_off_t offset);
 
     HDFLIBAPI intn HP_write
                 (filerec_t *file_rec,const void * buf,int32 bytes);
 
+    HDFLIBAPI intn HP_pread
+                (filerec_t *file_rec,void * buf,int32 bytes,hdf_off_t offset);
+
+    HDFLIBAPI intn HP_pwrite
+                (filerec_t *file_rec,const void * buf,int32 bytes,hdf_off_t offset);
+
+    HDFLIBAPI intn HPflush_writes
+                (filerec_t * file_rec);
+
+/*
+   ** from hfiledrv.c
+ */
+    HDFLIBAPI const hdf_fdriver_t *HPget_driver
+                (intn driver_id);
+
     HDFLIBAPI int32 HPread_drec
                 (int32 file_id, atom_t data_id, uint8** drec_buf);
 
@@ -512,6 +667,12 @@ extern      "C"
     HDFLIBAPI VOID tagdestroynode
                 (void * n);
 
+    HDFLIBAPI intn extentcompare
+                (void * k1, void * k2, intn cmparg);
+
+    HDFLIBAPI VOID extentdestroynode
+                (void * n);
+
 /*
    ** from hblocks.c
  */
@@ -704,13 +865,30 @@ extern      "C"
     Reads the DD blocks from disk and creates the in-memory structures for
     handling them.  This routine should only be called once for a given
     file and HTPend should be called when finished with the DD list (i.e.
-    when the file is being closed).
+    when the file is being closed).  If 'lazy' is set only the first DD
+    block is read in, the rest are read in when searches get to them.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+intn HTPstart(filerec_t *file_rec,      /* IN:  File record to store info in */
+    intn lazy                           /* IN:  Whether to read in only the first DD block */
+);
+
+/******************************************************************************
+ NAME
+     HTPload - Read in the rest of the DD list
+
+ DESCRIPTION
+    Reads in the DD blocks which HTPstart left on disk when asked to read
+    the DD list lazily.  Needed before the file is written to.
 
  RETURNS
     Returns SUCCEED if successful and FAIL otherwise
 
 *******************************************************************************/
-intn HTPstart(filerec_t *file_rec       /* IN:  File record to store info in */
+intn HTPload(filerec_t *file_rec       /* IN:  File record to store info in */
 );
 
 /******************************************************************************
@@ -745,6 +923,74 @@ intn HTPinit(filerec_t *file_rec,       /* IN: File record to store info in */
 intn HTPsync(filerec_t *file_rec       /* IN:  File record to store info in */
 );
 
+/******************************************************************************
+ NAME
+     HTPmerge - Merge the DD blocks after the first one into one block
+
+ DESCRIPTION
+    Rewrites the DD list as the first DD block followed by one block with
+    all the dd's in use from the other blocks, so that opening the file
+    takes two reads instead of one per block.  Only to be called when no
+    DD ids are attached to the file.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+intn HTPmerge(filerec_t *file_rec       /* IN:  File record to store info in */
+);
+
+/******************************************************************************
+ NAME
+     HTPgetfree - Take the free space recorded in the file into the free list
+
+ DESCRIPTION
+    Hands the extents the DFTAG_FREE dd's written by HTPputfree describe
+    to the free list of the file, so that new elements can be placed in
+    them.  The dd's stay in the file until the free list changes, see
+    HTPdropfree.  Called when the file is opened for writing.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+intn HTPgetfree(filerec_t *file_rec     /* IN:  File record to store info in */
+);
+
+/******************************************************************************
+ NAME
+     HTPdropfree - Delete the DFTAG_FREE dd's about to go out of date
+
+ DESCRIPTION
+    Deletes the DFTAG_FREE dd's HTPgetfree took the free list from, if they
+    are still in the file.  Called before the free list changes, so that
+    they never describe space handed out again.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+intn HTPdropfree(filerec_t *file_rec    /* IN:  File record to store info in */
+);
+
+/******************************************************************************
+ NAME
+     HTPputfree - Record the free list of the file in the DD list
+
+ DESCRIPTION
+    Writes a DFTAG_FREE dd for each extent in the free list of the file and
+    empties the free list, so that the space can be re-used the next time
+    the file is opened for writing.  Nothing is written if the list is the
+    one the DFTAG_FREE dd's of the file hold already.  Called when the file
+    is closed.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+intn HTPputfree(filerec_t *file_rec     /* IN:  File record to store info in */
+);
+
 /******************************************************************************
  NAME
      HTPend - Terminate the DD list in memory
@@ -843,7 +1089,7 @@ intn HTPdelete(atom_t ddid              /* IN: DD id to delete */
 
 *******************************************************************************/
 intn HTPupdate(atom_t ddid,             /* IN: DD id to update */
-    int32 new_off,                      /* IN: new offset for DD */
+    hdf_off_t new_off,                  /* IN: new offset for DD */
     int32 new_len                       /* IN: new length for DD */
 );
 
@@ -862,7 +1108,7 @@ intn HTPupdate(atom_t ddid,             /* IN: DD id to update */
 intn HTPinquire(atom_t ddid,            /* IN: DD id to inquire about */
     uint16 *tag,                        /* IN: tag of DD */
     uint16 *ref,                        /* IN: ref of DD */
-    int32 *off,                         /* IN: offset of DD */
+    hdf_off_t *off,                     /* IN: offset of DD */
     int32 *len                          /* IN: length of DD */
 );
 
@@ -60,8 +60,13 @@ EXPORTED ROUTINES
     HTPis_special- Check if a DD id is associated with a special tag
   DD list functions:
     HTPstart    - Initialize the DD list from disk (creates the DD list in memory)
+    HTPload     - Read in the rest of a lazily read DD list from disk
     HTPinit     - Create a new DD list (creates the DD list in memory)
     HTPsync     - Flush the DD list to disk (syncronizes with disk)
+    HTPmerge    - Merge the DD blocks after the first one into one block
+    HTPgetfree  - Take the DFTAG_FREE dd's of the file into its free list
+    HTPdropfree - Delete the DFTAG_FREE dd's before the free list changes
+    HTPputfree  - Write the free list of the file as DFTAG_FREE dd's
     HTPend      - Close the DD list to disk (syncronizes with disk too)
 LOCAL ROUTINES
     HTIfind_dd      - find a specific DD in the file
@@ -70,6 +75,16 @@ LOCAL ROUTINES
     HTIcount_dd     - counts the dd's of a certain type in file
     HTIregister_tag_ref     - insert a ref into the tag tree for a file
     HTIunregister_tag_ref   - remove a ref from the tag tree for a file
+    HTIread_dd_block        - read a DD block in from the file
+    HTIload_dd_block        - read in the next DD block not in memory yet
+    HTIload_all_dd_blocks   - read in all the DD blocks not in memory yet
+    HTInext_dd_block        - get the next DD block, reading it in if needed
+    HTIlookup_tag_ref       - look up a tag/ref, reading in DD blocks if needed
+    HTIwrite_dd_block       - write a DD block out to the file
+    HTIadd_extent           - insert the data of a dd into the extent tree
+    HTIremove_extent        - remove the data of a dd from the extent tree
+    HTIshared_extent        - check whether another dd uses the space of a dd
+    HTInewref               - get an unused ref for a tag
 
 OLD ROUTINES
     HIlookup_dd             - find the dd record for an element
@@ -110,23 +125,56 @@ static intn HTIregister_tag_ref(filerec_t * file_rec, dd_t *dd);
 
 static intn HTIunregister_tag_ref(filerec_t * file_rec, dd_t *dd_ptr);
 
+static intn HTIread_dd_block(filerec_t * file_rec, ddblock_t * block);
+
+static ddblock_t *HTIload_dd_block(filerec_t * file_rec);
+
+static intn HTIload_all_dd_blocks(filerec_t * file_rec);
+
+static ddblock_t *HTInext_dd_block(filerec_t * file_rec, ddblock_t * block);
+
+static intn HTIlookup_tag_ref(filerec_t * file_rec, uint16 tag, uint16 ref,
+            dd_t ** pdd);
+
+static intn HTIwrite_dd_block(filerec_t * file_rec, ddblock_t * block);
+
+static intn HTIadd_extent(filerec_t * file_rec, dd_t * dd_ptr);
+
+static intn HTIremove_extent(filerec_t * file_rec, dd_t * dd_ptr);
+
+static intn HTIshared_extent(filerec_t * file_rec, dd_t * dd_ptr);
+
+static uint16 HTInewref(filerec_t * file_rec, uint16 tag);
+
 /* Local definitions */
 /* The initial size of a ref dynarray */
 #define REF_DYNARRAY_START  64
 /* The increment of a ref dynarray */
 #define REF_DYNARRAY_INCR   256
-/* macros to encode and decode a DD */
-#define DDENCODE(p, tag,ref,offset,length) \
+/* macros to encode and decode an offset or a DD in the file's format */
+#define OFFSETENCODE(f, p, offset) \
+   {if ((f)->largefile) \
+        INT64ENCODE(p, offset) \
+    else \
+        INT32ENCODE(p, offset) \
+   }
+#define OFFSETDECODE(f, p, offset) \
+   {if ((f)->largefile) \
+        INT64DECODE(p, offset) \
+    else \
+        INT32DECODE(p, offset) \
+   }
+#define DDENCODE(f, p, tag,ref,offset,length) \
    {UINT16ENCODE(p, tag); \
     UINT16ENCODE(p, ref); \
-    INT32ENCODE(p, offset); \
-    INT32ENCODE(p, length); \
+    OFFSETENCODE(f, p, offset); \
+    OFFSETENCODE(f, p, length); \
    }
-#define DDDECODE(p, tag,ref,offset,length) \
+#define DDDECODE(f, p, tag,ref,offset,length) \
    {UINT16DECODE(p, tag); \
     UINT16DECODE(p, ref); \
-    INT32DECODE(p, offset); \
-    INT32DECODE(p, length); \
+    OFFSETDECODE(f, p, offset); \
+    OFFSETDECODE(f, p, length); \
    }
 
 
@@ -140,17 +188,20 @@ static intn HTIunregister_tag_ref(filerec_t * file_rec, dd_t *dd_ptr);
     file and HTPend should be called when finished with the DD list (i.e.
     when the file is being closed).
 
+    If 'lazy' is set only the first DD block is read in, the rest of the
+    DD blocks are read in as the searches of the DD list get to them.  The
+    end of the file is not known until HTPload has read in the whole DD
+    list, so this is only for files opened read-only.
+
  RETURNS
     Returns SUCCEED if successful and FAIL otherwise
 
 *******************************************************************************/
-intn HTPstart(filerec_t *file_rec       /* IN:  File record to store info in */
+intn HTPstart(filerec_t *file_rec,      /* IN:  File record to store info in */
+    intn lazy                           /* IN:  Whether to read in only the first DD block */
 )
 {
   CONSTR(FUNC, "HTPstart");	/* for HERROR */
-  uint8      *tbuf=NULL;  /* temporary buffer */
-  uintn       tbuf_size=0;    /* temporary buffer size */
-  int32       end_off = 0;	/* offset of the end of the file */
   intn        ret_value = SUCCEED;
 
   HEclear();
@@ -166,6 +217,7 @@ intn HTPstart(filerec_t *file_rec       /* IN:  File record to store info in */
   file_rec->ddlast = file_rec->ddhead;
   file_rec->ddlast->next = (ddblock_t *) NULL;
   file_rec->ddlast->prev = (ddblock_t *) NULL;
+  file_rec->ddlast->ddlist = (dd_t *) NULL;
 
   /* The first ddblock always starts after the magic number.
   Set it up so that we start reading from there. */
@@ -175,123 +227,30 @@ intn HTPstart(filerec_t *file_rec       /* IN:  File record to store info in */
   /* Initialize the tag tree */
   file_rec->tag_tree = tbbtdmake(tagcompare, sizeof(uint16), TBBT_FAST_UINT16_COMPARE);
 
+  /* Initialize the extent tree */
+  file_rec->extent_tree = tbbtdmake(extentcompare, sizeof(hdf_off_t), 0);
+
   /* Initialize the DD atom group (trying 256 hash currently, feel free to change */
   if(HAinit_group(DDGROUP,256)==FAIL)
     HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
-  /* Read in the dd's one at a time and determine the max ref in the file
-	   at the same time. */
+  /* The end of the file and the max ref are worked out from the dd's as
+     they are read in */
   file_rec->maxref = 0;
-  for (;;)
-    {
-        ddblock_t *ddcurr;      /* ptr to the current DD block */
-        dd_t *curr_dd_ptr;      /* pointer to the current DD being read in */
-        uint8       ddhead[NDDS_SZ+OFFSET_SZ];   /* storage for the DD header */
-        uint8      *p;          /* Temporary buffer pointer. */
-        intn        ndds;       /* number of DDs in a block */
-        intn        i;          /* Temporary integer */
-
-        /* Get a short-cut for the current DD block being read-in */
-        ddcurr=file_rec->ddlast;
-  
-        /* Go to the beginning of the DD block */
-        if (HPseek(file_rec, ddcurr->myoffset) == FAIL)
-          HGOTO_ERROR(DFE_SEEKERROR, FAIL);
-  
-        /* Read in the start of this dd block.
-           Read data consists of ndds (number of dd's in this block) and
-           offset (offset to the next ddblock). */
-        if (HP_read(file_rec, ddhead, NDDS_SZ + OFFSET_SZ) == FAIL)
-          HGOTO_ERROR(DFE_READERROR, FAIL);
-  
-        /* Decode the numbers. */
-        p = &ddhead[0];
-        INT16DECODE(p, ddcurr->ndds);
-        ndds = (intn)ddcurr->ndds;
-        if (ndds <= 0)		/* validity check */
-          HGOTO_ERROR(DFE_CORRUPT, FAIL);
-        INT32DECODE(p, ddcurr->nextoffset);
-  
-        /* check if the DD block is the last thing in the file */
-        /* (Unlikely, but possible (I think)) */
-        if (ddcurr->myoffset + (NDDS_SZ + OFFSET_SZ) + (ndds * DD_SZ) > end_off)
-          end_off = ddcurr->myoffset + (NDDS_SZ + OFFSET_SZ) + (ndds * DD_SZ);
-  
-        /* Now that we know how many dd's are in this block,
-           alloc memory for the records. */
-        ddcurr->ddlist = (dd_t *) HDmalloc((uint32) ndds * sizeof(dd_t));
-        if (ddcurr->ddlist==(dd_t *)NULL)
-          HGOTO_ERROR(DFE_NOSPACE, FAIL);
-  
-        /* Allocate memory for the temporary buffer also */
-        if(tbuf==NULL || ((uintn)ndds*DD_SZ)>tbuf_size)
-          {
-              if (tbuf!=(uint8 *)NULL)
-                  HDfree(tbuf);
-              tbuf_size=(uintn)ndds*DD_SZ;
-              tbuf=(uint8 *)HDmalloc(tbuf_size);
-              if (tbuf==(uint8 *)NULL)
-                HGOTO_ERROR(DFE_NOSPACE, FAIL);
-          } /* end if */
-  
-        /* Index of current dd in ddlist of this ddblock is 0. */
-        curr_dd_ptr=ddcurr->ddlist;
-  
-        /* Read in a chunk of dd's from the file. */
-        if (HP_read(file_rec, tbuf, ndds * DD_SZ) == FAIL)
-          HGOTO_ERROR(DFE_READERROR, FAIL);
-  
-      /* decode the dd's */
-        p = tbuf;
-        for (i = 0; i < ndds; i++, curr_dd_ptr++)
-          {
-	    DDDECODE(p, curr_dd_ptr->tag, curr_dd_ptr->ref,
-		curr_dd_ptr->offset, curr_dd_ptr->length);
-            curr_dd_ptr->blk=ddcurr;
-  
-             /* check if maximum ref # exceeded */
-            if (file_rec->maxref < curr_dd_ptr->ref)
-              file_rec->maxref = curr_dd_ptr->ref;
-  
-            /* check if the data element is the last thing in the file */
-            if ((curr_dd_ptr->offset + curr_dd_ptr->length) > end_off)
-              end_off = curr_dd_ptr->offset + curr_dd_ptr->length;
-  
-            /* Add to the tag info tree */
-            if(curr_dd_ptr->tag!=DFTAG_NULL)
-                if(HTIregister_tag_ref(file_rec,curr_dd_ptr)==FAIL)
-                    HGOTO_ERROR(DFE_INTERNAL, FAIL);
-          }
-  
-        if (ddcurr->nextoffset != 0)
-          {	/* More ddblocks in the file */
-              ddblock_t *ddnew;    /* ptr to the new DD block */
-  
-      /* extend the linked list */
-            ddcurr->next = ddnew = (ddblock_t *) HDmalloc((uint32) sizeof(ddblock_t));
-            if (ddnew == (ddblock_t *) NULL)
-              HGOTO_ERROR(DFE_NOSPACE, FAIL);
-  
-            ddnew->prev = ddcurr;
-            ddnew->next = (ddblock_t *) NULL;
-            ddnew->ddlist = (dd_t *) NULL;
-            ddnew->myoffset = ddcurr->nextoffset;
-            ddnew->dirty= FALSE;
-            file_rec->ddlast = ddnew;
-
-            /* Keep the filerec_t pointer around for each ddblock */
-            ddnew->frec=file_rec;
-          }	/* end if */
-        else
-              break;
-      } /* end for */
-    
-    /* Update the DFTAG_NULL pointers */
-    file_rec->ddnull=NULL;
-    file_rec->ddnull_idx=(-1);
+  file_rec->f_end_off = 0;
 
-    /* Update the end of the file from the DD's we have read in */
-    file_rec->f_end_off = end_off;
+  /* Read in the first DD block */
+  if (HTIread_dd_block(file_rec, file_rec->ddhead) == FAIL)
+    HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+  /* Read in the rest of the DD blocks now, unless we are asked not to */
+  if (!lazy)
+      if (HTIload_all_dd_blocks(file_rec) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    
+  /* Update the DFTAG_NULL pointers */
+  file_rec->ddnull=NULL;
+  file_rec->ddnull_idx=(-1);
 
 done:
   if(ret_value == FAIL)   
@@ -300,12 +259,48 @@ done:
     } /* end if */
 
   /* Normal function cleanup */
-  if(tbuf!=NULL)
-      HDfree(tbuf);
 
   return ret_value;
 } /* end HTPstart() */
 
+/******************************************************************************
+ NAME
+     HTPload - Read in the rest of the DD list
+
+ DESCRIPTION
+    Reads in the DD blocks which HTPstart left on disk when asked to read
+    the DD list lazily.  Needed before the file is written to, when the
+    end of the file must be known.  Does nothing if the whole DD list is
+    in memory already.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+intn HTPload(filerec_t *file_rec       /* IN:  File record to store info in */
+)
+{
+  CONSTR(FUNC, "HTPload");	/* for HERROR */
+  intn        ret_value = SUCCEED;
+
+  HEclear();
+  if (file_rec->ddhead == NULL)	/* check for DD list */
+    HGOTO_ERROR(DFE_BADDDLIST, FAIL);
+
+  if (HTIload_all_dd_blocks(file_rec) == FAIL)
+    HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+} /* end HTPload() */
+
 /******************************************************************************
  NAME
      HTPinit - Create a new DD list in memory
@@ -325,7 +320,7 @@ intn HTPinit(filerec_t *file_rec,       /* IN: File record to store info in */
 {
     CONSTR(FUNC, "HTPinit");    /* for HERROR */
     ddblock_t  *block;          /* dd block to intialize */
-    uint8       ddhead[NDDS_SZ+OFFSET_SZ];   /* storage for the DD header */
+    uint8       ddhead[NDDS_SZ+OFFSET64_SZ]; /* storage for the DD header */
     uint8      *tbuf=NULL;      /* temporary buffer */
     uint8      *p;              /* temp buffer ptr */
     dd_t       *list;           /* list of dd */
@@ -359,8 +354,8 @@ intn HTPinit(filerec_t *file_rec,       /* IN: File record to store info in */
     /* write first dd block header to file */
     p = &ddhead[0];
     INT16ENCODE(p, block->ndds);
-    INT32ENCODE(p, (int32) 0);
-    if (HP_write(file_rec, ddhead, NDDS_SZ + OFFSET_SZ) == FAIL)
+    OFFSETENCODE(file_rec, p, (int32) 0);
+    if (HP_write(file_rec, ddhead, FILE_DDHEAD_SZ(file_rec)) == FAIL)
       HGOTO_ERROR(DFE_WRITEERROR, FAIL);
   
     /* allocate and initialize dd list */
@@ -376,18 +371,18 @@ intn HTPinit(filerec_t *file_rec,       /* IN: File record to store info in */
     list[0].blk = block;
     HDmemfill(&list[1],&list[0],sizeof(dd_t),(uint32)(ndds-1));
 
-    tbuf=(uint8 *)HDmalloc(ndds*DD_SZ);
+    tbuf=(uint8 *)HDmalloc(ndds*FILE_DD_SZ(file_rec));
     if (tbuf == NULL)	/* check for DD list */
       HGOTO_ERROR(DFE_NOSPACE, FAIL);
   
     /* Fill the first disk DD block with NIL dd's */
     p = tbuf;
-    DDENCODE(p, (uint16) DFTAG_NULL, (uint16) DFREF_NONE,
+    DDENCODE(file_rec, p, (uint16) DFTAG_NULL, (uint16) DFREF_NONE,
 	(int32) INVALID_LENGTH, (int32) INVALID_OFFSET);
-    HDmemfill(p,tbuf,DD_SZ,(uint32)(ndds-1));
+    HDmemfill(p,tbuf,FILE_DD_SZ(file_rec),(uint32)(ndds-1));
 
     /* Write the NIL dd's out into the DD block on disk */
-    if (HP_write(file_rec, tbuf, ndds * DD_SZ) == FAIL)
+    if (HP_write(file_rec, tbuf, ndds * FILE_DD_SZ(file_rec)) == FAIL)
       HGOTO_ERROR(DFE_WRITEERROR, FAIL);
 
     /* Update the DFTAG_NULL pointers */
@@ -395,7 +390,7 @@ intn HTPinit(filerec_t *file_rec,       /* IN: File record to store info in */
     file_rec->ddnull_idx=(-1);
   
     /* set the end of the file currently to the end of the first DD block */
-    file_rec->f_end_off = block->myoffset + (NDDS_SZ + OFFSET_SZ) + (block->ndds * DD_SZ);
+    file_rec->f_end_off = block->myoffset + FILE_DDHEAD_SZ(file_rec) + (block->ndds * FILE_DD_SZ(file_rec));
   
     /* no dd's yet, so maximum ref is 0 */
     file_rec->maxref = 0;
@@ -403,6 +398,9 @@ intn HTPinit(filerec_t *file_rec,       /* IN: File record to store info in */
     /* Initialize the tag tree */
     file_rec->tag_tree = tbbtdmake(tagcompare, sizeof(uint16), TBBT_FAST_UINT16_COMPARE);
 
+    /* Initialize the extent tree */
+    file_rec->extent_tree = tbbtdmake(extentcompare, sizeof(hdf_off_t), 0);
+
     /* Initialize the DD atom group (trying 256 hash currently, feel free to change */
     if(HAinit_group(DDGROUP,256)==FAIL)
       HGOTO_ERROR(DFE_INTERNAL, FAIL);
@@ -436,13 +434,6 @@ intn HTPsync(filerec_t *file_rec       /* IN:  File record to store info in */
 {
     CONSTR(FUNC, "HTPsync");	/* for HERROR */
     ddblock_t  *block;		/* dd block to intialize */
-    uint8       ddhead[NDDS_SZ+OFFSET_SZ];   /* storage for the DD header */
-    uint8      *tbuf=NULL;  /* temporary buffer */
-    uintn       tbuf_size=0;    /* temporary buffer size */
-    uint8      *p;		/* temp buffer ptr */
-    dd_t       *list;		/* list of dd */
-    int16       ndds;		/* # of DDs per block */
-    intn        i;		/* temp ints */
     intn        ret_value = SUCCEED;
   
     HEclear();
@@ -454,36 +445,7 @@ intn HTPsync(filerec_t *file_rec       /* IN:  File record to store info in */
       {	/* check all the blocks for flushing */
         if (block->dirty == TRUE)
           {	/* flush this block? */
-            if (HPseek(file_rec, block->myoffset) == FAIL)
-              HGOTO_ERROR(DFE_SEEKERROR, FAIL);
-  
-      /* write dd block header to file */
-            p = ddhead;
-            INT16ENCODE(p, block->ndds);
-            INT32ENCODE(p, block->nextoffset);
-            if (HP_write(file_rec, ddhead, NDDS_SZ + OFFSET_SZ) == FAIL)
-              HGOTO_ERROR(DFE_WRITEERROR, FAIL);
-  
-      /* n is the maximum number of dd's in tbuf */
-            ndds = block->ndds;
-            /* Allocate memory for the temporary buffer also */
-            if(tbuf==NULL || ((uintn)ndds*DD_SZ)>tbuf_size)
-              {
-                  if (tbuf!=(uint8 *)NULL)
-                      HDfree(tbuf);
-                  tbuf_size=(uintn)ndds*DD_SZ;
-                  tbuf=(uint8 *)HDmalloc(tbuf_size);
-                  if (tbuf==(uint8 *)NULL)
-                    HGOTO_ERROR(DFE_NOSPACE, FAIL);
-              } /* end if */
-  
-      /* write dd list to file */
-            list = &block->ddlist[0];	/* start at the first DD, go from there */
-            p = tbuf;
-            for (i = 0; i < ndds; i++, list++)
-		DDENCODE(p, list->tag, list->ref, list->offset, list->length);
-
-            if (HP_write(file_rec, tbuf, ndds * DD_SZ) == FAIL)
+            if (HTIwrite_dd_block(file_rec, block) == FAIL)
               HGOTO_ERROR(DFE_WRITEERROR, FAIL);
   
             block->dirty = FALSE;	/* block has been flushed */
@@ -498,176 +460,274 @@ done:
     } /* end if */
 
   /* Normal function cleanup */
-  if (tbuf!=(uint8 *)NULL)
-      HDfree(tbuf);
 
   return ret_value;
 } /* end HTPsync() */
 
 /******************************************************************************
  NAME
-     HTPend - Terminate the DD list in memory
+     HTPmerge - Merge the DD blocks after the first one into one block
 
  DESCRIPTION
-    Terminates access to the DD list in memory, writing the DD blocks out to
-    the disk (if they've changed).  After this routine is called, no further
-    access to tag/refs (or essentially any other HDF objects) can be performed
-    on the file.
+    Files written a few objects at a time end up with a long chain of small
+    DD blocks, each of which takes a seek and a read when the file is
+    opened.  This rewrites the DD list as the first DD block (which always
+    stays right after the magic number) followed by one block holding all
+    the dd's in use from the other blocks, in the same order, with some
+    room left for new dd's.  The merged block never overwrites the old
+    ones: it is written to new space (free space or the end of the file),
+    then the first block is pointed at it, and only after that is the space
+    of the old blocks given back with HPfreediskblock.  A crash part way
+    through leaves either the old chain or the new one on disk, never a
+    half-written one.
+
+    Blocks of more than MAX_NDDS dd's cannot be stored, so a very large DD
+    list becomes a few contiguous blocks of MAX_NDDS dd's.
+
+    The dd's move in memory, so this must only be called when there are no
+    DD ids attached to the file (i.e. when the file is being closed).
 
  RETURNS
     Returns SUCCEED if successful and FAIL otherwise
 
 *******************************************************************************/
-intn HTPend(filerec_t *file_rec       /* IN:  File record to store info in */
-) 
+intn HTPmerge(filerec_t *file_rec       /* IN:  File record to store info in */
+)
 {
-    CONSTR(FUNC, "HTPend");	/* for HERROR */
-    ddblock_t  *bl, *next;	/* current ddblock and next ddblock pointers.
-				   for freeing ddblock linked list */
+    CONSTR(FUNC, "HTPmerge");	/* for HERROR */
+    ddblock_t  *head;           /* first dd block, which is not moved */
+    ddblock_t  *block;          /* dd block being looked at */
+    ddblock_t  *next;           /* next dd block to free */
+    ddblock_t  *first=NULL;     /* first merged dd block */
+    ddblock_t  *last=NULL;      /* last merged dd block */
+    dd_t       *dd_ptr;         /* dd being copied */
+    dd_t       *new_dd;         /* where the dd is copied to */
+    int32       nused = 0;      /* # of dd's in use after the first block */
+    int32       nslots;         /* # of dd's in the merged blocks */
+    int32       nblocks = 0;    /* # of blocks in the chain after the first */
+    hdf_off_t   offset;         /* offset of the merged blocks in the file */
+    intn        idx;            /* index into a dd list */
     intn        ret_value = SUCCEED;
 
     HEclear();
-    if(HTPsync(file_rec)==FAIL)
-        HGOTO_ERROR(DFE_INTERNAL, FAIL);
-
-    for (bl = file_rec->ddhead; bl!=NULL; bl = next)
-      {
-        next = bl->next;
-        if (bl->ddlist)
-          HDfree((VOIDP) bl->ddlist);
-        HDfree((VOIDP) bl);
-      }
-
-    /* Chuck the tag info tree too */
-    tbbtdfree(file_rec->tag_tree,tagdestroynode,NULL);
+    if ((head = file_rec->ddhead) == NULL)	/* check for DD list */
+      HGOTO_ERROR(DFE_BADDDLIST, FAIL);
 
-    /* Shutdown the DD atom group */
-    if(HAdestroy_group(DDGROUP)==FAIL)
+    if (HTIload_all_dd_blocks(file_rec) == FAIL)
       HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
-    file_rec->ddhead = (ddblock_t *) NULL;
-
-done:
-  if(ret_value == FAIL)   
-    { /* Error condition cleanup */
-
-    } /* end if */
+    /* Count the dd's to move */
+    for (block = head->next; block != NULL; block = block->next)
+      {
+        nblocks++;
+        for (idx = 0, dd_ptr = block->ddlist; idx < block->ndds; idx++, dd_ptr++)
+            if (dd_ptr->tag != DFTAG_NULL)
+                nused++;
+      } /* end for */
 
-  /* Normal function cleanup */
+    /* Nothing to gain unless there are at least two blocks after the first
+       one, or some of them are empty */
+    if (nblocks == 0 || (nused > 0 && (nused + MAX_NDDS - 1) / MAX_NDDS >= nblocks))
+        HGOTO_DONE(SUCCEED);
 
-  return ret_value;
-} /* end HTPend() */
+    if (nused > 0)
+      {
+        int32 left;             /* # of dd slots still to put in blocks */
+
+        /* Leave room for a first block's worth of new dd's, rounding up */
+        nslots = ((nused / head->ndds) + 1) * head->ndds;
+        if (nslots / MAX_NDDS > (nused + MAX_NDDS - 1) / MAX_NDDS)
+            nslots = nused;     /* the room would need another block */
+
+        /* Always put the merged blocks in new space, so the old chain stays
+           intact on disk until the first block points past it */
+        if ((offset = HPgetdiskblock(file_rec,
+                (nslots + MAX_NDDS - 1) / MAX_NDDS * FILE_DDHEAD_SZ(file_rec)
+                + nslots * FILE_DD_SZ(file_rec), FALSE)) == FAIL)
+          HGOTO_ERROR(DFE_SEEKERROR, FAIL);
 
-/******************************************************************************
- NAME
-     HTPcreate - Create (and attach to) a tag/ref pair
+        /* Build the new blocks in memory */
+        for (left = nslots; left > 0; )
+          {
+            ddblock_t *newblk;   /* new dd block */
+            intn ndds = (intn)MIN(left, MAX_NDDS);
 
- DESCRIPTION
-    Creates a new tag/ref pair in memory and inserts the tag/ref pair into the
-    DD list to be written out to disk.  This routine returns a DD id which can
-    be used in the other tag/ref routines to modify the DD.
+            if ((newblk = (ddblock_t *) HDmalloc(sizeof(ddblock_t))) == NULL)
+              HGOTO_ERROR(DFE_NOSPACE, FAIL);
+            if ((newblk->ddlist = (dd_t *) HDmalloc((uint32) ndds * sizeof(dd_t))) == NULL)
+              {
+                HDfree(newblk);
+                HGOTO_ERROR(DFE_NOSPACE, FAIL);
+              } /* end if */
+            newblk->ndds = (int16)ndds;
+            newblk->myoffset = offset;
+            newblk->nextoffset = 0;
+            newblk->dirty = FALSE;
+            newblk->frec = file_rec;
+            newblk->next = NULL;
+            newblk->prev = last;
+
+            newblk->ddlist[0].tag = DFTAG_NULL;
+            newblk->ddlist[0].ref = DFREF_NONE;
+            newblk->ddlist[0].length = INVALID_LENGTH;
+            newblk->ddlist[0].offset = INVALID_OFFSET;
+            newblk->ddlist[0].blk = newblk;
+            HDmemfill(&newblk->ddlist[1],&newblk->ddlist[0],sizeof(dd_t),(uint32)(ndds-1));
+
+            if (last == NULL)
+                first = newblk;
+            else
+              {
+                last->next = newblk;
+                last->nextoffset = offset;
+              } /* end else */
+            last = newblk;
 
- RETURNS
-    Returns DD id if successful and FAIL otherwise
+            offset += FILE_DDHEAD_SZ(file_rec) + ndds * FILE_DD_SZ(file_rec);
+            left -= ndds;
+          } /* end for */
 
-*******************************************************************************/
-atom_t HTPcreate(filerec_t *file_rec,   /* IN: File record to store info in */
-    uint16 tag,                         /* IN: Tag to create */
-    uint16 ref                          /* IN: ref to create */
-)
-{
-    CONSTR(FUNC, "HTPcreate");  /* for HERROR */
-    dd_t *dd_ptr=NULL;          /* ptr to dd created */
-    atom_t ret_value=SUCCEED;
+        /* Copy the dd's in use over, in order */
+        block = first;
+        new_dd = first->ddlist;
+        idx = 0;
+        for (next = head->next; next != NULL; next = next->next)
+          {
+            intn i;
 
-    HEclear();
-    if(file_rec==NULL || (tag==DFTAG_NULL || tag==DFTAG_WILDCARD) ||
-            ref==DFREF_WILDCARD)
-        HGOTO_ERROR(DFE_ARGS, FAIL);
+            for (i = 0, dd_ptr = next->ddlist; i < next->ndds; i++, dd_ptr++)
+              {
+                if (dd_ptr->tag == DFTAG_NULL)
+                    continue;
+                if (idx == block->ndds)
+                  {
+                    block = block->next;
+                    new_dd = block->ddlist;
+                    idx = 0;
+                  } /* end if */
+                new_dd->tag = dd_ptr->tag;
+                new_dd->ref = dd_ptr->ref;
+                new_dd->offset = dd_ptr->offset;
+                new_dd->length = dd_ptr->length;
+                new_dd++;
+                idx++;
+              } /* end for */
+          } /* end for */
 
-    if(HTIfind_dd(file_rec,(uint16)DFTAG_NULL,(uint16)DFTAG_WILDCARD,
-            &dd_ptr,DF_FORWARD)==FAIL)
-      {
-        if (HTInew_dd_block(file_rec) == FAIL)
-          {
-            HGOTO_ERROR(DFE_NOFREEDD, FAIL);
-          }	/* end if */
-        else
-            dd_ptr=&file_rec->ddlast->ddlist[0];
+        /* Write the new blocks out before the first block points at them */
+        for (block = first; block != NULL; block = block->next)
+            if (HTIwrite_dd_block(file_rec, block) == FAIL)
+              HGOTO_ERROR(DFE_WRITEERROR, FAIL);
       } /* end if */
 
-    /* Insert DD information into the DD list in memory */
-    dd_ptr->tag=tag;
-    dd_ptr->ref=ref;
-    /* the following assures object defintion in DD list 
-       without data written for object. */
-    dd_ptr->offset=INVALID_OFFSET;
-    dd_ptr->length=INVALID_LENGTH;
+    /* Point the first block at the merged blocks */
+    head->nextoffset = (first != NULL ? first->myoffset : 0);
+    if (HTIwrite_dd_block(file_rec, head) == FAIL)
+      HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+    head->dirty = FALSE;
 
-    /* dd_ptr->blk should already be correctly set */
+    /* Only now give back the space of the old blocks */
+    for (block = head->next; block != NULL; block = block->next)
+        if (HPfreediskblock(file_rec, block->myoffset,
+                FILE_DDHEAD_SZ(file_rec) + block->ndds * FILE_DD_SZ(file_rec)) == FAIL)
+          HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
-    /* Update the disk, etc. */
-    if(HTIupdate_dd(file_rec,dd_ptr)==FAIL)
-        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    /* The new blocks are on disk, swap them in for the old ones in memory */
+    for (block = head->next; block != NULL; block = next)
+      {
+        next = block->next;
+        HDfree(block->ddlist);
+        HDfree(block);
+      } /* end for */
 
-    /* Mark off the ref # as 'used' in the tag tree & add to dynarray of refs */
-    if(HTIregister_tag_ref(file_rec,dd_ptr)==FAIL)
-        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    head->next = first;
+    if (first != NULL)
+        first->prev = head;
+    file_rec->ddlast = (last != NULL ? last : head);
+    first = last = NULL;
 
-    /* Get the atom to return */
-    if((ret_value=HAregister_atom(DDGROUP,dd_ptr))==FAIL)
-        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    /* The tag tree points at the dd's, so re-point it at the new copies */
+    for (block = head->next; block != NULL; block = block->next)
+        for (idx = 0, dd_ptr = block->ddlist; idx < block->ndds; idx++, dd_ptr++)
+          {
+            tag_info **tip_ptr;   /* ptr to the ptr to the info for a tag */
+            uint16 base_tag=BASETAG(dd_ptr->tag);
+
+            if (dd_ptr->tag == DFTAG_NULL)
+                continue;
+            if((tip_ptr=(tag_info **)tbbtdfind(file_rec->tag_tree,(VOIDP)&base_tag,NULL))==NULL)
+                HGOTO_ERROR(DFE_BADTAG, FAIL);
+            if(DAset_elem((*tip_ptr)->d,(intn)dd_ptr->ref,(VOIDP)dd_ptr)==FAIL)
+                HGOTO_ERROR(DFE_INTERNAL, FAIL);
+          } /* end for */
+
+    /* Reset the DFTAG_NULL pointers */
+    file_rec->ddnull = NULL;
+    file_rec->ddnull_idx = (-1);
 
 done:
   if(ret_value == FAIL)   
     { /* Error condition cleanup */
-
+      for (block = first; block != NULL; block = next)
+        {
+          next = block->next;
+          HDfree(block->ddlist);
+          HDfree(block);
+        } /* end for */
     } /* end if */
 
   /* Normal function cleanup */
 
   return ret_value;
-}   /* HTPcreate() */
+} /* end HTPmerge() */
 
 /******************************************************************************
  NAME
-     HTPselect - Attach to an existing tag/ref pair
+     HTPgetfree - Take the free space recorded in the file into the free list
 
  DESCRIPTION
-    Attaches to an existing tag/ref pair.  This routine returns a DD id which
-    can be used in the other tag/ref routines to modify the DD.
+    Hands the extents the DFTAG_FREE dd's written by HTPputfree describe
+    to the free list of the file, so that new elements can be placed in
+    them.  The dd's themselves are left in the file until the free list
+    changes, see HTPdropfree(), so opening and closing a file without
+    using or releasing space does not rewrite them.  Called when the file
+    is opened for writing.
 
  RETURNS
-    Returns DD id if successful and FAIL otherwise
+    Returns SUCCEED if successful and FAIL otherwise
 
 *******************************************************************************/
-atom_t HTPselect(filerec_t *file_rec,   /* IN: File record to store info in */
-    uint16 tag,                         /* IN: Tag to select */
-    uint16 ref                          /* IN: ref to select */
+intn HTPgetfree(filerec_t *file_rec     /* IN:  File record to store info in */
 )
 {
-    CONSTR(FUNC, "HTPselect");  /* for HERROR */
-    dd_t *dd_ptr;         /* ptr to the DD info for the tag/ref */
-    tag_info **tip_ptr;   /* ptr to the ptr to the info for a tag */
-    tag_info *tinfo_ptr;  /* pointer to the info for a tag */
-    uint16 base_tag=BASETAG(tag);    /* corresponding base tag (if the tag is special) */
-    atom_t ret_value=SUCCEED;
+    CONSTR(FUNC, "HTPgetfree");	/* for HERROR */
+    ddblock_t  *block;          /* current DD block */
+    dd_t       *dd_ptr;         /* current dd */
+    hdf_off_t   end_off;        /* end of the file before */
+    intn        idx;            /* index of the dd in the block */
+    intn        ret_value = SUCCEED;
 
     HEclear();
-    if(file_rec==NULL || (tag==DFTAG_NULL || tag==DFTAG_WILDCARD) ||
-            ref==DFREF_WILDCARD)
+    if (file_rec == NULL)
         HGOTO_ERROR(DFE_ARGS, FAIL);
-        
-    /* Try to find the regular tag in the tag info tree */
-    if((tip_ptr=(tag_info **)tbbtdfind(file_rec->tag_tree,(VOIDP)&base_tag,NULL))==NULL)
-        HGOTO_DONE(FAIL); /* Not an error, we just didn't find the object */
 
-    tinfo_ptr=*tip_ptr; /* get the pointer to the tag info */
-    if((dd_ptr=DAget_elem(tinfo_ptr->d,(intn)ref))==NULL)
-        HGOTO_DONE(FAIL); /* Not an error, we just didn't find the object */
+    /* The DFTAG_FREE dd's can be anywhere in the DD list */
+    if (HTIload_all_dd_blocks(file_rec) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
-    /* Get the atom to return */
-    if((ret_value=HAregister_atom(DDGROUP,dd_ptr))==FAIL)
+    /* The list is built from the dd's, it does not change them */
+    file_rec->free_ondisk = FALSE;
+    end_off = file_rec->f_end_off;
+    for (block = file_rec->ddhead; block != NULL; block = block->next)
+        for (dd_ptr = block->ddlist, idx = 0; idx < block->ndds; idx++, dd_ptr++)
+            if (dd_ptr->tag == DFTAG_FREE
+                && HPfreediskblock(file_rec, dd_ptr->offset, dd_ptr->length) == FAIL)
+                HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    file_rec->free_ondisk = TRUE;
+
+    /* Free space at the end just shortens the file, the dd's for it must
+       go before anything is appended there */
+    if (file_rec->f_end_off != end_off && HTPdropfree(file_rec) == FAIL)
         HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
 done:
@@ -679,32 +739,49 @@ done:
   /* Normal function cleanup */
 
   return ret_value;
-}   /* HTPselect() */
+} /* end HTPgetfree() */
 
 /******************************************************************************
  NAME
-     HTPendaccess - End access to an existing tag/ref pair
+     HTPdropfree - Delete the DFTAG_FREE dd's about to go out of date
 
  DESCRIPTION
-    Ends access to an existing tag/ref pair.  Any further access to the tag/ref
-    pair may result in incorrect information being recorded about the DD in
-    memory or on disk.
+    Deletes the DFTAG_FREE dd's HTPgetfree took the free list from, if they
+    are still in the file.  Called before the free list changes, so that
+    the dd's never describe space handed out again, even if the file is
+    not closed properly; HTPputfree writes the new list out.
 
  RETURNS
     Returns SUCCEED if successful and FAIL otherwise
 
 *******************************************************************************/
-intn HTPendaccess(atom_t ddid           /* IN: DD id to end access to */
+intn HTPdropfree(filerec_t *file_rec    /* IN:  File record to store info in */
 )
 {
-#ifdef LATER
-    CONSTR(FUNC, "HTPendaccess"); /* for HERROR */
-#endif /* LATER */
-    int32 ret_value=SUCCEED;
+    CONSTR(FUNC, "HTPdropfree");	/* for HERROR */
+    ddblock_t  *block;          /* current DD block */
+    atom_t      ddid;           /* DD id of a DFTAG_FREE dd */
+    intn        idx;            /* index of the dd in the block */
+    intn        ret_value = SUCCEED;
 
-    /* Chuck the atom */
-    if(HAremove_atom(ddid)==NULL)
-        HGOTO_DONE(FAIL);
+    if (file_rec == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    if (!file_rec->free_ondisk)
+        HGOTO_DONE(SUCCEED);
+    file_rec->free_ondisk = FALSE;
+
+    /* The extents of the dd's are in the free list already, deleting the
+       dd's gives nothing back twice */
+    for (block = file_rec->ddhead; block != NULL; block = block->next)
+        for (idx = 0; idx < block->ndds; idx++)
+            if (block->ddlist[idx].tag == DFTAG_FREE)
+              {
+                if ((ddid = HTPselect(file_rec, DFTAG_FREE, block->ddlist[idx].ref)) == FAIL)
+                    HGOTO_ERROR(DFE_INTERNAL, FAIL);
+                if (HTPdelete(ddid) == FAIL)
+                    HGOTO_ERROR(DFE_CANTDELDD, FAIL);
+              } /* end if */
 
 done:
   if(ret_value == FAIL)   
@@ -715,22 +792,324 @@ done:
   /* Normal function cleanup */
 
   return ret_value;
-}   /* HTPendaccess() */
+} /* end HTPdropfree() */
 
 /******************************************************************************
  NAME
-     HTPdelete - Delete an existing tag/ref pair
+     HTPputfree - Record the free list of the file in the DD list
 
  DESCRIPTION
-    Deletes a tag/ref from the file.  Also ends access to the tag/ref pair.
-    Any further access to the tag/ref pair may result in incorrect information
-    being recorded about the DD in memory or on disk.
+    Writes a DFTAG_FREE dd for each extent in the free list of the file and
+    empties the free list, so that the space can be re-used the next time
+    the file is opened for writing.  Nothing is written if the list has not
+    changed since HTPgetfree read it from the file.  Called when the file
+    is closed.
+
+    Older versions of the library treat the DFTAG_FREE dd's like any other
+    element, so they never write over the free space either.
 
  RETURNS
     Returns SUCCEED if successful and FAIL otherwise
 
 *******************************************************************************/
-intn HTPdelete(atom_t ddid              /* IN: DD id to delete */
+intn HTPputfree(filerec_t *file_rec     /* IN:  File record to store info in */
+)
+{
+    CONSTR(FUNC, "HTPputfree");	/* for HERROR */
+    freeblock_t *list;          /* the free list being written out */
+    freeblock_t *next;          /* next extent in the free list */
+    atom_t      ddid;           /* DD id of the new DFTAG_FREE dd */
+    uint16      ref;            /* ref of the new DFTAG_FREE dd */
+    intn        ret_value = SUCCEED;
+
+    HEclear();
+    if (file_rec == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* Take the list off the file, a DD block needed for the new dd's must
+       not be placed in the space being recorded */
+    list = file_rec->freelist;
+    file_rec->freelist = NULL;
+
+    for (; list != NULL; list = next)
+      {
+        next = list->next;
+
+        /* If the refs run out, the rest of the space is just lost.  The
+           dd's of an unchanged list are in the file already */
+        if (!file_rec->free_ondisk
+            && (ref = HTInewref(file_rec, DFTAG_FREE)) != 0)
+          {
+            if ((ddid = HTPcreate(file_rec, DFTAG_FREE, ref)) == FAIL)
+                ret_value = FAIL;
+            else
+              {
+                if (HTPupdate(ddid, list->offset, list->length) == FAIL)
+                    ret_value = FAIL;
+                if (HTPendaccess(ddid) == FAIL)
+                    ret_value = FAIL;
+              } /* end else */
+          } /* end if */
+        HDfree(list);
+      } /* end for */
+    file_rec->free_ondisk = TRUE;
+
+    if (ret_value == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+} /* end HTPputfree() */
+
+/******************************************************************************
+ NAME
+     HTPend - Terminate the DD list in memory
+
+ DESCRIPTION
+    Terminates access to the DD list in memory, writing the DD blocks out to
+    the disk (if they've changed).  After this routine is called, no further
+    access to tag/refs (or essentially any other HDF objects) can be performed
+    on the file.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+intn HTPend(filerec_t *file_rec       /* IN:  File record to store info in */
+) 
+{
+    CONSTR(FUNC, "HTPend");	/* for HERROR */
+    ddblock_t  *bl, *next;	/* current ddblock and next ddblock pointers.
+				   for freeing ddblock linked list */
+    intn        ret_value = SUCCEED;
+
+    HEclear();
+    if(HTPsync(file_rec)==FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    for (bl = file_rec->ddhead; bl!=NULL; bl = next)
+      {
+        next = bl->next;
+        if (bl->ddlist)
+          HDfree((VOIDP) bl->ddlist);
+        HDfree((VOIDP) bl);
+      }
+
+    /* Chuck the tag info tree too */
+    tbbtdfree(file_rec->tag_tree,tagdestroynode,NULL);
+
+    /* And the extent tree */
+    tbbtdfree(file_rec->extent_tree,extentdestroynode,NULL);
+
+    /* Shutdown the DD atom group */
+    if(HAdestroy_group(DDGROUP)==FAIL)
+      HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    file_rec->ddhead = (ddblock_t *) NULL;
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+} /* end HTPend() */
+
+/******************************************************************************
+ NAME
+     HTPcreate - Create (and attach to) a tag/ref pair
+
+ DESCRIPTION
+    Creates a new tag/ref pair in memory and inserts the tag/ref pair into the
+    DD list to be written out to disk.  This routine returns a DD id which can
+    be used in the other tag/ref routines to modify the DD.
+
+ RETURNS
+    Returns DD id if successful and FAIL otherwise
+
+*******************************************************************************/
+atom_t HTPcreate(filerec_t *file_rec,   /* IN: File record to store info in */
+    uint16 tag,                         /* IN: Tag to create */
+    uint16 ref                          /* IN: ref to create */
+)
+{
+    CONSTR(FUNC, "HTPcreate");  /* for HERROR */
+    dd_t *dd_ptr=NULL;          /* ptr to dd created */
+    atom_t ret_value=SUCCEED;
+
+    HEclear();
+    if(file_rec==NULL || (tag==DFTAG_NULL || tag==DFTAG_WILDCARD) ||
+            ref==DFREF_WILDCARD)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* Make sure the tag/ref is not in a part of the DD list not read in
+       yet, it would be found twice when that part is read in */
+    if(file_rec->ddlast->nextoffset!=0)
+        switch(HTIlookup_tag_ref(file_rec,tag,ref,&dd_ptr))
+          {
+            case FAIL:
+                HGOTO_ERROR(DFE_INTERNAL, FAIL);
+            case TRUE:
+                HGOTO_ERROR(DFE_DUPDD, FAIL);
+            default:
+                dd_ptr=NULL;
+                break;
+          } /* end switch */
+
+    if(HTIfind_dd(file_rec,(uint16)DFTAG_NULL,(uint16)DFTAG_WILDCARD,
+            &dd_ptr,DF_FORWARD)==FAIL)
+      {
+        if (HTInew_dd_block(file_rec) == FAIL)
+          {
+            HGOTO_ERROR(DFE_NOFREEDD, FAIL);
+          }	/* end if */
+        else
+            dd_ptr=&file_rec->ddlast->ddlist[0];
+      } /* end if */
+
+    /* Insert DD information into the DD list in memory */
+    dd_ptr->tag=tag;
+    dd_ptr->ref=ref;
+    /* the following assures object defintion in DD list 
+       without data written for object. */
+    dd_ptr->offset=INVALID_OFFSET;
+    dd_ptr->length=INVALID_LENGTH;
+
+    /* dd_ptr->blk should already be correctly set */
+
+    /* Update the disk, etc. */
+    if(HTIupdate_dd(file_rec,dd_ptr)==FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    /* Mark off the ref # as 'used' in the tag tree & add to dynarray of refs */
+    if(HTIregister_tag_ref(file_rec,dd_ptr)==FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    /* Get the atom to return */
+    if((ret_value=HAregister_atom(DDGROUP,dd_ptr))==FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+}   /* HTPcreate() */
+
+/******************************************************************************
+ NAME
+     HTPselect - Attach to an existing tag/ref pair
+
+ DESCRIPTION
+    Attaches to an existing tag/ref pair.  This routine returns a DD id which
+    can be used in the other tag/ref routines to modify the DD.
+
+ RETURNS
+    Returns DD id if successful and FAIL otherwise
+
+*******************************************************************************/
+atom_t HTPselect(filerec_t *file_rec,   /* IN: File record to store info in */
+    uint16 tag,                         /* IN: Tag to select */
+    uint16 ref                          /* IN: ref to select */
+)
+{
+    CONSTR(FUNC, "HTPselect");  /* for HERROR */
+    dd_t *dd_ptr;         /* ptr to the DD info for the tag/ref */
+    atom_t ret_value=SUCCEED;
+
+    HEclear();
+    if(file_rec==NULL || (tag==DFTAG_NULL || tag==DFTAG_WILDCARD) ||
+            ref==DFREF_WILDCARD)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+        
+    /* Try to find the tag/ref in the tag info tree */
+    switch(HTIlookup_tag_ref(file_rec,tag,ref,&dd_ptr))
+      {
+        case FAIL:
+            HGOTO_ERROR(DFE_INTERNAL, FAIL);
+        case FALSE:
+            HGOTO_DONE(FAIL); /* Not an error, we just didn't find the object */
+      } /* end switch */
+
+    /* Get the atom to return */
+    if((ret_value=HAregister_atom(DDGROUP,dd_ptr))==FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+}   /* HTPselect() */
+
+/******************************************************************************
+ NAME
+     HTPendaccess - End access to an existing tag/ref pair
+
+ DESCRIPTION
+    Ends access to an existing tag/ref pair.  Any further access to the tag/ref
+    pair may result in incorrect information being recorded about the DD in
+    memory or on disk.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+intn HTPendaccess(atom_t ddid           /* IN: DD id to end access to */
+)
+{
+#ifdef LATER
+    CONSTR(FUNC, "HTPendaccess"); /* for HERROR */
+#endif /* LATER */
+    int32 ret_value=SUCCEED;
+
+    /* Chuck the atom */
+    if(HAremove_atom(ddid)==NULL)
+        HGOTO_DONE(FAIL);
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+}   /* HTPendaccess() */
+
+/******************************************************************************
+ NAME
+     HTPdelete - Delete an existing tag/ref pair
+
+ DESCRIPTION
+    Deletes a tag/ref from the file.  Also ends access to the tag/ref pair.
+    Any further access to the tag/ref pair may result in incorrect information
+    being recorded about the DD in memory or on disk.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+intn HTPdelete(atom_t ddid              /* IN: DD id to delete */
 )
 {
     CONSTR(FUNC, "HTPdelete"); /* for HERROR */
@@ -750,9 +1129,15 @@ intn HTPdelete(atom_t ddid              /* IN: DD id to delete */
     file_rec->ddnull=NULL;
     file_rec->ddnull_idx=(-1);
   
-    if (HPfreediskblock(file_rec,dd_ptr->offset,dd_ptr->length) == FAIL)
+    /* Give the space back, unless it is still used by a copy of the DD */
+    if (!HTIshared_extent(file_rec,dd_ptr)
+            && HPfreediskblock(file_rec,dd_ptr->offset,dd_ptr->length) == FAIL)
         HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
+    /* The tag/ref may be re-used, don't let the shared chunk cache (see
+       hcache.c) serve the deleted data for it */
+    HCSinvalidate(file_rec,dd_ptr->tag,dd_ptr->ref);
+
     /* Update the disk, etc. */
     if(HTIupdate_dd(file_rec,dd_ptr)==FAIL)
         HGOTO_ERROR(DFE_INTERNAL, FAIL);
@@ -793,7 +1178,7 @@ done:
 
 *******************************************************************************/
 intn HTPupdate(atom_t ddid,             /* IN: DD id to update */
-    int32 new_off,                      /* IN: new offset for DD */
+    hdf_off_t new_off,                  /* IN: new offset for DD */
     int32 new_len                       /* IN: new length for DD */
 )
 {
@@ -807,11 +1192,15 @@ intn HTPupdate(atom_t ddid,             /* IN: DD id to update */
     if((dd_ptr=HAatom_object(ddid))==NULL)
         HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
-    /* Update the tag/ref in memory */
+    /* Update the tag/ref in memory, and where its data is */
+    if(HTIremove_extent(dd_ptr->blk->frec,dd_ptr)==FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
     if(new_len != dont_change)
         dd_ptr->length=new_len;
     if(new_off != dont_change)
         dd_ptr->offset=new_off;
+    if(HTIadd_extent(dd_ptr->blk->frec,dd_ptr)==FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
     /* Update the disk, etc. */
     if(HTIupdate_dd(dd_ptr->blk->frec,dd_ptr)==FAIL)
@@ -843,7 +1232,7 @@ done:
 intn HTPinquire(atom_t ddid,            /* IN: DD id to inquire about */
     uint16 *tag,                        /* IN: tag of DD */
     uint16 *ref,                        /* IN: ref of DD */
-    int32 *off,                         /* IN: offset of DD */
+    hdf_off_t *off,                     /* IN: offset of DD */
     int32 *len                          /* IN: length of DD */
 )
 {
@@ -937,12 +1326,14 @@ intn Hdupdd(int32 file_id,      /* IN: File ID the tag/refs are in */
         uint16 old_ref          /* IN: Ref of old tag/ref */
 )
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "Hdupdd"); /* for HERROR */
     filerec_t  *file_rec;		/* file record */
     atom_t      old_dd;         /* The DD id for the old DD */
     atom_t      new_dd;         /* The DD id for the new DD */
     int32       old_len;        /* The length of the old DD */
-    int32       old_off;        /* The offset of the old DD */
+    hdf_off_t   old_off;        /* The offset of the old DD */
     intn ret_value=SUCCEED;
 
     /* clear error stack and check validity of file id */
@@ -1002,6 +1393,8 @@ int32 Hnumber(int32 file_id,    /* IN: File ID the tag/refs are in */
         uint16 tag              /* IN: Tag to count */
 )
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "Hnumber");
     uintn       all_cnt;
     uintn       real_cnt;
@@ -1048,6 +1441,8 @@ done:
 uint16 
 Hnewref(int32 file_id /* IN: File ID the tag/refs are in */)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "Hnewref");
     filerec_t  *file_rec;	   /* file record */
     uint16      ref;		   /* the new ref */
@@ -1060,6 +1455,10 @@ Hnewref(int32 file_id /* IN: File ID the tag/refs are in */)
     if (BADFREC(file_rec))
         HGOTO_ERROR(DFE_ARGS, 0);
   
+    /* The maximum ref # is only known with the whole DD list in memory */
+    if (HTIload_all_dd_blocks(file_rec) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, 0);
+
     /* if maxref of this file is still below the maximum,
      just return next number */
     if (file_rec->maxref < MAX_REF)
@@ -1108,11 +1507,10 @@ uint16
 Htagnewref(int32 file_id,/* IN: File ID the tag/refs are in */
            uint16 tag    /* IN: Tag to search for a new ref for */)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "Htagnewref");
     filerec_t  *file_rec;  /* file record */
-    tag_info   *tinfo_ptr; /* pointer to the info for a tag */
-    tag_info  **tip_ptr;   /* ptr to the ptr to the info for a tag */
-    uint16      base_tag = BASETAG(tag); /* corresponding base tag (if the tag is special) */
     uint16      ret_value = DFREF_NONE;
 
     /* clear error stack and check validity of file record id */
@@ -1121,14 +1519,12 @@ Htagnewref(int32 file_id,/* IN: File ID the tag/refs are in */
     if (BADFREC(file_rec))
         HGOTO_ERROR(DFE_ARGS, 0);
   
-    if((tip_ptr = (tag_info **)tbbtdfind(file_rec->tag_tree,(VOIDP)&base_tag,NULL))==NULL)
-        ret_value = 1;  /* The first available ref */
-    else
-      {   /* found an existing tag */
-          tinfo_ptr = *tip_ptr; /* get the pointer to the tag info */
-          if((ret_value = (uint16)bv_find(tinfo_ptr->b,-1,BV_FALSE)) == (uint16)FAIL)
-              HGOTO_ERROR(DFE_BVFIND, 0);
-      } /* end else */
+    /* The refs used for the tag are only known with the whole DD list in memory */
+    if (HTIload_all_dd_blocks(file_rec) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, 0);
+
+    if((ret_value = HTInewref(file_rec,tag)) == 0)
+        HGOTO_ERROR(DFE_BVFIND, 0);
 
 done:
   if(ret_value == 0)   
@@ -1153,6 +1549,9 @@ done:
     start from the beginning of the file if the direction is DF_FORWARD
     and from the and of the file if the direction is DF_BACKWARD.
 
+    The offset of an element past the 2 GB a 32-bit offset can hold, in a
+    file in the large file format, comes back as INVALID_OFFSET.
+
  RETURNS
     returns SUCCEED (0) if successful and FAIL (-1) otherwise
 
@@ -1171,6 +1570,8 @@ intn Hfind(int32 file_id,       /* IN: file ID to search in */
                                 /*  DF_BACKWARD searches backward from the current location */
 )
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "Hfind");	/* for HERROR */
     filerec_t  *file_rec;		/* file record */
     dd_t       *dd_ptr;		   /* ptr to current ddlist searched */
@@ -1201,7 +1602,9 @@ intn Hfind(int32 file_id,       /* IN: file ID to search in */
   
     *find_tag = dd_ptr->tag;
     *find_ref = dd_ptr->ref;
-    *find_offset = dd_ptr->offset;
+    /* offsets past 2 GB, in the large file format, don't fit */
+    *find_offset = (dd_ptr->offset > MAX_OFFSET32 ? INVALID_OFFSET
+                    : (int32)dd_ptr->offset);
     *find_length = dd_ptr->length;
 
 done:
@@ -1233,12 +1636,11 @@ HDcheck_tagref(int32  file_id, /* IN: id of file */
                uint16 tag,     /* IN: Tag to check */
                uint16 ref      /* IN: ref to check */)
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
     CONSTR(FUNC, "HDcheck_tagref");  /* for HERROR */
     filerec_t *file_rec = NULL;  /* file record */
     dd_t      *dd_ptr = NULL;    /* ptr to the DD info for the tag/ref */
-    tag_info **tip_ptr = NULL;   /* ptr to the ptr to the info for a tag */
-    tag_info  *tinfo_ptr = NULL; /* pointer to the info for a tag */
-    uint16     base_tag;         /* corresponding base tag (if the tag is special) */
     intn       ret_value = 1;  /* default tag/ref exists  */
 
     /* clear error stack */
@@ -1251,16 +1653,14 @@ HDcheck_tagref(int32  file_id, /* IN: id of file */
        ||  ref == DFREF_WILDCARD)
         HGOTO_ERROR(DFE_ARGS, -1);
 
-    base_tag = BASETAG(tag);
-        
-    /* Try to find the regular tag in the tag info tree */
-    if((tip_ptr = (tag_info **)tbbtdfind(file_rec->tag_tree,
-                                         (VOIDP)&base_tag,NULL)) == NULL)
-        HGOTO_DONE(0); /* Not an error, we just didn't find the object */
-
-    tinfo_ptr = *tip_ptr; /* get the pointer to the tag info */
-    if((dd_ptr = DAget_elem(tinfo_ptr->d,(intn)ref)) == NULL)
-        HGOTO_DONE(0); /* Not an error, we just didn't find the object */
+    /* Try to find the tag/ref in the tag info tree */
+    switch(HTIlookup_tag_ref(file_rec, tag, ref, &dd_ptr))
+      {
+        case FAIL:
+            HGOTO_ERROR(DFE_INTERNAL, -1);
+        case FALSE:
+            HGOTO_DONE(0); /* Not an error, we just didn't find the object */
+      } /* end switch */
 
     /* found if we reach here*/
     ret_value = 1;
@@ -1303,9 +1703,12 @@ HDreuse_tagref(int32 file_id, /* IN: id of file */
                uint16 tag,    /* IN: tag of data descriptor to reuse */
                uint16 ref     /* IN: ref of data descriptor to reuse */ )
 {
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
   CONSTR(FUNC, "HDreusedd");   /* for HERROR */
   filerec_t  *file_rec = NULL; /* file record */
   atom_t      ddid;            /* ID for the DD */
+  dd_t       *dd_ptr;          /* ptr to the DD info for the tag/ref */
   intn        ret_value = SUCCEED;
 
   /* clear error stack and check validity of file record id */
@@ -1319,25 +1722,492 @@ HDreuse_tagref(int32 file_id, /* IN: id of file */
   if ((ddid = HTPselect(file_rec, tag, ref)) == FAIL)
     HGOTO_ERROR(DFE_NOMATCH, FAIL);
 
-  /* could reuse space in file by calling HPfreediskblock() routine 
-     but it does nothing for now. For later. */
-  /* if (HPfreediskblock(file_rec,dd_ptr->offset,dd_ptr->length) == FAIL)
-      HGOTO_ERROR(DFE_INTERNAL, FAIL); */
+  /* the old data is going away, so its space can be re-used in the file */
+  if ((dd_ptr = HAatom_object(ddid)) == NULL)
+    HGOTO_ERROR(DFE_INTERNAL, FAIL);
+  if (!HTIshared_extent(file_rec, dd_ptr)
+      && HPfreediskblock(file_rec, dd_ptr->offset, dd_ptr->length) == FAIL)
+    HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+  /* nor should a cached copy of it be read back */
+  HCSinvalidate(file_rec, tag, ref);
 
   /* reuse the dd by setting the offset and length to
      INVALID_OFFSET and INVALID_LENGTH*/
   if (HTPupdate(ddid,INVALID_OFFSET, INVALID_LENGTH) == FAIL)
     HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
- /* We leave the ref # as 'used' in the tag tree and
-    dont' delete from dynarray of refs. */
+ /* We leave the ref # as 'used' in the tag tree and
+    dont' delete from dynarray of refs. */
+
+  /* Remove DD from atom group since it should get re-created in Hstartaccess().
+     This could be handled better if Hstartaccess() was revamped
+     to not create new access records for existing tag/ref pairs
+     as well as revamping a few other routines. */
+  if(HAremove_atom(ddid)==NULL)
+      HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+  return ret_value;
+}	/* end HDreuse_tagref */
+
+/*--------------------------------------------------------------------------
+NAME
+   Hdeldd -- delete a data descriptor
+USAGE
+   intn Hdeldd(file_id, tag, ref)
+   int32 file_id;            IN: id of file
+   int16 tag;                IN: tag of data descriptor to delete
+   int16 ref;                IN: ref of data descriptor to delete
+RETURNS
+   returns SUCCEED (0) if successful, FAIL (-1) otherwise
+DESCRIPTION
+   Deletes a data descriptor of tag/ref from the dd list of the file.
+   This routine is unsafe and may leave a file in a condition that is
+   not usable by some routines.  Use with care.
+   For example, if this element is contained in a Vgroup, that group
+   will *NOT* get updated to reflect that this element has been deleted.
+
+--------------------------------------------------------------------------*/
+intn Hdeldd(int32 file_id, uint16 tag, uint16 ref)
+{
+    HTS_API_LOCK;
+    HTS_FILE_LOCK(file_id);
+  CONSTR(FUNC, "Hdeldd");		/* for HERROR */
+  filerec_t  *file_rec;		/* file record */
+  atom_t      ddid;         /* ID for the DD */
+  intn        ret_value = SUCCEED;
+
+  /* clear error stack and check validity of file record id */
+  HEclear();
+  file_rec = HAatom_object(file_id);
+  if (BADFREC(file_rec) || tag == DFTAG_WILDCARD || ref == DFREF_WILDCARD)
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+
+  /* look for the dd to delete */
+  if ((ddid=HTPselect(file_rec, tag, ref)) == FAIL)
+    HGOTO_ERROR(DFE_NOMATCH, FAIL);
+
+  /* delete the dd */
+  if (HTPdelete(ddid) == FAIL)
+    HGOTO_ERROR(DFE_CANTDELDD, FAIL);
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+  return ret_value;
+}	/* end Hdeldd */
+
+#ifdef DEBUGGING
+/*--------------------------------------------------------------------------
+ NAME
+    HTPdump_dds -- Dump out the dd information for a file
+ USAGE
+    intn HTPdump_dds(file_id)
+        int32 file_id;              IN: file ID of HDF file to dump
+        FILE *fout;                 IN: file stream to output to
+ RETURNS
+    returns SUCCEED (0) if successful and FAIL (-1) if failed.
+ DESCRIPTION
+    Prints out all the information (that you could _ever_ want to know) about
+    the dd blocks and dd list for a file.
+
+--------------------------------------------------------------------------*/
+intn HTPdump_dds(int32 file_id, FILE *fout)
+{
+  CONSTR(FUNC, "HTPdump_dds");
+  filerec_t  *file_rec;		/* file record */
+  int         ret_value = SUCCEED;
+
+  /* clear error stack and check validity of file record id */
+  HEclear();
+  file_rec = HAatom_object(file_id);
+  if (BADFREC(file_rec))
+    HGOTO_ERROR(DFE_ARGS, FAIL);
+
+/* Print out each DD block */
+    {
+        ddblock_t   *block=file_rec->ddhead;    /* dd block currently dumping */
+        intn blk_count=0;       /* Count of the number of blocks we've dumped */
+        intn i;                 /* local counting variable */
+
+        while(block!=NULL)
+          {
+            dd_t *curr_dd;      /* current dd to dump */
+
+            fprintf(fout,"DD block %d\n",blk_count);
+            fprintf(fout,"# of DDs: %d, next block offset=%ld\n",(int)block->ndds,(long)block->nextoffset);
+            fprintf(fout,"DD block offset: %ld, dirty?=%d\n",(long)block->myoffset,(int)block->dirty);
+            for(i=0, curr_dd=block->ddlist; i<block->ndds; i++,curr_dd++)
+                fprintf(fout,"%5d: tag/ref=(%5u/%5u), offset=%7ld, length=%7ld\n",(int)i,(unsigned)curr_dd->tag,(unsigned)curr_dd->ref,(long)curr_dd->offset,(long)curr_dd->length);
+            blk_count++;
+            block=block->next;
+          } /* end while */
+    } /* End of ddblock dumping code */
+
+/* Dump the tag tree */
+    {
+        VOIDP      *t;
+
+        if (NULL != (t = (VOIDP *) tbbtfirst((TBBT_NODE *) * (file_rec->tag_tree))))
+          {   /* found at least one node in the tree */
+            tag_info *tinfo_ptr;  /* pointer to the info for a tag */
+
+            do
+              { /* dump each node */
+                intn size;      /* # of elements in the array */
+                intn i;         /* local counting variable */
+
+                tinfo_ptr = (tag_info *) * t;   /* get actual pointer to the tag info */
+                fprintf(fout,"Tag: %u\n",tinfo_ptr->tag);
+                
+                /* Dump the ref # dynarray */
+                if((size=DAsize_array(tinfo_ptr->d))!=FAIL)
+                  {
+                    VOIDP elem;
+
+                    fprintf(fout,"dynarray size=%d\n",size);
+                    for(i=0; i<size; i++)
+                      {
+                        elem=DAget_elem(tinfo_ptr->d,i);
+                        if(elem!=NULL)
+                            fprintf(fout,"dynarray[%d]=%p\n",i,elem);
+                      } /* end for */
+                  } /* end if */
+                
+                /* Dump the ref # bit-vector */
+                if((size=bv_size(tinfo_ptr->b))!=FAIL)
+                  {
+                    intn bit;
+
+                    fprintf(fout,"bitvector size=%d\n",size);
+                    fprintf(fout,"bits set:");
+                    for(i=0; i<size; i++)
+                      {
+                        bit=bv_get(tinfo_ptr->b,i);
+                        if(bit!=BV_FALSE)
+                            fprintf(fout,"%5d",i);
+                      } /* end for */
+                    fprintf(fout,"\n");
+                  } /* end if */
+
+                /* Get the next tag node */
+                t = (VOIDP *) tbbtnext((TBBT_NODE *) t);
+              } while(t!=NULL);
+          }
+        else
+            fprintf(fout,"No nodes in tag tree\n");
+    } /* End of tag node dumping */
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+}	/* HTPdump_dds */
+#endif /* DEBUGGING */
+
+
+
+/* Private, static, internal routines.  Do not call from outside this module */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTIread_dd_block -- read a DD block in from the file
+ USAGE
+    intn HTIread_dd_block(file_rec, block)
+        filerec_t  * file_rec;        IN: file record
+        ddblock_t  * block;           IN: DD block to read, with its offset set
+ RETURNS
+    returns SUCCEED (0) if successful and FAIL (-1) if failed.
+ DESCRIPTION
+    Reads the DD block at block->myoffset in the file, decodes its dd's
+    into memory and adds them to the tag tree.  The maximum ref # and the
+    end of the file in the file record are updated from the dd's read.
+
+--------------------------------------------------------------------------*/
+static intn HTIread_dd_block(filerec_t * file_rec, ddblock_t * block)
+{
+    CONSTR(FUNC, "HTIread_dd_block");   /* for HERROR */
+    dd_t       *curr_dd_ptr;    /* pointer to the current DD being read in */
+    uint8       ddhead[NDDS_SZ+OFFSET64_SZ]; /* storage for the DD header */
+    uint8      *tbuf=NULL;      /* temporary buffer */
+    uint8      *p;              /* Temporary buffer pointer. */
+    intn        ndds;           /* number of DDs in a block */
+    intn        i = 0;          /* Temporary integer */
+    intn        ret_value = SUCCEED;
+
+    /* Go to the beginning of the DD block */
+    if (HPseek(file_rec, block->myoffset) == FAIL)
+      HGOTO_ERROR(DFE_SEEKERROR, FAIL);
+    file_rec->iostats.ndd_loads++;
+    HTS_MUTEX_LOCK(lib_iostats_lock);
+    lib_iostats.ndd_loads++;
+    HTS_MUTEX_UNLOCK(lib_iostats_lock);
+
+    /* Read in the start of this dd block.
+       Read data consists of ndds (number of dd's in this block) and
+       offset (offset to the next ddblock). */
+    if (HP_read(file_rec, ddhead, FILE_DDHEAD_SZ(file_rec)) == FAIL)
+      HGOTO_ERROR(DFE_READERROR, FAIL);
+
+    /* Decode the numbers. */
+    p = &ddhead[0];
+    INT16DECODE(p, block->ndds);
+    ndds = (intn)block->ndds;
+    if (ndds <= 0)		/* validity check */
+      HGOTO_ERROR(DFE_CORRUPT, FAIL);
+    OFFSETDECODE(file_rec, p, block->nextoffset);
+
+    /* check if the DD block is the last thing in the file */
+    /* (Unlikely, but possible (I think)) */
+    if (block->myoffset + FILE_DDHEAD_SZ(file_rec) + (ndds * FILE_DD_SZ(file_rec)) > file_rec->f_end_off)
+      file_rec->f_end_off = block->myoffset + FILE_DDHEAD_SZ(file_rec) + (ndds * FILE_DD_SZ(file_rec));
+
+    /* Now that we know how many dd's are in this block,
+       alloc memory for the records. */
+    block->ddlist = (dd_t *) HDmalloc((uint32) ndds * sizeof(dd_t));
+    if (block->ddlist==(dd_t *)NULL)
+      HGOTO_ERROR(DFE_NOSPACE, FAIL);
+
+    /* Allocate memory for the temporary buffer also */
+    tbuf=(uint8 *)HDmalloc((uintn)ndds*FILE_DD_SZ(file_rec));
+    if (tbuf==(uint8 *)NULL)
+      HGOTO_ERROR(DFE_NOSPACE, FAIL);
+
+    /* Read in a chunk of dd's from the file. */
+    if (HP_read(file_rec, tbuf, ndds * FILE_DD_SZ(file_rec)) == FAIL)
+      HGOTO_ERROR(DFE_READERROR, FAIL);
+
+    /* decode the dd's */
+    p = tbuf;
+    curr_dd_ptr=block->ddlist;
+    for (i = 0; i < ndds; i++, curr_dd_ptr++)
+      {
+        hdf_off_t   length;     /* length of the element, as stored */
+
+        DDDECODE(file_rec, p, curr_dd_ptr->tag, curr_dd_ptr->ref,
+            curr_dd_ptr->offset, length);
+        /* element lengths are still 32-bit in memory */
+        if (length < (hdf_off_t)INVALID_LENGTH || length > MAX_OFFSET32)
+          HGOTO_ERROR(DFE_UNSUPPORTED, FAIL);
+        curr_dd_ptr->length = (int32)length;
+        curr_dd_ptr->blk=block;
+
+         /* check if maximum ref # exceeded */
+        if (file_rec->maxref < curr_dd_ptr->ref)
+          file_rec->maxref = curr_dd_ptr->ref;
+
+        /* check if the data element is the last thing in the file */
+        if ((curr_dd_ptr->offset + curr_dd_ptr->length) > file_rec->f_end_off)
+          file_rec->f_end_off = curr_dd_ptr->offset + curr_dd_ptr->length;
+
+        /* Add to the tag info tree */
+        if(curr_dd_ptr->tag!=DFTAG_NULL)
+            if(HTIregister_tag_ref(file_rec,curr_dd_ptr)==FAIL)
+                HGOTO_ERROR(DFE_INTERNAL, FAIL);
+      }
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+      /* take back the dd's already put in the tag tree */
+      for (curr_dd_ptr = block->ddlist; i > 0; i--, curr_dd_ptr++)
+          if(curr_dd_ptr->tag!=DFTAG_NULL)
+              HTIunregister_tag_ref(file_rec,curr_dd_ptr);
+    } /* end if */
+
+  /* Normal function cleanup */
+  if(tbuf!=NULL)
+      HDfree(tbuf);
+
+  return ret_value;
+}	/* HTIread_dd_block */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTIload_dd_block -- read in the next DD block not in memory yet
+ USAGE
+    ddblock_t *HTIload_dd_block(file_rec)
+        filerec_t  * file_rec;        IN: file record
+ RETURNS
+    returns a pointer to the DD block read in, NULL if all the DD blocks
+    are in memory already or on failure.
+ DESCRIPTION
+    When the DD list is read in lazily, the in-memory list of DD blocks
+    ends with the last block read in and that block's 'nextoffset' is the
+    offset of the next block on disk.  This reads that block in and adds
+    it to the end of the list.
+
+--------------------------------------------------------------------------*/
+static ddblock_t *HTIload_dd_block(filerec_t * file_rec)
+{
+    CONSTR(FUNC, "HTIload_dd_block");   /* for HERROR */
+    ddblock_t *ddcurr;          /* ptr to the current last DD block */
+    ddblock_t *ddnew=NULL;      /* ptr to the new DD block */
+    ddblock_t *ret_value=NULL;
+
+    ddcurr=file_rec->ddlast;
+    if (ddcurr->nextoffset == 0)
+        HGOTO_DONE(NULL);   /* Not an error, all the blocks are in */
+
+    ddnew = (ddblock_t *) HDmalloc((uint32) sizeof(ddblock_t));
+    if (ddnew == (ddblock_t *) NULL)
+      HGOTO_ERROR(DFE_NOSPACE, NULL);
+
+    ddnew->prev = ddcurr;
+    ddnew->next = (ddblock_t *) NULL;
+    ddnew->ddlist = (dd_t *) NULL;
+    ddnew->myoffset = ddcurr->nextoffset;
+    ddnew->dirty= FALSE;
+
+    /* Keep the filerec_t pointer around for each ddblock */
+    ddnew->frec=file_rec;
+
+    if (HTIread_dd_block(file_rec, ddnew) == FAIL)
+      HGOTO_ERROR(DFE_INTERNAL, NULL);
+
+    /* extend the linked list */
+    ddcurr->next = ddnew;
+    file_rec->ddlast = ddnew;
+
+    ret_value = ddnew;
+
+done:
+  if(ret_value == NULL)   
+    { /* Error condition cleanup */
+      /* The block is left on disk to be tried again, a half-read block is
+         never put in the list (its dd's are not all registered) */
+      if (ddnew != NULL)
+        {
+          if (ddnew->ddlist != NULL)
+              HDfree(ddnew->ddlist);
+          HDfree(ddnew);
+        } /* end if */
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+}	/* HTIload_dd_block */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTIload_all_dd_blocks -- read in all the DD blocks not in memory yet
+ USAGE
+    intn HTIload_all_dd_blocks(file_rec)
+        filerec_t  * file_rec;        IN: file record
+ RETURNS
+    returns SUCCEED (0) if successful and FAIL (-1) if failed.
+ DESCRIPTION
+    Used before the operations which need the whole DD list, such as
+    counting dd's or adding a DD block to the end of the list.
+
+--------------------------------------------------------------------------*/
+static intn HTIload_all_dd_blocks(filerec_t * file_rec)
+{
+    CONSTR(FUNC, "HTIload_all_dd_blocks");   /* for HERROR */
+    intn        ret_value = SUCCEED;
+
+    while (file_rec->ddlast->nextoffset != 0)
+        if (HTIload_dd_block(file_rec) == NULL)
+          HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+
+  return ret_value;
+}	/* HTIload_all_dd_blocks */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTInext_dd_block -- get the next DD block in the list
+ USAGE
+    ddblock_t *HTInext_dd_block(file_rec, block)
+        filerec_t  * file_rec;        IN: file record
+        ddblock_t  * block;           IN: current DD block
+ RETURNS
+    returns the DD block after 'block', NULL at the end of the list.
+ DESCRIPTION
+    Steps through the DD list for the forward searches, reading in the
+    next DD block if the list in memory ends at 'block'.  A DD block which
+    cannot be read in ends the list, with the error left on the stack.
+
+--------------------------------------------------------------------------*/
+static ddblock_t *HTInext_dd_block(filerec_t * file_rec, ddblock_t * block)
+{
+    if (block->next == NULL && block == file_rec->ddlast)
+        return HTIload_dd_block(file_rec);
+    return block->next;
+}	/* HTInext_dd_block */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTIlookup_tag_ref -- look up a tag/ref in the tag tree
+ USAGE
+    intn HTIlookup_tag_ref(file_rec, tag, ref, pdd)
+        filerec_t  * file_rec;        IN: file record
+        uint16       tag;             IN: tag to look up
+        uint16       ref;             IN: ref to look up
+        dd_t      ** pdd;             OUT: the DD for the tag/ref
+ RETURNS
+    returns TRUE if the tag/ref was found, FALSE if it is not in the file
+    and FAIL (-1) if a DD block could not be read in.
+ DESCRIPTION
+    Looks for the tag/ref in the tag tree, reading in more of the DD list
+    (one DD block at a time) until it is found or there is no more of the
+    DD list left to read.  A DD block which cannot be read in is an error,
+    the tag/ref may be in it.
+
+--------------------------------------------------------------------------*/
+static intn HTIlookup_tag_ref(filerec_t * file_rec, uint16 tag, uint16 ref,
+            dd_t ** pdd)
+{
+    CONSTR(FUNC, "HTIlookup_tag_ref");   /* for HERROR */
+    tag_info **tip_ptr;   /* ptr to the ptr to the info for a tag */
+    dd_t *dd_ptr;         /* ptr to the DD info for the tag/ref */
+    uint16 base_tag=BASETAG(tag);    /* corresponding base tag (if the tag is special) */
+    intn ret_value=FALSE;
 
-  /* Remove DD from atom group since it should get re-created in Hstartaccess().
-     This could be handled better if Hstartaccess() was revamped
-     to not create new access records for existing tag/ref pairs
-     as well as revamping a few other routines. */
-  if(HAremove_atom(ddid)==NULL)
-      HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    for (;;)
+      {
+        /* Try to find the regular tag in the tag info tree */
+        if((tip_ptr=(tag_info **)tbbtdfind(file_rec->tag_tree,(VOIDP)&base_tag,NULL))!=NULL)
+            if((dd_ptr=DAget_elem((*tip_ptr)->d,(intn)ref))!=NULL)
+              {
+                *pdd=dd_ptr;
+                HGOTO_DONE(TRUE);
+              } /* end if */
+
+        /* Not found in the part of the DD list in memory, read more in */
+        if (HTIload_dd_block(file_rec) == NULL)
+          {
+            /* The end of the DD list, unless the next block failed to
+               read in (it is then still to be read) */
+            if (file_rec->ddlast->nextoffset != 0)
+                HGOTO_ERROR(DFE_READERROR, FAIL);
+            HGOTO_DONE(FALSE);
+          } /* end if */
+      } /* end for */
 
 done:
   if(ret_value == FAIL)   
@@ -1346,47 +2216,55 @@ done:
     } /* end if */
 
   /* Normal function cleanup */
+
   return ret_value;
-}	/* end HDreuse_tagref */
+}	/* HTIlookup_tag_ref */
 
 /*--------------------------------------------------------------------------
-NAME
-   Hdeldd -- delete a data descriptor
-USAGE
-   intn Hdeldd(file_id, tag, ref)
-   int32 file_id;            IN: id of file
-   int16 tag;                IN: tag of data descriptor to delete
-   int16 ref;                IN: ref of data descriptor to delete
-RETURNS
-   returns SUCCEED (0) if successful, FAIL (-1) otherwise
-DESCRIPTION
-   Deletes a data descriptor of tag/ref from the dd list of the file.
-   This routine is unsafe and may leave a file in a condition that is
-   not usable by some routines.  Use with care.
-   For example, if this element is contained in a Vgroup, that group
-   will *NOT* get updated to reflect that this element has been deleted.
+ NAME
+    HTIwrite_dd_block -- write a DD block out to the file
+ USAGE
+    intn HTIwrite_dd_block(file_rec, block)
+        filerec_t  * file_rec;        IN: file record
+        ddblock_t  * block;           IN: DD block to write
+ RETURNS
+    returns SUCCEED (0) if successful and FAIL (-1) if failed.
+ DESCRIPTION
+    Writes the header and all the dd's of a DD block at its offset in the
+    file, whether the block is dirty or not.
 
 --------------------------------------------------------------------------*/
-intn Hdeldd(int32 file_id, uint16 tag, uint16 ref)
+static intn HTIwrite_dd_block(filerec_t * file_rec, ddblock_t * block)
 {
-  CONSTR(FUNC, "Hdeldd");		/* for HERROR */
-  filerec_t  *file_rec;		/* file record */
-  atom_t      ddid;         /* ID for the DD */
-  intn        ret_value = SUCCEED;
+    CONSTR(FUNC, "HTIwrite_dd_block");  /* for HERROR */
+    uint8      *tbuf=NULL;  /* temporary buffer */
+    uint8      *p;		/* temp buffer ptr */
+    dd_t       *list;		/* list of dd */
+    intn        ndds;		/* # of DDs in the block */
+    intn        i;		/* temp ints */
+    intn        ret_value = SUCCEED;
 
-  /* clear error stack and check validity of file record id */
-  HEclear();
-  file_rec = HAatom_object(file_id);
-  if (BADFREC(file_rec) || tag == DFTAG_WILDCARD || ref == DFREF_WILDCARD)
-    HGOTO_ERROR(DFE_ARGS, FAIL);
+    ndds = (intn)block->ndds;
 
-  /* look for the dd to delete */
-  if ((ddid=HTPselect(file_rec, tag, ref)) == FAIL)
-    HGOTO_ERROR(DFE_NOMATCH, FAIL);
+    /* the header and the dd's go out in one write */
+    tbuf=(uint8 *)HDmalloc(FILE_DDHEAD_SZ(file_rec) + (uintn)ndds*FILE_DD_SZ(file_rec));
+    if (tbuf==(uint8 *)NULL)
+      HGOTO_ERROR(DFE_NOSPACE, FAIL);
 
-  /* delete the dd */
-  if (HTPdelete(ddid) == FAIL)
-    HGOTO_ERROR(DFE_CANTDELDD, FAIL);
+    /* dd block header */
+    p = tbuf;
+    INT16ENCODE(p, block->ndds);
+    OFFSETENCODE(file_rec, p, block->nextoffset);
+
+    /* dd list */
+    list = &block->ddlist[0];	/* start at the first DD, go from there */
+    for (i = 0; i < ndds; i++, list++)
+        DDENCODE(file_rec, p, list->tag, list->ref, list->offset, list->length);
+
+    if (HPseek(file_rec, block->myoffset) == FAIL)
+      HGOTO_ERROR(DFE_SEEKERROR, FAIL);
+    if (HP_write(file_rec, tbuf, FILE_DDHEAD_SZ(file_rec) + ndds * FILE_DD_SZ(file_rec)) == FAIL)
+      HGOTO_ERROR(DFE_WRITEERROR, FAIL);
 
 done:
   if(ret_value == FAIL)   
@@ -1395,109 +2273,106 @@ done:
     } /* end if */
 
   /* Normal function cleanup */
+  if (tbuf!=(uint8 *)NULL)
+      HDfree(tbuf);
+
   return ret_value;
-}	/* end Hdeldd */
+}	/* HTIwrite_dd_block */
 
-#ifdef DEBUGGING
 /*--------------------------------------------------------------------------
  NAME
-    HTPdump_dds -- Dump out the dd information for a file
+    HTIadd_extent -- insert the data of a dd into the extent tree
  USAGE
-    intn HTPdump_dds(file_id)
-        int32 file_id;              IN: file ID of HDF file to dump
-        FILE *fout;                 IN: file stream to output to
+    intn HTIadd_extent(file_rec, dd_ptr)
+        filerec_t  * file_rec;        IN: file record
+        dd_t       * dd_ptr;          IN: dd to insert
  RETURNS
     returns SUCCEED (0) if successful and FAIL (-1) if failed.
  DESCRIPTION
-    Prints out all the information (that you could _ever_ want to know) about
-    the dd blocks and dd list for a file.
+    Counts the dd in the node of the extent tree for the offset of its
+    data, for HTIshared_extent.  Dd's without data and DFTAG_FREE dd's,
+    which describe no element, are left out.
 
 --------------------------------------------------------------------------*/
-intn HTPdump_dds(int32 file_id, FILE *fout)
+static intn HTIadd_extent(filerec_t * file_rec, dd_t * dd_ptr)
 {
-  CONSTR(FUNC, "HTPdump_dds");
-  filerec_t  *file_rec;		/* file record */
-  int         ret_value = SUCCEED;
-
-  /* clear error stack and check validity of file record id */
-  HEclear();
-  file_rec = HAatom_object(file_id);
-  if (BADFREC(file_rec))
-    HGOTO_ERROR(DFE_ARGS, FAIL);
+    CONSTR(FUNC, "HTIadd_extent");
+    extent_info **eip_ptr;      /* ptr to the ptr to the extent node */
+    extent_info *einfo_ptr;     /* extent node */
+    intn        ret_value = SUCCEED;
 
-/* Print out each DD block */
-    {
-        ddblock_t   *block=file_rec->ddhead;    /* dd block currently dumping */
-        intn blk_count=0;       /* Count of the number of blocks we've dumped */
-        intn i;                 /* local counting variable */
+    if (dd_ptr->tag == DFTAG_NULL || dd_ptr->tag == DFTAG_FREE
+        || dd_ptr->offset == INVALID_OFFSET || dd_ptr->length <= 0)
+        HGOTO_DONE(SUCCEED);
 
-        while(block!=NULL)
+    if ((eip_ptr = (extent_info **) tbbtdfind(file_rec->extent_tree,
+                                              (VOIDP) &dd_ptr->offset, NULL)) != NULL)
+      {
+        einfo_ptr = *eip_ptr;
+        einfo_ptr->count++;
+        if (einfo_ptr->length < dd_ptr->length)
+            einfo_ptr->length = dd_ptr->length;
+      } /* end if */
+    else
+      {
+        if ((einfo_ptr = (extent_info *) HDmalloc(sizeof(extent_info))) == NULL)
+            HGOTO_ERROR(DFE_NOSPACE, FAIL);
+        einfo_ptr->offset = dd_ptr->offset;
+        einfo_ptr->length = dd_ptr->length;
+        einfo_ptr->count = 1;
+        if (tbbtdins(file_rec->extent_tree, (VOIDP) einfo_ptr, NULL) == NULL)
           {
-            dd_t *curr_dd;      /* current dd to dump */
+            HDfree(einfo_ptr);
+            HGOTO_ERROR(DFE_TBBTINS, FAIL);
+          } /* end if */
+      } /* end else */
 
-            fprintf(fout,"DD block %d\n",blk_count);
-            fprintf(fout,"# of DDs: %d, next block offset=%ld\n",(int)block->ndds,(long)block->nextoffset);
-            fprintf(fout,"DD block offset: %ld, dirty?=%d\n",(long)block->myoffset,(int)block->dirty);
-            for(i=0, curr_dd=block->ddlist; i<block->ndds; i++,curr_dd++)
-                fprintf(fout,"%5d: tag/ref=(%5u/%5u), offset=%7ld, length=%7ld\n",(int)i,(unsigned)curr_dd->tag,(unsigned)curr_dd->ref,(long)curr_dd->offset,(long)curr_dd->length);
-            blk_count++;
-            block=block->next;
-          } /* end while */
-    } /* End of ddblock dumping code */
+done:
+  if(ret_value == FAIL)   
+    { /* Error condition cleanup */
 
-/* Dump the tag tree */
-    {
-        VOIDP      *t;
+    } /* end if */
 
-        if (NULL != (t = (VOIDP *) tbbtfirst((TBBT_NODE *) * (file_rec->tag_tree))))
-          {   /* found at least one node in the tree */
-            tag_info *tinfo_ptr;  /* pointer to the info for a tag */
+  /* Normal function cleanup */
 
-            do
-              { /* dump each node */
-                intn size;      /* # of elements in the array */
-                intn i;         /* local counting variable */
+  return ret_value;
+}   /* HTIadd_extent */
 
-                tinfo_ptr = (tag_info *) * t;   /* get actual pointer to the tag info */
-                fprintf(fout,"Tag: %u\n",tinfo_ptr->tag);
-                
-                /* Dump the ref # dynarray */
-                if((size=DAsize_array(tinfo_ptr->d))!=FAIL)
-                  {
-                    VOIDP elem;
+/*--------------------------------------------------------------------------
+ NAME
+    HTIremove_extent -- remove the data of a dd from the extent tree
+ USAGE
+    intn HTIremove_extent(file_rec, dd_ptr)
+        filerec_t  * file_rec;        IN: file record
+        dd_t       * dd_ptr;          IN: dd to remove
+ RETURNS
+    returns SUCCEED (0) if successful and FAIL (-1) if failed.
+ DESCRIPTION
+    Takes back what HTIadd_extent did for the dd.  The node of the offset
+    goes away with its last dd; until then it keeps the longest length
+    it had, which errs on the side of keeping space.
 
-                    fprintf(fout,"dynarray size=%d\n",size);
-                    for(i=0; i<size; i++)
-                      {
-                        elem=DAget_elem(tinfo_ptr->d,i);
-                        if(elem!=NULL)
-                            fprintf(fout,"dynarray[%d]=%p\n",i,elem);
-                      } /* end for */
-                  } /* end if */
-                
-                /* Dump the ref # bit-vector */
-                if((size=bv_size(tinfo_ptr->b))!=FAIL)
-                  {
-                    intn bit;
+--------------------------------------------------------------------------*/
+static intn HTIremove_extent(filerec_t * file_rec, dd_t * dd_ptr)
+{
+    CONSTR(FUNC, "HTIremove_extent");
+    TBBT_NODE  *node;           /* node of the extent */
+    extent_info *einfo_ptr;     /* extent node */
+    intn        ret_value = SUCCEED;
 
-                    fprintf(fout,"bitvector size=%d\n",size);
-                    fprintf(fout,"bits set:");
-                    for(i=0; i<size; i++)
-                      {
-                        bit=bv_get(tinfo_ptr->b,i);
-                        if(bit!=BV_FALSE)
-                            fprintf(fout,"%5d",i);
-                      } /* end for */
-                    fprintf(fout,"\n");
-                  } /* end if */
+    if (dd_ptr->tag == DFTAG_NULL || dd_ptr->tag == DFTAG_FREE
+        || dd_ptr->offset == INVALID_OFFSET || dd_ptr->length <= 0)
+        HGOTO_DONE(SUCCEED);
 
-                /* Get the next tag node */
-                t = (VOIDP *) tbbtnext((TBBT_NODE *) t);
-              } while(t!=NULL);
-          }
-        else
-            fprintf(fout,"No nodes in tag tree\n");
-    } /* End of tag node dumping */
+    if ((node = tbbtdfind(file_rec->extent_tree, (VOIDP) &dd_ptr->offset, NULL)) == NULL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    einfo_ptr = (extent_info *) node->data;
+    if (--einfo_ptr->count == 0)
+      {
+        tbbtrem((TBBT_NODE **) file_rec->extent_tree, node, NULL);
+        HDfree(einfo_ptr);
+      } /* end if */
 
 done:
   if(ret_value == FAIL)   
@@ -1508,12 +2383,92 @@ done:
   /* Normal function cleanup */
 
   return ret_value;
-}	/* HTPdump_dds */
-#endif /* DEBUGGING */
+}   /* HTIremove_extent */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTIshared_extent -- check whether another dd uses the space of a dd
+ USAGE
+    intn HTIshared_extent(file_rec, dd_ptr)
+        filerec_t  * file_rec;        IN: file record
+        dd_t       * dd_ptr;          IN: dd whose space is checked
+ RETURNS
+    returns TRUE if another dd in the file points into the same space as
+    dd_ptr, FALSE otherwise.
+ DESCRIPTION
+    Elements copied with Hdupdd (i.e. the first block of a linked-block
+    element) share their data with the original, so the space can only be
+    given back when the last dd pointing to it goes away.
+
+    The dd's are looked up in the extent tree by the offset of their data:
+    another dd with its data at the same offset, or at the offsets next to
+    it reaching into the space, shares it.  The dd itself must be in the
+    tree.
 
+--------------------------------------------------------------------------*/
+static intn HTIshared_extent(filerec_t * file_rec, dd_t * dd_ptr)
+{
+    TBBT_NODE  *node;           /* node of the extent */
+    TBBT_NODE  *next;           /* node of the extent before or after it */
+    extent_info *einfo_ptr;     /* extent node */
 
+    if (dd_ptr->tag == DFTAG_FREE
+        || dd_ptr->offset == INVALID_OFFSET || dd_ptr->length <= 0)
+        return (FALSE);
 
-/* Private, static, internal routines.  Do not call from outside this module */
+    if ((node = tbbtdfind(file_rec->extent_tree, (VOIDP) &dd_ptr->offset, NULL)) == NULL)
+        return (FALSE);
+    if (((extent_info *) node->data)->count > 1)
+        return (TRUE);
+
+    if ((next = tbbtprev(node)) != NULL)
+      {
+        einfo_ptr = (extent_info *) next->data;
+        if (einfo_ptr->offset + einfo_ptr->length > dd_ptr->offset)
+            return (TRUE);
+      } /* end if */
+    if ((next = tbbtnext(node)) != NULL)
+      {
+        einfo_ptr = (extent_info *) next->data;
+        if (einfo_ptr->offset < dd_ptr->offset + dd_ptr->length)
+            return (TRUE);
+      } /* end if */
+
+    return (FALSE);
+}   /* HTIshared_extent */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTInewref -- get an unused ref for a tag
+ USAGE
+    uint16 HTInewref(file_rec, tag)
+        filerec_t  * file_rec;        IN: file record
+        uint16       tag;             IN: tag to get a ref for
+ RETURNS
+    returns the ref, 0 if all the refs for the tag are in use.
+ DESCRIPTION
+    Looks in the tag tree for the lowest ref not used for the tag yet.
+    The whole DD list must be in memory.
+
+--------------------------------------------------------------------------*/
+static uint16 HTInewref(filerec_t * file_rec, uint16 tag)
+{
+    tag_info   *tinfo_ptr; /* pointer to the info for a tag */
+    tag_info  **tip_ptr;   /* ptr to the ptr to the info for a tag */
+    uint16      base_tag = BASETAG(tag); /* corresponding base tag (if the tag is special) */
+    uint16      ret_value;
+
+    if((tip_ptr = (tag_info **)tbbtdfind(file_rec->tag_tree,(VOIDP)&base_tag,NULL))==NULL)
+        ret_value = 1;  /* The first available ref */
+    else
+      {   /* found an existing tag */
+          tinfo_ptr = *tip_ptr; /* get the pointer to the tag info */
+          if((ret_value = (uint16)bv_find(tinfo_ptr->b,-1,BV_FALSE)) == (uint16)FAIL)
+              ret_value = 0;
+      } /* end else */
+
+    return (ret_value);
+}   /* HTInewref */
 
 /*--------------------------------------------------------------------------
  NAME
@@ -1532,9 +2487,9 @@ done:
 static intn HTInew_dd_block(filerec_t * file_rec)
 {
     CONSTR(FUNC, "HTInew_dd_block");    /* for HERROR */
-    int32       nextoffset;		/* offset of new ddblock */
-    uint8       ddhead[NDDS_SZ+OFFSET_SZ];   /* storage for the DD header */
-    int32       offset;			/* offset to the offset of new ddblock */
+    hdf_off_t   nextoffset;		/* offset of new ddblock */
+    uint8       ddhead[NDDS_SZ+OFFSET64_SZ]; /* storage for the DD header */
+    hdf_off_t   offset;			/* offset to the offset of new ddblock */
     ddblock_t *block;           /* Block the DD is located in */
     dd_t       *list;			/* dd list array of new dd block */
     uint8      *p;              /* Temporary buffer pointer. */
@@ -1546,6 +2501,11 @@ static intn HTInew_dd_block(filerec_t * file_rec)
     if (file_rec->ddhead==NULL || file_rec->ddlast==NULL)
       HGOTO_ERROR(DFE_INTERNAL, FAIL);
   
+    /* The new block goes after the last block in the file, not just the
+       last one read in so far */
+    if (HTIload_all_dd_blocks(file_rec) == FAIL)
+      HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
     /* allocate new dd block record and fill in data */
     if ((block = (ddblock_t *) HDmalloc(sizeof(ddblock_t))) == NULL)
       HGOTO_ERROR(DFE_NOSPACE, FAIL);
@@ -1557,7 +2517,7 @@ static intn HTInew_dd_block(filerec_t * file_rec)
     block->frec=file_rec;
   
     /* get room for the new DD block in the file */
-    if ((nextoffset = HPgetdiskblock(file_rec, NDDS_SZ + OFFSET_SZ + (ndds * DD_SZ), TRUE)) == FAIL)
+    if ((nextoffset = HPgetdiskblock(file_rec, FILE_DDHEAD_SZ(file_rec) + (ndds * FILE_DD_SZ(file_rec)), TRUE)) == FAIL)
       HGOTO_ERROR(DFE_SEEKERROR, FAIL);
     block->myoffset = nextoffset;	/* set offset of new block */
     block->dirty = (uintn)file_rec->cache; /* if we're caching, wait to write DD block */
@@ -1568,8 +2528,8 @@ static intn HTInew_dd_block(filerec_t * file_rec)
       {
         p = ddhead;
         INT16ENCODE(p, block->ndds);
-        INT32ENCODE(p, (int32) 0);
-        if (HP_write(file_rec, ddhead, NDDS_SZ + OFFSET_SZ) == FAIL)
+        OFFSETENCODE(file_rec, p, (int32) 0);
+        if (HP_write(file_rec, ddhead, FILE_DDHEAD_SZ(file_rec)) == FAIL)
           HGOTO_ERROR(DFE_WRITEERROR, FAIL);
       }		/* end else */
   
@@ -1591,16 +2551,16 @@ static intn HTInew_dd_block(filerec_t * file_rec)
       {	/* if we are caching, wait to update previous DD block */
         uint8 *tbuf;    /* temporary buffer */
 
-        tbuf=(uint8 *)HDmalloc(ndds*DD_SZ);
+        tbuf=(uint8 *)HDmalloc(ndds*FILE_DD_SZ(file_rec));
         if(tbuf==(uint8 *)NULL)
             HGOTO_ERROR(DFE_NOSPACE, FAIL);
 
         p = tbuf;
-	DDENCODE(p, (uint16) DFTAG_NULL, (uint16) DFREF_NONE,
+	DDENCODE(file_rec, p, (uint16) DFTAG_NULL, (uint16) DFREF_NONE,
 	    (int32) INVALID_LENGTH, (int32) INVALID_OFFSET);
-        HDmemfill(p,tbuf,DD_SZ,(uint32)(ndds-1));
+        HDmemfill(p,tbuf,FILE_DD_SZ(file_rec),(uint32)(ndds-1));
 
-        if (HP_write(file_rec, tbuf, ndds * DD_SZ) == FAIL)
+        if (HP_write(file_rec, tbuf, ndds * FILE_DD_SZ(file_rec)) == FAIL)
           HGOTO_ERROR(DFE_WRITEERROR, FAIL);
 
         HDfree(tbuf);
@@ -1622,18 +2582,19 @@ static intn HTInew_dd_block(filerec_t * file_rec)
         else
           offset = file_rec->ddlast->prev->nextoffset + NDDS_SZ;
         p = ddhead;
-        INT32ENCODE(p, nextoffset);
+        OFFSETENCODE(file_rec, p, nextoffset);
         if (HPseek(file_rec, offset) == FAIL)
           HGOTO_ERROR(DFE_SEEKERROR, FAIL);
-        if (HP_write(file_rec, ddhead, OFFSET_SZ) == FAIL)
+        if (HP_write(file_rec, ddhead, FILE_OFFSET_SZ(file_rec)) == FAIL)
           HGOTO_ERROR(DFE_WRITEERROR, FAIL);
       }	/* end else */
   
     /* update file record */
     file_rec->ddlast = block;
   
-    /* set the end of the file to the end of the current DD block */
-    file_rec->f_end_off = block->myoffset + (NDDS_SZ + OFFSET_SZ) + (block->ndds * DD_SZ);
+    /* the DD block may have been placed in free space inside the file */
+    if (block->myoffset + FILE_DDHEAD_SZ(file_rec) + (block->ndds * FILE_DD_SZ(file_rec)) > file_rec->f_end_off)
+        file_rec->f_end_off = block->myoffset + FILE_DDHEAD_SZ(file_rec) + (block->ndds * FILE_DD_SZ(file_rec));
 
 done:
   if(ret_value == FAIL)   
@@ -1667,9 +2628,7 @@ done:
 static intn HTIfind_dd(filerec_t * file_rec, uint16 look_tag, uint16 look_ref,
             dd_t ** pdd, intn direction)
 {
-#ifdef LATER
     CONSTR(FUNC, "HTIfind_dd");    /* for HERROR */
-#endif /* LATER */
     intn idx;          /* index into ddlist of current dd searched */
     ddblock_t *block;  /* ptr to current ddblock searched */
     dd_t *list;        /* ptr to current ddlist searched */
@@ -1682,18 +2641,16 @@ static intn HTIfind_dd(filerec_t * file_rec, uint16 look_tag, uint16 look_ref,
 
     if(look_tag!=DFTAG_WILDCARD && look_ref!=DFTAG_WILDCARD)
       { /* easy to optimize case, looking for a specific tag/ref pair */
-          tag_info **tip_ptr;   /* ptr to the ptr to the info for a tag */
-          tag_info *tinfo_ptr;  /* pointer to the info for a tag */
           dd_t *dd_ptr;         /* ptr to the DD info for a tag/ref */
-          uint16 base_tag=BASETAG(look_tag);    /* corresponding base tag (if the tag is special) */
-
-          /* Try to find the regular tag in the tag info tree */
-          if((tip_ptr=(tag_info **)tbbtdfind(file_rec->tag_tree,(VOIDP)&base_tag,NULL))==NULL)
-              HGOTO_DONE(FAIL); /* Not an error, we just didn't find the object */
 
-          tinfo_ptr=*tip_ptr; /* get the pointer to the tag info */
-          if((dd_ptr=DAget_elem(tinfo_ptr->d,(intn)look_ref))==NULL)
-              HGOTO_DONE(FAIL); /* Not an error, we just didn't find the object */
+          /* Try to find the tag/ref in the tag info tree */
+          switch(HTIlookup_tag_ref(file_rec,look_tag,look_ref,&dd_ptr))
+            {
+              case FAIL:
+                  HGOTO_ERROR(DFE_INTERNAL, FAIL);
+              case FALSE:
+                  HGOTO_DONE(FAIL); /* Not an error, we just didn't find the object */
+            } /* end switch */
 
           *pdd=dd_ptr;
           HGOTO_DONE(SUCCEED);
@@ -1714,7 +2671,7 @@ static intn HTIfind_dd(filerec_t * file_rec, uint16 look_tag, uint16 look_ref,
               } /* end else */
             if(look_tag==DFTAG_WILDCARD && look_ref==DFREF_WILDCARD)
               { /* Both tag & ref are wildcards */
-                for (; block; block = block->next)
+                for (; block; block = HTInext_dd_block(file_rec, block))
                   {
                     list = &block->ddlist[idx];
                     for (; idx < block->ndds; idx++, list++)
@@ -1743,7 +2700,7 @@ static intn HTIfind_dd(filerec_t * file_rec, uint16 look_tag, uint16 look_ref,
                 else
                     idx=file_rec->ddnull_idx+1;
 
-                for (; block; block = block->next)
+                for (; block; block = HTInext_dd_block(file_rec, block))
                   {
                     list = &block->ddlist[idx];
                     for (; idx < block->ndds; idx++, list++)
@@ -1768,7 +2725,7 @@ static intn HTIfind_dd(filerec_t * file_rec, uint16 look_tag, uint16 look_ref,
               } /* end if */
             else if(look_tag==DFTAG_WILDCARD)
               { /* tag is wildcard */
-                for (; block; block = block->next)
+                for (; block; block = HTInext_dd_block(file_rec, block))
                   {
                     list = &block->ddlist[idx];
                     for (; idx < block->ndds; idx++, list++)
@@ -1795,7 +2752,7 @@ static intn HTIfind_dd(filerec_t * file_rec, uint16 look_tag, uint16 look_ref,
                 if(special_tag==DFTAG_NULL)
                   {
 /* Change this to lookup the next used ref # in the bitvector or dynarray -QAK */
-                    for (; block; block = block->next)
+                    for (; block; block = HTInext_dd_block(file_rec, block))
                       {
                         list = &block->ddlist[idx];
                         for (; idx < block->ndds; idx++, list++)
@@ -1818,7 +2775,7 @@ static intn HTIfind_dd(filerec_t * file_rec, uint16 look_tag, uint16 look_ref,
                   } /* end if */
                 else
                   {
-                    for (; block; block = block->next)
+                    for (; block; block = HTInext_dd_block(file_rec, block))
                       {
                         list = &block->ddlist[idx];
                         for (; idx < block->ndds; idx++, list++)
@@ -1869,7 +2826,7 @@ static intn HTIfind_dd(filerec_t * file_rec, uint16 look_tag, uint16 look_ref,
               } /* end if */
             else
               { /* Both tag & ref are not wildcards */
-                for (; block; block = block->next)
+                for (; block; block = HTInext_dd_block(file_rec, block))
                   {
                     list = &block->ddlist[idx];
                     for (; idx < block->ndds; idx++, list++)
@@ -1897,6 +2854,9 @@ static intn HTIfind_dd(filerec_t * file_rec, uint16 look_tag, uint16 look_ref,
           {	  /* search backward through the DD list */
             if(*pdd==NULL)
               {
+                /* searching from the end needs the whole DD list */
+                if (HTIload_all_dd_blocks(file_rec) == FAIL)
+                    HGOTO_DONE(FAIL);
                 block=file_rec->ddlast;
                 idx=block->ndds-1;
               } /* end if */
@@ -1977,20 +2937,20 @@ static intn HTIupdate_dd(filerec_t * file_rec, dd_t * dd_ptr)
       } /* end if */
     else
       {
-        int32       offset;         /* offset of updated dd in file */
-        uint8       tbuf[DD_SZ];    /* storage for the DD */
+        hdf_off_t   offset;         /* offset of updated dd in file */
+        uint8       tbuf[DD64_SZ];  /* storage for the DD */
         uint8      *p;              /* temp buffer ptr */
 
         /* look for offset of updated dd block in the file */
-        offset = block->myoffset + (NDDS_SZ + OFFSET_SZ) + (idx * DD_SZ);
+        offset = block->myoffset + FILE_DDHEAD_SZ(file_rec) + (idx * FILE_DD_SZ(file_rec));
 
         /* write in the updated dd */
         if (HPseek(file_rec, offset) == FAIL)
           HGOTO_ERROR(DFE_SEEKERROR, FAIL);
   
         p = tbuf;
-	DDENCODE(p, dd_ptr->tag, dd_ptr->ref, dd_ptr->offset, dd_ptr->length);
-        if (HP_write(file_rec, tbuf, DD_SZ) == FAIL)
+	DDENCODE(file_rec, p, dd_ptr->tag, dd_ptr->ref, dd_ptr->offset, dd_ptr->length);
+        if (HP_write(file_rec, tbuf, FILE_DD_SZ(file_rec)) == FAIL)
           HGOTO_ERROR(DFE_WRITEERROR, FAIL);
       } /* end else */
   
@@ -2053,6 +3013,10 @@ static intn HTIcount_dd(filerec_t * file_rec, uint16 cnt_tag, uint16 cnt_ref,
     uint16      special_tag;    /* corresponding special tag */
 
     HEclear();
+    /* Counting needs the whole DD list */
+    if (HTIload_all_dd_blocks(file_rec) == FAIL)
+        return (FAIL);
+
     /* search for special version also */
     special_tag = MKSPECIALTAG(cnt_tag);
 
@@ -2220,12 +3184,15 @@ HTIregister_tag_ref(filerec_t * file_rec, dd_t *dd_ptr)
   if(DAset_elem(tinfo_ptr->d,(intn)dd_ptr->ref,(VOIDP)dd_ptr)==FAIL)
       HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
+  /* Note where its data is */
+  if(HTIadd_extent(file_rec,dd_ptr)==FAIL)
+      HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
 done:
   if(ret_value == FAIL)   
     { /* Error condition cleanup */
-
-      if(tinfo_ptr->d!=NULL)
-          DAdestroy_array(tinfo_ptr->d,0);
+      /* The tag info stays in the tag tree (it may be holding other refs),
+         it is released along with the tree */
     } /* end if */
 
   /* Normal function cleanup */
@@ -2276,6 +3243,10 @@ static intn HTIunregister_tag_ref(filerec_t * file_rec, dd_t *dd_ptr)
         if(DAdel_elem(tinfo_ptr->d,(intn)dd_ptr->ref)==NULL)
             HGOTO_ERROR(DFE_INTERNAL, FAIL);
 
+        /* and its data from the extent tree */
+        if(HTIremove_extent(file_rec,dd_ptr)==FAIL)
+            HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
         /* Delete the tag/ref from the file */
         dd_ptr->tag=DFTAG_NULL;
     } /* end else */
@@ -2309,6 +3280,36 @@ tagcompare(VOIDP k1, VOIDP k2, intn cmparg)
   return ret_value;
 }   /* tagcompare */
 
+/* ---------------------------- extentcompare ------------------------- */
+/*
+   Compares two extent B-tree keys, the offsets of the data of dd's.
+
+   *** Only called by B-tree routines, should _not_ be called externally ***
+ */
+intn
+extentcompare(VOIDP k1, VOIDP k2, intn cmparg)
+{
+  hdf_off_t off1 = *(hdf_off_t *) k1;
+  hdf_off_t off2 = *(hdf_off_t *) k2;
+
+  /* shut compiler up */
+  cmparg = cmparg;
+
+  return (off1 < off2) ? -1 : (off1 > off2) ? 1 : 0;
+}   /* extentcompare */
+
+/* ---------------------------- extentdestroynode ------------------------- */
+/*
+   Frees extent B-Tree nodes
+
+   *** Only called by B-tree routines, should _not_ be called externally ***
+ */
+VOID
+extentdestroynode(VOIDP n)
+{
+    HDfree(n);
+}   /* extentdestroynode */
+
 /* ---------------------------- tagdestroynode ------------------------- */
 /*
    Frees tag B-Tree nodes
@@ -0,0 +1,1051 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Board of Trustees of the University of Illinois.         *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of HDF.  The full HDF copyright notice, including       *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the root of the source code       *
+ * distribution tree, or in https://support.hdfgroup.org/ftp/HDF/releases/.  *
+ * If you do not have access to either file, you may request a copy from     *
+ * help@hdfgroup.org.                                                        *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* $Id$ */
+
+/*
+FILE
+    hfiledrv.c - File drivers for HDF files.
+
+REMARKS
+    These routines do the low-level I/O for files opened through Hopen().
+    Each driver is a table of functions (hdf_fdriver_t) which the HP
+    routines in hfile.c call through the driver pointer in the file record.
+    The driver used for a file is chosen when the file is opened, see
+    Hsetdriver().
+
+DESIGN
+    All reads and writes carry an explicit offset, the logical position in
+    a file is kept in the file record (f_cur_off) and a driver never has to
+    seek on behalf of its caller.  The drivers are:
+
+    HDF_DRIVER_POSIX - POSIX file descriptors, using pread()/pwrite() where
+                       available so that no seek is issued at all.
+    HDF_DRIVER_STDIO - C buffered streams, seeking only when the stream is
+                       not already positioned at the requested offset.
+    HDF_DRIVER_CORE  - the whole file image is kept in memory, an existing
+                       file is read in when opened and the image is written
+                       out once, with a single write, when the file is
+                       closed.  Nothing reaches the disk before that.
+
+    Where the system has mmap(), the POSIX and stdio drivers can also map
+    a file into memory for Hmmap().  Where it has posix_fadvise(), they
+    can ask the system to read ahead for Hreadahead().
+
+MODIFICATION HISTORY
+*/
+
+#include "hdf.h"
+#include "hfile.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef H4_HAVE_UNISTD_H
+#include <unistd.h>
+#endif /* H4_HAVE_UNISTD_H */
+#ifdef H4_HAVE_MMAP_IO
+#include <sys/mman.h>
+#endif /* H4_HAVE_MMAP_IO */
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif /* O_BINARY */
+
+/* Local definitions */
+/* The minimum # of bytes a core file image grows by */
+#define CORE_INCREMENT  (64*1024)
+
+/* Handle of a file opened with the POSIX driver */
+typedef struct posix_file_t
+  {
+      int         fd;           /* the file descriptor */
+  }
+posix_file_t;
+
+/* Handle of a file opened with the stdio driver */
+typedef struct stdio_file_t
+  {
+      FILE       *fp;           /* the file stream */
+      hdf_off_t   pos;          /* position of the stream */
+      fileop_t    last_op;      /* the last operation performed on the stream */
+  }
+stdio_file_t;
+
+/* Handle of a file opened with the core driver */
+typedef struct core_file_t
+  {
+      char       *path;         /* name of the file backing the image */
+      uint8      *image;        /* the file image */
+      int32       eof;          /* # of bytes of the image in use */
+      int32       alloc;        /* # of bytes allocated for the image */
+      intn        writable;     /* whether the image may be modified */
+      intn        dirty;        /* whether the image must be written out */
+  }
+core_file_t;
+
+/* Private routines */
+static void *HIposix_open(const char *path, intn acc_mode);
+static void *HIposix_create(const char *path);
+static intn HIposix_read(void *file, void *buf, int32 bytes, hdf_off_t offset);
+static intn HIposix_write(void *file, const void *buf, int32 bytes, hdf_off_t offset);
+static intn HIposix_flush(void *file);
+static intn HIposix_close(void *file);
+static hdf_off_t HIposix_size(void *file);
+
+static void *HIstdio_open(const char *path, intn acc_mode);
+static void *HIstdio_create(const char *path);
+static intn HIstdio_read(void *file, void *buf, int32 bytes, hdf_off_t offset);
+static intn HIstdio_write(void *file, const void *buf, int32 bytes, hdf_off_t offset);
+static intn HIstdio_flush(void *file);
+static intn HIstdio_close(void *file);
+static hdf_off_t HIstdio_size(void *file);
+
+static void *HIcore_open(const char *path, intn acc_mode);
+static void *HIcore_create(const char *path);
+static intn HIcore_read(void *file, void *buf, int32 bytes, hdf_off_t offset);
+static intn HIcore_write(void *file, const void *buf, int32 bytes, hdf_off_t offset);
+static intn HIcore_flush(void *file);
+static intn HIcore_close(void *file);
+static hdf_off_t HIcore_size(void *file);
+
+#ifdef H4_HAVE_MMAP_IO
+static intn HIposix_map(void *file, uint8 **base, int32 *len);
+static intn HIstdio_map(void *file, uint8 **base, int32 *len);
+static intn HIfd_map(int fd, uint8 **base, int32 *len);
+static intn HIfd_unmap(void *file, uint8 *base, int32 len);
+#else /* H4_HAVE_MMAP_IO */
+#define HIposix_map NULL
+#define HIstdio_map NULL
+#define HIfd_unmap  NULL
+#endif /* H4_HAVE_MMAP_IO */
+
+#ifdef H4_HAVE_READAHEAD
+static intn HIposix_prefetch(void *file, hdf_off_t offset, int32 len);
+static intn HIstdio_prefetch(void *file, hdf_off_t offset, int32 len);
+static intn HIfd_prefetch(int fd, hdf_off_t offset, int32 len);
+#else /* H4_HAVE_READAHEAD */
+#define HIposix_prefetch NULL
+#define HIstdio_prefetch NULL
+#endif /* H4_HAVE_READAHEAD */
+
+/* The file driver tables */
+static const hdf_fdriver_t posix_driver =
+{
+    HDF_DRIVER_POSIX, "posix",
+    HIposix_open, HIposix_create, HIposix_read, HIposix_write,
+    HIposix_flush, HIposix_close, HIposix_size,
+    HIposix_map, HIfd_unmap, HIposix_prefetch
+};
+
+static const hdf_fdriver_t stdio_driver =
+{
+    HDF_DRIVER_STDIO, "stdio",
+    HIstdio_open, HIstdio_create, HIstdio_read, HIstdio_write,
+    HIstdio_flush, HIstdio_close, HIstdio_size,
+    HIstdio_map, HIfd_unmap, HIstdio_prefetch
+};
+
+static const hdf_fdriver_t core_driver =
+{
+    HDF_DRIVER_CORE, "core",
+    HIcore_open, HIcore_create, HIcore_read, HIcore_write,
+    HIcore_flush, HIcore_close, HIcore_size,
+    NULL, NULL, NULL
+};
+
+/* #define HFILE_SEEKINFO */
+#ifdef HFILE_SEEKINFO
+static uint32 seek_taken=0;
+static uint32 seek_avoided=0;
+static uint32 write_force_seek=0;
+static uint32 read_force_seek=0;
+
+void
+Hdumpseek(void)
+{
+    printf("Seeks taken=%lu\n",(unsigned long)seek_taken);
+    printf("Seeks avoided=%lu\n",(unsigned long)seek_avoided);
+    printf("# of times write forced a seek=%lu\n",(unsigned long)write_force_seek);
+    printf("# of times read forced a seek=%lu\n",(unsigned long)read_force_seek);
+} /* Hdumpseek() */
+#endif /* HFILE_SEEKINFO */
+
+/******************************************************************************
+ NAME
+     HPget_driver - Look up a file driver
+
+ DESCRIPTION
+    Returns the driver table for one of the HDF_DRIVER_* numbers.
+    HDF_DRIVER_DEFAULT is the POSIX driver when the system has positional
+    I/O, and the stdio driver otherwise.
+
+ RETURNS
+    Returns a pointer to the driver table if successful and NULL otherwise
+
+*******************************************************************************/
+const hdf_fdriver_t *
+HPget_driver(intn driver_id)
+{
+    CONSTR(FUNC, "HPget_driver");       /* for HERROR */
+    const hdf_fdriver_t *ret_value = NULL;
+
+    switch (driver_id)
+      {
+      case HDF_DRIVER_DEFAULT:
+#ifdef H4_HAVE_POSITIONAL_IO
+          ret_value = &posix_driver;
+#else /* H4_HAVE_POSITIONAL_IO */
+          ret_value = &stdio_driver;
+#endif /* H4_HAVE_POSITIONAL_IO */
+          break;
+
+      case HDF_DRIVER_POSIX:
+          ret_value = &posix_driver;
+          break;
+
+      case HDF_DRIVER_STDIO:
+          ret_value = &stdio_driver;
+          break;
+
+      case HDF_DRIVER_CORE:
+          ret_value = &core_driver;
+          break;
+
+      default:
+          HGOTO_ERROR(DFE_ARGS, NULL);
+      } /* end switch */
+
+done:
+  if(ret_value == NULL)
+    { /* Error condition cleanup */
+
+    } /* end if */
+
+  /* Normal function cleanup */
+  return ret_value;
+} /* HPget_driver */
+
+/* ------------------------------ POSIX driver ----------------------------- */
+
+/******************************************************************************
+ NAME
+     HIposix_open - Open an existing file with the POSIX driver
+
+ RETURNS
+    Returns the driver handle of the file if successful and NULL otherwise
+
+*******************************************************************************/
+static void *
+HIposix_open(const char *path, intn acc_mode)
+{
+    posix_file_t *pf;
+    int         fd;
+
+    fd = open(path, ((acc_mode & DFACC_WRITE) ? O_RDWR : O_RDONLY) | O_BINARY);
+    if (fd < 0)
+        return NULL;
+
+    if ((pf = (posix_file_t *)HDmalloc(sizeof(posix_file_t))) == NULL)
+      {
+          close(fd);
+          return NULL;
+      } /* end if */
+    pf->fd = fd;
+
+    return pf;
+} /* HIposix_open */
+
+/******************************************************************************
+ NAME
+     HIposix_create - Create (or truncate) a file with the POSIX driver
+
+ RETURNS
+    Returns the driver handle of the file if successful and NULL otherwise
+
+*******************************************************************************/
+static void *
+HIposix_create(const char *path)
+{
+    posix_file_t *pf;
+    int         fd;
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
+    if (fd < 0)
+        return NULL;
+
+    if ((pf = (posix_file_t *)HDmalloc(sizeof(posix_file_t))) == NULL)
+      {
+          close(fd);
+          return NULL;
+      } /* end if */
+    pf->fd = fd;
+
+    return pf;
+} /* HIposix_create */
+
+/******************************************************************************
+ NAME
+     HIposix_read - Read from a file opened with the POSIX driver
+
+ DESCRIPTION
+    Reads exactly 'bytes' bytes at 'offset', short reads are retried until
+    the end of the file is reached.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIposix_read(void *file, void *buf, int32 bytes, hdf_off_t offset)
+{
+    posix_file_t *pf = (posix_file_t *)file;
+    uint8      *p = (uint8 *)buf;
+    ssize_t     n;
+
+    if ((hdf_off_t)(off_t)offset != offset)     /* off_t is too narrow */
+        return FAIL;
+
+#ifndef H4_HAVE_POSITIONAL_IO
+    if (lseek(pf->fd, (off_t)offset, SEEK_SET) == (off_t)-1)
+        return FAIL;
+#endif /* H4_HAVE_POSITIONAL_IO */
+    while (bytes > 0)
+      {
+#ifdef H4_HAVE_POSITIONAL_IO
+          n = pread(pf->fd, p, (size_t)bytes, (off_t)offset);
+#else /* H4_HAVE_POSITIONAL_IO */
+          n = read(pf->fd, p, (size_t)bytes);
+#endif /* H4_HAVE_POSITIONAL_IO */
+          if (n < 0 && errno == EINTR)
+              continue;
+          if (n <= 0)
+              return FAIL;
+          p += n;
+          bytes -= (int32)n;
+          offset += (hdf_off_t)n;
+      } /* end while */
+
+    return SUCCEED;
+} /* HIposix_read */
+
+/******************************************************************************
+ NAME
+     HIposix_write - Write to a file opened with the POSIX driver
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIposix_write(void *file, const void *buf, int32 bytes, hdf_off_t offset)
+{
+    posix_file_t *pf = (posix_file_t *)file;
+    const uint8 *p = (const uint8 *)buf;
+    ssize_t     n;
+
+    if ((hdf_off_t)(off_t)offset != offset)     /* off_t is too narrow */
+        return FAIL;
+
+#ifndef H4_HAVE_POSITIONAL_IO
+    if (lseek(pf->fd, (off_t)offset, SEEK_SET) == (off_t)-1)
+        return FAIL;
+#endif /* H4_HAVE_POSITIONAL_IO */
+    while (bytes > 0)
+      {
+#ifdef H4_HAVE_POSITIONAL_IO
+          n = pwrite(pf->fd, p, (size_t)bytes, (off_t)offset);
+#else /* H4_HAVE_POSITIONAL_IO */
+          n = write(pf->fd, p, (size_t)bytes);
+#endif /* H4_HAVE_POSITIONAL_IO */
+          if (n < 0 && errno == EINTR)
+              continue;
+          if (n <= 0)
+              return FAIL;
+          p += n;
+          bytes -= (int32)n;
+          offset += (hdf_off_t)n;
+      } /* end while */
+
+    return SUCCEED;
+} /* HIposix_write */
+
+/******************************************************************************
+ NAME
+     HIposix_flush - Flush a file opened with the POSIX driver
+
+ DESCRIPTION
+    Nothing is buffered by the POSIX driver.
+
+ RETURNS
+    Returns SUCCEED
+
+*******************************************************************************/
+static intn
+HIposix_flush(void *file)
+{
+    /* shut compiler up */
+    file = file;
+
+    return SUCCEED;
+} /* HIposix_flush */
+
+/******************************************************************************
+ NAME
+     HIposix_close - Close a file opened with the POSIX driver
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIposix_close(void *file)
+{
+    posix_file_t *pf = (posix_file_t *)file;
+    intn        ret_value = SUCCEED;
+
+    if (close(pf->fd) != 0)
+        ret_value = FAIL;
+    HDfree(pf);
+
+    return ret_value;
+} /* HIposix_close */
+
+/******************************************************************************
+ NAME
+     HIposix_size - Get the size of a file opened with the POSIX driver
+
+ RETURNS
+    Returns the size of the file if successful and FAIL otherwise
+
+*******************************************************************************/
+static hdf_off_t
+HIposix_size(void *file)
+{
+    posix_file_t *pf = (posix_file_t *)file;
+    struct stat file_stat;
+
+    if (fstat(pf->fd, &file_stat) != 0)
+        return FAIL;
+
+    return (hdf_off_t)file_stat.st_size;
+} /* HIposix_size */
+
+#ifdef H4_HAVE_MMAP_IO
+/******************************************************************************
+ NAME
+     HIposix_map - Map a file opened with the POSIX driver into memory
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIposix_map(void *file, uint8 **base, int32 *len)
+{
+    return HIfd_map(((posix_file_t *)file)->fd, base, len);
+} /* HIposix_map */
+#endif /* H4_HAVE_MMAP_IO */
+
+#ifdef H4_HAVE_READAHEAD
+/******************************************************************************
+ NAME
+     HIposix_prefetch - Read ahead in a file opened with the POSIX driver
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIposix_prefetch(void *file, hdf_off_t offset, int32 len)
+{
+    return HIfd_prefetch(((posix_file_t *)file)->fd, offset, len);
+} /* HIposix_prefetch */
+#endif /* H4_HAVE_READAHEAD */
+
+/* ------------------------------ stdio driver ----------------------------- */
+
+/******************************************************************************
+ NAME
+     HIstdio_open - Open an existing file with the stdio driver
+
+ RETURNS
+    Returns the driver handle of the file if successful and NULL otherwise
+
+*******************************************************************************/
+static void *
+HIstdio_open(const char *path, intn acc_mode)
+{
+    stdio_file_t *sf;
+    FILE       *fp;
+
+    fp = fopen(path, (acc_mode & DFACC_WRITE) ? "rb+" : "rb");
+    if (fp == NULL)
+        return NULL;
+
+    if ((sf = (stdio_file_t *)HDmalloc(sizeof(stdio_file_t))) == NULL)
+      {
+          fclose(fp);
+          return NULL;
+      } /* end if */
+    sf->fp = fp;
+    sf->pos = 0;
+    sf->last_op = H4_OP_UNKNOWN;
+
+    return sf;
+} /* HIstdio_open */
+
+/******************************************************************************
+ NAME
+     HIstdio_create - Create (or truncate) a file with the stdio driver
+
+ RETURNS
+    Returns the driver handle of the file if successful and NULL otherwise
+
+*******************************************************************************/
+static void *
+HIstdio_create(const char *path)
+{
+    stdio_file_t *sf;
+    FILE       *fp;
+
+    if ((fp = fopen(path, "wb+")) == NULL)
+        return NULL;
+
+    if ((sf = (stdio_file_t *)HDmalloc(sizeof(stdio_file_t))) == NULL)
+      {
+          fclose(fp);
+          return NULL;
+      } /* end if */
+    sf->fp = fp;
+    sf->pos = 0;
+    sf->last_op = H4_OP_UNKNOWN;
+
+    return sf;
+} /* HIstdio_create */
+
+/******************************************************************************
+ NAME
+     HIstdio_seek - Position a stream for the next operation
+
+ DESCRIPTION
+    Seeks only when the stream is not already at 'offset', or when the
+    operation switches between reading and writing, which ISO C requires a
+    positioning call for.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIstdio_seek(stdio_file_t *sf, hdf_off_t offset, fileop_t op)
+{
+    if (sf->pos != offset || sf->last_op == H4_OP_UNKNOWN
+        || (sf->last_op != H4_OP_SEEK && sf->last_op != op))
+      {
+#ifdef HFILE_SEEKINFO
+          if (sf->pos == offset)
+            {
+              if (op == H4_OP_READ)
+                  read_force_seek++;
+              else
+                  write_force_seek++;
+            } /* end if */
+          seek_taken++;
+#endif /* HFILE_SEEKINFO */
+          if ((hdf_off_t)(long)offset != offset     /* long is too narrow */
+              || fseek(sf->fp, (long)offset, SEEK_SET) != 0)
+            {
+              sf->last_op = H4_OP_UNKNOWN;
+              return FAIL;
+            } /* end if */
+          sf->pos = offset;
+          sf->last_op = H4_OP_SEEK;
+      } /* end if */
+#ifdef HFILE_SEEKINFO
+    else
+        seek_avoided++;
+#endif /* HFILE_SEEKINFO */
+
+    return SUCCEED;
+} /* HIstdio_seek */
+
+/******************************************************************************
+ NAME
+     HIstdio_read - Read from a file opened with the stdio driver
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIstdio_read(void *file, void *buf, int32 bytes, hdf_off_t offset)
+{
+    stdio_file_t *sf = (stdio_file_t *)file;
+
+    if (HIstdio_seek(sf, offset, H4_OP_READ) == FAIL)
+        return FAIL;
+
+    if ((size_t)bytes != fread(buf, 1, (size_t)bytes, sf->fp))
+      {
+          sf->last_op = H4_OP_UNKNOWN;
+          return FAIL;
+      } /* end if */
+    sf->pos += bytes;
+    sf->last_op = H4_OP_READ;
+
+    return SUCCEED;
+} /* HIstdio_read */
+
+/******************************************************************************
+ NAME
+     HIstdio_write - Write to a file opened with the stdio driver
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIstdio_write(void *file, const void *buf, int32 bytes, hdf_off_t offset)
+{
+    stdio_file_t *sf = (stdio_file_t *)file;
+
+    if (HIstdio_seek(sf, offset, H4_OP_WRITE) == FAIL)
+        return FAIL;
+
+    if ((size_t)bytes != fwrite(buf, 1, (size_t)bytes, sf->fp))
+      {
+          sf->last_op = H4_OP_UNKNOWN;
+          return FAIL;
+      } /* end if */
+    sf->pos += bytes;
+    sf->last_op = H4_OP_WRITE;
+
+    return SUCCEED;
+} /* HIstdio_write */
+
+/******************************************************************************
+ NAME
+     HIstdio_flush - Flush a file opened with the stdio driver
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIstdio_flush(void *file)
+{
+    return (fflush(((stdio_file_t *)file)->fp) == 0 ? SUCCEED : FAIL);
+} /* HIstdio_flush */
+
+/******************************************************************************
+ NAME
+     HIstdio_close - Close a file opened with the stdio driver
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIstdio_close(void *file)
+{
+    stdio_file_t *sf = (stdio_file_t *)file;
+    intn        ret_value = SUCCEED;
+
+    if (fclose(sf->fp) != 0)
+        ret_value = FAIL;
+    HDfree(sf);
+
+    return ret_value;
+} /* HIstdio_close */
+
+/******************************************************************************
+ NAME
+     HIstdio_size - Get the size of a file opened with the stdio driver
+
+ RETURNS
+    Returns the size of the file if successful and FAIL otherwise
+
+*******************************************************************************/
+static hdf_off_t
+HIstdio_size(void *file)
+{
+    stdio_file_t *sf = (stdio_file_t *)file;
+    long        size;
+
+    /* the stream is left at the end of the file */
+    sf->last_op = H4_OP_UNKNOWN;
+    if (fseek(sf->fp, 0L, SEEK_END) != 0 || (size = ftell(sf->fp)) < 0)
+        return FAIL;
+
+    return (hdf_off_t)size;
+} /* HIstdio_size */
+
+#ifdef H4_HAVE_MMAP_IO
+/******************************************************************************
+ NAME
+     HIstdio_map - Map a file opened with the stdio driver into memory
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIstdio_map(void *file, uint8 **base, int32 *len)
+{
+    stdio_file_t *sf = (stdio_file_t *)file;
+
+    /* the mapping must see anything still buffered in the stream */
+    if (fflush(sf->fp) != 0)
+        return FAIL;
+
+    return HIfd_map(fileno(sf->fp), base, len);
+} /* HIstdio_map */
+#endif /* H4_HAVE_MMAP_IO */
+
+#ifdef H4_HAVE_READAHEAD
+/******************************************************************************
+ NAME
+     HIstdio_prefetch - Read ahead in a file opened with the stdio driver
+
+ DESCRIPTION
+    Only the system reads ahead, the data doesn't go into the stream's
+    buffer.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIstdio_prefetch(void *file, hdf_off_t offset, int32 len)
+{
+    return HIfd_prefetch(fileno(((stdio_file_t *)file)->fp), offset, len);
+} /* HIstdio_prefetch */
+#endif /* H4_HAVE_READAHEAD */
+
+/* ------------------------------ core driver ------------------------------ */
+
+/******************************************************************************
+ NAME
+     HIcore_open - Open an existing file with the core driver
+
+ DESCRIPTION
+    Reads the whole file into memory.  The file itself is not kept open.
+
+ RETURNS
+    Returns the driver handle of the file if successful and NULL otherwise
+
+*******************************************************************************/
+static void *
+HIcore_open(const char *path, intn acc_mode)
+{
+    core_file_t *cf = NULL;
+    FILE       *fp;
+    long        size;
+
+    if ((fp = fopen(path, (acc_mode & DFACC_WRITE) ? "rb+" : "rb")) == NULL)
+        return NULL;
+
+    if (fseek(fp, 0L, SEEK_END) != 0 || (size = ftell(fp)) < 0
+        || size > (long)INT_MAX || fseek(fp, 0L, SEEK_SET) != 0)
+        goto error;
+
+    if ((cf = (core_file_t *)HDcalloc(1, sizeof(core_file_t))) == NULL)
+        goto error;
+    if ((cf->path = HDstrdup(path)) == NULL)
+        goto error;
+
+    cf->alloc = (int32)MAX(size, 1);
+    if ((cf->image = (uint8 *)HDmalloc((size_t)cf->alloc)) == NULL)
+        goto error;
+    if (size > 0 && (size_t)size != fread(cf->image, 1, (size_t)size, fp))
+        goto error;
+    cf->eof = (int32)size;
+    cf->writable = (acc_mode & DFACC_WRITE) ? TRUE : FALSE;
+    cf->dirty = FALSE;
+
+    fclose(fp);
+    return cf;
+
+error:
+    fclose(fp);
+    if (cf != NULL)
+      {
+          HDfreenclear(cf->image);
+          HDfreenclear(cf->path);
+          HDfree(cf);
+      } /* end if */
+    return NULL;
+} /* HIcore_open */
+
+/******************************************************************************
+ NAME
+     HIcore_create - Create (or truncate) a file with the core driver
+
+ DESCRIPTION
+    The file is created (empty) right away, so that the same errors are
+    reported as with the other drivers, the contents are written when the
+    file is closed.
+
+ RETURNS
+    Returns the driver handle of the file if successful and NULL otherwise
+
+*******************************************************************************/
+static void *
+HIcore_create(const char *path)
+{
+    core_file_t *cf;
+    FILE       *fp;
+
+    if ((fp = fopen(path, "wb")) == NULL)
+        return NULL;
+    fclose(fp);
+
+    if ((cf = (core_file_t *)HDcalloc(1, sizeof(core_file_t))) == NULL)
+        return NULL;
+    if ((cf->path = HDstrdup(path)) == NULL)
+      {
+          HDfree(cf);
+          return NULL;
+      } /* end if */
+    cf->writable = TRUE;
+    cf->dirty = TRUE;
+
+    return cf;
+} /* HIcore_create */
+
+/******************************************************************************
+ NAME
+     HIcore_read - Read from a file opened with the core driver
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIcore_read(void *file, void *buf, int32 bytes, hdf_off_t offset)
+{
+    core_file_t *cf = (core_file_t *)file;
+
+    if (offset < 0 || bytes < 0 || offset > (hdf_off_t)(cf->eof - bytes))
+        return FAIL;
+    HDmemcpy(buf, cf->image + offset, bytes);
+
+    return SUCCEED;
+} /* HIcore_read */
+
+/******************************************************************************
+ NAME
+     HIcore_write - Write to a file opened with the core driver
+
+ DESCRIPTION
+    Grows the image as needed, by at least half its size at a time so that
+    building a file with many small writes is not quadratic.  A gap left
+    between the old end of the image and 'offset' is zero-filled.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIcore_write(void *file, const void *buf, int32 bytes, hdf_off_t offset)
+{
+    core_file_t *cf = (core_file_t *)file;
+    int32       off;            /* offset in the image */
+
+    /* the image is addressed with int32 offsets */
+    if (!cf->writable || offset < 0 || bytes < 0
+        || offset > (hdf_off_t)(INT_MAX - bytes))
+        return FAIL;
+    off = (int32)offset;
+
+    if (off + bytes > cf->alloc)
+      {
+          int32       new_alloc;
+          uint8      *new_image;
+
+          new_alloc = MAX(off + bytes, cf->alloc + MAX(cf->alloc / 2, CORE_INCREMENT));
+          if (new_alloc < 0)    /* overflowed, allocate just what is needed */
+              new_alloc = off + bytes;
+          if ((new_image = (uint8 *)HDrealloc(cf->image, (size_t)new_alloc)) == NULL)
+              return FAIL;
+          cf->image = new_image;
+          cf->alloc = new_alloc;
+      } /* end if */
+
+    if (off > cf->eof)
+        HDmemset(cf->image + cf->eof, 0, (size_t)(off - cf->eof));
+    HDmemcpy(cf->image + off, buf, bytes);
+    if (off + bytes > cf->eof)
+        cf->eof = off + bytes;
+    cf->dirty = TRUE;
+
+    return SUCCEED;
+} /* HIcore_write */
+
+/******************************************************************************
+ NAME
+     HIcore_flush - Flush a file opened with the core driver
+
+ DESCRIPTION
+    The image is only written out when the file is closed.
+
+ RETURNS
+    Returns SUCCEED
+
+*******************************************************************************/
+static intn
+HIcore_flush(void *file)
+{
+    /* shut compiler up */
+    file = file;
+
+    return SUCCEED;
+} /* HIcore_flush */
+
+/******************************************************************************
+ NAME
+     HIcore_close - Close a file opened with the core driver
+
+ DESCRIPTION
+    Writes the image out with a single write if it was modified, then
+    releases it.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIcore_close(void *file)
+{
+    core_file_t *cf = (core_file_t *)file;
+    FILE       *fp;
+    intn        ret_value = SUCCEED;
+
+    if (cf->writable && cf->dirty)
+      {
+          if ((fp = fopen(cf->path, "wb")) == NULL)
+              ret_value = FAIL;
+          else
+            {
+              if (cf->eof > 0
+                  && (size_t)cf->eof != fwrite(cf->image, 1, (size_t)cf->eof, fp))
+                  ret_value = FAIL;
+              if (fclose(fp) != 0)
+                  ret_value = FAIL;
+            } /* end else */
+      } /* end if */
+
+    HDfreenclear(cf->image);
+    HDfreenclear(cf->path);
+    HDfree(cf);
+
+    return ret_value;
+} /* HIcore_close */
+
+/******************************************************************************
+ NAME
+     HIcore_size - Get the size of a file opened with the core driver
+
+ RETURNS
+    Returns the size of the file image
+
+*******************************************************************************/
+static hdf_off_t
+HIcore_size(void *file)
+{
+    return ((core_file_t *)file)->eof;
+} /* HIcore_size */
+
+/* ------------------------------ file mapping ----------------------------- */
+#ifdef H4_HAVE_MMAP_IO
+
+/******************************************************************************
+ NAME
+     HIfd_map - Map a whole file into memory
+
+ DESCRIPTION
+    Maps the file open on descriptor 'fd' read-only.  Files larger than
+    what an int32 offset can address are not mapped.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIfd_map(int fd, uint8 **base, int32 *len)
+{
+    struct stat file_stat;
+    void       *addr;
+
+    if (fstat(fd, &file_stat) != 0
+        || file_stat.st_size <= 0 || file_stat.st_size > (off_t)INT_MAX)
+        return FAIL;
+
+    addr = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_SHARED, fd, (off_t)0);
+    if (addr == MAP_FAILED)
+        return FAIL;
+
+    *base = (uint8 *)addr;
+    *len = (int32)file_stat.st_size;
+
+    return SUCCEED;
+} /* HIfd_map */
+
+/******************************************************************************
+ NAME
+     HIfd_unmap - Release a mapping made by HIfd_map
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIfd_unmap(void *file, uint8 *base, int32 len)
+{
+    /* shut compiler up */
+    file = file;
+
+    if (munmap((void *)base, (size_t)len) != 0)
+        return FAIL;
+
+    return SUCCEED;
+} /* HIfd_unmap */
+
+#endif /* H4_HAVE_MMAP_IO */
+
+/* ------------------------------- read-ahead ------------------------------ */
+#ifdef H4_HAVE_READAHEAD
+
+/******************************************************************************
+ NAME
+     HIfd_prefetch - Ask the system to read part of a file ahead
+
+ DESCRIPTION
+    The system starts reading 'len' bytes from 'offset' of the file open on
+    descriptor 'fd' into its cache and returns straight away.
+
+ RETURNS
+    Returns SUCCEED if successful and FAIL otherwise
+
+*******************************************************************************/
+static intn
+HIfd_prefetch(int fd, hdf_off_t offset, int32 len)
+{
+    if (posix_fadvise(fd, (off_t)offset, (off_t)len, POSIX_FADV_WILLNEED) != 0)
+        return FAIL;
+
+    return SUCCEED;
+} /* HIfd_prefetch */
+
+#endif /* H4_HAVE_READAHEAD */
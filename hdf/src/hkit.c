@@ -156,7 +156,9 @@ HDflush(int32 file_id)
     if (BADFREC(file_rec))
         HRETURN_ERROR(DFE_ARGS, FAIL);
 
-    HI_FLUSH(file_rec->file);
+    if (HPflush_writes(file_rec) == FAIL)
+        HRETURN_ERROR(DFE_WRITEERROR, FAIL);
+    (*file_rec->driver->flush)(file_rec->file);
 
     return SUCCEED;
 }	/* HDflush */
@@ -332,6 +334,7 @@ DESCRIPTION
 const char *
 HDfidtoname(int32 file_id)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "HDfidtoname");    /* for HERROR */
     filerec_t  *file_rec;
 
@@ -109,6 +109,34 @@
 #   define MIN_NDDS 4
 #endif /* MIN_NDDS */
 
+/* ndds maximum, the number of dd's in a block is stored in 16 bits */
+#ifndef MAX_NDDS
+#   define MAX_NDDS 32767
+#endif /* MAX_NDDS */
+
+/* size of the buffer each file gathers small writes in before they are
+   written out, 0 to write everything straight to the file.  Buffering
+   is off unless turned on with Hwritebuf() */
+#ifndef DEF_WRITEBUF_SIZE
+#   define DEF_WRITEBUF_SIZE 0
+#endif /* DEF_WRITEBUF_SIZE */
+
+/* # of bytes read ahead of sequential reads of an element, 0 for none.
+   Reading ahead is off unless turned on with Hreadahead() */
+#ifndef DEF_READAHEAD_SIZE
+#   define DEF_READAHEAD_SIZE 0
+#endif /* DEF_READAHEAD_SIZE */
+
+/* Hreadv reads elements no more than this many bytes apart with one read */
+#ifndef READV_MAX_GAP
+#   define READV_MAX_GAP 4096
+#endif /* READV_MAX_GAP */
+
+/* the most bytes Hreadv reads with one read to serve several elements */
+#ifndef READV_MAX_SPAN
+#   define READV_MAX_SPAN (1024*1024)
+#endif /* READV_MAX_SPAN */
+
 /* largest number that will fit into 16-bit word ref variable */
 #define MAX_REF ((uint16)65535)
 
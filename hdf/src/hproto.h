@@ -67,6 +67,9 @@ extern      "C"
     HDFLIBAPI int32 Hopen
                 (const char *path, intn acc_mode, int16 ndds);
 
+    HDFLIBAPI int32 Hopendriver
+                (const char *path, intn acc_mode, int16 ndds, intn driver_id);
+
     HDFLIBAPI intn Hclose
                 (int32 file_id);
 
@@ -129,6 +132,9 @@ extern      "C"
     HDFLIBAPI int32 Hgetelement
                 (int32 file_id, uint16 tag, uint16 ref, uint8 * data);
 
+    HDFLIBAPI intn Hreadv
+                (int32 file_id, intn nreqs, hdf_readreq_t reqs[]);
+
     HDFLIBAPI int32 Hputelement
                 (int32 file_id, uint16 tag, uint16 ref, const uint8 * data, int32 length);
 
@@ -144,10 +150,37 @@ extern      "C"
     HDFLIBAPI intn Hcache
                 (int32 file_id, intn cache_on);
 
+    HDFLIBAPI intn Hmmap
+                (int32 file_id, intn mmap_on);
+
+    HDFLIBAPI intn Hsetdriver
+                (intn driver_id);
+
+    HDFLIBAPI intn Hgetdriver
+                (int32 file_id);
+
+    HDFLIBAPI intn Hsetlazydd
+                (intn lazy_on);
+
+    HDFLIBAPI intn Hmergedd
+                (int32 file_id, intn merge_on);
+
+    HDFLIBAPI intn Hwritebuf
+                (int32 file_id, int32 size);
+
+    HDFLIBAPI intn Hreadahead
+                (int32 file_id, int32 size);
+
+    HDFLIBAPI intn Hgetiostats
+                (int32 file_id, hdf_iostats_t *stats);
+
     HDFLIBAPI intn Hgetlibversion
                 (uint32 * majorv, uint32 * minorv,
                  uint32 * releasev, char * string);
 
+    HDFLIBAPI intn Hthreadsafe
+                (void);
+
     HDFLIBAPI intn Hgetfileversion
                 (int32 file_id, uint32 * majorv, uint32 * minorv,
                  uint32 * release, char * string);
@@ -478,6 +511,27 @@ HDFLIBAPI intn Hdeldd(int32 file_id,      /* IN: File ID the tag/refs are in */
                 (int32 file_id, uint16 data_tag, uint16 data_ref,
         int32* comp_size, int32* orig_size);
 
+    HDFLIBAPI intn HCPreadcoded
+                (int32 file_id, uint16 data_tag, uint16 data_ref,
+        comp_coder_t *coder_type, int32 *orig_size, int32 *coded_size,
+        uint8 **coded);
+
+    HDFLIBAPI int32 HCPdecode_coded
+                (comp_coder_t coder_type, const uint8 *coded, int32 coded_size,
+        uint8 *buf, int32 length);
+
+    HDFLIBAPI int32 HCPencode_coded
+                (comp_coder_t coder_type, const comp_info * c_info,
+        const uint8 *buf, int32 length, uint8 *coded, int32 coded_size);
+
+    HDFLIBAPI int32 HCPwritecoded
+                (int32 access_id, comp_coder_t coder_type, const uint8 *coded,
+        int32 coded_size, int32 length);
+
+/* Size of a buffer large enough for HCPencode_coded to compress 'len'
+   bytes into */
+#define HCP_CODED_BOUND(len)    ((len) + (len) / 1000 + 12)
+
     HDFPUBLIC intn HCget_config_info ( comp_coder_t coder_type, uint32 *compression_config_info);
 
     HDFLIBAPI int32 HCPquery_encode_header(comp_model_t model_type, model_info * m_info,
@@ -507,6 +561,39 @@ HDFLIBAPI intn Hdeldd(int32 file_id,      /* IN: File ID the tag/refs are in */
                 (int32 fid, uint16 tag, uint16 ref, int32 xdim, int32 ydim,int16 scheme, comp_info *cinfo, uintn pixel_size);
 
 
+/*
+   ** from hwork.c
+ */
+    HDFLIBAPI void HWrun
+                (hdf_worktask_t task, void * args, size_t arg_size, intn count);
+
+    HDFLIBAPI intn HWnthreads
+                (void);
+
+    HDFLIBAPI intn HWshutdown
+                (void);
+
+/*
+   ** from hcache.c
+ */
+    HDFLIBAPI intn HCSsetmax
+                (int32 max);
+
+    HDFLIBAPI intn HCSget
+                (void * file, uint16 tag, uint16 ref, void * datap, int32 length);
+
+    HDFLIBAPI void HCSput
+                (void * file, uint16 tag, uint16 ref, const void * datap, int32 length);
+
+    HDFLIBAPI void HCSinvalidate
+                (void * file, uint16 tag, uint16 ref);
+
+    HDFLIBAPI void HCSpurge
+                (void * file);
+
+    HDFLIBAPI intn HCSshutdown
+                (void);
+
 /*
    ** from herr.c
  */
@@ -1219,6 +1306,15 @@ HDFLIBAPI intn GR2bmapped(int32 riid, intn *tobe_mapped, intn *created_byGR);
 /* Cache flags */
 #define HDF_CACHEALL 0x1
 
+/* Eviction policies of the chunk cache, for HMCsetCachePolicy() and
+   SDsetchunkcachepolicy(); the same values as the MCACHE_ ones */
+#define HDF_CACHE_LRU    0   /* least recently used chunk first */
+#define HDF_CACHE_2Q     1   /* chunks used once before chunks used again */
+#define HDF_CACHE_CLOCK  2   /* chunks not used since the last sweep first */
+
+/* Chunk placement flags, for HMCsetAlignment() and SDsetchunkalign() */
+#define HDF_CHUNK_PREALLOC 0x1  /* keep one extent of the file for all chunks */
+
 /* Chunk Defintion, Note that GRs need only 2 dimensions for the chunk_lengths */
 typedef union hdf_chunk_def_u
 {
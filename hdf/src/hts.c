@@ -0,0 +1,431 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Board of Trustees of the University of Illinois.         *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of HDF.  The full HDF copyright notice, including       *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the root of the source code       *
+ * distribution tree, or in https://support.hdfgroup.org/ftp/HDF/releases/.  *
+ * If you do not have access to either file, you may request a copy from     *
+ * help@hdfgroup.org.                                                        *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* $Id$ */
+
+/*
+FILE
+    hts.c - Thread-safety for the HDF and mfhdf libraries.
+
+REMARKS
+    The library keeps much of its state in process globals: the atom
+    groups and the atom cache, the list of open files, the conversion
+    and temporary buffers of the Vset and SD layers and the "last
+    reference" state of the single-file interfaces.  In a thread-safe
+    build all of it is guarded by a single recursive lock, the API lock,
+    which every public API routine holds for as long as it runs (see
+    HTS_API_LOCK in hts.h).  The error stack is kept per thread instead
+    (see herr.h).  Calls from different threads are
+    therefore serialized, a thread calling back into the API from inside
+    the library just takes the lock again.
+
+    The state of an open file, its DD list, free space, buffers and
+    caches, is guarded by a lock in its file record instead, which lets
+    the reads of different files run at the same time: a thread reading
+    an element of a file opened read-only holds the lock of its file but
+    not the API lock (see HTS_READ_LOCK and HTS_API_SUSPEND in hts.h).
+
+DESIGN
+    The API lock is a plain POSIX mutex.  Each thread counts how many
+    times it holds it in a thread-local variable, the mutex is taken when
+    the count goes from 0 to 1 and released when it goes back to 0.  The
+    count is what lets a thread give up the lock at any depth and take it
+    back as deep as it was.  A second thread-local count, the region,
+    tells the API routines a thread calls while reading without the API
+    lock not to take it.
+
+    The file locks are recursive POSIX mutexes, created with the file
+    record.
+
+EXPORTED ROUTINES
+    Hthreadsafe        -- report whether the library was built thread-safe
+    HTSIapi_lock       -- take the API lock
+    HTSIapi_unlock     -- release the API lock taken by HTSIapi_lock
+    HTSIapi_suspend    -- give up the API lock
+    HTSIapi_resume     -- take back the API lock given up by HTSIapi_suspend
+    HTSIfile_lock      -- take the lock of a file
+    HTSIfile_unlock    -- release the lock taken by HTSIfile_lock
+    HTSIread_lock      -- take the locks to read through an access id
+    HTSIread_unlock    -- release the locks taken by HTSIread_lock
+    HTSIinit_lock      -- create a recursive lock
+    HTSImutex_lock     -- take the lock of a registry
+    HTSImutex_unlock   -- release the lock taken by HTSImutex_lock
+
+MODIFICATION HISTORY
+*/
+
+#include "hdf.h"
+#include "hfile.h"
+#include "hchunks.h"
+
+#ifdef H4_HAVE_THREADSAFE
+
+/* The API lock */
+PRIVATE pthread_mutex_t api_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Times the thread holds the API lock, and how many times it held it
+   when it gave it up with HTSIapi_suspend */
+PRIVATE __thread intn api_depth = 0;
+PRIVATE __thread intn api_saved = 0;
+
+/* Read routines the thread is in without the API lock */
+PRIVATE __thread intn read_region = 0;
+
+/* One bit for each HTSIapi_suspend not resumed yet, set if it gave up
+   the API lock */
+PRIVATE __thread uint32 api_suspended = 0;
+
+PRIVATE intn HTSIread_alone(int32 aid);
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTSIread_alone -- check whether an element can be read without the API lock
+ USAGE
+    intn HTSIread_alone(aid)
+        int32 aid;          IN: access id read through
+ RETURNS
+    TRUE/FALSE
+ DESCRIPTION
+    Elements of files open for writing may have chunks to write out,
+    which goes through the Vdata interface, and the old decoders of
+    compressed raster images keep their state in globals.  Neither can be
+    read without the API lock.  Nor can a chunked element whose chunk
+    table is still to be read through the Vdata interface, see
+    HMCIfind_chunk().
+
+---------------------------------------------------------------------------*/
+PRIVATE intn
+HTSIread_alone(int32 aid)
+{
+    accrec_t   *access_rec;
+    filerec_t  *file_rec;
+
+    if ((access_rec = HAatom_object(aid)) == NULL
+        || access_rec->special == SPECIAL_COMPRAS)
+        return FALSE;
+    if (access_rec->special == SPECIAL_CHUNKED && !HMCPtableread(access_rec))
+        return FALSE;
+    file_rec = HAatom_object(access_rec->file_id);
+    if (BADFREC(file_rec) || (file_rec->access & DFACC_WRITE))
+        return FALSE;
+    return TRUE;
+} /* end HTSIread_alone() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTSIapi_lock -- take the API lock
+ USAGE
+    intn HTSIapi_lock()
+ RETURNS
+    SUCCEED if the lock was taken, FAIL if not
+ DESCRIPTION
+    Waits for the API lock and takes it.  The calling thread may already
+    hold it, in which case it is taken once more.  A thread reading
+    without the API lock doesn't take it.  Only meant to be used through
+    HTS_API_LOCK, which stores the return value in the variable
+    HTSIapi_unlock later receives.
+
+---------------------------------------------------------------------------*/
+intn
+HTSIapi_lock(void)
+{
+    if (read_region > 0)
+        return FAIL;
+    if (api_depth == 0 && pthread_mutex_lock(&api_lock) != 0)
+        return FAIL;
+    api_depth++;
+    return SUCCEED;
+} /* end HTSIapi_lock() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTSIapi_unlock -- release the API lock
+ USAGE
+    void HTSIapi_unlock(guard)
+        intn *guard;        IN: the result of the matching HTSIapi_lock
+ RETURNS
+    none
+ DESCRIPTION
+    Releases the API lock once, if the matching HTSIapi_lock took it.
+    Called by the compiler when a routine which used HTS_API_LOCK returns.
+
+---------------------------------------------------------------------------*/
+void
+HTSIapi_unlock(intn *guard)
+{
+    if (*guard == SUCCEED && --api_depth == 0)
+        pthread_mutex_unlock(&api_lock);
+} /* end HTSIapi_unlock() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTSIapi_suspend -- give up the API lock
+ USAGE
+    void HTSIapi_suspend(aid)
+        int32 aid;          IN: access id about to be read through
+ RETURNS
+    none
+ DESCRIPTION
+    Releases the API lock, however many times the thread holds it, and
+    marks the thread as reading without it, until HTSIapi_resume.  The
+    lock is kept if the element can't be read without it.  The thread
+    must hold no file lock.  Only meant to be used through
+    HTS_API_SUSPEND.
+
+---------------------------------------------------------------------------*/
+void
+HTSIapi_suspend(int32 aid)
+{
+    api_suspended <<= 1;
+    if (api_depth == 0 || read_region > 0 || !HTSIread_alone(aid))
+        return;
+
+    api_suspended |= 1;
+    api_saved = api_depth;
+    api_depth = 0;
+    read_region++;
+    pthread_mutex_unlock(&api_lock);
+} /* end HTSIapi_suspend() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTSIapi_resume -- take back the API lock
+ USAGE
+    void HTSIapi_resume()
+ RETURNS
+    none
+ DESCRIPTION
+    Waits for the API lock given up by the matching HTSIapi_suspend, if
+    it gave it up, and takes it back as many times as the thread held it.
+    Only meant to be used through HTS_API_RESUME.
+
+---------------------------------------------------------------------------*/
+void
+HTSIapi_resume(void)
+{
+    intn        suspended = (intn) (api_suspended & 1);
+
+    api_suspended >>= 1;
+    if (!suspended)
+        return;
+
+    read_region--;
+    pthread_mutex_lock(&api_lock);
+    api_depth = api_saved;
+    api_saved = 0;
+} /* end HTSIapi_resume() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTSIfile_lock -- take the lock of a file
+ USAGE
+    void *HTSIfile_lock(id)
+        int32 id;           IN: file id or access id
+ RETURNS
+    The file record locked, or NULL if the id is not valid
+ DESCRIPTION
+    Waits for the lock of the file the id belongs to and takes it.  The
+    calling thread may already hold it.  An id which is not valid is left
+    for the caller to report.  Only meant to be used through
+    HTS_FILE_LOCK.
+
+---------------------------------------------------------------------------*/
+void *
+HTSIfile_lock(int32 id)
+{
+    filerec_t  *file_rec = NULL;
+    accrec_t   *access_rec;
+
+    switch (HAatom_group(id))
+      {
+          case FIDGROUP:
+              file_rec = HAatom_object(id);
+              break;
+
+          case AIDGROUP:
+              access_rec = HAatom_object(id);
+              if (access_rec != NULL)
+                  file_rec = HAatom_object(access_rec->file_id);
+              break;
+
+          default:    /* left for the caller to report */
+              HEclear();
+              break;
+      }
+    if (BADFREC(file_rec))
+        return NULL;
+
+    pthread_mutex_lock(&file_rec->lock);
+    return file_rec;
+} /* end HTSIfile_lock() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTSIfile_unlock -- release the lock of a file
+ USAGE
+    void HTSIfile_unlock(guard)
+        void **guard;       IN: the result of the matching HTSIfile_lock
+ RETURNS
+    none
+ DESCRIPTION
+    Releases the lock the matching HTSIfile_lock took, if any.  Called by
+    the compiler when a routine which used HTS_FILE_LOCK returns.
+
+---------------------------------------------------------------------------*/
+void
+HTSIfile_unlock(void **guard)
+{
+    if (*guard != NULL)
+        pthread_mutex_unlock(&((filerec_t *) *guard)->lock);
+} /* end HTSIfile_unlock() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTSIread_lock -- take the locks to read through an access id
+ USAGE
+    HTS_read_t HTSIread_lock(aid)
+        int32 aid;          IN: access id read through
+ RETURNS
+    What was locked, for HTSIread_unlock
+ DESCRIPTION
+    A thread which holds the API lock takes it once more, as
+    HTSIapi_lock would, as does a thread reading an element which can't
+    be read without it.  Any other thread goes on without it, marked as
+    reading without the API lock.  Then the lock of the file is taken.
+    Only meant to be used through HTS_READ_LOCK.
+
+---------------------------------------------------------------------------*/
+HTS_read_t
+HTSIread_lock(int32 aid)
+{
+    HTS_read_t  ret_value;
+
+    ret_value.api = FAIL;
+    if (api_depth > 0 || (read_region == 0 && !HTSIread_alone(aid)))
+        ret_value.api = HTSIapi_lock();
+    else
+        read_region++;
+
+    ret_value.file = HTSIfile_lock(aid);
+    return ret_value;
+} /* end HTSIread_lock() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTSIread_unlock -- release the locks taken to read
+ USAGE
+    void HTSIread_unlock(guard)
+        HTS_read_t *guard;  IN: the result of the matching HTSIread_lock
+ RETURNS
+    none
+ DESCRIPTION
+    Releases what the matching HTSIread_lock took.  Called by the
+    compiler when a routine which used HTS_READ_LOCK returns.
+
+---------------------------------------------------------------------------*/
+void
+HTSIread_unlock(HTS_read_t *guard)
+{
+    HTSIfile_unlock(&guard->file);
+    if (guard->api == SUCCEED)
+        HTSIapi_unlock(&guard->api);
+    else
+        read_region--;
+} /* end HTSIread_unlock() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTSIinit_lock -- create a recursive lock
+ USAGE
+    void HTSIinit_lock(lock)
+        pthread_mutex_t *lock;  OUT: the lock to create
+ RETURNS
+    none
+ DESCRIPTION
+    Used for the locks of the file records, H routines call each other,
+    and for registry locks whose holder may take them again.
+
+---------------------------------------------------------------------------*/
+void
+HTSIinit_lock(pthread_mutex_t *lock)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+} /* end HTSIinit_lock() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTSImutex_lock -- take the lock of a registry
+ USAGE
+    pthread_mutex_t *HTSImutex_lock(m)
+        pthread_mutex_t *m;     IN: the lock
+ RETURNS
+    The lock, for HTSImutex_unlock
+ DESCRIPTION
+    Only meant to be used through HTS_MUTEX_GUARD.
+
+---------------------------------------------------------------------------*/
+pthread_mutex_t *
+HTSImutex_lock(pthread_mutex_t *m)
+{
+    pthread_mutex_lock(m);
+    return m;
+} /* end HTSImutex_lock() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HTSImutex_unlock -- release the lock of a registry
+ USAGE
+    void HTSImutex_unlock(guard)
+        pthread_mutex_t **guard;    IN: the result of HTSImutex_lock
+ RETURNS
+    none
+ DESCRIPTION
+    Called by the compiler when a routine which used HTS_MUTEX_GUARD
+    returns.
+
+---------------------------------------------------------------------------*/
+void
+HTSImutex_unlock(pthread_mutex_t **guard)
+{
+    pthread_mutex_unlock(*guard);
+} /* end HTSImutex_unlock() */
+
+#endif /* H4_HAVE_THREADSAFE */
+
+/*--------------------------------------------------------------------------
+ NAME
+    Hthreadsafe -- report whether the library is thread-safe
+ USAGE
+    intn Hthreadsafe()
+ RETURNS
+    TRUE if the library was built thread-safe, FALSE if not.
+ DESCRIPTION
+    Applications which call the library from more than one thread can use
+    this to check that the library they are linked with serializes the
+    calls itself.
+
+---------------------------------------------------------------------------*/
+intn
+Hthreadsafe(void)
+{
+#ifdef H4_HAVE_THREADSAFE
+    return TRUE;
+#else  /* H4_HAVE_THREADSAFE */
+    return FALSE;
+#endif /* H4_HAVE_THREADSAFE */
+} /* end Hthreadsafe() */
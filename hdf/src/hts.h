@@ -0,0 +1,155 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Board of Trustees of the University of Illinois.         *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of HDF.  The full HDF copyright notice, including       *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the root of the source code       *
+ * distribution tree, or in https://support.hdfgroup.org/ftp/HDF/releases/.  *
+ * If you do not have access to either file, you may request a copy from     *
+ * help@hdfgroup.org.                                                        *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* $Id$ */
+
+/*-----------------------------------------------------------------------------
+ * File:    hts.h
+ * Purpose: Thread-safety for the HDF and mfhdf libraries
+ *
+ * In a thread-safe build (configured with --enable-threadsafe, or with
+ * HDF4_ENABLE_THREADSAFE for CMake) the library keeps one recursive lock,
+ * the API lock.  Every public API routine starts with HTS_API_LOCK, which
+ * takes the lock and arranges for it to be released again when the
+ * routine returns, through whichever return statement it leaves by.  API
+ * routines called from inside the library just take the lock once more.
+ *
+ * Each open file has a lock of its own as well.  The H routines working
+ * on a file or an access id take it with HTS_FILE_LOCK, after the API
+ * lock.  The routines which only read an element (Hread, HMCreadChunk)
+ * use HTS_READ_LOCK instead of HTS_API_LOCK: called from outside the
+ * library, they take the file lock only, so that threads reading
+ * different files run at the same time.  Library routines which read
+ * with them can give up the API lock around the read with
+ * HTS_API_SUSPEND and HTS_API_RESUME, if they hold no file lock and
+ * nothing else reads or changes their own state in the meantime.  Only
+ * files opened read-only are read without the API lock, reading an
+ * element open for writing may write out chunks through the Vdata
+ * interface.  While a thread reads without the API lock, it takes no API
+ * lock either; the registries shared by all the files (atoms, free
+ * lists, I/O statistics) are guarded by short critical sections of their
+ * own, HTS_MUTEX_GUARD or HTS_MUTEX_LOCK/HTS_MUTEX_UNLOCK.  Each thread
+ * has an error stack of its own (see herr.h), which needs no lock.
+ *
+ * Locks are only ever taken in the order API lock, file lock, registry
+ * lock, which keeps the threads from deadlocking.
+ *
+ * The release on return relies on the cleanup variable attribute of GCC
+ * compatible compilers, configure checks for it.  In other builds all the
+ * macros expand to nothing.
+ *---------------------------------------------------------------------------*/
+
+#ifndef _HTS_H
+#define _HTS_H
+
+#include "H4api_adpt.h"
+
+#ifdef H4_HAVE_THREADSAFE
+#include <pthread.h>
+
+/* What HTS_READ_LOCK took */
+typedef struct
+{
+    intn        api;            /* SUCCEED if it took the API lock */
+    void       *file;           /* the file record it locked */
+} HTS_read_t;
+
+/* Take the API lock for the rest of the enclosing routine */
+#define HTS_API_LOCK \
+    intn HTS_api_guard __attribute__((cleanup(HTSIapi_unlock), unused)) = HTSIapi_lock()
+
+/* Take the lock of the file a file or access id belongs to, for the rest
+   of the enclosing routine */
+#define HTS_FILE_LOCK(id) \
+    void *HTS_file_guard __attribute__((cleanup(HTSIfile_unlock), unused)) = HTSIfile_lock(id)
+
+/* In place of HTS_API_LOCK, for routines which only read through an
+   access id: take the lock of its file, and the API lock only if the
+   thread already holds it */
+#define HTS_READ_LOCK(aid) \
+    HTS_read_t HTS_read_guard __attribute__((cleanup(HTSIread_unlock), unused)) = HTSIread_lock(aid)
+
+/* Give up the API lock around a read through an access id, and take it
+   back */
+#define HTS_API_SUSPEND(aid) HTSIapi_suspend(aid)
+#define HTS_API_RESUME      HTSIapi_resume()
+
+/* Critical sections around a registry shared by all the files, for the
+   rest of the enclosing routine or between the lock and the unlock */
+#define HTS_MUTEX_GUARD(m) \
+    pthread_mutex_t *HTS_mutex_guard __attribute__((cleanup(HTSImutex_unlock), unused)) = HTSImutex_lock(&(m))
+#define HTS_MUTEX_LOCK(m)   pthread_mutex_lock(&(m))
+#define HTS_MUTEX_UNLOCK(m) pthread_mutex_unlock(&(m))
+
+#else  /* H4_HAVE_THREADSAFE */
+
+/* The guards stand among the declarations at the top of a routine, so
+   without locks they must still be a declaration (of nothing used), not
+   an empty statement, for C90 compilers */
+#define HTS_NO_GUARD        extern void HTS_no_guard(void)
+#define HTS_API_LOCK        HTS_NO_GUARD
+#define HTS_FILE_LOCK(id)   HTS_NO_GUARD
+#define HTS_READ_LOCK(aid)  HTS_NO_GUARD
+#define HTS_API_SUSPEND(aid) ((void) 0)
+#define HTS_API_RESUME      ((void) 0)
+#define HTS_MUTEX_GUARD(m)  HTS_NO_GUARD
+#define HTS_MUTEX_LOCK(m)   ((void) 0)
+#define HTS_MUTEX_UNLOCK(m) ((void) 0)
+
+#endif /* H4_HAVE_THREADSAFE */
+
+#if defined c_plusplus || defined __cplusplus
+extern      "C"
+{
+#endif                          /* c_plusplus || __cplusplus */
+
+#ifdef H4_HAVE_THREADSAFE
+    HDFLIBAPI intn HTSIapi_lock
+                (void);
+
+    HDFLIBAPI void HTSIapi_unlock
+                (intn *guard);
+
+    HDFLIBAPI void HTSIapi_suspend
+                (int32 aid);
+
+    HDFLIBAPI void HTSIapi_resume
+                (void);
+
+    HDFLIBAPI void *HTSIfile_lock
+                (int32 id);
+
+    HDFLIBAPI void HTSIfile_unlock
+                (void **guard);
+
+    HDFLIBAPI HTS_read_t HTSIread_lock
+                (int32 aid);
+
+    HDFLIBAPI void HTSIread_unlock
+                (HTS_read_t *guard);
+
+    HDFLIBAPI void HTSIinit_lock
+                (pthread_mutex_t *lock);
+
+    HDFLIBAPI pthread_mutex_t *HTSImutex_lock
+                (pthread_mutex_t *m);
+
+    HDFLIBAPI void HTSImutex_unlock
+                (pthread_mutex_t **guard);
+#endif /* H4_HAVE_THREADSAFE */
+
+#if defined c_plusplus || defined __cplusplus
+}
+#endif                          /* c_plusplus || __cplusplus */
+
+#endif /* _HTS_H */
@@ -0,0 +1,375 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Board of Trustees of the University of Illinois.         *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of HDF.  The full HDF copyright notice, including       *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the root of the source code       *
+ * distribution tree, or in https://support.hdfgroup.org/ftp/HDF/releases/.  *
+ * If you do not have access to either file, you may request a copy from     *
+ * help@hdfgroup.org.                                                        *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* $Id$ */
+
+/*
+FILE
+    hwork.c - A pool of worker threads for CPU bound library work.
+
+REMARKS
+    Some of the work the library does for a single call splits into
+    pieces which do not depend on each other, the chunks of a read all
+    have to be decompressed for instance.  HWrun runs such a batch of
+    tasks on a pool of worker threads, the calling thread works on the
+    batch too and returns once all of it is done.
+
+    The tasks run outside of the locks of the library (see hts.h), so
+    they must not call the library, not even to report an error: they
+    only get the memory their argument points at.
+
+    The pool needs POSIX threads and only comes with the thread-safe
+    build, in other builds HWrun runs the tasks one after the other in
+    the calling thread.
+
+DESIGN
+    The workers are started the first time a batch comes, one less than
+    the number of processors online, at most HW_MAX_WORKERS; the
+    environment variable HDF4_NUM_WORKERS sets another number, 0 turns
+    the pool off.  The batches waiting for workers are kept in a queue
+    guarded by the mutex of the pool.  A worker takes the next task of
+    the batch at the head of the queue, a batch leaves the queue when its
+    last task has been taken.  The caller of HWrun takes tasks of its
+    own batch the same way and then waits until the tasks taken by the
+    workers are done as well.
+
+    HPend stops the workers with HWshutdown.
+
+EXPORTED ROUTINES
+    HWrun          -- run a batch of tasks on the worker pool
+    HWnthreads     -- number of threads a batch runs on
+    HWshutdown     -- stop the worker threads
+
+MODIFICATION HISTORY
+*/
+
+#include "hdf.h"
+
+#ifdef H4_HAVE_THREADSAFE
+#include <unistd.h>
+
+#define HW_MAX_WORKERS  16      /* most worker threads to start */
+
+/* A batch of tasks handed to HWrun */
+typedef struct hw_batch_t
+{
+    hdf_worktask_t task;        /* routine to run */
+    uint8      *args;           /* argument of the first task */
+    size_t      arg_size;       /* distance between the arguments */
+    intn        count;          /* number of tasks */
+    intn        next;           /* next task to take */
+    intn        done;           /* tasks finished */
+    pthread_cond_t finished;    /* signalled when the last task finishes */
+    struct hw_batch_t *next_batch;  /* next batch in the queue */
+}
+hw_batch_t;
+
+/* The pool */
+PRIVATE pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+PRIVATE pthread_cond_t pool_work = PTHREAD_COND_INITIALIZER;
+PRIVATE pthread_t pool_threads[HW_MAX_WORKERS];
+PRIVATE intn pool_size = 0;         /* worker threads running */
+PRIVATE intn pool_started = FALSE;  /* TRUE once the pool was set up */
+PRIVATE intn pool_stopping = FALSE; /* TRUE while HWshutdown runs */
+PRIVATE hw_batch_t *pool_head = NULL;   /* queue of batches */
+PRIVATE hw_batch_t *pool_tail = NULL;
+
+/* Private routines */
+PRIVATE intn HWIpool_workers
+            (void);
+
+PRIVATE void HWIstart
+            (void);
+
+PRIVATE hw_batch_t *HWItake
+            (intn *index);
+
+PRIVATE void HWIfinish
+            (hw_batch_t *batch);
+
+PRIVATE void *HWIworker
+            (void *arg);
+
+/*--------------------------------------------------------------------------
+ NAME
+    HWIpool_workers -- number of worker threads to start
+ USAGE
+    intn HWIpool_workers()
+ RETURNS
+    The number of workers to start
+ DESCRIPTION
+    One less than the number of processors online, or the number set by
+    the environment variable HDF4_NUM_WORKERS, at most HW_MAX_WORKERS.
+--------------------------------------------------------------------------*/
+PRIVATE intn
+HWIpool_workers(void)
+{
+    char       *env;
+    long        n;
+
+    if ((env = HDgetenv("HDF4_NUM_WORKERS")) != NULL)
+        n = atol(env);
+    else
+        n = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+
+    if (n < 0)
+        n = 0;
+    if (n > HW_MAX_WORKERS)
+        n = HW_MAX_WORKERS;
+    return ((intn) n);
+}   /* end HWIpool_workers() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HWIstart -- start the worker threads
+ USAGE
+    void HWIstart()
+ RETURNS
+    Nothing
+ DESCRIPTION
+    Starts the workers, with the pool lock held.  If a thread cannot be
+    created the pool runs with the ones started so far.
+--------------------------------------------------------------------------*/
+PRIVATE void
+HWIstart(void)
+{
+    intn        n;
+
+    pool_started = TRUE;
+    n = HWIpool_workers();
+    for (pool_size = 0; pool_size < n; pool_size++)
+        if (pthread_create(&pool_threads[pool_size], NULL, HWIworker, NULL) != 0)
+            break;
+}   /* end HWIstart() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HWItake -- take the next task from the queue
+ USAGE
+    hw_batch_t *HWItake(index)
+        intn *index;            OUT: index of the task in its batch
+ RETURNS
+    The batch of the task, or NULL if the queue is empty
+ DESCRIPTION
+    Called with the pool lock held.  Takes the batch off the queue once
+    its last task is taken.
+--------------------------------------------------------------------------*/
+PRIVATE hw_batch_t *
+HWItake(intn *index)
+{
+    hw_batch_t *batch = pool_head;
+
+    if (batch == NULL)
+        return (NULL);
+
+    *index = batch->next++;
+    if (batch->next == batch->count)
+      {
+          pool_head = batch->next_batch;
+          if (pool_head == NULL)
+              pool_tail = NULL;
+      }
+    return (batch);
+}   /* end HWItake() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HWIfinish -- record that a task is done
+ USAGE
+    void HWIfinish(batch)
+        hw_batch_t *batch;      IN: batch of the task
+ RETURNS
+    Nothing
+ DESCRIPTION
+    Called with the pool lock held, wakes the caller of HWrun up when
+    the last task of its batch is done.
+--------------------------------------------------------------------------*/
+PRIVATE void
+HWIfinish(hw_batch_t *batch)
+{
+    if (++batch->done == batch->count)
+        pthread_cond_signal(&batch->finished);
+}   /* end HWIfinish() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HWIworker -- body of a worker thread
+ USAGE
+    void *HWIworker(arg)
+        void *arg;              IN: unused
+ RETURNS
+    NULL
+ DESCRIPTION
+    Runs the tasks of the queue until HWshutdown stops the pool.
+--------------------------------------------------------------------------*/
+PRIVATE void *
+HWIworker(void *arg)
+{
+    hw_batch_t *batch;
+    intn        index;
+
+    (void) arg;
+    pthread_mutex_lock(&pool_lock);
+    while (!pool_stopping)
+      {
+          if ((batch = HWItake(&index)) == NULL)
+            {
+                pthread_cond_wait(&pool_work, &pool_lock);
+                continue;
+            }
+          pthread_mutex_unlock(&pool_lock);
+          (*batch->task)(batch->args + (size_t) index * batch->arg_size);
+          pthread_mutex_lock(&pool_lock);
+          HWIfinish(batch);
+      }
+    pthread_mutex_unlock(&pool_lock);
+    return (NULL);
+}   /* end HWIworker() */
+
+#endif /* H4_HAVE_THREADSAFE */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HWrun -- run a batch of tasks on the worker pool
+ USAGE
+    void HWrun(task, args, arg_size, count)
+        hdf_worktask_t task;    IN: routine to run
+        VOIDP args;             IN: array of the arguments of the tasks
+        size_t arg_size;        IN: size of an argument
+        intn count;             IN: number of tasks
+ RETURNS
+    Nothing
+ DESCRIPTION
+    Calls task on each of the count arguments in args, the first at args,
+    the next arg_size bytes further and so on, and returns when all the
+    calls have returned.  The calls run at the same time on the worker
+    threads and on the calling thread, in no particular order.  The task
+    must not call the library; it reports how it went through its
+    argument.
+--------------------------------------------------------------------------*/
+void
+HWrun(hdf_worktask_t task, VOIDP args, size_t arg_size, intn count)
+{
+    intn        i;
+#ifdef H4_HAVE_THREADSAFE
+    hw_batch_t  batch;
+    hw_batch_t *taken;
+
+    if (count > 1)
+      {
+          pthread_mutex_lock(&pool_lock);
+          if (!pool_started)
+              HWIstart();
+          if (pool_size > 0 && !pool_stopping)
+            {
+                batch.task = task;
+                batch.args = (uint8 *) args;
+                batch.arg_size = arg_size;
+                batch.count = count;
+                batch.next = 0;
+                batch.done = 0;
+                batch.next_batch = NULL;
+                pthread_cond_init(&batch.finished, NULL);
+                if (pool_tail == NULL)
+                    pool_head = &batch;
+                else
+                    pool_tail->next_batch = &batch;
+                pool_tail = &batch;
+                pthread_cond_broadcast(&pool_work);
+
+                /* work on the batch along with the workers; once its
+                   tasks are all taken the queue no longer holds it */
+                while (batch.next < batch.count)
+                  {
+                      /* batches queued before this one are ahead of it */
+                      if ((taken = HWItake(&i)) == NULL)
+                          break;
+                      pthread_mutex_unlock(&pool_lock);
+                      (*taken->task)(taken->args + (size_t) i * taken->arg_size);
+                      pthread_mutex_lock(&pool_lock);
+                      HWIfinish(taken);
+                  }
+                while (batch.done < batch.count)
+                    pthread_cond_wait(&batch.finished, &pool_lock);
+                pthread_mutex_unlock(&pool_lock);
+                pthread_cond_destroy(&batch.finished);
+                return;
+            }
+          pthread_mutex_unlock(&pool_lock);
+      }
+#endif /* H4_HAVE_THREADSAFE */
+
+    for (i = 0; i < count; i++)
+        (*task)((uint8 *) args + (size_t) i * arg_size);
+}   /* end HWrun() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HWnthreads -- number of threads a batch runs on
+ USAGE
+    intn HWnthreads()
+ RETURNS
+    The number of threads
+ DESCRIPTION
+    The workers of the pool, started or to be started by the next batch,
+    and the caller of HWrun: 1 if there is no pool.  Callers use it to
+    size batches which are only worth making to keep the workers busy.
+--------------------------------------------------------------------------*/
+intn
+HWnthreads(void)
+{
+    intn        n = 0;
+
+#ifdef H4_HAVE_THREADSAFE
+    pthread_mutex_lock(&pool_lock);
+    n = pool_started ? pool_size : HWIpool_workers();
+    pthread_mutex_unlock(&pool_lock);
+#endif /* H4_HAVE_THREADSAFE */
+    return (n + 1);
+}   /* end HWnthreads() */
+
+/*--------------------------------------------------------------------------
+ NAME
+    HWshutdown -- stop the worker threads
+ USAGE
+    intn HWshutdown()
+ RETURNS
+    SUCCEED
+ DESCRIPTION
+    Stops the workers and waits for them to exit.  A later HWrun starts
+    them again.
+--------------------------------------------------------------------------*/
+intn
+HWshutdown(void)
+{
+#ifdef H4_HAVE_THREADSAFE
+    intn        i;
+    intn        n;
+
+    pthread_mutex_lock(&pool_lock);
+    pool_stopping = TRUE;
+    n = pool_size;
+    pthread_cond_broadcast(&pool_work);
+    pthread_mutex_unlock(&pool_lock);
+
+    for (i = 0; i < n; i++)
+        pthread_join(pool_threads[i], NULL);
+
+    pthread_mutex_lock(&pool_lock);
+    pool_size = 0;
+    pool_started = FALSE;
+    pool_stopping = FALSE;
+    pthread_mutex_unlock(&pool_lock);
+#endif /* H4_HAVE_THREADSAFE */
+    return (SUCCEED);
+}   /* end HWshutdown() */
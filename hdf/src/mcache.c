@@ -73,6 +73,14 @@
 static BKT  *mcache_bkt   (MCACHE *mp);
 static BKT  *mcache_look  (MCACHE *mp, int32 pgno);
 static intn  mcache_write (MCACHE *mp, BKT *bkt);
+static intn  mcache_writev(MCACHE *mp, BKT *bkt, int32 most);
+static VOID  mcache_clean (MCACHE *mp, BKT *bkt);
+static VOID  mcache_link  (MCACHE *mp, BKT *bp);
+static VOID  mcache_unlink(MCACHE *mp, BKT *bp);
+static VOID  mcache_touch (MCACHE *mp, BKT *bp);
+static BKT  *mcache_first (struct _lqh *qh);
+static BKT  *mcache_victim(MCACHE *mp);
+static intn  mcache_trim  (MCACHE *mp);
 
 /******************************************************************************
 NAME
@@ -130,7 +138,11 @@ mcache_set_maxcache(
     int32  maxcache /* IN: max pages to cache */)
 {
     if (mp != NULL)
-      { /* currently allow the current cache to grow up */
+      { /* never more pages than the byte limit allows */
+          if (mp->maxbytes > 0 && maxcache > mp->maxbytes / mp->pagesize)
+              maxcache = mp->maxbytes / mp->pagesize > 0 ? mp->maxbytes / mp->pagesize : 1;
+
+          /* currently allow the current cache to grow up */
           if (mp->maxcache < maxcache)
               mp->maxcache = maxcache;
           else /* maxcache is less than current maxcache */
@@ -147,6 +159,117 @@ mcache_set_maxcache(
         return 0;
 } /* mcache_set_maxcache */
 
+/******************************************************************************
+NAME
+    mcache_get_maxbytes - returns the most bytes of pages to cache.
+
+DESCRIPTION
+    Finds the byte limit of the cache for object.
+
+RETURNS
+    Returns the most bytes of pages to cache, 0 if there is no limit.
+******************************************************************************/
+int32
+mcache_get_maxbytes(
+    MCACHE *mp /* IN: MCACHE cookie */)
+{
+    if (mp != NULL)
+        return mp->maxbytes;
+    else
+        return 0;
+} /* mcache_get_maxbytes */
+
+/******************************************************************************
+NAME
+    mcache_set_maxbytes - sets the most bytes of pages to cache.
+
+DESCRIPTION
+    Budgets the cache for object in bytes: it is set to cache as many
+    pages as fit in 'maxbytes', at least one, and never caches more
+    through mcache_set_maxcache(). Unlike the number of pages to cache,
+    the budget can be lowered, pages which do not fit any longer are 
+    written out if dirty and dropped, or as soon as they are put back 
+    if they are pinned. 'maxbytes' of 0 takes the limit away.
+
+RETURNS
+    Returns the number of pages to cache if successful and FAIL otherwise.
+******************************************************************************/
+int32
+mcache_set_maxbytes(
+    MCACHE *mp,     /* IN: MCACHE cookie */
+    int32  maxbytes /* IN: max bytes to cache */)
+{
+    if (mp == NULL || maxbytes < 0)
+        return FAIL;
+
+    mp->maxbytes = maxbytes;
+    if (maxbytes > 0)
+      {
+          mp->maxcache = maxbytes / mp->pagesize;
+          if (mp->maxcache < 1)
+              mp->maxcache = 1;
+          if (mcache_trim(mp) == RET_ERROR)
+              return FAIL;
+      }
+    return mp->maxcache;
+} /* mcache_set_maxbytes */
+
+/******************************************************************************
+NAME
+    mcache_get_policy - returns the eviction policy of the cache.
+
+DESCRIPTION
+    Finds which pages the cache for object gives up first.
+
+RETURNS
+    Returns MCACHE_LRU, MCACHE_2Q or MCACHE_CLOCK.
+******************************************************************************/
+intn
+mcache_get_policy(
+    MCACHE *mp /* IN: MCACHE cookie */)
+{
+    if (mp != NULL)
+        return mp->policy;
+    else
+        return MCACHE_LRU;
+} /* mcache_get_policy */
+
+/******************************************************************************
+NAME
+    mcache_set_policy - sets the eviction policy of the cache.
+
+DESCRIPTION
+    Sets which pages the cache for object gives up first when it is full,
+    see mcache.h. The pages cached so far start over on the lru chain, 
+    the ones on the hot queue as the most recently used.
+
+RETURNS
+    RET_SUCCESS if succesful and RET_ERROR otherwise
+******************************************************************************/
+intn
+mcache_set_policy(
+    MCACHE *mp,  /* IN: MCACHE cookie */
+    intn policy  /* IN: MCACHE_LRU, MCACHE_2Q or MCACHE_CLOCK */)
+{
+    BKT *bp = NULL; /* bucket element */
+
+    if (mp == NULL 
+        || (policy != MCACHE_LRU && policy != MCACHE_2Q && policy != MCACHE_CLOCK))
+        return RET_ERROR;
+
+    while ((bp = mp->aqh.cqh_first) != (VOID *)&mp->aqh)
+      {
+          CIRCLEQ_REMOVE(&mp->aqh, bp, q);
+          CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+      }
+    for (bp = mp->lqh.cqh_first; bp != (VOID *)&mp->lqh; bp = bp->q.cqe_next)
+        bp->flags &= ~(MCACHE_HOT | MCACHE_REF);
+    mp->nhot = 0;
+    mp->policy = policy;
+
+    return RET_SUCCESS;
+} /* mcache_set_policy */
+
 /******************************************************************************
 NAME
     mcache_get_pagsize - returns pagesize for object
@@ -199,6 +322,8 @@ mcache_open(
     intn          ret_value   = RET_SUCCESS;
     intn          entry;         /* index into hash table */
     int32         pageno;
+    char         *env;
+    long          bytes;         /* byte limit from the environment */
 
     /* shut compiler up */
     key=key;
@@ -214,6 +339,7 @@ mcache_open(
         HGOTO_ERROR(DFE_NOSPACE, FAIL);
 
     CIRCLEQ_INIT(&mp->lqh);
+    CIRCLEQ_INIT(&mp->aqh);
     for (entry = 0; entry < HASHSIZE; ++entry)
       {
           CIRCLEQ_INIT(&mp->hqh[entry]);
@@ -229,6 +355,25 @@ mcache_open(
     mp->object_id = object_id;
     mp->object_size = pagesize * npages;
 
+    /* The byte limit and eviction policy the environment sets for all
+       caches, if any */
+    mp->policy = MCACHE_LRU;
+    if ((env = HDgetenv(MCACHE_BYTES_ENV)) != NULL
+        && (bytes = HDstrtol(env, NULL, 10)) > 0)
+      {
+          /* more than an int32 holds is as good as no limit */
+          mp->maxbytes = (int32)(bytes > (long)INT_MAX ? INT_MAX : bytes);
+          if (mp->maxcache > mp->maxbytes / pagesize)
+              mp->maxcache = mp->maxbytes / pagesize > 0 ? mp->maxbytes / pagesize : 1;
+      }
+    if ((env = HDgetenv(MCACHE_POLICY_ENV)) != NULL)
+      {
+          if (HDstrcmp(env, "2q") == 0 || HDstrcmp(env, "2Q") == 0)
+              mp->policy = MCACHE_2Q;
+          else if (HDstrcmp(env, "clock") == 0 || HDstrcmp(env, "CLOCK") == 0)
+              mp->policy = MCACHE_CLOCK;
+      }
+
     /* Initialize list hash chain */
     for (pageno = 1; pageno <= mp->npages; ++pageno)
       {
@@ -254,6 +399,8 @@ mcache_open(
     /* initialize input/output filters and cookie to NULL */
     mp->pgin     = NULL;
     mp->pgout    = NULL;        
+    mp->pginv    = NULL;
+    mp->pgoutv   = NULL;
     mp->pgcookie = NULL;        
 #ifdef STATISTICS
     mp->listhit    = 0;
@@ -325,6 +472,32 @@ mcache_filter(
     mp->pgcookie = pgcookie;
 } /* mcache_filter() */
 
+/******************************************************************************
+NAME
+   mcache_filterv -- Initialize the batch input and output filters.
+
+DESCRIPTION
+   Initialize the filter mcache_getv uses to read in the pages it
+   needs all at once, and the one which writes out several dirty pages
+   together, when the cache gives up a dirty page or is synced. Without
+   them the pages are read and written one at a time through the
+   filters set by mcache_filter(), which are also given the cookie for
+   these ones.  Either may be NULL.
+
+RETURNS
+   Nothing
+
+******************************************************************************/
+VOID
+mcache_filterv( 
+    MCACHE *mp,                                            /* IN: MCACHE cookie */
+    int32 (*pginv) (VOID * /* cookie */, int32 /* npages */, const int32 * /* pgnos */, VOID ** /* pages */),  /* IN: batch page in filter */
+    int32 (*pgoutv) (VOID * /* cookie */, int32 /* npages */, const int32 * /* pgnos */, VOID ** /* pages */)  /* IN: batch page out filter */)
+{
+    mp->pginv    = pginv;
+    mp->pgoutv   = pgoutv;
+} /* mcache_filterv() */
+
 #if 0 /* NOT USED YET */
 /******************************************************************************
 NAME
@@ -477,7 +650,6 @@ mcache_get(
     int32  flags /* IN: XXX not used? */)
 {
     CONSTR(FUNC, "mcache_get");   /* for HERROR */
-    struct _hqh  *head  = NULL; /* head of lru queue */
     struct _lhqh *lhead = NULL; /* head of an entry in list hash chain */
     BKT          *bp   = NULL;  /* bucket element */
     L_ELEM       *lp   = NULL;
@@ -518,14 +690,10 @@ mcache_get(
             }
 #endif
           /*
-           * Move the page to the head of the hash chain and the tail
-           * of the lru chain.
+           * Move the page to the head of the hash chain and where the
+           * eviction policy puts pages used again.
            */
-          head = &mp->hqh[HASHKEY(bp->pgno)];
-          CIRCLEQ_REMOVE(head, bp, hq);
-          CIRCLEQ_INSERT_HEAD(head, bp, hq);
-          CIRCLEQ_REMOVE(&mp->lqh, bp, q);
-          CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+          mcache_touch(mp, bp);
           /* Return a pinned page. */
           bp->flags |= MCACHE_PINNED;
 
@@ -634,9 +802,7 @@ mcache_get(
      * Add the page to the head of the hash chain and the tail
      * of the lru chain.
      */
-    head = &mp->hqh[HASHKEY(bp->pgno)];
-    CIRCLEQ_INSERT_HEAD(head, bp, hq);
-    CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+    mcache_link(mp, bp);
 
   done:
     if(ret_value == RET_ERROR)
@@ -655,6 +821,216 @@ mcache_get(
     return (bp->page);
 } /* mcache_get() */
 
+/******************************************************************************
+NAME
+   mcache_getv - get several pages by page number.
+
+DESCRIPTION
+    Get the 'npages' pages specified by 'pgnos', which must all differ,
+    as mcache_get() would one after the other, except that the pages
+    which have to be read in are read in by a single call to the batch
+    page in filter, if there is one. That lets the filter work on the
+    pages at the same time. All returned pages are pinned, each has to
+    be put back with mcache_put().
+
+    'npages' should not be more than the number of pages the cache
+    holds, the cache grows to hold all of them otherwise.
+
+RETURNS
+   RET_SUCCESS if succesful and RET_ERROR otherwise, in which case no
+   page is left pinned
+******************************************************************************/
+intn
+mcache_getv( 
+    MCACHE      *mp,     /* IN: MCACHE cookie */
+    int32       npages,  /* IN: number of pages */
+    const int32 *pgnos,  /* IN: page numbers */
+    VOID        **pages  /* OUT: the pages */)
+{
+    CONSTR(FUNC, "mcache_getv");   /* for HERROR */
+    struct _lhqh *lhead = NULL; /* head of an entry in list hash chain */
+    BKT          *bp   = NULL;  /* bucket element */
+    L_ELEM       *lp   = NULL;
+    BKT         **bps  = NULL;  /* buckets of the pages */
+    BKT         **newbps = NULL; /* buckets of the pages not cached */
+    int32        *rpgnos = NULL; /* pages to read in, 0 based */
+    VOID        **rpages = NULL; /* where to read them */
+    int32         ngot  = 0;    /* number of pages pinned */
+    int32         nnew  = 0;    /* number of pages not cached */
+    int32         nread = 0;    /* number of pages to read in */
+    int32         pgno;
+    int32         i;
+    intn          ret_value = RET_SUCCESS;
+
+    /* check inputs */
+    if (mp == NULL || npages < 0 || (npages > 0 && (pgnos == NULL || pages == NULL)))
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+    if (npages == 0)
+        goto done;
+
+    if ((bps = (BKT **)HDmalloc(2 * (uint32)npages * sizeof(BKT *))) == NULL
+        || (rpgnos = (int32 *)HDmalloc((uint32)npages * sizeof(int32))) == NULL
+        || (rpages = (VOID **)HDmalloc((uint32)npages * sizeof(VOID *))) == NULL)
+        HGOTO_ERROR(DFE_NOSPACE, FAIL);
+    newbps = bps + npages;
+
+    for (i = 0; i < npages; i++)
+      {
+          pgno = pgnos[i];
+
+          /* Check for attempting to retrieve a non-existent page. 
+           *  remember pages go from 1 ->npages  */
+          if (pgno > mp->npages) 
+              HE_REPORT_GOTO("attempting to get a non existant page from cache", FAIL);
+
+#ifdef STATISTICS
+          ++mp->pageget;
+#endif
+          /* Check for a page that is cached, pin it as mcache_get() does */
+          if ((bp = mcache_look(mp, pgno)) != NULL) 
+            {
+                mcache_touch(mp, bp);
+                bp->flags |= MCACHE_PINNED;
+                bps[ngot++] = bp;
+                pages[i] = bp->page;
+                continue;
+            } /* end if bp */
+
+          /* Page not cached so get a page from the cache to use or
+           * create one. It goes on the hash and lru chains once it
+           * is read in. */
+          if ((bp = mcache_bkt(mp)) == NULL)
+              HE_REPORT_GOTO("unable to get a new page from bucket", FAIL);
+          bp->pgno = pgno;
+          bp->flags = MCACHE_PINNED;
+          bps[ngot++] = newbps[nnew++] = bp;
+          pages[i] = bp->page;
+
+          /* Check to see if this page has ever been referenced */
+          lhead = &mp->lhqh[HASHKEY(pgno)];
+          for (lp = lhead->cqh_first; lp != (VOID *)lhead; lp = lp->hl.cqe_next)
+              if (lp->pgno == pgno && lp->eflags != 0)
+                  break;
+
+          if (lp != (VOID *)lhead)
+            { /* list hit, need to read page */
+#ifdef STATISTICS
+                ++mp->listhit;
+                ++lp->elemhit;
+                ++mp->pageread;
+#endif
+                lp->eflags = ELEM_READ; /* Indiate we are reading this page */
+                /* Note page numbers in HMCPxxx are 0 based not 1 based */
+                rpgnos[nread] = pgno - 1;
+                rpages[nread++] = bp->page;
+            }
+          else
+            { /* NO hit, new list element 
+               * no need to read this page from disk */
+                if ((lp = (L_ELEM *)HDmalloc(sizeof(L_ELEM))) == NULL)
+                    HGOTO_ERROR(DFE_NOSPACE, FAIL);
+
+                lp->pgno = pgno;
+                lp->eflags = 0;
+#ifdef STATISTICS
+                ++mp->listalloc;
+                lp->elemhit =1;
+#endif
+                CIRCLEQ_INSERT_HEAD(lhead, lp, hl); /* add to list */
+            } /*end else */
+      } /* end for i */
+
+    /* Run the pages to read in through the user's filter. */
+    if (nread > 0)
+      {
+          if (mp->pginv != NULL)
+            {
+                if (((mp->pginv)(mp->pgcookie, nread, rpgnos, rpages)) == FAIL)
+                  {
+                      HEreport("mcache_getv: error reading %d chunks\n",(intn)nread);
+                      ret_value = RET_ERROR;
+                      goto done;
+                  }
+            }
+          else if (mp->pgin != NULL)
+            {
+                for (i = 0; i < nread; i++)
+                    if (((mp->pgin)(mp->pgcookie, rpgnos[i], rpages[i])) == FAIL)
+                      {
+                          HEreport("mcache_getv: error reading chunk=%d\n",(intn)rpgnos[i]);
+                          ret_value = RET_ERROR;
+                          goto done;
+                      }
+            }
+          else
+            {
+                HEreport("mcache_getv: reading fcn not set,chunk=%d\n",(intn)rpgnos[0]);
+                ret_value = RET_ERROR;
+                goto done;
+            }
+      } /* end if nread */
+
+    /*
+     * Add the new pages to the head of the hash chain and the tail
+     * of the lru chain.
+     */
+    for (i = 0; i < nnew; i++)
+        mcache_link(mp, newbps[i]);
+
+  done:
+    if(ret_value == RET_ERROR)
+      { /* error cleanup */
+          /* unpin the pages, drop the ones not cached */
+          for (i = 0; i < ngot; i++)
+              bps[i]->flags &= ~MCACHE_PINNED;
+          for (i = 0; i < nnew; i++)
+            {
+                HDfree(newbps[i]);
+                --mp->curcache;
+            }
+      }
+    /* Normal cleanup */
+    if (bps != NULL)
+        HDfree(bps);
+    if (rpgnos != NULL)
+        HDfree(rpgnos);
+    if (rpages != NULL)
+        HDfree(rpages);
+
+    return ret_value;
+} /* mcache_getv() */
+
+/******************************************************************************
+NAME
+   mcache_cached - tell whether a page is cached
+
+DESCRIPTION
+    Looks for the page specified by 'pgno' in the cache, without getting
+    it. A page which is not cached can be read or written without the 
+    cache, the cache holds no other copy of it.
+
+RETURNS
+   TRUE if the page is cached and FALSE otherwise
+******************************************************************************/
+intn
+mcache_cached( 
+    MCACHE *mp,  /* IN: MCACHE cookie */
+    int32  pgno  /* IN: page number */)
+{
+    struct _hqh  *head  = NULL; /* head of hash chain */
+    BKT          *bp   = NULL;  /* bucket element */
+
+    if (mp == NULL)
+        return FALSE;
+
+    head = &mp->hqh[HASHKEY(pgno)];
+    for (bp = head->cqh_first; bp != (VOID *)head; bp = bp->hq.cqe_next)
+        if (bp->pgno == pgno) 
+            return TRUE;
+
+    return FALSE;
+} /* mcache_cached() */
+
 /******************************************************************************
 NAME
    mcache_put -- put a page back into the memory buffer pool
@@ -715,6 +1091,10 @@ mcache_put(
                 } /* end if lp->pgno */
       }
 
+    /* the cache grew past its limit while its pages were all pinned */
+    if (mp->curcache > mp->maxcache && mcache_trim(mp) == RET_ERROR)
+        HE_REPORT_GOTO("unable to flush a dirty page", FAIL);
+
   done:
     if(ret_value == RET_ERROR)
       { /* error cleanup */
@@ -760,6 +1140,11 @@ mcache_close(
           CIRCLEQ_REMOVE(&mp->lqh, mp->lqh.cqh_first, q);
           HDfree(bp);
       }
+    while ((bp = mp->aqh.cqh_first) != (VOID *)&mp->aqh) 
+      {
+          CIRCLEQ_REMOVE(&mp->aqh, mp->aqh.cqh_first, q);
+          HDfree(bp);
+      }
 
     /* free up list elements */
     for (entry = 0; entry < HASHSIZE; ++entry)
@@ -803,7 +1188,7 @@ mcache_sync(
     MCACHE *mp /* IN: MCACHE cookie */)
 {
     CONSTR(FUNC, "mcache_sync");   /* for HERROR */
-    BKT *bp = NULL; /* bucket element */
+    intn nwritten;  /* pages written by a batch */
     intn ret_value = RET_SUCCESS;
 
 #ifdef MCACHE_DEBUG
@@ -813,12 +1198,12 @@ mcache_sync(
     if (mp == NULL)
         HGOTO_ERROR(DFE_ARGS, FAIL);
 
-    /* Walk the lru chain, flushing any dirty pages to disk. */
-    for (bp = mp->lqh.cqh_first; bp != (VOID *)&mp->lqh; bp = bp->q.cqe_next)
-      {
-          if (bp->flags & MCACHE_DIRTY && mcache_write(mp, bp) == RET_ERROR)
-              HE_REPORT_GOTO("unable to flush a dirty page", FAIL);
-      } /* end for bp */
+    /* Walk the lru chain and the hot queue, flushing the dirty pages to 
+       disk a batch at a time until none is left. */
+    while ((nwritten = mcache_writev(mp, NULL, MCACHE_WRITE_BATCH)) > 0)
+        ;
+    if (nwritten == RET_ERROR)
+        HE_REPORT_GOTO("unable to flush a dirty page", FAIL);
 
   done:
     if(ret_value == RET_ERROR)
@@ -981,7 +1366,6 @@ mcache_bkt(
     MCACHE *mp  /* IN: MCACHE cookie */)
 {
     CONSTR(FUNC, "mcache_bkt");   /* for HERROR */
-    struct _hqh *head = NULL;  /* head of hash chain */
     BKT         *bp   = NULL;  /* bucket element */
     intn         ret_value  = RET_SUCCESS;
 
@@ -994,34 +1378,37 @@ mcache_bkt(
         goto new;
 
     /*
-     * If the cache is max'd out, walk the lru list for a buffer we
-     * can flush.  If we find one, write it (if necessary) and take it
-     * off any lists.  If we don't find anything we grow the cache anyway.
-     * The cache never shrinks.
+     * If the cache is max'd out, ask the eviction policy for a buffer we
+     * can flush.  If we get one, write it (if necessary, along with as
+     * many of the dirty pages to be given up next as the worker pool can
+     * write at the same time) and take it off any lists.  If we don't
+     * find anything we grow the cache anyway.  The cache only shrinks
+     * through mcache_trim().
      */
-    for (bp = mp->lqh.cqh_first; bp != (VOID *)&mp->lqh; bp = bp->q.cqe_next)
-        if (!(bp->flags & MCACHE_PINNED)) 
-          { /* Flush if dirty. */
-              if (bp->flags & MCACHE_DIRTY  && mcache_write(mp, bp) == RET_ERROR)
-                  HE_REPORT_GOTO("unable to flush a dirty page", FAIL);
+    if ((bp = mcache_victim(mp)) != NULL)
+      { /* Flush if dirty. */
+          if (bp->flags & MCACHE_DIRTY  
+              && mcache_writev(mp, bp, HWnthreads()) == RET_ERROR)
+            {
+                bp = NULL; /* still cached, don't free it */
+                HE_REPORT_GOTO("unable to flush a dirty page", FAIL);
+            }
 #ifdef STATISTICS
-              ++mp->pageflush;
+          ++mp->pageflush;
 #endif
-              /* Remove from the hash and lru queues. */
-              head = &mp->hqh[HASHKEY(bp->pgno)];
-              CIRCLEQ_REMOVE(head, bp, hq);
-              CIRCLEQ_REMOVE(&mp->lqh, bp, q);
+          /* Remove from the hash and lru queues. */
+          mcache_unlink(mp, bp);
 #ifdef MCACHE_DEBUG
-              { VOID *spage;
-              spage = bp->page;
-              memset(bp, 0xff, sizeof(BKT) + mp->pagesize);
-              bp->page = spage;
-              }
+          { VOID *spage;
+          spage = bp->page;
+          memset(bp, 0xff, sizeof(BKT) + mp->pagesize);
+          bp->page = spage;
+          }
 #endif
-              /* done */
-              ret_value = RET_SUCCESS;
-              goto done;
-          } /* end if bp->flags */
+          /* done */
+          ret_value = RET_SUCCESS;
+          goto done;
+      } /* end if bp */
 
     /* create a new page */
   new: if ((bp = (BKT *)HDmalloc(sizeof(BKT) + (uintn)mp->pagesize)) == NULL)
@@ -1068,8 +1455,6 @@ mcache_write(
     BKT *bp     /* IN: bucket element */)
 {
     CONSTR(FUNC, "mcache_write");   /* for HERROR */
-    struct _lhqh *lhead = NULL; /* head of an entry in list hash chain */
-    L_ELEM       *lp   = NULL;
     intn          ret_value = RET_SUCCESS;
 #ifdef UNUSED
     int32         wpagesize;  /* page size to write */
@@ -1087,19 +1472,6 @@ mcache_write(
     ++mp->pagewrite;
 #endif
 
-    /* update this page reference */
-    lhead = &mp->lhqh[HASHKEY(bp->pgno)];
-    for (lp = lhead->cqh_first; lp != (VOID *)lhead; lp = lp->hl.cqe_next)
-        if (lp->pgno == bp->pgno)
-          { /* hit */
-#ifdef STATISTICS
-              ++mp->listhit;
-              ++lp->elemhit;
-#endif
-              lp->eflags = ELEM_SYNC;
-              break;
-          }
-
     /* Run page through the user's filter.
        we use this to write the data chunk/page out.
        This deviates from the orignal purpose of the filter. */
@@ -1128,7 +1500,7 @@ mcache_write(
 #endif /* UNUSED */
 
     /* mark page as clean */
-    bp->flags &= ~MCACHE_DIRTY;
+    mcache_clean(mp, bp);
 
   done:
     if(ret_value == RET_ERROR)
@@ -1146,6 +1518,127 @@ mcache_write(
     return ret_value;
 } /* mcache_write() */
 
+/******************************************************************************
+NAME
+   mcache_writev - write several dirty pages to disk together.
+
+DESCRIPTION
+   Private routine. Writes out the page 'bp', if given, along with the
+   other dirty pages of the cache, at most 'most' pages (at least 'bp'
+   and no more than MCACHE_WRITE_BATCH) in one call of the batch page
+   out filter.  Along with a page being given up only pages which are
+   not pinned are written, they are the ones the cache will give up
+   next.  Without a batch filter the pages are written one at a time.
+
+RETURNS
+   The number of pages written if succesful and RET_ERROR otherwise    
+******************************************************************************/
+static intn
+mcache_writev(
+    MCACHE *mp, /* IN: MCACHE cookie */
+    BKT *bp,    /* IN: bucket element to write, or NULL */
+    int32 most  /* IN: most pages to write */)
+{
+    CONSTR(FUNC, "mcache_writev");   /* for HERROR */
+    BKT          *bps[MCACHE_WRITE_BATCH];   /* the pages to write */
+    int32         pgnos[MCACHE_WRITE_BATCH]; /* their numbers, 0 based */
+    VOID         *pages[MCACHE_WRITE_BATCH]; /* their data */
+    struct _lqh  *qh;      /* queue walked */
+    BKT          *qp;      /* bucket element of the queue */
+    intn          npages = 0;
+    intn          i;
+    intn          ret_value = RET_SUCCESS;
+
+    /* check inputs */
+    if (mp == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    if (most > MCACHE_WRITE_BATCH)
+        most = MCACHE_WRITE_BATCH;
+    if (most < 1)
+        most = 1;
+
+    if (bp != NULL)
+        bps[npages++] = bp;
+    for (qh = &mp->lqh; npages < most; qh = &mp->aqh)
+      {
+          for (qp = qh->cqh_first; qp != (VOID *)qh && npages < most; qp = qp->q.cqe_next)
+              if (qp != bp && qp->flags & MCACHE_DIRTY 
+                  && (bp == NULL || !(qp->flags & MCACHE_PINNED)))
+                  bps[npages++] = qp;
+          if (qh == &mp->aqh)
+              break;
+      }
+
+    if (mp->pgoutv == NULL || npages <= 1)
+      {
+          for (i = 0; i < npages; i++)
+              if (mcache_write(mp, bps[i]) == RET_ERROR)
+                  HGOTO_ERROR(DFE_WRITEERROR, FAIL);
+          HGOTO_DONE(npages);
+      }
+
+    /* Note page numbers in HMCPxxx are 0 based not 1 based */
+    for (i = 0; i < npages; i++)
+      {
+          pgnos[i] = bps[i]->pgno - 1;
+          pages[i] = bps[i]->page;
+      }
+    if (((mp->pgoutv)(mp->pgcookie, (int32)npages, pgnos, pages)) == FAIL)
+      {
+          HEreport("mcache_writev: error writing %d chunks\n",npages);
+          ret_value = RET_ERROR;
+          goto done;
+      }
+
+    for (i = 0; i < npages; i++)
+      {
+#ifdef STATISTICS
+          ++mp->pagewrite;
+#endif
+          mcache_clean(mp, bps[i]);
+      }
+    ret_value = npages;
+
+  done:
+    return ret_value;
+} /* mcache_writev() */
+
+/******************************************************************************
+NAME
+   mcache_clean - mark a page written out as clean.
+
+DESCRIPTION
+   Private routine. Clears the dirty flag of a page just written and
+   records in the list of pages that the page is on disk.
+
+RETURNS
+   Nothing
+******************************************************************************/
+static VOID
+mcache_clean(
+    MCACHE *mp, /* IN: MCACHE cookie */
+    BKT *bp     /* IN: bucket element */)
+{
+    struct _lhqh *lhead = NULL; /* head of an entry in list hash chain */
+    L_ELEM       *lp   = NULL;
+
+    /* update this page reference */
+    lhead = &mp->lhqh[HASHKEY(bp->pgno)];
+    for (lp = lhead->cqh_first; lp != (VOID *)lhead; lp = lp->hl.cqe_next)
+        if (lp->pgno == bp->pgno)
+          { /* hit */
+#ifdef STATISTICS
+              ++mp->listhit;
+              ++lp->elemhit;
+#endif
+              lp->eflags = ELEM_SYNC;
+              break;
+          }
+
+    bp->flags &= ~MCACHE_DIRTY;
+} /* mcache_clean() */
+
 /******************************************************************************
 NAME
    mcache_look - lookup a page in the cache.
@@ -1204,6 +1697,222 @@ mcache_look(
     return (bp);
 } /* mcache_look() */
 
+/******************************************************************************
+NAME
+   mcache_link - put a new page on the cache's chains.
+
+DESCRIPTION
+   Private routine. Adds a page to the head of its hash chain and the
+   tail of the lru chain, which is the cold queue for 2Q and just behind
+   the clock hand for CLOCK.
+
+RETURNS
+   Nothing
+******************************************************************************/
+static VOID
+mcache_link(
+    MCACHE *mp, /* IN: MCACHE cookie */
+    BKT *bp     /* IN: bucket element */)
+{
+    struct _hqh *head = &mp->hqh[HASHKEY(bp->pgno)]; /* head of hash chain */
+
+    bp->flags &= ~(MCACHE_HOT | MCACHE_REF);
+    CIRCLEQ_INSERT_HEAD(head, bp, hq);
+    CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+} /* mcache_link() */
+
+/******************************************************************************
+NAME
+   mcache_unlink - take a page off the cache's chains.
+
+DESCRIPTION
+   Private routine. Removes a page from its hash chain and from the lru
+   chain or the hot queue, whichever it is on.
+
+RETURNS
+   Nothing
+******************************************************************************/
+static VOID
+mcache_unlink(
+    MCACHE *mp, /* IN: MCACHE cookie */
+    BKT *bp     /* IN: bucket element */)
+{
+    struct _hqh *head = &mp->hqh[HASHKEY(bp->pgno)]; /* head of hash chain */
+
+    CIRCLEQ_REMOVE(head, bp, hq);
+    if (bp->flags & MCACHE_HOT)
+      {
+          CIRCLEQ_REMOVE(&mp->aqh, bp, q);
+          --mp->nhot;
+      }
+    else
+      {
+          CIRCLEQ_REMOVE(&mp->lqh, bp, q);
+      }
+} /* mcache_unlink() */
+
+/******************************************************************************
+NAME
+   mcache_touch - note that a cached page is used again.
+
+DESCRIPTION
+   Private routine. Moves the page to the head of its hash chain, and 
+   then as the eviction policy wants it: LRU moves it to the tail of the
+   lru chain, 2Q to the tail of the hot queue and CLOCK only marks it as
+   used.
+
+RETURNS
+   Nothing
+******************************************************************************/
+static VOID
+mcache_touch(
+    MCACHE *mp, /* IN: MCACHE cookie */
+    BKT *bp     /* IN: bucket element */)
+{
+    struct _hqh *head = &mp->hqh[HASHKEY(bp->pgno)]; /* head of hash chain */
+
+    CIRCLEQ_REMOVE(head, bp, hq);
+    CIRCLEQ_INSERT_HEAD(head, bp, hq);
+
+    switch (mp->policy)
+      {
+      case MCACHE_2Q:
+          if (bp->flags & MCACHE_HOT)
+            {
+                CIRCLEQ_REMOVE(&mp->aqh, bp, q);
+            }
+          else
+            { /* used again, it's hot */
+                CIRCLEQ_REMOVE(&mp->lqh, bp, q);
+                bp->flags |= MCACHE_HOT;
+                ++mp->nhot;
+            }
+          CIRCLEQ_INSERT_TAIL(&mp->aqh, bp, q);
+          break;
+
+      case MCACHE_CLOCK:
+          bp->flags |= MCACHE_REF;
+          break;
+
+      default: /* MCACHE_LRU */
+          CIRCLEQ_REMOVE(&mp->lqh, bp, q);
+          CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+          break;
+      }
+} /* mcache_touch() */
+
+/******************************************************************************
+NAME
+   mcache_first - first page of a queue which is not pinned.
+
+DESCRIPTION
+   Private routine. Walks the lru chain or the hot queue from its head
+   for a page which is not pinned.
+
+RETURNS
+   The page if there is one and NULL otherwise.
+******************************************************************************/
+static BKT *
+mcache_first(
+    struct _lqh *qh /* IN: head of the queue */)
+{
+    BKT *bp = NULL; /* bucket element */
+
+    for (bp = qh->cqh_first; bp != (VOID *)qh; bp = bp->q.cqe_next)
+        if (!(bp->flags & MCACHE_PINNED)) 
+            return bp;
+    return NULL;
+} /* mcache_first() */
+
+/******************************************************************************
+NAME
+   mcache_victim - choose the page to give up.
+
+DESCRIPTION
+   Private routine. Chooses the cached page to give up for another one, 
+   as the eviction policy wants it, among the pages which are not pinned.
+   The page stays on the chains.
+
+RETURNS
+   The page if there is one and NULL otherwise.
+******************************************************************************/
+static BKT *
+mcache_victim(
+    MCACHE *mp /* IN: MCACHE cookie */)
+{
+    BKT   *bp = NULL; /* bucket element */
+    int32  sweep;     /* pages the clock hand passed */
+
+    switch (mp->policy)
+      {
+      case MCACHE_2Q:
+          /* the cold queue gives up pages once it has more than its share
+             of a quarter of the cache, the hot queue otherwise */
+          if (mp->curcache - mp->nhot > mp->maxcache / 4)
+            {
+                if ((bp = mcache_first(&mp->lqh)) == NULL)
+                    bp = mcache_first(&mp->aqh);
+            }
+          else if ((bp = mcache_first(&mp->aqh)) == NULL)
+              bp = mcache_first(&mp->lqh);
+          return bp;
+
+      case MCACHE_CLOCK:
+          /* the hand is at the head of the ring, it passes the pages used
+             since it last came by, and the pinned ones, to the tail */
+          for (sweep = 0; sweep <= 2 * mp->curcache; sweep++)
+            {
+                if ((bp = mp->lqh.cqh_first) == (VOID *)&mp->lqh)
+                    break;
+                if (!(bp->flags & (MCACHE_PINNED | MCACHE_REF)))
+                    return bp;
+                bp->flags &= ~MCACHE_REF;
+                CIRCLEQ_REMOVE(&mp->lqh, bp, q);
+                CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+            }
+          return NULL;
+
+      default: /* MCACHE_LRU */
+          return mcache_first(&mp->lqh);
+      }
+} /* mcache_victim() */
+
+/******************************************************************************
+NAME
+   mcache_trim - shrink the cache to its limit.
+
+DESCRIPTION
+   Private routine. Gives up pages, as the eviction policy chooses them,
+   until the cache holds no more than 'maxcache' pages or all the pages 
+   left are pinned. Dirty pages are written out first.
+
+RETURNS
+   RET_SUCCESS if succesful and RET_ERROR otherwise    
+******************************************************************************/
+static intn
+mcache_trim(
+    MCACHE *mp /* IN: MCACHE cookie */)
+{
+    BKT  *bp = NULL; /* bucket element */
+    intn  ret_value = RET_SUCCESS;
+
+    while (mp->curcache > mp->maxcache && (bp = mcache_victim(mp)) != NULL)
+      {
+          if (bp->flags & MCACHE_DIRTY  
+              && mcache_writev(mp, bp, mp->curcache - mp->maxcache) == RET_ERROR)
+              HE_REPORT_GOTO("unable to flush a dirty page", FAIL);
+#ifdef STATISTICS
+          ++mp->pageflush;
+#endif
+          mcache_unlink(mp, bp);
+          HDfree(bp);
+          --mp->curcache;
+      }
+
+  done:
+    return ret_value;
+} /* mcache_trim() */
+
 #ifdef STATISTICS
 #ifdef HAVE_GETRUSAGE
 /******************************************************************************
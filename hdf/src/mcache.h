@@ -73,6 +73,15 @@
  * are threaded on a hash chain (hashed by page number) and an lru chain.
  * (Inactive pages are threaded on a free chain?).  Each reference to a memory
  * pool is handed an opaque MPOOL cookie which stores all of this information.
+ *
+ * Which page the cache gives up when it is full depends on its eviction
+ * policy.  LRU takes the page used least recently.  2Q puts new pages on
+ * a cold queue and moves them to a hot queue when they are used again,
+ * the cold queue gives up its pages first once it holds more than a
+ * quarter of the cache, so that a long scan only cycles through the
+ * cold queue.  CLOCK sweeps the lru chain as a ring and passes over the
+ * pages used since its last sweep.  The cache holds at most 'maxcache'
+ * pages, and no more than 'maxbytes' bytes of pages if that is set.
  */
 
 /* Current Hash table size. Page numbers start with 1
@@ -86,6 +95,18 @@
 
 #define MAX_PAGE_NUMBER 0xffffffff  /* >= # of pages in a object */
 
+/* Eviction policies, which page goes when the cache is full */
+#define MCACHE_LRU    0   /* the least recently used page */
+#define MCACHE_2Q     1   /* pages used once before pages used again */
+#define MCACHE_CLOCK  2   /* pages not used since the clock last passed */
+
+/* Most dirty pages written out together */
+#define MCACHE_WRITE_BATCH  64
+
+/* Environment variables setting the defaults of every cache */
+#define MCACHE_BYTES_ENV   "HDF4_CHUNK_CACHE_BYTES"  /* most bytes to cache */
+#define MCACHE_POLICY_ENV  "HDF4_CHUNK_CACHE_POLICY" /* lru, 2q or clock */
+
 /* The BKT structures are the elements of the queues. */
 typedef struct _bkt
 {
@@ -95,6 +116,8 @@ typedef struct _bkt
   int32   pgno;             /* page number */
 #define    MCACHE_DIRTY  0x01  /* page needs to be written */
 #define    MCACHE_PINNED 0x02  /* page is pinned into memory */
+#define    MCACHE_HOT    0x04  /* page is on the hot queue (2Q) */
+#define    MCACHE_REF    0x08  /* page used since the clock passed it */
   uint8   flags;            /* flags */
 } BKT;
 
@@ -118,11 +141,16 @@ typedef struct _lelem
 /* Memory pool cache */
 typedef struct MCACHE
 {
-  CIRCLEQ_HEAD(_lqh, _bkt)    lqh;          /* lru queue head */
+  CIRCLEQ_HEAD(_lqh, _bkt)    lqh;          /* lru queue head, the cold
+                                               queue of 2Q, the clock ring */
+  struct _lqh                 aqh;          /* hot queue head (2Q) */
   CIRCLEQ_HEAD(_hqh, _bkt)    hqh[HASHSIZE];  /* hash queue array */
   CIRCLEQ_HEAD(_lhqh, _lelem) lhqh[HASHSIZE]; /* hash of all elements */
   int32    curcache;              /* current num of cached pages */
   int32    maxcache;              /* max number of cached pages */
+  int32    maxbytes;              /* max bytes of cached pages, 0 = no limit */
+  int32    nhot;                  /* number of pages on the hot queue */
+  intn     policy;                /* eviction policy, MCACHE_LRU... */
   int32    npages;                  /* number of pages in the object */
   int32    pagesize;              /* cache page size */
   int32 object_id;            /* access ID of object this cache is for */
@@ -130,6 +158,8 @@ typedef struct MCACHE
                                  must be multiple of pagesize for now */
   int32 (*pgin) (VOID *cookie, int32 pgno, VOID *page); /* page in conversion routine */
   int32 (*pgout) (VOID *cookie, int32 pgno, const VOID *page);/* page out conversion routine*/
+  int32 (*pginv) (VOID *cookie, int32 npages, const int32 *pgnos, VOID **pages);/* batch page in routine */
+  int32 (*pgoutv) (VOID *cookie, int32 npages, const int32 *pgnos, VOID **pages);/* batch page out routine */
   VOID    *pgcookie;                         /* cookie for page in/out routines */
 #ifdef STATISTICS
   int32    listhit;                /* # of list hits */
@@ -165,6 +195,11 @@ HDFLIBAPI VOID     mcache_filter (
     int32 (*pgout)(VOID *cookie, int32 pgno, const VOID *page) , /* IN: page out filter */
     VOID *pgcookie          /* IN: filter cookie */);
 
+HDFLIBAPI VOID     mcache_filterv (
+    MCACHE *mp,             /* IN: MCACHE cookie */
+    int32 (*pginv)(VOID *cookie, int32 npages, const int32 *pgnos, VOID **pages), /* IN: batch page in filter */
+    int32 (*pgoutv)(VOID *cookie, int32 npages, const int32 *pgnos, VOID **pages) /* IN: batch page out filter */);
+
 HDFLIBAPI VOID    *mcache_new (
     MCACHE *mp,      /* IN: MCACHE cookie */
     int32 *pgnoaddr, /* IN/OUT: address of newly create page */
@@ -176,6 +211,16 @@ HDFLIBAPI VOID    *mcache_get (
     int32 pgno, /* IN: page number */
     int32 flags /* IN: XXX not used? */);
 
+HDFLIBAPI intn     mcache_getv (
+    MCACHE *mp,    /* IN: MCACHE cookie */
+    int32 npages,  /* IN: number of pages */
+    const int32 *pgnos, /* IN: page numbers */
+    VOID **pages   /* OUT: the pages */);
+
+HDFLIBAPI intn     mcache_cached (
+    MCACHE *mp, /* IN: MCACHE cookie */
+    int32 pgno  /* IN: page number */);
+
 HDFLIBAPI intn     mcache_put (
     MCACHE *mp, /* IN: MCACHE cookie */
     VOID *page, /* IN: page to put */
@@ -197,6 +242,20 @@ HDFLIBAPI int32  mcache_set_maxcache (
     MCACHE *mp,     /* IN: MCACHE cookie */
     int32  maxcache /* IN: max pages to cache */);
 
+HDFLIBAPI int32  mcache_get_maxbytes (
+    MCACHE *mp /* IN: MCACHE cookie */);
+
+HDFLIBAPI int32  mcache_set_maxbytes (
+    MCACHE *mp,     /* IN: MCACHE cookie */
+    int32  maxbytes /* IN: max bytes to cache */);
+
+HDFLIBAPI intn   mcache_get_policy (
+    MCACHE *mp /* IN: MCACHE cookie */);
+
+HDFLIBAPI intn   mcache_set_policy (
+    MCACHE *mp,  /* IN: MCACHE cookie */
+    intn policy  /* IN: MCACHE_LRU, MCACHE_2Q or MCACHE_CLOCK */);
+
 HDFLIBAPI int32  mcache_get_npages (
     MCACHE *mp /* IN: MCACHE cookie */);
 
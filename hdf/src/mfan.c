@@ -1345,6 +1345,7 @@ ANIcreate(int32    file_id,  /* IN: file ID */
 EXPORT int32
 ANstart(int32 file_id /* IN: file to start annotation access on*/)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "ANstart");
     filerec_t  *file_rec = NULL;		/* file record pointer */
     int32       ret_value = SUCCEED;
@@ -1396,6 +1397,7 @@ ANfileinfo(int32  an_id,        /* IN:  annotation interface id */
            int32 *n_obj_label,  /* OUT: the # of object labels */
            int32 *n_obj_desc    /* OUT: the # of object descriptions */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "ANfileinfo");    /* for HERROR */
     filerec_t  *file_rec  = NULL;  /* file record pointer */
     intn        ret_value = SUCCEED;
@@ -1467,6 +1469,7 @@ ANfileinfo(int32  an_id,        /* IN:  annotation interface id */
 EXPORT int32
 ANend(int32 an_id /* IN: Annotation ID of file to close */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC,"ANend");
     filerec_t *file_rec = NULL;  /* file record pointer */
     TBBT_NODE *aentry   = NULL;
@@ -1611,6 +1614,7 @@ ANcreate(int32    an_id,    /* IN: annotation interface ID */
          ann_type type      /* IN: AN_DATA_LABEL for data labels, 
                                   AN_DATA_DESC for data descriptions*/)
 {
+    HTS_API_LOCK;
 #ifdef LATER
     CONSTR(FUNC, "ANcreate");    /* for HERROR */
 #endif /* LATER */
@@ -1641,6 +1645,7 @@ ANcreatef(int32    an_id,/* IN: annotation interface ID */
           ann_type type  /* IN:  AN_FILE_LABEL for file labels,
                                  AN_FILE_DESC for file descritpions.*/)
 {
+    HTS_API_LOCK;
 #ifdef LATER
     CONSTR(FUNC, "ANcreatef");    /* for HERROR */
 #endif /* LATER */
@@ -1699,6 +1704,7 @@ ANselect(int32    an_id, /* IN: annotation interface ID */
                                 AN_FILE_LABEL for file labels,
                                 AN_FILE_DESC for file descritpions.*/)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "ANselect");    /* for HERROR */
     filerec_t *file_rec = NULL;  /* file record pointer */
     TBBT_NODE *entry    = NULL;
@@ -1771,6 +1777,7 @@ ANnumann(int32    an_id,    /* IN: annotation interface id */
          uint16   elem_tag, /* IN: tag of item of which this is annotation */
          uint16   elem_ref  /* IN: ref of item of which this is annotation */ )
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "ANnumann");
     intn   ret_value = SUCCEED;
 
@@ -1818,6 +1825,7 @@ ANannlist(int32    an_id,      /* IN: annotation interface id */
           uint16   elem_ref,   /* IN: ref of item of which this is annotation */
           int32    ann_list[]  /* OUT: array of ann_id's that match criteria. */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "ANannlist");
     intn  ret_value = SUCCEED;
 
@@ -1855,6 +1863,7 @@ ANannlist(int32    an_id,      /* IN: annotation interface id */
 EXPORT int32
 ANannlen(int32 ann_id /* IN: annotation id */)
 {
+    HTS_API_LOCK;
 #ifdef LATER
     CONSTR(FUNC, "ANannlen");
 #endif /* LATER */
@@ -1884,6 +1893,7 @@ ANwriteann(int32 ann_id,     /* IN: annotation id */
            const char *ann,  /* IN: annotation to write */
            int32 annlen      /* IN: length of annotation */)
 {
+    HTS_API_LOCK;
 #ifdef LATER
     CONSTR(FUNC, "ANwriteann");    /* for HERROR */
 #endif /* LATER */
@@ -1913,6 +1923,7 @@ ANreadann(int32 ann_id,  /* IN: annotation id (handle) */
           char *ann,     /* OUT: space to return annotation in */
           int32 maxlen   /* IN: size of space to return annotation in */)
 {
+    HTS_API_LOCK;
 #ifdef LATER
     CONSTR(FUNC, "ANreadann");    /* for HERROR */
 #endif /* LATER */
@@ -1939,6 +1950,7 @@ ANreadann(int32 ann_id,  /* IN: annotation id (handle) */
 EXPORT intn
 ANendaccess(int32 ann_id /* IN: annotation id */)
 {
+    HTS_API_LOCK;
 #ifdef LATER
     CONSTR(FUNC, "ANendaccess");    /* for HERROR */
 #endif /* LATER */
@@ -1975,6 +1987,7 @@ ANget_tagref(int32    an_id, /* IN: annotation interface ID */
              uint16  *tag,   /* OUT: Tag for annotation */
              uint16  *ref    /* OUT: ref for annotation */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "ANget_tagref");    /* for HERROR */
     filerec_t *file_rec = NULL;  /* file record pointer */
     TBBT_NODE *entry    = NULL;
@@ -2060,6 +2073,7 @@ ANid2tagref(int32   ann_id,/* IN: annotation id */
             uint16 *tag,   /* OUT: Tag for annotation */
             uint16 *ref    /* OUT: ref for annotation */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "ANid2tagref");
     ANnode    *ann_node = NULL;
     int32      file_id  = FAIL;
@@ -2138,6 +2152,7 @@ ANtagref2id(int32  an_id,   /* IN  Annotation interface id */
             uint16 ann_tag, /* IN: Tag for annotation */
             uint16 ann_ref  /* IN: ref for annotation */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "ANtagref2id");
     filerec_t *file_rec = NULL;		/* file record pointer */
     TBBT_NODE *entry    = NULL;
@@ -1541,6 +1541,7 @@ done:
 --------------------------------------------------------------------------*/
 int32 GRstart(int32 hdf_file_id)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRstart");    /* for HERROR */
     gr_info_t *gr_ptr;          /* ptr to the new GR information for a file */
     int32  ret_value = SUCCEED;
@@ -1638,6 +1639,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRfileinfo(int32 grid,int32 *n_datasets,int32 *n_attrs)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRfileinfo");    /* for HERROR */
     gr_info_t *gr_ptr;          /* ptr to the GR information for a file */
     intn  ret_value = SUCCEED;
@@ -2084,6 +2086,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRend(int32 grid)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRend");      /* for HERROR */
     int32 hdf_file_id;          /* HDF file ID */
     int32 GroupID;              /* VGroup ID for the GR group */
@@ -2331,6 +2334,7 @@ done:
 --------------------------------------------------------------------------*/
 int32 GRselect(int32 grid,int32 index)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRselect");   /* for HERROR */
     gr_info_t *gr_ptr;          /* ptr to the GR information for this grid */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
@@ -2401,6 +2405,7 @@ done:
 --------------------------------------------------------------------------*/
 int32 GRcreate(int32 grid,const char *name,int32 ncomp,int32 nt,int32 il,int32 dimsizes[2])
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRcreate");   /* for HERROR */
     int32 GroupID;              /* ID of the Vgroup created */
     gr_info_t *gr_ptr;          /* ptr to the GR information for this grid */
@@ -2525,6 +2530,7 @@ done:
 --------------------------------------------------------------------------*/
 int32 GRnametoindex(int32 grid,const char *name)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRnametoindex");   /* for HERROR */
     gr_info_t *gr_ptr;          /* ptr to the GR information for this grid */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
@@ -2595,6 +2601,7 @@ done:
 intn GRgetiminfo(int32 riid,char *name,int32 *ncomp,int32 *nt,int32 *il,
     int32 dimsizes[2],int32 *n_attr)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRgetiminfo");   /* for HERROR */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     intn  ret_value = SUCCEED;
@@ -2667,6 +2674,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRgetnluts(int32 riid)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRgetnluts");   /* for HERROR */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     intn  ret_value = FAIL;
@@ -2735,6 +2743,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRwriteimage(int32 riid,int32 start[2],int32 in_stride[2],int32 count[2],void * data)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRwriteimage");   /* for HERROR */
     int32 stride[2];            /* pointer to the stride array */
     gr_info_t *gr_ptr;          /* ptr to the GR information for this grid */
@@ -3200,6 +3209,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRreadimage(int32 riid,int32 start[2],int32 in_stride[2],int32 count[2],void * data)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRreadimage");   /* for HERROR */
     int32 hdf_file_id;          /* HDF file ID */
     gr_info_t *gr_ptr;          /* ptr to the GR information for this grid */
@@ -3490,6 +3500,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRendaccess(int32 riid)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRendaccess");   /* for HERROR */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     intn  ret_value = SUCCEED;
@@ -3569,6 +3580,7 @@ done:
 --------------------------------------------------------------------------*/
 uint16 GRidtoref(int32 riid)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRidtoref");   /* for HERROR */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     uint16  ret_value = 0; /* FAIL? */
@@ -3637,6 +3649,7 @@ done:
 --------------------------------------------------------------------------*/
 int32 GRreftoindex(int32 grid,uint16 ref)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRreftoindex");   /* for HERROR */
     gr_info_t *gr_ptr;          /* ptr to the GR information for this grid */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
@@ -3703,6 +3716,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRreqlutil(int32 riid,intn il)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRreqlutil");   /* for HERROR */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     intn  ret_value = SUCCEED;
@@ -3761,6 +3775,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRreqimageil(int32 riid,intn il)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRreqimageil");   /* for HERROR */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     intn  ret_value = SUCCEED;
@@ -3817,6 +3832,7 @@ done:
 --------------------------------------------------------------------------*/
 int32 GRgetlutid(int32 riid,int32 lut_index)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRgetlutid");   /* for HERROR */
     int32  ret_value = SUCCEED;
 
@@ -3865,6 +3881,7 @@ done:
 --------------------------------------------------------------------------*/
 uint16 GRluttoref(int32 lutid)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRluttoref");   /* for HERROR */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     uint16 ret_value = 0;
@@ -3920,6 +3937,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRgetlutinfo(int32 lutid,int32 *ncomp,int32 *nt,int32 *il,int32 *nentries)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRgetlutinfo");   /* for HERROR */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     intn  ret_value = SUCCEED;
@@ -3996,6 +4014,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRwritelut(int32 lutid,int32 ncomps,int32 nt,int32 il,int32 nentries,void * data)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRwritelut");   /* for HERROR */
     int32 hdf_file_id;          /* file ID from Hopen */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
@@ -4088,6 +4107,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRreadlut(int32 lutid,void * data)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRreadlut");   /* for HERROR */
     int32 hdf_file_id;          /* file ID from Hopen */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
@@ -4170,6 +4190,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRsetexternalfile(int32 riid,const char *filename,int32 offset)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRsetexternalfile");   /* for HERROR */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     int32 tmp_aid;  /* AID returned from HXcreate() */
@@ -4254,6 +4275,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRsetaccesstype(int32 riid,uintn accesstype)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRsetaccesstype");   /* for HERROR */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     intn  ret_value = SUCCEED;
@@ -4360,6 +4382,7 @@ GRsetup_szip_parms( ri_info_t *ri_ptr, comp_info *c_info, int32 *cdims)
 --------------------------------------------------------------------------*/
 intn GRsetcompress(int32 riid,comp_coder_t comp_type,comp_info *cinfo)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRsetcompress");   /* for HERROR */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     comp_info cinfo_x;
@@ -4487,6 +4510,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRgetcompress(int32 riid, comp_coder_t* comp_type, comp_info* cinfo)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRgetcompress");   /* for HGOTO_ERROR */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     int32 file_id;
@@ -4598,6 +4622,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRgetcomptype(int32 riid, comp_coder_t* comp_type)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRgetcomptype");  /* for HGOTO_ERROR */
     ri_info_t *ri_ptr;            /* ptr to the image to work with */
     int32 file_id;
@@ -4691,6 +4716,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRgetcompinfo(int32 riid, comp_coder_t* comp_type, comp_info* cinfo)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRgetcompinfo");  /* for HGOTO_ERROR */
     ri_info_t *ri_ptr;            /* ptr to the image to work with */
     int32 file_id;
@@ -4779,6 +4805,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRsetattr(int32 id,const char *name,int32 attr_nt,int32 count,const void * data)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRsetattr");   /* for HERROR */
     int32 hdf_file_id;          /* HDF file ID from Hopen */
     gr_info_t *gr_ptr;          /* ptr to the GR information for this grid */
@@ -4998,6 +5025,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRattrinfo(int32 id,int32 index,char *name,int32 *attr_nt,int32 *count)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRattrinfo");   /* for HERROR */
     gr_info_t *gr_ptr;          /* ptr to the GR information for this grid */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
@@ -5084,6 +5112,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRgetattr(int32 id,int32 index,void * data)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRgetattr");   /* for HERROR */
     int32 hdf_file_id;          /* HDF file ID from Hopen */
     gr_info_t *gr_ptr;          /* ptr to the GR information for this grid */
@@ -5202,6 +5231,7 @@ done:
 --------------------------------------------------------------------------*/
 int32 GRfindattr(int32 id,const char *name)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRfindattr");   /* for HERROR */
     gr_info_t *gr_ptr;          /* ptr to the GR information for this grid */
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
@@ -5426,6 +5456,7 @@ done:
 --------------------------------------------------------------------------*/
 intn GRPshutdown(void)
 {
+    HTS_API_LOCK;
     if(gr_tree!=NULL)
       {
           /* Free the vfile tree */
@@ -5562,6 +5593,7 @@ GRsetchunk(int32 riid,              /* IN: raster access id */
            HDF_CHUNK_DEF chunk_def, /* IN: chunk definition */
            int32 flags              /* IN: flags */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRsetchunk");
     ri_info_t     *ri_ptr = NULL;    /* ptr to the image to work with */
     HCHUNK_DEF     chunk[1];         /* H-level chunk defintion */
@@ -5863,6 +5895,7 @@ GRgetchunkinfo(int32 riid,               /* IN: sds access id */
                HDF_CHUNK_DEF *chunk_def, /* IN/OUT: chunk definition */
                int32 *flags              /* IN/OUT: flags */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRgetchunkinfo");
     ri_info_t      *ri_ptr = NULL;        /* ptr to the image to work with */
     sp_info_block_t info_block;           /* special info block */
@@ -5983,6 +6016,7 @@ GRwritechunk(int32 riid,       /* IN: access aid to GR */
              int32 *origin,    /* IN: origin of chunk to write */
              const VOID *datap /* IN: buffer for data */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRwritechunk");
     ri_info_t *ri_ptr = NULL;   /* ptr to the image to work with */
     uintn      pixel_mem_size,  /* size of a pixel in memory */
@@ -6198,6 +6232,7 @@ GRreadchunk(int32 riid,    /* IN: access aid to GR */
             int32 *origin, /* IN: origin of chunk to write */
             VOID *datap    /* IN/OUT: buffer for data */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRreadchunk");
     ri_info_t *ri_ptr = NULL;   /* ptr to the image to work with */
     uintn      pixel_mem_size;  /* size of a pixel in memory */
@@ -6444,6 +6479,7 @@ GRsetchunkcache(int32 riid,     /* IN: access aid to mess with */
                 int32 maxcache, /* IN: max number of chunks to cache */
                 int32 flags     /* IN: flags = 0, HDF_CACHEALL */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GRsetchunkcache");
     ri_info_t *ri_ptr = NULL;        /* ptr to the image to work with */
     int16      special;              /* Special code */
@@ -6545,6 +6581,7 @@ MODIFICATION
 intn
 GR2bmapped(int32 riid, intn *tobe_mapped, intn *name_generated)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "GR2bmapped");
     ri_info_t *ri_ptr;          /* ptr to the image to work with */
     intn   should_map = FALSE;  /* TRUE if the image should be mapped */
@@ -40,6 +40,11 @@ extern VOID tbbt_dump(TBBT_TREE *ptree, VOID (*key_dump)(VOID *,VOID *),
 static TBBT_NODE *tbbt_get_node(void);
 static void tbbt_release_node(TBBT_NODE *nod);
 
+#ifdef H4_HAVE_THREADSAFE
+/* Guards the node free list, trees are guarded by the locks of their owners */
+PRIVATE pthread_mutex_t tbbt_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif /* H4_HAVE_THREADSAFE */
+
 /* #define TESTING */
 
 /* Returns pointer to end-most (to LEFT or RIGHT) node of tree: */
@@ -966,6 +971,7 @@ tbbtcount(TBBT_TREE * tree)
 *******************************************************************************/
 static TBBT_NODE *tbbt_get_node(void)
 {
+    HTS_MUTEX_GUARD(tbbt_lock);
     TBBT_NODE *ret_value=NULL;
 
     if(tbbt_free_list!=NULL)
@@ -992,6 +998,8 @@ static TBBT_NODE *tbbt_get_node(void)
 *******************************************************************************/
 static void tbbt_release_node(TBBT_NODE *nod)
 {
+    HTS_MUTEX_GUARD(tbbt_lock);
+
     /* Insert the atom at the beginning of the free list */
     nod->Lchild=tbbt_free_list;
     tbbt_free_list=nod;
@@ -1017,6 +1025,7 @@ static void tbbt_release_node(TBBT_NODE *nod)
 intn 
 tbbt_shutdown(void)
 {
+    HTS_MUTEX_GUARD(tbbt_lock);
     TBBT_NODE *curr;
 
     /* Release the free-list if it exists */
@@ -205,6 +205,7 @@ DESCRIPTION
 ---------------------------------------------------- */
 intn VSfindex(int32 vsid, const char *fieldname, int32 *findex)
 {
+    HTS_API_LOCK;
      CONSTR(FUNC, "VSfindex");
      vsinstance_t *vs_inst;
      VDATA *vs;
@@ -282,6 +283,7 @@ DESCRIPTION
 intn VSsetattr(int32 vsid, int32 findex, const char *attrname,
                  int32 datatype, int32 count, const void * values)
 {
+    HTS_API_LOCK;
      CONSTR(FUNC, "VSsetattr");
      vsinstance_t *vs_inst, *attr_inst;
      VDATA    *vs, *attr_vs;
@@ -400,6 +402,7 @@ DESCRIPTION
 --------------------------------------------------------  */
 intn VSnattrs(int32 vsid)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "VSnattrs");
     vsinstance_t *vs_inst;
     VDATA *vs;
@@ -443,6 +446,7 @@ DESCRIPTION
 --------------------------------------------------------  */
 intn VSfnattrs(int32 vsid, int32 findex)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "VSfnattrs");
     vsinstance_t *vs_inst;
     VDATA *vs;
@@ -498,6 +502,7 @@ DESCRIPTION
 ------------------------------------------------------------  */
 intn VSfindattr(int32 vsid, int32 findex, const char *attrname)
 {
+    HTS_API_LOCK;
      CONSTR(FUNC, "VSfindattr");
      VDATA *vs, *attr_vs;
      vsinstance_t *vs_inst, *attr_inst;
@@ -596,6 +601,7 @@ DESCRIPTION
 intn VSattrinfo(int32 vsid, int32 findex, intn attrindex, 
      char *name, int32 *datatype, int32 *count, int32 *size)
 {
+    HTS_API_LOCK;
 
      CONSTR(FUNC, "VSattrinfo");
      VDATA *vs, *attr_vs;
@@ -691,6 +697,7 @@ DESCRIPTION
 intn VSgetattr(int32 vsid, int32 findex, intn attrindex,
                void * values)
 {
+    HTS_API_LOCK;
      CONSTR(FUNC, "VSgetattr");
      VDATA *vs, *attr_vs;
      vs_attr_t *vs_alist;
@@ -781,6 +788,7 @@ DESCRIPTION
 -------------------------------------------------------- */
 intn VSisattr(int32 vsid)
 {
+    HTS_API_LOCK;
      CONSTR(FUNC, "VSsetattr");
      vsinstance_t *vs_inst;
      VDATA    *vs;
@@ -831,6 +839,7 @@ DESCRIPTION
 intn Vsetattr(int32 vgid, const char *attrname, int32 datatype,
               int32 count, const void * values)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vsetattr");
     VGROUP *vg; 
     VDATA *vs;
@@ -951,6 +960,7 @@ DESCRIPTION
 ------------------------------------------------------------  */
 int32 Vgetversion(int32 vgid)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vgetversion");
     VGROUP *vg;
     vginstance_t *v;
@@ -994,6 +1004,7 @@ DESCRIPTION
 --------------------------------------------------  */
 intn Vnattrs(int32 vgid)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vnattrs");
     VGROUP *vg;
     vginstance_t *v;
@@ -1068,6 +1079,7 @@ DESCRIPTION
 --------------------------------------------------  */
 intn Vnoldattrs(int32 vgid)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vnoldattrs");
     VGROUP *vg;
     vginstance_t *v;
@@ -1184,6 +1196,7 @@ DESCRIPTION
 --------------------------------------------------  */
 intn Vnattrs2(int32 vgid)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vnattrs2");
     intn n_new_attrs=0, n_old_attrs=0;
     int32 ret_value = SUCCEED;
@@ -1226,6 +1239,7 @@ done:
 ------------------------------------------------------------  */
 intn Vfindattr(int32 vgid, const char *attrname)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vfindattr");
     VGROUP *vg;
     VDATA *vs;
@@ -1308,6 +1322,7 @@ DESCRIPTION
 intn Vattrinfo(int32 vgid, intn attrindex, char *name,
              int32 *datatype, int32 *count, int32 *size)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vattrinfo");
     VGROUP *vg;
     VDATA *vs;
@@ -1415,6 +1430,7 @@ DESCRIPTION
 intn Vattrinfo2(int32 vgid, intn attrindex, char *name, int32 *datatype,
 	int32 *count, int32 *size, int32 *nfields, uint16 *refnum)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vattrinfo2");
     VGROUP *vg;
     VDATA *vs;
@@ -1519,6 +1535,7 @@ DESCRIPTION
 
 intn Vgetattr(int32 vgid, intn attrindex, void * values)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vgetattr");
     VGROUP *vg;
     VDATA *vs;
@@ -1601,6 +1618,7 @@ DESCRIPTION
 ------------------------------------------------- */
 intn Vgetattr2(int32 vgid, intn attrindex, void * values)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vgetattr2");
     VGROUP *vg;
     VDATA *vs;
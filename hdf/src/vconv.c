@@ -123,6 +123,7 @@ PRIVATE void oldunpackvs(VDATA * vs, uint8 buf[], int32 *size);
 int32
 vicheckcompat(HFILEID f)
 {
+    HTS_API_LOCK;
     int16       foundold, foundnew;
     int32       aid;
 
@@ -187,6 +188,7 @@ vicheckcompat(HFILEID f)
 int32
 vimakecompat(HFILEID f)
 {
+    HTS_API_LOCK;
     VGROUP     *vg;
     VDATA      *vs;
     uint8      *buf = NULL;     /* to store an old vdata or vgroup descriptor  */
@@ -329,6 +331,7 @@ vimakecompat(HFILEID f)
 int32
 vcheckcompat(char *fs)
 {
+    HTS_API_LOCK;
 
     HFILEID     f;
     int32       ret;
@@ -358,6 +361,7 @@ vcheckcompat(char *fs)
 int32
 vmakecompat(char *fs)
 {
+    HTS_API_LOCK;
     HFILEID     f;
     int32       ret;
     CONSTR(FUNC, "vmakecompat");
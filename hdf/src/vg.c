@@ -126,6 +126,7 @@ RETURNS
 int32
 VSelts(int32 vkey /* IN: vdata key */)
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     int32        ret_value = SUCCEED;
@@ -171,6 +172,7 @@ RETURNS
 int32
 VSgetinterlace(int32 vkey /* IN: vdata key */)
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     int32        ret_value = SUCCEED;
@@ -217,6 +219,7 @@ intn
 VSsetinterlace(int32 vkey,     /* IN: vdata key */
                int32 interlace /* IN: interlace for storing records */ )
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     intn         ret_value = SUCCEED;
@@ -279,6 +282,7 @@ int32
 VSgetfields(int32 vkey,   /* IN: vdata key */
             char *fields  /* OUT: comman seperated field name list */)
 {
+    HTS_API_LOCK;
     int32        i;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
@@ -342,6 +346,7 @@ intn
 VSfexist(int32 vkey,  /* IN: vdata key */
          char *fields /* IN: names of fields to check for */)
 {
+    HTS_API_LOCK;
     char          **av = NULL;
     char           *s = NULL;
     DYN_VWRITELIST *w = NULL;
@@ -425,6 +430,7 @@ int32
 VSsizeof(int32 vkey,   /* IN vdata key */
          char *fields  /* IN: Name(s) of the fields to check size of */ )
 {
+    HTS_API_LOCK;
     int32       totalsize;
     int32       i, j;
     int32       found;
@@ -500,6 +506,7 @@ RETURNS
 VOID
 VSdump(int32 vkey /* IN: vdata key */)
 {
+    HTS_API_LOCK;
     vkey = vkey;    /* suppress warning */
 }   /* VSdump */
 
@@ -520,6 +527,7 @@ int32
 VSsetname(int32 vkey,        /* IN: Vdata key */
           const char *vsname /* IN: name to set for vdata*/)
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     int32       curr_len;
@@ -589,6 +597,7 @@ int32
 VSsetclass(int32 vkey,         /* IN: vdata key */
            const char *vsclass /* IN: class name to set for vdata */)
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA       *vs = NULL;
     int32       curr_len;
@@ -655,6 +664,7 @@ int32
 VSgetname(int32 vkey,   /* IN: vdata key */
           char *vsname  /* OUT: vdata name (allocated by user)*/)
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     int32        ret_value = SUCCEED;
@@ -705,6 +715,7 @@ int32
 VSgetclass(int32 vkey,    /* IN: vdata key */
            char *vsclass  /* OUT: class name for vdata (allocated by user) */ )
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     int32     ret_value = SUCCEED;
@@ -760,6 +771,7 @@ VSinquire(int32 vkey,       /* IN: vdata key */
           int32 *eltsize,   /* OUT: total size of all fields in bytes */
           char *vsname      /* OUT: name of vdata */)
 {
+    HTS_API_LOCK;
   intn ret_value = SUCCEED;
   intn status;
   CONSTR(FUNC, "VSinquire");
@@ -824,6 +836,7 @@ VSlone(HFILEID f,     /* IN: file id */
        int32 *idarray,/* OUT: array to return refs of lone vdatas? */
        int32 asize    /* IN: size of 'idarray' */)
 {
+    HTS_API_LOCK;
     int32   i;
     int32   vgid;
     int32   vsid;
@@ -902,6 +915,7 @@ Vlone(HFILEID f,      /* IN: file id */
       int32 *idarray, /* OUT: array to return refs of lone vgroups? */
       int32 asize     /* IN: size of 'idarray' */)
 {
+    HTS_API_LOCK;
     int32       i;
     int32       vgid;
     int32       vstag;
@@ -981,6 +995,7 @@ int32
 Vfind(HFILEID f,          /* IN: file id */
       const char *vgname  /* IN: name of vgroup to find */)
 {
+    HTS_API_LOCK;
     int32        vgid = -1;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
@@ -1035,6 +1050,7 @@ int32
 VSfind(HFILEID f,          /* IN: file id */
        const char *vsname  /* IN: name of vdata to find */)
 {
+    HTS_API_LOCK;
     int32        vsid = -1;
     vsinstance_t *v = NULL;
     VDATA        *vs = NULL;
@@ -1088,6 +1104,7 @@ int32
 Vfindclass(HFILEID f,           /* IN: file id */
            const char *vgclass  /* IN: class of vgroup to find */)
 {
+    HTS_API_LOCK;
     int32        vgid = -1;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
@@ -1144,6 +1161,7 @@ int32
 VSfindclass(HFILEID f,           /* IN: file id */
             const char *vsclass  /* IN: class of vdata to find */)
 {
+    HTS_API_LOCK;
     int32        vsid = -1;
     vsinstance_t *v = NULL;
     VDATA        *vs = NULL;
@@ -1202,6 +1220,7 @@ intn
 VSsetblocksize(	int32 vkey, /* IN: vdata key */
 		int32 block_size) /* length to be used for each linked-block */
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     intn        ret_value = SUCCEED;
@@ -1259,6 +1278,7 @@ intn
 VSsetnumblocks( int32 vkey, /* IN: vdata key */
 		int32 num_blocks) /* number of blocks the element can have */
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     intn        ret_value = SUCCEED;
@@ -1316,6 +1336,7 @@ VSgetblockinfo(int32 vkey, /* IN: vdata id */
                int32* block_size, /* OUT: length used for each linked-block */
                int32* num_blocks) /* OUT: number of blocks the element has */
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     intn        ret_value = SUCCEED;
@@ -1363,6 +1384,7 @@ done:
 intn
 VSisinternal(const char *classname)
 {
+    HTS_API_LOCK;
     int  i;
     intn ret_value = FALSE;
 
@@ -1421,6 +1443,7 @@ VSofclass(int32 id,              /* IN: file id or vgroup id */
             uintn n_vds,	 /* IN: number of user-created vds to return */
             uint16 *refarray	 /* IN/OUT: ref array to fill */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "VSofclass");
     intn      ret_value = 0;
 
@@ -1749,6 +1772,7 @@ VSgetvdatas(int32 id,		/* IN: file id or vgroup id */
             const uintn n_vds,	/* IN: number of user-created vds to return */
             uint16 *refarray	/* IN/OUT: ref array to fill */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "VSgetvdatas");
     int32       ret_value = SUCCEED;
 
@@ -1778,4 +1802,5 @@ done:
 VOID
 Vsetzap(void)
 {
+    HTS_API_LOCK;
 }
@@ -726,6 +726,7 @@ RETURNS
 intn
 Vinitialize(HFILEID f /* IN: file handle */)
 {
+    HTS_API_LOCK;
     intn   ret_value = SUCCEED;
     CONSTR(FUNC, "Vinitialize");
 
@@ -768,6 +769,7 @@ RETURNS
 intn
 Vfinish(HFILEID f /* IN: file handle */)
 {
+    HTS_API_LOCK;
   intn    ret_value = SUCCEED;
   CONSTR(FUNC, "Vfinish");
 
@@ -857,6 +859,7 @@ int32
 vexistvg(HFILEID f,   /* IN: file handle */
          uint16 vgid  /* IN: vgroup id */)
 {
+    HTS_API_LOCK;
     int32   ret_value;
 #ifdef LATER
     CONSTR(FUNC, "vexistvg");
@@ -1216,6 +1219,7 @@ Vattach(HFILEID f,             /* IN: file handle */
         int32 vgid,            /* IN: vgroup id */
         const char *accesstype /* IN: access type */)
 {
+    HTS_API_LOCK;
     VGROUP     *vg = NULL;
     vginstance_t *v = NULL;
     vfile_t    *vf = NULL;
@@ -1366,6 +1370,7 @@ RETURNS
 int32
 Vdetach(int32 vkey /* IN: vgroup key */)
 {
+    HTS_API_LOCK;
     VGROUP       *vg = NULL;
     vginstance_t *v = NULL;
     int32       vgpacksize;
@@ -1489,6 +1494,7 @@ int32
 Vinsert(int32 vkey,      /* IN: vgroup key */
         int32 insertkey  /* IN: */)
 {
+    HTS_API_LOCK;
     VGROUP       *vg = NULL;
     vginstance_t *v = NULL;
     uint16      newtag = 0;
@@ -1599,6 +1605,7 @@ int32
 Vflocate(int32 vkey,  /* IN: vdata key */
          char *field  /* IN: field to locate */)
 {
+    HTS_API_LOCK;
     uintn u;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
@@ -1673,6 +1680,7 @@ Vinqtagref(int32 vkey, /* IN: vgroup key */
            int32 tag,  /* IN: tag to check in vgroup */
            int32 ref   /* IN: ref to check in vgroup */)
 {
+    HTS_API_LOCK;
     uintn u;
     uint16 ttag;
     uint16 rref;
@@ -1736,6 +1744,7 @@ Vdeletetagref(int32 vkey, /* IN: vgroup key */
               int32 tag,  /* IN: tag to delete in vgroup */
               int32 ref   /* IN: ref to delete in vgroup */)
 {
+    HTS_API_LOCK;
     uintn         i,j;       /* loop indices */
     uint16        ttag;      /* tag for comparison */
     uint16        rref;      /* ref for comparison */
@@ -1846,6 +1855,7 @@ RETURNS
 int32
 Vntagrefs(int32 vkey /* IN: vgroup key */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
     int32      ret_value = SUCCEED;
@@ -1895,6 +1905,7 @@ int32
 Vnrefs(int32 vkey, /* IN: vgroup key */
        int32 tag   /* IN: tag to find refs for */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
     uint16 ttag = (uint16)tag;    /* alias for faster comparison */
@@ -1957,6 +1968,7 @@ Vgettagrefs(int32 vkey,       /* IN: vgroup key */
             int32 refarray[], /* IN/OUT: ref array to fill */
             int32 n           /* IN: number of pairs to return */)
 {
+    HTS_API_LOCK;
     int32       i;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
@@ -2022,6 +2034,7 @@ Vgettagref(int32 vkey,   /* IN: vgroup key */
            int32 *tag,   /* IN/OUT: tag to return */
            int32 *ref    /* IN/OUT: ref to return */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
     intn       ret_value = SUCCEED;
@@ -2073,6 +2086,7 @@ RETURNS
 int32
 VQuerytag(int32 vkey /* IN: vgroup key */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
     int32      ret_value = SUCCEED;
@@ -2120,6 +2134,7 @@ RETURN
 int32
 VQueryref(int32 vkey /* IN: vgroup id */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
     int32     ret_value = SUCCEED;
@@ -2177,6 +2192,7 @@ Vaddtagref(int32 vkey, /* IN: vgroup key */
            int32 tag,  /* IN: tag to add */
            int32 ref   /* IN: ref to add */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
 #ifdef NO_DUPLICATES
@@ -2292,6 +2308,7 @@ int32
 Ventries(HFILEID f,  /* IN: file handle */
          int32 vgid  /* IN: vgroup id */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     int32      ret_value = SUCCEED;
     CONSTR(FUNC, "Ventries");
@@ -2337,6 +2354,7 @@ int32
 Vsetname(int32 vkey,         /* IN: vgroup key */
          const char *vgname  /* IN: name to set for vgroup */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vsetname");
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
@@ -2405,6 +2423,7 @@ int32
 Vsetclass(int32 vkey,          /* IN: vgroup key */
           const char *vgclass  /* IN: class to set for vgroup */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vsetclass");
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
@@ -2478,6 +2497,7 @@ intn
 Visvg(int32 vkey, /* IN: vgroup key */
       int32 id    /* IN: id of entry in vgroup */)
 {
+    HTS_API_LOCK;
     uintn        u;
     uint16       ID;
     vginstance_t *v = NULL;
@@ -2539,6 +2559,7 @@ intn
 Visvs(int32 vkey, /* IN: vgroup key */
       int32 id    /* IN: id of entry in vgroup */)
 {
+    HTS_API_LOCK;
     intn         i;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
@@ -2598,6 +2619,7 @@ int32
 Vgetid(HFILEID f,  /* IN: file handle */
        int32 vgid  /* IN: vgroup id */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     vfile_t      *vf = NULL;
     VOIDP        *t = NULL;
@@ -2684,6 +2706,7 @@ int32
 Vgetnext(int32 vkey, /* IN: vgroup key */
          int32 id    /* IN: id of entry in vgroup */)
 {
+    HTS_API_LOCK;
     uintn        u;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
@@ -2771,6 +2794,7 @@ int32
 Vgetnamelen(int32 vkey,   /* IN: vgroup key */
 	    uint16 *name_len /* OUT: length of vgroup's name */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
     int32        ret_value = SUCCEED;
@@ -2837,6 +2861,7 @@ int32
 Vgetclassnamelen(int32 vkey,   /* IN: vgroup key */
 	    uint16 *classname_len /* OUT: length of vgroup's classname */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
     int32        ret_value = SUCCEED;
@@ -2902,6 +2927,7 @@ int32
 Vgetname(int32 vkey,   /* IN: vgroup key */
          char *vgname  /* IN/OUT: vgroup name */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
     int32        ret_value = SUCCEED;
@@ -2958,6 +2984,7 @@ int32
 Vgetclass(int32 vkey,    /* IN: vgroup key */
           char *vgclass  /* IN/OUT: vgroup class */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
     int32        ret_value = SUCCEED;
@@ -3017,6 +3044,7 @@ Vinquire(int32 vkey,        /* IN: vgroup key */
          int32 *nentries,   /* IN/OUT: number of entries in vgroup */
          char *vgname       /* IN/OUT: vgroup name */)
 {
+    HTS_API_LOCK;
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
     intn    ret_value = SUCCEED;
@@ -3090,6 +3118,7 @@ Vopen(char *path,     /* IN: file name */
       intn acc_mode,  /* IN: type of file access */
       int16 ndds      /* IN: number of DD in a block */)
 {
+    HTS_API_LOCK;
     HFILEID    ret_value=SUCCEED;
     CONSTR(FUNC, "Vopen");
 
@@ -3135,6 +3164,7 @@ RETURNS
 intn
 Vclose(HFILEID f /* IN: file handle */)
 {
+    HTS_API_LOCK;
 #ifdef LATER
     CONSTR(FUNC, "Vclose");
 #endif
@@ -3168,6 +3198,7 @@ int32
 Vdelete(int32 f,     /* IN: file handle */
         int32 vgid   /* IN: vgroup id i.e. ref */)
 {
+    HTS_API_LOCK;
     VOIDP       v;
     vfile_t    *vf = NULL;
     VOIDP      *t = NULL;
@@ -3272,6 +3303,7 @@ done:
 intn
 VPshutdown(void)
 {
+    HTS_API_LOCK;
     VGROUP       *v  = NULL;
     vginstance_t *vg = NULL;
     intn         ret_value = SUCCEED;
@@ -3355,6 +3387,7 @@ done:
 intn
 Vgisinternal(int32 vkey /* vgroup's identifier */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vgisinternal");
     vginstance_t *v = NULL;
     VGROUP       *vg = NULL;
@@ -3429,6 +3462,7 @@ done:
 intn
 Visinternal(const char *classname /* vgroup's class name */)
 {
+    HTS_API_LOCK;
     int  i;
     intn ret_value = FALSE;
 
@@ -3480,6 +3514,7 @@ Vgetvgroups(int32 id,		/* IN: file id or vgroup id */
             uintn n_vgs,	/* IN: number of user-created vgs to return */
             uint16 *refarray	/* IN/OUT: ref array to fill */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "Vgetvgroups");
     vginstance_t *vg_inst = NULL;
     int32    vg_ref;
@@ -55,6 +55,7 @@ VHstoredata(HFILEID f, const char *field, const uint8 *buf, int32 n, int32 datat
             const char *vsname, const char *vsclass)
 
 {
+    HTS_API_LOCK;
 #ifdef LATER
     CONSTR(FUNC, "VHstoredata");
 #endif
@@ -94,6 +95,7 @@ VHstoredata(HFILEID f, const char *field, const uint8 *buf, int32 n, int32 datat
 int32
 VHstoredatam(HFILEID f, const char *field, const uint8 *buf, int32 n, int32 datatype, const char *vsname, const char *vsclass, int32 order)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "VHstoredatam");
     int32       ref;
     int32       vs;
@@ -164,6 +166,7 @@ done:
 int32
 VHmakegroup(HFILEID f, int32 tagarray[], int32 refarray[], int32 n, const char *vgname, const char *vgclass)
 {
+    HTS_API_LOCK;
     int32       ref, i;
     int32       vg;
     int32       ret_value = SUCCEED;
@@ -232,6 +232,7 @@ VSIrelease_vsinstance_node(vsinstance_t *vs /* IN: vinstance node to release */)
 intn 
 VSPhshutdown(void)
 {
+    HTS_API_LOCK;
     intn  ret_value = SUCCEED;
     VDATA *v = NULL;
     vsinstance_t *vs = NULL;
@@ -338,6 +339,7 @@ int32
 vexistvs(HFILEID f,  /* IN: file handle */
          uint16 vsid /* IN: vdata id i.e. ref */)
 {
+    HTS_API_LOCK;
   return ((NULL==vsinst(f, vsid)) ? FAIL : TRUE);
 }   /* vexistvs */
 
@@ -879,6 +881,7 @@ VSattach(HFILEID f,             /* IN: file handle */
          int32 vsid,            /* IN: vdata id i.e. ref */
          const char *accesstype /* IN: access type */)
 {
+    HTS_API_LOCK;
     VDATA        *vs = NULL;    /* new vdata to be returned */
     vsinstance_t *w = NULL;
     vfile_t      *vf = NULL;
@@ -1071,6 +1074,7 @@ RETURNS
 int32 
 VSdetach(int32 vkey /* IN: vdata key? */)
 {
+    HTS_API_LOCK;
     int32       i;
     int32       ret;
     int32       vspacksize;
@@ -1215,6 +1219,7 @@ int32
 VSappendable(int32 vkey, /* IN: vdata key */
              int32 blk   /* IN: */)
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     int32      ret_value = SUCCEED;
@@ -1271,6 +1276,7 @@ int32
 VSgetid(HFILEID f,  /* IN: file handle */
         int32 vsid  /* IN: vdata id i.e. ref */)
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     vfile_t      *vf = NULL;
     void *        *t = NULL;
@@ -1344,6 +1350,7 @@ RETURNS
 int32
 VSQuerytag(int32 vkey /* IN: vdata key */)
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     int32      ret_value = SUCCEED;
@@ -1394,6 +1401,7 @@ RETURNS
 int32
 VSQueryref(int32 vkey /* IN: vdata key */)
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     int32      ret_value = SUCCEED;
@@ -1492,6 +1500,7 @@ RETURNS
 int32
 VSgetversion(int32 vkey /* IN: vdata key */)
 {
+    HTS_API_LOCK;
     vsinstance_t *w = NULL;
     VDATA        *vs = NULL;
     int32      ret_value = SUCCEED;
@@ -1546,6 +1555,7 @@ int32
 VSdelete(int32 f,    /* IN: file handle */
          int32 vsid  /* IN: vdata id i.e. ref */)
 {
+    HTS_API_LOCK;
     void *       v;
     vfile_t    *vf = NULL;
     void *      *t = NULL;
@@ -65,6 +65,7 @@ scanattrs(const char *attrs,
           int32 *attrc, 
           char ***attrv)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "scanattrs");
     char *s, *s0, *ss;
     intn len;
@@ -62,6 +62,7 @@ PRIVATE uint8 *Vtbuf = NULL;
 intn 
 VSPshutdown(void)
 {
+    HTS_API_LOCK;
   intn  ret_value = SUCCEED;
 
   /* free global buffers */
@@ -98,6 +99,7 @@ int32
 VSseek(int32 vkey,   /* IN: vdata key */
        int32 eltpos  /* IN: element position in vdata */)
 {
+    HTS_API_LOCK;
     int32        ret;
     int32        offset;
     vsinstance_t *w = NULL;
@@ -163,6 +165,7 @@ VSread(int32 vkey,       /* IN: vdata key */
        int32 nelt,       /* IN: number of elements to read */
        int32 interlace   /* IN: interlace to return elements in 'buf' */)
 {
+    HTS_API_LOCK;
     intn isize = 0;
     intn order = 0;
     intn index = 0;
@@ -487,6 +490,7 @@ VSwrite(int32 vkey,         /* IN: vdata key */
         int32 nelt,         /* IN: number of elements */
         int32 interlace     /* IN: interlace of elements 'buf' */)
 {
+    HTS_API_LOCK;
     intn isize = 0;
     intn order = 0;
     intn index = 0;
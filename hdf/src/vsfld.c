@@ -75,6 +75,7 @@ static const SYMDEF rstab[] =
 intn
 VSsetfields(int32 vkey, const char *fields)
 {
+    HTS_API_LOCK;
     char      **av;
     int32       ac, found;
     intn j, i;
@@ -280,6 +281,7 @@ done:
 intn
 VSfdefine(int32 vkey, const char *field, int32 localtype, int32 order)
 {
+    HTS_API_LOCK;
     char      **av;
     int32       ac;
     int16       isize, replacesym;
@@ -386,6 +388,7 @@ done:
 int32
 VFnfields(int32 vkey)
 {
+    HTS_API_LOCK;
     vsinstance_t *w;
     VDATA      *vs;
     int32      ret_value = SUCCEED;
@@ -425,6 +428,7 @@ done:
 char       *
 VFfieldname(int32 vkey, int32 index)
 {
+    HTS_API_LOCK;
     vsinstance_t *w;
     VDATA      *vs;
     char       *ret_value = NULL; /* FAIL */
@@ -465,6 +469,7 @@ done:
 int32
 VFfieldtype(int32 vkey, int32 index)
 {
+    HTS_API_LOCK;
     vsinstance_t *w;
     VDATA      *vs;
     int32      ret_value = SUCCEED;
@@ -506,6 +511,7 @@ done:
 int32
 VFfieldisize(int32 vkey, int32 index)
 {
+    HTS_API_LOCK;
     vsinstance_t *w;
     VDATA      *vs;
     int32      ret_value = SUCCEED;
@@ -547,6 +553,7 @@ done:
 int32
 VFfieldesize(int32 vkey, int32 index)
 {
+    HTS_API_LOCK;
     vsinstance_t *w;
     VDATA      *vs;
     int32      ret_value = SUCCEED;
@@ -588,6 +595,7 @@ done:
 int32
 VFfieldorder(int32 vkey, int32 index)
 {
+    HTS_API_LOCK;
     vsinstance_t *w;
     VDATA      *vs;
     int32      ret_value = SUCCEED;
@@ -648,6 +656,7 @@ FORTRAN
 
 intn VSsetexternalfile(int32 vkey, const char *filename, int32 offset)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "VSsetexternalfile");
     int32       ret_value = SUCCEED;
 
@@ -725,6 +734,7 @@ done:
 
 intn VSgetexternalfile(int32 vkey, uintn buf_size, char *ext_filename, int32 *offset)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "VSgetexternalfile");
     vsinstance_t *w;
     VDATA *vs;
@@ -836,6 +846,7 @@ done:
 
 intn VSgetexternalinfo(int32 vkey, uintn buf_size, char *ext_filename, int32 *offset, int32 *length)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "VSgetexternalinfo");
     vsinstance_t *w;
     VDATA *vs;
@@ -971,6 +982,7 @@ DESCRIPTION
 intn VSfpack(int32 vsid, intn packtype, const char *fields_in_buf,
          void * buf, intn bufsz, intn n_records, const char *fields, void * fldbufpt[])
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "VSfpack");
 
     int32 ac;
@@ -77,13 +77,21 @@ set (HDF4_TESTHDF_FILES
     t4.hdf
     tbitio.hdf
     tblocks.hdf
+    tchunkal.hdf
     tchunks.hdf
     tcomp.hdf
     tdf24.hdf
     tdfan.hdf
+    tdriver.hdf
     temp.hdf
     thf.hdf
+    tthread0.hdf
+    tthread1.hdf
+    tthread2.hdf
+    tthread3.hdf
+    tthreads.hdf
     tjpeg.hdf
+    tlazydd.hdf
     tlongnames.hdf
     tman.hdf
     tmgr.hdf
@@ -92,6 +92,50 @@
  *       where each chunk is 1x1x4= 4 bytes , total data size 24 bytes 
  *       The element is compressed using RLE scheme.
  *
+ *    13. Create a 2-D chunked, GZIP compressed element with many chunks.
+ *       Set dimension to 48x256 array with 192 chunks 
+ *       where each chunk is 4x16 = 64 bytes, total data size 12,288 bytes.
+ *       Write every chunk but every fifth using HMCwriteChunk(), then
+ *       read the data back in using Hread(), all at once and from the 
+ *       middle, so that many chunks are decompressed together.
+ *
+ *    14. Create a 2-D chunked, GZIP compressed element whose chunks span
+ *       whole rows, so that each chunk lies in one piece in the buffer.
+ *       Set dimension to 48x256 array with 12 chunks 
+ *       where each chunk is 4x256 = 1024 bytes, total data size 12,288 bytes.
+ *       Write it whole, then part of it again, and read it back in 
+ *       whole after reading part of it, so that some chunks are read
+ *       and written through the cache and the others past it.
+ *
+ *    15. Read the element of test 14 again through the shared chunk 
+ *       cache, over several accesses, before and after writing part of it.
+ *       Check that deleting or re-using a tag/ref drops it from the cache.
+ *
+ *    16. Read the element of test 13 a value at a time down a column,
+ *       along a row and up another column, so that the chunks ahead of
+ *       the reads are read ahead.
+ *
+ *    17. Create a 2-D chunked, GZIP compressed element with many chunks
+ *       and write it a row at a time through a cache of few chunks, so
+ *       that the dirty chunks are compressed and written out together
+ *       as they are given up and when the access ends.
+ *
+ *    18. Create a 2-D chunked element with 16,384 chunks and write a few
+ *       of them far apart, starting from the last, so that the chunk 
+ *       records are looked up through a hash table.  Read them all back
+ *       in, add one and read them again.
+ *
+ *    19. Create a 3-D chunked, GZIP compressed element of two byte numbers
+ *       with partial chunks along every dimension and write slabs of it:
+ *       a column one number wide, whole chunks which are not in one piece
+ *       in the slab and a single chunk.  Read it back in whole and read
+ *       slabs of it.
+ *
+ *    20. Create a 2-D chunked element with partial chunks in a new file,
+ *       with its chunks placed on 100 byte boundaries in an extent kept
+ *       for all of them.  Write all its chunks but one, last one first,
+ *       and check where they are in the file.
+ *
  *  For all the tests the data is read back in and verified.
  *
  *  Routines tested using User level H-level calls:
@@ -107,8 +151,13 @@
  * Routines test by direct calling of Chunking routines:
  *   HMCcreate()
  *   HMCsetMaxCache()
+ *   HMCsetCachePolicy()
+ *   HMCsetSharedCache()
  *   HMCwriteChunk()
  *   HMCreadChunk()
+ *   HMCwriteSlab()
+ *   HMCreadSlab()
+ *   HMCsetAlignment()
  *
  *
  * Author -GeorgeV
@@ -119,6 +168,7 @@
 #include "hchunks.h"
 
 #define TESTFILE_NAME "tchunks.hdf"
+#define ALIGNFILE_NAME "tchunkal.hdf"
 #define BUFSIZE       12288
 
 /* Some static data buffers */
@@ -146,6 +196,13 @@ static uint8  chunk5[4] = { 110, 111, 112, 113};
 
 static uint8  chunk6[4] = { 120, 121, 122, 123};
 
+/* slabs of the 6x20x50 element of Test 19, the first three are written */
+static int32  slab_start[5][3] = {{1, 2, 5}, {0, 6, 8}, {0, 0, 0}, {0, 0, 0}, {2, 3, 7}};
+static int32  slab_count[5][3] = {{4, 16, 1}, {4, 12, 16}, {4, 6, 8}, {6, 20, 50}, {3, 15, 2}};
+
+/* what the element of Test 19 holds */
+static uint8  slab_data[BUFSIZE];
+
 /* datay layout of arrays in memory */
 /* for comparison in Test 8 */
 static float32  f32_data[2][3][4] =
@@ -215,6 +272,11 @@ test_chunks(void)
     comp_info  cinfo;
     model_info minfo;
     intn       errors = 0;
+    int32      x_row, x_col;         /* test 16 */
+    int32      n_chk;                /* test 18 */
+    int32      n_slab, s_len, s_pos, s_off, s_bad; /* test 19 */
+    int32      chk_off[12], chk_base; /* test 20 */
+    VOIDP      file_rec;             /* test 15 */
 
     /* intialize out buffer */
     for (i = 0; i < BUFSIZE; i++)
@@ -2500,6 +2562,722 @@ test_chunks(void)
     ret = Hclose(fid);
     CHECK_VOID(ret, FAIL, "Hclose");
 
+    /* 
+       13. Create a 2-D chunked, GZIP compressed element with many chunks.
+       Set dimension to 48x256 array with 192 chunks 
+       where each chunk is 4x16 = 64 bytes, total data size 12,288 bytes.
+       Write every chunk but every fifth using HMCwriteChunk(), then
+       read the data back in using Hread(), all at once and from the 
+       middle, so that many chunks are decompressed together.
+       */
+    chunk[0].num_dims   = 2;
+    chunk[0].chunk_size = 64; /* 4x16 bytes */
+    chunk[0].nt_size    = 1; /* number type size */
+    chunk[0].chunk_flag = SPECIAL_COMP; /* compression */
+    chunk[0].comp_type = COMP_CODE_DEFLATE; /* GZIP */
+    cinfo.deflate.level = 6;
+    chunk[0].model_type = COMP_MODEL_STDIO; /* STDIO */
+    chunk[0].cinfo = &cinfo;
+    chunk[0].minfo = &minfo; /* nothing set */
+
+    chunk[0].pdims[0].dim_length   = 48;
+    chunk[0].pdims[0].chunk_length = 4;  
+    chunk[0].pdims[0].distrib_type = 1;
+
+    chunk[0].pdims[1].dim_length   = 256;
+    chunk[0].pdims[1].chunk_length = 16;
+    chunk[0].pdims[1].distrib_type = 1;
+
+    /* set fill value to 7 */
+    fill_val_u8 = 7;
+    fill_val_len = 1;
+
+    /* the data expected back, element (x,y) is x*3+y except in the 
+       chunks not written */
+    for (i = 0; i < 48; i++)
+        for (j = 0; j < 256; j++)
+            outbuf[i*256 + j] = ((i/4)*16 + j/16) % 5 == 0 ? 
+                                fill_val_u8 : (uint8)(i*3 + j);
+
+    fid = Hopen(TESTFILE_NAME, DFACC_RDWR, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+    MESSAGE(5, printf("Test 13. Create another new element as a 2-D, uint8 chunked, GZIP Compressed element(12,288 bytes)\n"););
+
+    /* Create element     tag, ref,  nlevels, fill_len, fill, chunk array */
+    aid1 = HMCcreate(fid, 1020, 23, 1, fill_val_len, &fill_val_u8, (HCHUNK_DEF *)chunk);
+    CHECK_VOID(aid1, FAIL, "HMCcreate");
+
+    for (i = 0; i < 12; i++)
+        for (j = 0; j < 16; j++)
+          {
+              if ((i*16 + j) % 5 == 0)
+                  continue;
+              for (k = 0; k < 64; k++)
+                  inbuf[k] = outbuf[(i*4 + k/16)*256 + j*16 + k%16];
+              dims[0] = i;
+              dims[1] = j;
+              ret = HMCwriteChunk(aid1, dims, inbuf);
+              if (ret == FAIL)
+                {
+                    fprintf(stderr, "ERROR: HMCwriteChunk failed on chunk (%d,%d)\n", i, j);
+                    errors++;
+                    goto done;
+                }
+          }
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    MESSAGE(5, printf("Open 2-D, uint8 chunked, GZIP Compressed element again for reading\n"); );
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    aid1 = Hstartread(fid, 1020, 23);
+    CHECK_VOID(aid1, FAIL, "Hstartread");
+
+    /* let the cache hold more than a row of chunks */
+    ret = HMCsetMaxcache(aid1, 100, 0);
+    CHECK_VOID(ret, FAIL, "HMCsetMaxcache");
+
+    HDmemset(inbuf, 0, BUFSIZE);
+    ret = Hread(aid1, BUFSIZE, inbuf);
+    VERIFY_VOID(ret, BUFSIZE, "Hread");
+
+    MESSAGE(5, printf("Verifying 12,288 bytes of data\n"); );
+    for (i = 0; i < BUFSIZE; i++)
+        if (inbuf[i] != outbuf[i])
+          {
+              printf("Wrong data at %d, out %d in %d\n", i, outbuf[i], inbuf[i]);
+              errors++;
+              break;
+          }
+
+    /* read from the middle, starting in a chunk not written */
+    ret = Hseek(aid1, 5*256 + 3, DF_START);
+    CHECK_VOID(ret, FAIL, "Hseek");
+
+    HDmemset(inbuf, 0, BUFSIZE);
+    ret = Hread(aid1, 5000, inbuf);
+    VERIFY_VOID(ret, 5000, "Hread");
+
+    MESSAGE(5, printf("Verifying 5,000 bytes of data\n"); );
+    for (i = 0; i < 5000; i++)
+        if (inbuf[i] != outbuf[5*256 + 3 + i])
+          {
+              printf("Wrong data at %d, out %d in %d\n", i, outbuf[5*256 + 3 + i], inbuf[i]);
+              errors++;
+              break;
+          }
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+
+    MESSAGE(5, printf("Closing the file\n"););
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    /* 
+       14. Create a 2-D chunked, GZIP compressed element whose chunks span
+       whole rows, so that each chunk lies in one piece in the buffer.
+       Set dimension to 48x256 array with 12 chunks 
+       where each chunk is 4x256 = 1024 bytes, total data size 12,288 bytes.
+       Write it whole, then part of it again, and read it back in 
+       whole after reading part of it, so that some chunks are read
+       and written through the cache and the others past it.
+       */
+    chunk[0].chunk_size = 1024; /* 4x256 bytes */
+    chunk[0].pdims[1].chunk_length = 256;
+
+    for (i = 0; i < BUFSIZE; i++)
+        outbuf[i] = (uint8)(i / 7);
+
+    fid = Hopen(TESTFILE_NAME, DFACC_RDWR, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+    MESSAGE(5, printf("Test 14. Create another new element as a 2-D, uint8 chunked, GZIP Compressed element with whole row chunks\n"););
+
+    /* Create element     tag, ref,  nlevels, fill_len, fill, chunk array */
+    aid1 = HMCcreate(fid, 1020, 24, 1, fill_val_len, &fill_val_u8, (HCHUNK_DEF *)chunk);
+    CHECK_VOID(aid1, FAIL, "HMCcreate");
+
+    ret = Hwrite(aid1, BUFSIZE, outbuf);
+    VERIFY_VOID(ret, BUFSIZE, "Hwrite");
+
+    /* write part of the first chunk and all of the next through the cache */
+    for (i = 1000; i < 2100; i++)
+        outbuf[i] = (uint8)(255 - i);
+    ret = Hseek(aid1, 1000, DF_START);
+    CHECK_VOID(ret, FAIL, "Hseek");
+    ret = Hwrite(aid1, 1100, outbuf + 1000);
+    VERIFY_VOID(ret, 1100, "Hwrite");
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    MESSAGE(5, printf("Open 2-D, uint8 chunked, GZIP Compressed element again for reading\n"); );
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    aid1 = Hstartread(fid, 1020, 24);
+    CHECK_VOID(aid1, FAIL, "Hstartread");
+
+    /* a cache of three chunks, the ones used again kept first */
+    ret = HMCsetCachePolicy(aid1, 3 * 1024 + 100, HDF_CACHE_2Q);
+    VERIFY_VOID(ret, 3, "HMCsetCachePolicy");
+
+    /* get the third chunk into the cache */
+    ret = Hseek(aid1, 2100, DF_START);
+    CHECK_VOID(ret, FAIL, "Hseek");
+    ret = Hread(aid1, 100, inbuf);
+    VERIFY_VOID(ret, 100, "Hread");
+
+    ret = Hseek(aid1, 0, DF_START);
+    CHECK_VOID(ret, FAIL, "Hseek");
+    HDmemset(inbuf, 0, BUFSIZE);
+    ret = Hread(aid1, BUFSIZE, inbuf);
+    VERIFY_VOID(ret, BUFSIZE, "Hread");
+
+    MESSAGE(5, printf("Verifying 12,288 bytes of data\n"); );
+    for (i = 0; i < BUFSIZE; i++)
+        if (inbuf[i] != outbuf[i])
+          {
+              printf("Wrong data at %d, out %d in %d\n", i, outbuf[i], inbuf[i]);
+              errors++;
+              break;
+          }
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+
+    MESSAGE(5, printf("Closing the file\n"););
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    /* 
+       15. Read the element of test 14 through the shared chunk cache,
+       with the chunks read by one access found by the next one, then
+       write part of it and check that the next read does not get the
+       chunks from before the write.
+       */
+    MESSAGE(5, printf("Test 15. Read the GZIP Compressed element of test 14 through the shared chunk cache\n"););
+    ret = HMCsetSharedCache(64 * 1024);
+    CHECK_VOID(ret, FAIL, "HMCsetSharedCache");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_RDWR, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    for (k = 0; k < 3; k++)
+      {
+          if (k == 2)
+            { /* write the first two chunks and a bit of the third */
+                for (i = 0; i < 2100; i++)
+                    outbuf[i] = (uint8)(i * 3);
+                aid1 = Hstartaccess(fid, 1020, 24, DFACC_RDWR);
+                CHECK_VOID(aid1, FAIL, "Hstartaccess");
+                ret = Hwrite(aid1, 2100, outbuf);
+                VERIFY_VOID(ret, 2100, "Hwrite");
+                ret = Hendaccess(aid1);
+                CHECK_VOID(ret, FAIL, "Hendaccess");
+            }
+
+          aid1 = Hstartread(fid, 1020, 24);
+          CHECK_VOID(aid1, FAIL, "Hstartread");
+
+          HDmemset(inbuf, 0, BUFSIZE);
+          ret = Hread(aid1, BUFSIZE, inbuf);
+          VERIFY_VOID(ret, BUFSIZE, "Hread");
+
+          MESSAGE(5, printf("Verifying 12,288 bytes of data, pass %d\n", k); );
+          for (i = 0; i < BUFSIZE; i++)
+              if (inbuf[i] != outbuf[i])
+                {
+                    printf("Wrong data at %d, out %d in %d\n", i, outbuf[i], inbuf[i]);
+                    errors++;
+                    break;
+                }
+
+          ret = Hendaccess(aid1);
+          CHECK_VOID(ret, FAIL, "Hendaccess");
+      }
+
+    /* the cache is keyed by tag/ref, which may name other data once the
+       element is deleted or its tag/ref is re-used */
+    MESSAGE(5, printf("Deleting and re-using tag/refs held in the shared chunk cache\n"); );
+    file_rec = HAatom_object(fid);
+    for (k = 0; k < 2; k++)
+      {
+          ret = Hputelement(fid, 1021, 1, outbuf, 16);
+          VERIFY_VOID(ret, 16, "Hputelement");
+          HCSput(file_rec, 1021, 1, outbuf, 16);
+          if (!HCSget(file_rec, 1021, 1, inbuf, 16))
+            {
+                printf("Tag/ref not in the shared chunk cache\n");
+                errors++;
+            }
+
+          if (k == 0)
+            {
+                ret = Hdeldd(fid, 1021, 1);
+                CHECK_VOID(ret, FAIL, "Hdeldd");
+            }
+          else
+            {
+                ret = HDreuse_tagref(fid, 1021, 1);
+                CHECK_VOID(ret, FAIL, "HDreuse_tagref");
+            }
+          if (HCSget(file_rec, 1021, 1, inbuf, 16))
+            {
+                printf("Shared chunk cache still holds tag/ref 1021/1 after %s\n",
+                       k == 0 ? "Hdeldd" : "HDreuse_tagref");
+                errors++;
+            }
+      }
+
+    MESSAGE(5, printf("Closing the file\n"););
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    ret = HMCsetSharedCache(0);
+    CHECK_VOID(ret, FAIL, "HMCsetSharedCache");
+
+    /* 
+       16. Read the element of test 13 a value at a time, down a column,
+       along a row and then up another column, so that the reads go 
+       through the chunks at a steady stride, forwards and backwards, 
+       and the chunks ahead are read with them.
+       Element (x,y) of it is x*3+y, or the fill value 7 in the chunks
+       not written.
+       */
+    MESSAGE(5, printf("Test 16. Read the GZIP Compressed element of test 13 down a column, along a row and up a column\n"););
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    aid1 = Hstartread(fid, 1020, 23);
+    CHECK_VOID(aid1, FAIL, "Hstartread");
+
+    for (k = 0; k < 3; k++)
+        for (i = 0; i < (k == 1 ? 256 : 48); i++)
+          {
+              /* down column 37, along row 21, then up column 100 */
+              x_row = (k == 0) ? i : (k == 1) ? 21 : 47 - i;
+              x_col = (k == 0) ? 37 : (k == 1) ? i : 100;
+              ret = Hseek(aid1, x_row * 256 + x_col, DF_START);
+              CHECK_VOID(ret, FAIL, "Hseek");
+              inbuf[0] = 255;
+              ret = Hread(aid1, 1, inbuf);
+              VERIFY_VOID(ret, 1, "Hread");
+              j = ((x_row / 4) * 16 + x_col / 16) % 5 == 0 ? 7 : (uint8)(x_row * 3 + x_col);
+              if (inbuf[0] != j)
+                {
+                    printf("Wrong data at (%d,%d), out %d in %d\n", x_row, x_col, j, inbuf[0]);
+                    errors++;
+                    break;
+                }
+          }
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+
+    MESSAGE(5, printf("Closing the file\n"););
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    /* 
+       17. Create a 2-D chunked, GZIP compressed element like the one of
+       test 13 and write it a row at a time through a cache of 20 chunks.
+       Each row goes through 16 chunks, so the cache gives up dirty chunks
+       as the rows go by, and writes out the rest when the access ends.
+       */
+    chunk[0].chunk_size = 64; /* 4x16 bytes */
+    chunk[0].pdims[1].chunk_length = 16;
+
+    for (i = 0; i < BUFSIZE; i++)
+        outbuf[i] = (uint8)((i * 7) / 3);
+
+    fid = Hopen(TESTFILE_NAME, DFACC_RDWR, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+    MESSAGE(5, printf("Test 17. Create another new element as a 2-D, uint8 chunked, GZIP Compressed element written a row at a time\n"););
+
+    /* Create element     tag, ref,  nlevels, fill_len, fill, chunk array */
+    aid1 = HMCcreate(fid, 1020, 25, 1, fill_val_len, &fill_val_u8, (HCHUNK_DEF *)chunk);
+    CHECK_VOID(aid1, FAIL, "HMCcreate");
+
+    ret = HMCsetMaxcache(aid1, 20, 0);
+    VERIFY_VOID(ret, 20, "HMCsetMaxcache");
+
+    for (i = 0; i < 48; i++)
+      {
+          ret = Hwrite(aid1, 256, outbuf + i * 256);
+          VERIFY_VOID(ret, 256, "Hwrite");
+      }
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    MESSAGE(5, printf("Open 2-D, uint8 chunked, GZIP Compressed element again for reading\n"); );
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    aid1 = Hstartread(fid, 1020, 25);
+    CHECK_VOID(aid1, FAIL, "Hstartread");
+
+    HDmemset(inbuf, 0, BUFSIZE);
+    ret = Hread(aid1, BUFSIZE, inbuf);
+    VERIFY_VOID(ret, BUFSIZE, "Hread");
+
+    MESSAGE(5, printf("Verifying 12,288 bytes of data\n"); );
+    for (i = 0; i < BUFSIZE; i++)
+        if (inbuf[i] != outbuf[i])
+          {
+              printf("Wrong data at %d, out %d in %d\n", i, outbuf[i], inbuf[i]);
+              errors++;
+              break;
+          }
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+
+    MESSAGE(5, printf("Closing the file\n"););
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    /* 
+       18. Create a 2-D chunked element of 256x1024 uint8 with 4x4 chunks,
+       16,384 chunks, and write every 37th chunk from the last one down,
+       so that the chunk numbers in use are too far apart for a flat
+       chunk index.  Read all the chunks back in, those not written hold
+       the fill value, then write chunk 1 and read them all again.
+       Chunk n holds n+k at byte k.
+       */
+    chunk[0].num_dims   = 2;
+    chunk[0].chunk_size = 16; /* 4x4 bytes */
+    chunk[0].nt_size    = 1; /* number type size */
+    chunk[0].chunk_flag = 0;  /* nothing set */
+    chunk[0].comp_type  = COMP_CODE_NONE;
+    chunk[0].model_type = COMP_MODEL_STDIO;
+    chunk[0].cinfo = &cinfo; /* nothing set */
+    chunk[0].minfo = &minfo; /* nothing set */
+    chunk[0].pdims[0].dim_length   = 256;
+    chunk[0].pdims[0].chunk_length = 4;  
+    chunk[0].pdims[0].distrib_type = 1;
+    chunk[0].pdims[1].dim_length   = 1024;
+    chunk[0].pdims[1].chunk_length = 4;
+    chunk[0].pdims[1].distrib_type = 1;
+
+    fid = Hopen(TESTFILE_NAME, DFACC_RDWR, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+    MESSAGE(5, printf("Test 18. Create another new element as a 2-D, uint8 chunked element with few of its 16,384 chunks written\n"););
+
+    /* Create element     tag, ref,  nlevels, fill_len, fill, chunk array */
+    aid1 = HMCcreate(fid, 1020, 26, 1, fill_val_len, &fill_val_u8, (HCHUNK_DEF *)chunk);
+    CHECK_VOID(aid1, FAIL, "HMCcreate");
+
+    for (n_chk = 16383; n_chk >= 0; n_chk -= 37)
+      {
+          for (k = 0; k < 16; k++)
+              inbuf[k] = (uint8)(n_chk + k);
+          dims[0] = n_chk / 256;
+          dims[1] = n_chk % 256;
+          ret = HMCwriteChunk(aid1, dims, inbuf);
+          CHECK_VOID(ret, FAIL, "HMCwriteChunk");
+      }
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+
+    for (j = 0; j < 2; j++)
+      {
+          aid1 = Hstartaccess(fid, 1020, 26, DFACC_RDWR);
+          CHECK_VOID(aid1, FAIL, "Hstartaccess");
+
+          MESSAGE(5, printf("Verifying 16,384 chunks, pass %d\n", (int)j); );
+          for (n_chk = 0; n_chk < 16384; n_chk++)
+            {
+                dims[0] = n_chk / 256;
+                dims[1] = n_chk % 256;
+                ret = HMCreadChunk(aid1, dims, inbuf);
+                CHECK_VOID(ret, FAIL, "HMCreadChunk");
+                for (k = 0; k < 16; k++)
+                    if (inbuf[k] != (((16383 - n_chk) % 37 == 0 || (j == 1 && n_chk == 1)) ?
+                                     (uint8)(n_chk + k) : fill_val_u8))
+                      {
+                          printf("Wrong data in chunk %d at %d, in %d\n", (int)n_chk, (int)k, inbuf[k]);
+                          errors++;
+                          break;
+                      }
+                if (k < 16)
+                    break;
+            }
+
+          if (j == 0)
+            { /* write chunk 1 as well */
+                for (k = 0; k < 16; k++)
+                    inbuf[k] = (uint8)(1 + k);
+                dims[0] = 0;
+                dims[1] = 1;
+                ret = HMCwriteChunk(aid1, dims, inbuf);
+                CHECK_VOID(ret, FAIL, "HMCwriteChunk");
+            }
+
+          ret = Hendaccess(aid1);
+          CHECK_VOID(ret, FAIL, "Hendaccess");
+      }
+
+    MESSAGE(5, printf("Closing the file\n"););
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    /* 
+       19. Create a 3-D chunked, GZIP compressed element of 6x20x50 two
+       byte numbers with 4x6x8 chunks, partial along every dimension, 
+       and write it whole.  Then write three slabs of it with 
+       HMCwriteSlab(), see slab_start[] and slab_count[], keeping a copy
+       of what the element holds up to date.  Read the element back in
+       with Hread(), and slabs of it with HMCreadSlab(), and check them
+       against the copy.
+       */
+    chunk[0].num_dims   = 3;
+    chunk[0].chunk_size = 4*6*8;
+    chunk[0].nt_size    = 2; /* number type size */
+    chunk[0].chunk_flag = SPECIAL_COMP;
+    chunk[0].comp_type  = COMP_CODE_DEFLATE; /* GZIP */
+    cinfo.deflate.level = 6;
+    chunk[0].model_type = COMP_MODEL_STDIO;
+    chunk[0].cinfo = &cinfo;
+    chunk[0].minfo = &minfo;
+    chunk[0].pdims[0].dim_length   = 6;
+    chunk[0].pdims[0].chunk_length = 4;  
+    chunk[0].pdims[0].distrib_type = 1;
+    chunk[0].pdims[1].dim_length   = 20;
+    chunk[0].pdims[1].chunk_length = 6;
+    chunk[0].pdims[1].distrib_type = 1;
+    chunk[0].pdims[2].dim_length   = 50;
+    chunk[0].pdims[2].chunk_length = 8;
+    chunk[0].pdims[2].distrib_type = 1;
+
+    fid = Hopen(TESTFILE_NAME, DFACC_RDWR, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+    MESSAGE(5, printf("Test 19. Create another new element as a 3-D, 2 byte chunked, GZIP Compressed element written and read a slab at a time\n"););
+
+    /* Create element     tag, ref,  nlevels, fill_len, fill, chunk array */
+    fill_val_len = 2;
+    aid1 = HMCcreate(fid, 1020, 27, 1, fill_val_len, &fill_val_u16, (HCHUNK_DEF *)chunk);
+    CHECK_VOID(aid1, FAIL, "HMCcreate");
+    fill_val_len = 1;
+
+    ret = Hwrite(aid1, 12000, outbuf);
+    VERIFY_VOID(ret, 12000, "Hwrite");
+    HDmemcpy(slab_data, outbuf, 12000);
+
+    for (n_slab = 0; n_slab < 3; n_slab++)
+      {
+          s_len = 2 * slab_count[n_slab][0] * slab_count[n_slab][1] * slab_count[n_slab][2];
+          for (k = 0; k < s_len; k++)
+              inbuf[k] = (uint8)(n_slab * 50 + k * 3);
+          ret = HMCwriteSlab(aid1, slab_start[n_slab], slab_count[n_slab], inbuf);
+          VERIFY_VOID(ret, s_len, "HMCwriteSlab");
+
+          /* bring the copy up to date */
+          s_pos = 0;
+          for (i = 0; i < slab_count[n_slab][0]; i++)
+              for (j = 0; j < slab_count[n_slab][1]; j++)
+                  for (k = 0; k < slab_count[n_slab][2]; k++)
+                    {
+                        s_off = (((slab_start[n_slab][0] + i) * 20 
+                                  + slab_start[n_slab][1] + j) * 50 
+                                 + slab_start[n_slab][2] + k) * 2;
+                        slab_data[s_off] = inbuf[s_pos++];
+                        slab_data[s_off + 1] = inbuf[s_pos++];
+                    }
+      }
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    MESSAGE(5, printf("Open 3-D, 2 byte chunked, GZIP Compressed element again for reading\n"); );
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    aid1 = Hstartread(fid, 1020, 27);
+    CHECK_VOID(aid1, FAIL, "Hstartread");
+
+    HDmemset(inbuf, 0, BUFSIZE);
+    ret = Hread(aid1, 12000, inbuf);
+    VERIFY_VOID(ret, 12000, "Hread");
+
+    MESSAGE(5, printf("Verifying 12,000 bytes of data\n"); );
+    for (i = 0; i < 12000; i++)
+        if (inbuf[i] != slab_data[i])
+          {
+              printf("Wrong data at %d, out %d in %d\n", i, slab_data[i], inbuf[i]);
+              errors++;
+              break;
+          }
+
+    for (n_slab = 0; n_slab < 5; n_slab++)
+      {
+          MESSAGE(5, printf("Verifying slab %d\n", (int)n_slab); );
+          s_len = 2 * slab_count[n_slab][0] * slab_count[n_slab][1] * slab_count[n_slab][2];
+          HDmemset(inbuf, 0, BUFSIZE);
+          ret = HMCreadSlab(aid1, slab_start[n_slab], slab_count[n_slab], inbuf);
+          VERIFY_VOID(ret, s_len, "HMCreadSlab");
+
+          s_pos = 0;
+          s_bad = 0;
+          for (i = 0; i < slab_count[n_slab][0]; i++)
+              for (j = 0; j < slab_count[n_slab][1]; j++)
+                  for (k = 0; k < slab_count[n_slab][2]; k++, s_pos += 2)
+                    {
+                        s_off = (((slab_start[n_slab][0] + i) * 20 
+                                  + slab_start[n_slab][1] + j) * 50 
+                                 + slab_start[n_slab][2] + k) * 2;
+                        if (inbuf[s_pos] != slab_data[s_off] 
+                            || inbuf[s_pos + 1] != slab_data[s_off + 1])
+                            s_bad++;
+                    }
+          if (s_bad > 0)
+            {
+                printf("Wrong data in slab %d, %d numbers\n", (int)n_slab, (int)s_bad);
+                errors++;
+            }
+      }
+
+    /* slabs reaching past the element are not read */
+    dims[0] = 3; dims[1] = 0; dims[2] = 0;
+    ret = HMCreadSlab(aid1, dims, slab_count[3], inbuf);
+    VERIFY_VOID(ret, FAIL, "HMCreadSlab");
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+
+    MESSAGE(5, printf("Closing the file\n"););
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    /* 
+       20. Create a 2-D chunked element of 10x20 bytes with 4x6 chunks,
+       12 chunks of 24 bytes, in a new file of its own.  Ask for its 
+       chunks to start on 100 byte boundaries, in an extent kept for all
+       of them.  Write all the chunks but chunk 5 with HMCwriteChunk(),
+       from the last one on, so that they would go in the file the other
+       way round.  Chunk n holds n+k at byte k.  Then find the chunks 
+       in the file: each must be at 100 bytes times its number from the
+       beginning of the extent, which is on a boundary itself.
+       */
+    chunk[0].num_dims   = 2;
+    chunk[0].chunk_size = 24; /* 4x6 bytes */
+    chunk[0].nt_size    = 1; /* number type size */
+    chunk[0].chunk_flag = 0;  /* nothing set */
+    chunk[0].comp_type  = COMP_CODE_NONE;
+    chunk[0].model_type = COMP_MODEL_STDIO;
+    chunk[0].cinfo = &cinfo; /* nothing set */
+    chunk[0].minfo = &minfo; /* nothing set */
+    chunk[0].pdims[0].dim_length   = 10;
+    chunk[0].pdims[0].chunk_length = 4;  
+    chunk[0].pdims[0].distrib_type = 1;
+    chunk[0].pdims[1].dim_length   = 20;
+    chunk[0].pdims[1].chunk_length = 6;
+    chunk[0].pdims[1].distrib_type = 1;
+
+    fid = Hopen(ALIGNFILE_NAME, DFACC_CREATE, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+    MESSAGE(5, printf("Test 20. Create another new element as a 2-D, uint8 chunked element with its chunks placed on boundaries\n"););
+
+    /* Create element     tag, ref,  nlevels, fill_len, fill, chunk array */
+    aid1 = HMCcreate(fid, 1020, 28, 1, fill_val_len, &fill_val_u8, (HCHUNK_DEF *)chunk);
+    CHECK_VOID(aid1, FAIL, "HMCcreate");
+
+    ret = HMCsetAlignment(aid1, 100, HDF_CHUNK_PREALLOC);
+    CHECK_VOID(ret, FAIL, "HMCsetAlignment");
+
+    for (n_chk = 11; n_chk >= 0; n_chk--)
+      {
+          if (n_chk == 5)
+              continue;
+          for (k = 0; k < 24; k++)
+              inbuf[k] = (uint8)(n_chk + k);
+          dims[0] = n_chk / 4;
+          dims[1] = n_chk % 4;
+          ret = HMCwriteChunk(aid1, dims, inbuf);
+          CHECK_VOID(ret, FAIL, "HMCwriteChunk");
+      }
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+
+    /* the chunks are the only elements of that tag in the file */
+    for (n_chk = 0; n_chk < 12; n_chk++)
+        chk_off[n_chk] = -1;
+    tag = 0; 
+    ref = 0;
+    while (Hfind(fid, DFTAG_CHUNK, DFREF_WILDCARD, &tag, &ref, &offset, &length,
+                 DF_FORWARD) == SUCCEED)
+      {
+          VERIFY_VOID(length, 24, "Hfind");
+          ret = Hgetelement(fid, tag, ref, inbuf);
+          VERIFY_VOID(ret, 24, "Hgetelement");
+          n_chk = inbuf[0];
+          if (n_chk >= 12 || chk_off[n_chk] != -1)
+            {
+                printf("Wrong chunk %d found\n", (int)n_chk);
+                errors++;
+                continue;
+            }
+          chk_off[n_chk] = offset;
+      }
+
+    MESSAGE(5, printf("Verifying the places of the chunks\n"); );
+    chk_base = chk_off[0];
+    if (chk_base % 100 != 0)
+      {
+          printf("Chunk 0 at %d, not on a boundary\n", (int)chk_base);
+          errors++;
+      }
+    for (n_chk = 0; n_chk < 12; n_chk++)
+        if (chk_off[n_chk] != (n_chk == 5 ? -1 : chk_base + 100 * n_chk))
+          {
+              printf("Chunk %d at %d, not at %d\n", (int)n_chk, 
+                     (int)chk_off[n_chk], (int)(chk_base + 100 * n_chk));
+              errors++;
+          }
+
+    aid1 = Hstartread(fid, 1020, 28);
+    CHECK_VOID(aid1, FAIL, "Hstartread");
+
+    HDmemset(inbuf, 1, BUFSIZE);
+    ret = Hread(aid1, 200, inbuf);
+    VERIFY_VOID(ret, 200, "Hread");
+
+    MESSAGE(5, printf("Verifying 200 bytes of data\n"); );
+    for (i = 0; i < 10; i++)
+        for (j = 0; j < 20; j++)
+          {
+              n_chk = (i / 4) * 4 + j / 6;
+              k = (i % 4) * 6 + j % 6;
+              if (inbuf[i * 20 + j] != (n_chk == 5 ? fill_val_u8 : (uint8)(n_chk + k)))
+                {
+                    printf("Wrong data at (%d,%d), in %d\n", (int)i, (int)j, inbuf[i * 20 + j]);
+                    errors++;
+                }
+          }
+
+    /* unknown flags are refused */
+    ret = HMCsetAlignment(aid1, 100, HDF_CHUNK_PREALLOC | 0x10);
+    VERIFY_VOID(ret, FAIL, "HMCsetAlignment");
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+
+    MESSAGE(5, printf("Closing the file\n"););
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
 
   done:
     /* Don't forget to free dimensions allocate for chunk definition */
@@ -43,10 +43,63 @@
    ** With wildcard.
    ** Open more access elements than there is space.
 
+   * Hmmap
+   ** Map all files opened read-only.
+   ** Unmap and re-map one file.
+   ** Re-open a mapped file with DFACC_RDWR.
+
+   * Hsetdriver/Hgetdriver
+   ** Create a file with the core driver.
+   ** Re-open it with the default driver.
+   ** Set an illegal driver.
+
+   * Hopendriver
+   ** Open a file with a driver other than the default one.
+   ** Don't create a large file with the core driver.
+
+   * Hsetlazydd
+   ** Read a file with many DD blocks lazily.
+   ** Re-open a lazily read file with DFACC_RDWR.
+   ** Read one file lazily with DFACC_LAZYDD.
+   ** Report a DD block which can't be read in.
+
+   * Hmergedd
+   ** Merge the DD blocks of a file on close.
+
+   * HPgetdiskblock/HPfreediskblock
+   ** Re-use the space of a deleted element after re-opening the file.
+   ** Re-use the space of a deleted element in the same open.
+
+   * Hwritebuf
+   ** Read back data still in the write buffer.
+   ** Turn the write buffer off for a file.
+
+   * Hgetiostats
+   ** Count the DD blocks and reads of opening a file.
+   ** Count the read of an element.
+   ** Include an open file in the statistics of all files.
+
+   * Hreadv
+   ** Read parts of several elements, asked for out of file order.
+   ** Read them with one read.
+   ** Ask for an element which doesn't exist.
+
+   * Hreadahead
+   ** Read ahead of a sequential read of an element.
+
+   * DFACC_LARGE
+   ** Create a file in the large file format, with several DD blocks.
+   ** Re-open it with DFACC_RDWR and add to it.
+   ** Place an element past 2 GB in it.
+   ** Don't let a file in the old format grow past 2 GB.
+
  */
 
 #include "tproto.h"
+#include "hfile.h"
 #define TESTFILE_NAME "t.hdf"
+#define TESTFILE_NAME1 "tdriver.hdf"
+#define LAZYFILE_NAME "tlazydd.hdf"
 #define BUF_SIZE        4096
 
 static uint8  outbuf[BUF_SIZE],  inbuf[BUF_SIZE];
@@ -61,8 +114,12 @@ test_hfile(void)
     int16       acc_mode, special;
     int32       ret;
     int         i;
-    intn        errors = 0;
     intn        ret_bool;
+    hdf_iostats_t stats, stats1, all_stats;
+    hdf_readreq_t reqs[3];
+    FILE       *fp;
+    char        magic[MAGICLEN];
+    size_t      nbytes;
 
     for (i = 0; i < BUF_SIZE; i++)
         outbuf[i] = (char) (i % 256);
@@ -98,7 +155,7 @@ test_hfile(void)
     if (ret != 2000)
       {
           fprintf(stderr, "Line %d: Hgetelement returned wrong count: %d\n", (int)__LINE__, (int) ret);
-          errors++;
+          num_errs++;
       }
 
     for (i = 0; i < ret; i++)
@@ -135,7 +192,7 @@ test_hfile(void)
     if (ret != 14)
       {
           fprintf(stderr, "ERROR: Hread returned the wrong length: %d\n", (int) ret);
-          errors++;
+          num_errs++;
       }
 
     if (HDstrcmp((const char *) inbuf, (const char *) "testing 100 1"))
@@ -143,7 +200,7 @@ test_hfile(void)
           fprintf(stderr, "ERROR: Hread returned the wrong data\n");
           fprintf(stderr, "\t       Is: %s\n", (char *) inbuf);
           fprintf(stderr, "\tShould be: testing 100 1\n");
-          errors++;
+          num_errs++;
       }
 
     ret = (int32)Hnewref(fid);
@@ -163,7 +220,7 @@ test_hfile(void)
       {
           fprintf(stderr, "ERROR: Found a non-existant element at line %d\n",
                   __LINE__);
-          errors++;
+          num_errs++;
       }
 
     ret = Hnextread(aid1, DFTAG_WILDCARD, DFREF_WILDCARD, DF_START);
@@ -178,7 +235,7 @@ test_hfile(void)
       {
           fprintf(stderr, "ERROR: Found a non-existant element at line %d\n",
                   __LINE__);
-          errors++;
+          num_errs++;
       }
 
     ret = Hnextread(aid1, DFTAG_WILDCARD, 2, DF_CURRENT);
@@ -192,14 +249,14 @@ test_hfile(void)
     if (aid2 == FAIL)
       {
           fprintf(stderr, "ERROR: was not allowed to startwrite on existing object\n");
-          errors++;
+          num_errs++;
       }
 
     ret = Hwrite(aid1, 4, "ABCD");
     if (ret != FAIL)
       {
           fprintf(stderr, "ERROR: was allowed to write to read access object\n");
-          errors++;
+          num_errs++;
       }
 
     ret = Hendaccess(aid1);
@@ -214,7 +271,7 @@ test_hfile(void)
     if (fid1 == FAIL)
       {
           fprintf(stderr, "ERROR: Failed to have two concurrent access to file\n");
-          errors++;
+          num_errs++;
       }
 
     ret = (int32)Hnewref(fid1);
@@ -226,9 +283,730 @@ test_hfile(void)
     ret = Hclose(fid1);
     CHECK_VOID(ret, FAIL, "Hclose");
 
+    MESSAGE(5, printf("Reading a memory-mapped file\n");
+        );
+    ret = Hmmap(MMAP_ALL_FILES, TRUE);
+    CHECK_VOID(ret, FAIL, "Hmmap");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hmmap(MMAP_ALL_FILES, FALSE);
+    CHECK_VOID(ret, FAIL, "Hmmap");
+
+    ret = Hgetelement(fid, 102, 2, inbuf);
+    VERIFY_VOID(ret, BUF_SIZE, "Hgetelement");
+    if (HDmemcmp(inbuf, outbuf, BUF_SIZE))
+      {
+          fprintf(stderr, "ERROR: Hgetelement returned the wrong data from a mapped file\n");
+          num_errs++;
+      }
+
+    ret = Hmmap(fid, FALSE);
+    CHECK_VOID(ret, FAIL, "Hmmap");
+
+#if defined(H4_HAVE_MMAP) && defined(H4_HAVE_MUNMAP)
+    ret = Hmmap(fid, TRUE);
+    CHECK_VOID(ret, FAIL, "Hmmap");
+#endif /* H4_HAVE_MMAP && H4_HAVE_MUNMAP */
+
+    /* re-opening for writing drops the mapping */
+    fid1 = Hopen(TESTFILE_NAME, DFACC_RDWR, 0);
+    CHECK_VOID(fid1, FAIL, "Hopen");
+
+    ret = Hmmap(fid1, TRUE);
+    VERIFY_VOID(ret, FAIL, "Hmmap");
+
+    HDmemset(inbuf, 0, BUF_SIZE);
+    ret = Hgetelement(fid1, 102, 2, inbuf);
+    VERIFY_VOID(ret, BUF_SIZE, "Hgetelement");
+    if (HDmemcmp(inbuf, outbuf, BUF_SIZE))
+      {
+          fprintf(stderr, "ERROR: Hgetelement returned the wrong data after re-opening\n");
+          num_errs++;
+      }
+
+    ret = Hclose(fid1);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    MESSAGE(5, printf("Writing a file with the core driver\n");
+        );
+    ret = Hsetdriver(HDF_DRIVER_CORE);
+    CHECK_VOID(ret, FAIL, "Hsetdriver");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_CREATE, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hsetdriver(HDF_DRIVER_DEFAULT);
+    CHECK_VOID(ret, FAIL, "Hsetdriver");
+
+    ret = Hgetdriver(fid);
+    VERIFY_VOID(ret, HDF_DRIVER_CORE, "Hgetdriver");
+
+    ret = Hputelement(fid, 102, 2, outbuf, BUF_SIZE);
+    CHECK_VOID(ret, FAIL, "Hputelement");
+
+    /* files already open keep their driver */
+    fid1 = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid1, FAIL, "Hopen");
+
+    ret = Hgetdriver(fid1);
+    VERIFY_VOID(ret, HDF_DRIVER_CORE, "Hgetdriver");
+
+    ret = Hclose(fid1);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hgetdriver(fid);
+    CHECK_VOID(ret, HDF_DRIVER_CORE, "Hgetdriver");
+
+    HDmemset(inbuf, 0, BUF_SIZE);
+    ret = Hgetelement(fid, 102, 2, inbuf);
+    VERIFY_VOID(ret, BUF_SIZE, "Hgetelement");
+    if (HDmemcmp(inbuf, outbuf, BUF_SIZE))
+      {
+          fprintf(stderr, "ERROR: Hgetelement returned the wrong data from a core driver file\n");
+          num_errs++;
+      }
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    ret = Hsetdriver(-1);
+    VERIFY_VOID(ret, FAIL, "Hsetdriver");
+
+    MESSAGE(5, printf("Opening a file with a driver for that open only\n");
+        );
+    fid = Hopendriver(TESTFILE_NAME, DFACC_READ, 0, HDF_DRIVER_CORE);
+    CHECK_VOID(fid, FAIL, "Hopendriver");
+
+    ret = Hgetdriver(fid);
+    VERIFY_VOID(ret, HDF_DRIVER_CORE, "Hgetdriver");
+
+    /* the default driver is still the default one */
+    fid1 = Hopen(TESTFILE_NAME1, DFACC_CREATE, 0);
+    CHECK_VOID(fid1, FAIL, "Hopen");
+
+    ret = Hgetdriver(fid1);
+    CHECK_VOID(ret, HDF_DRIVER_CORE, "Hgetdriver");
+
+    ret = Hclose(fid1);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    fid = Hopendriver(TESTFILE_NAME, DFACC_READ, 0, -1);
+    VERIFY_VOID(fid, FAIL, "Hopendriver");
+
+    /* the core driver can't hold a file past 2 GB */
+    fid = Hopendriver(TESTFILE_NAME1, DFACC_CREATE | DFACC_LARGE, 0, HDF_DRIVER_CORE);
+    VERIFY_VOID(fid, FAIL, "Hopendriver");
+    if (HEvalue(1) != DFE_UNSUPPORTED)
+      {
+          fprintf(stderr, "ERROR: creating a large file with the core driver didn't fail with DFE_UNSUPPORTED\n");
+          num_errs++;
+      }
+
+    MESSAGE(5, printf("Reading the DD list of a file lazily\n");
+        );
+    fid = Hopen(TESTFILE_NAME, DFACC_CREATE, MIN_NDDS);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    /* spread the elements over many DD blocks */
+    for (i = 1; i <= 20; i++)
+      {
+          ret = Hputelement(fid, 103, (uint16) i, &outbuf[i], 16);
+          CHECK_VOID(ret, FAIL, "Hputelement");
+      }
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    ret = Hsetlazydd(TRUE);
+    CHECK_VOID(ret, FAIL, "Hsetlazydd");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hsetlazydd(FALSE);
+    CHECK_VOID(ret, FAIL, "Hsetlazydd");
+
+    /* the last element is in the last DD block */
+    ret = Hgetelement(fid, 103, 20, inbuf);
+    VERIFY_VOID(ret, 16, "Hgetelement");
+    if (HDmemcmp(inbuf, &outbuf[20], 16))
+      {
+          fprintf(stderr, "ERROR: Hgetelement returned the wrong data from a lazily read file\n");
+          num_errs++;
+      }
+
+    ret = Hnumber(fid, 103);
+    VERIFY_VOID(ret, 20, "Hnumber");
+
+    /* writing needs the whole DD list */
+    fid1 = Hopen(TESTFILE_NAME, DFACC_RDWR, 0);
+    CHECK_VOID(fid1, FAIL, "Hopen");
+
+    ret = Hputelement(fid1, 103, 21, &outbuf[21], 16);
+    CHECK_VOID(ret, FAIL, "Hputelement");
+
+    ret = Hclose(fid1);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hnumber(fid, 103);
+    VERIFY_VOID(ret, 21, "Hnumber");
+
+    ret = Hgetelement(fid, 103, 21, inbuf);
+    VERIFY_VOID(ret, 16, "Hgetelement");
+    if (HDmemcmp(inbuf, &outbuf[21], 16))
+      {
+          fprintf(stderr, "ERROR: Hgetelement returned the wrong data after writing a lazily read file\n");
+          num_errs++;
+      }
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    /* a copy of the file cut off after its first DD block, so the other
+       DD blocks can't be read in */
+    nbytes = MAGICLEN + NDDS_SZ + OFFSET_SZ + MIN_NDDS * DD_SZ;
+    if ((fp = fopen(TESTFILE_NAME, "rb")) == NULL
+        || fread(inbuf, 1, nbytes, fp) != nbytes)
+      {
+          fprintf(stderr, "ERROR: can't read %s\n", TESTFILE_NAME);
+          num_errs++;
+      }
+    if (fp != NULL)
+        fclose(fp);
+    if ((fp = fopen(LAZYFILE_NAME, "wb")) == NULL
+        || fwrite(inbuf, 1, nbytes, fp) != nbytes)
+      {
+          fprintf(stderr, "ERROR: can't write %s\n", LAZYFILE_NAME);
+          num_errs++;
+      }
+    if (fp != NULL)
+        fclose(fp);
+
+    /* only this open is lazy, Hsetlazydd is off */
+    fid = Hopen(LAZYFILE_NAME, DFACC_READ | DFACC_LAZYDD, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    /* a DD block which can't be read is an error, not a missing tag/ref */
+    ret = HDcheck_tagref(fid, 103, 20);
+    VERIFY_VOID(ret, FAIL, "HDcheck_tagref");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    /* without lazy reading the whole DD list is read at Hopen */
+    fid = Hopen(LAZYFILE_NAME, DFACC_READ, 0);
+    VERIFY_VOID(fid, FAIL, "Hopen");
+
+    MESSAGE(5, printf("Merging the DD blocks of a file\n");
+        );
+    fid = Hopen(TESTFILE_NAME, DFACC_RDWR, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hmergedd(fid, TRUE);
+    CHECK_VOID(ret, FAIL, "Hmergedd");
+
+    /* leave a hole in the DD list */
+    ret = Hdeldd(fid, 103, 5);
+    CHECK_VOID(ret, FAIL, "Hdeldd");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hnumber(fid, 103);
+    VERIFY_VOID(ret, 20, "Hnumber");
+
+    for (i = 1; i <= 21; i++)
+      {
+          if (i == 5)
+              continue;
+          ret = Hgetelement(fid, 103, (uint16) i, inbuf);
+          VERIFY_VOID(ret, 16, "Hgetelement");
+          if (HDmemcmp(inbuf, &outbuf[i], 16))
+            {
+                fprintf(stderr, "ERROR: Hgetelement returned the wrong data for ref %d after merging the DD blocks\n", i);
+                num_errs++;
+            }
+      }
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    MESSAGE(5, printf("Re-using the space of deleted elements\n");
+        );
+    fid = Hopen(TESTFILE_NAME, DFACC_CREATE, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    for (i = 1; i <= 4; i++)
+      {
+          ret = Hputelement(fid, 103, (uint16) i, &outbuf[i], 16);
+          CHECK_VOID(ret, FAIL, "Hputelement");
+      }
+
+    offset = Hoffset(fid, 103, 2);
+    CHECK_VOID(offset, FAIL, "Hoffset");
+
+    ret = Hdeldd(fid, 103, 2);
+    CHECK_VOID(ret, FAIL, "Hdeldd");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    /* the free space is remembered in the file */
+    fid = Hopen(TESTFILE_NAME, DFACC_RDWR, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hputelement(fid, 103, 30, &outbuf[30], 16);
+    CHECK_VOID(ret, FAIL, "Hputelement");
+
+    ret = Hoffset(fid, 103, 30);
+    VERIFY_VOID(ret, offset, "Hoffset");
+
+    /* and space freed while the file is open is used right away */
+    offset = Hoffset(fid, 103, 3);
+    CHECK_VOID(offset, FAIL, "Hoffset");
+
+    ret = Hdeldd(fid, 103, 3);
+    CHECK_VOID(ret, FAIL, "Hdeldd");
+
+    ret = Hputelement(fid, 103, 31, &outbuf[31], 16);
+    CHECK_VOID(ret, FAIL, "Hputelement");
+
+    ret = Hoffset(fid, 103, 31);
+    VERIFY_VOID(ret, offset, "Hoffset");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hnumber(fid, 103);
+    VERIFY_VOID(ret, 4, "Hnumber");
+
+    ret = Hgetelement(fid, 103, 31, inbuf);
+    VERIFY_VOID(ret, 16, "Hgetelement");
+    if (HDmemcmp(inbuf, &outbuf[31], 16))
+      {
+          fprintf(stderr, "ERROR: Hgetelement returned the wrong data from re-used space\n");
+          num_errs++;
+      }
+
+    ret = Hgetelement(fid, 103, 4, inbuf);
+    VERIFY_VOID(ret, 16, "Hgetelement");
+    if (HDmemcmp(inbuf, &outbuf[4], 16))
+      {
+          fprintf(stderr, "ERROR: Hgetelement returned the wrong data next to re-used space\n");
+          num_errs++;
+      }
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    MESSAGE(5, printf("Gathering small writes in the write buffer\n");
+        );
+    fid = Hopen(TESTFILE_NAME, DFACC_CREATE, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hwritebuf(fid, -1);
+    VERIFY_VOID(ret, FAIL, "Hwritebuf");
+
+    ret = Hwritebuf(fid, 256);
+    CHECK_VOID(ret, FAIL, "Hwritebuf");
+
+    for (i = 1; i <= 8; i++)
+      {
+          ret = Hputelement(fid, 103, (uint16) i, &outbuf[i], 16);
+          CHECK_VOID(ret, FAIL, "Hputelement");
+      }
+
+    /* data not written out yet is read back from the buffer */
+    ret = Hgetelement(fid, 103, 5, inbuf);
+    VERIFY_VOID(ret, 16, "Hgetelement");
+    if (HDmemcmp(inbuf, &outbuf[5], 16))
+      {
+          fprintf(stderr, "ERROR: Hgetelement returned the wrong data from the write buffer\n");
+          num_errs++;
+      }
+
+    ret = Hsync(fid);
+    CHECK_VOID(ret, FAIL, "Hsync");
+
+    ret = Hwritebuf(fid, 0);
+    CHECK_VOID(ret, FAIL, "Hwritebuf");
+
+    ret = Hputelement(fid, 103, 9, &outbuf[9], 16);
+    CHECK_VOID(ret, FAIL, "Hputelement");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hnumber(fid, 103);
+    VERIFY_VOID(ret, 9, "Hnumber");
+
+    for (i = 1; i <= 9; i++)
+      {
+          ret = Hgetelement(fid, 103, (uint16) i, inbuf);
+          VERIFY_VOID(ret, 16, "Hgetelement");
+          if (HDmemcmp(inbuf, &outbuf[i], 16))
+            {
+                fprintf(stderr, "ERROR: Hgetelement returned the wrong data for ref %d written through the write buffer\n", i);
+                num_errs++;
+            }
+      }
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    MESSAGE(5, printf("Getting the I/O statistics of files\n");
+        );
+    ret = Hgetiostats(IOSTATS_ALL_FILES, &all_stats);
+    CHECK_VOID(ret, FAIL, "Hgetiostats");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hgetiostats(fid, NULL);
+    VERIFY_VOID(ret, FAIL, "Hgetiostats");
+
+    /* opening the file read the DD list */
+    ret = Hgetiostats(fid, &stats);
+    CHECK_VOID(ret, FAIL, "Hgetiostats");
+    if (stats.ndd_loads < 1 || stats.nreads < 1 || stats.nwrites != 0)
+      {
+          fprintf(stderr, "ERROR: Hgetiostats counted %lu DD blocks, %lu reads and %lu writes after opening a file\n",
+                  (unsigned long) stats.ndd_loads, (unsigned long) stats.nreads,
+                  (unsigned long) stats.nwrites);
+          num_errs++;
+      }
+
+    ret = Hgetelement(fid, 103, 5, inbuf);
+    VERIFY_VOID(ret, 16, "Hgetelement");
+
+    ret = Hgetiostats(fid, &stats1);
+    CHECK_VOID(ret, FAIL, "Hgetiostats");
+    if (stats1.nreads != stats.nreads + 1
+        || stats1.bytes_read != stats.bytes_read + 16
+        || stats1.nseeks + stats1.nseeks_avoided != stats1.nreads)
+      {
+          fprintf(stderr, "ERROR: Hgetiostats didn't count reading an element\n");
+          num_errs++;
+      }
+
+    /* the library-wide statistics include the file's */
+    ret = Hgetiostats(IOSTATS_ALL_FILES, &stats);
+    CHECK_VOID(ret, FAIL, "Hgetiostats");
+    if (stats.nreads != all_stats.nreads + stats1.nreads
+        || stats.ndd_loads != all_stats.ndd_loads + stats1.ndd_loads)
+      {
+          fprintf(stderr, "ERROR: Hgetiostats(IOSTATS_ALL_FILES) doesn't include the open file\n");
+          num_errs++;
+      }
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    MESSAGE(5, printf("Reading several elements at once\n");
+        );
+    fid = Hopen(TESTFILE_NAME, DFACC_CREATE, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    for (i = 1; i <= 6; i++)
+      {
+          ret = Hputelement(fid, 103, (uint16) i, &outbuf[i * 16], 16);
+          CHECK_VOID(ret, FAIL, "Hputelement");
+      }
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    /* ask for the elements out of the order they are in the file */
+    reqs[0].tag = 103;
+    reqs[0].ref = 5;
+    reqs[0].offset = 0;
+    reqs[0].length = 0;
+    reqs[0].buf = &inbuf[0];
+    reqs[1].tag = 103;
+    reqs[1].ref = 3;
+    reqs[1].offset = 4;
+    reqs[1].length = 8;
+    reqs[1].buf = &inbuf[100];
+    reqs[2].tag = 103;
+    reqs[2].ref = 1;
+    reqs[2].offset = 0;
+    reqs[2].length = 100;
+    reqs[2].buf = &inbuf[200];
+
+    ret = Hgetiostats(fid, &stats);
+    CHECK_VOID(ret, FAIL, "Hgetiostats");
+
+    ret = Hreadv(fid, 3, reqs);
+    CHECK_VOID(ret, FAIL, "Hreadv");
+    VERIFY_VOID(reqs[0].nread, 16, "Hreadv");
+    VERIFY_VOID(reqs[1].nread, 8, "Hreadv");
+    VERIFY_VOID(reqs[2].nread, 16, "Hreadv");
+    if (HDmemcmp(&inbuf[0], &outbuf[5 * 16], 16)
+        || HDmemcmp(&inbuf[100], &outbuf[3 * 16 + 4], 8)
+        || HDmemcmp(&inbuf[200], &outbuf[1 * 16], 16))
+      {
+          fprintf(stderr, "ERROR: Hreadv returned the wrong data\n");
+          num_errs++;
+      }
+
+    /* the elements are close together, so one read does for all of them */
+    ret = Hgetiostats(fid, &stats1);
+    CHECK_VOID(ret, FAIL, "Hgetiostats");
+    VERIFY_VOID(stats1.nreads - stats.nreads, 1, "Hreadv");
+
+    reqs[1].ref = 7;
+    ret = Hreadv(fid, 3, reqs);
+    VERIFY_VOID(ret, FAIL, "Hreadv");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    MESSAGE(5, printf("Reading ahead of sequential reads\n");
+        );
+    fid = Hopen(TESTFILE_NAME, DFACC_CREATE, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hputelement(fid, 104, 1, outbuf, BUF_SIZE);
+    CHECK_VOID(ret, FAIL, "Hputelement");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hreadahead(fid, -1);
+    VERIFY_VOID(ret, FAIL, "Hreadahead");
+
+    ret = Hreadahead(fid, 1024);
+    CHECK_VOID(ret, FAIL, "Hreadahead");
+
+    aid1 = Hstartread(fid, 104, 1);
+    CHECK_VOID(aid1, FAIL, "Hstartread");
+
+    for (i = 0; i < BUF_SIZE; i += 256)
+      {
+          ret = Hread(aid1, 256, &inbuf[i]);
+          VERIFY_VOID(ret, 256, "Hread");
+      }
+    if (HDmemcmp(inbuf, outbuf, BUF_SIZE))
+      {
+          fprintf(stderr, "ERROR: Hread returned the wrong data while reading ahead\n");
+          num_errs++;
+      }
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+
+#ifdef H4_HAVE_READAHEAD
+    /* 1024 bytes at a time, asked for again every 512 bytes read */
+    ret = Hgetiostats(fid, &stats);
+    CHECK_VOID(ret, FAIL, "Hgetiostats");
+    if (stats.nprefetches < 2 || stats.nprefetches > BUF_SIZE / 512)
+      {
+          fprintf(stderr, "ERROR: read ahead %lu times while reading an element\n",
+                  (unsigned long) stats.nprefetches);
+          num_errs++;
+      }
+#endif /* H4_HAVE_READAHEAD */
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    MESSAGE(5, printf("Creating a file in the large file format\n");
+        );
+    fid = Hopen(TESTFILE_NAME, DFACC_CREATE | DFACC_LARGE, 16);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    /* enough elements for several DD blocks */
+    for (i = 1; i <= 40; i++)
+      {
+          ret = Hputelement(fid, 103, (uint16) i, &outbuf[i], 16);
+          CHECK_VOID(ret, FAIL, "Hputelement");
+      }
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    if ((fp = fopen(TESTFILE_NAME, "rb")) == NULL
+        || fread(magic, 1, MAGICLEN, fp) != MAGICLEN
+        || HDmemcmp(magic, HDFMAGIC_LARGE, MAGICLEN))
+      {
+          fprintf(stderr, "ERROR: file created with DFACC_LARGE doesn't have the large file magic number\n");
+          num_errs++;
+      }
+    if (fp != NULL)
+        fclose(fp);
+
+    ret_bool = (intn) Hishdf(TESTFILE_NAME);
+    CHECK_VOID(ret_bool, FALSE, "Hishdf");
+
+    /* DFACC_LARGE doesn't matter for an existing file */
+    fid = Hopen(TESTFILE_NAME, DFACC_RDWR | DFACC_LARGE, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hdeldd(fid, 103, 5);
+    CHECK_VOID(ret, FAIL, "Hdeldd");
+
+    ret = Hputelement(fid, 104, 1, outbuf, BUF_SIZE);
+    CHECK_VOID(ret, FAIL, "Hputelement");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hnumber(fid, 103);
+    VERIFY_VOID(ret, 39, "Hnumber");
+
+    for (i = 1; i <= 40; i++)
+      {
+          if (i == 5)
+              continue;
+          ret = Hgetelement(fid, 103, (uint16) i, inbuf);
+          VERIFY_VOID(ret, 16, "Hgetelement");
+          if (HDmemcmp(inbuf, &outbuf[i], 16))
+            {
+                fprintf(stderr, "ERROR: Hgetelement returned the wrong data for ref %d in a large format file\n", i);
+                num_errs++;
+            }
+      }
+
+    ret = Hgetelement(fid, 104, 1, inbuf);
+    VERIFY_VOID(ret, BUF_SIZE, "Hgetelement");
+    if (HDmemcmp(inbuf, outbuf, BUF_SIZE))
+      {
+          fprintf(stderr, "ERROR: Hgetelement returned the wrong data for an element added to a large format file\n");
+          num_errs++;
+      }
+
+    aid1 = Hstartread(fid, 104, 1);
+    CHECK_VOID(aid1, FAIL, "Hstartread");
+
+    ret = Hinquire(aid1, NULL, NULL, NULL, &length, &offset, NULL, NULL, NULL);
+    CHECK_VOID(ret, FAIL, "Hinquire");
+    VERIFY_VOID(length, BUF_SIZE, "Hinquire");
+    VERIFY_VOID(Hoffset(fid, 104, 1), offset, "Hoffset");
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
     ret_bool = (intn) Hishdf(TESTFILE_NAME);
     CHECK_VOID(ret_bool, FALSE, "Hishdf");
 
+    MESSAGE(5, printf("Placing an element past 2 GB in a large format file\n");
+        );
+    fid = Hopen(TESTFILE_NAME, DFACC_RDWR, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    /* only the start of this element is written, the file stays sparse */
+    aid1 = Hstartwrite(fid, 105, 1, (int32) MAX_OFFSET32 - 2048);
+    CHECK_VOID(aid1, FAIL, "Hstartwrite");
+
+    ret = Hwrite(aid1, 16, outbuf);
+    VERIFY_VOID(ret, 16, "Hwrite");
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+
+    /* this one can only go past the 32-bit offsets */
+    ret = Hputelement(fid, 105, 2, outbuf, BUF_SIZE);
+    CHECK_VOID(ret, FAIL, "Hputelement");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hgetelement(fid, 105, 2, inbuf);
+    VERIFY_VOID(ret, BUF_SIZE, "Hgetelement");
+    if (HDmemcmp(inbuf, outbuf, BUF_SIZE))
+      {
+          fprintf(stderr, "ERROR: Hgetelement returned the wrong data for an element past 2 GB\n");
+          num_errs++;
+      }
+
+    ret = Hgetelement(fid, 104, 1, inbuf);
+    VERIFY_VOID(ret, BUF_SIZE, "Hgetelement");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    MESSAGE(5, printf("Growing a file in the old format past 2 GB\n");
+        );
+    fid = Hopen(TESTFILE_NAME, DFACC_CREATE, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    aid1 = Hstartwrite(fid, 105, 1, (int32) MAX_OFFSET32 - 2048);
+    CHECK_VOID(aid1, FAIL, "Hstartwrite");
+
+    ret = Hwrite(aid1, 16, outbuf);
+    VERIFY_VOID(ret, 16, "Hwrite");
+
+    ret = Hendaccess(aid1);
+    CHECK_VOID(ret, FAIL, "Hendaccess");
+
+    /* the DD list of the file has no room for the offset */
+    ret = Hputelement(fid, 105, 2, outbuf, BUF_SIZE);
+    VERIFY_VOID(ret, FAIL, "Hputelement");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    fid = Hopen(TESTFILE_NAME, DFACC_READ, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    /* the file is still good up to the element which didn't fit */
+    ret = Hlength(fid, 105, 1);
+    VERIFY_VOID(ret, (int32) MAX_OFFSET32 - 2048, "Hlength");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
+    /* don't leave the sparse file behind */
+    fid = Hopen(TESTFILE_NAME, DFACC_CREATE, 0);
+    CHECK_VOID(fid, FAIL, "Hopen");
+
+    ret = Hclose(fid);
+    CHECK_VOID(ret, FAIL, "Hclose");
+
     ret_bool = (intn) Hishdf(__FILE__);
     CHECK_VOID(ret_bool, TRUE, "Hishdf");
 
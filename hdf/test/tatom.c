@@ -0,0 +1,136 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Board of Trustees of the University of Illinois.         *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of HDF.  The full HDF copyright notice, including       *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the root of the source code       *
+ * distribution tree, or in https://support.hdfgroup.org/ftp/HDF/releases/.  *
+ * If you do not have access to either file, you may request a copy from     *
+ * help@hdfgroup.org.                                                        *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* $Id$ */
+
+/*
+   FILE
+   tatom.c
+   Test HDF atom routines.
+
+   REMARKS
+   Registers many more atoms in a group than its hash table starts with,
+   so that the table has to grow, and checks that every atom still finds
+   its object, through the growing and after atoms are removed.
+
+ */
+
+#include "tproto.h"
+#include "atom.h"
+
+#define ATOM_TEST_GROUP     BITIDGROUP  /* group the test registers in */
+#define ATOM_TEST_HASH      4           /* hash size the group starts with */
+#define ATOM_TEST_NATOMS    20000       /* number of atoms to register */
+
+PRIVATE intn atom_match
+            (const void *obj, const void *key);
+
+/* HAsearch_atom comparison, the objects are int32s */
+PRIVATE intn
+atom_match(const void *obj, const void *key)
+{
+    return (*(const int32 *) obj == *(const int32 *) key);
+}
+
+void
+test_atom(void)
+{
+    int32      *objs;
+    atom_t     *atoms;
+    int32       key;
+    VOIDP       obj;
+    intn        ret;
+    intn        i;
+
+    objs = (int32 *) HDmalloc(ATOM_TEST_NATOMS * sizeof(int32));
+    atoms = (atom_t *) HDmalloc(ATOM_TEST_NATOMS * sizeof(atom_t));
+    if (objs == NULL || atoms == NULL)
+      {
+          fprintf(stderr, "ERROR: out of memory\n");
+          num_errs++;
+          return;
+      }
+
+    MESSAGE(5, printf("Registering %d atoms in a group of hash size %d\n",
+                      ATOM_TEST_NATOMS, ATOM_TEST_HASH););
+    ret = HAinit_group(ATOM_TEST_GROUP, ATOM_TEST_HASH);
+    CHECK_VOID(ret, FAIL, "HAinit_group");
+
+    for (i = 0; i < ATOM_TEST_NATOMS; i++)
+      {
+          objs[i] = i;
+          atoms[i] = HAregister_atom(ATOM_TEST_GROUP, &objs[i]);
+          CHECK_VOID(atoms[i], FAIL, "HAregister_atom");
+
+          /* the atoms registered so far must survive the table growing */
+          if (i % 1000 == 999 && HAatom_object(atoms[i / 2]) != &objs[i / 2])
+            {
+                fprintf(stderr, "ERROR: atom %d lost after %d registrations\n", (int) (i / 2), (int) (i + 1));
+                num_errs++;
+            }
+      }
+
+    MESSAGE(5, printf("Looking up all the atoms\n"););
+    for (i = 0; i < ATOM_TEST_NATOMS; i++)
+      {
+          obj = HAatom_object(atoms[i]);
+          if (obj != &objs[i])
+            {
+                fprintf(stderr, "ERROR: atom %d maps to the wrong object\n", (int) i);
+                num_errs++;
+                break;
+            }
+          if (HAatom_group(atoms[i]) != ATOM_TEST_GROUP)
+            {
+                fprintf(stderr, "ERROR: atom %d is in the wrong group\n", (int) i);
+                num_errs++;
+                break;
+            }
+      }
+
+    key = ATOM_TEST_NATOMS - 1;
+    obj = HAsearch_atom(ATOM_TEST_GROUP, atom_match, &key);
+    VERIFY_VOID(obj, &objs[ATOM_TEST_NATOMS - 1], "HAsearch_atom");
+
+    MESSAGE(5, printf("Removing every other atom\n"););
+    for (i = 0; i < ATOM_TEST_NATOMS; i += 2)
+      {
+          obj = HAremove_atom(atoms[i]);
+          if (obj != &objs[i])
+            {
+                fprintf(stderr, "ERROR: removing atom %d returned the wrong object\n", (int) i);
+                num_errs++;
+                break;
+            }
+      }
+    for (i = 0; i < ATOM_TEST_NATOMS; i++)
+      {
+          obj = HAatom_object(atoms[i]);
+          if (obj != ((i % 2) ? &objs[i] : NULL))
+            {
+                fprintf(stderr, "ERROR: atom %d found %s after removing\n", (int) i,
+                        (i % 2) ? "the wrong object" : "an object");
+                num_errs++;
+                break;
+            }
+      }
+    HEclear();
+
+    for (i = 1; i < ATOM_TEST_NATOMS; i += 2)
+        HAremove_atom(atoms[i]);
+    ret = HAdestroy_group(ATOM_TEST_GROUP);
+    CHECK_VOID(ret, FAIL, "HAdestroy_group");
+
+    HDfree(objs);
+    HDfree(atoms);
+}
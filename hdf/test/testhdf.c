@@ -127,6 +127,8 @@ main(int argc, char *argv[])
     InitTest("bitvect", test_bitvect, "Bit-Vector routines");
     InitTest("tbbt", test_tbbt, "Threaded Balanced Binary Trees");
 #endif
+    InitTest("atom", test_atom, "ATOM GROUPS");
+    InitTest("mcache", test_mcache, "CHUNK CACHE POLICIES");
     InitTest("vers", test_vers, "VERSION OF LIBRARY");
     InitTest("hfile", test_hfile, "HFILE");
     InitTest("hfile1", test_hfile1, "HFILE LIMITS");
@@ -160,6 +162,7 @@ main(int argc, char *argv[])
     InitTest("datainfo", test_datainfo, "Getting Raw Data's Spatial Information");
     InitTest("attdatainfo", test_attdatainfo, "Getting Raw Data's Spatial Information of Attributes");
     InitTest("mfgr", test_mgr, "Multi-File Generic Raster Image Interface");
+    InitTest("thread", test_thread, "THREAD-SAFETY");
 
     Verbosity = 4;  /* Default Verbosity is Low */
     Hgetlibversion(&lmajor, &lminor, &lrelease, lstring);
@@ -0,0 +1,322 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Board of Trustees of the University of Illinois.         *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of HDF.  The full HDF copyright notice, including       *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the root of the source code       *
+ * distribution tree, or in https://support.hdfgroup.org/ftp/HDF/releases/.  *
+ * If you do not have access to either file, you may request a copy from     *
+ * help@hdfgroup.org.                                                        *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* $Id$ */
+
+/*
+   * Hthreadsafe
+   ** Report whether the library is thread-safe.
+
+   * Several threads, each with a file of its own
+   ** Create the file and write elements and a vdata into it.
+   ** Re-open it and read everything back.
+   ** Make a call fail, to push onto the error stack, and check that
+      the error shows on the stack of that thread only.
+
+   * Several threads reading the same file
+   ** Each opens the file read-only and reads all the elements, plain
+      and compressed, through access ids of its own.
+
+ */
+
+#include "tproto.h"
+
+#ifdef H4_HAVE_THREADSAFE
+#include <pthread.h>
+
+#define TS_NTHREADS     4
+#define TS_NELEMS       20
+#define TS_ELEM_SIZE    512
+#define TS_NRECS        100
+#define TS_TAG          ((uint16) 1000)
+#define TS_COMP_TAG     ((uint16) 1001)
+#define TS_SHARED_FILE  "tthreads.hdf"
+#define TS_NPASSES      10
+
+typedef struct
+{
+    intn        index;          /* number of the thread */
+    intn        errors;         /* errors the thread found */
+} ts_thread_t;
+
+static void *ts_thread(void *arg);
+
+static intn ts_write_shared(void);
+
+static void *ts_read_shared(void *arg);
+
+/* Create a file of its own, write it, read it back and check it */
+static void *
+ts_thread(void *arg)
+{
+    ts_thread_t *th = (ts_thread_t *) arg;
+    char        fname[32];
+    uint8       outbuf[TS_ELEM_SIZE], inbuf[TS_ELEM_SIZE];
+    int32       recs[TS_NRECS], inrecs[TS_NRECS];
+    int32       fid, vsid, vsref;
+    int32       ret;
+    intn        i, j;
+
+    sprintf(fname, "tthread%d.hdf", th->index);
+
+    fid = Hopen(fname, DFACC_CREATE, 0);
+    if (fid == FAIL)
+      {
+          th->errors++;
+          return NULL;
+      }
+    for (i = 0; i < TS_NELEMS; i++)
+      {
+          for (j = 0; j < TS_ELEM_SIZE; j++)
+              outbuf[j] = (uint8) (th->index + i + j);
+          if (Hputelement(fid, TS_TAG, (uint16) (i + 1), outbuf, TS_ELEM_SIZE) == FAIL)
+              th->errors++;
+      }
+
+    /* Vdatas go through the atom groups and the Vset buffers */
+    Vstart(fid);
+    vsid = VSattach(fid, -1, "w");
+    if (vsid == FAIL)
+        th->errors++;
+    else
+      {
+          for (i = 0; i < TS_NRECS; i++)
+              recs[i] = th->index * TS_NRECS + i;
+          VSfdefine(vsid, "VALUE", DFNT_INT32, 1);
+          VSsetfields(vsid, "VALUE");
+          VSsetname(vsid, "thread");
+          if (VSwrite(vsid, (uint8 *) recs, TS_NRECS, FULL_INTERLACE) != TS_NRECS)
+              th->errors++;
+          VSdetach(vsid);
+      }
+    Vend(fid);
+
+    /* Hclose of a file id which is not valid pushes onto the error stack */
+    ret = Hclose(fid + 1000);
+    if (ret != FAIL || HEvalue(1) == DFE_NONE)
+        th->errors++;
+
+    if (Hclose(fid) == FAIL)
+        th->errors++;
+
+    fid = Hopen(fname, DFACC_READ, 0);
+    if (fid == FAIL)
+      {
+          th->errors++;
+          return NULL;
+      }
+    if (Hnumber(fid, TS_TAG) != TS_NELEMS)
+        th->errors++;
+    for (i = 0; i < TS_NELEMS; i++)
+      {
+          if (Hgetelement(fid, TS_TAG, (uint16) (i + 1), inbuf) != TS_ELEM_SIZE)
+            {
+                th->errors++;
+                continue;
+            }
+          for (j = 0; j < TS_ELEM_SIZE; j++)
+              if (inbuf[j] != (uint8) (th->index + i + j))
+                {
+                    th->errors++;
+                    break;
+                }
+      }
+
+    Vstart(fid);
+    vsref = VSfind(fid, "thread");
+    vsid = (vsref > 0) ? VSattach(fid, vsref, "r") : FAIL;
+    if (vsid == FAIL)
+        th->errors++;
+    else
+      {
+          VSsetfields(vsid, "VALUE");
+          if (VSread(vsid, (uint8 *) inrecs, TS_NRECS, FULL_INTERLACE) != TS_NRECS)
+              th->errors++;
+          for (i = 0; i < TS_NRECS; i++)
+              if (inrecs[i] != th->index * TS_NRECS + i)
+                {
+                    th->errors++;
+                    break;
+                }
+          VSdetach(vsid);
+      }
+    Vend(fid);
+
+    if (Hclose(fid) == FAIL)
+        th->errors++;
+    return NULL;
+}
+
+/* Write the file all the threads read, plain and deflated elements */
+static intn
+ts_write_shared(void)
+{
+    uint8       outbuf[TS_ELEM_SIZE];
+    model_info  m_info;
+    comp_info   c_info;
+    int32       fid, aid;
+    intn        errors = 0;
+    intn        i, j;
+
+    fid = Hopen(TS_SHARED_FILE, DFACC_CREATE, 0);
+    if (fid == FAIL)
+        return 1;
+    c_info.deflate.level = 6;
+    for (i = 0; i < TS_NELEMS; i++)
+      {
+          for (j = 0; j < TS_ELEM_SIZE; j++)
+              outbuf[j] = (uint8) (i * j);
+          if (Hputelement(fid, TS_TAG, (uint16) (i + 1), outbuf, TS_ELEM_SIZE) == FAIL)
+              errors++;
+          aid = HCcreate(fid, TS_COMP_TAG, (uint16) (i + 1), COMP_MODEL_STDIO,
+                         &m_info, COMP_CODE_DEFLATE, &c_info);
+          if (aid == FAIL)
+            {
+                errors++;
+                continue;
+            }
+          if (Hwrite(aid, TS_ELEM_SIZE, outbuf) != TS_ELEM_SIZE)
+              errors++;
+          Hendaccess(aid);
+      }
+    if (Hclose(fid) == FAIL)
+        errors++;
+    return errors;
+}
+
+/* Open the shared file read-only and read it all, several times over */
+static void *
+ts_read_shared(void *arg)
+{
+    ts_thread_t *th = (ts_thread_t *) arg;
+    uint8       inbuf[TS_ELEM_SIZE];
+    uint16      tag;
+    int32       fid, aid;
+    intn        pass, i, j;
+
+    fid = Hopen(TS_SHARED_FILE, DFACC_READ, 0);
+    if (fid == FAIL)
+      {
+          th->errors++;
+          return NULL;
+      }
+    for (pass = 0; pass < TS_NPASSES; pass++)
+        for (i = 0; i < 2 * TS_NELEMS; i++)
+          {
+              /* start each thread at a different element */
+              intn        n = (i + th->index * 5) % (2 * TS_NELEMS);
+
+              tag = (n % 2) ? TS_COMP_TAG : TS_TAG;
+              aid = Hstartread(fid, tag, (uint16) (n / 2 + 1));
+              if (aid == FAIL)
+                {
+                    th->errors++;
+                    continue;
+                }
+              if (Hread(aid, TS_ELEM_SIZE, inbuf) != TS_ELEM_SIZE)
+                  th->errors++;
+              else
+                  for (j = 0; j < TS_ELEM_SIZE; j++)
+                      if (inbuf[j] != (uint8) ((n / 2) * j))
+                        {
+                            th->errors++;
+                            break;
+                        }
+              Hendaccess(aid);
+          }
+    if (Hclose(fid) == FAIL)
+        th->errors++;
+    return NULL;
+}
+#endif /* H4_HAVE_THREADSAFE */
+
+void
+test_thread(void)
+{
+#ifdef H4_HAVE_THREADSAFE
+    pthread_t   threads[TS_NTHREADS];
+    ts_thread_t th[TS_NTHREADS];
+    intn        i;
+
+    MESSAGE(5, printf("Testing Hthreadsafe\n"););
+    if (Hthreadsafe() != TRUE)
+      {
+          fprintf(stderr, "Hthreadsafe reports a library which is not thread-safe\n");
+          num_errs++;
+      }
+
+    MESSAGE(5, printf("Reading and writing files from %d threads\n", TS_NTHREADS););
+    HEclear();
+    for (i = 0; i < TS_NTHREADS; i++)
+      {
+          th[i].index = i;
+          th[i].errors = 0;
+          if (pthread_create(&threads[i], NULL, ts_thread, &th[i]) != 0)
+            {
+                fprintf(stderr, "pthread_create failed\n");
+                num_errs++;
+                return;
+            }
+      }
+    for (i = 0; i < TS_NTHREADS; i++)
+      {
+          pthread_join(threads[i], NULL);
+          if (th[i].errors != 0)
+            {
+                fprintf(stderr, "Thread %d found %d errors\n", (int) i, (int) th[i].errors);
+                num_errs += th[i].errors;
+            }
+      }
+    if (HEvalue(1) != DFE_NONE)
+      {
+          fprintf(stderr, "Errors of the threads show on the main thread's stack\n");
+          num_errs++;
+      }
+
+    MESSAGE(5, printf("Reading one file from %d threads\n", TS_NTHREADS););
+    if (ts_write_shared() != 0)
+      {
+          fprintf(stderr, "Could not write %s\n", TS_SHARED_FILE);
+          num_errs++;
+          return;
+      }
+    for (i = 0; i < TS_NTHREADS; i++)
+      {
+          th[i].index = i;
+          th[i].errors = 0;
+          if (pthread_create(&threads[i], NULL, ts_read_shared, &th[i]) != 0)
+            {
+                fprintf(stderr, "pthread_create failed\n");
+                num_errs++;
+                return;
+            }
+      }
+    for (i = 0; i < TS_NTHREADS; i++)
+      {
+          pthread_join(threads[i], NULL);
+          if (th[i].errors != 0)
+            {
+                fprintf(stderr, "Thread %d found %d errors\n", (int) i, (int) th[i].errors);
+                num_errs += th[i].errors;
+            }
+      }
+#else  /* H4_HAVE_THREADSAFE */
+    MESSAGE(5, printf("Testing Hthreadsafe\n"););
+    if (Hthreadsafe() != FALSE)
+      {
+          fprintf(stderr, "Hthreadsafe reports a thread-safe library\n");
+          num_errs++;
+      }
+    MESSAGE(5, printf("Library is not thread-safe, skipping the thread tests\n"););
+#endif /* H4_HAVE_THREADSAFE */
+}
@@ -0,0 +1,261 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Board of Trustees of the University of Illinois.         *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of HDF.  The full HDF copyright notice, including       *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the root of the source code       *
+ * distribution tree, or in https://support.hdfgroup.org/ftp/HDF/releases/.  *
+ * If you do not have access to either file, you may request a copy from     *
+ * help@hdfgroup.org.                                                        *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* $Id$ */
+
+/*
+   FILE
+   tmcache.c
+   Test the eviction policies and the byte limit of the page cache.
+
+   REMARKS
+   Runs a cache over a made up object whose page in and page out
+   filters count the pages read and written.  Checks that a page used
+   twice survives a long scan with 2Q but not with LRU, that CLOCK
+   passes over a page used since its last sweep, that lowering the
+   byte limit shrinks the cache, writing out its dirty pages, and that
+   dirty pages are written out together through the batch page out
+   filter, on eviction only as many as the worker pool has threads.
+
+ */
+
+#include "tproto.h"
+#include "mcache.h"
+
+#define MC_PAGESIZE   64        /* bytes in a page */
+#define MC_NPAGES     100       /* pages in the object */
+#define MC_MAXCACHE   8         /* pages the cache holds */
+#define MC_SCAN       60        /* pages of the scan */
+
+/* What the filters count */
+typedef struct
+{
+    int32       reads;          /* pages read in */
+    int32       writes;         /* pages written out */
+    int32       bad;            /* pages found with the wrong contents */
+    int32       batches;        /* calls of the batch page out filter */
+}
+mc_count_t;
+
+PRIVATE int32 mc_pgin
+            (VOID *cookie, int32 pgno, VOID *page);
+
+PRIVATE int32 mc_pgout
+            (VOID *cookie, int32 pgno, const VOID *page);
+
+PRIVATE int32 mc_pgoutv
+            (VOID *cookie, int32 npages, const int32 *pgnos, VOID **pages);
+
+PRIVATE intn mc_use
+            (MCACHE *mp, int32 pgno, int32 flags);
+
+PRIVATE MCACHE *mc_open
+            (mc_count_t *count, intn policy);
+
+/* page in filter, a page holds its number (0 based) in every byte */
+PRIVATE int32
+mc_pgin(VOID *cookie, int32 pgno, VOID *page)
+{
+    ((mc_count_t *) cookie)->reads++;
+    HDmemset(page, (int) (pgno & 0xff), MC_PAGESIZE);
+    return (SUCCEED);
+}
+
+/* page out filter */
+PRIVATE int32
+mc_pgout(VOID *cookie, int32 pgno, const VOID *page)
+{
+    ((mc_count_t *) cookie)->writes++;
+    if (*(const uint8 *) page != (uint8) (pgno & 0xff))
+        ((mc_count_t *) cookie)->bad++;
+    return (SUCCEED);
+}
+
+/* batch page out filter */
+PRIVATE int32
+mc_pgoutv(VOID *cookie, int32 npages, const int32 *pgnos, VOID **pages)
+{
+    int32       i;
+
+    ((mc_count_t *) cookie)->batches++;
+    for (i = 0; i < npages; i++)
+        mc_pgout(cookie, pgnos[i], pages[i]);
+    return (SUCCEED);
+}
+
+/* get a page, check it and put it back */
+PRIVATE intn
+mc_use(MCACHE *mp, int32 pgno, int32 flags)
+{
+    uint8      *page;
+
+    if ((page = (uint8 *) mcache_get(mp, pgno, 0)) == NULL)
+        return (FAIL);
+    if (page[MC_PAGESIZE - 1] != (uint8) ((pgno - 1) & 0xff))
+        return (FAIL);
+    return (mcache_put(mp, page, flags));
+}
+
+/* a cache of MC_MAXCACHE pages with the given policy */
+PRIVATE MCACHE *
+mc_open(mc_count_t *count, intn policy)
+{
+    MCACHE     *mp;
+
+    HDmemset(count, 0, sizeof(mc_count_t));
+    if ((mp = mcache_open(NULL, 0, MC_PAGESIZE, MC_MAXCACHE, MC_NPAGES, 0)) == NULL)
+        return (NULL);
+    mcache_filter(mp, mc_pgin, mc_pgout, count);
+    if (mcache_set_policy(mp, policy) == FAIL)
+      {
+          mcache_close(mp);
+          return (NULL);
+      }
+    return (mp);
+}
+
+void
+test_mcache(void)
+{
+    MCACHE     *mp;
+    mc_count_t  count;
+    int32       reads;
+    int32       ret;
+    intn        policy;
+    intn        nthreads;
+    int32       i;
+
+    /* a page used twice, then a long scan, then the page again */
+    for (policy = MCACHE_LRU; policy <= MCACHE_2Q; policy++)
+      {
+          MESSAGE(5, printf("Scanning past a hot page, policy %d\n", (int) policy););
+          if ((mp = mc_open(&count, policy)) == NULL)
+            {
+                fprintf(stderr, "ERROR: mcache_open failed\n");
+                num_errs++;
+                continue;
+            }
+          ret = mc_use(mp, 1, 0);
+          CHECK_VOID(ret, FAIL, "mc_use");
+          ret = mc_use(mp, 1, 0);
+          CHECK_VOID(ret, FAIL, "mc_use");
+          for (i = 2; i < 2 + MC_SCAN; i++)
+            {
+                ret = mc_use(mp, i, 0);
+                CHECK_VOID(ret, FAIL, "mc_use");
+            }
+          reads = count.reads;
+          ret = mc_use(mp, 1, 0);
+          CHECK_VOID(ret, FAIL, "mc_use");
+
+          /* LRU reads the page in again, 2Q kept it */
+          VERIFY_VOID(count.reads - reads, (policy == MCACHE_LRU ? 1 : 0), "hot page reads");
+          VERIFY_VOID(count.reads, MC_SCAN + (policy == MCACHE_LRU ? 2 : 1), "page reads");
+          VERIFY_VOID(mp->curcache, MC_MAXCACHE, "curcache");
+          mcache_close(mp);
+      }
+
+    /* the clock passes over a page used since its last sweep */
+    MESSAGE(5, printf("Sweeping the clock\n"););
+    if ((mp = mc_open(&count, MCACHE_CLOCK)) != NULL)
+      {
+          for (i = 1; i <= MC_MAXCACHE; i++)
+            {
+                ret = mc_use(mp, i, 0);
+                CHECK_VOID(ret, FAIL, "mc_use");
+            }
+          ret = mc_use(mp, 1, 0);
+          CHECK_VOID(ret, FAIL, "mc_use");
+          ret = mc_use(mp, MC_MAXCACHE + 1, 0);
+          CHECK_VOID(ret, FAIL, "mc_use");
+          VERIFY_VOID(mcache_cached(mp, 1), TRUE, "mcache_cached");
+          VERIFY_VOID(mcache_cached(mp, 2), FALSE, "mcache_cached");
+          VERIFY_VOID(count.reads, MC_MAXCACHE + 1, "page reads");
+          mcache_close(mp);
+      }
+    else
+      {
+          fprintf(stderr, "ERROR: mcache_open failed\n");
+          num_errs++;
+      }
+
+    /* lowering the byte limit drops the pages over it */
+    MESSAGE(5, printf("Shrinking the cache to a byte limit\n"););
+    if ((mp = mc_open(&count, MCACHE_2Q)) != NULL)
+      {
+          for (i = 1; i <= MC_MAXCACHE; i++)
+            {
+                ret = mc_use(mp, i, MCACHE_DIRTY);
+                CHECK_VOID(ret, FAIL, "mc_use");
+            }
+          ret = mcache_set_maxbytes(mp, 3 * MC_PAGESIZE + MC_PAGESIZE / 2);
+          VERIFY_VOID(ret, 3, "mcache_set_maxbytes");
+          VERIFY_VOID(mp->curcache, 3, "curcache");
+          VERIFY_VOID(count.writes, MC_MAXCACHE - 3, "page writes");
+
+          /* more pages than the limit allows are not taken */
+          ret = mcache_set_maxcache(mp, MC_MAXCACHE);
+          VERIFY_VOID(ret, 3, "mcache_set_maxcache");
+          for (i = 1; i <= MC_MAXCACHE; i++)
+            {
+                ret = mc_use(mp, i, 0);
+                CHECK_VOID(ret, FAIL, "mc_use");
+            }
+          VERIFY_VOID(mp->curcache, 3, "curcache");
+
+          ret = mcache_sync(mp);
+          CHECK_VOID(ret, FAIL, "mcache_sync");
+          VERIFY_VOID(count.writes, MC_MAXCACHE, "page writes");
+          VERIFY_VOID(count.bad, 0, "pages written with the wrong contents");
+          mcache_close(mp);
+      }
+    else
+      {
+          fprintf(stderr, "ERROR: mcache_open failed\n");
+          num_errs++;
+      }
+
+    /* giving up a dirty page writes along the ones given up next, one
+       for each thread the worker pool writes with; sync writes the rest */
+    MESSAGE(5, printf("Writing dirty pages together\n"););
+    if ((mp = mc_open(&count, MCACHE_LRU)) != NULL)
+      {
+          nthreads = HWnthreads();
+          if (nthreads > MC_MAXCACHE)
+              nthreads = MC_MAXCACHE;
+          mcache_filterv(mp, NULL, mc_pgoutv);
+          for (i = 1; i <= MC_MAXCACHE; i++)
+            {
+                ret = mc_use(mp, i, MCACHE_DIRTY);
+                CHECK_VOID(ret, FAIL, "mc_use");
+            }
+          ret = mc_use(mp, MC_MAXCACHE + 1, 0);
+          CHECK_VOID(ret, FAIL, "mc_use");
+          VERIFY_VOID(count.batches, (nthreads > 1 ? 1 : 0), "page out batches");
+          VERIFY_VOID(count.writes, nthreads, "page writes");
+          VERIFY_VOID(mcache_cached(mp, 2), TRUE, "mcache_cached");
+
+          ret = mcache_sync(mp);
+          CHECK_VOID(ret, FAIL, "mcache_sync");
+          VERIFY_VOID(count.batches, (nthreads > 1 ? 1 : 0) + (MC_MAXCACHE - nthreads > 1 ? 1 : 0),
+                      "page out batches");
+          VERIFY_VOID(count.writes, MC_MAXCACHE, "page writes");
+          VERIFY_VOID(count.bad, 0, "pages written with the wrong contents");
+          mcache_close(mp);
+      }
+    else
+      {
+          fprintf(stderr, "ERROR: mcache_open failed\n");
+          num_errs++;
+      }
+}
@@ -44,6 +44,8 @@ void        test_vspack(void);
 void        test_comp(void);
 void        test_bitio(void);
 void        test_tbbt(void);
+void        test_atom(void);
+void        test_mcache(void);
 void        test_macros(void);
 void        test_conv(void);
 void        test_nbit(void);
@@ -57,5 +59,6 @@ void        test_datainfo(void);
 void        test_datainfo(void);
 void        test_attdatainfo(void);
 void        test_mgr_szip(void);
+void        test_thread(void);
 
 #endif /* _TPROTO_H */
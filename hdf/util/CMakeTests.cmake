@@ -18,8 +18,11 @@ if (HDF4_BUILD_TOOLS)
       hdfcomp.out1.2
       hdfed.input1
 #      hdfed.out1
+      hdfpack.input1
       hdfpack.out1.1
       hdfpack.out1.2
+      hdfpack.out2.1
+      hdfpack.out2.2
       hdftor8.out1
       jpeg2hdf.out1
       ristosds.input1
@@ -286,6 +289,8 @@ add_test (
     COMMAND ${CMAKE_COMMAND} -E remove
         test.pck
         test.blk
+        testfree.hdf
+        testfree.pck
 )
 if (NOT "${last_test}" STREQUAL "")
   set_tests_properties (hdfpack-clear-refs PROPERTIES DEPENDS ${last_test} LABELS ${PROJECT_NAME})
@@ -299,6 +304,43 @@ ADD_H4_TEST (testhdfpack-block hdfpack -b test.hdf test.blk)
 if (HDF4_BUILD_TOOLS)
   ADD_LS_TEST_NOL (test.hdf hdfpack.out1.1 0)
   ADD_LS_TEST_NOL (test.pck hdfpack.out1.2 0)
+
+  # the free space left by a deleted element is not packed
+  add_test (NAME testhdfpack-free-copy COMMAND ${CMAKE_COMMAND} -E copy test.hdf testfree.hdf)
+  set_tests_properties (testhdfpack-free-copy PROPERTIES DEPENDS ${last_test} LABELS ${PROJECT_NAME})
+  set (last_test "testhdfpack-free-copy")
+
+  add_test (
+      NAME HEDIT-hdfpack.input1
+      COMMAND "${CMAKE_COMMAND}"
+          -D "TEST_EMULATOR=${CMAKE_CROSSCOMPILING_EMULATOR}"
+          -D "TEST_PROGRAM=$<TARGET_FILE:hdfed${tgt_ext}>"
+          -D "TEST_ARGS:STRING=-batch"
+          -D "TEST_FOLDER=${PROJECT_BINARY_DIR}"
+          -D "TEST_INPUT=hdfpack.input1"
+          -D "TEST_OUTPUT=hdfpack.input1.tmp"
+          -D "TEST_EXPECT=0"
+          -D "TEST_SKIP_COMPARE=TRUE"
+          -P "${HDF_RESOURCES_EXT_DIR}/runTest.cmake"
+  )
+  set_tests_properties (HEDIT-hdfpack.input1 PROPERTIES DEPENDS ${last_test} LABELS ${PROJECT_NAME})
+  set (last_test "HEDIT-hdfpack.input1")
+
+  ADD_H4_TEST (testhdfpack-free hdfpack testfree.hdf testfree.pck)
+  ADD_LS_TEST_NOL (testfree.hdf hdfpack.out2.1 0)
+  ADD_LS_TEST_NOL (testfree.pck hdfpack.out2.2 0)
+
+  # one element less than test.hdf, so it packs smaller
+  add_test (
+      NAME testhdfpack-free-size
+      COMMAND "${CMAKE_COMMAND}"
+          -D "TEST_FOLDER=${PROJECT_BINARY_DIR}"
+          -D "TEST_SMALLER=testfree.pck"
+          -D "TEST_LARGER=test.pck"
+          -P "${HDF4_HDF_UTIL_SOURCE_DIR}/hdfpackSize.cmake"
+  )
+  set_tests_properties (testhdfpack-free-size PROPERTIES DEPENDS ${last_test} LABELS ${PROJECT_NAME})
+  set (last_test "testhdfpack-free-size")
 endif ()
 
 # Remove any output file left over from previous test run
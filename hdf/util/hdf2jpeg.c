@@ -86,7 +86,7 @@ main(int argc, char *argv[])
             {
                 n++;    /* increment the number of images found */
                 Hinquire(aid, NULL, &image_desc.tag, &image_desc.ref,
-                         &image_desc.length, &image_desc.offset,
+                         &image_desc.length, NULL,
                          NULL, NULL, NULL);
                 if (Hread(aid, image_desc.length, file_buf) != image_desc.length)
                   {
@@ -115,7 +115,7 @@ main(int argc, char *argv[])
                   }     /* end if */
                 data_aid = Hstartread(fid, DFTAG_CI, image_desc.ref);
                 Hinquire(data_aid, NULL, &image_desc.tag, &image_desc.ref,
-                         &image_desc.length, &image_desc.offset,
+                         &image_desc.length, NULL,
                          NULL, NULL, NULL);
                 while (image_desc.length > MAX_FILE_BUF)
                   {
@@ -163,7 +163,7 @@ main(int argc, char *argv[])
             {
                 n++;    /* increment the number of images found */
                 Hinquire(aid, NULL, &image_desc.tag, &image_desc.ref,
-                         &image_desc.length, &image_desc.offset,
+                         &image_desc.length, NULL,
                          NULL, NULL, NULL);
                 if (Hread(aid, image_desc.length, file_buf) != image_desc.length)
                   {
@@ -192,7 +192,7 @@ main(int argc, char *argv[])
                   }     /* end if */
                 data_aid = Hstartread(fid, DFTAG_CI, image_desc.ref);
                 Hinquire(data_aid, NULL, &image_desc.tag, &image_desc.ref,
-                         &image_desc.length, &image_desc.offset,
+                         &image_desc.length, NULL,
                          NULL, NULL, NULL);
                 while (image_desc.length > MAX_FILE_BUF)
                   {
@@ -240,7 +240,7 @@ main(int argc, char *argv[])
           do
             {
                 Hinquire(aid, NULL, &image_desc.tag, &image_desc.ref,
-                         &image_desc.length, &image_desc.offset,
+                         &image_desc.length, NULL,
                          NULL, NULL, NULL);
                 n++;    /* increment the number of images found */
                 if (jfif_formatted == TRUE)
@@ -259,7 +259,7 @@ main(int argc, char *argv[])
                   }     /* end if */
                 data_aid = Hstartread(fid, DFTAG_CI, image_desc.ref);
                 Hinquire(data_aid, NULL, &image_desc.tag, &image_desc.ref,
-                         &image_desc.length, &image_desc.offset,
+                         &image_desc.length, NULL,
                          NULL, NULL, NULL);
                 while (image_desc.length > MAX_FILE_BUF)
                   {
@@ -308,7 +308,7 @@ main(int argc, char *argv[])
             {
                 n++;    /* increment the number of images found */
                 Hinquire(aid, NULL, &image_desc.tag, &image_desc.ref,
-                         &image_desc.length, &image_desc.offset,
+                         &image_desc.length, NULL,
                          NULL, NULL, NULL);
                 if (jfif_formatted == TRUE)
                   {
@@ -326,7 +326,7 @@ main(int argc, char *argv[])
                   }     /* end if */
                 data_aid = Hstartread(fid, DFTAG_CI, image_desc.ref);
                 Hinquire(data_aid, NULL, &image_desc.tag, &image_desc.ref,
-                         &image_desc.length, &image_desc.offset,
+                         &image_desc.length, NULL,
                          NULL, NULL, NULL);
                 while (image_desc.length > MAX_FILE_BUF)
                   {
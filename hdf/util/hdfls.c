@@ -355,13 +355,15 @@ void usage(char *argv[])
 int dumpDD(void)
 {
     hdf_file_t file_id;    /* stdio file ID */
-    int32 next_block=MAGICLEN;
+    hdf_off_t next_block=MAGICLEN;
     uint8 *ddbuf;         /* buffer to store the DD information */
-    uint8 buf[NDDS_SZ+OFFSET_SZ]; /* buffer to hold DD block info */
+    uint8 buf[NDDS_SZ+OFFSET64_SZ]; /* buffer to hold DD block info */
     uint8 *b;
     int16 n_dds;          /* number of DDs in the current block */
     uint16 tag,ref;       /* DD tag & ref */
-    int32 off,len;        /* DD offset & length */
+    hdf_off_t off,len;    /* DD offset & length */
+    intn large;           /* is the file in the large file format? */
+    intn head_sz, dd_sz;  /* sizes of the block header and of a DD */
     intn l;               /* local counting variable */
 
     file_id=HI_OPEN(file_name,DFACC_READ);
@@ -370,6 +372,16 @@ int dumpDD(void)
           printf("Error opening file: %s\n",file_name);
           return(FAIL);
       } /* end if */
+
+    /* the magic number tells the size of the offsets in the DD list */
+    if(HI_READ(file_id,buf,MAGICLEN)==FAIL)
+      {
+          printf("Error reading in file: %s\n",file_name);
+          return(FAIL);
+      } /* end if */
+    large=(HDmemcmp(buf,HDFMAGIC_LARGE,MAGICLEN)==0);
+    head_sz=NDDS_SZ+(large ? OFFSET64_SZ : OFFSET_SZ);
+    dd_sz=(large ? DD64_SZ : DD_SZ);
     while(next_block!=0)
       {
           if(HI_SEEK(file_id,next_block)==FAIL)
@@ -377,7 +389,7 @@ int dumpDD(void)
                 printf("Error seeking in file: %s\n",file_name);
                 return(FAIL);
             } /* end if */
-          if(HI_READ(file_id,buf,NDDS_SZ+OFFSET_SZ)==FAIL)
+          if(HI_READ(file_id,buf,head_sz)==FAIL)
             {
                 printf("Error reading in file: %s\n",file_name);
                 return(FAIL);
@@ -385,11 +397,14 @@ int dumpDD(void)
           printf("current block: %ld,",(long)next_block);
           b=buf;
           INT16DECODE(b,n_dds);
-          INT32DECODE(b,next_block);
-          printf(" size of block: %ld, number of DDs:%d, next block: %ld\n",(long)(NDDS_SZ+OFFSET_SZ+(n_dds*DD_SZ)),(int)n_dds,(long)next_block);
+          if(large)
+              INT64DECODE(b,next_block)
+          else
+              INT32DECODE(b,next_block)
+          printf(" size of block: %ld, number of DDs:%d, next block: %ld\n",(long)(head_sz+(n_dds*dd_sz)),(int)n_dds,(long)next_block);
 
-          ddbuf=(uint8 *)HDmalloc(n_dds*DD_SZ);
-          if(HI_READ(file_id,ddbuf,n_dds*DD_SZ)==FAIL)
+          ddbuf=(uint8 *)HDmalloc(n_dds*dd_sz);
+          if(HI_READ(file_id,ddbuf,n_dds*dd_sz)==FAIL)
             {
                 printf("Error reading in file: %s\n",file_name);
                 return(FAIL);
@@ -404,8 +419,16 @@ int dumpDD(void)
 
                 UINT16DECODE(b, tag);
                 UINT16DECODE(b, ref);
-                INT32DECODE(b, off);
-                INT32DECODE(b, len);
+                if(large)
+                  {
+                    INT64DECODE(b, off);
+                    INT64DECODE(b, len);
+                  }
+                else
+                  {
+                    INT32DECODE(b, off);
+                    INT32DECODE(b, len);
+                  }
                 printf("\t[%5d] tag=%5u ref=%5u offset=%10ld length=%10ld\n",(int)l,(unsigned)tag,(unsigned)ref,(long)off,(long)len);
 #ifdef DISKBLOCK_DEBUG
                 if((tag!=DFTAG_NULL && tag!=DFTAG_FREE) &&
@@ -575,8 +598,11 @@ main(int argc, char *argv[])
           status = SUCCEED;
           for (n = 0; (n < MAXBUFF) && (status != FAIL); n++)
             {
+                int32 offset = INVALID_OFFSET;  /* stays so past 2 GB */
+
                 Hinquire(aid, NULL, &desc_buf[n].tag, &desc_buf[n].ref, &desc_buf[n].length,
-                         &desc_buf[n].offset, NULL, NULL, NULL);
+                         &offset, NULL, NULL, NULL);
+                desc_buf[n].offset = offset;
                 status = Hnextread(aid, DFTAG_WILDCARD, DFREF_WILDCARD, DF_CURRENT);
             }
 
@@ -278,7 +278,7 @@ main(int argc, char *argv[])
     for (i = 0; i < num_desc; i++)
       {
           if (((dlist[i].tag != DFTAG_NULL) && (dlist[i].tag != DFTAG_VERSION))
-              && (dlist[i].tag != DFTAG_LINKED))
+              && (dlist[i].tag != DFTAG_LINKED) && (dlist[i].tag != DFTAG_FREE))
             {
                 if ((dlist[i].offset != oldoff) || (dlist[i].length != oldlen))
                   {
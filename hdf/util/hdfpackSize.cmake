@@ -0,0 +1,22 @@
+# runs the size check of the hdfpack tests:
+#   fails unless TEST_SMALLER is smaller than TEST_LARGER, both in TEST_FOLDER
+
+if (NOT TEST_FOLDER)
+  message (FATAL_ERROR "Require TEST_FOLDER to be defined")
+endif ()
+if (NOT TEST_SMALLER OR NOT TEST_LARGER)
+  message (FATAL_ERROR "Require TEST_SMALLER and TEST_LARGER to be defined")
+endif ()
+
+# two hex digits a byte
+file (READ ${TEST_FOLDER}/${TEST_SMALLER} smaller_hex HEX)
+string (LENGTH "${smaller_hex}" smaller_size)
+math (EXPR smaller_size "${smaller_size} / 2")
+file (READ ${TEST_FOLDER}/${TEST_LARGER} larger_hex HEX)
+string (LENGTH "${larger_hex}" larger_size)
+math (EXPR larger_size "${larger_size} / 2")
+
+message (STATUS "${TEST_SMALLER}: ${smaller_size} bytes, ${TEST_LARGER}: ${larger_size} bytes")
+if (NOT smaller_size LESS larger_size)
+  message (FATAL_ERROR "Failed: ${TEST_SMALLER} is not smaller than ${TEST_LARGER}")
+endif ()
@@ -302,6 +302,7 @@ nc_type datatype ;
 int count ;
 const ncvoid *values ;
 {
+    HTS_API_LOCK;
 	NC_array **ap ;
 
 	cdf_routine_name = "ncattput" ;
@@ -330,6 +331,7 @@ int varid ;
 int attnum ;
 char *name ;
 {
+    HTS_API_LOCK;
 	NC_array **ap ;
 	NC_attr **attr ;
 
@@ -365,6 +367,7 @@ const char *name ; /* input, attribute name */
 nc_type *datatypep ;
 int *countp ;
 {
+    HTS_API_LOCK;
 	NC_attr **attr ;
 
 	cdf_routine_name = "ncattinq" ;
@@ -387,6 +390,7 @@ int varid ;
 const char *name ;
 const char *newname ;
 {
+    HTS_API_LOCK;
 	
 	NC *handle ;
 	NC_attr **attr ;
@@ -440,6 +444,7 @@ const char *name ;
 int outcdf ;
 int outname ;
 {
+    HTS_API_LOCK;
 	NC_attr **attr ;
 	NC_array **ap ;
 
@@ -464,6 +469,7 @@ int cdfid ;
 int varid ; 
 const char *name ;
 {
+    HTS_API_LOCK;
 	
 	NC_array **ap ;
 	NC_attr **attr ;
@@ -518,6 +524,7 @@ int varid ;
 const char *name ;
 ncvoid *values ;
 {
+    HTS_API_LOCK;
 	
 	NC_attr **attr ;
 
@@ -176,7 +176,8 @@ const char *filename;
     HI_CLOSE(fp);
 
     /* If magic_num is a valid file format version number, then return it */
-    if (magic_num == HDFXMAGIC || magic_num == CDFMAGIC ||
+    if (magic_num == HDFXMAGIC || magic_num == HDFXMAGIC_LARGE ||
+        magic_num == CDFMAGIC ||
         magic_num == NCMAGIC  || magic_num == NCMAGIC64)
         ret_value = magic_num;
     else
@@ -560,6 +561,7 @@ int *nvarsp ;
 int *nattrsp ;
 int *xtendimp ;
 {
+    HTS_API_LOCK;
     NC *handle ;
 
     cdf_routine_name = "ncinquire" ;
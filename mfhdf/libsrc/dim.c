@@ -97,6 +97,7 @@ int cdfid ;
 const char *name ;
 long size ;
 {
+    HTS_API_LOCK;
     NC *handle ;
     NC_dim *dim[1] ;
     NC_dim **dp ;
@@ -186,6 +187,7 @@ int ncdimid( cdfid, name)
 int cdfid ;
 const char *name ;
 {
+    HTS_API_LOCK;
     NC *handle ;
     NC_dim **dp ;
     unsigned ii ;
@@ -217,6 +219,7 @@ int dimid ;
 char *name ;
 long *sizep ;
 {
+    HTS_API_LOCK;
     NC *handle ;
     NC_dim **dp ;
 
@@ -260,6 +263,7 @@ int cdfid ;
 int dimid ;
 const char *newname ;
 {
+    HTS_API_LOCK;
 
     NC *handle ;
     NC_dim **dp ;
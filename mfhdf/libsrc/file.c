@@ -342,6 +342,7 @@ int nccreate(path, cmode)
 const char    *path ;    /* file name */
 int         cmode ;
 {
+    HTS_API_LOCK;
     cdf_routine_name = "nccreate" ;
 
     if(cmode & NC_CREAT)
@@ -357,6 +358,7 @@ int ncopen(path,mode)
 const char    *path ;    /* file name */
 int         mode ;
 {
+    HTS_API_LOCK;
     cdf_routine_name = "ncopen" ;
     if(mode & NC_CREAT)
     {
@@ -370,6 +372,7 @@ int         mode ;
 int ncsync(cdfid)
 int cdfid ;
 {
+    HTS_API_LOCK;
     NC *handle ;
 
     cdf_routine_name = "ncsync" ;
@@ -441,6 +444,7 @@ int cdfid ;
 int ncabort(cdfid)
 int cdfid ;
 {
+    HTS_API_LOCK;
     NC *handle ;
     char path[FILENAME_MAX + 1] ;
     unsigned flags ;
@@ -543,6 +547,7 @@ int cdfid ;
 int ncnobuf(cdfid)
 int cdfid ;
 {
+    HTS_API_LOCK;
     NC *handle ;
 
     cdf_routine_name = "ncnobuf" ;
@@ -652,6 +657,7 @@ const char *proto ;
 int ncredef(cdfid)
 int cdfid ;
 {
+    HTS_API_LOCK;
     NC *handle ;
     NC *new ;
     int id ;
@@ -1040,6 +1046,7 @@ done:
 int ncendef( cdfid )
 int cdfid ;
 {
+    HTS_API_LOCK;
     NC *handle ;
 
     cdf_routine_name = "ncendef" ;
@@ -1058,6 +1065,7 @@ int cdfid ;
 int ncclose( cdfid )
 int cdfid ;
 {
+    HTS_API_LOCK;
     NC *handle ;
 
     cdf_routine_name = "ncclose" ;
@@ -1112,6 +1120,7 @@ ncsetfill(id, fillmode)
 int id ;
 int fillmode ;
 {
+    HTS_API_LOCK;
     NC *handle ;
     int ret = 0 ;
 
@@ -275,6 +275,7 @@ HDFLIBAPI const char *cdf_routine_name ; /* defined in lerror.c */
 
 /* Format version number for HDF file */
 #define HDFXMAGIC   0x0e031301   /* ^N^C^S^A */
+#define HDFXMAGIC_LARGE 0x0e031302   /* ^N^C^S^B, large file format */
 
 /* Format version number for netCDF classic file */
 #define NCMAGIC     0x43444601   /*  C D F 1 */
@@ -106,6 +106,7 @@ intn
 SDgetdatainfo(int32 sdsid, int32 *chk_coord, uintn start_block,
         uintn info_count, int32 *offsetarray, int32 *lengtharray)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetdatainfo");    /* for HGOTO_ERROR */
     NC     *handle;
     NC_var *var;
@@ -209,6 +210,7 @@ SDgetdatainfo(int32 sdsid, int32 *chk_coord, uintn start_block,
 intn
 SDgetattdatainfo(int32 id, int32 attrindex, int32 *offset, int32 *length)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetattdatainfo");
     NC     *handle;
     NC_var *var;
@@ -516,6 +518,7 @@ intn
 SDgetoldattdatainfo(int32 dim_id, int32 sdsid, char  *attr_name,
         int32 *offset, int32 *length)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetoldattdatainfo");
     NC     *handle;
     NC_var *var;
@@ -736,6 +739,7 @@ SDgetoldattdatainfo(int32 dim_id, int32 sdsid, char  *attr_name,
  ******************************************************************************/
 intn SDgetanndatainfo(int32 sdsid, ann_type annot_type, uintn size, int32* offsetarray, int32* lengtharray)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetanndatainfo");
     int32   file_id=FAIL,  /* file, AN API, annotation IDs */
             an_id=FAIL,
@@ -443,6 +443,38 @@ HDFLIBAPI intn SDreadchunk
      int32 *origin,    /* IN: origin of chunk to read */
      void  *datap      /* IN/OUT: buffer for data */);
 
+/******************************************************************************
+ NAME
+     SDreadsparse -- read a hyperslab of a chunked SDS, telling which of its
+                     chunks have been written
+
+ DESCRIPTION
+     Reads the hyperslab of 'edge' values from 'start' of a chunked SDS,
+     as SDreaddata() does with no stride, and sets 'chunk_map' to TRUE
+     for each chunk of the hyperslab which has been written and to FALSE
+     for those never written.
+
+     'chunk_map' holds one entry for each chunk the hyperslab covers, in
+     the order of the chunks in the SDS, the last dimension varying the
+     fastest.  Along dimension i the hyperslab covers the chunks
+     start[i]/chunk_lengths[i] to (start[i]+edge[i]-1)/chunk_lengths[i].
+
+     With 'fill_mode' SD_FILL, the values of the chunks never written are
+     set to the fill value, as SDreaddata() sets them.  With SD_NOFILL
+     those chunks are not read at all, and their part of 'data' is left
+     as it is, which makes reading mostly empty datasets much cheaper.
+
+ RETURNS
+     The number of chunks of the hyperslab which have been written, or FAIL
+******************************************************************************/
+HDFLIBAPI intn SDreadsparse
+    (int32 sdsid,      /* IN: sds access id */
+     int32 *start,     /* IN: coords of starting point */
+     int32 *edge,      /* IN: number of values to read per dimension */
+     void  *data,      /* OUT: data buffer */
+     uint8 *chunk_map, /* OUT: TRUE for the chunks written */
+     intn   fill_mode  /* IN: SD_FILL or SD_NOFILL */);
+
 /******************************************************************************
 NAME
      SDsetchunkcache -- maximum number of chunks to cache 
@@ -492,6 +524,83 @@ HDFLIBAPI intn SDsetchunkcache
      int32 maxcache,  /* IN: max number of chunks to cache */
      int32 flags      /* IN: flags = 0, HDF_CACHEALL */);
 
+/******************************************************************************
+NAME
+     SDsetchunkcachepolicy -- byte budget and eviction policy of the chunk cache
+
+DESCRIPTION
+     Budget the chunk cache of the SDS in bytes and set which chunks it 
+     gives up first when it is full.
+
+     The cache is set to hold as many chunks as fit in 'maxbytes', at
+     least one, and SDsetchunkcache() does not let it hold more. Unlike 
+     the number of chunks the budget can be lowered, which writes out 
+     and drops the chunks that no longer fit. A 'maxbytes' of zero 
+     leaves the number of chunks alone and takes the limit away.
+
+     'policy' is HDF_CACHE_LRU (the default), HDF_CACHE_2Q or 
+     HDF_CACHE_CLOCK. With HDF_CACHE_2Q chunks used only once, as in a
+     long sequential read, are given up before chunks used again, such
+     as those of coordinate variables or tile edges. HDF_CACHE_CLOCK 
+     gives up the chunks not used since its last sweep of the cache.
+
+     The environment variables HDF4_CHUNK_CACHE_BYTES and
+     HDF4_CHUNK_CACHE_POLICY ("lru", "2q" or "clock") set both for
+     every chunk cache when it is created.
+
+RETURNS
+     Returns the number of chunks the cache holds at most if successful 
+     and FAIL otherwise
+******************************************************************************/
+HDFLIBAPI intn SDsetchunkcachepolicy
+    (int32 sdsid,     /* IN: sds access id */
+     int32 maxbytes,  /* IN: max bytes to cache, 0 for no limit */
+     intn  policy     /* IN: HDF_CACHE_LRU, HDF_CACHE_2Q, HDF_CACHE_CLOCK */);
+
+/******************************************************************************
+NAME
+     SDsetsharedchunkcache -- byte budget of the chunk cache shared by all SDSs
+
+DESCRIPTION
+     Set the memory of the chunk cache shared by all the chunked SDSs of
+     all the open files. The shared cache keeps the chunks read, 
+     decompressed, after SDendaccess() and across SDSs, and gives up the
+     least recently used chunks when they take more than 'maxbytes'.
+
+     The cache is off until it is given a budget, a 'maxbytes' of zero
+     turns it off again. The environment variable 
+     HDF4_SHARED_CHUNK_CACHE_BYTES sets the budget as well.
+
+RETURNS
+     SUCCEED/FAIL
+******************************************************************************/
+HDFLIBAPI intn SDsetsharedchunkcache
+    (int32 maxbytes   /* IN: max bytes to cache, 0 to turn off */);
+
+/******************************************************************************
+NAME
+     SDsetchunkalign -- where in the file to place the chunks of the SDS
+
+DESCRIPTION
+     Place each chunk of the SDS written for the first time on a multiple
+     of 'alignment' bytes from the beginning of the file, e.g. the page 
+     size or the stripe size of the file system. With HDF_CHUNK_PREALLOC
+     in 'flags' one extent of the file is kept right away for all the 
+     chunks, which go in it next to each other in the order of the chunk
+     numbers; the places of the chunks not written are given back at
+     SDendaccess(). An 'alignment' of zero places the chunks anywhere.
+
+     Only SDSs chunked without compression can be placed. The policy is
+     not recorded in the file and lasts until SDendaccess().
+
+RETURNS
+     SUCCEED/FAIL
+******************************************************************************/
+HDFLIBAPI intn SDsetchunkalign
+    (int32 sdsid,     /* IN: sds access id */
+     int32 alignment, /* IN: chunks start on multiples of this, 0 for anywhere */
+     intn  flags      /* IN: 0 or HDF_CHUNK_PREALLOC */);
+
 
 #ifdef __cplusplus
 }
@@ -339,6 +339,7 @@ int32
 SDstart(const char *name,   /* IN: file name to open */
         int32       HDFmode /* IN: access mode to open file with */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDstart");    /* for HGOTO_ERROR */
     intn    cdfid;
     int32   fid;
@@ -426,6 +427,7 @@ done:
 intn
 SDend(int32 id /* IN: file ID of file to close */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDend");    /* for HGOTO_ERROR */
     intn  cdfid;
     NC   *handle = NULL;
@@ -515,6 +517,7 @@ SDfileinfo(int32  fid,     /* IN:  file ID */
            int32 *datasets,/* OUT: number of datasets in the file */
            int32 *attrs    /* OUT: number of global attributes */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDfileinfo");    /* for HGOTO_ERROR */
     NC   *handle = NULL;
     intn  ret_value = SUCCEED;
@@ -584,6 +587,7 @@ int32
 SDselect(int32 fid,  /* IN: file ID */
          int32 index /* IN: index of dataset to get ID for */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDselect");    /* for HGOTO_ERROR */
     NC    *handle = NULL;
     int32  sdsid;         /* the id we're gonna build */
@@ -655,6 +659,7 @@ SDgetinfo(int32  sdsid,   /* IN:  dataset ID */
           int32 *nt,      /* OUT: number type of data */
           int32 *nattrs   /* OUT: the number of local attributes */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetinfo");    /* for HGOTO_ERROR */
     intn    i;
     NC     *handle = NULL;
@@ -748,6 +753,7 @@ SDreaddata(int32  sdsid,  /* IN:  dataset ID */
            int32 *end,    /* IN:  number of values to read per dimension */
            void  *data    /* OUT: data buffer */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDreaddata");    /* for HGOTO_ERROR */
     NC     *handle = NULL;
     NC_dim *dim = NULL;
@@ -932,6 +938,7 @@ int32
 SDnametoindex(int32 fid,  /* IN: file ID */
               const char *name  /* IN: name of dataset to search for */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDnametoindex");    /* for HGOTO_ERROR */
     unsigned ii;
     intn     len;
@@ -1002,6 +1009,7 @@ SDgetnumvars_byname(int32 fid,  /* IN: file ID */
               const char *name,  /* IN: name of dataset to search for */
         int32* n_vars)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetnumvars_byname");    /* for HGOTO_ERROR */
     unsigned ii;
     intn     len;
@@ -1077,6 +1085,7 @@ SDnametoindices(int32 fid,  /* IN: file ID */
         const char *name,  /* IN: name of dataset to search for */
         hdf_varlist_t* var_list)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDnametoindices");    /* for HGOTO_ERROR */
     unsigned ii;
     intn     len;
@@ -1154,6 +1163,7 @@ SDgetrange(int32 sdsid, /* IN:  dataset ID */
            void * pmax,  /* OUT: valid max */
            void * pmin   /* OUT: valid min */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetrange");    /* for HGOTO_ERROR */
     NC       *handle = NULL;
     NC_var   *var = NULL;
@@ -1286,6 +1296,7 @@ SDcreate(int32  fid,      /* IN: file ID */
          int32  rank,     /* IN: rank of dataset */
          int32 *dimsizes  /* IN: array of dimension sizes */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDcreate");    /* for HGOTO_ERROR */
     intn     i;
     NC      *handle = NULL;
@@ -1499,6 +1510,7 @@ int32
 SDgetdimid(int32 sdsid,  /* IN: dataset ID */
            intn  number  /* IN: index of dimension, in the SDS, ie. <= rank-1 */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetdimid");    /* for HGOTO_ERROR */
     NC     *handle = NULL;
     NC_var *var = NULL;
@@ -1579,6 +1591,7 @@ intn
 SDsetdimname(int32  id,   /* IN: dataset ID */
              const char  *name  /* IN: dimension name */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetdimname");    /* for HGOTO_ERROR */
     NC         *handle = NULL;
     NC_dim     *dim = NULL;
@@ -1681,6 +1694,7 @@ done:
 intn
 SDendaccess(int32 id /* IN: dataset ID */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDendaccess");    /* for HGOTO_ERROR */
     NC     *handle;
     int32   ret_value = SUCCEED;
@@ -1871,6 +1885,7 @@ SDsetrange(int32 sdsid, /* IN: dataset ID */
            void * pmax,  /* IN: valid max */
            void * pmin   /* IN: valid min */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetrange");    /* for HGOTO_ERROR */
     NC      *handle = NULL;
     NC_var  *var = NULL;
@@ -2045,6 +2060,7 @@ SDsetattr(int32 id,    /* IN: object ID */
           int32 count, /* IN: number of attribute values */
           const void * data   /* IN: attribute values */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetattr");    /* for HGOTO_ERROR */
     NC_array **ap = NULL;
     NC        *handle = NULL;
@@ -2144,6 +2160,7 @@ SDattrinfo(int32  id,    /* IN:  object ID */
            int32 *nt,    /* OUT: attribute number type */
            int32 *count  /* OUT: number of attribute values */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDattrinfo");    /* for HGOTO_ERROR */
     NC_array  *ap = NULL;
     NC_array **app = NULL;
@@ -2227,6 +2244,7 @@ SDreadattr(int32 id,    /* IN:  object ID */
            int32 index, /* IN:  attribute index */
            void * buf    /* OUT: data buffer  */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDreadattr");    /* for HGOTO_ERROR */
     NC_array  *ap = NULL;
     NC_array **app = NULL;
@@ -2302,6 +2320,7 @@ SDwritedata(int32  sdsid,  /* IN: dataset ID */
             int32 *end,    /* IN: number of values to write per dimension */
             void *  data    /* IN: data buffer */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDwritedata");    /* for HGOTO_ERROR */
     intn    varid;
     int32   status;
@@ -2501,6 +2520,7 @@ SDsetdatastrs(int32 sdsid, /* IN: dataset ID */
               const char *f,     /* IN: format string ("format") */
               const char *c      /* IN: coordsys string ("coordsys") */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetdatastrs");    /* for HGOTO_ERROR */
     NC     *handle = NULL;
     NC_var *var = NULL;
@@ -2601,6 +2621,7 @@ SDsetcal(int32   sdsid,/* IN: dataset ID */
          float64 ioffe,/* IN: integer offset error */
          int32   nt    /* IN: number type of uncalibrated data */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetcal");    /* for HGOTO_ERROR */
     NC     *handle = NULL;
     NC_var *var = NULL;
@@ -2691,6 +2712,7 @@ intn
 SDsetfillvalue(int32 sdsid, /* IN: dataset ID */
                void * val    /* IN: fillvalue */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetfillvalue");    /* for HGOTO_ERROR */
     NC     *handle = NULL;
     NC_var *var = NULL;
@@ -2758,6 +2780,7 @@ intn
 SDgetfillvalue(int32 sdsid, /* IN:  dataset ID */
                void * val    /* OUT: fillvalue */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetfillvalue");    /* for HGOTO_ERROR */
     NC       *handle = NULL;
     NC_var   *var = NULL;
@@ -2834,6 +2857,7 @@ SDgetdatastrs(int32 sdsid, /* IN:  dataset ID */
               char *c,     /* OUT: coordsys string ("coordsys") */
               intn  len    /* IN:  buffer length */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetdatastrs");    /* for HGOTO_ERROR */
     NC       *handle = NULL;
     NC_var   *var = NULL;
@@ -2965,6 +2989,7 @@ SDgetcal(int32    sdsid, /* IN:  dataset ID */
          float64 *ioffe, /* OUT: integer offset error */
          int32   *nt     /* OUT: number type of uncalibrated data */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetcal");    /* for HGOTO_ERROR */
     NC       *handle = NULL;
     NC_var   *var    = NULL;
@@ -3213,6 +3238,7 @@ SDsetdimstrs(int32 id, /* IN: dimension ID */
              const char *u,  /* IN: units string ("units") */
              const char *f   /* IN: format string ("format") */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetdimstrs");    /* for HGOTO_ERROR */
     intn       varid;
     NC        *handle = NULL;
@@ -3372,6 +3398,7 @@ SDsetdimscale(int32 id,    /* IN: dimension ID */
               int32 nt,    /* IN: number type of data */
               void * data   /* IN: scale values */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetdimscale");    /* for HGOTO_ERROR */
     NC        *handle = NULL;
     NC_dim    *dim = NULL;
@@ -3468,6 +3495,7 @@ intn
 SDgetdimscale(int32 id,   /* IN:  dimension ID */
               void * data  /* OUT: scale values */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetdimscale");    /* for HGOTO_ERROR */
     NC        *handle = NULL;
     NC_dim    *dim = NULL;
@@ -3585,6 +3613,7 @@ SDdiminfo(int32  id,    /* IN:  dimension ID */
           int32 *nt,    /* OUT: number type of scales */
           int32 *nattr  /* OUT: the number of local attributes */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDdiminfo");    /* for HGOTO_ERROR */
     NC      *handle = NULL;
     NC_dim  *dim = NULL;
@@ -3712,6 +3741,7 @@ SDgetdimstrs(int32 id,  /* IN:  dataset ID */
              char *f,   /* OUT: format string ("format") */
              intn  len  /* IN:  buffer length */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetdimstrs");    /* for HGOTO_ERROR */
     NC       *handle = NULL;
     NC_var   *var = NULL;
@@ -3888,6 +3918,7 @@ SDsetexternalfile(int32 id,       /* IN: dataset ID */
                   const char *filename, /* IN: name of external file */
                   int32 offset    /* IN: offset in external file */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetexternalfile");    /* for HGOTO_ERROR */
     NC     *handle = NULL;
     NC_var *var = NULL;
@@ -4026,6 +4057,7 @@ SDgetexternalinfo(int32 id,      /* IN: dataset ID */
               int32 *offset,     /* IN: offset in external file */
               int32 *length      /* IN: length of external data */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetexternalinfo");    /* for HGOTO_ERROR */
     NC     *handle = NULL;
     NC_var *var = NULL;
@@ -4178,6 +4210,7 @@ SDgetexternalfile(int32 id,       /* IN: dataset ID */
                   char *ext_filename, /* IN: name of external file */
                   int32 *offset    /* IN: offset in external file */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetexternalfile");    /* for HGOTO_ERROR */
     NC     *handle = NULL;
     NC_var *var = NULL;
@@ -4306,6 +4339,7 @@ SDsetnbitdataset(int32 id,       /* IN: dataset ID */
                  intn sign_ext,  /* IN: Whether to sign extend */
                  intn fill_one   /* IN: Whether to fill background w/1's */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetnbitdataset");    /* for HGOTO_ERROR */
     NC        *handle = NULL;
     NC_var    *var = NULL;
@@ -4486,6 +4520,7 @@ SDsetcompress(int32 id,                /* IN: dataset ID */
                     perform on the next image */
               comp_info *c_info        /* IN: ptr to compression info struct*/)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetcompress");    /* for HGOTO_ERROR */
     NC        *handle;
     NC_var    *var;
@@ -4683,6 +4718,7 @@ SDgetcompress(int32     id,     /* IN: dataset ID */
               comp_info* c_info)/* OUT: ptr to compression information
                 structure for storing the retrieved info */
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetcompress");    /* for HGOTO_ERROR */
     NC        *handle;
     NC_var    *var;
@@ -4757,6 +4793,7 @@ SDgetcompinfo(int32 sdsid,     /* IN: dataset ID */
               comp_info* c_info)/* OUT: ptr to compression information
                 structure for storing the retrieved info */
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetcompinfo");    /* for HGOTO_ERROR */
     NC        *handle;
     NC_var    *var;
@@ -4831,6 +4868,7 @@ intn
 SDgetcomptype(int32 sdsid,        /* IN: dataset ID */
               comp_coder_t* comp_type    /* OUT: the type of compression */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetcomptype");    /* for HGOTO_ERROR */
     NC        *handle;
     NC_var    *var;
@@ -4902,6 +4940,7 @@ SDgetdatasize(int32 sdsid,        /* IN: dataset ID */
               int32* orig_size)        /* OUT: size of original data */
 
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetdatasize");    /* for HGOTO_ERROR */
     NC     *handle;
     NC_var *var;
@@ -4987,6 +5026,7 @@ int32
 SDfindattr(int32 id,       /* IN: object ID */
            const char *attrname  /* IN: attribute name */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDfindattr");    /* for HGOTO_ERROR */
     NC_array  *ap = NULL;
     NC_array **app = NULL;
@@ -5056,6 +5096,7 @@ done:
 int32
 SDidtoref(int32 id /* IN: dataset ID */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDidtoref");    /* for HGOTO_ERROR */
     NC       *handle = NULL;
     NC_var   *var = NULL;
@@ -5114,6 +5155,7 @@ int32
 SDreftoindex(int32 fid, /* IN: file ID */
              int32 ref  /* IN: reference number */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDreftoindex");    /* for HGOTO_ERROR */
     NC       *handle = NULL;
     NC_var  **dp = NULL;
@@ -5176,6 +5218,7 @@ done:
 int32
 SDisrecord(int32 id /* IN: dataset ID */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDisrecord");    /* for HGOTO_ERROR */
     NC       *handle;
     NC_var   *var;
@@ -5242,6 +5285,7 @@ done:
 intn
 SDiscoordvar(int32 id /* IN: dataset ID */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDiscoordvar");    /* for HGOTO_ERROR */
     NC       *handle = NULL;
     NC_var   *var = NULL;
@@ -5459,6 +5503,7 @@ intn
 SDsetaccesstype(int32 id,         /* IN: dataset ID */
                 uintn accesstype  /* IN: access type */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetaccesstype");    /* for HGOTO_ERROR */
     NC       *handle = NULL;
     NC_var   *var = NULL;
@@ -5535,6 +5580,7 @@ intn
 SDsetblocksize(int32 sdsid,      /* IN: dataset ID */
                int32 block_size  /* IN: size of the block in bytes */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetblocksize");    /* for HGOTO_ERROR */
     NC      *handle = NULL;
     NC_var  *var = NULL;
@@ -5591,6 +5637,7 @@ intn
 SDgetblocksize(int32 sdsid,      /* IN: dataset ID */
                int32 *block_size /* OUT: size of the block in bytes */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetblocksize");    /* for HGOTO_ERROR */
     NC      *handle = NULL;
     NC_var  *var = NULL;
@@ -5668,6 +5715,7 @@ SDsetfillmode(int32 sd_id,  /* IN: HDF file ID, returned from SDstart */
                                    either SD_FILL or SD_NOFILL.
                                    SD_FILL is the default mode. */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetfillmode");    /* for HGOTO_ERROR */
     NC     *handle = NULL;
     intn    cdfid;
@@ -5718,6 +5766,7 @@ SDsetdimval_comp(int32 dimid,    /* IN: dimension ID, returned from SDgetdimid *
                                     SD_DIMVAL_BW_INCOMP -- incompatible.
                                     (defined in mfhdf.h ) */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetdimval_comp");    /* for HGOTO_ERROR */
     NC      *handle = NULL;
     NC_dim  *dim = NULL;
@@ -5781,6 +5830,7 @@ done:
 intn
 SDisdimval_bwcomp(int32 dimid /* IN: dimension ID, returned from SDgetdimid */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDisdimval_bwcomp");    /* for HGOTO_ERROR */
     NC      *handle = NULL;
     NC_dim  *dim = NULL;
@@ -5942,6 +5992,7 @@ SDsetchunk(int32         sdsid,     /* IN: sds access id */
            HDF_CHUNK_DEF chunk_def, /* IN: chunk definition */
            int32         flags      /* IN: flags */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetchunk");    /* for HGOTO_ERROR */
     NC        *handle = NULL;      /* file handle */
     NC_var    *var    = NULL;      /* SDS variable */
@@ -6367,6 +6418,7 @@ SDgetchunkinfo(int32          sdsid,      /* IN: sds access id */
                HDF_CHUNK_DEF *chunk_def,  /* IN/OUT: chunk definition */
                int32         *flags       /* IN/OUT: flags */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetchunkinfo");    /* for HGOTO_ERROR */
     NC       *handle = NULL;       /* file handle */
     NC_var   *var    = NULL;       /* SDS variable */
@@ -6594,6 +6646,7 @@ SDwritechunk(int32       sdsid, /* IN: access aid to SDS */
              int32      *origin,/* IN: origin of chunk to write */
              const void *datap  /* IN: buffer for data */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDwritechunk");    /* for HGOTO_ERROR */
     NC        *handle = NULL;   /* file handle */
     NC_var    *var    = NULL;   /* SDS variable */
@@ -6804,6 +6857,7 @@ SDreadchunk(int32  sdsid,  /* IN: access aid to SDS */
             int32 *origin, /* IN: origin of chunk to write */
             void  *datap   /* IN/OUT: buffer for data */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDreadchunk");    /* for HGOTO_ERROR */
     NC        *handle = NULL;   /* file handle */
     NC_var    *var    = NULL;   /* SDS variable */
@@ -7007,6 +7061,273 @@ SDreadchunk(int32  sdsid,  /* IN: access aid to SDS */
     return ret_value;
 } /* SDreadchunk() */
 
+/******************************************************************************
+ NAME
+     SDIconvert_sparse -- convert the values of the written chunks of a
+                          hyperslab
+
+ DESCRIPTION
+     Converts, in place, the values of the hyperslab 'start', 'edge' in
+     'data' which fall in the chunks 'chunk_map' marks as written, a
+     row along the last dimension at a time.  The other values were not
+     read by SDreadsparse() and are left as they are.
+
+ RETURNS
+     SUCCEED/FAIL
+******************************************************************************/
+static intn
+SDIconvert_sparse(NC_var *var,             /* IN: SDS variable */
+                  const int32 *start,      /* IN: start of the hyperslab */
+                  const int32 *edge,       /* IN: size of the hyperslab */
+                  const int32 *cdims,      /* IN: chunk lengths */
+                  const uint8 *chunk_map,  /* IN: TRUE for chunks written */
+                  uint8 *data              /* IN/OUT: the hyperslab */)
+{
+    int32   first[H4_MAX_VAR_DIMS];  /* first chunk of the hyperslab */
+    int32   last[H4_MAX_VAR_DIMS];   /* last chunk of the hyperslab */
+    int32   cidx[H4_MAX_VAR_DIMS];   /* chunk being converted */
+    int32   lo[H4_MAX_VAR_DIMS];     /* first value of the chunk in the slab */
+    int32   ext[H4_MAX_VAR_DIMS];    /* values of the chunk in the slab */
+    int32   pos[H4_MAX_VAR_DIMS];    /* row being converted */
+    int32   stride[H4_MAX_VAR_DIMS]; /* values between rows of the slab */
+    int32   ndims = (int32) var->assoc->count;
+    int32   offset;                  /* offset of a row in the slab */
+    int32   m;                       /* entry of the chunk in chunk_map */
+    int32   i, j;
+    intn    ret_value = SUCCEED;
+
+    stride[ndims - 1] = 1;
+    for (i = ndims - 2; i >= 0; i--)
+        stride[i] = stride[i + 1] * edge[i + 1];
+
+    for (i = 0; i < ndims; i++)
+      {
+          first[i] = start[i] / cdims[i];
+          last[i] = (start[i] + edge[i] - 1) / cdims[i];
+          cidx[i] = first[i];
+      }
+
+    for (m = 0; ; m++)
+      {
+          if (chunk_map[m])
+            {
+                for (i = 0; i < ndims; i++)
+                  {
+                      lo[i] = MAX(start[i], cidx[i] * cdims[i]);
+                      ext[i] = MIN(start[i] + edge[i], (cidx[i] + 1) * cdims[i]) - lo[i];
+                      pos[i] = 0;
+                  }
+
+                /* convert the rows of the chunk */
+                do {
+                    for (i = 0, offset = 0; i < ndims; i++)
+                        offset += (lo[i] + pos[i] - start[i]) * stride[i];
+                    if (FAIL == DFKconvert(data + offset * var->HDFsize,
+                                           data + offset * var->HDFsize,
+                                           var->HDFtype, (uint32) ext[ndims - 1],
+                                           DFACC_READ, 0, 0))
+                        return FAIL;
+
+                    for (j = ndims - 2; j >= 0; j--)
+                      {
+                          if (++pos[j] < ext[j])
+                              break;
+                          pos[j] = 0;
+                      }
+                } while (j >= 0);
+            }
+
+          /* on to the next chunk of the hyperslab */
+          for (i = ndims - 1; i >= 0; i--)
+            {
+                if (++cidx[i] <= last[i])
+                    break;
+                cidx[i] = first[i];
+            }
+          if (i < 0)
+              break;
+      }
+
+    return ret_value;
+} /* SDIconvert_sparse() */
+
+/******************************************************************************
+ NAME
+     SDreadsparse -- read a hyperslab of a chunked SDS, telling which of its
+                     chunks have been written
+
+ DESCRIPTION
+     Reads the hyperslab of 'edge' values from 'start' of a chunked SDS,
+     as SDreaddata() does with no stride, and sets 'chunk_map' to TRUE
+     for each chunk of the hyperslab which has been written and to FALSE
+     for those never written.
+
+     'chunk_map' holds one entry for each chunk the hyperslab covers, in
+     the order of the chunks in the SDS, the last dimension varying the
+     fastest.  Along dimension i the hyperslab covers the chunks
+     start[i]/chunk_lengths[i] to (start[i]+edge[i]-1)/chunk_lengths[i].
+
+     With 'fill_mode' SD_FILL, the values of the chunks never written are
+     set to the fill value, as SDreaddata() sets them.  With SD_NOFILL
+     those chunks are not read at all, and their part of 'data' is left
+     as it is, which makes reading mostly empty datasets much cheaper.
+
+     NOTE:
+         This routine directly calls a Special Chunked Element fcn HMCxxx.
+
+ RETURNS
+     The number of chunks of the hyperslab which have been written, or FAIL
+******************************************************************************/
+intn
+SDreadsparse(int32  sdsid,     /* IN: access aid to SDS */
+             int32 *start,     /* IN: coords of starting point */
+             int32 *edge,      /* IN: number of values to read per dimension */
+             void  *data,      /* OUT: data buffer */
+             uint8 *chunk_map, /* OUT: TRUE for the chunks written */
+             intn   fill_mode  /* IN: SD_FILL or SD_NOFILL */)
+{
+    HTS_API_LOCK;
+    CONSTR(FUNC, "SDreadsparse");    /* for HGOTO_ERROR */
+    NC        *handle = NULL;   /* file handle */
+    NC_var    *var    = NULL;   /* SDS variable */
+    int16      special;         /* Special code */
+    int32      count;           /* number of values to read */
+    int32      nchunks;         /* number of chunks of the hyperslab */
+    int32      nwritten;        /* number of them written */
+    int8       platntsubclass;  /* the machine type of the current platform */
+    int8       outntsubclass;   /* the data's machine type */
+    uintn      convert;         /* whether to convert or not */
+    comp_coder_t comp_type;
+    uint32  comp_config;
+    int32 status;
+    intn       i;
+    sp_info_block_t info_block; /* special info block */
+    intn       ret_value = SUCCEED;
+
+    /* clear error stack */
+    HEclear();
+
+    info_block.cdims = NULL;
+
+    /* Check args */
+    if (start == NULL || edge == NULL || data == NULL || chunk_map == NULL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+    if (fill_mode != SD_FILL && fill_mode != SD_NOFILL)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* get file handle and verify it is an HDF file
+       we only handle reading from SDS only not coordinate variables */
+    handle = SDIhandle_from_id(sdsid, SDSTYPE);
+    if(handle == NULL || handle->file_type != HDF_FILE || handle->vars == NULL)
+      {
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+      }
+
+    /* get variable from id */
+    var = SDIget_var(handle, sdsid);
+    if(var == NULL)
+      {
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+      }
+
+    /* Check compression method is enabled */
+    status = HCPgetcomptype(handle->hdf_file, var->data_tag, var->data_ref,
+                &comp_type);
+
+    if (status != FAIL)
+    if (comp_type != COMP_CODE_NONE && comp_type != COMP_CODE_INVALID)
+      {
+    /* Must have decoder to read data */
+        HCget_config_info( comp_type , &comp_config);
+        if ((comp_config & COMP_DECODER_ENABLED) == 0) {
+        /* decoder not present?? */
+        HGOTO_ERROR(DFE_BADCODER, FAIL);
+          }
+      }
+
+    /* Keep the access id the data is read through, as SDreaddata() does */
+    if(var->aid == FAIL && hdf_get_vp_aid(handle, var) == FAIL)
+        HGOTO_ERROR(DFE_CANTACCESS, FAIL);
+
+    /* only chunked SDSs have chunks to tell about */
+    if (Hinquire(var->aid, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &special) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+    if (special != SPECIAL_CHUNKED)
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+
+    /* get info about chunked element */
+    if (HDget_special_info(var->aid, &info_block) == FAIL)
+        HGOTO_ERROR(DFE_INTERNAL, FAIL);
+
+    /* figure out if data needs to be converted */
+    if (FAIL == (platntsubclass = DFKgetPNSC(var->HDFtype, DF_MT)))
+      {
+          HGOTO_ERROR(DFE_INTERNAL, FAIL);
+      }
+
+    if (DFKisnativeNT(var->HDFtype))
+      {
+          if (FAIL == (outntsubclass = DFKgetPNSC(var->HDFtype, DF_MT)))
+            {
+                HGOTO_ERROR(DFE_INTERNAL, FAIL);
+            }
+      }
+    else
+      {
+          outntsubclass = DFKislitendNT(var->HDFtype) ? DFNTF_PC : DFNTF_HDFDEFAULT;
+      }
+
+    convert = (uintn)(platntsubclass != outntsubclass);
+
+    /* read the hyperslab in, as hdf_xdr_NCvdata() does */
+    handle->xdrs->x_op = XDR_DECODE;
+    HTS_API_SUSPEND(var->aid);
+    nwritten = HMCreadSlabMap(var->aid, start, edge, data, chunk_map,
+                              fill_mode == SD_FILL);
+    HTS_API_RESUME;
+    handle->xdrs->x_op = XDR_DECODE;
+    if (nwritten == FAIL)
+        HGOTO_ERROR(DFE_READERROR, FAIL);
+
+    /* convert the values read, all of them unless chunks were left out;
+       fill values need it even if no chunk was written */
+    if (convert && (fill_mode == SD_FILL || nwritten > 0))
+      {
+          count = 1;
+          nchunks = 1;
+          for (i = 0; i < info_block.ndims; i++)
+            {
+                count *= edge[i];
+                nchunks *= (start[i] + edge[i] - 1) / info_block.cdims[i]
+                           - start[i] / info_block.cdims[i] + 1;
+            }
+
+          if (fill_mode == SD_FILL || nwritten == nchunks)
+            {
+                if (FAIL == DFKconvert(data, data, var->HDFtype, (uint32) count,
+                                       DFACC_READ, 0, 0))
+                    HGOTO_ERROR(DFE_INTERNAL, FAIL);
+            }
+          else if (FAIL == SDIconvert_sparse(var, start, edge, info_block.cdims,
+                                             chunk_map, (uint8 *) data))
+              HGOTO_ERROR(DFE_INTERNAL, FAIL);
+      }
+
+    ret_value = (intn) nwritten;
+
+  done:
+    if (ret_value == FAIL)
+      { /* Failure cleanup */
+      }
+    /* Normal cleanup */
+    /* dont forget to free up info in special info block
+       This space was allocated by the library */
+    if (info_block.cdims != NULL)
+        HDfree(info_block.cdims);
+
+    return ret_value;
+} /* SDreadsparse() */
+
 /******************************************************************************
 NAME
      SDsetchunkcache - maximum number of chunks to cache
@@ -7062,6 +7383,7 @@ SDsetchunkcache(int32 sdsid,     /* IN: access aid to mess with */
                 int32 maxcache,  /* IN: max number of chunks to cache */
                 int32 flags      /* IN: flags = 0, HDF_CACHEALL */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDsetchunkcache");    /* for HGOTO_ERROR */
     NC       *handle = NULL;        /* file handle */
     NC_var   *var    = NULL;        /* SDS variable */
@@ -7123,6 +7445,251 @@ SDsetchunkcache(int32 sdsid,     /* IN: access aid to mess with */
     return ret_value;
 } /* SDsetchunkcache() */
 
+/******************************************************************************
+NAME
+     SDsetchunkcachepolicy - byte budget and eviction policy of the chunk cache
+
+DESCRIPTION
+     Budget the chunk cache of the SDS in bytes and set which chunks it 
+     gives up first when it is full.
+
+     The cache is set to hold as many chunks as fit in 'maxbytes', at
+     least one, and SDsetchunkcache() does not let it hold more. Unlike 
+     the number of chunks the budget can be lowered, which writes out 
+     and drops the chunks that no longer fit. A 'maxbytes' of zero 
+     leaves the number of chunks alone and takes the limit away.
+
+     'policy' is HDF_CACHE_LRU (the default), HDF_CACHE_2Q or 
+     HDF_CACHE_CLOCK. With HDF_CACHE_2Q chunks used only once, as in a
+     long sequential read, are given up before chunks used again, such
+     as those of coordinate variables or tile edges. HDF_CACHE_CLOCK 
+     gives up the chunks not used since its last sweep of the cache.
+
+     The environment variables HDF4_CHUNK_CACHE_BYTES and
+     HDF4_CHUNK_CACHE_POLICY ("lru", "2q" or "clock") set both for
+     every chunk cache when it is created.
+
+     NOTE:
+          This routine directly calls a Special Chunked Element fcn HMCxxx.
+
+RETURNS
+     Returns the number of chunks the cache holds at most if successful 
+     and FAIL otherwise
+******************************************************************************/
+intn
+SDsetchunkcachepolicy(int32 sdsid,     /* IN: access aid to mess with */
+                      int32 maxbytes,  /* IN: max bytes to cache, 0 for no limit */
+                      intn  policy     /* IN: HDF_CACHE_LRU, HDF_CACHE_2Q, HDF_CACHE_CLOCK */)
+{
+    HTS_API_LOCK;
+    CONSTR(FUNC, "SDsetchunkcachepolicy");    /* for HGOTO_ERROR */
+    NC       *handle = NULL;        /* file handle */
+    NC_var   *var    = NULL;        /* SDS variable */
+    int16     special;              /* Special code */
+    intn      ret_value = SUCCEED;
+
+    /* clear error stack */
+    HEclear();
+
+    /* Check args */
+    if (maxbytes < 0)
+      {
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+      }
+
+    if (policy != HDF_CACHE_LRU && policy != HDF_CACHE_2Q && policy != HDF_CACHE_CLOCK)
+      {
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+      }
+
+    /* get file handle and verify it is an HDF file
+       we only handle dealing with SDS only not coordinate variables */
+    handle = SDIhandle_from_id(sdsid, SDSTYPE);
+    if(handle == NULL || handle->file_type != HDF_FILE || handle->vars == NULL)
+      {
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+      }
+
+    /* get variable from id */
+    var = SDIget_var(handle, sdsid);
+    if(var == NULL)
+      {
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+      }
+
+    /* Check to see if data aid exists? i.e. may need to create a ref for SDS */
+    if(var->aid == FAIL && hdf_get_vp_aid(handle, var) == FAIL)
+      {
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+      }
+
+    /* inquire about element */
+    ret_value = Hinquire(var->aid, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &special);
+    if (ret_value != FAIL)
+      {
+          if (special == SPECIAL_CHUNKED)
+              ret_value = HMCsetCachePolicy(var->aid, maxbytes, policy);
+          else
+              ret_value = FAIL;
+      }
+
+  done:
+    if (ret_value == FAIL)
+      { /* Failure cleanup */
+
+      }
+    /* Normal cleanup */
+
+    return ret_value;
+} /* SDsetchunkcachepolicy() */
+
+/******************************************************************************
+NAME
+     SDsetsharedchunkcache - byte budget of the chunk cache shared by all SDSs
+
+DESCRIPTION
+     Set the memory of the chunk cache shared by all the chunked SDSs of
+     all the open files.
+
+     The chunk cache of an SDS goes away with the SDS id. The shared 
+     cache keeps the chunks read, decompressed, after SDendaccess() and 
+     across SDSs, so that reading them again neither goes to the file 
+     nor through the decompression. The least recently used chunks are 
+     given up when the chunks take more than 'maxbytes'. A chunk 
+     written is dropped from the cache, the chunks of a file when it is
+     closed.
+
+     The cache is off until it is given a budget, a 'maxbytes' of zero
+     turns it off again. The environment variable 
+     HDF4_SHARED_CHUNK_CACHE_BYTES sets the budget as well.
+
+     NOTE:
+          This routine directly calls a Special Chunked Element fcn HMCxxx.
+
+RETURNS
+     SUCCEED/FAIL
+******************************************************************************/
+intn
+SDsetsharedchunkcache(int32 maxbytes  /* IN: max bytes to cache, 0 to turn off */)
+{
+    HTS_API_LOCK;
+    CONSTR(FUNC, "SDsetsharedchunkcache");    /* for HGOTO_ERROR */
+    intn      ret_value = SUCCEED;
+
+    /* clear error stack */
+    HEclear();
+
+    /* Check args */
+    if (maxbytes < 0)
+      {
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+      }
+
+    ret_value = HMCsetSharedCache(maxbytes);
+
+  done:
+    if (ret_value == FAIL)
+      { /* Failure cleanup */
+
+      }
+    /* Normal cleanup */
+
+    return ret_value;
+} /* SDsetsharedchunkcache() */
+
+/******************************************************************************
+NAME
+     SDsetchunkalign - where in the file to place the chunks of the SDS
+
+DESCRIPTION
+     Set where the chunks of the SDS written for the first time go in the
+     file. Left alone, they go wherever there is room, mixed with the 
+     chunk table and the other objects of the file.
+
+     With an 'alignment' above one each chunk starts on a multiple of 
+     'alignment' bytes from the beginning of the file, e.g. the page size
+     or the stripe size of the file system, so that the chunks can be 
+     read with direct I/O. The alignment need not be a power of two, zero
+     places the chunks anywhere again.
+
+     With HDF_CHUNK_PREALLOC in 'flags' one extent of the file, starting
+     on a boundary, is kept right away for all the chunks of the SDS, 
+     which go in it next to each other in the order of the chunk numbers,
+     each on a boundary. The places of the chunks not written are given
+     back at SDendaccess(). Chunks written before are left where they are.
+
+     Only SDSs chunked without compression can be placed. The policy is 
+     not recorded in the file and lasts until SDendaccess(), so it is set
+     after SDsetchunk() and before the data is written.
+
+     NOTE:
+          This routine directly calls a Special Chunked Element fcn HMCxxx.
+
+RETURNS
+     SUCCEED/FAIL
+******************************************************************************/
+intn
+SDsetchunkalign(int32 sdsid,     /* IN: access aid to mess with */
+                int32 alignment, /* IN: chunks start on multiples of this, 0 for anywhere */
+                intn  flags      /* IN: 0 or HDF_CHUNK_PREALLOC */)
+{
+    HTS_API_LOCK;
+    CONSTR(FUNC, "SDsetchunkalign");    /* for HGOTO_ERROR */
+    NC       *handle = NULL;        /* file handle */
+    NC_var   *var    = NULL;        /* SDS variable */
+    int16     special;              /* Special code */
+    intn      ret_value = SUCCEED;
+
+    /* clear error stack */
+    HEclear();
+
+    /* Check args */
+    if (alignment < 0 || (flags & ~HDF_CHUNK_PREALLOC))
+      {
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+      }
+
+    /* get file handle and verify it is an HDF file
+       we only handle dealing with SDS only not coordinate variables */
+    handle = SDIhandle_from_id(sdsid, SDSTYPE);
+    if(handle == NULL || handle->file_type != HDF_FILE || handle->vars == NULL)
+      {
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+      }
+
+    /* get variable from id */
+    var = SDIget_var(handle, sdsid);
+    if(var == NULL)
+      {
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+      }
+
+    /* Check to see if data aid exists? i.e. may need to create a ref for SDS */
+    if(var->aid == FAIL && hdf_get_vp_aid(handle, var) == FAIL)
+      {
+        HGOTO_ERROR(DFE_ARGS, FAIL);
+      }
+
+    /* inquire about element */
+    ret_value = Hinquire(var->aid, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &special);
+    if (ret_value != FAIL)
+      {
+          if (special == SPECIAL_CHUNKED)
+              ret_value = HMCsetAlignment(var->aid, alignment, flags);
+          else
+              ret_value = FAIL;
+      }
+
+  done:
+    if (ret_value == FAIL)
+      { /* Failure cleanup */
+
+      }
+    /* Normal cleanup */
+
+    return ret_value;
+} /* SDsetchunkalign() */
+
 
 /******************************************************************************
  NAME
@@ -7151,6 +7718,7 @@ int32
 SDcheckempty(int32 sdsid,  /* IN: dataset ID */
         intn  *emptySDS /* TRUE if SDS is empty */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDcheckempty");    /* for HGOTO_ERROR */
     NC     *handle = NULL;        /* file record struct */
     NC_var *var = NULL;            /* variable record struct */
@@ -7238,6 +7806,7 @@ done:
 hdf_idtype_t
 SDidtype(int32 an_id)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDidtype");    /* for HGOTO_ERROR */
     NC     *handle = NULL;    /* file record struct */
     hdf_idtype_t ret_value = NOT_SDAPI_ID;
@@ -7302,6 +7871,7 @@ SDidtype(int32 an_id)
 intn
 SDreset_maxopenfiles(intn req_max)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDreset_maxopenfiles");    /* for HGOTO_ERROR */
     intn ret_value = SUCCEED;
 
@@ -7350,6 +7920,7 @@ SDget_maxopenfiles(intn *curr_max,  /* OUT: current # of open files allowed */
         intn *sys_limit) /* OUT: max # of open files allowed on
                     a system */
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDget_maxopenfiles");    /* for HGOTO_ERROR */
     intn ret_value = SUCCEED;
 
@@ -7403,6 +7974,7 @@ done:
 intn
 SDget_numopenfiles()
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDget_numopenfiles");    /* for HGOTO_ERROR */
     intn ret_value = SUCCEED;
 
@@ -7440,6 +8012,7 @@ intn
 SDgetfilename(int32 fid,       /* IN:  file ID */
               char  *filename  /* OUT: name of the file */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetfilename");    /* for HGOTO_ERROR */
     NC     *handle = NULL;
     intn    len;
@@ -7496,6 +8069,7 @@ intn
 SDgetnamelen(int32 id,        /* IN:  object ID */
              uint16 *name_len    /* OUT: buffer for name's length */)
 {
+    HTS_API_LOCK;
     CONSTR(FUNC, "SDgetnamelen");    /* for HGOTO_ERROR */
     NC     *handle = NULL;
     NC_var *var = NULL;
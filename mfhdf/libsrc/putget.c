@@ -31,9 +31,16 @@ static intn hdf_xdr_NCvdata
     (NC *handle,NC_var *vp,u_long where,nc_type type,uint32 count,
         void * values);
 
+static intn hdf_xdr_NCvslab
+    (NC *handle,NC_var *vp,const long *start,const long *edges,
+        void * values);
+
 static intn hdf_xdr_NCv1data
     (NC *handle,NC_var *vp,u_long where,nc_type type,void * values);
 
+static int32 hdf_read_NCvdata
+    (int32 aid, int32 where, int32 byte_count, void * values);
+
 int32 hdf_get_vp_aid
     (NC *handle, NC_var *vp);
 
@@ -1065,6 +1072,28 @@ done:
 } /* hdf_get_vp_aid */
 
 
+/* --------------------------- hdf_read_NCvdata --------------------------- */
+/*
+ *  Read 'byte_count' bytes at 'where' in the data of a variable.
+ *
+ * The seek and the read are made holding the lock of the file, in a
+ *  thread-safe build, so that other threads using the same access id
+ *  can't move it in between.
+ */
+static int32
+hdf_read_NCvdata(int32 aid,
+                 int32 where,
+                 int32 byte_count,
+                 void * values)
+{
+    HTS_FILE_LOCK(aid);
+
+    if(Hseek(aid, where, DF_START) == FAIL)
+        return FAIL;
+    return Hread(aid, byte_count, values);
+} /* hdf_read_NCvdata */
+
+
 /* --------------------------- hdf_xdr_NCvdata ---------------------------- */
 /*
  *  Read / write 'count' items of contiguous data of type 'type' at 'where'
@@ -1407,8 +1436,8 @@ this routine */
                   }
             } /* end else */
       } /* end if */
-    else
-      { /* position ourselves correctly */
+    else if(handle->xdrs->x_op != XDR_DECODE)
+      { /* position ourselves correctly, reads seek along with the read */
 
 #ifdef DEBUG
           fprintf(stderr, "hdf_xdr_NCvdata: Check 2.0\n");
@@ -1430,83 +1459,30 @@ this routine */
 
     /* Read or write the data into / from values */
     if(handle->xdrs->x_op == XDR_DECODE)  /* the read case */
-    {
-       if(convert) /* if data need to be converted for this platform */
-       {
-          data_size = byte_count; /* use data_size; preserve the byte count */
-          new_count = count;     /* use new_count; preserve the # of elements */
-
-          /* attempt to allocate the entire amount needed first */
-          alloc_status = SDIresizebuf((void **)&tBuf,&tBuf_size, data_size );
-
-    /* if fail to allocate, repeatedly calculate a new amount and
-        allocate until success or until no memory available */
-          while( alloc_status == FAIL )
-          {
-             new_count = new_count / 2;  /* try smaller number of elements */
-             if( new_count <= 0 )  /* unable to allocate any memory */
-             {
+      {
+          /* Read straight into the user's buffer and convert the data
+             there, if need be.  The data are as large in memory as in
+             the file.  In a thread-safe build, the read gives up the API
+             lock while it reads from a file opened read-only; other
+             threads may have used the handle meanwhile. */
+          HTS_API_SUSPEND(vp->aid);
+          status = hdf_read_NCvdata(vp->aid, (int32)where, byte_count, values);
+          HTS_API_RESUME;
+          handle->xdrs->x_op = XDR_DECODE;
+          if(status != byte_count)
+            {
                 ret_value = FAIL;
                 goto done;
-             }
-
-             /* re-calculate the size of the data block */
-             data_size = new_count * vp->szof;
-             alloc_status = SDIresizebuf((void **)&tBuf,&tBuf_size, data_size);
-          }
-
-    /* repeatedly read, convert, and store blocks of data_size
-        bytes of data into the user's buffer until no more elements
-        left */
-
-        /* number of elements left to be processed */
-            elements_left = count;
-
-        /* put a ptr at the beginning of the user buffer for read data */
-        pvalues = values;
-
-        while( elements_left > 0 )
-             {
-                status = Hread(vp->aid, data_size, tBuf);
-                if(status != data_size)  /* amount read != amount specified */
-                  {
-                      ret_value = FAIL;
-                      goto done;
-                  }
-                /* convert and store new_count elements in tBuf into
-                   the buffer values, pointed to by pvalues */
-                if (FAIL == DFKconvert(tBuf, pvalues, vp->HDFtype, (uint32) new_count, DFACC_READ, 0, 0))
-                  {
-                      ret_value = FAIL;
-                      goto done;
-                  }
-
-        /* compute the number of elements left to be processed */
-                elements_left = elements_left - new_count;
-
-        /* adjust the # of elements in the final block and
-                   compute that block's size if necessary */
-                if( elements_left > 0 && elements_left < new_count )
-                {
-                   new_count = elements_left;
-                   data_size = new_count * vp->szof;
-                }
-
-        /* advance pvalues on buffer "values" for next batch of data */
-        pvalues = pvalues + data_size;
-              } /* while more elements left to be processed */
+            }
 
-              SDPfreebuf();  /* free tBuf and tValues if any exist */
-            } /* end if convert */
-          else  /* no convert, read directly into the user's buffer */
+          if(convert)
             {
-                status = Hread(vp->aid, byte_count, values);
-                if(status != byte_count)
+                if (FAIL == DFKconvert(values, values, vp->HDFtype, count, DFACC_READ, 0, 0))
                   {
                       ret_value = FAIL;
                       goto done;
                   }
-            } /* end else */
+            } /* end if convert */
       } /* end if XDR_DECODE */
     else
       {/* XDR_ENCODE */
@@ -1697,6 +1673,149 @@ done:
 } /* hdf_xdr_NCvdata */
 
 
+/* --------------------------- hdf_xdr_NCvslab ---------------------------- */
+/*
+ *  Read / write the hypercube 'start', 'edges' of a chunked variable in
+ *  one go, rather than one contiguous run at a time.
+ *
+ * The chunked element maps the hypercube onto its chunks itself (see
+ *  HMCreadSlab() and HMCwriteSlab()), getting each chunk once however
+ *  many runs of the hypercube it holds.  Record variables and data which
+ *  do not begin at the start of their data-object are left to
+ *  hdf_xdr_NCvdata().
+ *
+ * Returns TRUE if done, FALSE if the hypercube is to be read / written
+ *  run by run instead, FAIL on error.
+ *
+ * The calling routine is responsible for calling DFKsetNT() as required.
+ */
+static intn
+hdf_xdr_NCvslab(NC *handle,
+                NC_var *vp,
+                const long *start,
+                const long *edges,
+                void * values)
+{
+    int32  slab_start[H4_MAX_VAR_DIMS]; /* the hypercube, as int32s */
+    int32  slab_count[H4_MAX_VAR_DIMS];
+    int32  status;
+    int32  byte_count;    /* total # of bytes of data to be processed */
+    uint32 count;         /* total # of elements */
+    int32  elem_length;   /* length of the element pointed to */
+    int8   platntsubclass;  /* the machine type of the current platform */
+    int8   outntsubclass;   /* the data's machine type */
+    uintn  convert;         /* whether to convert or not */
+    int16  isspecial;
+    unsigned i;
+    intn   ret_value = TRUE;
+
+    if(IS_RECVAR(vp) || vp->data_offset > 0)
+        return FALSE;
+
+    /* leave variables with no data yet to hdf_xdr_NCvdata() */
+    if(vp->aid == FAIL
+       && hdf_get_vp_aid(handle, vp) == FAIL)
+        return FALSE;
+
+    if(Hinquire(vp->aid,NULL,NULL,NULL,&elem_length,NULL,NULL,NULL,&isspecial) == FAIL)
+      {
+          ret_value = FAIL;
+          goto done;
+      }
+    if(isspecial != SPECIAL_CHUNKED || elem_length <= 0)
+        return FALSE;
+
+    count = 1;
+    for(i = 0; i < vp->assoc->count; i++)
+      {
+          slab_start[i] = (int32)start[i];
+          slab_count[i] = (int32)edges[i];
+          count *= (uint32)edges[i];
+      }
+    byte_count = count * vp->HDFsize;
+
+    if (FAIL == (platntsubclass = DFKgetPNSC(vp->HDFtype, DF_MT)))
+      {
+          ret_value = FAIL;
+          goto done;
+      }
+
+    if (DFKisnativeNT(vp->HDFtype))
+      {
+          if (FAIL == (outntsubclass = DFKgetPNSC(vp->HDFtype, DF_MT)))
+            {
+                ret_value = FAIL;
+                goto done;
+            }
+      }
+    else
+      {
+          outntsubclass = DFKislitendNT(vp->HDFtype) ? DFNTF_PC : DFNTF_HDFDEFAULT;
+      }
+    convert= (uintn)(platntsubclass!=outntsubclass);
+
+    if(handle->xdrs->x_op == XDR_DECODE)  /* the read case */
+      {
+          /* Read straight into the user's buffer and convert the data
+             there, as hdf_xdr_NCvdata() does */
+          HTS_API_SUSPEND(vp->aid);
+          status = HMCreadSlab(vp->aid, slab_start, slab_count, values);
+          HTS_API_RESUME;
+          handle->xdrs->x_op = XDR_DECODE;
+          if(status != byte_count)
+            {
+                ret_value = FAIL;
+                goto done;
+            }
+
+          if(convert)
+            {
+                if (FAIL == DFKconvert(values, values, vp->HDFtype, count, DFACC_READ, 0, 0))
+                  {
+                      ret_value = FAIL;
+                      goto done;
+                  }
+            } /* end if convert */
+      } /* end if XDR_DECODE */
+    else
+      {/* XDR_ENCODE */
+          if(convert) /* if data need to be converted for this platform */
+            {
+                /* without room for the whole hypercube converted, go run
+                   by run, which converts a block at a time */
+                if(SDIresizebuf((void **)&tBuf,&tBuf_size,byte_count) == FAIL)
+                    return FALSE;
+
+                if (FAIL == DFKconvert(values, tBuf, vp->HDFtype, count, DFACC_WRITE, 0, 0))
+                  {
+                      ret_value = FAIL;
+                      goto done;
+                  }
+                status = HMCwriteSlab(vp->aid, slab_start, slab_count, tBuf);
+                SDPfreebuf();  /* free tBuf and tValues if any exist */
+            } /* end if convert */
+          else
+            { /* no convert, write directly from the user's buffer */
+                status = HMCwriteSlab(vp->aid, slab_start, slab_count, values);
+            } /* no convert */
+
+          if(status != byte_count)
+            {
+                ret_value = FAIL;
+                goto done;
+            }
+      } /* XDR_ENCODE */
+
+done:
+    if (ret_value == FAIL)
+      { /* Failure cleanup */
+      }
+     /* Normal cleanup */
+
+    return ret_value;
+} /* hdf_xdr_NCvslab */
+
+
 /* ------------------------- hdf_xdr_NCv1data ------------------- */
 /*
  * read / write a single datum of type 'type' at 'where'
@@ -1869,6 +1988,7 @@ int varid ;
 const long *coords ;
 const ncvoid *value ;
 {
+    HTS_API_LOCK;
     NC *handle ;
 
     cdf_routine_name = "ncvarput1" ;
@@ -1893,6 +2013,7 @@ int varid ;
 const long *coords ;
 ncvoid *value ;
 {
+    HTS_API_LOCK;
     NC *handle ;
 
     cdf_routine_name = "ncvarget1" ;
@@ -2257,6 +2378,25 @@ void *values ;
         iocount *= *edp ;
     /* now edp = edp0 - 1 */
 
+#ifdef HDF
+    /* a hypercube of several runs of a chunked variable goes in one go */
+    if(handle->file_type == HDF_FILE && edp0 != edges)
+      {
+          switch(hdf_xdr_NCvslab(handle, vp, start, edges, values))
+            {
+            case TRUE:
+                /* as at the end of the ripple counter below */
+                if(start[0] + edges[0] > vp->numrecs)
+                    vp->numrecs = start[0] + edges[0];
+                return(0) ;
+            case FAIL:
+                return(-1) ;
+            default:
+                break;
+            }
+      }
+#endif /* HDF */
+
     { /* inline */
         long  coords[H4_MAX_VAR_DIMS], upper[H4_MAX_VAR_DIMS];
         long  *cc ;
@@ -2413,6 +2553,7 @@ const long *start ;
 const long *edges ;
 ncvoid *values ;
 {
+    HTS_API_LOCK;
     NC *handle ;
 
     cdf_routine_name = "ncvarput" ;
@@ -2499,6 +2640,7 @@ const long *start ;
 const long *edges ;
 ncvoid *values ;
 {
+    HTS_API_LOCK;
     NC *handle;
     int  status = 0;
 
@@ -2603,6 +2745,7 @@ int *nrecvars ;
 int *recvarids ;
 long *recsizes ;
 {
+    HTS_API_LOCK;
     NC *handle ;
     int nrvars ;
     NC_var *rvp[H4_MAX_NC_VARS] ;
@@ -2705,6 +2848,7 @@ int cdfid ;
 long recnum ;
 ncvoid * *datap ;
 {
+    HTS_API_LOCK;
     NC *handle ;
     long unfilled ;
 
@@ -2767,6 +2911,7 @@ int cdfid ;
 long recnum ;
 ncvoid **datap ;
 {
+    HTS_API_LOCK;
     NC *handle ;
 
     cdf_routine_name = "ncrecget" ;
@@ -165,6 +165,7 @@ const long *stride ;
 const long *imap ;
 ncvoid *values ;
 {
+    HTS_API_LOCK;
 	NC *handle ;
 
 	cdf_routine_name = "ncvarputg" ;
@@ -197,6 +198,7 @@ const long *stride ;
 const long *imap ;
 ncvoid *values ;
 {
+    HTS_API_LOCK;
 	NC *handle ;
 
 	cdf_routine_name = "ncvargetg" ;
@@ -224,6 +226,7 @@ const long *count ;
 const long *stride ;
 ncvoid *values ;
 {
+    HTS_API_LOCK;
 	NC *handle ;
 
 	cdf_routine_name = "ncvarputs" ;
@@ -255,6 +258,7 @@ const long *count ;
 const long *stride ;
 ncvoid *values ;
 {
+    HTS_API_LOCK;
 	NC *handle ;
 
 	cdf_routine_name = "ncvargets" ;
@@ -268,6 +268,7 @@ nc_type type ;
 int ndims ;
 const int dims[] ;
 {
+    HTS_API_LOCK;
     NC *handle ;
     NC_var *var[1] ;
     NC_var **dp ;
@@ -408,6 +409,7 @@ int ncvarid( cdfid, name)
 int cdfid ;
 const char *name ;
 {
+    HTS_API_LOCK;
     NC *handle ;
     NC_var **dp ;
     int ii ;
@@ -489,6 +491,7 @@ int *ndimsp ;
 int dims[] ;
 int *nattrsp ;
 {
+    HTS_API_LOCK;
     NC_var *vp ;
     int ii ;
 
@@ -540,6 +543,7 @@ int cdfid ;
 int varid ;
 const char *newname ;
 {
+    HTS_API_LOCK;
 
     NC *handle ;
     NC_var **vpp ;
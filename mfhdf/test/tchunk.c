@@ -165,7 +165,7 @@ test_chunk()
     int32 nt;                /* Number type */
     int32 dimsize[10];       /* dimension sizes */
     int32   newsds1, newsds2, newsds3, newsds4, newsds5, 
-	    newsds6, newsds7, newsds8;   /* Chunked SDS ids */
+	    newsds6, newsds7, newsds8, newsds9, newsds10;   /* Chunked SDS ids */
     float32 inbuf_f32[2][3][4];  /* float32 Data array read from from file */
     uint16  inbuf_u16[2][3][4];  /* uint16 Data array read from from file */
     uint16  inbuf1_2u16[9][4];   /* Data array read for Example 1 */
@@ -188,6 +188,8 @@ test_chunk()
     int32   start[10], end[10]; /* start, end, stride arrays */
     int32   idata[100];
     int32   rdata[100];
+    int32   fill_i32;
+    uint8   chunk_map[12];
     float32 max;
     int     num_errs = 0;    /* number of errors so far */
 
@@ -1652,6 +1654,217 @@ test_chunk()
     status = SDend(fchk);
     CHECK(status, FAIL, "Chunk Test 8. SDend");
 
+    /*
+     * Test 9. Create a 10x10 SDS of int32 with 3x4 chunks in file 1,
+     *         and write and read hyperslabs of it a few values wide,
+     *         which span several chunks each.
+     */
+    fchk = SDstart(CHKFILE, DFACC_RDWR);
+    CHECK(fchk, FAIL, "Chunk Test 9. SDstart");
+
+    dimsize[0] = 10;
+    dimsize[1] = 10;
+    newsds9 = SDcreate(fchk, "DataSetChunked_2D_slabs", DFNT_INT32, 2, dimsize);
+    if(newsds9 == FAIL) 
+      {
+        fprintf(stderr, "Chunk Test 9. Failed to create a new data set \n");
+        num_errs++;
+        goto done;
+      }
+
+    chunk_def.chunk_lengths[0] = 3;
+    chunk_def.chunk_lengths[1] = 4;
+    status = SDsetchunk(newsds9, chunk_def, HDF_CHUNK);
+    CHECK(status, FAIL, "Chunk Test 9. SDsetchunk");
+
+    for(i = 0; i < 100; i++)
+        idata[i] = i * 3;
+    start[0] = start[1] = 0;
+    end[0]   = end[1]   = 10;
+    status = SDwritedata(newsds9, start, NULL, end, (VOIDP) idata);
+    CHECK(status, FAIL, "Chunk Test 9. SDwritedata");
+
+    /* write a column 8 values down */
+    for(i = 0; i < 8; i++)
+      {
+        rdata[i] = 1000 + i;
+        idata[(1 + i) * 10 + 6] = rdata[i];
+      }
+    start[0] = 1;  start[1] = 6;
+    end[0]   = 8;  end[1]   = 1;
+    status = SDwritedata(newsds9, start, NULL, end, (VOIDP) rdata);
+    CHECK(status, FAIL, "Chunk Test 9. SDwritedata");
+
+    status = SDendaccess(newsds9);
+    CHECK(status, FAIL, "Chunk Test 9. SDendaccess");
+
+    newsds9 = SDselect(fchk, SDnametoindex(fchk, "DataSetChunked_2D_slabs"));
+    CHECK(newsds9, FAIL, "Chunk Test 9. SDselect");
+
+    /* read the columns 5 to 7 back in */
+    start[0] = 0;  start[1] = 5;
+    end[0]   = 10; end[1]   = 3;
+    status = SDreaddata(newsds9, start, NULL, end, (VOIDP) rdata);
+    CHECK(status, FAIL, "Chunk Test 9. SDreaddata");
+    for(i = 0; i < 10; i++)
+        for(j = 0; j < 3; j++)
+            if(rdata[i * 3 + j] != idata[i * 10 + 5 + j])
+              {
+                fprintf(stderr,"Chunk Test 9. Bogus val at (%d,%d) want %ld got %ld\n",
+                        i, 5 + j, (long)idata[i * 10 + 5 + j], (long)rdata[i * 3 + j]);
+                num_errs++;
+              }
+
+    /* and the whole of it */
+    start[0] = start[1] = 0;
+    end[0]   = end[1]   = 10;
+    status = SDreaddata(newsds9, start, NULL, end, (VOIDP) rdata);
+    CHECK(status, FAIL, "Chunk Test 9. SDreaddata");
+    for(i = 0; i < 100; i++)
+        if(rdata[i] != idata[i])
+          {
+            fprintf(stderr,"Chunk Test 9. Bogus val in loc %d want %ld got %ld\n",
+                    i, (long)idata[i], (long)rdata[i]);
+            num_errs++;
+          }
+
+    status = SDendaccess(newsds9);
+    CHECK(status, FAIL, "Chunk Test 9. SDendaccess");
+
+    status = SDend(fchk);
+    CHECK(status, FAIL, "Chunk Test 9. SDend");
+
+    /*
+     * Test 10. Create a 10x10 SDS of int32 with 3x4 chunks in file 1,
+     *          write only two of its 12 chunks, and read it back with
+     *          SDreadsparse(), first leaving the chunks never written
+     *          alone, then filling them, also in a hyperslab with no
+     *          chunk written.
+     */
+    fchk = SDstart(CHKFILE, DFACC_RDWR);
+    CHECK(fchk, FAIL, "Chunk Test 10. SDstart");
+
+    dimsize[0] = 10;
+    dimsize[1] = 10;
+    newsds10 = SDcreate(fchk, "DataSetChunked_2D_sparse", DFNT_INT32, 2, dimsize);
+    if(newsds10 == FAIL) 
+      {
+        fprintf(stderr, "Chunk Test 10. Failed to create a new data set \n");
+        num_errs++;
+        goto done;
+      }
+
+    fill_i32 = 77;
+    status = SDsetfillvalue(newsds10, (VOIDP) &fill_i32);
+    CHECK(status, FAIL, "Chunk Test 10. SDsetfillvalue");
+
+    chunk_def.chunk_lengths[0] = 3;
+    chunk_def.chunk_lengths[1] = 4;
+    status = SDsetchunk(newsds10, chunk_def, HDF_CHUNK);
+    CHECK(status, FAIL, "Chunk Test 10. SDsetchunk");
+
+    /* write chunk (0,0) and chunk (2,1) */
+    for(i = 0; i < 100; i++)
+        idata[i] = -1;
+    for(i = 0; i < 3; i++)
+        for(j = 0; j < 4; j++)
+          {
+            idata[i * 10 + j] = i * 10 + j;
+            idata[(6 + i) * 10 + 4 + j] = 500 + i * 10 + j;
+            rdata[i * 4 + j] = i * 10 + j;
+            rdata[12 + i * 4 + j] = 500 + i * 10 + j;
+          }
+    start[0] = 0;  start[1] = 0;
+    end[0]   = 3;  end[1]   = 4;
+    status = SDwritedata(newsds10, start, NULL, end, (VOIDP) rdata);
+    CHECK(status, FAIL, "Chunk Test 10. SDwritedata");
+    start[0] = 6;  start[1] = 4;
+    status = SDwritedata(newsds10, start, NULL, end, (VOIDP) &rdata[12]);
+    CHECK(status, FAIL, "Chunk Test 10. SDwritedata");
+
+    status = SDendaccess(newsds10);
+    CHECK(status, FAIL, "Chunk Test 10. SDendaccess");
+
+    newsds10 = SDselect(fchk, SDnametoindex(fchk, "DataSetChunked_2D_sparse"));
+    CHECK(newsds10, FAIL, "Chunk Test 10. SDselect");
+
+    /* the chunks never written are left as they are */
+    for(i = 0; i < 100; i++)
+        rdata[i] = -1;
+    HDmemset(chunk_map, 0xff, sizeof(chunk_map));
+    start[0] = start[1] = 0;
+    end[0]   = end[1]   = 10;
+    status = SDreadsparse(newsds10, start, end, (VOIDP) rdata, chunk_map, SD_NOFILL);
+    VERIFY(status, 2, "Chunk Test 10. SDreadsparse");
+    for(i = 0; i < 12; i++)
+        if(chunk_map[i] != (uint8)(i == 0 || i == 7))
+          {
+            fprintf(stderr,"Chunk Test 10. Bogus map entry %d: %d\n",
+                    i, (int)chunk_map[i]);
+            num_errs++;
+          }
+    for(i = 0; i < 100; i++)
+        if(rdata[i] != idata[i])
+          {
+            fprintf(stderr,"Chunk Test 10. Bogus val in loc %d want %ld got %ld\n",
+                    i, (long)idata[i], (long)rdata[i]);
+            num_errs++;
+          }
+
+    /* a hyperslab in the chunks of the rows 3 to 8, filled this time */
+    start[0] = 4;  start[1] = 2;
+    end[0]   = 4;  end[1]   = 7;
+    status = SDreadsparse(newsds10, start, end, (VOIDP) rdata, chunk_map, SD_FILL);
+    VERIFY(status, 1, "Chunk Test 10. SDreadsparse");
+    for(i = 0; i < 6; i++)
+        if(chunk_map[i] != (uint8)(i == 4))
+          {
+            fprintf(stderr,"Chunk Test 10. Bogus map entry %d: %d\n",
+                    i, (int)chunk_map[i]);
+            num_errs++;
+          }
+    for(i = 0; i < 4; i++)
+        for(j = 0; j < 7; j++)
+          {
+            int32 want = idata[(4 + i) * 10 + 2 + j];
+
+            if(want == -1)
+                want = fill_i32;
+            if(rdata[i * 7 + j] != want)
+              {
+                fprintf(stderr,"Chunk Test 10. Bogus val at (%d,%d) want %ld got %ld\n",
+                        4 + i, 2 + j, (long)want, (long)rdata[i * 7 + j]);
+                num_errs++;
+              }
+          }
+
+    /* a hyperslab in a chunk never written, filled */
+    for(i = 0; i < 6; i++)
+        rdata[i] = -1;
+    chunk_map[0] = 0xff;
+    start[0] = 3;  start[1] = 8;
+    end[0]   = 3;  end[1]   = 2;
+    status = SDreadsparse(newsds10, start, end, (VOIDP) rdata, chunk_map, SD_FILL);
+    VERIFY(status, 0, "Chunk Test 10. SDreadsparse");
+    if(chunk_map[0] != 0)
+      {
+        fprintf(stderr,"Chunk Test 10. Bogus map entry 0: %d\n", (int)chunk_map[0]);
+        num_errs++;
+      }
+    for(i = 0; i < 6; i++)
+        if(rdata[i] != fill_i32)
+          {
+            fprintf(stderr,"Chunk Test 10. Bogus fill val in loc %d want %ld got %ld\n",
+                    i, (long)fill_i32, (long)rdata[i]);
+            num_errs++;
+          }
+
+    status = SDendaccess(newsds10);
+    CHECK(status, FAIL, "Chunk Test 10. SDendaccess");
+
+    status = SDend(fchk);
+    CHECK(status, FAIL, "Chunk Test 10. SDend");
+
     if (num_errs == 0)
         PASSED();
 